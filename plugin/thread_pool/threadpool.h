@@ -0,0 +1,138 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <my_global.h>
+#include <mysql/plugin.h>
+#include <mysql/thread_pool_priv.h>
+#include <conn_handler/connection_handler.h>  // Connection_handler
+
+/*
+  Thread pool connection handler.
+
+  Connections are distributed over threadpool_size thread groups. Each
+  group owns an epoll descriptor, a queue of connections with pending
+  work and a small set of worker threads. At any time at most one worker
+  of a group is the "listener" blocked in epoll_wait(); the others either
+  execute statements or sleep waiting for work. A timer thread detects
+  groups where no progress is being made (stalls) and lets them
+  temporarily exceed their active thread limit.
+*/
+
+/* System variables */
+extern uint  threadpool_size;          // Number of thread groups
+extern uint  threadpool_stall_limit;   // Stall detection interval, in ms
+extern uint  threadpool_max_threads;   // Max worker threads in all groups
+extern uint  threadpool_oversubscribe; // Active threads per group allowed
+extern uint  threadpool_idle_timeout;  // Seconds before idle worker exits
+extern ulong threadpool_high_prio_mode;
+extern uint  threadpool_high_prio_tickets;
+extern uint  threadpool_prio_kickup_timer; // ms before low prio is kicked up
+
+/* Values of thread_pool_high_priority_mode */
+enum tp_high_prio_mode
+{
+  TP_HIGH_PRIO_MODE_TRANSACTIONS,
+  TP_HIGH_PRIO_MODE_STATEMENTS,
+  TP_HIGH_PRIO_MODE_NONE
+};
+
+/* Upper bound of thread_pool_size */
+#define MAX_THREAD_GROUPS 128
+
+/* Status counters, read by SHOW STATUS */
+struct TP_STATISTICS
+{
+  volatile int32 num_worker_threads;   // Current number of worker threads
+  volatile int32 active_worker_threads;// Workers executing a request
+  volatile int64 stall_count;          // Times a group was found stalled
+  volatile int64 high_prio_dequeues;   // Events served from high prio queue
+  volatile int64 low_prio_dequeues;    // Events served from low prio queue
+  volatile int64 kickups;              // Low prio events kicked to high prio
+};
+
+extern TP_STATISTICS tp_stats;
+
+struct thread_group_t;
+
+/**
+  Per-connection state of the thread pool, attached to the THD through
+  thd_set_scheduler_data().
+*/
+struct connection_t
+{
+  THD *thd;
+  /* Set until the connection has been logged in by a worker. */
+  Channel_info *channel_info;
+  thread_group_t *thread_group;
+  connection_t *next_in_queue;
+  connection_t **prev_in_queue;
+  /* Absolute time (in ms) when the connection expires by wait_timeout. */
+  ulonglong abs_wait_timeout;
+  /* Time (in ms) the connection was put in a queue. */
+  ulonglong enqueue_time;
+  /* Remaining high priority events before demotion to low priority. */
+  uint tickets;
+  bool logged_in;
+  bool bound_to_poll_descriptor;
+  /* True while inside a thd_wait_begin()/thd_wait_end() pair. */
+  bool waiting;
+};
+
+
+/* Low level thread group functions, implemented in threadpool_unix.cc */
+bool tp_init();
+void tp_end();
+bool tp_add_connection(connection_t *connection);
+void tp_wait_begin(THD *thd, int wait_type);
+void tp_wait_end(THD *thd);
+void tp_post_kill_notification(THD *thd);
+void tp_set_threadpool_size(uint size);
+void tp_set_threadpool_stall_limit(uint limit);
+int  tp_get_idle_thread_count();
+int  tp_get_thread_count();
+
+/* Connection level functions, implemented in threadpool_common.cc */
+int  threadpool_add_connection(connection_t *connection);
+int  threadpool_process_request(connection_t *connection);
+void threadpool_remove_connection(connection_t *connection);
+void threadpool_update_wait_timeout(connection_t *connection);
+
+
+/**
+  Connection_handler implementation that multiplexes connections over
+  the thread groups of the thread pool.
+*/
+class Thread_pool_connection_handler : public Connection_handler
+{
+  Thread_pool_connection_handler(const Thread_pool_connection_handler&);
+  Thread_pool_connection_handler&
+    operator=(const Thread_pool_connection_handler&);
+
+public:
+  Thread_pool_connection_handler() {}
+  virtual ~Thread_pool_connection_handler() {}
+
+protected:
+  virtual bool add_connection(Channel_info* channel_info);
+
+  virtual void remove_connection(THD* thd);
+
+  virtual uint get_max_threads() const { return threadpool_max_threads; }
+};
+
+#endif // THREADPOOL_INCLUDED
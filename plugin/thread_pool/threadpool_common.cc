@@ -0,0 +1,484 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  Connection level part of the thread pool plugin: login, execution of
+  client requests and teardown of connections, the Connection_handler
+  registered with the server, and the plugin declaration itself.
+*/
+
+#include "threadpool.h"
+
+#include <mysql/psi/mysql_thread.h>
+#include <my_sys.h>
+#include <new>
+
+
+/* System variables */
+uint  threadpool_size;
+uint  threadpool_stall_limit;
+uint  threadpool_max_threads;
+uint  threadpool_oversubscribe;
+uint  threadpool_idle_timeout;
+ulong threadpool_high_prio_mode;
+uint  threadpool_high_prio_tickets;
+uint  threadpool_prio_kickup_timer;
+
+TP_STATISTICS tp_stats;
+
+
+PSI_memory_key key_memory_thread_pool_connection;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_memory_info all_thread_pool_memory[]=
+{
+  { &key_memory_thread_pool_connection, "connection_t", 0 }
+};
+#endif /* HAVE_PSI_INTERFACE */
+
+
+/**
+  Associate the connection's THD with the current worker thread.
+
+  Worker threads serve many connections, so the thread specific state
+  that a dedicated connection thread would set up once (THR_THD, the
+  mysys_var, the performance schema thread) has to be switched on every
+  event.
+*/
+
+static void thread_attach(THD *thd)
+{
+  thd_set_thread_stack(thd, (char*) &thd);
+  thd_store_globals(thd);
+  thd_clear_errors(thd);
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_THREAD_CALL(set_thread)(thd_get_psi(thd));
+#endif
+}
+
+
+/**
+  Dissociate the THD from the current worker thread.
+*/
+
+static void thread_detach(THD *thd)
+{
+  restore_globals(thd);
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_THREAD_CALL(set_thread)(NULL);
+#endif
+}
+
+
+/**
+  Create the THD for a new connection and authenticate the client.
+
+  Called by a worker thread for the first event of a connection, so that
+  the possibly slow handshake does not block the acceptor thread.
+
+  @param connection   Connection to log in. connection->channel_info is
+                      consumed by this function.
+
+  @retval 0 on success, the connection is ready to receive commands.
+  @retval 1 on failure. The caller must call
+            threadpool_remove_connection().
+*/
+
+int threadpool_add_connection(connection_t *connection)
+{
+  Channel_info *channel_info= connection->channel_info;
+  connection->channel_info= NULL;
+
+  THD *thd= create_thd(channel_info);
+  destroy_channel_info(channel_info);
+  if (thd == NULL)
+  {
+    inc_aborted_connects();
+    dec_connection_count();
+    return 1;
+  }
+
+  connection->thd= thd;
+  thd_set_scheduler_data(thd, connection);
+
+  thd_lock_thread_count(thd);
+  /* Unlocks LOCK_thread_count */
+  thd_new_connection_setup(thd, (char*) &thd);
+
+  thread_attach(thd);
+
+  if (thd_prepare_connection(thd))
+  {
+    inc_aborted_connects();
+    thread_detach(thd);
+    return 1;
+  }
+
+  if (!thd_is_connection_alive(thd))
+  {
+    thread_detach(thd);
+    return 1;
+  }
+
+  connection->logged_in= true;
+  thd_set_net_read_write(thd, 1);
+  threadpool_update_wait_timeout(connection);
+  thread_detach(thd);
+  return 0;
+}
+
+
+/**
+  Execute the pending client command(s) of a connection.
+
+  All commands that are already buffered in the network layer are
+  executed before returning, since epoll would not report them again.
+
+  @retval 0 on success, the connection waits for the next command.
+  @retval 1 if the connection should be closed.
+*/
+
+int threadpool_process_request(connection_t *connection)
+{
+  THD *thd= connection->thd;
+  int retval= 0;
+
+  thread_attach(thd);
+
+  if (!thd_is_connection_alive(thd))
+  {
+    retval= 1;
+    goto end;
+  }
+
+  for (;;)
+  {
+    mysql_audit_release(thd);
+    if (do_command(thd) || !thd_is_connection_alive(thd))
+    {
+      retval= 1;
+      goto end;
+    }
+
+    if (!thd_connection_has_data(thd))
+      break;
+  }
+
+  /* Show the connection as reading in SHOW PROCESSLIST while idle. */
+  thd_set_net_read_write(thd, 1);
+  threadpool_update_wait_timeout(connection);
+
+end:
+  thread_detach(thd);
+  return retval;
+}
+
+
+/**
+  Close a connection and release its THD. The connection_t object itself
+  is owned and freed by the thread group.
+*/
+
+void threadpool_remove_connection(connection_t *connection)
+{
+  THD *thd= connection->thd;
+  if (thd == NULL)
+    return;
+
+  thread_attach(thd);
+  if (connection->logged_in)
+    end_connection(thd);
+  close_connection(thd, 0);
+  thd_set_scheduler_data(thd, NULL);
+  connection->thd= NULL;
+
+  /* Decrements the connection count and calls remove_connection(). */
+  Connection_handler_manager::get_instance()->remove_connection(thd);
+
+#ifdef HAVE_PSI_THREAD_INTERFACE
+  PSI_THREAD_CALL(delete_current_thread)();
+#endif
+}
+
+
+/**
+  Recompute the absolute time at which an idle connection is closed by
+  the timer thread because wait_timeout has elapsed.
+*/
+
+void threadpool_update_wait_timeout(connection_t *connection)
+{
+  ulonglong timeout_ms= 1000ULL * thd_get_net_wait_timeout(connection->thd);
+  connection->abs_wait_timeout= my_micro_time() / 1000 + timeout_ms;
+}
+
+
+bool Thread_pool_connection_handler::add_connection(Channel_info* channel_info)
+{
+  connection_t *connection=
+    (connection_t*) my_malloc(key_memory_thread_pool_connection,
+                              sizeof(connection_t), MYF(MY_ZEROFILL));
+  if (connection == NULL)
+  {
+    channel_info->send_error_and_close_channel(ER_OUT_OF_RESOURCES, 0, false);
+    return true;
+  }
+
+  connection->channel_info= channel_info;
+  connection->tickets= threadpool_high_prio_tickets;
+
+  /* The login is done by a worker thread of the connection's group. */
+  if (tp_add_connection(connection))
+  {
+    my_free(connection);
+    channel_info->send_error_and_close_channel(ER_OUT_OF_RESOURCES, 0, false);
+    return true;
+  }
+  return false;
+}
+
+
+void Thread_pool_connection_handler::remove_connection(THD* thd)
+{
+  thd_release_resources(thd);
+  thd_lock_thread_count(thd);
+  remove_global_thread(thd);
+  thd_unlock_thread_count(thd);
+  destroy_thd(thd);
+}
+
+
+static Connection_handler_callback tp_callbacks=
+{
+  tp_wait_begin,
+  tp_wait_end,
+  tp_post_kill_notification
+};
+
+
+/*
+  System variables
+*/
+
+static void fix_threadpool_size(MYSQL_THD, struct st_mysql_sys_var *,
+                                void *var_ptr, const void *save)
+{
+  uint size= *static_cast<const uint*>(save);
+  *static_cast<uint*>(var_ptr)= size;
+  tp_set_threadpool_size(size);
+}
+
+static void fix_threadpool_stall_limit(MYSQL_THD, struct st_mysql_sys_var *,
+                                       void *var_ptr, const void *save)
+{
+  uint limit= *static_cast<const uint*>(save);
+  *static_cast<uint*>(var_ptr)= limit;
+  tp_set_threadpool_stall_limit(limit);
+}
+
+static MYSQL_SYSVAR_UINT(size, threadpool_size,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of thread groups in the pool. "
+  "This parameter is roughly equivalent to maximum number of concurrently "
+  "executing threads (threads in a waiting state do not count as executing).",
+  NULL,                                 // check
+  fix_threadpool_size,                  // update
+  16, 1, MAX_THREAD_GROUPS, 1);
+
+static MYSQL_SYSVAR_UINT(stall_limit, threadpool_stall_limit,
+  PLUGIN_VAR_RQCMDARG,
+  "Maximum query execution time in milliseconds, before an executing "
+  "non-yielding thread is considered stalled. If a worker thread is "
+  "stalled, an additional worker thread may be created to handle "
+  "remaining clients.",
+  NULL,                                 // check
+  fix_threadpool_stall_limit,           // update
+  500, 10, UINT_MAX, 1);
+
+static MYSQL_SYSVAR_UINT(max_threads, threadpool_max_threads,
+  PLUGIN_VAR_RQCMDARG,
+  "Maximum allowed number of worker threads in the thread pool.",
+  NULL,                                 // check
+  NULL,                                 // update
+  100000, 1, 100000, 1);
+
+static MYSQL_SYSVAR_UINT(oversubscribe, threadpool_oversubscribe,
+  PLUGIN_VAR_RQCMDARG,
+  "How many additional active worker threads in a group are allowed.",
+  NULL,                                 // check
+  NULL,                                 // update
+  3, 1, 1000, 1);
+
+static MYSQL_SYSVAR_UINT(idle_timeout, threadpool_idle_timeout,
+  PLUGIN_VAR_RQCMDARG,
+  "Timeout in seconds for an idle thread in the thread pool. "
+  "Worker thread will be shut down after timeout.",
+  NULL,                                 // check
+  NULL,                                 // update
+  60, 1, UINT_MAX, 1);
+
+static const char *high_prio_mode_names[]=
+{ "transactions", "statements", "none", NullS };
+
+static TYPELIB high_prio_mode_typelib=
+{
+  array_elements(high_prio_mode_names) - 1,
+  "high_prio_mode_typelib",
+  high_prio_mode_names,
+  NULL
+};
+
+static MYSQL_SYSVAR_ENUM(high_priority_mode, threadpool_high_prio_mode,
+  PLUGIN_VAR_RQCMDARG,
+  "High priority queue mode: one of 'transactions', 'statements' or 'none'. "
+  "In 'transactions' mode, events of connections with an open transaction "
+  "are put into the high priority queue, so that locks are released "
+  "sooner. 'statements' puts all events there, 'none' disables the high "
+  "priority queue.",
+  NULL,                                 // check
+  NULL,                                 // update
+  TP_HIGH_PRIO_MODE_TRANSACTIONS, &high_prio_mode_typelib);
+
+static MYSQL_SYSVAR_UINT(high_priority_tickets, threadpool_high_prio_tickets,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of times a connection with an open transaction may be put into "
+  "the high priority queue before it has to wait in the low priority "
+  "queue. Prevents starvation of other connections.",
+  NULL,                                 // check
+  NULL,                                 // update
+  UINT_MAX, 0, UINT_MAX, 1);
+
+static MYSQL_SYSVAR_UINT(prio_kickup_timer, threadpool_prio_kickup_timer,
+  PLUGIN_VAR_RQCMDARG,
+  "Time in milliseconds after which an event waiting in the low priority "
+  "queue is moved to the high priority queue.",
+  NULL,                                 // check
+  NULL,                                 // update
+  1000, 0, UINT_MAX, 1);
+
+static struct st_mysql_sys_var* threadpool_system_vars[]=
+{
+  MYSQL_SYSVAR(size),
+  MYSQL_SYSVAR(stall_limit),
+  MYSQL_SYSVAR(max_threads),
+  MYSQL_SYSVAR(oversubscribe),
+  MYSQL_SYSVAR(idle_timeout),
+  MYSQL_SYSVAR(high_priority_mode),
+  MYSQL_SYSVAR(high_priority_tickets),
+  MYSQL_SYSVAR(prio_kickup_timer),
+  NULL
+};
+
+
+/*
+  Status variables
+*/
+
+static int show_threadpool_idle_threads(MYSQL_THD, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_INT;
+  var->value= buff;
+  *(int*) buff= tp_get_idle_thread_count();
+  return 0;
+}
+
+static int show_threadpool_threads(MYSQL_THD, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_INT;
+  var->value= buff;
+  *(int*) buff= tp_get_thread_count();
+  return 0;
+}
+
+static SHOW_VAR threadpool_status_vars[]=
+{
+  {"Thread_pool_threads",
+   (char*) &show_threadpool_threads, SHOW_FUNC},
+  {"Thread_pool_idle_threads",
+   (char*) &show_threadpool_idle_threads, SHOW_FUNC},
+  {"Thread_pool_active_threads",
+   (char*) &tp_stats.active_worker_threads, SHOW_INT},
+  {"Thread_pool_stalls",
+   (char*) &tp_stats.stall_count, SHOW_LONGLONG},
+  {"Thread_pool_high_prio_dequeues",
+   (char*) &tp_stats.high_prio_dequeues, SHOW_LONGLONG},
+  {"Thread_pool_low_prio_dequeues",
+   (char*) &tp_stats.low_prio_dequeues, SHOW_LONGLONG},
+  {"Thread_pool_prio_kickups",
+   (char*) &tp_stats.kickups, SHOW_LONGLONG},
+  {NULL, NULL, SHOW_LONG}
+};
+
+
+static int threadpool_plugin_init(void *)
+{
+  DBUG_ENTER("threadpool_plugin_init");
+
+#ifdef HAVE_PSI_INTERFACE
+  mysql_memory_register("thread_pool", all_thread_pool_memory,
+                        array_elements(all_thread_pool_memory));
+#endif
+
+  if (tp_init())
+    DBUG_RETURN(1);
+
+  Thread_pool_connection_handler *handler=
+    new (std::nothrow) Thread_pool_connection_handler();
+  if (handler == NULL)
+  {
+    tp_end();
+    DBUG_RETURN(1);
+  }
+
+  /* Ownership of handler is transferred to Connection_handler_manager. */
+  if (my_connection_handler_set(handler, &tp_callbacks))
+  {
+    delete handler;
+    tp_end();
+    DBUG_RETURN(1);
+  }
+  DBUG_RETURN(0);
+}
+
+
+static int threadpool_plugin_deinit(void *)
+{
+  DBUG_ENTER("threadpool_plugin_deinit");
+  my_connection_handler_reset();
+  tp_end();
+  DBUG_RETURN(0);
+}
+
+
+static struct st_mysql_daemon threadpool_plugin=
+{ MYSQL_DAEMON_INTERFACE_VERSION };
+
+mysql_declare_plugin(thread_pool)
+{
+  MYSQL_DAEMON_PLUGIN,
+  &threadpool_plugin,
+  "thread_pool",
+  "Oracle Corporation",
+  "Thread pool connection handler",
+  PLUGIN_LICENSE_GPL,
+  threadpool_plugin_init,       /* Plugin Init */
+  threadpool_plugin_deinit,     /* Plugin Deinit */
+  0x0100 /* 1.0 */,
+  threadpool_status_vars,       /* status variables */
+  threadpool_system_vars,       /* system variables */
+  NULL,                         /* config options */
+  PLUGIN_OPT_NO_INSTALL | PLUGIN_OPT_NO_UNINSTALL, /* flags */
+}
+mysql_declare_plugin_end;
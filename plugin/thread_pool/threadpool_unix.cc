@@ -0,0 +1,1224 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  Thread group implementation of the thread pool, based on epoll.
+
+  Each thread group has
+  - an epoll descriptor with all its (idle) client sockets registered
+    in one-shot mode, so that an event is reported to exactly one thread,
+  - a high and a low priority queue of connections with pending events,
+  - a list of worker threads sleeping while waiting for work,
+  - at most one listener, a worker thread blocked in epoll_wait().
+
+  The number of active (i.e. not waiting, not listening) worker threads
+  in a group is kept close to one. A worker that blocks in the server
+  (row lock, disk IO, sleep ...) reports it through thd_wait_begin(), so
+  that another worker can be woken up or created. Workers that block
+  without reporting it are caught by the timer thread, which marks a
+  group "stalled" if its queue did not move during thread_pool_stall_limit
+  milliseconds, allowing one more thread to run.
+*/
+
+#include "threadpool.h"
+
+#include <mysql/psi/mysql_thread.h>
+#include <my_sys.h>
+#include <sql_plist.h>
+#include <sys/epoll.h>
+
+
+#define MAX_EVENTS 1024
+
+#ifndef CPU_LEVEL1_DCACHE_LINESIZE
+#define CPU_LEVEL1_DCACHE_LINESIZE 64
+#endif
+
+struct thread_group_t;
+
+/* Per-thread structure for workers */
+struct worker_thread_t
+{
+  ulonglong event_count;     // number of requests handled by this thread
+  thread_group_t *thread_group;
+  worker_thread_t *next_in_list;
+  worker_thread_t **prev_in_list;
+  mysql_cond_t cond;
+  bool woken;
+};
+
+typedef I_P_List<worker_thread_t,
+                 I_P_List_adapter<worker_thread_t,
+                                  &worker_thread_t::next_in_list,
+                                  &worker_thread_t::prev_in_list> >
+worker_list_t;
+
+typedef I_P_List<connection_t,
+                 I_P_List_adapter<connection_t,
+                                  &connection_t::next_in_queue,
+                                  &connection_t::prev_in_queue>,
+                 I_P_List_null_counter,
+                 I_P_List_fast_push_back<connection_t> >
+connection_queue_t;
+
+struct thread_group_t
+{
+  mysql_mutex_t mutex;
+  connection_queue_t queue;
+  connection_queue_t high_prio_queue;
+  worker_list_t waiting_threads;
+  worker_thread_t *listener;
+  pthread_attr_t *pthread_attr;
+  int pollfd;
+  int shutdown_pipe[2];
+  int thread_count;
+  int active_thread_count;
+  int connection_count;
+  /* Event counters, reset by the timer thread for stall detection. */
+  int io_event_count;
+  int queue_event_count;
+  ulonglong last_thread_creation_time;
+  bool shutdown;
+  bool stalled;
+  /* Avoid false sharing between groups */
+  char pad[CPU_LEVEL1_DCACHE_LINESIZE];
+};
+
+static thread_group_t all_groups[MAX_THREAD_GROUPS];
+static uint group_count;
+static int32 next_group_id;
+
+/* Timer thread, for stall detection and wait_timeout handling */
+struct pool_timer_t
+{
+  mysql_mutex_t mutex;
+  mysql_cond_t cond;
+  volatile uint tick_interval;   // ms
+  ulonglong next_timeout_check;  // ms
+  pthread_t thread_id;
+  bool shutdown;
+};
+
+static pool_timer_t pool_timer;
+
+static bool threadpool_started= false;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_group_mutex;
+static PSI_mutex_key key_timer_mutex;
+static PSI_cond_key key_worker_cond;
+static PSI_cond_key key_timer_cond;
+static PSI_thread_key key_worker_thread;
+static PSI_thread_key key_timer_thread;
+
+static PSI_mutex_info mutex_list[]=
+{
+  { &key_group_mutex, "group_mutex", 0},
+  { &key_timer_mutex, "timer_mutex", PSI_FLAG_GLOBAL}
+};
+
+static PSI_cond_info cond_list[]=
+{
+  { &key_worker_cond, "worker_cond", 0},
+  { &key_timer_cond, "timer_cond", PSI_FLAG_GLOBAL}
+};
+
+static PSI_thread_info thread_list[]=
+{
+  {&key_worker_thread, "worker_thread", 0},
+  {&key_timer_thread, "timer_thread", PSI_FLAG_GLOBAL}
+};
+
+static void tp_init_psi_keys(void)
+{
+  const char *category= "thread_pool";
+  mysql_mutex_register(category, mutex_list, array_elements(mutex_list));
+  mysql_cond_register(category, cond_list, array_elements(cond_list));
+  mysql_thread_register(category, thread_list, array_elements(thread_list));
+}
+#endif /* HAVE_PSI_INTERFACE */
+
+
+static int wake_or_create_thread(thread_group_t *thread_group);
+static int create_worker(thread_group_t *thread_group);
+static void *worker_main(void *param);
+static void check_stall(thread_group_t *thread_group);
+static void connection_abort(connection_t *connection);
+
+
+static inline ulonglong now_ms()
+{
+  return my_micro_time() / 1000;
+}
+
+
+/*
+  Thin wrappers around epoll.
+
+  Sockets are registered with EPOLLONESHOT so that once an event has been
+  reported, the socket is disabled until the connection is done with its
+  request and rearms it with io_poll_start_read().
+*/
+
+static int io_poll_create()
+{
+  return epoll_create(1);
+}
+
+
+static int io_poll_associate_fd(int pollfd, int fd, void *data)
+{
+  struct epoll_event ev;
+  ev.data.u64= 0;
+  ev.data.ptr= data;
+  ev.events= EPOLLIN | EPOLLET | EPOLLERR | EPOLLRDHUP | EPOLLONESHOT;
+  return epoll_ctl(pollfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+
+static int io_poll_start_read(int pollfd, int fd, void *data)
+{
+  struct epoll_event ev;
+  ev.data.u64= 0;
+  ev.data.ptr= data;
+  ev.events= EPOLLIN | EPOLLET | EPOLLERR | EPOLLRDHUP | EPOLLONESHOT;
+  return epoll_ctl(pollfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+
+static int io_poll_disassociate_fd(int pollfd, int fd)
+{
+  struct epoll_event ev;
+  return epoll_ctl(pollfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+
+static int io_poll_wait(int pollfd, struct epoll_event *events, int maxevents,
+                        int timeout_ms)
+{
+  int ret;
+  do
+  {
+    ret= epoll_wait(pollfd, events, maxevents, timeout_ms);
+  }
+  while (ret == -1 && errno == EINTR);
+  return ret;
+}
+
+
+/**
+  Check whether the connection should be served from the high priority
+  queue.
+*/
+
+static bool connection_is_high_prio(const connection_t *c)
+{
+  if (threadpool_high_prio_mode == TP_HIGH_PRIO_MODE_STATEMENTS)
+    return true;
+
+  if (threadpool_high_prio_mode == TP_HIGH_PRIO_MODE_TRANSACTIONS)
+    return c->logged_in && c->tickets > 0 && thd_is_transaction_active(c->thd);
+
+  return false;
+}
+
+
+static bool queue_is_empty(thread_group_t *thread_group)
+{
+  return thread_group->queue.is_empty() &&
+         thread_group->high_prio_queue.is_empty();
+}
+
+
+/**
+  Put a connection with a pending event into the queue of its group.
+
+  @note Must be called with the group mutex held.
+*/
+
+static void queue_put(thread_group_t *thread_group, connection_t *connection)
+{
+  mysql_mutex_assert_owner(&thread_group->mutex);
+  connection->enqueue_time= now_ms();
+
+  if (connection_is_high_prio(connection))
+  {
+    connection->tickets--;
+    thread_group->high_prio_queue.push_back(connection);
+  }
+  else
+  {
+    connection->tickets= threadpool_high_prio_tickets;
+    thread_group->queue.push_back(connection);
+  }
+
+  if (thread_group->active_thread_count == 0)
+    wake_or_create_thread(thread_group);
+}
+
+
+/**
+  Take the next connection off the queues of a group.
+
+  The high priority queue is served first. Events that have waited in the
+  low priority queue for longer than thread_pool_prio_kickup_timer are
+  moved to the high priority queue first, so they cannot starve.
+
+  @note Must be called with the group mutex held.
+*/
+
+static connection_t *queue_get(thread_group_t *thread_group)
+{
+  mysql_mutex_assert_owner(&thread_group->mutex);
+  thread_group->queue_event_count++;
+
+  if (threadpool_high_prio_mode != TP_HIGH_PRIO_MODE_NONE &&
+      !thread_group->queue.is_empty())
+  {
+    ulonglong kickup_limit= now_ms() - threadpool_prio_kickup_timer;
+    connection_t *c;
+    while ((c= thread_group->queue.front()) != NULL &&
+           c->enqueue_time < kickup_limit)
+    {
+      thread_group->queue.remove(c);
+      thread_group->high_prio_queue.push_back(c);
+      my_atomic_add64(&tp_stats.kickups, 1);
+    }
+  }
+
+  connection_t *connection= thread_group->high_prio_queue.pop_front();
+  if (connection)
+  {
+    my_atomic_add64(&tp_stats.high_prio_dequeues, 1);
+    return connection;
+  }
+
+  connection= thread_group->queue.pop_front();
+  if (connection)
+    my_atomic_add64(&tp_stats.low_prio_dequeues, 1);
+  return connection;
+}
+
+
+/**
+  Wake a sleeping worker of the group.
+
+  @retval 0  a thread was woken up
+  @retval -1 no thread was waiting
+*/
+
+static int wake_thread(thread_group_t *thread_group)
+{
+  worker_thread_t *thread= thread_group->waiting_threads.front();
+  if (thread == NULL)
+    return -1;
+
+  thread->woken= true;
+  thread_group->waiting_threads.remove(thread);
+  mysql_cond_signal(&thread->cond);
+  return 0;
+}
+
+
+/**
+  Minimal interval between creation of two threads in the same group,
+  in microseconds. The more threads the group has, the more hesitant we
+  are to create yet another one.
+*/
+
+static ulonglong microsecond_throttling_interval(thread_group_t *thread_group)
+{
+  int count= thread_group->thread_count;
+
+  if (count < 4)
+    return 0;
+  if (count < 8)
+    return 50 * 1000;
+  if (count < 16)
+    return 100 * 1000;
+  return 200 * 1000;
+}
+
+
+/**
+  Wake a waiting worker, or create a new one if none is waiting and
+  creation is not throttled.
+
+  @note Must be called with the group mutex held.
+*/
+
+static int wake_or_create_thread(thread_group_t *thread_group)
+{
+  mysql_mutex_assert_owner(&thread_group->mutex);
+
+  if (thread_group->shutdown)
+    return 0;
+
+  if (wake_thread(thread_group) == 0)
+    return 0;
+
+  if (thread_group->thread_count > thread_group->connection_count)
+    return -1;
+
+  if (thread_group->active_thread_count == 0)
+  {
+    /*
+      We're better off creating a new thread here with no delay: either
+      there are no workers at all, or they are all blocked, and there
+      was no idle thread to wake up.
+    */
+    return create_worker(thread_group);
+  }
+
+  /*
+    Throttle thread creation; the timer thread retries later if the
+    group stays stalled.
+  */
+  ulonglong now= my_micro_time();
+  if (now - thread_group->last_thread_creation_time <
+      microsecond_throttling_interval(thread_group))
+    return 0;
+
+  return create_worker(thread_group);
+}
+
+
+/**
+  Create a new worker thread in the group.
+
+  @note Must be called with the group mutex held.
+*/
+
+static int create_worker(thread_group_t *thread_group)
+{
+  pthread_t thread_id;
+  int err;
+
+  if ((uint) my_atomic_load32(&tp_stats.num_worker_threads) >=
+      threadpool_max_threads)
+  {
+    static ulonglong last_report= 0;
+    ulonglong now= now_ms();
+    if (now > last_report + 60 * 1000)
+    {
+      sql_print_error("Thread pool: thread_pool_max_threads (%u) reached, "
+                      "cannot create more worker threads",
+                      threadpool_max_threads);
+      last_report= now;
+    }
+    errno= EAGAIN;
+    return -1;
+  }
+
+  err= mysql_thread_create(key_worker_thread, &thread_id,
+                           thread_group->pthread_attr, worker_main,
+                           thread_group);
+  if (!err)
+  {
+    thread_group->last_thread_creation_time= my_micro_time();
+    thread_group->thread_count++;
+    thread_group->active_thread_count++;
+    my_atomic_add32(&tp_stats.num_worker_threads, 1);
+    inc_thread_created();
+  }
+  else
+    my_errno= errno;
+  return err;
+}
+
+
+/**
+  Too many active threads in the group. Workers refrain from picking up
+  new work until this is no longer the case, unless the group is stalled.
+*/
+
+static bool too_many_threads(thread_group_t *thread_group)
+{
+  return (thread_group->active_thread_count >= 1 + (int) threadpool_oversubscribe
+          && !thread_group->stalled);
+}
+
+
+/**
+  Listener loop: wait for network events and dispatch them.
+
+  The listener puts the events into the queues of the group and wakes
+  up workers. If the queues were empty, it keeps the first event and
+  handles it itself, saving a context switch in the common case of a
+  mostly idle group.
+
+  @return connection to handle, or NULL on shutdown.
+*/
+
+static connection_t *listener(worker_thread_t *current_thread,
+                              thread_group_t *thread_group)
+{
+  connection_t *retval= NULL;
+
+  for (;;)
+  {
+    struct epoll_event ev[MAX_EVENTS];
+    int cnt;
+
+    if (thread_group->shutdown)
+      break;
+
+    cnt= io_poll_wait(thread_group->pollfd, ev, MAX_EVENTS, -1);
+
+    if (cnt <= 0)
+    {
+      DBUG_ASSERT(thread_group->shutdown);
+      break;
+    }
+
+    mysql_mutex_lock(&thread_group->mutex);
+
+    if (thread_group->shutdown)
+    {
+      mysql_mutex_unlock(&thread_group->mutex);
+      break;
+    }
+
+    thread_group->io_event_count+= cnt;
+
+    /*
+      Handle one event ourselves if there was nothing queued; otherwise
+      there is a backlog and the event is better off in the queue.
+    */
+    bool listener_picks_event= queue_is_empty(thread_group);
+
+    for (int i= (listener_picks_event ? 1 : 0); i < cnt; i++)
+    {
+      connection_t *c= static_cast<connection_t*>(ev[i].data.ptr);
+      if (c != NULL)
+        queue_put(thread_group, c);
+    }
+
+    if (listener_picks_event)
+    {
+      retval= static_cast<connection_t*>(ev[0].data.ptr);
+      if (retval == NULL)
+      {
+        /* Shutdown notification */
+        mysql_mutex_unlock(&thread_group->mutex);
+        continue;
+      }
+      thread_group->listener= NULL;
+      mysql_mutex_unlock(&thread_group->mutex);
+      break;
+    }
+
+    if (thread_group->active_thread_count == 0)
+    {
+      /* We added some work items to the queue, now wake a worker. */
+      if (wake_thread(thread_group))
+      {
+        /*
+          Wake failed, hence there are no waiting threads and no active
+          ones. If this listener is the only thread, create a worker so
+          that the queue is served while we keep listening.
+        */
+        if (thread_group->thread_count == 1)
+          create_worker(thread_group);
+      }
+    }
+    mysql_mutex_unlock(&thread_group->mutex);
+  }
+
+  return retval;
+}
+
+
+/**
+  Retrieve the next event to handle for a worker.
+
+  The worker serves the queues first, becomes the listener if the group
+  has none, and otherwise sleeps until woken up or until
+  thread_pool_idle_timeout has elapsed.
+
+  @return connection to handle, or NULL if the thread should exit.
+*/
+
+static connection_t *get_event(worker_thread_t *current_thread,
+                               thread_group_t *thread_group,
+                               struct timespec *abstime)
+{
+  connection_t *connection= NULL;
+  int err= 0;
+
+  mysql_mutex_lock(&thread_group->mutex);
+  DBUG_ASSERT(thread_group->active_thread_count >= 0);
+  thread_group->active_thread_count--;
+
+  for (;;)
+  {
+    bool oversubscribed= too_many_threads(thread_group);
+
+    if (thread_group->shutdown)
+      break;
+
+    /* Check the queues first */
+    if (!oversubscribed)
+    {
+      connection= queue_get(thread_group);
+      if (connection)
+        break;
+    }
+
+    /* If there is currently no listener in the group, become one. */
+    if (!thread_group->listener)
+    {
+      thread_group->listener= current_thread;
+      mysql_mutex_unlock(&thread_group->mutex);
+
+      connection= listener(current_thread, thread_group);
+
+      mysql_mutex_lock(&thread_group->mutex);
+      /* There is no listener anymore, it just returned. */
+      thread_group->listener= NULL;
+      break;
+    }
+
+    /*
+      Last thing we try before going to sleep is to pick a single event
+      without waiting.
+    */
+    if (!oversubscribed)
+    {
+      struct epoll_event ev;
+      if (io_poll_wait(thread_group->pollfd, &ev, 1, 0) == 1)
+      {
+        thread_group->io_event_count++;
+        connection= static_cast<connection_t*>(ev.data.ptr);
+        if (connection)
+          break;
+      }
+    }
+
+    /* And now, finally sleep */
+    current_thread->woken= false;
+    thread_group->waiting_threads.push_front(current_thread);
+
+    if (abstime)
+      err= mysql_cond_timedwait(&current_thread->cond, &thread_group->mutex,
+                                abstime);
+    else
+      err= mysql_cond_wait(&current_thread->cond, &thread_group->mutex);
+
+    if (!current_thread->woken)
+    {
+      /*
+        Thread was not signalled by wake(), it might be a spurious
+        wakeup or a timeout. Anyhow, we need to remove ourselves from the
+        list now. If thread was explicitly woken, then the waker removed
+        us from the list.
+      */
+      thread_group->waiting_threads.remove(current_thread);
+    }
+
+    if (err)
+      break;
+  }
+
+  thread_group->stalled= false;
+  thread_group->active_thread_count++;
+  mysql_mutex_unlock(&thread_group->mutex);
+
+  return connection;
+}
+
+
+/**
+  Move a connection to another group when thread_pool_size has been
+  reduced below the group it was assigned to.
+*/
+
+static int change_group(connection_t *c, thread_group_t *new_group)
+{
+  thread_group_t *old_group= c->thread_group;
+  int fd= thd_get_fd(c->thd);
+  int ret= 0;
+
+  /* Remove connection from the old group. */
+  mysql_mutex_lock(&old_group->mutex);
+  if (c->bound_to_poll_descriptor)
+  {
+    io_poll_disassociate_fd(old_group->pollfd, fd);
+    c->bound_to_poll_descriptor= false;
+  }
+  old_group->connection_count--;
+  mysql_mutex_unlock(&old_group->mutex);
+
+  /* Add connection to the new group. */
+  mysql_mutex_lock(&new_group->mutex);
+  c->thread_group= new_group;
+  new_group->connection_count++;
+  /* Ensure that there is a listener in the new group. */
+  if (new_group->pollfd == -1 &&
+      (new_group->pollfd= io_poll_create()) < 0)
+    ret= -1;
+  else if (!new_group->thread_count)
+    ret= create_worker(new_group);
+  mysql_mutex_unlock(&new_group->mutex);
+  return ret;
+}
+
+
+/**
+  (Re)arm the connection's socket in the epoll descriptor of its group,
+  so that the next client request is reported.
+*/
+
+static int start_io(connection_t *connection)
+{
+  int fd= thd_get_fd(connection->thd);
+
+  uint group_id= (uint) (connection->thread_group - all_groups);
+  if (group_id >= group_count)
+  {
+    if (change_group(connection, &all_groups[group_id % group_count]))
+      return -1;
+  }
+
+  thread_group_t *group= connection->thread_group;
+
+  if (!connection->bound_to_poll_descriptor)
+  {
+    connection->bound_to_poll_descriptor= true;
+    return io_poll_associate_fd(group->pollfd, fd, connection);
+  }
+
+  return io_poll_start_read(group->pollfd, fd, connection);
+}
+
+
+static void handle_event(connection_t *connection)
+{
+  int err;
+
+  if (!connection->logged_in)
+  {
+    err= threadpool_add_connection(connection);
+  }
+  else
+  {
+    /* Not idle anymore, the timer must not close it for wait_timeout. */
+    connection->abs_wait_timeout= ULONGLONG_MAX;
+    err= threadpool_process_request(connection);
+  }
+
+  if (!err)
+    err= start_io(connection);
+
+  if (err)
+    connection_abort(connection);
+}
+
+
+/**
+  Close a connection and free its thread pool state.
+*/
+
+static void connection_abort(connection_t *connection)
+{
+  thread_group_t *group= connection->thread_group;
+
+  threadpool_remove_connection(connection);
+
+  mysql_mutex_lock(&group->mutex);
+  group->connection_count--;
+  mysql_mutex_unlock(&group->mutex);
+
+  my_free(connection);
+}
+
+
+/**
+  Worker thread's main loop.
+*/
+
+static void *worker_main(void *param)
+{
+  worker_thread_t this_thread;
+  thread_group_t *thread_group= static_cast<thread_group_t*>(param);
+
+  if (init_new_connection_handler_thread())
+  {
+    mysql_mutex_lock(&thread_group->mutex);
+    thread_group->active_thread_count--;
+    thread_group->thread_count--;
+    mysql_mutex_unlock(&thread_group->mutex);
+    my_atomic_add32(&tp_stats.num_worker_threads, -1);
+    return NULL;
+  }
+
+  mysql_cond_init(key_worker_cond, &this_thread.cond, NULL);
+  this_thread.thread_group= thread_group;
+  this_thread.event_count= 0;
+
+  /* Run event loop */
+  for (;;)
+  {
+    struct timespec ts;
+    set_timespec(ts, threadpool_idle_timeout);
+
+    connection_t *connection= get_event(&this_thread, thread_group, &ts);
+    if (!connection)
+      break;
+
+    this_thread.event_count++;
+    my_atomic_add32(&tp_stats.active_worker_threads, 1);
+    handle_event(connection);
+    my_atomic_add32(&tp_stats.active_worker_threads, -1);
+  }
+
+  /* Thread shutdown: cleanup per-worker-thread structure. */
+  mysql_cond_destroy(&this_thread.cond);
+
+  mysql_mutex_lock(&thread_group->mutex);
+  thread_group->active_thread_count--;
+  thread_group->thread_count--;
+  mysql_mutex_unlock(&thread_group->mutex);
+
+  my_atomic_add32(&tp_stats.num_worker_threads, -1);
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Close wait_timeout expired idle connections.
+
+  Connections of the pool do not have a thread blocked in read() whose
+  timeout would fire, so the timer thread kills them instead.
+*/
+
+static void timeout_check(pool_timer_t *timer)
+{
+  ulonglong now= now_ms();
+
+  thd_lock_thread_count(NULL);
+  Thread_iterator it= thd_get_global_thread_list_begin();
+  Thread_iterator end= thd_get_global_thread_list_end();
+  for (; it != end; ++it)
+  {
+    THD *thd= *it;
+    connection_t *connection=
+      static_cast<connection_t*>(thd_get_scheduler_data(thd));
+    if (connection == NULL)
+      continue;
+
+    if (connection->abs_wait_timeout < now)
+    {
+      /* Wait timeout exceeded, kill the connection. */
+      thd_lock_data(thd);
+      thd_set_killed(thd);
+      thd_close_connection(thd);
+      thd_unlock_data(thd);
+      connection->abs_wait_timeout= ULONGLONG_MAX;
+    }
+  }
+  thd_unlock_thread_count(NULL);
+
+  timer->next_timeout_check= now + 1000;
+}
+
+
+/**
+  Timer thread.
+
+  Every tick_interval (thread_pool_stall_limit) milliseconds, check each
+  thread group for stalls, and once per second close connections that
+  exceeded wait_timeout.
+*/
+
+static void *timer_thread(void *param)
+{
+  pool_timer_t *timer= static_cast<pool_timer_t*>(param);
+
+  my_thread_init();
+  timer->next_timeout_check= ULONGLONG_MAX;
+
+  for (;;)
+  {
+    struct timespec ts;
+    int err;
+
+    set_timespec_nsec(ts, (ulonglong) timer->tick_interval * 1000000ULL);
+    mysql_mutex_lock(&timer->mutex);
+    err= mysql_cond_timedwait(&timer->cond, &timer->mutex, &ts);
+    if (timer->shutdown)
+    {
+      mysql_mutex_unlock(&timer->mutex);
+      break;
+    }
+    mysql_mutex_unlock(&timer->mutex);
+
+    if (err == ETIMEDOUT)
+    {
+      /* Check stalls in thread groups */
+      for (uint i= 0; i < array_elements(all_groups); i++)
+      {
+        if (all_groups[i].connection_count)
+          check_stall(&all_groups[i]);
+      }
+
+      /* Check if any client exceeded wait_timeout */
+      if (timer->next_timeout_check == ULONGLONG_MAX ||
+          timer->next_timeout_check <= now_ms())
+        timeout_check(timer);
+    }
+  }
+
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Check whether a thread group makes progress.
+
+  - If there is no listener and no IO was handled since the last check,
+    the group's events are not being picked up: wake or create a worker
+    that will become the listener.
+  - If the queue is not empty but nothing was dequeued since the last
+    check, all active workers are busy with long running requests that
+    did not report their waits. Mark the group stalled, which lifts the
+    thread_pool_oversubscribe limit, and wake or create a worker.
+*/
+
+static void check_stall(thread_group_t *thread_group)
+{
+  if (mysql_mutex_trylock(&thread_group->mutex) != 0)
+  {
+    /* Something happens. Don't disturb */
+    return;
+  }
+
+  if (!thread_group->listener && !thread_group->io_event_count)
+    wake_or_create_thread(thread_group);
+
+  /* Reset io event count */
+  thread_group->io_event_count= 0;
+
+  if (!queue_is_empty(thread_group) && !thread_group->queue_event_count)
+  {
+    thread_group->stalled= true;
+    my_atomic_add64(&tp_stats.stall_count, 1);
+    wake_or_create_thread(thread_group);
+  }
+
+  /* Reset queue event count */
+  thread_group->queue_event_count= 0;
+
+  mysql_mutex_unlock(&thread_group->mutex);
+}
+
+
+static int thread_group_init(thread_group_t *thread_group,
+                             pthread_attr_t *thread_attr)
+{
+  mysql_mutex_init(key_group_mutex, &thread_group->mutex, NULL);
+  thread_group->pollfd= -1;
+  thread_group->shutdown_pipe[0]= -1;
+  thread_group->shutdown_pipe[1]= -1;
+  thread_group->pthread_attr= thread_attr;
+  thread_group->queue.empty();
+  thread_group->high_prio_queue.empty();
+  thread_group->waiting_threads.empty();
+  return 0;
+}
+
+
+/**
+  Initiate shutdown of a thread group: wake up the listener through the
+  shutdown pipe and all sleeping workers.
+*/
+
+static void thread_group_close(thread_group_t *thread_group)
+{
+  mysql_mutex_lock(&thread_group->mutex);
+  if (thread_group->thread_count == 0)
+  {
+    mysql_mutex_unlock(&thread_group->mutex);
+    return;
+  }
+
+  thread_group->shutdown= true;
+  thread_group->listener= NULL;
+
+  if (pipe(thread_group->shutdown_pipe))
+  {
+    mysql_mutex_unlock(&thread_group->mutex);
+    return;
+  }
+
+  /* Wake listener */
+  if (io_poll_associate_fd(thread_group->pollfd,
+                           thread_group->shutdown_pipe[0], NULL))
+  {
+    mysql_mutex_unlock(&thread_group->mutex);
+    return;
+  }
+  char c= 0;
+  if (write(thread_group->shutdown_pipe[1], &c, 1) < 0)
+  {
+    mysql_mutex_unlock(&thread_group->mutex);
+    return;
+  }
+
+  /* Wake all workers. */
+  while (wake_thread(thread_group) == 0)
+  { }
+
+  mysql_mutex_unlock(&thread_group->mutex);
+}
+
+
+static void thread_group_destroy(thread_group_t *thread_group)
+{
+  mysql_mutex_destroy(&thread_group->mutex);
+  if (thread_group->pollfd != -1)
+  {
+    close(thread_group->pollfd);
+    thread_group->pollfd= -1;
+  }
+  for (int i= 0; i < 2; i++)
+  {
+    if (thread_group->shutdown_pipe[i] != -1)
+    {
+      close(thread_group->shutdown_pipe[i]);
+      thread_group->shutdown_pipe[i]= -1;
+    }
+  }
+}
+
+
+/**
+  Assign a new connection to a thread group and queue its login event.
+
+  @retval false on success
+  @retval true  if the group could not be set up
+*/
+
+bool tp_add_connection(connection_t *connection)
+{
+  uint group_id= (uint) my_atomic_add32(&next_group_id, 1) % group_count;
+  thread_group_t *group= &all_groups[group_id];
+
+  connection->thread_group= group;
+  connection->abs_wait_timeout= ULONGLONG_MAX;
+
+  mysql_mutex_lock(&group->mutex);
+  if (group->pollfd == -1 && (group->pollfd= io_poll_create()) < 0)
+  {
+    group->pollfd= -1;
+    mysql_mutex_unlock(&group->mutex);
+    return true;
+  }
+  group->connection_count++;
+  /* The login is handled by a worker like any other event. */
+  queue_put(group, connection);
+  mysql_mutex_unlock(&group->mutex);
+  return false;
+}
+
+
+/**
+  Called by thd_wait_begin(): the current worker is about to block, so
+  let another worker of the group run.
+*/
+
+void tp_wait_begin(THD *thd, int)
+{
+  if (thd == NULL && (thd= thd_get_current_thd()) == NULL)
+    return;
+
+  connection_t *connection=
+    static_cast<connection_t*>(thd_get_scheduler_data(thd));
+  if (connection == NULL || connection->waiting)
+    return;
+
+  thread_group_t *thread_group= connection->thread_group;
+  connection->waiting= true;
+
+  mysql_mutex_lock(&thread_group->mutex);
+  thread_group->active_thread_count--;
+  if (thread_group->active_thread_count == 0 &&
+      (!queue_is_empty(thread_group) || !thread_group->listener))
+  {
+    /*
+      Group might stall while this thread waits, thus wake or create a
+      worker to prevent stall.
+    */
+    wake_or_create_thread(thread_group);
+  }
+  mysql_mutex_unlock(&thread_group->mutex);
+}
+
+
+/**
+  Called by thd_wait_end(): the current worker is running again.
+*/
+
+void tp_wait_end(THD *thd)
+{
+  if (thd == NULL && (thd= thd_get_current_thd()) == NULL)
+    return;
+
+  connection_t *connection=
+    static_cast<connection_t*>(thd_get_scheduler_data(thd));
+  if (connection == NULL || !connection->waiting)
+    return;
+
+  thread_group_t *thread_group= connection->thread_group;
+  connection->waiting= false;
+
+  mysql_mutex_lock(&thread_group->mutex);
+  thread_group->active_thread_count++;
+  mysql_mutex_unlock(&thread_group->mutex);
+}
+
+
+/**
+  Called when a connection is killed: shut its socket down so that the
+  idle connection is reported by epoll and closed by a worker.
+*/
+
+void tp_post_kill_notification(THD *thd)
+{
+  if (thd == thd_get_current_thd() || thd_get_scheduler_data(thd) == NULL)
+    return;
+  thd_close_connection(thd);
+}
+
+
+void tp_set_threadpool_size(uint size)
+{
+  if (!threadpool_started)
+    return;
+
+  for (uint i= 0; i < size; i++)
+  {
+    thread_group_t *group= &all_groups[i];
+    mysql_mutex_lock(&group->mutex);
+    if (group->pollfd == -1 && (group->pollfd= io_poll_create()) < 0)
+    {
+      group->pollfd= -1;
+      mysql_mutex_unlock(&group->mutex);
+      sql_print_error("Thread pool: epoll_create() failed, errno %d; "
+                      "thread_pool_size set to %u", errno, i);
+      size= i;
+      threadpool_size= i;
+      break;
+    }
+    mysql_mutex_unlock(&group->mutex);
+  }
+  if (size > 0)
+    group_count= size;
+}
+
+
+void tp_set_threadpool_stall_limit(uint limit)
+{
+  if (!threadpool_started)
+    return;
+
+  mysql_mutex_lock(&pool_timer.mutex);
+  pool_timer.tick_interval= limit;
+  mysql_cond_signal(&pool_timer.cond);
+  mysql_mutex_unlock(&pool_timer.mutex);
+}
+
+
+int tp_get_idle_thread_count()
+{
+  int sum= 0;
+  for (uint i= 0; i < array_elements(all_groups) &&
+       all_groups[i].pollfd >= 0; i++)
+  {
+    sum+= (all_groups[i].thread_count - all_groups[i].active_thread_count);
+  }
+  return sum;
+}
+
+
+int tp_get_thread_count()
+{
+  return my_atomic_load32(&tp_stats.num_worker_threads);
+}
+
+
+bool tp_init()
+{
+#ifdef HAVE_PSI_INTERFACE
+  tp_init_psi_keys();
+#endif
+
+  for (uint i= 0; i < array_elements(all_groups); i++)
+    thread_group_init(&all_groups[i], get_connection_attrib());
+
+  threadpool_started= true;
+  tp_set_threadpool_size(threadpool_size);
+  if (group_count == 0)
+  {
+    threadpool_started= false;
+    sql_print_error("Thread pool: could not create any thread group");
+    return true;
+  }
+
+  mysql_mutex_init(key_timer_mutex, &pool_timer.mutex, NULL);
+  mysql_cond_init(key_timer_cond, &pool_timer.cond, NULL);
+  pool_timer.tick_interval= threadpool_stall_limit;
+  pool_timer.shutdown= false;
+  /* The timer thread is joinable, tp_end() waits for it. */
+  if (mysql_thread_create(key_timer_thread, &pool_timer.thread_id,
+                          NULL, timer_thread, &pool_timer))
+  {
+    sql_print_error("Thread pool: could not create the timer thread");
+    mysql_cond_destroy(&pool_timer.cond);
+    mysql_mutex_destroy(&pool_timer.mutex);
+    threadpool_started= false;
+    return true;
+  }
+  return false;
+}
+
+
+void tp_end()
+{
+  if (!threadpool_started)
+    return;
+
+  mysql_mutex_lock(&pool_timer.mutex);
+  pool_timer.shutdown= true;
+  mysql_cond_signal(&pool_timer.cond);
+  mysql_mutex_unlock(&pool_timer.mutex);
+  pthread_join(pool_timer.thread_id, NULL);
+
+  for (uint i= 0; i < array_elements(all_groups); i++)
+    thread_group_close(&all_groups[i]);
+
+  /* Wait for the workers to notice the shutdown and exit. */
+  while (my_atomic_load32(&tp_stats.num_worker_threads) > 0)
+    my_sleep(1000);
+
+  for (uint i= 0; i < array_elements(all_groups); i++)
+    thread_group_destroy(&all_groups[i]);
+
+  mysql_cond_destroy(&pool_timer.cond);
+  mysql_mutex_destroy(&pool_timer.mutex);
+  threadpool_started= false;
+}
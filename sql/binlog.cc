@@ -64,6 +64,10 @@ static int limit_unsafe_warning_count= 0;
 
 static handlerton *binlog_hton;
 bool opt_binlog_order_commits= true;
+bool opt_binlog_parallel_flush= false;
+ulong opt_binlog_transaction_dependency_tracking=
+  DEPENDENCY_TRACKING_COMMIT_ORDER;
+ulong opt_binlog_transaction_dependency_history_size= 25000;
 
 const char *log_bin_index= 0;
 const char *log_bin_basename= 0;
@@ -324,7 +328,14 @@ public:
 
   int finalize(THD *thd, Log_event *end_event);
   int flush(THD *thd, my_off_t *bytes, bool *wrote_xid);
+  int reserve_range(THD *thd, my_off_t *end_pos, my_off_t *bytes);
+  void copy_to_range();
+  int finish_range(THD *thd, bool *wrote_xid, my_off_t *end_pos);
   int write_event(THD *thd, Log_event *event);
+  void add_write_set(TABLE *table, const uchar *record,
+                     const MY_BITMAP *read_cols,
+                     const MY_BITMAP *write_cols);
+  void assign_commit_parent();
 
   virtual ~binlog_cache_data()
   {
@@ -383,6 +394,52 @@ public:
     return flags.transactional;
   }
 
+  /**
+    Assign the cache a range of the binary log.
+
+    @param start   Start of the range
+    @param end     End of the range
+    @param written @c true if the cache was already written into the
+                   range, @c false if it is still to be copied there.
+   */
+  void set_range(my_off_t start, my_off_t end, bool written)
+  {
+    range_start= start;
+    range_end= end;
+    range_errno= 0;
+    flags.range_reserved= true;
+    flags.range_written= written;
+  }
+
+  /**
+    Find the failed copy of the cache, if it is before the one found so
+    far.
+
+    @param[in,out] pos   Start of the first failed range found so far
+    @param[in,out] error Its errno, or zero if none was found
+   */
+  void find_failed_range(my_off_t *pos, int *error) const
+  {
+    if (flags.range_reserved && range_errno && range_start < *pos)
+    {
+      *pos= range_start;
+      *error= range_errno;
+    }
+  }
+
+  /**
+    Fail the flush of the cache if its range ends after @c pos, where
+    the binary log is truncated because a copy before it failed.
+
+    @param pos   Start of the first failed range
+    @param error Its errno
+   */
+  void cancel_range(my_off_t pos, int error)
+  {
+    if (flags.range_reserved && !range_errno && range_end > pos)
+      range_errno= error;
+  }
+
   my_off_t get_byte_position() const
   {
     return my_b_tell(&cache_log);
@@ -415,6 +472,10 @@ public:
     flags.with_xid= false;
     flags.immediate= false;
     flags.finalized= false;
+    flags.range_reserved= false;
+    flags.range_written= false;
+    flags.write_set_unsafe= false;
+    write_set.clear();
     /*
       The truncate function calls reinit_io_cache that calls my_b_flush_io_cache
       which may increase disk_writes. This breaks the disk_writes use by the
@@ -470,6 +531,21 @@ public:
   */
   Group_cache group_cache;
 
+  /*
+    Range of the binary log given to the cache by the flush stage
+    leader when the caches are copied in parallel (see set_range()),
+    and the errno of a failed copy, or zero.
+  */
+  my_off_t range_start;
+  my_off_t range_end;
+  int range_errno;
+
+  /*
+    Hashes of the primary and unique keys of the rows logged into the
+    cache, see add_write_set().
+  */
+  std::set<ulonglong> write_set;
+
 protected:
   /*
     It truncates the cache to a certain position. This includes deleting the
@@ -533,6 +609,26 @@ protected:
       This indicates that the cache contain an XID event.
      */
     bool with_xid:1;
+
+    /*
+      This indicates that the cache was given a range of the binary
+      log by the flush stage leader.
+     */
+    bool range_reserved:1;
+
+    /*
+      This indicates that the leader wrote the cache into its range
+      itself, so there is nothing left to copy.
+     */
+    bool range_written:1;
+
+    /*
+      This indicates that the write set does not tell all the rows that
+      the events of the cache change, so the slave must not apply them in
+      parallel with a transaction just because the write sets do not
+      intersect.
+     */
+    bool write_set_unsafe:1;
   } flags;
 
 private:
@@ -778,6 +874,57 @@ public:
     return 0;
   }
 
+  /**
+    Reserve ranges of the binary log for the caches of the session.
+
+    @see binlog_cache_data::reserve_range
+   */
+  int reserve_ranges(THD *thd, my_off_t *end_pos, my_off_t *bytes_written)
+  {
+    my_off_t stmt_bytes= 0;
+    my_off_t trx_bytes= 0;
+    if (int error= stmt_cache.reserve_range(thd, end_pos, &stmt_bytes))
+      return error;
+    if (int error= trx_cache.reserve_range(thd, end_pos, &trx_bytes))
+      return error;
+    *bytes_written= stmt_bytes + trx_bytes;
+    return 0;
+  }
+
+  void copy_to_ranges()
+  {
+    stmt_cache.copy_to_range();
+    trx_cache.copy_to_range();
+  }
+
+  void find_failed_ranges(my_off_t *pos, int *error) const
+  {
+    stmt_cache.find_failed_range(pos, error);
+    trx_cache.find_failed_range(pos, error);
+  }
+
+  void cancel_ranges(my_off_t pos, int error)
+  {
+    stmt_cache.cancel_range(pos, error);
+    trx_cache.cancel_range(pos, error);
+  }
+
+  /**
+    Finish the flush of caches copied into their ranges.
+
+    @param thd       The session owning the caches
+    @param wrote_xid Set to @c true if an XID event was written
+    @param end_pos   Set to the end of the last range written, if any
+   */
+  int finish_ranges(THD *thd, bool *wrote_xid, my_off_t *end_pos)
+  {
+    if (int error= stmt_cache.finish_range(thd, wrote_xid, end_pos))
+      return error;
+    if (int error= trx_cache.finish_range(thd, wrote_xid, end_pos))
+      return error;
+    return 0;
+  }
+
   binlog_stmt_cache_data stmt_cache;
   binlog_trx_cache_data trx_cache;
 
@@ -966,11 +1113,149 @@ int binlog_cache_data::write_event(THD *thd, Log_event *ev)
       flags.with_xid= true;
     if (ev->is_using_immediate_logging())
       flags.immediate= true;
+
+    /*
+      Only the rows of row events are in the write set: any other change,
+      such as a statement or a LOAD DATA, makes it unsafe.
+    */
+    switch (ev->get_type_code())
+    {
+    case QUERY_EVENT:
+      if (!static_cast<Query_log_event*>(ev)->is_trans_keyword())
+        flags.write_set_unsafe= true;
+      break;
+    case XID_EVENT:
+    case TABLE_MAP_EVENT:
+    case ROWS_QUERY_LOG_EVENT:
+    case WRITE_ROWS_EVENT:
+    case UPDATE_ROWS_EVENT:
+    case DELETE_ROWS_EVENT:
+    case WRITE_ROWS_EVENT_V1:
+    case UPDATE_ROWS_EVENT_V1:
+    case DELETE_ROWS_EVENT_V1:
+      break;
+    default:
+      flags.write_set_unsafe= true;
+      break;
+    }
   }
   DBUG_RETURN(0);
 }
 
 
+/**
+  Add the primary and unique keys of a row to the write set of the cache.
+
+  Each key of the row that has no NULL part is hashed, together with the
+  name of the table and the number of the key, using the collations of
+  its columns so that values that are equal for the key give equal
+  hashes. The write set is marked unsafe instead if
+  @c binlog_transaction_dependency_tracking is not WRITESET, or if the
+  row cannot be told apart by its keys: the table has no primary or
+  unique key, a key is on a prefix of a column or on a column whose value
+  is not in the record, or the table is referenced by a foreign key.
+
+  @param table      The table of the row
+  @param record     The row, in the format of @c table->record[0]
+  @param read_cols  The columns with a value in the record, or NULL if
+                    all columns have one
+  @param write_cols The columns set by the statement, which have a value
+                    in the record too, or NULL
+ */
+void binlog_cache_data::add_write_set(TABLE *table, const uchar *record,
+                                      const MY_BITMAP *read_cols,
+                                      const MY_BITMAP *write_cols)
+{
+  DBUG_ENTER("binlog_cache_data::add_write_set");
+  if (flags.write_set_unsafe)
+    DBUG_VOID_RETURN;
+
+  if (opt_binlog_transaction_dependency_tracking !=
+      DEPENDENCY_TRACKING_WRITESET ||
+      table->file->referenced_by_foreign_key())
+  {
+    flags.write_set_unsafe= true;
+    write_set.clear();
+    DBUG_VOID_RETURN;
+  }
+
+  my_ptrdiff_t const offset= record - table->record[0];
+  const CHARSET_INFO *const cs= &my_charset_bin;
+  bool has_unique_key= false;
+  bool unsafe= false;
+
+  for (uint key= 0; key < table->s->keys && !unsafe; key++)
+  {
+    KEY *const key_info= table->key_info + key;
+    if (!(key_info->flags & HA_NOSAME))
+      continue;
+    has_unique_key= true;
+
+    ulong nr1= 1, nr2= 4;
+    uchar key_nr[2];
+    int2store(key_nr, key);
+    cs->coll->hash_sort(cs, (const uchar *) table->s->table_cache_key.str,
+                        table->s->table_cache_key.length, &nr1, &nr2);
+    cs->coll->hash_sort(cs, key_nr, sizeof(key_nr), &nr1, &nr2);
+
+    bool has_null= false;
+    for (uint part= 0; part < key_info->user_defined_key_parts; part++)
+    {
+      KEY_PART_INFO *const key_part= key_info->key_part + part;
+      Field *const field= key_part->field;
+      if ((key_part->key_part_flag & HA_PART_KEY_SEG) ||
+          (read_cols && !bitmap_is_set(read_cols, field->field_index) &&
+           !(write_cols && bitmap_is_set(write_cols, field->field_index))))
+      {
+        unsafe= true;
+        break;
+      }
+      if (field->is_null(offset))
+      {
+        /* NULLs are never equal for a unique key */
+        has_null= true;
+        break;
+      }
+      field->move_field_offset(offset);
+      field->hash(&nr1, &nr2);
+      field->move_field_offset(-offset);
+    }
+
+    if (!unsafe && !has_null)
+      write_set.insert((ulonglong) nr1 ^ ((ulonglong) nr2 << 32));
+  }
+
+  if (unsafe || !has_unique_key ||
+      write_set.size() > opt_binlog_transaction_dependency_history_size)
+  {
+    flags.write_set_unsafe= true;
+    write_set.clear();
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Set the commit parent of the cache before it is written to the binary
+  log. This is called by the flush stage leader, in commit order.
+
+  @see Writeset_history::get_commit_parent
+ */
+void binlog_cache_data::assign_commit_parent()
+{
+  DBUG_ENTER("binlog_cache_data::assign_commit_parent");
+  bool const use_write_set=
+    opt_binlog_transaction_dependency_tracking ==
+      DEPENDENCY_TRACKING_WRITESET &&
+    flags.transactional && !flags.write_set_unsafe && !flags.incident;
+  cache_log.commit_seq_no=
+    mysql_bin_log.writeset_history.get_commit_parent(
+      cache_log.commit_seq_no, use_write_set ? &write_set : NULL,
+      opt_binlog_transaction_dependency_history_size);
+  DBUG_VOID_RETURN;
+}
+
+
 /**
   Checks if the given GTID exists in the Group_cache. If not, add it
   as an empty group.
@@ -1225,6 +1510,7 @@ binlog_cache_data::flush(THD *thd, my_off_t *bytes_written, bool *wrote_xid)
   {
     my_off_t bytes_in_cache= my_b_tell(&cache_log);
     DBUG_PRINT("debug", ("bytes_in_cache: %llu", bytes_in_cache));
+    assign_commit_parent();
     /*
       The cache is always reset since subsequent rollbacks of the
       transactions might trigger attempts to write to the binary log
@@ -1248,6 +1534,98 @@ binlog_cache_data::flush(THD *thd, my_off_t *bytes_written, bool *wrote_xid)
   DBUG_RETURN(error);
 }
 
+/**
+  Reserve a range of the binary log for the cache.
+
+  This is the part of flush() that the flush stage leader has to do in
+  commit order when @c binlog_parallel_flush is enabled: the GTID of the
+  group is generated and the cache is given the range of the binary log
+  starting at @c *end_pos that its events will occupy. The session owning
+  the cache copies the events into the range with copy_to_range(), and
+  the leader completes the flush with finish_range().
+
+  If flushing fails, the cache is reset as in flush().
+
+  @param thd           The session owning the cache
+  @param end_pos       End of the part of the binary log reserved so
+                       far. Moved to the end of the range of the cache.
+  @param bytes_written Set to the number of bytes in the cache
+
+  @see binlog_cache_data::flush
+ */
+int
+binlog_cache_data::reserve_range(THD *thd, my_off_t *end_pos,
+                                 my_off_t *bytes_written)
+{
+  DBUG_ENTER("binlog_cache_data::reserve_range");
+  int error= 0;
+  if (flags.finalized)
+  {
+    my_off_t bytes_in_cache= my_b_tell(&cache_log);
+    assign_commit_parent();
+    if (!(error= gtid_before_write_cache(thd, this)))
+      error= mysql_bin_log.reserve_cache_range(thd, this, end_pos);
+    if (error)
+      reset();
+    if (bytes_written)
+      *bytes_written= bytes_in_cache;
+  }
+  DBUG_RETURN(error);
+}
+
+/**
+  Copy the cache into the range of the binary log reserved for it.
+
+  This is called by the session owning the cache, concurrently with the
+  other sessions of the flush group. Errors are recorded in @c
+  range_errno and reported by finish_range().
+ */
+void binlog_cache_data::copy_to_range()
+{
+  DBUG_ENTER("binlog_cache_data::copy_to_range");
+  if (flags.range_reserved && !flags.range_written)
+  {
+    DBUG_EXECUTE_IF("binlog_range_copy_error",
+                    {
+                      range_errno= ENOSPC;
+                      DBUG_VOID_RETURN;
+                    });
+    if (mysql_bin_log.write_cache_range(this))
+      range_errno= errno ? errno : -1;
+  }
+  DBUG_VOID_RETURN;
+}
+
+/**
+  Finish the flush of a cache copied into its range of the binary log.
+
+  @param thd       The session owning the cache
+  @param wrote_xid Set to @c true if the cache contained an XID event
+  @param end_pos   Set to the end of the range of the cache, if it had
+                   one
+
+  @see binlog_cache_data::flush
+ */
+int
+binlog_cache_data::finish_range(THD *thd, bool *wrote_xid, my_off_t *end_pos)
+{
+  DBUG_ENTER("binlog_cache_data::finish_range");
+  int error= 0;
+  if (flags.finalized && flags.range_reserved)
+  {
+    /* A range written by the leader fails if the log is cut before it */
+    if (!flags.range_written || range_errno)
+      error= mysql_bin_log.finish_cache_range(thd, this);
+
+    if (flags.with_xid && error == 0)
+      *wrote_xid= true;
+    *end_pos= range_end;
+
+    reset();
+  }
+  DBUG_RETURN(error);
+}
+
 /**
   This function truncates the transactional cache upon committing or rolling
   back either a transaction or a statement.
@@ -1473,6 +1851,7 @@ Stage_manager::enroll_for(StageID stage, THD *thd, mysql_mutex_t *stage_mutex)
   */
   if (!leader)
   {
+    THD_STAGE_INFO(thd, stage_waiting_for_binlog_group_commit);
     mysql_mutex_lock(&m_lock_done);
 #ifndef DBUG_OFF
     /*
@@ -1485,7 +1864,23 @@ Stage_manager::enroll_for(StageID stage, THD *thd, mysql_mutex_t *stage_mutex)
       mysql_cond_signal(&m_cond_preempt);
 #endif
     while (thd->transaction.flags.pending)
+    {
+      /*
+        The flush stage leader may ask us to copy our caches into the
+        binary log, see signal_copy().
+      */
+      if (thd->transaction.flags.copy_pending)
+      {
+        mysql_mutex_unlock(&m_lock_done);
+        mysql_bin_log.copy_thread_caches(thd);
+        THD_STAGE_INFO(thd, stage_waiting_for_binlog_group_commit);
+        mysql_mutex_lock(&m_lock_done);
+        thd->transaction.flags.copy_pending= false;
+        mysql_cond_broadcast(&m_cond_done);
+        continue;
+      }
       mysql_cond_wait(&m_cond_done, &m_lock_done);
+    }
     mysql_mutex_unlock(&m_lock_done);
   }
   return leader;
@@ -5746,7 +6141,8 @@ inline void write_commit_seq_no(IO_CACHE* cache, uchar* buff)
   SYNOPSIS
     do_write_cache()
     cache    Cache to write to the binary log
-    lock_log True if the LOCK_log mutex should be aquired, false otherwise
+    to       Cache of the binary log to write to. The events are
+             positioned at its current write position.
 
   DESCRIPTION
     Write the contents of the cache to the binary log. The cache will
@@ -5757,9 +6153,9 @@ inline void write_commit_seq_no(IO_CACHE* cache, uchar* buff)
     events prior to fill in the binlog cache.
 */
 
-int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
+int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache, IO_CACHE *to)
 {
-  DBUG_ENTER("MYSQL_BIN_LOG::do_write_cache(IO_CACHE *)");
+  DBUG_ENTER("MYSQL_BIN_LOG::do_write_cache(IO_CACHE *, IO_CACHE *)");
 
   DBUG_EXECUTE_IF("simulate_do_write_cache_failure",
                   {
@@ -5802,7 +6198,7 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
     split.
   */
 
-  group= (uint)my_b_tell(&log_file);
+  group= (uint)my_b_tell(to);
   DBUG_PRINT("debug", ("length: %llu, group: %llu",
                        (ulonglong) length, (ulonglong) group));
   hdr_offs= carry= 0;
@@ -5840,7 +6236,7 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
       }
 
       /* write the first half of the split header */
-      if (my_b_write(&log_file, header, carry))
+      if (my_b_write(to, header, carry))
         DBUG_RETURN(ER_ERROR_ON_WRITE);
 
       /*
@@ -5883,12 +6279,12 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
 
         crc= my_checksum(crc, cache->read_pos, length); 
         remains -= length;
-        if (my_b_write(&log_file, cache->read_pos, length))
+        if (my_b_write(to, cache->read_pos, length))
           DBUG_RETURN(ER_ERROR_ON_WRITE);
         if (remains == 0)
         {
           int4store(buf, crc);
-          if (my_b_write(&log_file, buf, BINLOG_CHECKSUM_LEN))
+          if (my_b_write(to, buf, BINLOG_CHECKSUM_LEN))
             DBUG_RETURN(ER_ERROR_ON_WRITE);
           crc= crc_0;
         }
@@ -5914,8 +6310,8 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
             int4store(buf, crc);
             remains -= hdr_offs;
             DBUG_ASSERT(remains == 0);
-            if (my_b_write(&log_file, cache->read_pos, hdr_offs) ||
-                my_b_write(&log_file, buf, BINLOG_CHECKSUM_LEN))
+            if (my_b_write(to, cache->read_pos, hdr_offs) ||
+                my_b_write(to, buf, BINLOG_CHECKSUM_LEN))
               DBUG_RETURN(ER_ERROR_ON_WRITE);
             crc= crc_0;
           }
@@ -5965,13 +6361,13 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
             int4store(ev + EVENT_LEN_OFFSET, event_len + BINLOG_CHECKSUM_LEN);
             remains= fix_log_event_crc(cache->read_pos, hdr_offs, event_len,
                                        length, &crc);
-            if (my_b_write(&log_file, ev, 
+            if (my_b_write(to, ev, 
                            remains == 0 ? event_len : length - hdr_offs))
               DBUG_RETURN(ER_ERROR_ON_WRITE);
             if (remains == 0)
             {
               int4store(buf, crc);
-              if (my_b_write(&log_file, buf, BINLOG_CHECKSUM_LEN))
+              if (my_b_write(to, buf, BINLOG_CHECKSUM_LEN))
                 DBUG_RETURN(ER_ERROR_ON_WRITE);
               crc= crc_0; // crc is complete
             }
@@ -5997,7 +6393,7 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
 
     /* Write the entire buf to the binary log file */
     if (!do_checksum)
-      if (my_b_write(&log_file, cache->read_pos, length))
+      if (my_b_write(to, cache->read_pos, length))
         DBUG_RETURN(ER_ERROR_ON_WRITE);
     cache->read_pos=cache->read_end;		// Mark buffer used up
   } while ((length= my_b_fill(cache)));
@@ -6131,7 +6527,7 @@ bool MYSQL_BIN_LOG::write_cache(THD *thd, binlog_cache_data *cache_data)
     {
       DBUG_EXECUTE_IF("crash_before_writing_xid",
                       {
-                        if ((write_error= do_write_cache(cache)))
+                        if ((write_error= do_write_cache(cache, &log_file)))
                           DBUG_PRINT("info", ("error writing binlog cache: %d",
                                                write_error));
                         flush_and_sync(true);
@@ -6139,7 +6535,7 @@ bool MYSQL_BIN_LOG::write_cache(THD *thd, binlog_cache_data *cache_data)
                         DBUG_SUICIDE();
                       });
 
-      if ((write_error= do_write_cache(cache)))
+      if ((write_error= do_write_cache(cache, &log_file)))
         goto err;
 
       if (incident && write_incident(thd, false/*need_lock_log=false*/,
@@ -6183,6 +6579,281 @@ err:
 }
 
 
+/**
+  Compute the number of bytes do_write_cache() writes for a cache.
+
+  Without checksums, this is the size of the cache. With checksums,
+  each event grows by BINLOG_CHECKSUM_LEN, so the event headers are
+  read to count the events.
+
+  The cache is left as a READ_CACHE positioned at its end.
+
+  @param cache        The cache, as a WRITE_CACHE
+  @param do_checksum  @c true if the events are written with checksums
+  @param[out] size    Number of bytes that will be written
+
+  @retval false Success
+  @retval true  The cache could not be read
+*/
+static bool binlog_cache_write_size(IO_CACHE *cache, bool do_checksum,
+                                    my_off_t *size)
+{
+  DBUG_ENTER("binlog_cache_write_size");
+  my_off_t length= my_b_tell(cache);
+  *size= length;
+  if (!do_checksum || length == 0)
+    DBUG_RETURN(false);
+
+  if (reinit_io_cache(cache, READ_CACHE, 0, 0, 0))
+    DBUG_RETURN(true);
+  uchar header[LOG_EVENT_HEADER_LEN];
+  my_off_t pos= 0;
+  while (pos < length)
+  {
+    my_b_seek(cache, pos);
+    if (my_b_read(cache, header, LOG_EVENT_HEADER_LEN))
+      DBUG_RETURN(true);
+    ulong event_len= uint4korr(header + EVENT_LEN_OFFSET);
+    if (event_len < LOG_EVENT_HEADER_LEN)
+      DBUG_RETURN(true);
+    pos+= event_len;
+    *size+= BINLOG_CHECKSUM_LEN;
+  }
+  DBUG_RETURN(pos != length);
+}
+
+/**
+  Write function of the IO_CACHE used to copy a session cache into its
+  range of the binary log.
+
+  The sessions of a flush group write into the binary log file at the
+  same time, so the buffer is written with pwrite() at the position of
+  the cache instead of moving the file offset shared with @c log_file.
+  Calling it with no data writes out the buffer.
+*/
+static int binlog_range_write(IO_CACHE *info, const uchar *buffer,
+                              size_t count)
+{
+  size_t length= (size_t) (info->write_pos - info->write_buffer);
+  if (length)
+  {
+    if (mysql_file_pwrite(info->file, info->write_buffer, length,
+                          info->pos_in_file, MYF(MY_WME | MY_NABP)))
+      return info->error= -1;
+    info->pos_in_file+= length;
+    info->write_pos= info->write_buffer;
+  }
+  if (count >= info->buffer_length)
+  {
+    if (mysql_file_pwrite(info->file, buffer, count, info->pos_in_file,
+                          MYF(MY_WME | MY_NABP)))
+      return info->error= -1;
+    info->pos_in_file+= count;
+  }
+  else if (count > 0)
+  {
+    memcpy(info->write_pos, buffer, count);
+    info->write_pos+= count;
+  }
+  return 0;
+}
+
+/**
+  Move the write position of the binary log forward.
+
+  The bytes skipped belong to ranges reserved for sessions, which write
+  them directly into the file. Anything buffered in the cache is written
+  first, since it is located before the skipped bytes.
+
+  @param log_file The cache of the binary log
+  @param pos      The new write position
+
+  @retval false Success
+  @retval true  Writing the buffer failed
+*/
+static bool binlog_skip_to(IO_CACHE *log_file, my_off_t pos)
+{
+  DBUG_ASSERT(log_file->type == WRITE_CACHE);
+  DBUG_ASSERT(pos >= my_b_tell(log_file));
+  if (pos == my_b_tell(log_file))
+    return false;
+  if (flush_io_cache(log_file))
+    return true;
+  log_file->pos_in_file= pos;
+  log_file->seek_not_done= 1;
+  log_file->write_end= (log_file->write_buffer + log_file->buffer_length -
+                        (pos & (IO_SIZE - 1)));
+  return false;
+}
+
+/**
+  Cut the binary log at a position before the end of the ranges
+  reserved for sessions, and move the write position there.
+
+  @param log_file The cache of the binary log
+  @param pos      The new end of the binary log
+
+  @retval false Success
+  @retval true  Writing the buffer or truncating the file failed
+*/
+static bool binlog_truncate_to(IO_CACHE *log_file, my_off_t pos)
+{
+  DBUG_ASSERT(log_file->type == WRITE_CACHE);
+  if (flush_io_cache(log_file) ||
+      my_chsize(log_file->file, pos, 0, MYF(MY_WME)))
+    return true;
+  log_file->pos_in_file= pos;
+  log_file->seek_not_done= 1;
+  log_file->write_end= (log_file->write_buffer + log_file->buffer_length -
+                        (pos & (IO_SIZE - 1)));
+  return false;
+}
+
+/**
+  Reserve a range of the binary log for a cache.
+
+  The range starts at @c *end_pos and is large enough for the events of
+  the cache, as written by do_write_cache(). A cache with an incident is
+  not copied in parallel: it is written here, followed by the incident
+  event, just like write_cache() does it.
+
+  @param thd        The session owning the cache
+  @param cache_data The cache
+  @param end_pos    End of the part of the binary log reserved so far.
+                    Moved to the end of the range of the cache.
+
+  @return Zero on success, non-zero on error
+*/
+int MYSQL_BIN_LOG::reserve_cache_range(THD *thd,
+                                       binlog_cache_data *cache_data,
+                                       my_off_t *end_pos)
+{
+  DBUG_ENTER("MYSQL_BIN_LOG::reserve_cache_range");
+  mysql_mutex_assert_owner(&LOCK_log);
+  DBUG_ASSERT(is_open());
+  my_off_t start= *end_pos;
+
+  if (cache_data->has_incident())
+  {
+    if (binlog_skip_to(&log_file, start))
+    {
+      thd->commit_error= THD::CE_FLUSH_ERROR;
+      DBUG_RETURN(ER_ERROR_ON_WRITE);
+    }
+    if (write_cache(thd, cache_data))
+      DBUG_RETURN(1);
+    *end_pos= my_b_tell(&log_file);
+    cache_data->set_range(start, *end_pos, true);
+    DBUG_RETURN(0);
+  }
+
+  my_off_t size;
+  if (binlog_cache_write_size(&cache_data->cache_log,
+                              binlog_checksum_options !=
+                              BINLOG_CHECKSUM_ALG_OFF,
+                              &size))
+  {
+    char errbuf[MYSYS_STRERROR_SIZE];
+    sql_print_error(ER(ER_ERROR_ON_READ), cache_data->cache_log.file_name,
+                    errno, my_strerror(errbuf, sizeof(errbuf), errno));
+    write_error= 1;
+    thd->commit_error= THD::CE_FLUSH_ERROR;
+    DBUG_RETURN(1);
+  }
+  *end_pos= start + size;
+  cache_data->set_range(start, *end_pos, false);
+  DBUG_PRINT("debug", ("range: [%llu, %llu)", start, *end_pos));
+  DBUG_RETURN(0);
+}
+
+/**
+  Copy a cache into its range of the binary log.
+
+  This is called by the session owning the cache, without holding
+  LOCK_log, while the flush stage leader waits for the copies to
+  finish.
+
+  @param cache_data The cache, with a range reserved by
+                    reserve_cache_range()
+
+  @return Zero on success, non-zero on error
+*/
+int MYSQL_BIN_LOG::write_cache_range(binlog_cache_data *cache_data)
+{
+  DBUG_ENTER("MYSQL_BIN_LOG::write_cache_range");
+  IO_CACHE *cache= &cache_data->cache_log;
+  IO_CACHE range;
+  int error= 0;
+
+  if (cache_data->range_end == cache_data->range_start)
+    DBUG_RETURN(0);
+
+  if (init_io_cache(&range, log_file.file, IO_SIZE * 16, WRITE_CACHE,
+                    cache_data->range_start, 0, MYF(MY_WME | MY_NABP)))
+    DBUG_RETURN(ER_ERROR_ON_WRITE);
+  range.write_function= binlog_range_write;
+  range.write_end= range.write_buffer + range.buffer_length;
+
+  if (!(error= do_write_cache(cache, &range)) &&
+      binlog_range_write(&range, NULL, 0))
+    error= ER_ERROR_ON_WRITE;
+  if (!error && cache->error)
+    error= ER_ERROR_ON_READ;
+  DBUG_ASSERT(error || range.pos_in_file == cache_data->range_end);
+
+  /* Nothing must be written by end_io_cache(), see binlog_range_write() */
+  range.write_pos= range.write_buffer;
+  end_io_cache(&range);
+  DBUG_RETURN(error);
+}
+
+/**
+  Finish the flush of a cache copied into its range of the binary log.
+
+  This does what write_cache() does after writing the cache, and is
+  called by the flush stage leader in commit order.
+
+  @param thd        The session owning the cache
+  @param cache_data The cache
+
+  @return Zero on success, non-zero on error
+*/
+int MYSQL_BIN_LOG::finish_cache_range(THD *thd,
+                                      binlog_cache_data *cache_data)
+{
+  DBUG_ENTER("MYSQL_BIN_LOG::finish_cache_range");
+  mysql_mutex_assert_owner(&LOCK_log);
+
+  if (cache_data->range_errno)
+  {
+    char errbuf[MYSYS_STRERROR_SIZE];
+    if (!write_error)
+    {
+      write_error= 1;
+      sql_print_error(ER(ER_ERROR_ON_WRITE), name, cache_data->range_errno,
+                      my_strerror(errbuf, sizeof(errbuf),
+                                  cache_data->range_errno));
+    }
+    thd->commit_error= THD::CE_FLUSH_ERROR;
+    DBUG_RETURN(1);
+  }
+
+  if (cache_data->range_end > cache_data->range_start)
+  {
+    global_sid_lock->rdlock();
+    if (gtid_state->update_on_flush(thd) != RETURN_STATUS_OK)
+    {
+      global_sid_lock->unlock();
+      thd->commit_error= THD::CE_FLUSH_ERROR;
+      DBUG_RETURN(1);
+    }
+    global_sid_lock->unlock();
+  }
+  thd->set_next_event_pos(log_file_name, cache_data->range_end);
+  DBUG_RETURN(0);
+}
+
+
 /**
   Wait until we get a signal that the relay log has been updated.
 
@@ -6757,6 +7428,68 @@ MYSQL_BIN_LOG::flush_thread_caches(THD *thd)
 }
 
 
+/**
+  Reserve ranges of the binary log for the caches of a session.
+
+  This is used instead of flush_thread_caches() when @c
+  binlog_parallel_flush is enabled. The caches are copied into the
+  ranges by copy_thread_caches() and the flush is completed by
+  finish_thread_caches().
+
+  @param thd     The session
+  @param end_pos End of the part of the binary log reserved so far.
+                 Moved past the ranges of the caches.
+
+  @return Error code and the number of bytes in the caches of the
+  session, as for flush_thread_caches().
+ */
+std::pair<int,my_off_t>
+MYSQL_BIN_LOG::reserve_thread_caches(THD *thd, my_off_t *end_pos)
+{
+  binlog_cache_mngr *cache_mngr= thd_get_cache_mngr(thd);
+  my_off_t bytes= 0;
+  int error= cache_mngr->reserve_ranges(thd, end_pos, &bytes);
+  DBUG_PRINT("debug", ("bytes: %llu, end_pos: %llu", bytes, *end_pos));
+  return std::make_pair(error, bytes);
+}
+
+
+/**
+  Copy the caches of a session into their ranges of the binary log.
+
+  Called by each session of the flush group from its own thread, see
+  Stage_manager::signal_copy().
+ */
+void MYSQL_BIN_LOG::copy_thread_caches(THD *thd)
+{
+  THD_STAGE_INFO(thd, stage_binlog_write_cache);
+  thd_get_cache_mngr(thd)->copy_to_ranges();
+}
+
+
+/**
+  Complete the flush of the caches of a session after they have been
+  copied into the binary log.
+
+  @see flush_thread_caches
+ */
+int
+MYSQL_BIN_LOG::finish_thread_caches(THD *thd)
+{
+  binlog_cache_mngr *cache_mngr= thd_get_cache_mngr(thd);
+  bool wrote_xid= false;
+  my_off_t end_pos= 0;
+  int error= cache_mngr->finish_ranges(thd, &wrote_xid, &end_pos);
+  if (!error && end_pos > 0)
+  {
+    thd->set_trans_pos(log_file_name, end_pos);
+    if (wrote_xid)
+      inc_prep_xids(thd);
+  }
+  return error;
+}
+
+
 /**
   Execute the flush stage.
 
@@ -6784,6 +7517,13 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
   int flush_error= 1;
   mysql_mutex_assert_owner(&LOCK_log);
 
+  /*
+    With parallel flush, the caches are only given a range of the binary
+    log here, in commit order. The sessions copy them in parallel below.
+  */
+  const bool parallel_flush= opt_binlog_parallel_flush;
+  my_off_t end_pos= my_b_tell(&log_file);
+
   my_atomic_rwlock_rdlock(&opt_binlog_max_flush_queue_time_lock);
   const ulonglong max_udelay= my_atomic_load32(&opt_binlog_max_flush_queue_time);
   my_atomic_rwlock_rdunlock(&opt_binlog_max_flush_queue_time_lock);
@@ -6801,7 +7541,9 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
   while ((max_udelay == 0 || my_micro_time() < start_utime + max_udelay) && has_more)
   {
     std::pair<bool,THD*> current= stage_manager.pop_front(Stage_manager::FLUSH_STAGE);
-    std::pair<int,my_off_t> result= flush_thread_caches(current.second);
+    std::pair<int,my_off_t> result= parallel_flush ?
+      reserve_thread_caches(current.second, &end_pos) :
+      flush_thread_caches(current.second);
     has_more= current.first;
     total_bytes+= result.second;
     if (flush_error == 1)
@@ -6823,7 +7565,9 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
     THD *queue= stage_manager.fetch_queue_for(Stage_manager::FLUSH_STAGE);
     for (THD *head= queue ; head ; head = head->next_to_commit)
     {
-      std::pair<int,my_off_t> result= flush_thread_caches(head);
+      std::pair<int,my_off_t> result= parallel_flush ?
+        reserve_thread_caches(head, &end_pos) :
+        flush_thread_caches(head);
       total_bytes+= result.second;
       if (flush_error == 1)
         flush_error= result.first;
@@ -6835,6 +7579,57 @@ MYSQL_BIN_LOG::process_flush_stage_queue(my_off_t *total_bytes_var,
       first_seen= queue;
   }
 
+  if (parallel_flush)
+  {
+    /*
+      The leader was the first to enter the queue. It copies its own
+      caches while the followers copy theirs, then finishes the flush of
+      every session in commit order.
+    */
+    THD *leader= first_seen;
+    DBUG_ASSERT(leader == current_thd);
+    stage_manager.signal_copy(first_seen);
+    copy_thread_caches(leader);
+    stage_manager.copy_done(leader);
+    stage_manager.wait_for_copies(first_seen);
+    THD_STAGE_INFO(leader, stage_binlog_flush);
+
+    /*
+      If a copy failed, the binary log is cut at the start of its range,
+      so that no unwritten bytes are left in it, and the flush fails for
+      every session whose events were to follow.
+    */
+    my_off_t failed_pos= end_pos;
+    int failed_errno= 0;
+    for (THD *head= first_seen ; head ; head = head->next_to_commit)
+      thd_get_cache_mngr(head)->find_failed_ranges(&failed_pos,
+                                                   &failed_errno);
+    if (failed_errno)
+    {
+      for (THD *head= first_seen ; head ; head = head->next_to_commit)
+        thd_get_cache_mngr(head)->cancel_ranges(failed_pos, failed_errno);
+      if (!binlog_truncate_to(&log_file, failed_pos))
+        end_pos= failed_pos;
+      else
+      {
+        char errbuf[MYSYS_STRERROR_SIZE];
+        sql_print_error("Could not truncate the binary log '%s' to %llu"
+                        " after a failed write (errno: %d - %s).",
+                        log_file_name, (ulonglong) failed_pos, my_errno,
+                        my_strerror(errbuf, sizeof(errbuf), my_errno));
+      }
+    }
+
+    for (THD *head= first_seen ; head ; head = head->next_to_commit)
+    {
+      int error= finish_thread_caches(head);
+      if (flush_error == 0)
+        flush_error= error;
+    }
+    if (binlog_skip_to(&log_file, end_pos) && flush_error == 0)
+      flush_error= ER_ERROR_ON_WRITE;
+  }
+
   *out_queue_var= first_seen;
   *total_bytes_var= total_bytes;
   if (total_bytes > 0 && my_b_tell(&log_file) >= (my_off_t) max_size)
@@ -7210,6 +8005,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit)
   thd->transaction.flags.xid_written= false;
   thd->transaction.flags.commit_low= !skip_commit;
   thd->transaction.flags.run_hooks= !skip_commit;
+  thd->transaction.flags.copy_pending= false;
 #ifndef DBUG_OFF
   /*
      The group commit Leader may have to wait for follower whose transaction
@@ -7241,6 +8037,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit)
     DBUG_RETURN(finish_commit(thd));
   }
 
+  THD_STAGE_INFO(thd, stage_binlog_flush);
   THD *wait_queue= NULL;
   flush_error= process_flush_stage_queue(&total_bytes, &do_rotate, &wait_queue);
 
@@ -7278,6 +8075,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit)
                           thd->thread_id, thd->commit_error));
     DBUG_RETURN(finish_commit(thd));
   }
+  THD_STAGE_INFO(thd, stage_binlog_sync);
   THD *final_queue= stage_manager.fetch_queue_for(Stage_manager::SYNC_STAGE);
   if (flush_error == 0 && total_bytes > 0)
   {
@@ -7307,6 +8105,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit)
                             thd->thread_id, thd->commit_error));
       DBUG_RETURN(finish_commit(thd));
     }
+    THD_STAGE_INFO(thd, stage_binlog_commit);
     THD *commit_queue= stage_manager.fetch_queue_for(Stage_manager::COMMIT_STAGE);
     DBUG_EXECUTE_IF("semi_sync_3-way_deadlock",
                     DEBUG_SYNC(thd, "before_process_commit_stage_queue"););
@@ -8731,6 +9530,10 @@ int THD::binlog_write_row(TABLE* table, bool is_trans,
   if (unlikely(ev == 0))
     return HA_ERR_OUT_OF_MEM;
 
+  binlog_cache_data *const cache_data=
+    thd_get_cache_mngr(this)->get_binlog_cache_data(is_trans);
+  cache_data->add_write_set(table, record, NULL, NULL);
+
   return ev->add_row_data(row_data, len);
 }
 
@@ -8794,6 +9597,11 @@ int THD::binlog_update_row(TABLE* table, bool is_trans,
   error= ev->add_row_data(before_row, before_size) ||
          ev->add_row_data(after_row, after_size);
 
+  binlog_cache_data *const cache_data=
+    thd_get_cache_mngr(this)->get_binlog_cache_data(is_trans);
+  cache_data->add_write_set(table, before_record, old_read_set, NULL);
+  cache_data->add_write_set(table, after_record, old_read_set, old_write_set);
+
   /* restore read/write set for the rest of execution */
   table->column_bitmaps_set_no_signal(old_read_set,
                                       old_write_set);
@@ -8845,6 +9653,10 @@ int THD::binlog_delete_row(TABLE* table, bool is_trans,
 
   error= ev->add_row_data(row_data, len);
 
+  binlog_cache_data *const cache_data=
+    thd_get_cache_mngr(this)->get_binlog_cache_data(is_trans);
+  cache_data->add_write_set(table, record, old_read_set, NULL);
+
   /* restore read/write set for the rest of execution */
   table->column_bitmaps_set_no_signal(old_read_set,
                                       old_write_set);
@@ -9208,6 +10020,82 @@ Logical_clock::~Logical_clock()
   my_atomic_rwlock_destroy(&m_state_lock);
 }
 
+Writeset_history::Writeset_history()
+  : m_group_parent(SEQ_UNINIT), m_last_parent(SEQ_UNINIT),
+    m_write_set_complete(false), m_write_set_joined(false)
+{
+}
+
+/**
+  Compute the commit parent to write into the binary log for a
+  transaction.
+
+  The transaction joins the group of transactions written before it, and
+  gets the same commit parent, if it prepared in the same commit group as
+  the first transaction of the group, as without write sets, or if its
+  write set is known and does not intersect the write sets of the group.
+  A transaction that joined because of its write set may not have
+  prepared in the same commit group as the others, so once one has joined
+  only the write sets are trusted. Otherwise the transaction starts a new
+  group, and gets a commit parent different from the one of the previous
+  group so that the slave does not apply the two groups in parallel.
+
+  @param commit_parent The commit parent the transaction got in prepare
+  @param write_set     The write set of the transaction, or NULL if it is
+                       not known
+  @param history_size  Maximum number of hashes in the write set of a
+                       group
+
+  @return The commit parent to write into the binary log.
+ */
+int64
+Writeset_history::get_commit_parent(int64 commit_parent,
+                                    const std::set<ulonglong> *write_set,
+                                    ulong history_size)
+{
+  DBUG_ENTER("Writeset_history::get_commit_parent");
+  bool join= false;
+
+  if (m_last_parent != SEQ_UNINIT)
+  {
+    if (commit_parent == m_group_parent && !m_write_set_joined)
+      join= true;
+    else if (write_set != NULL && m_write_set_complete &&
+             m_write_set.size() + write_set->size() <= history_size)
+    {
+      join= true;
+      for (std::set<ulonglong>::const_iterator it= write_set->begin();
+           join && it != write_set->end(); ++it)
+        join= m_write_set.find(*it) == m_write_set.end();
+      if (join && commit_parent != m_group_parent)
+        m_write_set_joined= true;
+    }
+  }
+
+  if (!join)
+  {
+    m_last_parent= (commit_parent != m_last_parent) ?
+                   commit_parent : m_last_parent + 1;
+    m_group_parent= commit_parent;
+    m_write_set.clear();
+    m_write_set_complete= true;
+    m_write_set_joined= false;
+  }
+
+  if (write_set != NULL && m_write_set_complete &&
+      m_write_set.size() + write_set->size() <= history_size)
+    m_write_set.insert(write_set->begin(), write_set->end());
+  else
+  {
+    m_write_set_complete= false;
+    m_write_set.clear();
+  }
+
+  DBUG_PRINT("info", ("commit_parent: %lld written: %lld join: %d",
+                      commit_parent, m_last_parent, join));
+  DBUG_RETURN(m_last_parent);
+}
+
 /**
   Log the current query.
 
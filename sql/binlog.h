@@ -19,6 +19,7 @@
 #include "mysqld.h"                             /* opt_relay_logname */
 #include "log_event.h"
 #include "log.h"
+#include <set>
 
 class Relay_log_info;
 class Master_info;
@@ -42,6 +43,52 @@ public:
   ~Logical_clock();
 };
 
+/**
+  How the commit parent written into the binary log for a transaction
+  is computed, see @c binlog_transaction_dependency_tracking.
+ */
+enum enum_binlog_transaction_dependency_tracking
+{
+  /* Transactions that prepared in the same commit group */
+  DEPENDENCY_TRACKING_COMMIT_ORDER= 0,
+  /* Also transactions whose write sets do not intersect */
+  DEPENDENCY_TRACKING_WRITESET= 1
+};
+
+/**
+  Write set history of the flush stage.
+
+  The slave applies consecutive transactions with the same commit parent
+  in parallel. This class gives a transaction the commit parent of the
+  transaction written before it not only when both prepared in the same
+  commit group, but also when the write set of the transaction, i.e. the
+  hashes of the primary and unique keys of the rows it changed, does not
+  intersect the write sets of the transactions that already share that
+  commit parent.
+
+  Only the flush stage leader uses the history, so it needs no lock.
+ */
+class Writeset_history
+{
+public:
+  Writeset_history();
+  int64 get_commit_parent(int64 commit_parent,
+                          const std::set<ulonglong> *write_set,
+                          ulong history_size);
+
+private:
+  /* The union of the write sets of the current group */
+  std::set<ulonglong> m_write_set;
+  /* Commit parent of the first transaction of the current group */
+  int64 m_group_parent;
+  /* Commit parent written for the current group */
+  int64 m_last_parent;
+  /* If every transaction of the group added its write set */
+  bool m_write_set_complete;
+  /* If a transaction joined the group because of its write set */
+  bool m_write_set_joined;
+};
+
 /**
   Class for maintaining the commit stages for binary log group commit.
  */
@@ -224,6 +271,42 @@ public:
     mysql_cond_broadcast(&m_cond_done);
   }
 
+  /**
+    Ask the sessions of a flush queue to copy their caches into the
+    binary log.
+
+    Followers do the copy themselves while waiting in enroll_for().
+    The leader is not waiting there, so it has to copy its own caches
+    and then call copy_done() before wait_for_copies().
+
+    @param queue Queue of sessions whose caches have been assigned a
+                 range of the binary log.
+   */
+  void signal_copy(THD *queue) {
+    mysql_mutex_lock(&m_lock_done);
+    for (THD *thd= queue ; thd ; thd = thd->next_to_commit)
+      thd->transaction.flags.copy_pending= true;
+    mysql_mutex_unlock(&m_lock_done);
+    mysql_cond_broadcast(&m_cond_done);
+  }
+
+  void copy_done(THD *thd) {
+    mysql_mutex_lock(&m_lock_done);
+    thd->transaction.flags.copy_pending= false;
+    mysql_mutex_unlock(&m_lock_done);
+  }
+
+  /**
+    Wait until all sessions in the queue have copied their caches.
+   */
+  void wait_for_copies(THD *queue) {
+    mysql_mutex_lock(&m_lock_done);
+    for (THD *thd= queue ; thd ; thd = thd->next_to_commit)
+      while (thd->transaction.flags.copy_pending)
+        mysql_cond_wait(&m_cond_done, &m_lock_done);
+    mysql_mutex_unlock(&m_lock_done);
+  }
+
 private:
   /**
      Queues for sessions.
@@ -559,6 +642,8 @@ public:
 public:
   /* Clock to timestamp the commits */
    Logical_clock commit_clock;
+  /* Write sets of the last commit group written to the binary log */
+  Writeset_history writeset_history;
 
   /**
     Find the oldest binary log that contains any GTID that
@@ -604,6 +689,8 @@ private:
                     THD* queue, mysql_mutex_t *leave,
                     mysql_mutex_t *enter);
   std::pair<int,my_off_t> flush_thread_caches(THD *thd);
+  std::pair<int,my_off_t> reserve_thread_caches(THD *thd, my_off_t *end_pos);
+  int finish_thread_caches(THD *thd);
   int flush_cache_to_file(my_off_t *flush_end_pos);
   int finish_commit(THD *thd);
   std::pair<bool, bool> sync_binlog_file(bool force);
@@ -708,7 +795,12 @@ public:
 
   bool write_event(Log_event* event_info);
   bool write_cache(THD *thd, class binlog_cache_data *binlog_cache_data);
-  int  do_write_cache(IO_CACHE *cache);
+  int  do_write_cache(IO_CACHE *cache, IO_CACHE *to);
+  int  reserve_cache_range(THD *thd, class binlog_cache_data *cache_data,
+                           my_off_t *end_pos);
+  int  write_cache_range(class binlog_cache_data *cache_data);
+  int  finish_cache_range(THD *thd, class binlog_cache_data *cache_data);
+  void copy_thread_caches(THD *thd);
 
   void set_write_error(THD *thd, bool is_transactional);
   bool check_write_error(THD *thd);
@@ -846,6 +938,9 @@ int query_error_code(THD *thd, bool not_killed);
 extern const char *log_bin_index;
 extern const char *log_bin_basename;
 extern bool opt_binlog_order_commits;
+extern bool opt_binlog_parallel_flush;
+extern ulong opt_binlog_transaction_dependency_tracking;
+extern ulong opt_binlog_transaction_dependency_history_size;
 
 /**
   Turns a relative log binary log path into a full path, based on the
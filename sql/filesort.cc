@@ -35,8 +35,10 @@
 #include "debug_sync.h"
 #include "opt_trace.h"
 #include "sql_optimizer.h"              // JOIN
+#include "mysqld.h"                     // key_thread_parallel_sort
 
 #include <algorithm>
+#include <new>
 #include <utility>
 using std::max;
 using std::min;
@@ -60,6 +62,12 @@ static int merge_index(Sort_param *param,uchar *sort_buffer,
                        IO_CACHE *outfile);
 static bool save_index(Sort_param *param, uint count,
                        Filesort_info *table_sort);
+static void sort_buffer_keys(Sort_param *param, Filesort_info *fs_info,
+                             uint count);
+static int do_merge_buffers(Sort_param *param, IO_CACHE *from_file,
+                            IO_CACHE *to_file, uchar *sort_buffer,
+                            BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                            int flag, volatile THD::killed_state *killed);
 static uint suffix_length(ulong string_length);
 static SORT_ADDON_FIELD *get_addon_fields(ulong max_length_for_sort_data,
                                           Field **ptabfield,
@@ -132,6 +140,27 @@ static void trace_filesort_information(Opt_trace_context *trace,
 }
 
 
+static void trace_parallel_sort(Opt_trace_context *trace,
+                                const Sort_param *param)
+{
+  if (!trace->is_started())
+    return;
+
+  Opt_trace_object trace_parallel(trace, "filesort_parallel_execution");
+  trace_parallel.add("parallel_degree", param->parallel_degree);
+  Opt_trace_array trace_workers(trace, "workers");
+  for (uint i= 0; i < param->parallel_degree; i++)
+  {
+    const Sort_worker_stats *stats= &param->worker_stats[i];
+    Opt_trace_object(trace)
+      .add("worker", i)
+      .add("sorted_chunks", stats->sorted_chunks)
+      .add("sorted_keys", stats->sorted_keys)
+      .add("merged_runs", stats->merged_runs);
+  }
+}
+
+
 /**
   Sort a table.
   Creates a set of pointers that can be used to read the rows
@@ -185,6 +214,7 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
   SQL_SELECT *const select= filesort->select;
   ha_rows max_rows= filesort->limit;
   uint s_length= 0;
+  Sort_worker_stats worker_stats[MAX_SORT_PARALLEL_DEGREE];
 
   DBUG_ENTER("filesort");
 
@@ -231,6 +261,12 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
                           table,
                           thd->variables.max_length_for_sort_data,
                           max_rows, sort_positions);
+  param.parallel_degree= thd->variables.sort_parallel_degree;
+  if (param.parallel_degree > 1)
+  {
+    memset(worker_stats, 0, sizeof(worker_stats));
+    param.worker_stats= worker_stats;
+  }
 
   table_sort.addon_buf= 0;
   table_sort.addon_length= param.addon_length;
@@ -401,6 +437,9 @@ ha_rows filesort(THD *thd, TABLE *table, Filesort *filesort,
       goto err;
   }
 
+  if (param.parallel_degree > 1)
+    trace_parallel_sort(trace, &param);
+
   if (num_rows > param.max_rows)
   {
     // If find_all_keys() produced more results than the query LIMIT.
@@ -854,6 +893,356 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
 } /* find_all_keys */
 
 
+/*
+  Parallel filesort.
+
+  With sort_parallel_degree > 1, the two CPU bound phases of filesort()
+  are shared out between up to that many threads, one of which is the
+  session thread itself:
+  - Sorting a sort buffer. The buffer is split into chunks which are
+    sorted concurrently and then merged pairwise, see sort_buffer_keys().
+  - The passes of merge_many_buff(). The groups of MERGEBUFF runs of a
+    pass are independent of each other, and are merged concurrently into
+    disjoint ranges of the output file, see merge_pass_parallel().
+  The final merge into the result file, merge_index(), stays serial.
+  The other threads are sort worker threads, which stay between phases
+  and filesorts, see run_sort_jobs().
+*/
+
+/**
+  Smallest number of keys in a chunk sorted by a thread of its own.
+  Below this, handing the chunk to another thread costs more than it
+  saves.
+*/
+static const uint MIN_KEYS_PER_SORT_CHUNK= 8192;
+
+/**
+  The work of one thread in a phase of a parallel filesort.
+*/
+class Sort_job
+{
+public:
+  Sort_job() : stats(NULL), done(false), error(false),
+    next(NULL), pending(NULL) {}
+  virtual ~Sort_job() {}
+
+  /** Do the work, then set done, and error if it failed. */
+  virtual void run()= 0;
+
+  Sort_worker_stats *stats;
+  bool done;
+  bool error;
+  /* Below: used by run_sort_jobs() while the job is queued. */
+  Sort_job *next;               // Next job in sort_job_queue
+  uint *pending;                // Jobs of the phase not done yet
+};
+
+
+/*
+  The sort worker threads, shared by all parallel filesorts.
+
+  A thread is created when a phase has more jobs than there are idle
+  workers, up to MAX_SORT_PARALLEL_DEGREE - 1 threads. It then stays,
+  waiting for more jobs, until sort_workers_end() is called at shutdown.
+  So a filesort does not create threads for each phase or merge pass,
+  and neither do the following ones.
+*/
+
+static mysql_mutex_t LOCK_sort_workers;
+static mysql_cond_t COND_sort_job;            // Signalled to workers
+static mysql_cond_t COND_sort_job_done;       // Signalled to sessions
+static Sort_job *sort_job_queue= NULL, *sort_job_queue_last= NULL;
+static uint sort_worker_count= 0;             // Worker threads
+static uint sort_worker_idle= 0;              // Workers waiting for a job
+static bool sort_workers_stop= false;
+static bool sort_workers_inited= false;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_LOCK_sort_workers;
+static PSI_cond_key key_COND_sort_job, key_COND_sort_job_done;
+
+static PSI_mutex_info all_sort_workers_mutexes[]=
+{
+  { &key_LOCK_sort_workers, "LOCK_sort_workers", PSI_FLAG_GLOBAL}
+};
+
+static PSI_cond_info all_sort_workers_conds[]=
+{
+  { &key_COND_sort_job, "COND_sort_job", PSI_FLAG_GLOBAL},
+  { &key_COND_sort_job_done, "COND_sort_job_done", PSI_FLAG_GLOBAL}
+};
+#endif /* HAVE_PSI_INTERFACE */
+
+
+/** Initialize the sort worker threads. None is started yet. */
+
+void sort_workers_init()
+{
+#ifdef HAVE_PSI_INTERFACE
+  mysql_mutex_register("sql", all_sort_workers_mutexes,
+                       array_elements(all_sort_workers_mutexes));
+  mysql_cond_register("sql", all_sort_workers_conds,
+                      array_elements(all_sort_workers_conds));
+#endif /* HAVE_PSI_INTERFACE */
+  mysql_mutex_init(key_LOCK_sort_workers, &LOCK_sort_workers,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_sort_job, &COND_sort_job, NULL);
+  mysql_cond_init(key_COND_sort_job_done, &COND_sort_job_done, NULL);
+  sort_workers_stop= false;
+  sort_workers_inited= true;
+}
+
+
+/** Stop the sort worker threads, and wait for them to exit. */
+
+void sort_workers_end()
+{
+  if (!sort_workers_inited)
+    return;
+  sort_workers_inited= false;
+
+  mysql_mutex_lock(&LOCK_sort_workers);
+  sort_workers_stop= true;
+  mysql_cond_broadcast(&COND_sort_job);
+  while (sort_worker_count)
+    mysql_cond_wait(&COND_sort_job_done, &LOCK_sort_workers);
+  mysql_mutex_unlock(&LOCK_sort_workers);
+
+  mysql_cond_destroy(&COND_sort_job_done);
+  mysql_cond_destroy(&COND_sort_job);
+  mysql_mutex_destroy(&LOCK_sort_workers);
+}
+
+
+/**
+  Run a queued job, and tell its session when its phase is done.
+  Called and returns with LOCK_sort_workers held.
+*/
+
+static void run_queued_sort_job(Sort_job *job)
+{
+  mysql_mutex_assert_owner(&LOCK_sort_workers);
+  mysql_mutex_unlock(&LOCK_sort_workers);
+  job->run();
+  mysql_mutex_lock(&LOCK_sort_workers);
+  /* The job may be gone as soon as the count is zero. */
+  if (--*job->pending == 0)
+    mysql_cond_broadcast(&COND_sort_job_done);
+}
+
+
+pthread_handler_t sort_worker_thread(void *arg)
+{
+  const bool init_error= my_thread_init();
+
+  mysql_mutex_lock(&LOCK_sort_workers);
+  /* Without my_thread_init() the jobs are left to their sessions. */
+  while (!init_error)
+  {
+    if (sort_job_queue)
+    {
+      Sort_job *job= sort_job_queue;
+      if (!(sort_job_queue= job->next))
+        sort_job_queue_last= NULL;
+      run_queued_sort_job(job);
+    }
+    else if (sort_workers_stop)
+      break;
+    else
+    {
+      sort_worker_idle++;
+      mysql_cond_wait(&COND_sort_job, &LOCK_sort_workers);
+      sort_worker_idle--;
+    }
+  }
+  sort_worker_count--;
+  mysql_cond_broadcast(&COND_sort_job_done);
+  mysql_mutex_unlock(&LOCK_sort_workers);
+
+  if (!init_error)
+    my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Run the jobs of one phase of a parallel filesort, and wait for them.
+
+  The first job is run by the calling thread, the others are queued for
+  the sort worker threads, and more workers are started if too few are
+  idle. The calling thread then takes its jobs that no worker has taken
+  yet, so all jobs are done on return even if no worker could be
+  started.
+
+  @param jobs      Jobs to run
+  @param num_jobs  Number of jobs, at most MAX_SORT_PARALLEL_DEGREE
+
+  @retval false  All jobs succeeded
+  @retval true   Some job failed
+*/
+
+static bool run_sort_jobs(Sort_job **jobs, uint num_jobs)
+{
+  uint pending= num_jobs - 1;
+  bool error= false;
+  DBUG_ENTER("run_sort_jobs");
+  DBUG_ASSERT(num_jobs > 0 && num_jobs <= MAX_SORT_PARALLEL_DEGREE);
+
+  if (pending)
+  {
+    mysql_mutex_lock(&LOCK_sort_workers);
+    for (uint i= 1; i < num_jobs; i++)
+    {
+      jobs[i]->pending= &pending;
+      jobs[i]->next= NULL;
+      if (sort_job_queue_last)
+        sort_job_queue_last->next= jobs[i];
+      else
+        sort_job_queue= jobs[i];
+      sort_job_queue_last= jobs[i];
+    }
+    for (uint i= sort_worker_idle; i < pending &&
+           sort_worker_count < MAX_SORT_PARALLEL_DEGREE - 1; i++)
+    {
+      pthread_t thread;
+      if (mysql_thread_create(key_thread_parallel_sort, &thread,
+                              &connection_attrib, sort_worker_thread, NULL))
+        break;
+      sort_worker_count++;
+    }
+    mysql_cond_broadcast(&COND_sort_job);
+    mysql_mutex_unlock(&LOCK_sort_workers);
+  }
+
+  jobs[0]->run();
+
+  if (pending)
+  {
+    mysql_mutex_lock(&LOCK_sort_workers);
+    /* Take back the jobs of this phase that no worker has taken. */
+    for (;;)
+    {
+      Sort_job *prev= NULL, *job= sort_job_queue;
+      while (job && job->pending != &pending)
+      {
+        prev= job;
+        job= job->next;
+      }
+      if (!job)
+        break;
+      if (prev)
+        prev->next= job->next;
+      else
+        sort_job_queue= job->next;
+      if (sort_job_queue_last == job)
+        sort_job_queue_last= prev;
+      run_queued_sort_job(job);
+    }
+    while (pending)
+      mysql_cond_wait(&COND_sort_job_done, &LOCK_sort_workers);
+    mysql_mutex_unlock(&LOCK_sort_workers);
+  }
+
+  for (uint i= 0; i < num_jobs; i++)
+  {
+    DBUG_ASSERT(jobs[i]->done);
+    error|= jobs[i]->error;
+  }
+  DBUG_RETURN(error);
+}
+
+
+/** Sort one chunk of a sort buffer. */
+
+class Sort_chunk_job : public Sort_job
+{
+public:
+  uchar **keys;
+  uint count;
+  size_t sort_length;
+
+  void run()
+  {
+    sort_key_pointers(keys, count, sort_length);
+    stats->sorted_chunks++;
+    stats->sorted_keys+= count;
+    done= true;
+  }
+};
+
+
+/** Merge two adjacent sorted chunks of a sort buffer into one. */
+
+class Merge_chunks_job : public Sort_job
+{
+public:
+  uchar **first, **middle, **last;
+  size_t sort_length;
+
+  void run()
+  {
+    merge_key_pointers(first, middle, last, sort_length);
+    done= true;
+  }
+};
+
+
+/**
+  Sort the first count keys in the sort buffer, with several threads
+  if param->parallel_degree allows and the buffer is large enough.
+*/
+
+static void sort_buffer_keys(Sort_param *param, Filesort_info *fs_info,
+                             uint count)
+{
+  const uint num_chunks=
+    min<uint>(param->parallel_degree, count / MIN_KEYS_PER_SORT_CHUNK);
+  if (num_chunks < 2)
+  {
+    fs_info->sort_buffer(param, count);
+    return;
+  }
+
+  DBUG_ENTER("sort_buffer_keys");
+  uchar **keys= fs_info->get_sort_keys();
+  uint bounds[MAX_SORT_PARALLEL_DEGREE + 1];
+  Sort_chunk_job sort_jobs[MAX_SORT_PARALLEL_DEGREE];
+  Sort_job *jobs[MAX_SORT_PARALLEL_DEGREE];
+
+  for (uint i= 0; i < num_chunks; i++)
+    bounds[i]= (uint) ((ulonglong) count * i / num_chunks);
+  bounds[num_chunks]= count;
+
+  for (uint i= 0; i < num_chunks; i++)
+  {
+    sort_jobs[i].keys= keys + bounds[i];
+    sort_jobs[i].count= bounds[i + 1] - bounds[i];
+    sort_jobs[i].sort_length= param->sort_length;
+    sort_jobs[i].stats= &param->worker_stats[i];
+    jobs[i]= &sort_jobs[i];
+  }
+  (void) run_sort_jobs(jobs, num_chunks);
+
+  /* Merge adjacent chunks pairwise, until one sorted chunk remains. */
+  for (uint width= 1; width < num_chunks; width*= 2)
+  {
+    Merge_chunks_job merge_jobs[MAX_SORT_PARALLEL_DEGREE / 2];
+    uint num_jobs= 0;
+    for (uint i= 0; i + width < num_chunks; i+= 2 * width)
+    {
+      Merge_chunks_job *job= &merge_jobs[num_jobs];
+      job->first= keys + bounds[i];
+      job->middle= keys + bounds[i + width];
+      job->last= keys + bounds[min(i + 2 * width, num_chunks)];
+      job->sort_length= param->sort_length;
+      jobs[num_jobs++]= job;
+    }
+    (void) run_sort_jobs(jobs, num_jobs);
+  }
+  DBUG_VOID_RETURN;
+}
+
+
 /**
   @details
   Sort the buffer and write:
@@ -888,7 +1277,7 @@ write_keys(Sort_param *param, Filesort_info *fs_info, uint count,
   rec_length= param->rec_length;
   uchar **sort_keys= fs_info->get_sort_keys();
 
-  fs_info->sort_buffer(param, count);
+  sort_buffer_keys(param, fs_info, count);
 
   if (!my_b_inited(tempfile) &&
       open_cached_file(tempfile, mysql_tmpdir, TEMP_PREFIX, DISK_BUFFER_SIZE,
@@ -1241,7 +1630,7 @@ static bool save_index(Sort_param *param, uint count, Filesort_info *table_sort)
   uchar *to;
   DBUG_ENTER("save_index");
 
-  table_sort->sort_buffer(param, count);
+  sort_buffer_keys(param, table_sort, count);
   res_length= param->res_length;
   offset= param->rec_length-res_length;
   if (!(to= table_sort->record_pointers= 
@@ -1427,6 +1816,258 @@ bool check_if_pq_applicable(Opt_trace_context *trace,
 }
 
 
+/*
+  A write-only IO_CACHE that flushes with positioned writes, so that
+  several threads can write to disjoint ranges of one file without
+  sharing a file position. Only my_b_write() and my_b_tell() may be
+  used on it, and pwrite_cache_flush() before moving pos_in_file.
+*/
+
+static int pwrite_cache_flush(IO_CACHE *cache)
+{
+  size_t length= (size_t) (cache->write_pos - cache->write_buffer);
+  if (length &&
+      mysql_file_pwrite(cache->file, cache->write_buffer, length,
+                        cache->pos_in_file, cache->myflags))
+    return (cache->error= -1);
+  cache->pos_in_file+= length;
+  cache->write_pos= cache->write_buffer;
+  return 0;
+}
+
+
+static int pwrite_cache_write(IO_CACHE *cache, const uchar *buf,
+                              size_t count)
+{
+  size_t rest= (size_t) (cache->write_end - cache->write_pos);
+  memcpy(cache->write_pos, buf, rest);
+  cache->write_pos+= rest;
+  buf+= rest;
+  count-= rest;
+  if (pwrite_cache_flush(cache))
+    return 1;
+  if (count >= cache->buffer_length)
+  {
+    if (mysql_file_pwrite(cache->file, buf, count, cache->pos_in_file,
+                          cache->myflags))
+      return (cache->error= -1);
+    cache->pos_in_file+= count;
+    return 0;
+  }
+  memcpy(cache->write_pos, buf, count);
+  cache->write_pos+= count;
+  return 0;
+}
+
+
+static bool init_pwrite_cache(IO_CACHE *cache, File file, size_t cachesize)
+{
+  memset(cache, 0, sizeof(*cache));
+  if (!(cache->buffer= (uchar*) my_malloc(key_memory_Filesort_parallel_workers,
+                                          cachesize, MYF(0))))
+    return true;
+  cache->file= file;
+  cache->type= WRITE_CACHE;
+  cache->buffer_length= cachesize;
+  cache->request_pos= cache->write_buffer= cache->write_pos= cache->buffer;
+  cache->write_end= cache->buffer + cachesize;
+  cache->current_pos= &cache->write_pos;
+  cache->current_end= &cache->write_end;
+  cache->write_function= pwrite_cache_write;
+  /* Errors are reported by the session thread, see merge_pass_parallel() */
+  cache->myflags= MYF(MY_NABP);
+  return false;
+}
+
+
+/** A group of runs merged into one by a merge_many_buff() pass. */
+
+struct Merge_group
+{
+  uint first, last;             // buffpek[first..last] are merged
+  my_off_t file_pos;            // Position of the result in the output file
+};
+
+
+/**
+  Merge a share of the groups of one merge_many_buff() pass.
+  Job j of n merges groups j, j + n, j + 2n, ... with its own part of
+  the sort buffer, and writes each result where a serial pass would
+  have written it.
+*/
+
+class Merge_runs_job : public Sort_job
+{
+public:
+  Sort_param param;             // With this job's max_keys_per_buffer
+  uchar *sort_buffer;           // This job's part of the sort buffer
+  IO_CACHE *from_file;
+  File to_file;
+  BUFFPEK *buffpek;             // Runs of the pass
+  const Merge_group *groups;
+  uint num_groups;
+  uint first_group;
+  uint group_step;
+  BUFFPEK *lastbuff;            // OUT: the merged runs, one per group
+  volatile THD::killed_state *killed;
+  int error_no;
+
+  void run()
+  {
+    IO_CACHE to_cache;
+    if (init_pwrite_cache(&to_cache, to_file, DISK_BUFFER_SIZE))
+    {
+      error_no= ENOMEM;
+      error= done= true;
+      return;
+    }
+    for (uint g= first_group; g < num_groups; g+= group_step)
+    {
+      const Merge_group *group= &groups[g];
+      to_cache.pos_in_file= group->file_pos;
+      if (do_merge_buffers(&param, from_file, &to_cache, sort_buffer,
+                           lastbuff + g, buffpek + group->first,
+                           buffpek + group->last, 0, killed) ||
+          pwrite_cache_flush(&to_cache))
+      {
+        error_no= my_errno;
+        error= true;
+        break;
+      }
+      stats->merged_runs+= group->last - group->first + 1;
+    }
+    my_free(to_cache.buffer);
+    done= true;
+  }
+};
+
+
+/**
+  Do one merge_many_buff() pass with several threads.
+
+  The runs are grouped as by a serial pass. As the size of every merged
+  run is known in advance, each group can be written to its final
+  position in to_file independently of the others.
+
+  @param      param        Sort parameters
+  @param      sort_buffer  Buffer to share out between the threads
+  @param      from_file    File with the runs to merge
+  @param      to_file      File to write the merged runs to, from start
+  @param      buffpek      Runs to merge. On return, the merged runs.
+  @param      maxbuffer    Index of the last run to merge
+  @param[out] num_merged   Number of merged runs
+
+  @retval
+    0 OK
+  @retval
+    1 Error, reported unless the sort was killed
+*/
+
+static int merge_pass_parallel(Sort_param *param, uchar *sort_buffer,
+                               IO_CACHE *from_file, IO_CACHE *to_file,
+                               BUFFPEK *buffpek, uint maxbuffer,
+                               uint *num_merged)
+{
+  THD *thd= current_thd;
+  uint num_groups= 0, num_jobs, keys_per_job;
+  my_off_t file_pos= 0;
+  Merge_group *groups;
+  BUFFPEK *lastbuff;
+  Merge_runs_job *merge_jobs;
+  Sort_job *jobs[MAX_SORT_PARALLEL_DEGREE];
+  int error= 1;
+  DBUG_ENTER("merge_pass_parallel");
+
+  const uint max_groups= maxbuffer / MERGEBUFF + 1;
+  if (!(groups= (Merge_group*)
+        my_malloc(key_memory_Filesort_parallel_workers,
+                  max_groups * (sizeof(Merge_group) + sizeof(BUFFPEK)),
+                  MYF(MY_WME))))
+    DBUG_RETURN(1);                             /* purecov: inspected */
+  lastbuff= (BUFFPEK*) (groups + max_groups);
+
+  /* Same grouping as the serial loop in merge_many_buff() */
+  for (uint i= 0; i <= maxbuffer; num_groups++)
+  {
+    const uint last= (i <= maxbuffer - MERGEBUFF*3/2) ?
+                     i + MERGEBUFF - 1 : maxbuffer;
+    ha_rows rows= 0;
+    for (uint j= i; j <= last; j++)
+      rows+= buffpek[j].count;
+    groups[num_groups].first= i;
+    groups[num_groups].last= last;
+    groups[num_groups].file_pos= file_pos;
+    file_pos+= (my_off_t) min(rows, param->max_rows) * param->rec_length;
+    i= last + 1;
+  }
+  DBUG_ASSERT(num_groups <= max_groups);
+
+  /* Each job needs room for a key from each of up to MERGEBUFF2 runs. */
+  num_jobs= min<uint>(param->parallel_degree, num_groups);
+  while (num_jobs > 1 && param->max_keys_per_buffer / num_jobs < MERGEBUFF2)
+    num_jobs--;
+  keys_per_job= param->max_keys_per_buffer / num_jobs;
+
+  if (!(merge_jobs= new (std::nothrow) Merge_runs_job[num_jobs]))
+  {
+    my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR),
+             num_jobs * sizeof(Merge_runs_job));
+    goto end;
+  }
+
+  if (to_file->file == -1 && real_open_cached_file(to_file))
+    goto end;                                   /* purecov: inspected */
+
+  for (uint j= 0; j < num_jobs; j++)
+  {
+    Merge_runs_job *job= &merge_jobs[j];
+    job->param= *param;
+    job->param.max_keys_per_buffer= keys_per_job;
+    job->sort_buffer= sort_buffer + (size_t) j * keys_per_job * param->rec_length;
+    job->from_file= from_file;
+    job->to_file= to_file->file;
+    job->buffpek= buffpek;
+    job->groups= groups;
+    job->num_groups= num_groups;
+    job->first_group= j;
+    job->group_step= num_jobs;
+    job->lastbuff= lastbuff;
+    job->killed= &thd->killed;
+    job->error_no= 0;
+    job->stats= &param->worker_stats[j];
+    jobs[j]= job;
+  }
+
+  for (uint g= 0; g < num_groups; g++)
+    thd->inc_status_sort_merge_passes();
+
+  if (run_sort_jobs(jobs, num_jobs))
+  {
+    if (!thd->killed || param->not_killable)
+    {
+      int error_no= 0;
+      for (uint j= 0; j < num_jobs && !error_no; j++)
+        error_no= merge_jobs[j].error_no;
+      char errbuf[MYSYS_STRERROR_SIZE];
+      my_error(ER_ERROR_ON_WRITE, MYF(0), my_filename(to_file->file),
+               error_no, my_strerror(errbuf, sizeof(errbuf), error_no));
+    }
+    goto end;
+  }
+
+  memcpy(buffpek, lastbuff, num_groups * sizeof(BUFFPEK));
+  /* Make my_b_tell() and so reinit_io_cache() see what the jobs wrote. */
+  to_file->pos_in_file= file_pos;
+  *num_merged= num_groups;
+  error= 0;
+
+end:
+  delete [] merge_jobs;
+  my_free(groups);
+  DBUG_RETURN(error);
+}
+
+
 /** Merge buffers to make < MERGEBUFF2 buffers. */
 
 int merge_many_buff(Sort_param *param, uchar *sort_buffer,
@@ -1452,15 +2093,26 @@ int merge_many_buff(Sort_param *param, uchar *sort_buffer,
     if (reinit_io_cache(to_file,WRITE_CACHE,0L,0,0))
       goto cleanup;
     lastbuff=buffpek;
-    for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+    if (param->parallel_degree > 1)
+    {
+      uint num_merged;
+      if (merge_pass_parallel(param, sort_buffer, from_file, to_file,
+                              buffpek, *maxbuffer, &num_merged))
+        break;
+      lastbuff+= num_merged;
+    }
+    else
     {
+      for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+      {
+        if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
+                          buffpek+i,buffpek+i+MERGEBUFF-1,0))
+          goto cleanup;
+      }
       if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-			buffpek+i,buffpek+i+MERGEBUFF-1,0))
-      goto cleanup;
+                        buffpek+i,buffpek+ *maxbuffer,0))
+        break;					/* purecov: inspected */
     }
-    if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-		      buffpek+i,buffpek+ *maxbuffer,0))
-      break;					/* purecov: inspected */
     if (flush_io_cache(to_file))
       break;					/* purecov: inspected */
     temp=from_file; from_file=to_file; to_file=temp;
@@ -1563,6 +2215,27 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
                   IO_CACHE *to_file, uchar *sort_buffer,
                   BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
                   int flag)
+{
+  THD *thd= current_thd;
+  thd->inc_status_sort_merge_passes();
+  return do_merge_buffers(param, from_file, to_file, sort_buffer,
+                          lastbuff, Fb, Tb, flag, &thd->killed);
+}
+
+
+/**
+  Merge buffers to one buffer, see merge_buffers().
+
+  Does not use the THD, so it can be called by the threads of a
+  parallel filesort.
+
+  @param killed  Checked for kill of the sort, unless param->not_killable
+*/
+
+static int do_merge_buffers(Sort_param *param, IO_CACHE *from_file,
+                            IO_CACHE *to_file, uchar *sort_buffer,
+                            BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                            int flag, volatile THD::killed_state *killed)
 {
   int error;
   uint rec_length,res_length,offset;
@@ -1575,11 +2248,9 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
   QUEUE queue;
   qsort2_cmp cmp;
   void *first_cmp_arg;
-  volatile THD::killed_state *killed= &current_thd->killed;
   THD::killed_state not_killable;
-  DBUG_ENTER("merge_buffers");
+  DBUG_ENTER("do_merge_buffers");
 
-  current_thd->inc_status_sort_merge_passes();
   if (param->not_killable)
   {
     killed= &not_killable;
@@ -1762,7 +2433,7 @@ end:
 err:
   delete_queue(&queue);
   DBUG_RETURN(error);
-} /* merge_buffers */
+} /* do_merge_buffers */
 
 
 	/* Do a merge to output-file (save only positions) */
@@ -69,6 +69,8 @@ private:
 ha_rows filesort(THD *thd, TABLE *table, Filesort *fsort, bool sort_positions,
                  ha_rows *examined_rows, ha_rows *found_rows);
 void filesort_free_buffers(TABLE *table, bool full);
+void sort_workers_init();
+void sort_workers_end();
 void change_double_for_sort(double nr,uchar *to);
 
 class Sort_param;
@@ -176,19 +176,18 @@ size_t try_reserve(std::pair<type*, ptrdiff_t> *buf, ptrdiff_t size)
 
 } // namespace
 
-void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
+void sort_key_pointers(uchar **keys, uint count, size_t sort_length)
 {
   if (count <= 1)
     return;
-  if (param->sort_length == 0)
+  if (sort_length == 0)
     return;
 
-  uchar **keys= get_sort_keys();
   std::pair<uchar**, ptrdiff_t> buffer;
-  if (radixsort_is_appliccable(count, param->sort_length) &&
+  if (radixsort_is_appliccable(count, sort_length) &&
       try_reserve(&buffer, count))
   {
-    radixsort_for_str_ptr(keys, count, param->sort_length, buffer.first);
+    radixsort_for_str_ptr(keys, count, sort_length, buffer.first);
     std::return_temporary_buffer(buffer.first);
     return;
   }
@@ -200,9 +199,24 @@ void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
   */
   if (count < 100)
   {
-    size_t size= param->sort_length;
+    size_t size= sort_length;
     my_qsort2(keys, count, sizeof(uchar*), get_ptr_compare(size), &size);
     return;
   }
-  std::stable_sort(keys, keys + count, Mem_compare(param->sort_length));
+  std::stable_sort(keys, keys + count, Mem_compare(sort_length));
+}
+
+
+void merge_key_pointers(uchar **first, uchar **middle, uchar **last,
+                        size_t sort_length)
+{
+  if (first == middle || middle == last || sort_length == 0)
+    return;
+  std::inplace_merge(first, middle, last, Mem_compare(sort_length));
+}
+
+
+void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
+{
+  sort_key_pointers(get_sort_keys(), count, param->sort_length);
 }
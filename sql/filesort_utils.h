@@ -47,6 +47,25 @@ double get_merge_many_buffs_cost_fast(ha_rows num_rows,
                                       uint    elem_size);
 
 
+/**
+  Sort an array of pointers to keys of length sort_length.
+  Radix sort, quicksort or std::stable_sort is used, depending on
+  the number of keys and the key length.
+
+  @note
+    Touches only the given array, so that disjoint parts of the same
+    sort buffer can be sorted by different threads.
+*/
+void sort_key_pointers(uchar **keys, uint count, size_t sort_length);
+
+/**
+  Merge two adjacent sorted arrays of key pointers,
+  [first, middle) and [middle, last), into one sorted array.
+*/
+void merge_key_pointers(uchar **first, uchar **middle, uchar **last,
+                        size_t sort_length);
+
+
 /**
   A wrapper class around the buffer used by filesort().
   The buffer is a contiguous chunk of memory,
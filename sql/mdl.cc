@@ -18,6 +18,7 @@
 #include "debug_sync.h"
 #include "sql_array.h"
 #include <hash.h>
+#include <my_atomic.h>
 #include <mysqld_error.h>
 #include <mysql/plugin.h>
 #include <mysql/service_thd_wait.h>
@@ -136,6 +137,9 @@ public:
   ~MDL_map_partition();
   inline MDL_lock *find_or_insert(const MDL_key *mdl_key,
                                   my_hash_value_type hash_value);
+  inline MDL_lock *try_fast_path_acquire(const MDL_key *mdl_key,
+                                         my_hash_value_type hash_value,
+                                         int64 unobtrusive_lock_increment);
   inline void remove(MDL_lock *lock);
   my_hash_value_type get_key_hash(const MDL_key *mdl_key) const
   {
@@ -186,6 +190,8 @@ public:
   void init();
   void destroy();
   MDL_lock *find_or_insert(const MDL_key *key);
+  MDL_lock *try_fast_path_acquire(const MDL_key *key,
+                                  int64 unobtrusive_lock_increment);
   void remove(MDL_lock *lock);
 private:
   /** Array of partitions where the locks are actually stored. */
@@ -357,6 +363,27 @@ class MDL_lock
 {
 public:
   typedef unsigned short bitmap_t;
+  /**
+    Type of MDL_lock::m_fast_path_state. Packs the counters of the
+    unobtrusive locks granted on the fast path and the flags below.
+  */
+  typedef int64 fast_path_state_t;
+
+  /**
+    Number of bits used for each counter in the fast path state.
+    Several tickets of a context can be accounted in the same
+    counter, but their total stays far below 2^20.
+  */
+  static const uint FAST_PATH_COUNTER_BITS= 20;
+  static const fast_path_state_t FAST_PATH_COUNTER_MASK=
+    (1LL << FAST_PATH_COUNTER_BITS) - 1;
+  /**
+    Flag set in the fast path state when there is a granted or pending
+    ticket for an obtrusive lock type in m_granted or m_waiting lists.
+    While it is set unobtrusive locks can't be granted on the fast path,
+    and releasing them has to wake up waiters.
+  */
+  static const fast_path_state_t HAS_OBTRUSIVE= 1LL << 62;
 
   class Ticket_list
   {
@@ -424,18 +451,65 @@ public:
   */
   mysql_prlock_t m_rwlock;
 
-  bool is_empty() const
+  bool is_empty()
   {
-    return (m_granted.is_empty() && m_waiting.is_empty());
+    return (m_granted.is_empty() && m_waiting.is_empty() &&
+            get_fast_path_state() == 0);
   }
 
   virtual const bitmap_t *incompatible_granted_types_bitmap() const = 0;
   virtual const bitmap_t *incompatible_waiting_types_bitmap() const = 0;
+  /**
+    Array of increments of the fast path state, indexed by lock type.
+    Zero for obtrusive lock types which are never granted on the fast
+    path.
+  */
+  virtual const fast_path_state_t *unobtrusive_lock_increments() const = 0;
+
+  static fast_path_state_t
+  get_unobtrusive_lock_increment(const MDL_request *request);
+
+  bool is_obtrusive_lock(enum_mdl_type type) const
+  {
+    return unobtrusive_lock_increments()[type] == 0;
+  }
 
   bool has_pending_conflicting_lock(enum_mdl_type type);
 
   bool can_grant_lock(enum_mdl_type type, MDL_context *requstor_ctx,
-                      bool ignore_lock_priority) const;
+                      bool ignore_lock_priority);
+
+  fast_path_state_t get_fast_path_state()
+  {
+    fast_path_state_t state;
+    my_atomic_rwlock_rdlock(&m_fast_path_state_lock);
+    state= my_atomic_load64(&m_fast_path_state);
+    my_atomic_rwlock_rdunlock(&m_fast_path_state_lock);
+    return state;
+  }
+
+  void add_to_fast_path_state(fast_path_state_t value)
+  {
+    my_atomic_rwlock_wrlock(&m_fast_path_state_lock);
+    my_atomic_add64(&m_fast_path_state, value);
+    my_atomic_rwlock_wrunlock(&m_fast_path_state_lock);
+  }
+
+  bool cas_fast_path_state(fast_path_state_t *old_state,
+                           fast_path_state_t new_state)
+  {
+    bool res;
+    my_atomic_rwlock_wrlock(&m_fast_path_state_lock);
+    res= my_atomic_cas64(&m_fast_path_state, old_state, new_state);
+    my_atomic_rwlock_wrunlock(&m_fast_path_state_lock);
+    return res;
+  }
+
+  bool fast_path_acquire(fast_path_state_t unobtrusive_lock_increment);
+  bool fast_path_release(fast_path_state_t unobtrusive_lock_increment);
+  bitmap_t fast_path_granted_bitmap(fast_path_state_t state) const;
+  void set_obtrusive_flag();
+  void update_obtrusive_flag();
 
   inline static MDL_lock *create(const MDL_key *key,
                                  MDL_map_partition *map_part);
@@ -463,11 +537,26 @@ public:
   */
   ulong m_hog_lock_count;
 
+  /**
+    Counters of unobtrusive locks granted on the fast path, without
+    acquiring m_rwlock, and the HAS_OBTRUSIVE flag.
+
+    The counters are incremented only when HAS_OBTRUSIVE is not set,
+    either by a lock-free CAS while the object is pinned by
+    MDL_map_partition::m_mutex (or is a pre-allocated GLOBAL/COMMIT
+    lock) or under m_rwlock. The flag is changed only under m_rwlock.
+    Tickets accounted here always belong to contexts that are not
+    waiting for other locks, see MDL_context::materialize_fast_path_locks().
+  */
+  volatile int64 m_fast_path_state;
+  my_atomic_rwlock_t m_fast_path_state_lock;
+
 public:
 
   MDL_lock(const MDL_key *key_arg, MDL_map_partition *map_part)
   : key(key_arg),
     m_hog_lock_count(0),
+    m_fast_path_state(0),
     m_ref_usage(0),
     m_ref_release(0),
     m_is_destroyed(FALSE),
@@ -475,10 +564,12 @@ public:
     m_map_part(map_part)
   {
     mysql_prlock_init(key_MDL_lock_rwlock, &m_rwlock);
+    my_atomic_rwlock_init(&m_fast_path_state_lock);
   }
 
   virtual ~MDL_lock()
   {
+    my_atomic_rwlock_destroy(&m_fast_path_state_lock);
     mysql_prlock_destroy(&m_rwlock);
   }
   inline static void destroy(MDL_lock *lock);
@@ -551,6 +642,10 @@ public:
   {
     return m_waiting_incompatible;
   }
+  virtual const fast_path_state_t *unobtrusive_lock_increments() const
+  {
+    return m_unobtrusive_lock_increment;
+  }
   virtual bool needs_notification(const MDL_ticket *ticket) const
   {
     return (ticket->get_type() == MDL_SHARED);
@@ -569,6 +664,9 @@ public:
 private:
   static const bitmap_t m_granted_incompatible[MDL_TYPE_END];
   static const bitmap_t m_waiting_incompatible[MDL_TYPE_END];
+
+public:
+  static const fast_path_state_t m_unobtrusive_lock_increment[MDL_TYPE_END];
 };
 
 
@@ -592,7 +690,10 @@ public:
   {
     /* We need to change only object's key. */
     key.mdl_key_init(new_key);
-    /* m_granted and m_waiting should be already in the empty/initial state. */
+    /*
+      m_granted, m_waiting and m_fast_path_state should be already in
+      the empty/initial state.
+    */
     DBUG_ASSERT(is_empty());
     /* Object should not be marked as destroyed. */
     DBUG_ASSERT(! m_is_destroyed);
@@ -612,6 +713,10 @@ public:
   {
     return m_waiting_incompatible;
   }
+  virtual const fast_path_state_t *unobtrusive_lock_increments() const
+  {
+    return m_unobtrusive_lock_increment;
+  }
   virtual bool needs_notification(const MDL_ticket *ticket) const
   {
     return (ticket->get_type() >= MDL_SHARED_NO_WRITE);
@@ -635,6 +740,8 @@ private:
   static const bitmap_t m_waiting_incompatible[MDL_TYPE_END];
 
 public:
+  static const fast_path_state_t m_unobtrusive_lock_increment[MDL_TYPE_END];
+
   /** Members for linking the object into the list of unused objects. */
   MDL_object_lock *next_in_cache, **prev_in_cache;
 };
@@ -892,6 +999,78 @@ retry:
 }
 
 
+/**
+  Try to grant an unobtrusive lock on the fast path, i.e. without
+  acquiring MDL_lock::m_rwlock of the MDL_lock object for the key.
+
+  @param mdl_key                     Key of the lock.
+  @param unobtrusive_lock_increment  Increment of the fast path state for
+                                     the requested lock type.
+
+  @retval non-NULL - Lock was granted, MDL_lock instance for the key.
+  @retval NULL     - Object does not exist yet or there are obtrusive
+                     locks on it, caller should use the slow path.
+*/
+
+MDL_lock* MDL_map::try_fast_path_acquire(const MDL_key *mdl_key,
+                                         int64 unobtrusive_lock_increment)
+{
+  MDL_lock *lock;
+
+  if (mdl_key->mdl_namespace() == MDL_key::GLOBAL ||
+      mdl_key->mdl_namespace() == MDL_key::COMMIT)
+  {
+    /*
+      Pre-allocated objects are never destroyed, so no mutex at all
+      is needed to pin them.
+    */
+    lock= (mdl_key->mdl_namespace() == MDL_key::GLOBAL) ? m_global_lock :
+                                                          m_commit_lock;
+
+    return lock->fast_path_acquire(unobtrusive_lock_increment) ? lock : NULL;
+  }
+
+  my_hash_value_type hash_value= m_partitions.at(0)->get_key_hash(mdl_key);
+  uint part_id= hash_value % mdl_locks_hash_partitions;
+  MDL_map_partition *part= m_partitions.at(part_id);
+
+  return part->try_fast_path_acquire(mdl_key, hash_value,
+                                     unobtrusive_lock_increment);
+}
+
+
+/**
+  Find MDL_lock object corresponding to the key and hash value in
+  MDL_map partition and try to grant an unobtrusive lock on it on
+  the fast path.
+
+  @note MDL_map_partition::m_mutex prevents the object from being
+        removed from the hash while we increment its fast path
+        state. Once the counter is non-zero the object is pinned
+        by the granted lock, see MDL_map_partition::remove().
+
+  @retval non-NULL - Lock was granted, MDL_lock instance for the key.
+  @retval NULL     - Caller should use the slow path.
+*/
+
+MDL_lock* MDL_map_partition::try_fast_path_acquire(const MDL_key *mdl_key,
+                                          my_hash_value_type hash_value,
+                                          int64 unobtrusive_lock_increment)
+{
+  MDL_lock *lock;
+
+  mysql_mutex_lock(&m_mutex);
+  lock= (MDL_lock*) my_hash_search_using_hash_value(&m_locks, hash_value,
+                                                    mdl_key->ptr(),
+                                                    mdl_key->length());
+  if (lock && ! lock->fast_path_acquire(unobtrusive_lock_increment))
+    lock= NULL;
+  mysql_mutex_unlock(&m_mutex);
+
+  return lock;
+}
+
+
 /**
   Release MDL_map_partition::m_mutex mutex and lock MDL_lock::m_rwlock for lock
   object from the hash. Handle situation when object was released
@@ -997,6 +1176,18 @@ void MDL_map::remove(MDL_lock *lock)
 void MDL_map_partition::remove(MDL_lock *lock)
 {
   mysql_mutex_lock(&m_mutex);
+  if (lock->get_fast_path_state() != 0)
+  {
+    /*
+      Some thread has found the object in the hash and has been granted
+      a lock on the fast path after we have checked that the object is
+      unused. It will take care of removing the object when releasing
+      its lock.
+    */
+    mysql_mutex_unlock(&m_mutex);
+    mysql_prlock_unlock(&lock->m_rwlock);
+    return;
+  }
   my_hash_delete(&m_locks, (uchar*) lock);
   /*
     To let threads holding references to the MDL_lock object know that it was
@@ -1069,6 +1260,7 @@ MDL_context::MDL_context()
   :
   m_owner(NULL),
   m_needs_thr_lock_abort(FALSE),
+  m_fast_path_locks_count(0),
   m_waiting_for(NULL)
 {
   mysql_prlock_init(key_MDL_context_LOCK_waiting_for, &m_LOCK_waiting_for);
@@ -1092,6 +1284,7 @@ void MDL_context::destroy()
   DBUG_ASSERT(m_tickets[MDL_STATEMENT].is_empty());
   DBUG_ASSERT(m_tickets[MDL_TRANSACTION].is_empty());
   DBUG_ASSERT(m_tickets[MDL_EXPLICIT].is_empty());
+  DBUG_ASSERT(m_fast_path_locks_count == 0);
 
   mysql_prlock_destroy(&m_LOCK_waiting_for);
 }
@@ -1606,6 +1799,20 @@ const MDL_lock::bitmap_t MDL_scoped_lock::m_waiting_incompatible[MDL_TYPE_END] =
 };
 
 
+/**
+  Increments of the fast path state for the scoped lock. Only IX locks,
+  which are taken by every statement changing data or metadata, are
+  unobtrusive, i.e. can be granted without acquiring MDL_lock::m_rwlock
+  as long as there are no S or X locks granted or pending.
+*/
+
+const MDL_lock::fast_path_state_t
+MDL_scoped_lock::m_unobtrusive_lock_increment[MDL_TYPE_END] =
+{
+  1, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+
 /**
   Compatibility (or rather "incompatibility") matrices for per-object
   metadata lock. Arrays of bitmaps which elements specify which granted/
@@ -1700,6 +1907,177 @@ MDL_object_lock::m_waiting_incompatible[MDL_TYPE_END] =
 };
 
 
+/**
+  Increments of the fast path state for the per-object lock.
+
+  S, SH, SR and SW locks, which are taken by DML statements, are
+  unobtrusive: they are compatible with each other, so they can be
+  granted by incrementing a counter in MDL_lock::m_fast_path_state
+  as long as no SU, SNW, SNRW or X lock is granted or pending.
+  S and SH locks share a counter since they conflict only with X lock.
+*/
+
+const MDL_lock::fast_path_state_t
+MDL_object_lock::m_unobtrusive_lock_increment[MDL_TYPE_END] =
+{
+  0,
+  1,
+  1,
+  1LL << FAST_PATH_COUNTER_BITS,
+  1LL << (2 * FAST_PATH_COUNTER_BITS),
+  0, 0, 0, 0
+};
+
+
+/**
+  Get increment of the fast path state for the lock requested,
+  or 0 if the requested lock type is obtrusive.
+
+  @note This has to be known before the MDL_lock object for the
+        request is found, hence the dispatch on the namespace
+        mirroring MDL_lock::create().
+*/
+
+MDL_lock::fast_path_state_t
+MDL_lock::get_unobtrusive_lock_increment(const MDL_request *request)
+{
+  switch (request->key.mdl_namespace())
+  {
+    case MDL_key::GLOBAL:
+    case MDL_key::SCHEMA:
+    case MDL_key::COMMIT:
+      return MDL_scoped_lock::m_unobtrusive_lock_increment[request->type];
+    default:
+      return MDL_object_lock::m_unobtrusive_lock_increment[request->type];
+  }
+}
+
+
+/**
+  Grant an unobtrusive lock on the fast path by atomically incrementing
+  the corresponding counter in the fast path state.
+
+  @pre The object must be pinned, i.e. be one of the pre-allocated
+       objects, or be looked up under MDL_map_partition::m_mutex,
+       or have its m_rwlock locked.
+
+  @retval TRUE   Lock was granted.
+  @retval FALSE  There are obtrusive locks granted or pending,
+                 slow path must be used.
+*/
+
+bool MDL_lock::fast_path_acquire(fast_path_state_t unobtrusive_lock_increment)
+{
+  fast_path_state_t old_state= get_fast_path_state();
+
+  do
+  {
+    if (old_state & HAS_OBTRUSIVE)
+      return FALSE;
+  } while (! cas_fast_path_state(&old_state,
+                                 old_state + unobtrusive_lock_increment));
+  return TRUE;
+}
+
+
+/**
+  Release a lock granted on the fast path without acquiring m_rwlock.
+
+  @retval TRUE   Lock was released.
+  @retval FALSE  Lock was not released since there are waiters which
+                 might have to be woken up, or since this is the last
+                 lock on the object so it has to be removed from
+                 MDL_map. The caller must release the lock under
+                 m_rwlock.
+*/
+
+bool MDL_lock::fast_path_release(fast_path_state_t unobtrusive_lock_increment)
+{
+  fast_path_state_t old_state= get_fast_path_state();
+
+  do
+  {
+    /* Pre-allocated objects have no partition and are never removed. */
+    if ((old_state & HAS_OBTRUSIVE) ||
+        (old_state == unobtrusive_lock_increment && m_map_part))
+      return FALSE;
+  } while (! cas_fast_path_state(&old_state,
+                                 old_state - unobtrusive_lock_increment));
+  return TRUE;
+}
+
+
+/**
+  Get bitmap of lock types for which there are locks granted on the
+  fast path according to the fast path state.
+*/
+
+MDL_lock::bitmap_t
+MDL_lock::fast_path_granted_bitmap(fast_path_state_t state) const
+{
+  const fast_path_state_t *increments= unobtrusive_lock_increments();
+  bitmap_t result= 0;
+
+  for (uint i= 0; i < MDL_TYPE_END; i++)
+  {
+    if (increments[i] && ((state / increments[i]) & FAST_PATH_COUNTER_MASK))
+      result|= MDL_BIT(i);
+  }
+  return result;
+}
+
+
+/**
+  Forbid granting of unobtrusive locks on the fast path. Called before
+  checking if an obtrusive lock can be granted, so that the fast path
+  counters can only decrease after the check.
+
+  @pre m_rwlock is write-locked.
+*/
+
+void MDL_lock::set_obtrusive_flag()
+{
+  fast_path_state_t old_state= get_fast_path_state();
+
+  while (! (old_state & HAS_OBTRUSIVE) &&
+         ! cas_fast_path_state(&old_state, old_state | HAS_OBTRUSIVE))
+  { }
+}
+
+
+/**
+  Set or clear the HAS_OBTRUSIVE flag according to the types of tickets
+  in the granted and waiting lists.
+
+  @pre m_rwlock is write-locked.
+*/
+
+void MDL_lock::update_obtrusive_flag()
+{
+  bitmap_t types= m_granted.bitmap() | m_waiting.bitmap();
+  fast_path_state_t old_state, new_state;
+  bool has_obtrusive= FALSE;
+
+  for (uint i= 0; i < MDL_TYPE_END; i++)
+  {
+    if ((types & MDL_BIT(i)) && is_obtrusive_lock((enum_mdl_type) i))
+    {
+      has_obtrusive= TRUE;
+      break;
+    }
+  }
+
+  old_state= get_fast_path_state();
+  do
+  {
+    new_state= has_obtrusive ? (old_state | HAS_OBTRUSIVE) :
+                               (old_state & ~HAS_OBTRUSIVE);
+    if (new_state == old_state)
+      break;
+  } while (! cas_fast_path_state(&old_state, new_state));
+}
+
+
 /**
   Check if request for the metadata lock can be satisfied given its
   current state.
@@ -1719,12 +2097,21 @@ MDL_object_lock::m_waiting_incompatible[MDL_TYPE_END] =
 bool
 MDL_lock::can_grant_lock(enum_mdl_type type_arg,
                          MDL_context *requestor_ctx,
-                         bool ignore_lock_priority) const
+                         bool ignore_lock_priority)
 {
   bool can_grant= FALSE;
   bitmap_t waiting_incompat_map= incompatible_waiting_types_bitmap()[type_arg];
   bitmap_t granted_incompat_map= incompatible_granted_types_bitmap()[type_arg];
 
+  /*
+    Locks granted on the fast path always belong to other contexts,
+    since the requestor has materialized its own fast path locks
+    before requesting an obtrusive lock (and unobtrusive locks never
+    conflict with them).
+  */
+  if (fast_path_granted_bitmap(get_fast_path_state()) & granted_incompat_map)
+    return FALSE;
+
   /*
     New lock request can be satisfied iff:
     - There are no incompatible types of satisfied requests
@@ -1760,8 +2147,24 @@ MDL_lock::can_grant_lock(enum_mdl_type type_arg,
 
 void MDL_lock::remove_ticket(Ticket_list MDL_lock::*list, MDL_ticket *ticket)
 {
-  mysql_prlock_wrlock(&m_rwlock);
-  (this->*list).remove_ticket(ticket);
+  if (ticket->is_fast_path())
+  {
+    fast_path_state_t unobtrusive_lock_increment=
+      unobtrusive_lock_increments()[ticket->get_type()];
+
+    if (fast_path_release(unobtrusive_lock_increment))
+      return;
+
+    mysql_prlock_wrlock(&m_rwlock);
+    add_to_fast_path_state(-unobtrusive_lock_increment);
+  }
+  else
+  {
+    mysql_prlock_wrlock(&m_rwlock);
+    (this->*list).remove_ticket(ticket);
+    if (is_obtrusive_lock(ticket->get_type()))
+      update_obtrusive_flag();
+  }
   if (is_empty())
     mdl_locks.remove(this);
   else
@@ -1934,6 +2337,8 @@ MDL_context::try_acquire_lock(MDL_request *mdl_request)
       is no need to release it.
     */
     DBUG_ASSERT(! ticket->m_lock->is_empty());
+    if (ticket->m_lock->is_obtrusive_lock(mdl_request->type))
+      ticket->m_lock->update_obtrusive_flag();
     mysql_prlock_unlock(&ticket->m_lock->m_rwlock);
     MDL_ticket::destroy(ticket);
   }
@@ -1966,6 +2371,8 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
   MDL_key *key= &mdl_request->key;
   MDL_ticket *ticket;
   enum_mdl_duration found_duration;
+  MDL_lock::fast_path_state_t unobtrusive_lock_increment;
+  bool use_fast_path;
 
   DBUG_ASSERT(mdl_request->type != MDL_EXCLUSIVE ||
               is_lock_owner(MDL_key::GLOBAL, "", "", MDL_INTENTION_EXCLUSIVE));
@@ -2019,6 +2426,33 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
                                    )))
     return TRUE;
 
+  /*
+    Unobtrusive locks are granted on the fast path, without acquiring
+    MDL_lock::m_rwlock, unless owners of conflicting locks must be able
+    to find this context's tickets in order to notify it.
+  */
+  unobtrusive_lock_increment=
+    MDL_lock::get_unobtrusive_lock_increment(mdl_request);
+  use_fast_path= unobtrusive_lock_increment && ! m_needs_thr_lock_abort;
+
+  if (use_fast_path &&
+      (lock= mdl_locks.try_fast_path_acquire(key, unobtrusive_lock_increment)))
+  {
+    ticket->m_lock= lock;
+    ticket->m_is_fast_path= TRUE;
+    m_fast_path_locks_count++;
+    m_tickets[mdl_request->duration].push_front(ticket);
+    mdl_request->ticket= ticket;
+    return FALSE;
+  }
+
+  /*
+    An obtrusive lock request has to see all locks of this context in
+    the granted lists, as they are not conflicting with it.
+  */
+  if (! unobtrusive_lock_increment)
+    materialize_fast_path_locks();
+
   /* The below call implicitly locks MDL_lock::m_rwlock on success. */
   if (!(lock= mdl_locks.find_or_insert(key)))
   {
@@ -2028,6 +2462,30 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
 
   ticket->m_lock= lock;
 
+  if (use_fast_path && lock->fast_path_acquire(unobtrusive_lock_increment))
+  {
+    /*
+      The object has just been created or there are no obtrusive locks
+      any more. We hold m_rwlock so the object can't be removed from the
+      hash before the counter is incremented.
+    */
+    mysql_prlock_unlock(&lock->m_rwlock);
+    ticket->m_is_fast_path= TRUE;
+    m_fast_path_locks_count++;
+    m_tickets[mdl_request->duration].push_front(ticket);
+    mdl_request->ticket= ticket;
+    return FALSE;
+  }
+
+  /*
+    Stop granting of unobtrusive locks on the fast path so the fast path
+    counters checked by can_grant_lock() can only decrease. If the lock
+    is not granted the flag stays set for the pending ticket, or is
+    reset by the caller.
+  */
+  if (! unobtrusive_lock_increment)
+    lock->set_obtrusive_flag();
+
   if (lock->can_grant_lock(mdl_request->type, this, false))
   {
     lock->m_granted.add_ticket(ticket);
@@ -2092,6 +2550,54 @@ MDL_context::clone_ticket(MDL_request *mdl_request)
 }
 
 
+/**
+  Move all tickets of this context which were granted on the fast path
+  to the granted lists of their locks.
+
+  This makes them visible to the deadlock detector, to contexts that
+  notify owners of conflicting locks, and to can_grant_lock(), which
+  ignores only the tickets of the requestor found in the granted list.
+  Therefore it is done before this context starts waiting for a lock,
+  before it requests an obtrusive lock and before it is marked as
+  needing abort of table-level lock waits.
+
+  @pre The context must not hold MDL_lock::m_rwlock of any lock.
+*/
+
+void MDL_context::materialize_fast_path_locks()
+{
+  int i;
+
+  if (m_fast_path_locks_count == 0)
+    return;
+
+  for (i= 0; i < MDL_DURATION_END; i++)
+  {
+    Ticket_iterator it(m_tickets[i]);
+    MDL_ticket *ticket;
+
+    while ((ticket= it++))
+    {
+      if (! ticket->m_is_fast_path)
+        continue;
+
+      MDL_lock *lock= ticket->m_lock;
+      mysql_prlock_wrlock(&lock->m_rwlock);
+      /*
+        The object can't be removed while we hold m_rwlock, and is
+        referenced by the granted list once the counter is decremented.
+      */
+      lock->add_to_fast_path_state(
+        -lock->unobtrusive_lock_increments()[ticket->m_type]);
+      ticket->m_is_fast_path= FALSE;
+      lock->m_granted.add_ticket(ticket);
+      mysql_prlock_unlock(&lock->m_rwlock);
+    }
+  }
+  m_fast_path_locks_count= 0;
+}
+
+
 /**
   Notify threads holding a shared metadata locks on object which
   conflict with a pending X, SNW or SNRW lock.
@@ -2180,6 +2686,7 @@ MDL_context::acquire_lock(MDL_request *mdl_request, ulong lock_wait_timeout)
   /* Do some work outside the critical section. */
   set_timespec(abs_timeout, lock_wait_timeout);
 
+retry:
   if (try_acquire_lock_impl(mdl_request, &ticket))
     return TRUE;
 
@@ -2201,6 +2708,23 @@ MDL_context::acquire_lock(MDL_request *mdl_request, ulong lock_wait_timeout)
   */
   lock= ticket->m_lock;
 
+  if (m_fast_path_locks_count)
+  {
+    /*
+      The deadlock detector only sees tickets in the granted lists, so
+      before starting to wait we have to move the locks of this context
+      acquired on the fast path there. This can't be done while holding
+      MDL_lock::m_rwlock, so back off and retry. The requested lock is
+      unobtrusive, since obtrusive requests materialize such locks first,
+      so there is no flag to reset.
+    */
+    DBUG_ASSERT(! lock->is_obtrusive_lock(mdl_request->type));
+    mysql_prlock_unlock(&lock->m_rwlock);
+    MDL_ticket::destroy(ticket);
+    materialize_fast_path_locks();
+    goto retry;
+  }
+
   lock->m_waiting.add_ticket(ticket);
 
   /*
@@ -2416,6 +2940,12 @@ MDL_context::upgrade_shared_lock(MDL_ticket *mdl_ticket,
   mdl_xlock_request.init(&mdl_ticket->m_lock->key, new_type,
                          MDL_TRANSACTION);
 
+  /*
+    The ticket is going to be moved to the stronger type in the granted
+    list, so it can't stay a fast path one.
+  */
+  materialize_fast_path_locks();
+
   if (acquire_lock(&mdl_xlock_request, lock_wait_timeout))
     DBUG_RETURN(TRUE);
 
@@ -2714,6 +3244,9 @@ void MDL_context::release_lock(enum_mdl_duration duration, MDL_ticket *ticket)
   DBUG_ASSERT(this == ticket->get_ctx());
   mysql_mutex_assert_not_owner(&LOCK_open);
 
+  if (ticket->m_is_fast_path)
+    m_fast_path_locks_count--;
+
   lock->remove_ticket(&MDL_lock::m_granted, ticket);
 
   m_tickets[duration].remove(ticket);
@@ -2829,6 +3362,7 @@ void MDL_ticket::downgrade_lock(enum_mdl_type type)
   m_lock->m_granted.remove_ticket(this);
   m_type= type;
   m_lock->m_granted.add_ticket(this);
+  m_lock->update_obtrusive_flag();
   m_lock->reschedule_waiters();
   mysql_prlock_unlock(&m_lock->m_rwlock);
 }
@@ -580,6 +580,7 @@ public:
   }
   enum_mdl_type get_type() const { return m_type; }
   MDL_lock *get_lock() const { return m_lock; }
+  bool is_fast_path() const { return m_is_fast_path; }
   void downgrade_lock(enum_mdl_type type);
 
   bool has_stronger_or_equal_type(enum_mdl_type type) const;
@@ -603,7 +604,8 @@ private:
      m_duration(duration_arg),
 #endif
      m_ctx(ctx_arg),
-     m_lock(NULL)
+     m_lock(NULL),
+     m_is_fast_path(FALSE)
   {}
 
   static MDL_ticket *create(MDL_context *ctx_arg, enum_mdl_type type_arg
@@ -632,6 +634,13 @@ private:
   */
   MDL_lock *m_lock;
 
+  /**
+    TRUE if the lock was granted on the fast path, i.e. the ticket is
+    accounted in MDL_lock::m_fast_path_state instead of being included
+    in the MDL_lock::m_granted list. Context private.
+  */
+  bool m_is_fast_path;
+
 private:
   MDL_ticket(const MDL_ticket &);               /* not implemented */
   MDL_ticket &operator=(const MDL_ticket &);    /* not implemented */
@@ -794,6 +803,13 @@ public:
             will see the new value eventually.
     */
     m_needs_thr_lock_abort= needs_thr_lock_abort;
+    /*
+      Owners of conflicting locks are notified by iterating over the
+      granted tickets, so locks acquired on the fast path have to be
+      made visible there.
+    */
+    if (needs_thr_lock_abort)
+      materialize_fast_path_locks();
   }
   bool get_needs_thr_lock_abort() const
   {
@@ -872,6 +888,11 @@ private:
     FALSE - Otherwise.
   */
   bool m_needs_thr_lock_abort;
+  /**
+    Number of tickets of this context which were acquired on the fast
+    path and thus are not included in MDL_lock::m_granted lists.
+  */
+  uint m_fast_path_locks_count;
 
   /**
     Read-write lock protecting m_waiting_for member.
@@ -899,6 +920,8 @@ private:
                              MDL_ticket **out_ticket);
 
 public:
+  void materialize_fast_path_locks();
+
   void find_deadlock();
 
   bool visit_subgraph(MDL_wait_for_graph_visitor *dvisitor);
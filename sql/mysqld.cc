@@ -56,6 +56,7 @@
 #include "derror.h"       // init_errmessage
 #include "des_key_file.h" // load_des_key_file
 #include "sql_manager.h"  // stop_handle_manager, start_handle_manager
+#include "filesort.h"     // sort_workers_init, sort_workers_end
 #include <m_ctype.h>
 #include <my_dir.h>
 #include <my_bit.h>
@@ -1106,6 +1107,7 @@ int allow_severity = LOG_INFO;
 int deny_severity = LOG_WARNING;
 #endif /* HAVE_LIBWRAP */
 ulong query_cache_min_res_unit= QUERY_CACHE_MIN_RESULT_DATA_SIZE;
+ulong query_cache_partitions= 1;
 Query_cache query_cache;
 #if defined (_WIN32) && !defined (EMBEDDED_LIBRARY)
 char *shared_memory_base_name= default_shared_memory_base_name;
@@ -1600,6 +1602,7 @@ void clean_up(bool print_message)
   delegates_destroy();
   xid_cache_free();
   table_def_free();
+  sort_workers_end();
   mdl_destroy();
   key_caches.delete_elements((void (*)(const char*, uchar*)) free_key_cache);
   multi_keycache_free();
@@ -3938,9 +3941,9 @@ static void init_server_query_cache()
 {
   ulong set_cache_size;
 
+  query_cache.init(query_cache_partitions);
   query_cache.set_min_res_unit(query_cache_min_res_unit);
-  query_cache.init();
-	
+
   set_cache_size= query_cache.resize(query_cache_size);
   if (set_cache_size != query_cache_size)
   {
@@ -3959,6 +3962,7 @@ static int init_server_components()
     all things are initialized so that unireg_abort() doesn't fail
   */
   mdl_init();
+  sort_workers_init();
   if (table_def_init() | hostname_cache_init())
     unireg_abort(1);
 
@@ -5996,6 +6000,72 @@ static int show_open_tables(THD *thd, SHOW_VAR *var, char *buff)
   return 0;
 }
 
+static int show_qcache_counter(SHOW_VAR *var, char *buff,
+                               ulong Query_cache_partition::*counter)
+{
+  var->type= SHOW_LONG;
+  var->value= buff;
+  *((long *)buff)= (long)query_cache.status(counter);
+  return 0;
+}
+
+static int show_qcache_free_blocks(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff,
+                             &Query_cache_partition::free_memory_blocks);
+}
+
+static int show_qcache_free_memory(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::free_memory);
+}
+
+static int show_qcache_hits(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::hits);
+}
+
+static int show_qcache_inserts(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::inserts);
+}
+
+static int show_qcache_lock_waits(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::lock_waits);
+}
+
+static int show_qcache_lowmem_prunes(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff,
+                             &Query_cache_partition::lowmem_prunes);
+}
+
+static int show_qcache_not_cached(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::refused);
+}
+
+static int show_qcache_queries_in_cache(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff,
+                             &Query_cache_partition::queries_in_cache);
+}
+
+static int show_qcache_total_blocks(THD *thd, SHOW_VAR *var, char *buff)
+{
+  return show_qcache_counter(var, buff, &Query_cache_partition::total_blocks);
+}
+
+static int show_qcache_partition(THD *thd, SHOW_VAR *var, char *buff)
+{
+  static SHOW_VAR no_partitions[]= {{NullS, NullS, SHOW_LONG}};
+  var->type= SHOW_ARRAY;
+  var->value= (char *) (query_cache.status_vars() ?
+                        query_cache.status_vars() : no_partitions);
+  return 0;
+}
+
 static int show_prepared_stmt_count(THD *thd, SHOW_VAR *var, char *buff)
 {
   var->type= SHOW_LONG;
@@ -6444,14 +6514,16 @@ SHOW_VAR status_vars[]= {
   {"Opened_tables",            (char*) offsetof(STATUS_VAR, opened_tables), SHOW_LONGLONG_STATUS},
   {"Opened_table_definitions", (char*) offsetof(STATUS_VAR, opened_shares), SHOW_LONGLONG_STATUS},
   {"Prepared_stmt_count",      (char*) &show_prepared_stmt_count, SHOW_FUNC},
-  {"Qcache_free_blocks",       (char*) &query_cache.free_memory_blocks, SHOW_LONG_NOFLUSH},
-  {"Qcache_free_memory",       (char*) &query_cache.free_memory, SHOW_LONG_NOFLUSH},
-  {"Qcache_hits",              (char*) &query_cache.hits,       SHOW_LONG},
-  {"Qcache_inserts",           (char*) &query_cache.inserts,    SHOW_LONG},
-  {"Qcache_lowmem_prunes",     (char*) &query_cache.lowmem_prunes, SHOW_LONG},
-  {"Qcache_not_cached",        (char*) &query_cache.refused,    SHOW_LONG},
-  {"Qcache_queries_in_cache",  (char*) &query_cache.queries_in_cache, SHOW_LONG_NOFLUSH},
-  {"Qcache_total_blocks",      (char*) &query_cache.total_blocks, SHOW_LONG_NOFLUSH},
+  {"Qcache_free_blocks",       (char*) &show_qcache_free_blocks, SHOW_FUNC},
+  {"Qcache_free_memory",       (char*) &show_qcache_free_memory, SHOW_FUNC},
+  {"Qcache_hits",              (char*) &show_qcache_hits,       SHOW_FUNC},
+  {"Qcache_inserts",           (char*) &show_qcache_inserts,    SHOW_FUNC},
+  {"Qcache_lock_waits",        (char*) &show_qcache_lock_waits, SHOW_FUNC},
+  {"Qcache_lowmem_prunes",     (char*) &show_qcache_lowmem_prunes, SHOW_FUNC},
+  {"Qcache_not_cached",        (char*) &show_qcache_not_cached, SHOW_FUNC},
+  {"Qcache_partition",         (char*) &show_qcache_partition,  SHOW_FUNC},
+  {"Qcache_queries_in_cache",  (char*) &show_qcache_queries_in_cache, SHOW_FUNC},
+  {"Qcache_total_blocks",      (char*) &show_qcache_total_blocks, SHOW_FUNC},
   {"Queries",                  (char*) &show_queries,            SHOW_FUNC},
   {"Questions",                (char*) offsetof(STATUS_VAR, questions), SHOW_LONGLONG_STATUS},
   {"Select_full_join",         (char*) offsetof(STATUS_VAR, select_full_join_count), SHOW_LONGLONG_STATUS},
@@ -7797,6 +7869,8 @@ void refresh_status(THD *thd)
 
   /* Reset the counters of all key caches (default and named). */
   process_key_caches(reset_key_cache_counters);
+  /* Reset the hit, insert and lock wait counters of the query cache. */
+  query_cache.reset_status();
   flush_status_time= time((time_t*) 0);
   mysql_mutex_unlock(&LOCK_status);
 
@@ -8029,7 +8103,7 @@ static PSI_cond_info all_server_conds[]=
 };
 
 PSI_thread_key key_thread_bootstrap, key_thread_handle_manager, key_thread_main,
-  key_thread_one_connection, key_thread_signal_hand;
+  key_thread_one_connection, key_thread_parallel_sort, key_thread_signal_hand;
 
 static PSI_thread_info all_server_threads[]=
 {
@@ -8047,6 +8121,7 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_handle_manager, "manager", PSI_FLAG_GLOBAL},
   { &key_thread_main, "main", PSI_FLAG_GLOBAL},
   { &key_thread_one_connection, "one_connection", 0},
+  { &key_thread_parallel_sort, "parallel_sort", 0},
   { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL}
 };
 
@@ -8105,6 +8180,10 @@ PSI_stage_info stage_allocating_local_table= { 0, "allocating local table", 0};
 PSI_stage_info stage_alter_inplace_prepare= { 0, "preparing for alter table", 0};
 PSI_stage_info stage_alter_inplace= { 0, "altering table", 0};
 PSI_stage_info stage_alter_inplace_commit= { 0, "committing alter table to storage engine", 0};
+PSI_stage_info stage_binlog_commit= { 0, "Committing binlog group", 0};
+PSI_stage_info stage_binlog_flush= { 0, "Flushing binlog caches", 0};
+PSI_stage_info stage_binlog_sync= { 0, "Syncing binlog", 0};
+PSI_stage_info stage_binlog_write_cache= { 0, "Writing binlog cache", 0};
 PSI_stage_info stage_changing_master= { 0, "Changing master", 0};
 PSI_stage_info stage_checking_master_version= { 0, "Checking master version", 0};
 PSI_stage_info stage_checking_permissions= { 0, "checking permissions", 0};
@@ -8187,6 +8266,7 @@ PSI_stage_info stage_waiting_for_handler_open= { 0, "waiting for handler open",
 PSI_stage_info stage_waiting_for_insert= { 0, "Waiting for INSERT", 0};
 PSI_stage_info stage_waiting_for_master_to_send_event= { 0, "Waiting for master to send event", 0};
 PSI_stage_info stage_waiting_for_master_update= { 0, "Waiting for master update", 0};
+PSI_stage_info stage_waiting_for_binlog_group_commit= { 0, "Waiting for binlog group commit", 0};
 PSI_stage_info stage_waiting_for_relay_log_space= { 0, "Waiting for the slave SQL thread to free enough relay log space", 0};
 PSI_stage_info stage_waiting_for_slave_mutex_on_exit= { 0, "Waiting for slave mutex on exit", 0};
 PSI_stage_info stage_waiting_for_slave_thread_to_start= { 0, "Waiting for slave thread to start", 0};
@@ -8211,6 +8291,10 @@ PSI_stage_info *all_server_stages[]=
   & stage_alter_inplace_prepare,
   & stage_alter_inplace,
   & stage_alter_inplace_commit,
+  & stage_binlog_commit,
+  & stage_binlog_flush,
+  & stage_binlog_sync,
+  & stage_binlog_write_cache,
   & stage_changing_master,
   & stage_checking_master_version,
   & stage_checking_permissions,
@@ -8292,6 +8376,7 @@ PSI_stage_info *all_server_stages[]=
   & stage_waiting_for_insert,
   & stage_waiting_for_master_to_send_event,
   & stage_waiting_for_master_update,
+  & stage_waiting_for_binlog_group_commit,
   & stage_waiting_for_slave_mutex_on_exit,
   & stage_waiting_for_slave_thread_to_start,
   & stage_waiting_for_table_flush,
@@ -8356,6 +8441,7 @@ PSI_memory_key key_memory_Sort_param_tmp_buffer;
 PSI_memory_key key_memory_Filesort_info_buffpek;
 PSI_memory_key key_memory_Filesort_info_record_pointers;
 PSI_memory_key key_memory_SORT_ADDON_FIELD;
+PSI_memory_key key_memory_Filesort_parallel_workers;
 PSI_memory_key key_memory_handler_errmsgs;
 PSI_memory_key key_memory_handlerton;
 PSI_memory_key key_memory_XID;
@@ -8491,6 +8577,7 @@ static PSI_memory_info all_server_memory[]=
   { &key_memory_Filesort_info_record_pointers, "Filesort_info::record_pointers", 0},
   { &key_memory_SORT_ADDON_FIELD, "SORT_ADDON_FIELD", 0},
   { &key_memory_Filesort_buffer_sort_keys, "Filesort_buffer::sort_keys", 0},
+  { &key_memory_Filesort_parallel_workers, "Filesort::parallel_workers", 0},
   { &key_memory_handler_errmsgs, "handler::errmsgs", 0},
   { &key_memory_handlerton, "handlerton", 0},
   { &key_memory_XID, "XID", 0},
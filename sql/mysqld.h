@@ -196,6 +196,7 @@ extern ulong delayed_insert_threads, delayed_insert_writes;
 extern ulong delayed_rows_in_use,delayed_insert_errors;
 extern int32 slave_open_temp_tables;
 extern ulong query_cache_size, query_cache_min_res_unit;
+extern ulong query_cache_partitions;
 extern ulong slow_launch_time;
 extern ulong table_cache_size, table_def_size;
 extern ulong table_cache_size_per_instance, table_cache_instances;
@@ -409,7 +410,7 @@ extern PSI_cond_key key_gtid_ensure_index_cond;
 
 extern PSI_thread_key key_thread_bootstrap,
   key_thread_handle_manager, key_thread_kill_server, key_thread_main,
-  key_thread_one_connection, key_thread_signal_hand;
+  key_thread_one_connection, key_thread_parallel_sort, key_thread_signal_hand;
 
 #ifdef HAVE_MMAP
 extern PSI_file_key key_file_map;
@@ -490,6 +491,7 @@ extern PSI_memory_key key_memory_SORT_ADDON_FIELD;
 extern PSI_memory_key key_memory_Sort_param_tmp_buffer;
 extern PSI_memory_key key_memory_Filesort_info_buffpek;
 extern PSI_memory_key key_memory_Filesort_buffer_sort_keys;
+extern PSI_memory_key key_memory_Filesort_parallel_workers;
 extern PSI_memory_key key_memory_handler_errmsgs;
 extern PSI_memory_key key_memory_handlerton;
 extern PSI_memory_key key_memory_XID;
@@ -576,6 +578,10 @@ extern PSI_stage_info stage_allocating_local_table;
 extern PSI_stage_info stage_alter_inplace_prepare;
 extern PSI_stage_info stage_alter_inplace;
 extern PSI_stage_info stage_alter_inplace_commit;
+extern PSI_stage_info stage_binlog_commit;
+extern PSI_stage_info stage_binlog_flush;
+extern PSI_stage_info stage_binlog_sync;
+extern PSI_stage_info stage_binlog_write_cache;
 extern PSI_stage_info stage_changing_master;
 extern PSI_stage_info stage_checking_master_version;
 extern PSI_stage_info stage_checking_permissions;
@@ -658,6 +664,7 @@ extern PSI_stage_info stage_waiting_for_handler_open;
 extern PSI_stage_info stage_waiting_for_insert;
 extern PSI_stage_info stage_waiting_for_master_to_send_event;
 extern PSI_stage_info stage_waiting_for_master_update;
+extern PSI_stage_info stage_waiting_for_binlog_group_commit;
 extern PSI_stage_info stage_waiting_for_relay_log_space;
 extern PSI_stage_info stage_waiting_for_slave_mutex_on_exit;
 extern PSI_stage_info stage_waiting_for_slave_thread_to_start;
@@ -16,7 +16,12 @@
 /*
   Description of the query cache:
 
-1. Query_cache object consists of
+0. Query_cache object consists of query_cache_partitions
+Query_cache_partition objects. Each statement is stored in and looked
+up from one partition, chosen by the hash of the query text. Table
+invalidation, flushes and packing are applied to all partitions.
+
+1. Query_cache_partition object consists of
 	- query cache memory pool (cache)
 	- queries hash (queries)
 	- tables hash (tables)
@@ -271,13 +276,13 @@ If join_results allocated new block(s) then we need call pack_cache again.
 7. Interface
 The query cache interfaces with the rest of the server code through 7
 functions:
- 1. Query_cache::send_result_to_client
+ 1. Query_cache_partition::send_result_to_client
        - Called before parsing and used to match a statement with the stored
          queries hash.
          If a match is found the cached result set is sent through repeated
          calls to net_write_packet. (note: calling thread doesn't have a regis-
          tered result set writer: thd->net.query_cache_query=0)
- 2. Query_cache::store_query
+ 2. Query_cache_partition::store_query
        - Called just before handle_select() and is used to register a result
          set writer to the statement currently being processed
          (thd->net.query_cache_query).
@@ -285,18 +290,18 @@ functions:
        - Called from net_write_packet to append a result set to a cached query
          if (and only if) this query has a registered result set writer
          (thd->net.query_cache_query).
- 4. Query_cache::invalidate
-    Query_cache::invalidate_locked_for_write
+ 4. Query_cache_partition::invalidate
+    Query_cache_partition::invalidate_locked_for_write
        - Called from various places to invalidate query cache based on data-
          base, table and myisam file name. During an on going invalidation
          the query cache is temporarily disabled.
- 5. Query_cache::flush
+ 5. Query_cache_partition::flush
        - Used when a RESET QUERY CACHE is issued. This clears the entire
          cache block by block.
- 6. Query_cache::resize
+ 6. Query_cache_partition::resize
        - Used to change the available memory used by the query cache. This
          will also invalidate the entrie query cache in one free operation.
- 7. Query_cache::pack
+ 7. Query_cache_partition::pack
        - Used when a FLUSH QUERY CACHE is issued. This changes the order of
          the used memory blocks in physical memory order and move all avail-
          able memory to the 'bottom' of the memory.
@@ -456,26 +461,27 @@ struct Query_cache_wait_state
    @retval TRUE The locking attempt failed
 */
 
-bool Query_cache::try_lock(bool use_timeout)
+bool Query_cache_partition::try_lock(bool use_timeout)
 {
   bool interrupt= FALSE;
+  bool waited= FALSE;
   THD *thd= current_thd;
   Query_cache_wait_state wait_state(thd, __func__, __FILE__, __LINE__);
-  DBUG_ENTER("Query_cache::try_lock");
+  DBUG_ENTER("Query_cache_partition::try_lock");
 
   mysql_mutex_lock(&structure_guard_mutex);
   while (1)
   {
-    if (m_cache_lock_status == Query_cache::UNLOCKED)
+    if (m_cache_lock_status == Query_cache_partition::UNLOCKED)
     {
-      m_cache_lock_status= Query_cache::LOCKED;
+      m_cache_lock_status= Query_cache_partition::LOCKED;
 #ifndef DBUG_OFF
       if (thd)
         m_cache_lock_thread_id= thd->thread_id;
 #endif
       break;
     }
-    else if (m_cache_lock_status == Query_cache::LOCKED_NO_WAIT)
+    else if (m_cache_lock_status == Query_cache_partition::LOCKED_NO_WAIT)
     {
       /*
         If query cache is protected by a LOCKED_NO_WAIT lock this thread
@@ -486,7 +492,12 @@ bool Query_cache::try_lock(bool use_timeout)
     }
     else
     {
-      DBUG_ASSERT(m_cache_lock_status == Query_cache::LOCKED);
+      DBUG_ASSERT(m_cache_lock_status == Query_cache_partition::LOCKED);
+      if (!waited)
+      {
+        lock_waits++;
+        waited= TRUE;
+      }
       /*
         To prevent send_result_to_client() and query_cache_insert() from
         blocking execution for too long a timeout is put on the lock.
@@ -526,16 +537,18 @@ bool Query_cache::try_lock(bool use_timeout)
   It is used by all methods which flushes or destroys the whole cache.
  */
 
-void Query_cache::lock_and_suspend(void)
+void Query_cache_partition::lock_and_suspend(void)
 {
   THD *thd= current_thd;
   Query_cache_wait_state wait_state(thd, __func__, __FILE__, __LINE__);
-  DBUG_ENTER("Query_cache::lock_and_suspend");
+  DBUG_ENTER("Query_cache_partition::lock_and_suspend");
 
   mysql_mutex_lock(&structure_guard_mutex);
-  while (m_cache_lock_status != Query_cache::UNLOCKED)
+  if (m_cache_lock_status != Query_cache_partition::UNLOCKED)
+    lock_waits++;
+  while (m_cache_lock_status != Query_cache_partition::UNLOCKED)
     mysql_cond_wait(&COND_cache_status_changed, &structure_guard_mutex);
-  m_cache_lock_status= Query_cache::LOCKED_NO_WAIT;
+  m_cache_lock_status= Query_cache_partition::LOCKED_NO_WAIT;
 #ifndef DBUG_OFF
   if (thd)
     m_cache_lock_thread_id= thd->thread_id;
@@ -555,16 +568,18 @@ void Query_cache::lock_and_suspend(void)
   It is used by all methods which invalidates one or more tables.
  */
 
-void Query_cache::lock(void)
+void Query_cache_partition::lock(void)
 {
   THD *thd= current_thd;
   Query_cache_wait_state wait_state(thd, __func__, __FILE__, __LINE__);
-  DBUG_ENTER("Query_cache::lock");
+  DBUG_ENTER("Query_cache_partition::lock");
 
   mysql_mutex_lock(&structure_guard_mutex);
-  while (m_cache_lock_status != Query_cache::UNLOCKED)
+  if (m_cache_lock_status != Query_cache_partition::UNLOCKED)
+    lock_waits++;
+  while (m_cache_lock_status != Query_cache_partition::UNLOCKED)
     mysql_cond_wait(&COND_cache_status_changed, &structure_guard_mutex);
-  m_cache_lock_status= Query_cache::LOCKED;
+  m_cache_lock_status= Query_cache_partition::LOCKED;
 #ifndef DBUG_OFF
   if (thd)
     m_cache_lock_thread_id= thd->thread_id;
@@ -579,18 +594,18 @@ void Query_cache::lock(void)
   Set the query cache to UNLOCKED and signal waiting threads.
 */
 
-void Query_cache::unlock(void)
+void Query_cache_partition::unlock(void)
 {
-  DBUG_ENTER("Query_cache::unlock");
+  DBUG_ENTER("Query_cache_partition::unlock");
   mysql_mutex_lock(&structure_guard_mutex);
 #ifndef DBUG_OFF
   THD *thd= current_thd;
   if (thd)
     DBUG_ASSERT(m_cache_lock_thread_id == thd->thread_id);
 #endif
-  DBUG_ASSERT(m_cache_lock_status == Query_cache::LOCKED ||
-              m_cache_lock_status == Query_cache::LOCKED_NO_WAIT);
-  m_cache_lock_status= Query_cache::UNLOCKED;
+  DBUG_ASSERT(m_cache_lock_status == Query_cache_partition::LOCKED ||
+              m_cache_lock_status == Query_cache_partition::LOCKED_NO_WAIT);
+  m_cache_lock_status= Query_cache_partition::UNLOCKED;
   DBUG_PRINT("Query_cache",("Sending signal"));
   mysql_cond_signal(&COND_cache_status_changed);
   mysql_mutex_unlock(&structure_guard_mutex);
@@ -854,14 +869,14 @@ uchar *query_cache_query_get_key(const uchar *record, size_t *length,
   Note on double-check locking (DCL) usage.
 
   Below, in query_cache_insert(), query_cache_abort() and
-  Query_cache::end_of_result() we use what is called double-check
+  Query_cache_partition::end_of_result() we use what is called double-check
   locking (DCL) for Query_cache_tls::first_query_block.
   I.e. we test it first without a lock, and, if positive, test again
   under the lock.
 
   This means that if we see 'first_query_block == 0' without a
   lock we will skip the operation.  But this is safe here: when we
-  started to cache a query, we called Query_cache::store_query(), and
+  started to cache a query, we called Query_cache_partition::store_query(), and
   'first_query_block' was set to non-zero in this thread (and the
   thread always sees results of its memory operations, mutex or not).
   If later we see 'first_query_block == 0' without locking a
@@ -870,8 +885,8 @@ uchar *query_cache_query_get_key(const uchar *record, size_t *length,
   right thing to do, as first_query_block won't get non-zero for
   this query again.
 
-  See also comments in Query_cache::store_query() and
-  Query_cache::send_result_to_client().
+  See also comments in Query_cache_partition::store_query() and
+  Query_cache_partition::send_result_to_client().
 
   NOTE, however, that double-check locking is not applicable in
   'invalidate' functions, as we may erroneously skip invalidation,
@@ -909,14 +924,14 @@ void query_cache_insert(const char *packet, ulong length,
 */
 
 void
-Query_cache::insert(Query_cache_tls *query_cache_tls,
+Query_cache_partition::insert(Query_cache_tls *query_cache_tls,
                     const char *packet, ulong length,
                     unsigned pkt_nr)
 {
-  DBUG_ENTER("Query_cache::insert");
+  DBUG_ENTER("Query_cache_partition::insert");
 
   /* See the comment on double-check locking usage above. */
-  if (is_disabled() || query_cache_tls->first_query_block == NULL)
+  if (query_cache_tls->first_query_block == NULL)
     DBUG_VOID_RETURN;
 
   QC_DEBUG_SYNC("wait_in_query_cache_insert");
@@ -953,8 +968,8 @@ Query_cache::insert(Query_cache_tls *query_cache_tls,
     header->result(result);
     DBUG_PRINT("qcache", ("free query 0x%lx", (ulong) query_block));
     // The following call will remove the lock on query_block
-    query_cache.free_query(query_block);
-    query_cache.refused++;
+    free_query(query_block);
+    refused++;
     // append_result_data no success => we need unlock
     unlock();
     DBUG_VOID_RETURN;
@@ -971,13 +986,13 @@ Query_cache::insert(Query_cache_tls *query_cache_tls,
 
 
 void
-Query_cache::abort(Query_cache_tls *query_cache_tls)
+Query_cache_partition::abort(Query_cache_tls *query_cache_tls)
 {
   DBUG_ENTER("query_cache_abort");
   THD *thd= current_thd;
 
   /* See the comment on double-check locking usage above. */
-  if (is_disabled() || query_cache_tls->first_query_block == NULL)
+  if (query_cache_tls->first_query_block == NULL)
     DBUG_VOID_RETURN;
 
   if (try_lock())
@@ -1005,12 +1020,12 @@ Query_cache::abort(Query_cache_tls *query_cache_tls)
 }
 
 
-void Query_cache::end_of_result(THD *thd)
+void Query_cache_partition::end_of_result(THD *thd)
 {
   Query_cache_block *query_block;
   Query_cache_tls *query_cache_tls= &thd->query_cache_tls;
   ulonglong limit_found_rows= thd->limit_found_rows;
-  DBUG_ENTER("Query_cache::end_of_result");
+  DBUG_ENTER("Query_cache_partition::end_of_result");
 
   /* See the comment on double-check locking usage above. */
   if (query_cache_tls->first_query_block == NULL)
@@ -1065,9 +1080,9 @@ void Query_cache::end_of_result(THD *thd)
     }
     last_result_block= header->result()->prev;
     allign_size= ALIGN_SIZE(last_result_block->used);
-    len= max(query_cache.min_allocation_unit, allign_size);
-    if (last_result_block->length >= query_cache.min_allocation_unit + len)
-      query_cache.split_block(last_result_block,len);
+    len= max(min_allocation_unit, allign_size);
+    if (last_result_block->length >= min_allocation_unit + len)
+      split_block(last_result_block,len);
 
     header->found_rows(limit_found_rows);
     header->result()->type= Query_cache_block::RESULT;
@@ -1102,18 +1117,18 @@ void mysql_query_cache_invalidate4(THD *thd,
 
 
 /*****************************************************************************
-   Query_cache methods
+   Query_cache_partition methods
 *****************************************************************************/
 
-Query_cache::Query_cache(ulong query_cache_limit_arg,
-			 ulong min_allocation_unit_arg,
-			 ulong min_result_data_size_arg,
-			 uint def_query_hash_size_arg,
-			 uint def_table_hash_size_arg)
+Query_cache_partition::Query_cache_partition(ulong query_cache_limit_arg,
+                                             ulong min_allocation_unit_arg,
+                                             ulong min_result_data_size_arg,
+                                             uint def_query_hash_size_arg,
+                                             uint def_table_hash_size_arg)
   :query_cache_size(0),
    query_cache_limit(query_cache_limit_arg),
    queries_in_cache(0), hits(0), inserts(0), refused(0),
-   total_blocks(0), lowmem_prunes(0), m_query_cache_is_disabled(FALSE),
+   total_blocks(0), lowmem_prunes(0), lock_waits(0),
    min_allocation_unit(ALIGN_SIZE(min_allocation_unit_arg)),
    min_result_data_size(ALIGN_SIZE(min_result_data_size_arg)),
    def_query_hash_size(ALIGN_SIZE(def_query_hash_size_arg)),
@@ -1129,10 +1144,10 @@ Query_cache::Query_cache(ulong query_cache_limit_arg,
 }
 
 
-ulong Query_cache::resize(ulong query_cache_size_arg)
+ulong Query_cache_partition::resize(ulong query_cache_size_arg)
 {
   ulong new_query_cache_size;
-  DBUG_ENTER("Query_cache::resize");
+  DBUG_ENTER("Query_cache_partition::resize");
   DBUG_PRINT("qcache", ("from %lu to %lu",query_cache_size,
 			query_cache_size_arg));
   DBUG_ASSERT(initialized);
@@ -1177,7 +1192,7 @@ ulong Query_cache::resize(ulong query_cache_size_arg)
 }
 
 
-ulong Query_cache::set_min_res_unit(ulong size)
+ulong Query_cache_partition::set_min_res_unit(ulong size)
 {
   if (size < min_allocation_unit)
     size= min_allocation_unit;
@@ -1185,11 +1200,11 @@ ulong Query_cache::set_min_res_unit(ulong size)
 }
 
 
-void Query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
+void Query_cache_partition::store_query(THD *thd, TABLE_LIST *tables_used)
 {
   TABLE_COUNTER_TYPE local_tables;
   ulong tot_length;
-  DBUG_ENTER("Query_cache::store_query");
+  DBUG_ENTER("Query_cache_partition::store_query");
   /*
     Testing 'query_cache_size' without a lock here is safe: the thing
     we may loose is that the query won't be cached, but we save on
@@ -1204,7 +1219,7 @@ void Query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
 #ifndef EMBEDDED_LIBRARY
   /*
     Without active vio, net_write_packet() will not be called and
-    therefore neither Query_cache::insert(). Since we will never get a
+    therefore neither Query_cache_partition::insert(). Since we will never get a
     complete query result in this case, it does not make sense to
     register the query in the first place.
   */
@@ -1372,6 +1387,7 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 	inserts++;
 	queries_in_cache++;
 	thd->query_cache_tls.first_query_block= query_block;
+	thd->query_cache_tls.partition= this;
 	header->writer(&thd->query_cache_tls);
 	header->tables_type(tables_type);
 
@@ -1475,7 +1491,7 @@ send_data_in_chunks(NET *net, const uchar *packet, ulong len)
 */
 
 int
-Query_cache::send_result_to_client(THD *thd, char *sql, uint query_length)
+Query_cache_partition::send_result_to_client(THD *thd, char *sql, uint query_length)
 {
   ulonglong engine_data;
   Query_cache_query *query;
@@ -1487,7 +1503,7 @@ Query_cache::send_result_to_client(THD *thd, char *sql, uint query_length)
   ulong tot_length;
   Query_cache_query_flags flags;
   enum xa_states xa_state= thd->transaction.xid_state.xa_state;
-  DBUG_ENTER("Query_cache::send_result_to_client");
+  DBUG_ENTER("Query_cache_partition::send_result_to_client");
 
   /*
     Testing 'query_cache_size' without a lock here is safe: the thing
@@ -1496,7 +1512,7 @@ Query_cache::send_result_to_client(THD *thd, char *sql, uint query_length)
 
     See also a note on double-check locking usage above.
   */
-  if (is_disabled() || thd->locked_tables_mode ||
+  if (thd->locked_tables_mode ||
       thd->variables.query_cache_type == 0 || query_cache_size == 0)
     goto err;
 
@@ -1886,163 +1902,14 @@ err:
 }
 
 
-/**
-  Remove all cached queries that use the given table.
-
-  @param thd                 Thread handle
-  @param table_used          TABLE_LIST representing the table to be
-                             invalidated.
-  @param using_transactions  If we are inside a transaction only add
-                             the table to a list of changed tables for now,
-                             don't invalidate directly. The table will instead
-                             be invalidated once the transaction commits.
-*/
-
-void Query_cache::invalidate_single(THD *thd, TABLE_LIST *table_used,
-                                    my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate_single (table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  DBUG_ASSERT(!using_transactions || table_used->table!=0);
-  if (table_used->derived)
-    DBUG_VOID_RETURN;
-  if (using_transactions &&
-      (table_used->table->file->table_cache_type() ==
-       HA_CACHE_TBL_TRANSACT))
-    /*
-      table_used->table can't be 0 in transaction.
-      Only 'drop' invalidate not opened table, but 'drop'
-      force transaction finish.
-    */
-    thd->add_changed_table(table_used->table);
-  else
-    invalidate_table(thd, table_used);
-
-  DBUG_VOID_RETURN;
-}
-
-/**
-  Remove all cached queries that use any of the tables in the list.
-
-  @see Query_cache::invalidate_single().
-*/
-
-void Query_cache::invalidate(THD *thd, TABLE_LIST *tables_used,
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  for (; tables_used; tables_used= tables_used->next_local)
-    invalidate_single(thd, tables_used, using_transactions);
-
-  DEBUG_SYNC(thd, "wait_after_query_cache_invalidate");
-
-  DBUG_VOID_RETURN;
-}
-
-void Query_cache::invalidate(CHANGED_TABLE_LIST *tables_used)
-{
-  DBUG_ENTER("Query_cache::invalidate (changed table list)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  THD *thd= current_thd;
-  for (; tables_used; tables_used= tables_used->next)
-  {
-    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table_list);
-    invalidate_table(thd, (uchar*) tables_used->key, tables_used->key_length);
-    DBUG_PRINT("qcache", ("db: %s  table: %s", tables_used->key,
-                          tables_used->key+
-                          strlen(tables_used->key)+1));
-  }
-  DBUG_VOID_RETURN;
-}
-
-
-/*
-  Invalidate locked for write
-
-  SYNOPSIS
-    Query_cache::invalidate_locked_for_write()
-    tables_used - table list
-
-  NOTE
-    can be used only for opened tables
-*/
-void Query_cache::invalidate_locked_for_write(TABLE_LIST *tables_used)
-{
-  DBUG_ENTER("Query_cache::invalidate_locked_for_write");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  THD *thd= current_thd;
-  for (; tables_used; tables_used= tables_used->next_local)
-  {
-    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table);
-    if (tables_used->lock_type >= TL_WRITE_ALLOW_WRITE &&
-        tables_used->table)
-    {
-      invalidate_table(thd, tables_used->table);
-    }
-  }
-  DBUG_VOID_RETURN;
-}
-
-/*
-  Remove all cached queries that uses the given table
-*/
-
-void Query_cache::invalidate(THD *thd, TABLE *table, 
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (table)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  if (using_transactions && 
-      (table->file->table_cache_type() == HA_CACHE_TBL_TRANSACT))
-    thd->add_changed_table(table);
-  else
-    invalidate_table(thd, table);
-
-
-  DBUG_VOID_RETURN;
-}
-
-void Query_cache::invalidate(THD *thd, const char *key, uint32  key_length,
-			     my_bool using_transactions)
-{
-  DBUG_ENTER("Query_cache::invalidate (key)");
-  if (is_disabled())
-   DBUG_VOID_RETURN;
-
-  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
-  if (using_transactions) // used for innodb => has_transactions() is TRUE
-    thd->add_changed_table(key, key_length);
-  else
-    invalidate_table(thd, (uchar*)key, key_length);
-
-  DBUG_VOID_RETURN;
-}
-
-
 /**
    Remove all cached queries that uses the given database.
 */
 
-void Query_cache::invalidate(char *db)
+void Query_cache_partition::invalidate(char *db)
 {
   
-  DBUG_ENTER("Query_cache::invalidate (db)");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
+  DBUG_ENTER("Query_cache_partition::invalidate (db)");
 
   bool restart= FALSE;
   /*
@@ -2111,27 +1978,11 @@ void Query_cache::invalidate(char *db)
 }
 
 
-void Query_cache::invalidate_by_MyISAM_filename(const char *filename)
-{
-  DBUG_ENTER("Query_cache::invalidate_by_MyISAM_filename");
-
-  /* Calculate the key outside the lock to make the lock shorter */
-  char key[MAX_DBKEY_LENGTH];
-  uint32 db_length;
-  uint key_length= filename_2_table_key(key, filename, &db_length);
-  THD *thd= current_thd;
-  invalidate_table(thd,(uchar *)key, key_length);
-  DBUG_EXECUTE("check_querycache", check_integrity(LOCK_WHILE_CHECKING););
-  DBUG_VOID_RETURN;
-}
-
   /* Remove all queries from cache */
 
-void Query_cache::flush()
+void Query_cache_partition::flush()
 {
-  DBUG_ENTER("Query_cache::flush");
-  if (is_disabled())
-    DBUG_VOID_RETURN;
+  DBUG_ENTER("Query_cache_partition::flush");
 
   QC_DEBUG_SYNC("wait_in_query_cache_flush1");
 
@@ -2159,12 +2010,9 @@ void Query_cache::flush()
 
 */
 
-void Query_cache::pack(ulong join_limit, uint iteration_limit)
+void Query_cache_partition::pack(ulong join_limit, uint iteration_limit)
 {
-  DBUG_ENTER("Query_cache::pack");
-
-  if (is_disabled())
-    DBUG_VOID_RETURN;
+  DBUG_ENTER("Query_cache_partition::pack");
 
   /*
     If the entire qc is being invalidated we can bail out early
@@ -2190,9 +2038,9 @@ void Query_cache::pack(ulong join_limit, uint iteration_limit)
 }
 
 
-void Query_cache::destroy()
+void Query_cache_partition::destroy()
 {
-  DBUG_ENTER("Query_cache::destroy");
+  DBUG_ENTER("Query_cache_partition::destroy");
   if (!initialized)
   {
     DBUG_PRINT("qcache", ("Query Cache not initialized"));
@@ -2216,36 +2064,27 @@ void Query_cache::destroy()
   init/destroy
 *****************************************************************************/
 
-void Query_cache::init()
+void Query_cache_partition::init()
 {
-  DBUG_ENTER("Query_cache::init");
+  DBUG_ENTER("Query_cache_partition::init");
   mysql_mutex_init(key_structure_guard_mutex,
                    &structure_guard_mutex, MY_MUTEX_INIT_FAST);
   mysql_cond_init(key_COND_cache_status_changed,
                   &COND_cache_status_changed, NULL);
-  m_cache_lock_status= Query_cache::UNLOCKED;
+  m_cache_lock_status= Query_cache_partition::UNLOCKED;
   initialized = 1;
-  /*
-    If we explicitly turn off query cache from the command line query cache will
-    be disabled for the reminder of the server life time. This is because we
-    want to avoid locking the QC specific mutex if query cache isn't going to
-    be used.
-  */
-  if (global_system_variables.query_cache_type == 0)
-    query_cache.disable_query_cache();
-
   DBUG_VOID_RETURN;
 }
 
 
-ulong Query_cache::init_cache()
+ulong Query_cache_partition::init_cache()
 {
   uint mem_bin_count, num, step;
   ulong mem_bin_size, prev_size, inc;
   ulong additional_data_size, max_mem_bin_size, approx_additional_data_size;
   int align;
 
-  DBUG_ENTER("Query_cache::init_cache");
+  DBUG_ENTER("Query_cache_partition::init_cache");
 
   approx_additional_data_size = (/* FIXME: WHAT FOR ? sizeof(Query_cache) + */
 				 sizeof(uchar*)*(def_query_hash_size+
@@ -2415,9 +2254,9 @@ err:
 
 /* Disable the use of the query cache */
 
-void Query_cache::make_disabled()
+void Query_cache_partition::make_disabled()
 {
-  DBUG_ENTER("Query_cache::make_disabled");
+  DBUG_ENTER("Query_cache_partition::make_disabled");
   query_cache_size= 0;
   queries_blocks= 0;
   free_memory= 0;
@@ -2443,9 +2282,9 @@ void Query_cache::make_disabled()
   requires the structure_guard_mutex to be locked.
 */
 
-void Query_cache::free_cache()
+void Query_cache_partition::free_cache()
 {
-  DBUG_ENTER("Query_cache::free_cache");
+  DBUG_ENTER("Query_cache_partition::free_cache");
 
   my_free(cache);
   make_disabled();
@@ -2472,7 +2311,7 @@ void Query_cache::free_cache()
   state could have been changed, and should not be relied on.
 */
 
-void Query_cache::flush_cache()
+void Query_cache_partition::flush_cache()
 {
   QC_DEBUG_SYNC("wait_in_query_cache_flush2");
 
@@ -2489,9 +2328,9 @@ void Query_cache::flush_cache()
   Returns 1 if we couldn't remove anything
 */
 
-my_bool Query_cache::free_old_query()
+my_bool Query_cache_partition::free_old_query()
 {
-  DBUG_ENTER("Query_cache::free_old_query");
+  DBUG_ENTER("Query_cache_partition::free_old_query");
   if (queries_blocks)
   {
     /*
@@ -2546,9 +2385,9 @@ my_bool Query_cache::free_old_query()
     calling this method, as the lock will be destroyed here.
 */
 
-void Query_cache::free_query_internal(Query_cache_block *query_block)
+void Query_cache_partition::free_query_internal(Query_cache_block *query_block)
 {
-  DBUG_ENTER("Query_cache::free_query_internal");
+  DBUG_ENTER("Query_cache_partition::free_query_internal");
   DBUG_PRINT("qcache", ("free query 0x%lx %lu bytes result",
 		      (ulong) query_block,
 		      query_block->query()->length() ));
@@ -2616,9 +2455,9 @@ void Query_cache::free_query_internal(Query_cache_block *query_block)
     then call free_query_internal(), which see.
 */
 
-void Query_cache::free_query(Query_cache_block *query_block)
+void Query_cache_partition::free_query(Query_cache_block *query_block)
 {
-  DBUG_ENTER("Query_cache::free_query");
+  DBUG_ENTER("Query_cache_partition::free_query");
   DBUG_PRINT("qcache", ("free query 0x%lx %lu bytes result",
 		      (ulong) query_block,
 		      query_block->query()->length() ));
@@ -2634,7 +2473,7 @@ void Query_cache::free_query(Query_cache_block *query_block)
 *****************************************************************************/
 
 Query_cache_block *
-Query_cache::write_block_data(ulong data_len, uchar* data,
+Query_cache_partition::write_block_data(ulong data_len, uchar* data,
 			      ulong header_len,
 			      Query_cache_block::block_type type,
 			      TABLE_COUNTER_TYPE ntab)
@@ -2644,7 +2483,7 @@ Query_cache::write_block_data(ulong data_len, uchar* data,
 			   header_len);
   ulong len = data_len + all_headers_len;
   ulong align_len= ALIGN_SIZE(len);
-  DBUG_ENTER("Query_cache::write_block_data");
+  DBUG_ENTER("Query_cache_partition::write_block_data");
   DBUG_PRINT("qcache", ("data: %ld, header: %ld, all header: %ld",
 		      data_len, header_len, all_headers_len));
   Query_cache_block *block= allocate_block(max(align_len,
@@ -2662,11 +2501,11 @@ Query_cache::write_block_data(ulong data_len, uchar* data,
 
 
 my_bool
-Query_cache::append_result_data(Query_cache_block **current_block,
+Query_cache_partition::append_result_data(Query_cache_block **current_block,
 				ulong data_len, uchar* data,
 				Query_cache_block *query_block)
 {
-  DBUG_ENTER("Query_cache::append_result_data");
+  DBUG_ENTER("Query_cache_partition::append_result_data");
   DBUG_PRINT("qcache", ("append %lu bytes to 0x%lx query",
 		      data_len, (long) query_block));
 
@@ -2740,12 +2579,12 @@ Query_cache::append_result_data(Query_cache_block **current_block,
 }
 
 
-my_bool Query_cache::write_result_data(Query_cache_block **result_block,
+my_bool Query_cache_partition::write_result_data(Query_cache_block **result_block,
 				       ulong data_len, uchar* data,
 				       Query_cache_block *query_block,
 				       Query_cache_block::block_type type)
 {
-  DBUG_ENTER("Query_cache::write_result_data");
+  DBUG_ENTER("Query_cache_partition::write_result_data");
   DBUG_PRINT("qcache", ("data_len %lu",data_len));
 
   /*
@@ -2813,7 +2652,7 @@ my_bool Query_cache::write_result_data(Query_cache_block **result_block,
   DBUG_RETURN(success);
 }
 
-inline ulong Query_cache::get_min_first_result_data_size()
+inline ulong Query_cache_partition::get_min_first_result_data_size()
 {
   if (queries_in_cache < QUERY_CACHE_MIN_ESTIMATED_QUERIES_NUMBER)
     return min_result_data_size;
@@ -2822,7 +2661,7 @@ inline ulong Query_cache::get_min_first_result_data_size()
   return max(min_result_data_size, avg_result);
 }
 
-inline ulong Query_cache::get_min_append_result_data_size()
+inline ulong Query_cache_partition::get_min_append_result_data_size()
 {
   return min_result_data_size;
 }
@@ -2830,7 +2669,7 @@ inline ulong Query_cache::get_min_append_result_data_size()
 /*
   Allocate one or more blocks to hold data
 */
-my_bool Query_cache::allocate_data_chain(Query_cache_block **result_block,
+my_bool Query_cache_partition::allocate_data_chain(Query_cache_block **result_block,
 					 ulong data_len,
 					 Query_cache_block *query_block,
 					 my_bool first_block_arg)
@@ -2842,7 +2681,7 @@ my_bool Query_cache::allocate_data_chain(Query_cache_block **result_block,
 		    get_min_append_result_data_size());
   Query_cache_block *prev_block= NULL;
   Query_cache_block *new_block;
-  DBUG_ENTER("Query_cache::allocate_data_chain");
+  DBUG_ENTER("Query_cache_partition::allocate_data_chain");
   DBUG_PRINT("qcache", ("data_len %lu, all_headers_len %lu",
 			data_len, all_headers_len));
 
@@ -2895,7 +2734,7 @@ my_bool Query_cache::allocate_data_chain(Query_cache_block **result_block,
   Invalidate the first table in the table_list
 */
 
-void Query_cache::invalidate_table(THD *thd, TABLE_LIST *table_list)
+void Query_cache_partition::invalidate_table(THD *thd, TABLE_LIST *table_list)
 {
   if (table_list->table != 0)
     invalidate_table(thd, table_list->table);	// Table is open
@@ -2910,13 +2749,13 @@ void Query_cache::invalidate_table(THD *thd, TABLE_LIST *table_list)
   }
 }
 
-void Query_cache::invalidate_table(THD *thd, TABLE *table)
+void Query_cache_partition::invalidate_table(THD *thd, TABLE *table)
 {
   invalidate_table(thd, (uchar*) table->s->table_cache_key.str,
                    table->s->table_cache_key.length);
 }
 
-void Query_cache::invalidate_table(THD *thd, uchar * key, uint32  key_length)
+void Query_cache_partition::invalidate_table(THD *thd, uchar * key, uint32  key_length)
 {
   DEBUG_SYNC(thd, "wait_in_query_cache_invalidate1");
 
@@ -2944,7 +2783,7 @@ void Query_cache::invalidate_table(THD *thd, uchar * key, uint32  key_length)
 */
 
 void
-Query_cache::invalidate_table_internal(THD *thd, uchar *key, uint32 key_length)
+Query_cache_partition::invalidate_table_internal(THD *thd, uchar *key, uint32 key_length)
 {
   Query_cache_block *table_block=
     (Query_cache_block*)my_hash_search(&tables, key, key_length);
@@ -2968,7 +2807,7 @@ Query_cache::invalidate_table_internal(THD *thd, uchar *key, uint32 key_length)
 */
 
 void
-Query_cache::invalidate_query_block_list(THD *thd,
+Query_cache_partition::invalidate_query_block_list(THD *thd,
                                          Query_cache_block_table *list_root)
 {
   while (list_root->next != list_root)
@@ -2984,7 +2823,7 @@ Query_cache::invalidate_query_block_list(THD *thd,
   block
 
   SYNOPSIS
-    Query_cache::register_tables_from_list
+    Query_cache_partition::register_tables_from_list
     tables_used     given table list
     counter         number current position in table of tables of block
     block_table     pointer to current position in tables table of block
@@ -2995,12 +2834,12 @@ Query_cache::invalidate_query_block_list(THD *thd,
 */
 
 TABLE_COUNTER_TYPE
-Query_cache::register_tables_from_list(TABLE_LIST *tables_used,
+Query_cache_partition::register_tables_from_list(TABLE_LIST *tables_used,
                                        TABLE_COUNTER_TYPE counter,
                                        Query_cache_block_table *block_table)
 {
   TABLE_COUNTER_TYPE n;
-  DBUG_ENTER("Query_cache::register_tables_from_list");
+  DBUG_ENTER("Query_cache_partition::register_tables_from_list");
   for (n= counter;
        tables_used;
        tables_used= tables_used->next_global, n++, block_table++)
@@ -3094,7 +2933,7 @@ Query_cache::register_tables_from_list(TABLE_LIST *tables_used,
     tables_arg		Not used ?
 */
 
-my_bool Query_cache::register_all_tables(Query_cache_block *block,
+my_bool Query_cache_partition::register_all_tables(Query_cache_block *block,
 					 TABLE_LIST *tables_used,
 					 TABLE_COUNTER_TYPE tables_arg)
 {
@@ -3128,13 +2967,13 @@ my_bool Query_cache::register_all_tables(Query_cache_block *block,
 */
 
 my_bool
-Query_cache::insert_table(uint key_len, const char *key,
+Query_cache_partition::insert_table(uint key_len, const char *key,
 			  Query_cache_block_table *node,
 			  uint32 db_length, uint8 cache_type,
                           qc_engine_callback callback,
                           ulonglong engine_data)
 {
-  DBUG_ENTER("Query_cache::insert_table");
+  DBUG_ENTER("Query_cache_partition::insert_table");
   DBUG_PRINT("qcache", ("insert table node 0x%lx, len %d",
 		      (ulong)node, key_len));
 
@@ -3233,9 +3072,9 @@ Query_cache::insert_table(uint key_len, const char *key,
 }
 
 
-void Query_cache::unlink_table(Query_cache_block_table *node)
+void Query_cache_partition::unlink_table(Query_cache_block_table *node)
 {
-  DBUG_ENTER("Query_cache::unlink_table");
+  DBUG_ENTER("Query_cache_partition::unlink_table");
   node->prev->next= node->next;
   node->next->prev= node->prev;
   Query_cache_block_table *neighbour= node->next;
@@ -3268,9 +3107,9 @@ void Query_cache::unlink_table(Query_cache_block_table *node)
 *****************************************************************************/
 
 Query_cache_block *
-Query_cache::allocate_block(ulong len, my_bool not_less, ulong minimum)
+Query_cache_partition::allocate_block(ulong len, my_bool not_less, ulong minimum)
 {
-  DBUG_ENTER("Query_cache::allocate_block");
+  DBUG_ENTER("Query_cache_partition::allocate_block");
   DBUG_PRINT("qcache", ("len %lu, not less %d, min %lu",
              len, not_less, minimum));
 
@@ -3300,10 +3139,10 @@ Query_cache::allocate_block(ulong len, my_bool not_less, ulong minimum)
 
 
 Query_cache_block *
-Query_cache::get_free_block(ulong len, my_bool not_less, ulong min)
+Query_cache_partition::get_free_block(ulong len, my_bool not_less, ulong min)
 {
   Query_cache_block *block = 0, *first = 0;
-  DBUG_ENTER("Query_cache::get_free_block");
+  DBUG_ENTER("Query_cache_partition::get_free_block");
   DBUG_PRINT("qcache",("length %lu, not_less %d, min %lu", len,
 		     (int)not_less, min));
 
@@ -3376,9 +3215,9 @@ Query_cache::get_free_block(ulong len, my_bool not_less, ulong min)
 }
 
 
-void Query_cache::free_memory_block(Query_cache_block *block)
+void Query_cache_partition::free_memory_block(Query_cache_block *block)
 {
-  DBUG_ENTER("Query_cache::free_memory_block");
+  DBUG_ENTER("Query_cache_partition::free_memory_block");
   block->used=0;
   block->type= Query_cache_block::FREE; // mark block as free in any case
   DBUG_PRINT("qcache",
@@ -3395,9 +3234,9 @@ void Query_cache::free_memory_block(Query_cache_block *block)
 }
 
 
-void Query_cache::split_block(Query_cache_block *block, ulong len)
+void Query_cache_partition::split_block(Query_cache_block *block, ulong len)
 {
-  DBUG_ENTER("Query_cache::split_block");
+  DBUG_ENTER("Query_cache_partition::split_block");
   Query_cache_block *new_block = (Query_cache_block*)(((uchar*) block)+len);
 
   new_block->init(block->length - len);
@@ -3423,11 +3262,11 @@ void Query_cache::split_block(Query_cache_block *block, ulong len)
 
 
 Query_cache_block *
-Query_cache::join_free_blocks(Query_cache_block *first_block_arg,
+Query_cache_partition::join_free_blocks(Query_cache_block *first_block_arg,
 			      Query_cache_block *block_in_list)
 {
   Query_cache_block *second_block;
-  DBUG_ENTER("Query_cache::join_free_blocks");
+  DBUG_ENTER("Query_cache_partition::join_free_blocks");
   DBUG_PRINT("qcache",
 	     ("join first 0x%lx, pnext 0x%lx, in list 0x%lx",
 	      (ulong) first_block_arg, (ulong) first_block_arg->pnext,
@@ -3448,11 +3287,11 @@ Query_cache::join_free_blocks(Query_cache_block *first_block_arg,
 }
 
 
-my_bool Query_cache::append_next_free_block(Query_cache_block *block,
+my_bool Query_cache_partition::append_next_free_block(Query_cache_block *block,
 					    ulong add_size)
 {
   Query_cache_block *next_block = block->pnext;
-  DBUG_ENTER("Query_cache::append_next_free_block");
+  DBUG_ENTER("Query_cache_partition::append_next_free_block");
   DBUG_PRINT("enter", ("block 0x%lx, add_size %lu", (ulong) block,
 		       add_size));
 
@@ -3476,9 +3315,9 @@ my_bool Query_cache::append_next_free_block(Query_cache_block *block,
 }
 
 
-void Query_cache::exclude_from_free_memory_list(Query_cache_block *free_block)
+void Query_cache_partition::exclude_from_free_memory_list(Query_cache_block *free_block)
 {
-  DBUG_ENTER("Query_cache::exclude_from_free_memory_list");
+  DBUG_ENTER("Query_cache_partition::exclude_from_free_memory_list");
   Query_cache_memory_bin *bin = *((Query_cache_memory_bin **)
 				  free_block->data());
   double_linked_list_exclude(free_block, &bin->free_blocks);
@@ -3490,9 +3329,9 @@ void Query_cache::exclude_from_free_memory_list(Query_cache_block *free_block)
   DBUG_VOID_RETURN;
 }
 
-void Query_cache::insert_into_free_memory_list(Query_cache_block *free_block)
+void Query_cache_partition::insert_into_free_memory_list(Query_cache_block *free_block)
 {
-  DBUG_ENTER("Query_cache::insert_into_free_memory_list");
+  DBUG_ENTER("Query_cache_partition::insert_into_free_memory_list");
   uint idx = find_bin(free_block->length);
   insert_into_free_memory_sorted_list(free_block, &bins[idx].free_blocks);
   /*
@@ -3508,9 +3347,9 @@ void Query_cache::insert_into_free_memory_list(Query_cache_block *free_block)
   DBUG_VOID_RETURN;
 }
 
-uint Query_cache::find_bin(ulong size)
+uint Query_cache_partition::find_bin(ulong size)
 {
-  DBUG_ENTER("Query_cache::find_bin");
+  DBUG_ENTER("Query_cache_partition::find_bin");
   // Binary search
   int left = 0, right = mem_bin_steps;
   do
@@ -3540,21 +3379,21 @@ uint Query_cache::find_bin(ulong size)
  Lists management
 *****************************************************************************/
 
-void Query_cache::move_to_query_list_end(Query_cache_block *query_block)
+void Query_cache_partition::move_to_query_list_end(Query_cache_block *query_block)
 {
-  DBUG_ENTER("Query_cache::move_to_query_list_end");
+  DBUG_ENTER("Query_cache_partition::move_to_query_list_end");
   double_linked_list_exclude(query_block, &queries_blocks);
   double_linked_list_simple_include(query_block, &queries_blocks);
   DBUG_VOID_RETURN;
 }
 
 
-void Query_cache::insert_into_free_memory_sorted_list(Query_cache_block *
+void Query_cache_partition::insert_into_free_memory_sorted_list(Query_cache_block *
 						      new_block,
 						      Query_cache_block **
 						      list)
 {
-  DBUG_ENTER("Query_cache::insert_into_free_memory_sorted_list");
+  DBUG_ENTER("Query_cache_partition::insert_into_free_memory_sorted_list");
   /*
      list sorted by size in ascendant order, because we need small blocks
      more frequently than bigger ones
@@ -3596,11 +3435,11 @@ void Query_cache::insert_into_free_memory_sorted_list(Query_cache_block *
 
 
 void
-Query_cache::double_linked_list_simple_include(Query_cache_block *point,
+Query_cache_partition::double_linked_list_simple_include(Query_cache_block *point,
 						Query_cache_block **
 						list_pointer)
 {
-  DBUG_ENTER("Query_cache::double_linked_list_simple_include");
+  DBUG_ENTER("Query_cache_partition::double_linked_list_simple_include");
   DBUG_PRINT("qcache", ("including block 0x%lx", (ulong) point));
   if (*list_pointer == 0)
     *list_pointer=point->next=point->prev=point;
@@ -3616,10 +3455,10 @@ Query_cache::double_linked_list_simple_include(Query_cache_block *point,
 }
 
 void
-Query_cache::double_linked_list_exclude(Query_cache_block *point,
+Query_cache_partition::double_linked_list_exclude(Query_cache_block *point,
 					Query_cache_block **list_pointer)
 {
-  DBUG_ENTER("Query_cache::double_linked_list_exclude");
+  DBUG_ENTER("Query_cache_partition::double_linked_list_exclude");
   DBUG_PRINT("qcache", ("excluding block 0x%lx, list 0x%lx",
 		      (ulong) point, (ulong) list_pointer));
   if (point->next == point)
@@ -3638,7 +3477,7 @@ Query_cache::double_linked_list_exclude(Query_cache_block *point,
 }
 
 
-void Query_cache::double_linked_list_join(Query_cache_block *head_tail,
+void Query_cache_partition::double_linked_list_join(Query_cache_block *head_tail,
 					  Query_cache_block *tail_head)
 {
   Query_cache_block *head_head = head_tail->next,
@@ -3668,7 +3507,7 @@ void Query_cache::double_linked_list_join(Query_cache_block *head_tail,
 */
 
 TABLE_COUNTER_TYPE
-Query_cache::process_and_count_tables(THD *thd, TABLE_LIST *tables_used,
+Query_cache_partition::process_and_count_tables(THD *thd, TABLE_LIST *tables_used,
                                       uint8 *tables_type)
 {
   DBUG_ENTER("process_and_count_tables");
@@ -3762,12 +3601,12 @@ Query_cache::process_and_count_tables(THD *thd, TABLE_LIST *tables_used,
 */
 
 TABLE_COUNTER_TYPE
-Query_cache::is_cacheable(THD *thd, size_t query_len, const char *query,
+Query_cache_partition::is_cacheable(THD *thd, size_t query_len, const char *query,
                           LEX *lex,
                           TABLE_LIST *tables_used, uint8 *tables_type)
 {
   TABLE_COUNTER_TYPE table_count;
-  DBUG_ENTER("Query_cache::is_cacheable");
+  DBUG_ENTER("Query_cache_partition::is_cacheable");
 
   if (lex->sql_command == SQLCOM_SELECT &&
       lex->safe_to_cache_query &&
@@ -3808,7 +3647,7 @@ Query_cache::is_cacheable(THD *thd, size_t query_len, const char *query,
   Check handler allowance to cache query with these tables
 
   SYNOPSYS
-    Query_cache::ask_handler_allowance()
+    Query_cache_partition::ask_handler_allowance()
     thd - thread handlers
     tables_used - tables list used in query
 
@@ -3816,10 +3655,10 @@ Query_cache::is_cacheable(THD *thd, size_t query_len, const char *query,
     0 - caching allowed
     1 - caching disallowed
 */
-my_bool Query_cache::ask_handler_allowance(THD *thd,
+my_bool Query_cache_partition::ask_handler_allowance(THD *thd,
 					   TABLE_LIST *tables_used)
 {
-  DBUG_ENTER("Query_cache::ask_handler_allowance");
+  DBUG_ENTER("Query_cache_partition::ask_handler_allowance");
 
   for (; tables_used; tables_used= tables_used->next_global)
   {
@@ -3845,7 +3684,7 @@ my_bool Query_cache::ask_handler_allowance(THD *thd,
       We're skipping a special case here (MERGE VIEW on top of a TEMPTABLE
       view). This is MyISAMly safe because we know it's not a user-created
       TEMPTABLE as those are guarded against in
-      Query_cache::process_and_count_tables(), and schema-tables clear
+      Query_cache_partition::process_and_count_tables(), and schema-tables clear
       safe_to_cache_query. This implies that nobody else will change our
       TEMPTABLE while we're using it, so calling register_query_cache_table()
       in MyISAM to check on it is pointless. Finally, we should see the
@@ -3879,12 +3718,12 @@ my_bool Query_cache::ask_handler_allowance(THD *thd,
 /**
   Rearrange all memory blocks so that free memory joins at the
   'bottom' of the allocated memory block containing all cache data.
-  @see Query_cache::pack(ulong join_limit, uint iteration_limit)
+  @see Query_cache_partition::pack(ulong join_limit, uint iteration_limit)
 */
 
-void Query_cache::pack_cache()
+void Query_cache_partition::pack_cache()
 {
-  DBUG_ENTER("Query_cache::pack_cache");
+  DBUG_ENTER("Query_cache_partition::pack_cache");
 
   DBUG_EXECUTE("check_querycache", check_integrity(CALLER_HOLDS_LOCK););
 
@@ -3923,11 +3762,11 @@ void Query_cache::pack_cache()
 }
 
 
-my_bool Query_cache::move_by_type(uchar **border,
+my_bool Query_cache_partition::move_by_type(uchar **border,
 				  Query_cache_block **before, ulong *gap,
 				  Query_cache_block *block)
 {
-  DBUG_ENTER("Query_cache::move_by_type");
+  DBUG_ENTER("Query_cache_partition::move_by_type");
 
   my_bool ok = 1;
   switch (block->type) {
@@ -4107,13 +3946,13 @@ my_bool Query_cache::move_by_type(uchar **border,
   case Query_cache_block::RES_CONT:
   case Query_cache_block::RESULT:
   {
-    DBUG_PRINT("qcache", ("block 0x%lx RES* (%d)", (ulong) block,
-               (int) block->type));
-    if (*border == 0)
-      break;
-    Query_cache_block *query_block= block->result()->parent();
-    BLOCK_LOCK_WR(query_block);
-    Query_cache_block *next= block->next, *prev= block->prev;
+    DBUG_PRINT("qcache", ("block 0x%lx RES* (%d)", (ulong) block,
+               (int) block->type));
+    if (*border == 0)
+      break;
+    Query_cache_block *query_block= block->result()->parent();
+    BLOCK_LOCK_WR(query_block);
+    Query_cache_block *next= block->next, *prev= block->prev;
     Query_cache_block::block_type type= block->type;
     ulong len = block->length, used = block->used;
     Query_cache_block *pprev = block->pprev,
@@ -4160,7 +3999,7 @@ my_bool Query_cache::move_by_type(uchar **border,
 }
 
 
-void Query_cache::relink(Query_cache_block *oblock,
+void Query_cache_partition::relink(Query_cache_block *oblock,
 			 Query_cache_block *nblock,
 			 Query_cache_block *next, Query_cache_block *prev,
 			 Query_cache_block *pnext, Query_cache_block *pprev)
@@ -4187,10 +4026,10 @@ void Query_cache::relink(Query_cache_block *oblock,
 }
 
 
-my_bool Query_cache::join_results(ulong join_limit)
+my_bool Query_cache_partition::join_results(ulong join_limit)
 {
   my_bool has_moving = 0;
-  DBUG_ENTER("Query_cache::join_results");
+  DBUG_ENTER("Query_cache_partition::join_results");
 
   if (queries_blocks != 0)
   {
@@ -4259,11 +4098,11 @@ my_bool Query_cache::join_results(ulong join_limit)
 }
 
 
-uint Query_cache::filename_2_table_key (char *key, const char *path,
+uint Query_cache_partition::filename_2_table_key (char *key, const char *path,
 					uint32 *db_length)
 {
   char tablename[FN_REFLEN+2], *filename, *dbname;
-  DBUG_ENTER("Query_cache::filename_2_table_key");
+  DBUG_ENTER("Query_cache_partition::filename_2_table_key");
 
   /* Safety if filename didn't have a directory name */
   tablename[0]= FN_LIBCHAR;
@@ -4282,39 +4121,499 @@ uint Query_cache::filename_2_table_key (char *key, const char *path,
                                 filename, NAME_LEN) - key) + 1);
 }
 
-/****************************************************************************
-  Functions to be used when debugging
-****************************************************************************/
+/*****************************************************************************
+  Query_cache methods
+*****************************************************************************/
 
-#if defined(DBUG_OFF) || !defined(EXTRA_DEBUG)
+Query_cache::Query_cache()
+  :query_cache_size(0), query_cache_limit(ULONG_MAX),
+   partitions(NULL), n_partitions(0), m_query_cache_is_disabled(FALSE),
+   m_status_vars(NULL)
+{
+}
 
-void Query_cache::wreck(uint line, const char *message) { query_cache_size = 0; }
-void Query_cache::bins_dump() {}
-void Query_cache::cache_dump() {}
-void Query_cache::queries_dump() {}
-void Query_cache::tables_dump() {}
-bool Query_cache::check_integrity(enum_qcci_lock_mode locking) { return false; }
-my_bool Query_cache::in_list(Query_cache_block *root, Query_cache_block *point,
-                             const char *name) { return 0;}
-my_bool Query_cache::in_blocks(Query_cache_block * point) { return 0; }
 
-#else
+/**
+  Create the partitions of the query cache and the per partition status
+  variables.
 
+  @param n_partitions_arg  Number of partitions (query_cache_partitions)
+*/
 
-/*
-  Debug method which switch query cache off but left content for
-  investigation.
+void Query_cache::init(uint n_partitions_arg)
+{
+  static const struct
+  {
+    const char *name;
+    ulong Query_cache_partition::*counter;
+  } partition_status[]=
+  {
+    {"hits",             &Query_cache_partition::hits},
+    {"inserts",          &Query_cache_partition::inserts},
+    {"lock_waits",       &Query_cache_partition::lock_waits},
+    {"not_cached",       &Query_cache_partition::refused},
+    {"queries_in_cache", &Query_cache_partition::queries_in_cache}
+  };
+  const size_t name_size= 32;
+  DBUG_ENTER("Query_cache::init");
+  DBUG_ASSERT(partitions == NULL);
 
-  SYNOPSIS
-    Query_cache::wreck()
-    line                 line of the wreck() call
-    message              message for logging
+  n_partitions= max(n_partitions_arg, 1U);
+  partitions= new Query_cache_partition[n_partitions];
+  for (uint i= 0; i < n_partitions; i++)
+  {
+    partitions[i].init();
+    partitions[i].result_size_limit(query_cache_limit);
+  }
+
+  uint n_vars= n_partitions * array_elements(partition_status);
+  m_status_vars= (SHOW_VAR *) my_malloc(key_memory_Query_cache,
+                                        (n_vars + 1) *
+                                        (sizeof(SHOW_VAR) + name_size),
+                                        MYF(MY_WME));
+  if (m_status_vars)
+  {
+    SHOW_VAR *var= m_status_vars;
+    char *name= (char *) (m_status_vars + n_vars + 1);
+    for (uint i= 0; i < n_partitions; i++)
+    {
+      for (uint j= 0; j < array_elements(partition_status); j++)
+      {
+        my_snprintf(name, name_size, "%u_%s", i, partition_status[j].name);
+        var->name= name;
+        var->value= (char *) &(partitions[i].*partition_status[j].counter);
+        var->type= SHOW_LONG;
+        var++;
+        name+= name_size;
+      }
+    }
+    var->name= NullS;
+    var->value= NullS;
+    var->type= SHOW_LONG;
+  }
+
+  /*
+    If we explicitly turn off query cache from the command line query cache will
+    be disabled for the reminder of the server life time. This is because we
+    want to avoid locking the QC specific mutex if query cache isn't going to
+    be used.
+  */
+  if (global_system_variables.query_cache_type == 0)
+    disable_query_cache();
+
+  DBUG_VOID_RETURN;
+}
+
+
+void Query_cache::destroy()
+{
+  DBUG_ENTER("Query_cache::destroy");
+  if (partitions)
+  {
+    for (uint i= 0; i < n_partitions; i++)
+      partitions[i].destroy();
+    delete [] partitions;
+    partitions= NULL;
+    n_partitions= 0;
+  }
+  my_free(m_status_vars);
+  m_status_vars= NULL;
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Pick the partition for a statement.
+
+  Only the query text is hashed: the database name and the flags that
+  complete the lookup key are written after it by store_query() and
+  send_result_to_client(), so both see the same partition. The low bits
+  of the query hash function are poorly mixed, so a CRC-32 is used.
 */
 
-void Query_cache::wreck(uint line, const char *message)
+Query_cache_partition *Query_cache::get_partition(const char *query,
+                                                  size_t length)
+{
+  if (n_partitions == 1)
+    return partitions;
+
+  ha_checksum hash= my_checksum(0, (const uchar *) query, length);
+  return &partitions[hash % n_partitions];
+}
+
+
+/**
+  Split the cache memory evenly between the partitions; the first
+  partition gets the remainder.
+
+  @return Total size of the partitions, 0 if the cache is disabled
+*/
+
+ulong Query_cache::resize(ulong query_cache_size_arg)
+{
+  ulong new_query_cache_size= 0;
+  ulong partition_size= query_cache_size_arg / n_partitions;
+  DBUG_ENTER("Query_cache::resize");
+  DBUG_ASSERT(partitions);
+
+  for (uint i= 0; i < n_partitions; i++)
+  {
+    ulong size= partition_size;
+    if (i == 0)
+      size+= query_cache_size_arg - partition_size * n_partitions;
+    new_query_cache_size+= partitions[i].resize(size);
+  }
+  query_cache_size= new_query_cache_size;
+  DBUG_RETURN(new_query_cache_size);
+}
+
+
+void Query_cache::result_size_limit(ulong limit)
+{
+  query_cache_limit= limit;
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].result_size_limit(limit);
+}
+
+
+ulong Query_cache::set_min_res_unit(ulong size)
+{
+  ulong res_unit= size;
+  for (uint i= 0; i < n_partitions; i++)
+    res_unit= partitions[i].set_min_res_unit(size);
+  return res_unit;
+}
+
+
+void Query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
+{
+  /* See the comment in Query_cache_partition::store_query(). */
+  if (query_cache_size == 0)
+    return;
+  get_partition(thd->query(), thd->query_length())->store_query(thd,
+                                                                tables_used);
+}
+
+
+int Query_cache::send_result_to_client(THD *thd, char *sql, uint query_length)
+{
+  if (is_disabled() || query_cache_size == 0)
+  {
+    MYSQL_QUERY_CACHE_MISS(thd->query());
+    return 0;
+  }
+  return get_partition(sql, query_length)->send_result_to_client(thd, sql,
+                                                                 query_length);
+}
+
+
+void Query_cache::insert(Query_cache_tls *query_cache_tls,
+                         const char *packet, ulong length,
+                         unsigned pkt_nr)
+{
+  /* See the comment on double-check locking usage above. */
+  if (is_disabled() || query_cache_tls->first_query_block == NULL)
+    return;
+  query_cache_tls->partition->insert(query_cache_tls, packet, length, pkt_nr);
+}
+
+
+void Query_cache::end_of_result(THD *thd)
+{
+  Query_cache_tls *query_cache_tls= &thd->query_cache_tls;
+
+  if (query_cache_tls->first_query_block == NULL)
+    return;
+  query_cache_tls->partition->end_of_result(thd);
+}
+
+
+void Query_cache::abort(Query_cache_tls *query_cache_tls)
+{
+  if (is_disabled() || query_cache_tls->first_query_block == NULL)
+    return;
+  query_cache_tls->partition->abort(query_cache_tls);
+}
+
+
+/**
+  Remove all cached queries that use the given table.
+
+  @param thd                 Thread handle
+  @param table_used          TABLE_LIST representing the table to be
+                             invalidated.
+  @param using_transactions  If we are inside a transaction only add
+                             the table to a list of changed tables for now,
+                             don't invalidate directly. The table will instead
+                             be invalidated once the transaction commits.
+*/
+
+void Query_cache::invalidate_single(THD *thd, TABLE_LIST *table_used,
+                                    my_bool using_transactions)
+{
+  DBUG_ENTER("Query_cache::invalidate_single (table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  DBUG_ASSERT(!using_transactions || table_used->table!=0);
+  if (table_used->derived)
+    DBUG_VOID_RETURN;
+  if (using_transactions &&
+      (table_used->table->file->table_cache_type() ==
+       HA_CACHE_TBL_TRANSACT))
+    /*
+      table_used->table can't be 0 in transaction.
+      Only 'drop' invalidate not opened table, but 'drop'
+      force transaction finish.
+    */
+    thd->add_changed_table(table_used->table);
+  else
+    invalidate_table(thd, table_used);
+
+  DBUG_VOID_RETURN;
+}
+
+/**
+  Remove all cached queries that use any of the tables in the list.
+
+  @see Query_cache::invalidate_single().
+*/
+
+void Query_cache::invalidate(THD *thd, TABLE_LIST *tables_used,
+			     my_bool using_transactions)
+{
+  DBUG_ENTER("Query_cache::invalidate (table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  for (; tables_used; tables_used= tables_used->next_local)
+    invalidate_single(thd, tables_used, using_transactions);
+
+  DEBUG_SYNC(thd, "wait_after_query_cache_invalidate");
+
+  DBUG_VOID_RETURN;
+}
+
+void Query_cache::invalidate(CHANGED_TABLE_LIST *tables_used)
+{
+  DBUG_ENTER("Query_cache::invalidate (changed table list)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  THD *thd= current_thd;
+  for (; tables_used; tables_used= tables_used->next)
+  {
+    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table_list);
+    invalidate_table(thd, (uchar*) tables_used->key, tables_used->key_length);
+    DBUG_PRINT("qcache", ("db: %s  table: %s", tables_used->key,
+                          tables_used->key+
+                          strlen(tables_used->key)+1));
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Invalidate locked for write
+
+  SYNOPSIS
+    Query_cache::invalidate_locked_for_write()
+    tables_used - table list
+
+  NOTE
+    can be used only for opened tables
+*/
+void Query_cache::invalidate_locked_for_write(TABLE_LIST *tables_used)
+{
+  DBUG_ENTER("Query_cache::invalidate_locked_for_write");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  THD *thd= current_thd;
+  for (; tables_used; tables_used= tables_used->next_local)
+  {
+    THD_STAGE_INFO(thd, stage_invalidating_query_cache_entries_table);
+    if (tables_used->lock_type >= TL_WRITE_ALLOW_WRITE &&
+        tables_used->table)
+    {
+      invalidate_table(thd, tables_used->table);
+    }
+  }
+  DBUG_VOID_RETURN;
+}
+
+/*
+  Remove all cached queries that uses the given table
+*/
+
+void Query_cache::invalidate(THD *thd, TABLE *table, 
+			     my_bool using_transactions)
+{
+  DBUG_ENTER("Query_cache::invalidate (table)");
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  if (using_transactions && 
+      (table->file->table_cache_type() == HA_CACHE_TBL_TRANSACT))
+    thd->add_changed_table(table);
+  else
+    invalidate_table(thd, table);
+
+
+  DBUG_VOID_RETURN;
+}
+
+void Query_cache::invalidate(THD *thd, const char *key, uint32  key_length,
+			     my_bool using_transactions)
+{
+  DBUG_ENTER("Query_cache::invalidate (key)");
+  if (is_disabled())
+   DBUG_VOID_RETURN;
+
+  using_transactions= using_transactions && thd->in_multi_stmt_transaction_mode();
+  if (using_transactions) // used for innodb => has_transactions() is TRUE
+    thd->add_changed_table(key, key_length);
+  else
+    invalidate_table(thd, (uchar*)key, key_length);
+
+  DBUG_VOID_RETURN;
+}
+
+
+
+void Query_cache::invalidate_by_MyISAM_filename(const char *filename)
+{
+  DBUG_ENTER("Query_cache::invalidate_by_MyISAM_filename");
+
+  /* Calculate the key outside the lock to make the lock shorter */
+  char key[MAX_DBKEY_LENGTH];
+  uint32 db_length;
+  uint key_length= Query_cache_partition::filename_2_table_key(key, filename,
+                                                             &db_length);
+  THD *thd= current_thd;
+  invalidate_table(thd,(uchar *)key, key_length);
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Remove all queries that use the given table from every partition.
+*/
+
+void Query_cache::invalidate_table(THD *thd, TABLE_LIST *table_list)
+{
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].invalidate_table(thd, table_list);
+}
+
+void Query_cache::invalidate_table(THD *thd, TABLE *table)
+{
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].invalidate_table(thd, table);
+}
+
+void Query_cache::invalidate_table(THD *thd, uchar *key, uint32 key_length)
+{
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].invalidate_table(thd, key, key_length);
+}
+
+
+void Query_cache::invalidate(char *db)
+{
+  if (is_disabled())
+    return;
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].invalidate(db);
+}
+
+
+void Query_cache::flush()
+{
+  if (is_disabled())
+    return;
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].flush();
+}
+
+
+void Query_cache::pack(ulong join_limit, uint iteration_limit)
+{
+  if (is_disabled())
+    return;
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].pack(join_limit, iteration_limit);
+}
+
+
+void Query_cache::wreck(uint line, const char *message)
+{
+  for (uint i= 0; i < n_partitions; i++)
+    partitions[i].wreck(line, message);
+}
+
+
+ulong Query_cache::status(ulong Query_cache_partition::*counter)
+{
+  ulong sum= 0;
+  for (uint i= 0; i < n_partitions; i++)
+    sum+= partitions[i].*counter;
+  return sum;
+}
+
+
+void Query_cache::reset_status()
+{
+  for (uint i= 0; i < n_partitions; i++)
+  {
+    Query_cache_partition *partition= &partitions[i];
+    partition->hits= 0;
+    partition->inserts= 0;
+    partition->refused= 0;
+    partition->lowmem_prunes= 0;
+    partition->lock_waits= 0;
+  }
+}
+
+/****************************************************************************
+  Functions to be used when debugging
+****************************************************************************/
+
+#if defined(DBUG_OFF) || !defined(EXTRA_DEBUG)
+
+void Query_cache_partition::wreck(uint line, const char *message)
+{ query_cache_size = 0; }
+void Query_cache_partition::bins_dump() {}
+void Query_cache_partition::cache_dump() {}
+void Query_cache_partition::queries_dump() {}
+void Query_cache_partition::tables_dump() {}
+bool Query_cache_partition::check_integrity(enum_qcci_lock_mode locking)
+{ return false; }
+my_bool Query_cache_partition::in_list(Query_cache_block *root,
+                                       Query_cache_block *point,
+                                       const char *name) { return 0;}
+my_bool Query_cache_partition::in_blocks(Query_cache_block * point) { return 0; }
+
+#else
+
+
+/*
+  Debug method which switch query cache off but left content for
+  investigation.
+
+  SYNOPSIS
+    Query_cache_partition::wreck()
+    line                 line of the wreck() call
+    message              message for logging
+*/
+
+void Query_cache_partition::wreck(uint line, const char *message)
 {
   THD *thd=current_thd;
-  DBUG_ENTER("Query_cache::wreck");
+  DBUG_ENTER("Query_cache_partition::wreck");
   query_cache_size = 0;
   if (*message)
     DBUG_PRINT("error", (" %s", message));
@@ -4329,7 +4628,7 @@ void Query_cache::wreck(uint line, const char *message)
 }
 
 
-void Query_cache::bins_dump()
+void Query_cache_partition::bins_dump()
 {
   uint i;
   
@@ -4372,7 +4671,7 @@ void Query_cache::bins_dump()
 }
 
 
-void Query_cache::cache_dump()
+void Query_cache_partition::cache_dump()
 {
   if (!initialized || query_cache_size == 0)
   {
@@ -4398,7 +4697,7 @@ void Query_cache::cache_dump()
 }
 
 
-void Query_cache::queries_dump()
+void Query_cache_partition::queries_dump()
 {
 
   if (!initialized)
@@ -4464,7 +4763,7 @@ void Query_cache::queries_dump()
 }
 
 
-void Query_cache::tables_dump()
+void Query_cache_partition::tables_dump()
 {
   if (!initialized || query_cache_size == 0)
   {
@@ -4501,7 +4800,7 @@ void Query_cache::tables_dump()
     @retval true  Query cache is broken.
 */
 
-bool Query_cache::check_integrity(enum_qcci_lock_mode locking)
+bool Query_cache_partition::check_integrity(enum_qcci_lock_mode locking)
 {
   bool result= false;
   uint i;
@@ -4769,7 +5068,7 @@ bool Query_cache::check_integrity(enum_qcci_lock_mode locking)
 }
 
 
-my_bool Query_cache::in_blocks(Query_cache_block * point)
+my_bool Query_cache_partition::in_blocks(Query_cache_block * point)
 {
   my_bool result = 0;
   Query_cache_block *block = point;
@@ -4824,7 +5123,7 @@ err2:
 }
 
 
-my_bool Query_cache::in_list(Query_cache_block * root,
+my_bool Query_cache_partition::in_list(Query_cache_block * root,
 			     Query_cache_block * point,
 			     const char *name)
 {
@@ -4893,7 +5192,7 @@ void dump_node(Query_cache_block_table * node,
 			(ulong) node->prev));
 }
 
-my_bool Query_cache::in_table_list(Query_cache_block_table * root,
+my_bool Query_cache_partition::in_table_list(Query_cache_block_table * root,
 				   Query_cache_block_table * point,
 				   const char *name)
 {
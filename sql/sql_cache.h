@@ -26,6 +26,7 @@ struct LEX;
 struct TABLE;
 typedef struct st_changed_table_list CHANGED_TABLE_LIST;
 typedef ulonglong sql_mode_t;
+typedef struct st_mysql_show_var SHOW_VAR;
 
 /* Query cache */
 
@@ -52,7 +53,10 @@ typedef ulonglong sql_mode_t;
 
 
 
-/* memory bins size spacing (see at Query_cache::init_cache (sql_cache.cc)) */
+/*
+  memory bins size spacing
+  (see at Query_cache_partition::init_cache (sql_cache.cc))
+*/
 #define QUERY_CACHE_MEM_BIN_FIRST_STEP_PWR2	4
 #define QUERY_CACHE_MEM_BIN_STEP_PWR2		2
 #define QUERY_CACHE_MEM_BIN_PARTS_INC		1
@@ -75,6 +79,7 @@ struct Query_cache_table;
 struct Query_cache_query;
 struct Query_cache_result;
 class Query_cache;
+class Query_cache_partition;
 struct Query_cache_tls;
 struct LEX;
 class THD;
@@ -279,14 +284,23 @@ struct Query_cache_memory_bin_step
   }
 };
 
-class Query_cache
+/**
+  One independently locked part of the query cache.
+
+  Every partition has its own structure guard mutex, memory arena, query
+  hash and table hash. A query is always stored in and served from the
+  partition selected by the hash of its text, see Query_cache.
+*/
+
+class Query_cache_partition
 {
+  friend class Query_cache;
 public:
   /* Info */
   ulong query_cache_size, query_cache_limit;
   /* statistics */
   ulong free_memory, queries_in_cache, hits, inserts, refused,
-    free_memory_blocks, total_blocks, lowmem_prunes;
+    free_memory_blocks, total_blocks, lowmem_prunes, lock_waits;
 
 
 private:
@@ -297,11 +311,8 @@ private:
   enum Cache_lock_status { UNLOCKED, LOCKED_NO_WAIT, LOCKED };
   Cache_lock_status m_cache_lock_status;
 
-  bool m_query_cache_is_disabled;
-
   void free_query_internal(Query_cache_block *point);
   void invalidate_table_internal(THD *thd, uchar *key, uint32 key_length);
-  void disable_query_cache(void) { m_query_cache_is_disabled= TRUE; }
 
 protected:
   /*
@@ -439,13 +450,15 @@ protected:
   static my_bool ask_handler_allowance(THD *thd, TABLE_LIST *tables_used);
  public:
 
-  Query_cache(ulong query_cache_limit = ULONG_MAX,
-	      ulong min_allocation_unit = QUERY_CACHE_MIN_ALLOCATION_UNIT,
-	      ulong min_result_data_size = QUERY_CACHE_MIN_RESULT_DATA_SIZE,
-	      uint def_query_hash_size = QUERY_CACHE_DEF_QUERY_HASH_SIZE,
-	      uint def_table_hash_size = QUERY_CACHE_DEF_TABLE_HASH_SIZE);
-
-  bool is_disabled(void) { return m_query_cache_is_disabled; }
+  Query_cache_partition(ulong query_cache_limit = ULONG_MAX,
+                        ulong min_allocation_unit =
+                          QUERY_CACHE_MIN_ALLOCATION_UNIT,
+                        ulong min_result_data_size =
+                          QUERY_CACHE_MIN_RESULT_DATA_SIZE,
+                        uint def_query_hash_size =
+                          QUERY_CACHE_DEF_QUERY_HASH_SIZE,
+                        uint def_table_hash_size =
+                          QUERY_CACHE_DEF_TABLE_HASH_SIZE);
 
   /* initialize cache (mutex) */
   void init();
@@ -465,24 +478,9 @@ protected:
   */
   int send_result_to_client(THD *thd, char *query, uint query_length);
 
-  /* Remove all queries that use the given table */
-  void invalidate_single(THD* thd, TABLE_LIST *table_used,
-                         my_bool using_transactions);
-  /* Remove all queries that uses any of the listed following tables */
-  void invalidate(THD* thd, TABLE_LIST *tables_used,
-		  my_bool using_transactions);
-  void invalidate(CHANGED_TABLE_LIST *tables_used);
-  void invalidate_locked_for_write(TABLE_LIST *tables_used);
-  void invalidate(THD* thd, TABLE *table, my_bool using_transactions);
-  void invalidate(THD *thd, const char *key, uint32  key_length,
-		  my_bool using_transactions);
-
   /* Remove all queries that uses any of the tables in following database */
   void invalidate(char *db);
 
-  /* Remove all queries that uses any of the listed following table */
-  void invalidate_by_MyISAM_filename(const char *filename);
-
   void flush();
   void pack(ulong join_limit = QUERY_CACHE_PACK_LIMIT,
 	    uint iteration_limit = QUERY_CACHE_PACK_ITERATION);
@@ -522,6 +520,106 @@ protected:
   void unlock(void);
 };
 
+
+/* Upper limit of query_cache_partitions */
+#define QUERY_CACHE_MAX_PARTITIONS 64
+
+/**
+  The query cache.
+
+  The cache is split into query_cache_partitions independently locked
+  Query_cache_partition objects, so that lookups and inserts of different
+  queries do not serialize on a single structure guard mutex. The memory
+  given by query_cache_size is divided evenly between the partitions.
+  Statements are routed to a partition by the hash of the query text;
+  invalidation and flushes visit every partition.
+*/
+
+class Query_cache
+{
+public:
+  /* Info */
+  ulong query_cache_size, query_cache_limit;
+
+private:
+  Query_cache_partition *partitions;
+  uint n_partitions;
+  bool m_query_cache_is_disabled;
+  /* Per partition status variables, see status_vars() */
+  SHOW_VAR *m_status_vars;
+
+  void disable_query_cache(void) { m_query_cache_is_disabled= TRUE; }
+  Query_cache_partition *get_partition(const char *query, size_t length);
+  void invalidate_table(THD *thd, TABLE_LIST *table);
+  void invalidate_table(THD *thd, TABLE *table);
+  void invalidate_table(THD *thd, uchar *key, uint32 key_length);
+
+public:
+  Query_cache();
+
+  bool is_disabled(void) { return m_query_cache_is_disabled; }
+
+  /* initialize cache (mutexes) with the given number of partitions */
+  void init(uint n_partitions_arg);
+  /* resize query cache (return real query size, 0 if disabled) */
+  ulong resize(ulong query_cache_size);
+  /* set limit on result size */
+  void result_size_limit(ulong limit);
+  /* set minimal result data allocation unit size */
+  ulong set_min_res_unit(ulong size);
+
+  /* register query in cache */
+  void store_query(THD *thd, TABLE_LIST *used_tables);
+
+  /*
+    Check if the query is in the cache and if this is true send the
+    data to client.
+  */
+  int send_result_to_client(THD *thd, char *query, uint query_length);
+
+  /* Remove all queries that use the given table */
+  void invalidate_single(THD* thd, TABLE_LIST *table_used,
+                         my_bool using_transactions);
+  /* Remove all queries that uses any of the listed following tables */
+  void invalidate(THD* thd, TABLE_LIST *tables_used,
+		  my_bool using_transactions);
+  void invalidate(CHANGED_TABLE_LIST *tables_used);
+  void invalidate_locked_for_write(TABLE_LIST *tables_used);
+  void invalidate(THD* thd, TABLE *table, my_bool using_transactions);
+  void invalidate(THD *thd, const char *key, uint32  key_length,
+		  my_bool using_transactions);
+
+  /* Remove all queries that uses any of the tables in following database */
+  void invalidate(char *db);
+
+  /* Remove all queries that uses any of the listed following table */
+  void invalidate_by_MyISAM_filename(const char *filename);
+
+  void flush();
+  void pack(ulong join_limit = QUERY_CACHE_PACK_LIMIT,
+	    uint iteration_limit = QUERY_CACHE_PACK_ITERATION);
+
+  void destroy();
+
+  void insert(Query_cache_tls *query_cache_tls,
+              const char *packet,
+              ulong length,
+              unsigned pkt_nr);
+
+  void end_of_result(THD *thd);
+  void abort(Query_cache_tls *query_cache_tls);
+
+  /* Switch all partitions off, see Query_cache_partition::wreck() */
+  void wreck(uint line, const char *message);
+
+  /* Sum of a statistics counter over all partitions */
+  ulong status(ulong Query_cache_partition::*counter);
+  /* Reset the counters cleared by FLUSH STATUS */
+  void reset_status();
+  /* Qcache_partition_<n>_* status variables */
+  SHOW_VAR *status_vars() { return m_status_vars; }
+};
+
 struct Query_cache_query_flags
 {
   unsigned int client_long_flag:1;
@@ -384,6 +384,7 @@ class MY_LOCALE;
 */
 
 struct Query_cache_block;
+class Query_cache_partition;
 
 struct Query_cache_tls
 {
@@ -392,12 +393,14 @@ struct Query_cache_tls
     functions and methods to maintain proper locking.
   */
   Query_cache_block *first_query_block;
+  /* Query cache partition holding 'first_query_block' */
+  Query_cache_partition *partition;
   void set_first_query_block(Query_cache_block *first_query_block_arg)
   {
     first_query_block= first_query_block_arg;
   }
 
-  Query_cache_tls() :first_query_block(NULL) {}
+  Query_cache_tls() :first_query_block(NULL), partition(NULL) {}
 };
 
 #include "sql_lex.h"				/* Must be here */
@@ -474,6 +477,7 @@ typedef struct system_variables
   ulong read_rnd_buff_size;
   ulong div_precincrement;
   ulong sortbuff_size;
+  ulong sort_parallel_degree;
   ulong max_sp_recursion_depth;
   ulong default_week_format;
   ulong max_seeks_for_key;
@@ -2326,6 +2330,7 @@ public:
       bool real_commit;               // Is this a "real" commit?
       bool commit_low;                // see MYSQL_BIN_LOG::ordered_commit
       bool run_hooks;                 // Call the after_commit hook
+      bool copy_pending;              // Caches to copy into the binary log
 #ifndef DBUG_OFF
       bool ready_preempt;             // internal in MYSQL_BIN_LOG::ordered_commit
 #endif
@@ -199,6 +199,13 @@
 */
 #define MATCHING_ROWS_IN_OTHER_TABLE 10
 
+/**
+  Number of bytes a hash join uses in the join buffer for each record in
+  addition to the record itself: the reference to the next record of the
+  hash chain, the hash value of the record and the hash table entry.
+*/
+#define HASH_JOIN_RECORD_OVERHEAD 12
+
 /*
   Constants related to the use of temporary tables in query execution.
   Lookup and write operations are currently assumed to be equally costly
@@ -3409,6 +3409,527 @@ bool JOIN_CACHE_BKA_UNIQUE::check_match(uchar *rec_ptr)
 }
 
 
+/* 
+  Initialize a hash join cache       
+
+  SYNOPSIS
+    init()
+
+  DESCRIPTION
+    The function initializes the cache structure. It supposed to be called
+    right after a constructor for the JOIN_CACHE_HASH.
+    The function first looks for the equalities from the condition attached
+    to join_tab that can be used to build hash keys. If there are none the
+    function fails and the caller is expected to employ a JOIN_CACHE_BNL
+    object instead. Otherwise the function allocates memory for the join
+    buffer and for descriptors of the record fields stored in the buffer,
+    estimates the number of entries in the hash table to be used and
+    initializes this hash table at the end of the join buffer.
+  
+  RETURN
+    0   initialization with buffer allocations has been succeeded
+    1   otherwise
+*/
+
+int JOIN_CACHE_HASH::init()
+{
+  int rc= 0;
+  DBUG_ENTER("JOIN_CACHE_HASH::init");
+
+  hash_table= 0;
+  key_parts= 0;
+  rec_fields_offset= 0;
+
+  MEM_ROOT *mem_root= join->thd->mem_root;
+  if (!(outer_key_items= (Item **) alloc_root(mem_root,
+                                              MAX_REF_PARTS*sizeof(Item *))) ||
+      !(inner_key_items= (Item **) alloc_root(mem_root,
+                                              MAX_REF_PARTS*sizeof(Item *))) ||
+      !(key_part_cs= (const CHARSET_INFO **)
+          alloc_root(mem_root, MAX_REF_PARTS*sizeof(CHARSET_INFO *))))
+    DBUG_RETURN(1);
+
+  /*
+    The outer expressions may refer to any table preceding join_tab,
+    but they must not be random as they are evaluated only once for
+    each record put into the join buffer.
+  */
+  table_map outer_tables= join_tab->prefix_tables() &
+                          ~(join_tab->table->map | RAND_TABLE_BIT);
+  if (join_tab->condition())
+    add_key_parts(join_tab->condition(), outer_tables);
+  if (!key_parts)
+    DBUG_RETURN(1);
+
+  if ((rc= JOIN_CACHE_BNL::init()))
+    DBUG_RETURN(rc);
+
+  /* Take into account the chain reference and the hash value */
+  pack_length+= get_hash_prefix_length();
+  pack_length_with_blob_ptrs+= get_hash_prefix_length();
+
+  /* Have about one hash entry for each record that fits into the buffer */
+  hash_entries= max(1UL, buff_size/(pack_length+get_size_of_rec_offset()));
+
+  /* Initialize the hash table */ 
+  hash_table= buff + (buff_size-hash_entries*get_size_of_rec_offset());
+  cleanup_hash_table();
+
+  DBUG_RETURN(rc);
+}
+
+
+/*
+  Add the equalities usable for hash keys to the key of a hash join cache
+
+  SYNOPSIS
+    add_key_parts()
+      cond          the condition to look for equalities in
+      outer_tables  the tables the outer expressions may depend on
+
+  DESCRIPTION
+    The function looks for the top level conjuncts of 'cond' of the form
+    inner_expr=outer_expr where inner_expr depends only on the table of
+    join_tab and outer_expr depends only on 'outer_tables', and adds them
+    to the hash key of the cache. Only the equalities comparing integers
+    or strings are used, as for them equal values are guaranteed to have
+    equal hash values: the integer values are hashed as they are, the
+    string values are hashed with the collation used for the comparison.
+    The predicate guarding the condition pushed to the first inner table
+    of an outer join against null complemented rows is looked through as
+    it is always on when the matches for the records are searched for.
+
+  RETURN
+    none
+*/
+
+void JOIN_CACHE_HASH::add_key_parts(Item *cond, table_map outer_tables)
+{
+  if (cond->type() == Item::COND_ITEM)
+  {
+    if (((Item_cond*) cond)->functype() != Item_func::COND_AND_FUNC)
+      return;
+    List_iterator<Item> li(*((Item_cond*) cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+      add_key_parts(item, outer_tables);
+    return;
+  }
+  if (cond->type() != Item::FUNC_ITEM)
+    return;
+
+  Item_func *func= (Item_func *) cond;
+  if (func->functype() == Item_func::TRIG_COND_FUNC)
+  {
+    if (join_tab->first_inner == join_tab &&
+        ((Item_func_trig_cond *) func)->get_trig_var() ==
+          &join_tab->not_null_compl)
+      add_key_parts(func->arguments()[0], outer_tables);
+    return;
+  }
+  if (func->functype() != Item_func::EQ_FUNC || key_parts == MAX_REF_PARTS)
+    return;
+
+  const table_map inner_table= join_tab->table->map;
+  Item **args= func->arguments();
+  for (uint i= 0; i < 2; i++)
+  {
+    Item *inner= args[i];
+    Item *outer= args[1-i];
+    const table_map inner_map= inner->used_tables() & ~OUTER_REF_TABLE_BIT;
+    const table_map outer_map= outer->used_tables() & ~OUTER_REF_TABLE_BIT;
+    if (inner_map != inner_table || !outer_map ||
+        (outer_map & ~outer_tables))
+      continue;
+    const CHARSET_INFO *cs= ((Item_func_eq *) func)->compare_collation();
+    if (!is_key_part(inner, outer, cs))
+      return;
+
+    inner_key_items[key_parts]= inner;
+    outer_key_items[key_parts]= outer;
+    key_part_cs[key_parts]= inner->result_type() == STRING_RESULT ? cs : NULL;
+    key_parts++;
+    return;
+  }
+}
+
+
+/*
+  Check whether an equality can be used as a part of a hash join key
+
+  SYNOPSIS
+    is_key_part()
+      inner   the side of the equality evaluated over the rows of join_tab
+      outer   the side of the equality evaluated over the buffered records
+      cmp_cs  the collation the equality compares strings with
+
+  DESCRIPTION
+    The function checks the types of the sides of an equality. Only the
+    equalities comparing integers, or strings of the same character set
+    as the comparison collation, are usable as for them equal values are
+    guaranteed to have equal hash values. The function is used both by
+    add_key_parts() and by the join planner, so that a hash join is never
+    costed for an equality that cannot be hashed when the cache is set up.
+
+  RETURN
+    TRUE   the equality can be used as a key part
+    FALSE  otherwise
+*/
+
+bool JOIN_CACHE_HASH::is_key_part(Item *inner, Item *outer,
+                                  const CHARSET_INFO *cmp_cs)
+{
+  if (inner->has_subquery() || outer->has_subquery() ||
+      inner->is_temporal() || outer->is_temporal() ||
+      inner->field_type() == MYSQL_TYPE_YEAR ||
+      outer->field_type() == MYSQL_TYPE_YEAR ||
+      inner->result_type() != outer->result_type())
+    return FALSE;
+
+  if (inner->result_type() == STRING_RESULT)
+    return my_charset_same(cmp_cs, inner->collation.collation) &&
+           my_charset_same(cmp_cs, outer->collation.collation);
+  return inner->result_type() == INT_RESULT;
+}
+
+
+/*
+  Calculate the hash value of a key of a hash join cache
+
+  SYNOPSIS
+    calc_hash_value()
+      key_items   the expressions of the key
+      hash_value  OUT the hash value of the key
+
+  DESCRIPTION
+    The function evaluates the expressions from 'key_items' and calculates
+    the hash value over the values of all of them. When the function is
+    called for the outer expressions the values are taken from the partial
+    join record in the record buffers, for the inner expressions they are
+    taken from the current row of join_tab.
+
+  RETURN
+    TRUE   one of the key parts has a NULL value, the key cannot match
+    FALSE  otherwise
+*/
+
+bool JOIN_CACHE_HASH::calc_hash_value(Item **key_items, uint32 *hash_value)
+{
+  ulong nr1= 1;
+  ulong nr2= 4;
+  for (uint i= 0; i < key_parts; i++)
+  {
+    Item *item= key_items[i];
+    const CHARSET_INFO *cs= key_part_cs[i];
+    if (cs)
+    {
+      StringBuffer<STRING_BUFFER_USUAL_SIZE> tmp(cs);
+      String *str= item->val_str(&tmp);
+      if (item->null_value)
+        return TRUE;
+      cs->coll->hash_sort(cs, (const uchar *) str->ptr(), str->length(),
+                          &nr1, &nr2);
+    }
+    else
+    {
+      uchar buff[8];
+      longlong value= item->val_int();
+      if (item->null_value)
+        return TRUE;
+      int8store(buff, value);
+      my_charset_bin.coll->hash_sort(&my_charset_bin, buff, sizeof(buff),
+                                     &nr1, &nr2);
+    }
+  }
+  *hash_value= (uint32) nr1;
+  return FALSE;
+}
+
+
+/* 
+  Clean up the hash table of the join buffer
+
+  SYNOPSIS
+    cleanup_hash_table()
+      
+  DESCRIPTION
+    The function cleans up the hash table in the join buffer detaching
+    all record chains from the hash entries. 
+
+  RETURN
+    none  
+*/
+
+void JOIN_CACHE_HASH::cleanup_hash_table()
+{
+  memset(hash_table, 0, (buff+buff_size)-hash_table);
+}
+
+
+/* 
+  Reset the JOIN_CACHE_HASH buffer for reading/writing
+
+  SYNOPSIS
+    reset_cache()
+      for_writing  if it's TRUE the function reset the buffer for writing
+
+  DESCRIPTION
+    This implementation of the virtual function reset_cache() resets the join
+    buffer of the JOIN_CACHE_HASH class for reading or writing.
+    Additionally to what the default implementation does this function
+    cleans up the hash table allocated within the buffer.  
+    
+  RETURN
+    none
+*/
+ 
+void JOIN_CACHE_HASH::reset_cache(bool for_writing)
+{
+  this->JOIN_CACHE::reset_cache(for_writing);
+  if (for_writing && hash_table)
+    cleanup_hash_table();
+}
+
+
+/* 
+  Add a record into the JOIN_CACHE_HASH buffer
+
+  SYNOPSIS
+    put_record_in_cache()
+
+  DESCRIPTION
+    This implementation of the virtual function put_record writes the next
+    matching record into the join buffer of the JOIN_CACHE_HASH class.
+    Additionally to what the default implementation does this function
+    calculates the hash value of the outer expressions of the hash key
+    over the record and appends the record to the chain attached to
+    the hash entry for this value. The hash value is stored before the
+    record in the buffer.
+    
+  RETURN
+    TRUE    if it has been decided that it should be the last record
+            in the join buffer,
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASH::put_record_in_cache()
+{
+  uint32 hash_value;
+  uchar *next_ref_ptr= pos;
+  pos+= get_hash_prefix_length();
+
+  // Write record to join buffer
+  bool is_full= JOIN_CACHE::put_record_in_cache();
+
+  uchar *rec_ptr= get_curr_rec();
+  rec_fields_offset= (uint) (rec_ptr-next_ref_ptr);
+
+  if (calc_hash_value(outer_key_items, &hash_value))
+  {
+    /*
+      The record cannot have matches. It is not added to any chain, but
+      it stays in the buffer to be null complemented if needed.
+    */
+    DBUG_PRINT("info", ("JOIN_CACHE_HASH::put_record null_rejected"));
+    return is_full;
+  }
+  int4store(next_ref_ptr+get_size_of_rec_offset(), hash_value);
+
+  uchar *entry= get_hash_entry(hash_value);
+  if (get_offset(get_size_of_rec_offset(), entry))
+  {
+    /* Add the record to the end of the circular list of the chain */
+    uchar *last_next_ref_ptr= get_next_rec_ref(entry)-rec_fields_offset;
+    /* rec->next_rec= entry->last_rec->next_rec */
+    memcpy(next_ref_ptr, last_next_ref_ptr, get_size_of_rec_offset());
+    /* entry->last_rec->next_rec= rec */ 
+    store_next_rec_ref(last_next_ref_ptr, rec_ptr);
+  }
+  else
+  {
+    /* Create a circular list with one element */
+    store_next_rec_ref(next_ref_ptr, rec_ptr);
+  }
+  /* entry->last_rec= rec */
+  store_next_rec_ref(entry, rec_ptr);
+  return is_full;
+}
+
+
+/*
+  Read the next record from the JOIN_CACHE_HASH buffer
+
+  SYNOPSIS
+    get_record()
+
+  DESCRIPTION
+    Additionally to what the default implementation of the virtual 
+    function get_record does this implementation skips the chain
+    reference and the hash value stored before the record.
+
+  RETURN
+    TRUE  - there are no more records to read from the join buffer
+    FALSE - otherwise
+*/
+
+bool JOIN_CACHE_HASH::get_record()
+{ 
+  pos+= get_hash_prefix_length();
+  return this->JOIN_CACHE::get_record();
+}
+
+
+/* 
+  Skip record from the JOIN_CACHE_HASH join buffer if its match flag is on 
+
+  SYNOPSIS
+    skip_record_if_match()
+
+  DESCRIPTION
+    This implementation of the virtual function skip_record_if_match does
+    the same as the default implementation does, but it takes into account
+    the chain reference and the hash value stored before the record.
+
+  RETURN
+    TRUE  - the match flag is on and the record has been skipped
+    FALSE - the match flag is off 
+*/
+
+bool JOIN_CACHE_HASH::skip_record_if_match()
+{
+  uchar *save_pos= pos;
+  pos+= get_hash_prefix_length();
+  if (!this->JOIN_CACHE::skip_record_if_match())
+  {
+    pos= save_pos;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+
+/*
+  Using the hash table find matches from the next table for records
+  from the join buffer
+
+  SYNOPSIS
+    join_matching_records()
+      skip_last    do not look for matches for the last partial join record 
+
+  DESCRIPTION
+    The function retrieves all rows of the join_tab table as the function
+    JOIN_CACHE_BNL::join_matching_records does. For each row meeting the
+    conditions pushed to join_tab it calculates the hash value of the inner
+    expressions of the hash key and checks only the records from the chain
+    of the corresponding hash entry that have the same hash value. If a
+    match is found the function will call the sub_select function trying
+    to look for matches for the remaining join operations.
+    If the value of skip_last is true the function writes the partial join
+    record from the record buffer into the join buffer to save its value for
+    the future processing in the caller function, and positions the buffer
+    at this record when it returns.
+
+  RETURN
+    return one of enum_nested_loop_state.
+*/ 
+
+enum_nested_loop_state JOIN_CACHE_HASH::join_matching_records(bool skip_last)
+{
+  int error;
+  READ_RECORD *info;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  SQL_SELECT *select= join_tab->cache_select;
+  uchar *skip_next_ref_ptr= 0;
+  uchar *skip_rec_ptr= 0;
+
+  join_tab->table->null_row= 0;
+
+  /* Return at once if there are no records in the join buffer */
+  if (!records)     
+    return NESTED_LOOP_OK;   
+ 
+  if (skip_last)
+  {
+    skip_next_ref_ptr= pos;
+    put_record_in_cache();
+    skip_rec_ptr= get_curr_rec();
+  }
+ 
+  if (join_tab->use_quick == QS_DYNAMIC_RANGE && join_tab->select->quick)
+    /* A dynamic range access was used last. Clean up after it */
+    join_tab->select->set_quick(NULL);
+
+  /* Start retrieving all records of the joined table */
+  if ((error= (*join_tab->read_first_record)(join_tab))) 
+    return error < 0 ? NESTED_LOOP_OK : NESTED_LOOP_ERROR;
+
+  info= &join_tab->read_record;
+  do
+  {
+    if (join_tab->keep_current_rowid)
+      join_tab->table->file->position(join_tab->table->record[0]);
+
+    if (join->thd->killed)
+    {
+      /* The user has aborted the execution of the query */
+      join->thd->send_kill_message();
+      return NESTED_LOOP_KILLED;
+    }
+    
+    /* 
+      Do not look for matches if the last read record of the joined table
+      does not meet the conditions that have been pushed to this table
+    */
+    if (rc == NESTED_LOOP_OK)
+    {
+      bool skip_record;
+      uint32 hash_value;
+      bool consider_record= (!select || 
+                             (!select->skip_record(join->thd, &skip_record) &&
+                              !skip_record));
+      if (select && join->thd->is_error())
+        return NESTED_LOOP_ERROR;
+      if (!consider_record || calc_hash_value(inner_key_items, &hash_value))
+        continue;
+      if (join->thd->is_error())
+        return NESTED_LOOP_ERROR;
+
+      uchar *entry= get_hash_entry(hash_value);
+      if (!get_offset(get_size_of_rec_offset(), entry))
+        continue;
+
+      /* Check the records of the chain starting from the first one */
+      uchar *last_rec_ptr= get_next_rec_ref(entry);
+      uchar *rec_ptr= last_rec_ptr;
+      do
+      {
+        rec_ptr= get_next_rec_ref(rec_ptr-rec_fields_offset);
+        if (rec_ptr == skip_rec_ptr ||
+            uint4korr(rec_ptr-rec_fields_offset+get_size_of_rec_offset()) !=
+              hash_value)
+          continue;
+        /* 
+          If only the first match is needed and it has been already found
+          for the record then the record is skipped.
+        */
+        if (check_only_first_match && get_match_flag_by_pos(rec_ptr))
+          continue;
+        get_record_by_pos(rec_ptr);
+        rc= generate_full_extensions(rec_ptr);
+        if (rc != NESTED_LOOP_OK)
+          return rc;
+      } while (rec_ptr != last_rec_ptr);
+    }
+  } while (!(error= info->read_record(info)));
+
+  if (error > 0)				// Fatal error
+    rc= NESTED_LOOP_ERROR; 
+  if (skip_last)
+    pos= skip_next_ref_ptr;
+  return rc;
+}
+
+
 /****************************************************************************
  * Join cache module end
  ****************************************************************************/
@@ -470,9 +470,11 @@ public:
   }
 
   /** Bits describing cache's type @sa setup_join_buffering() */
-  enum {ALG_NONE= 0, ALG_BNL= 1, ALG_BKA= 2, ALG_BKA_UNIQUE= 4};
+  enum {ALG_NONE= 0, ALG_BNL= 1, ALG_BKA= 2, ALG_BKA_UNIQUE= 4,
+        ALG_HASH= 8};
 
   friend class JOIN_CACHE_BNL;
+  friend class JOIN_CACHE_HASH;
   friend class JOIN_CACHE_BKA;
   friend class JOIN_CACHE_BKA_UNIQUE;
 };
@@ -520,6 +522,148 @@ public:
 
 };
 
+/*
+  The class JOIN_CACHE_HASH supports a hash join variant of the Blocked Nested
+  Loops algorithm. It is employed when the condition attached to join_tab
+  contains equalities of the form inner_expr=outer_expr where inner_expr
+  depends only on the table of join_tab while outer_expr depends only on the
+  tables whose records are stored in this join buffer or in the previous ones.
+  When a record is put into the join buffer the hash value of its outer
+  expressions is calculated and the record is added to the chain of records
+  attached to the corresponding entry of a hash table. The hash table is
+  placed at the very end of the join buffer. For each row of join_tab only
+  the records from the chain selected by the hash value of the inner
+  expressions are checked instead of all records from the join buffer.
+  The attached condition is still evaluated for each of these records,
+  so hash collisions and the remaining predicates are handled exactly as
+  with the JOIN_CACHE_BNL class.
+  Each record in the join buffer is preceded by a reference to the next
+  record in its chain followed by the hash value of the record. The records
+  of a chain are linked in a circular list in the order they have been put
+  into the buffer, a hash entry refers to the last record of its chain.
+  Records with a NULL value for one of the outer expressions are not added
+  to any chain as they cannot have matches. They are still read sequentially
+  when null complementing extensions are generated for outer joins.
+  When the join buffer gets full its records are joined with all rows of
+  join_tab and the buffer is refilled, as it is done for JOIN_CACHE_BNL.
+*/
+
+class JOIN_CACHE_HASH :public JOIN_CACHE_BNL
+{
+
+private:
+
+  /* Number of equalities used to build the hash keys */
+  uint key_parts;
+  /* The sides of the equalities evaluated over the records from the buffer */
+  Item **outer_key_items;
+  /* The sides of the equalities evaluated over the rows of join_tab */
+  Item **inner_key_items;
+  /* Collations to hash string key parts, NULL for integer key parts */
+  const CHARSET_INFO **key_part_cs;
+
+  /* The beginning of the hash table in the join buffer */
+  uchar *hash_table;
+  /* Number of hash entries in the hash table */
+  uint hash_entries;
+
+  /* 
+    The offset of the record fields from the beginning of the record
+    representation. The record representation starts with a reference to
+    the next record in the chain followed by the hash value of the record
+    followed by the length of the record data, if any, followed by a
+    reference to the record segment in the previous cache, if any.
+  */ 
+  uint rec_fields_offset;
+
+  /* Add the usable equalities from 'cond' to the hash key */
+  void add_key_parts(Item *cond, table_map outer_tables);
+
+  /* Calculate the hash value of a key, return TRUE if it has a NULL part */
+  bool calc_hash_value(Item **key_items, uint32 *hash_value);
+
+  void cleanup_hash_table();
+
+  /* Get the length of the chain reference and the hash value of a record */
+  uint get_hash_prefix_length()
+  {
+    return get_size_of_rec_offset()+sizeof(uint32);
+  }
+
+  /* Get the hash entry for the hash value 'hash_value' */
+  uchar *get_hash_entry(uint32 hash_value)
+  {
+    return hash_table+get_size_of_rec_offset()*(hash_value % hash_entries);
+  }
+
+  /*
+    Get the position of the record fields pointed to by a reference stored
+    at the position ref_ptr. The stored reference is actually the offset
+    from the beginning of the join buffer, 0 stands for the nil value.
+  */
+  uchar *get_next_rec_ref(uchar *ref_ptr)
+  {
+    return buff+get_offset(get_size_of_rec_offset(), ref_ptr);
+  }
+
+  void store_next_rec_ref(uchar *ref_ptr, uchar *ref)
+  {
+    store_offset(get_size_of_rec_offset(), ref_ptr, (ulong) (ref-buff));
+  }     
+
+protected:
+
+  /* 
+    Calculate how much space in the buffer would not be occupied by
+    records and by the hash table.
+  */ 
+  ulong rem_space() 
+  { 
+    return std::max<ulong>(hash_table-end_pos-aux_buff_size, 0UL);
+  }
+
+  /* Skip record from JOIN_CACHE_HASH buffer if its match flag is on */
+  bool skip_record_if_match();
+
+  /* Using the hash table find matches for records from join buffer */
+  enum_nested_loop_state join_matching_records(bool skip_last);
+
+  /* Add a record into the JOIN_CACHE_HASH buffer */
+  bool put_record_in_cache();
+
+public:
+
+  /* 
+    This constructor creates an unlinked hash join cache. The cache is to be
+    used to join table 'tab' to the result of joining the previous tables 
+    specified by the 'j' parameter.
+  */   
+  JOIN_CACHE_HASH(JOIN *j, JOIN_TAB *tab)
+    :JOIN_CACHE_BNL(j, tab) {}
+
+  /* 
+    This constructor creates a linked hash join cache. The cache is to be
+    used to join table 'tab' to the result of joining the previous tables 
+    specified by the 'j' parameter. The parameter 'prev' specifies the
+    previous cache object to which this cache is linked.
+  */   
+  JOIN_CACHE_HASH(JOIN *j, JOIN_TAB *tab, JOIN_CACHE *prev)
+    :JOIN_CACHE_BNL(j, tab, prev) {}
+
+  /* Check whether inner=outer can be used as a part of a hash key */
+  static bool is_key_part(Item *inner, Item *outer,
+                          const CHARSET_INFO *cmp_cs);
+
+  /* Initialize the hash join cache */       
+  int init();
+
+  /* Reset the JOIN_CACHE_HASH buffer for reading/writing */
+  void reset_cache(bool for_writing);
+
+  /* Read the next record from the JOIN_CACHE_HASH buffer */
+  bool get_record();
+};
+
 class JOIN_CACHE_BKA :public JOIN_CACHE
 {
 protected:
@@ -29,6 +29,7 @@
 #include "opt_range.h"
 #include "opt_trace.h"
 #include "sql_executor.h"
+#include "sql_join_buffer.h"                 // JOIN_CACHE_HASH
 #include "merge_sort.h"
 #include <my_bit.h>
 
@@ -68,6 +69,88 @@ cache_record_length(JOIN *join,uint idx)
 }
 
 
+/**
+  Check whether a condition contains an equality that can be used as the
+  key of a hash join between a table and the tables of a partial plan.
+
+  The top level conjuncts of the condition are searched for an equality
+  with one side depending only on the table and the other one only on the
+  tables of the partial plan. Multiple equalities without a constant are
+  accepted if they contain fields from both. The types of the sides are
+  checked with JOIN_CACHE_HASH::is_key_part(), the same predicate that
+  chooses the key parts when the join buffer is set up, so that the plan
+  is not costed for a hash join that JOIN_CACHE_HASH::init() rejects.
+
+  @param cond          condition to check, may be NULL
+  @param table_bit     map of the table to be joined
+  @param prefix_tables map of the tables of the partial plan
+
+  @return true if a hash join may be used, false otherwise
+*/
+
+static bool
+has_hash_join_equality(Item *cond, table_map table_bit,
+                       table_map prefix_tables)
+{
+  if (cond == NULL)
+    return false;
+
+  if (cond->type() == Item::COND_ITEM)
+  {
+    if (((Item_cond*) cond)->functype() != Item_func::COND_AND_FUNC)
+      return false;
+    List_iterator<Item> li(*((Item_cond*) cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (has_hash_join_equality(item, table_bit, prefix_tables))
+        return true;
+    }
+    return false;
+  }
+  if (cond->type() != Item::FUNC_ITEM)
+    return false;
+
+  Item_func *const func= (Item_func*) cond;
+  if (func->functype() == Item_func::MULT_EQUAL_FUNC)
+  {
+    Item_equal *const item_equal= (Item_equal*) func;
+    if (item_equal->get_const())
+      return false;
+    Item_field *inner= NULL, *outer= NULL;
+    Item_equal_iterator it(*item_equal);
+    Item_field *item;
+    while ((item= it++))
+    {
+      const table_map map= item->used_tables();
+      if (map == table_bit)
+        inner= item;
+      else if (map & prefix_tables)
+        outer= item;
+    }
+    return inner && outer &&
+           JOIN_CACHE_HASH::is_key_part(inner, outer,
+                                        item_equal->compare_collation());
+  }
+  if (func->functype() == Item_func::EQ_FUNC)
+  {
+    Item **const args= func->arguments();
+    for (uint i= 0; i < 2; i++)
+    {
+      const table_map inner_map= args[i]->used_tables() & ~OUTER_REF_TABLE_BIT;
+      const table_map outer_map=
+        args[1 - i]->used_tables() & ~OUTER_REF_TABLE_BIT;
+      if (inner_map == table_bit && outer_map &&
+          !(outer_map & ~prefix_tables))
+        return JOIN_CACHE_HASH::is_key_part(args[i], args[1 - i],
+                                            ((Item_func_eq *) func)->
+                                              compare_collation());
+    }
+  }
+  return false;
+}
+
+
 /**
   Find the best access path for an extension of a partial execution
   plan and add this path to the plan.
@@ -106,6 +189,7 @@ void Optimize_table_order::best_access_path(
   table_map best_ref_depends_map= 0;
   double tmp;
   bool best_uses_jbuf= false;
+  bool best_uses_hash_join= false;
   Opt_trace_context * const trace= &thd->opt_trace;
   TABLE *const table= s->table;
 
@@ -614,6 +698,9 @@ void Optimize_table_order::best_access_path(
     if (table->quick_condition_rows != s->found_records)
       rnd_records= table->quick_condition_rows;
 
+    double scan_records= rows2double(rnd_records);
+    bool use_hash_join= false;
+
     /*
       Range optimizer never proposes a RANGE if it isn't better
       than FULL: so if RANGE is present, it's always preferred to FULL.
@@ -645,6 +732,7 @@ void Optimize_table_order::best_access_path(
         tmp= table->file->read_time(s->ref.key, 1, s->records);
       else // table scan
         tmp= table->file->scan_time();
+      const double scan_time= tmp;
 
       if (disable_jbuf)
       {
@@ -675,13 +763,62 @@ void Optimize_table_order::best_access_path(
            take into account cost to read and skip these records.
         */
         tmp+= (s->records - rnd_records) * ROW_EVALUATE_COST;
+
+        /*
+          The outer sides of the hash key are evaluated once for each
+          buffered record, so they must not be random, as in
+          JOIN_CACHE_HASH::init().
+        */
+        const table_map prefix_tables=
+          ~(remaining_tables | excluded_tables | table->map | RAND_TABLE_BIT);
+        if (thd->optimizer_switch_flag(OPTIMIZER_SWITCH_HASH_JOIN) &&
+            !table->force_index &&
+            (has_hash_join_equality(join->conds, table->map,
+                                    prefix_tables) ||
+             (s->on_expr_ref &&
+              has_hash_join_equality(*s->on_expr_ref, table->map,
+                                     prefix_tables))))
+        {
+          /*
+            A hash join hashes each record put into the join buffer and
+            each row read from the table once, and compares only the
+            records with the same hash value. Lacking statistics on the
+            join columns, assume that a row matches as many records as a
+            'ref' access over a key without statistics would return. The
+            hash table takes extra space in the join buffer, so the table
+            may have to be read more times than with Block Nested Loop.
+          */
+          const double hash_scans= 1.0 +
+            ((double) (cache_record_length(join, idx) +
+                       HASH_JOIN_RECORD_OVERHEAD) *
+             record_count / (double) thd->variables.join_buff_size);
+          const double hash_records=
+            max(scan_records / MATCHING_ROWS_IN_OTHER_TABLE, 1.0);
+          const double hash_time= scan_time * hash_scans +
+            (s->records - rnd_records) * ROW_EVALUATE_COST +
+            (record_count + hash_scans * scan_records) * ROW_EVALUATE_COST;
+          const double hash_cost=
+            hash_time + record_count * ROW_EVALUATE_COST * hash_records;
+          const double bnl_cost=
+            tmp + record_count * ROW_EVALUATE_COST * scan_records;
+
+          Opt_trace_object trace_hash(trace, "hash_join");
+          trace_hash.add("rows", hash_records).add("cost", hash_cost);
+          if (hash_cost < bnl_cost)
+          {
+            tmp= hash_time;
+            scan_records= hash_records;
+            use_hash_join= true;
+          }
+          trace_hash.add("chosen", use_hash_join);
+        }
       }
     }
 
     const double scan_cost=
-      tmp + (record_count * ROW_EVALUATE_COST * rnd_records);
+      tmp + (record_count * ROW_EVALUATE_COST * scan_records);
 
-    trace_access_scan.add("rows", rows2double(rnd_records)).
+    trace_access_scan.add("rows", scan_records).
       add("cost", scan_cost);
     /*
       We estimate the cost of evaluating WHERE clause for found records
@@ -696,11 +833,12 @@ void Optimize_table_order::best_access_path(
         will ensure that this will be used
       */
       best= tmp;
-      records= rows2double(rnd_records);
+      records= scan_records;
       best_key= 0;
       /* range/index_merge/ALL/index access method are "independent", so: */
       best_ref_depends_map= 0;
       best_uses_jbuf= test(!disable_jbuf);
+      best_uses_hash_join= use_hash_join;
     }
   }
 
@@ -727,6 +865,7 @@ skip_table_scan:
   pos->ref_depend_map= best_ref_depends_map;
   pos->loosescan_key= MAX_KEY;
   pos->use_join_buffer= best_uses_jbuf;
+  pos->use_hash_join= best_uses_hash_join;
 
   if (!best_key &&
       idx == join->const_tables &&
@@ -875,6 +1014,7 @@ semijoin_loosescan_fill_driving_table_position(const JOIN_TAB  *tab,
 
   pos->read_time= DBL_MAX;
   pos->use_join_buffer= false;
+  pos->use_hash_join= false;
 
   Opt_trace_array trace_all_idx(trace, "indexes");
 
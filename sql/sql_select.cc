@@ -2282,6 +2282,11 @@ void revise_cache_usage(JOIN_TAB *join_tab)
     for any join operation (inner join, outer join, semi-join) with 'JT_ALL' 
     access method.  In that case, a JOIN_CACHE_BNL object is always employed.
 
+    If hash_join is also turned on and the join planner has estimated that
+    a hash join is cheaper for 'JT_ALL' access, a JOIN_CACHE_HASH object is
+    employed instead, provided that the condition attached to the table
+    contains an equality that can be used as the hash key.
+
     If an index is used to access rows of the joined table and batched_key_access
     is on, then a JOIN_CACHE_BKA object is employed. (Unless debug flag,
     test_bka unique, is set, then a JOIN_CACHE_BKA_UNIQUE object is employed
@@ -2463,6 +2468,21 @@ static bool setup_join_buffering(JOIN_TAB *tab, JOIN *join,
       goto no_join_cache;
     }
 
+    /*
+      Use a hash join if the join planner has chosen it for this table.
+      If no equality usable for the hash key is found when the cache is
+      initialized, fall back to Block Nested Loop.
+    */
+    if (tab->position && tab->position->use_hash_join &&
+        (tab->op= new JOIN_CACHE_HASH(join, tab, prev_cache)) &&
+        !tab->op->init())
+    {
+      *icp_other_tables_ok= FALSE;
+      DBUG_ASSERT(might_do_join_buffering(join_buffer_alg(join->thd), tab));
+      tab->use_join_cache= JOIN_CACHE::ALG_HASH;
+      return false;
+    }
+
     if (((tab->op= new JOIN_CACHE_BNL(join, tab, prev_cache)) &&
          !tab->op->init()))
     {
@@ -2661,6 +2681,7 @@ bool JOIN::setup_materialized_table(JOIN_TAB *tab, uint tableno,
   sjm_pos->sj_strategy= SJ_OPT_NONE;
 
   sjm_pos->use_join_buffer= false;
+  sjm_pos->use_hash_join= false;
 
   /*
     Key_use objects are required so that create_ref_for_key() can set up
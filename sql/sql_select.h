@@ -412,6 +412,8 @@ typedef struct st_position : public Sql_alloc
   /* If ref-based access is used: bitmap of tables this table depends on  */
   table_map ref_depend_map;
   bool use_join_buffer; 
+  /* TRUE <=> the join buffer is to be used for a hash join */
+  bool use_hash_join;
   
   
   /* These form a stack of partial join order costs and output sizes */
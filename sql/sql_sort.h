@@ -33,6 +33,9 @@ struct TABLE;
 #define MERGEBUFF		7
 #define MERGEBUFF2		15
 
+/* Upper bound of sort_parallel_degree */
+#define MAX_SORT_PARALLEL_DEGREE 64
+
 /*
    The structure SORT_ADDON_FIELD describes a fixed layout
    for field values appended to sorted values in records to be sorted
@@ -71,6 +74,18 @@ struct BUFFPEK_COMPARE_CONTEXT
   const void *key_compare_arg;
 };
 
+/*
+  Work done by one thread of a parallel filesort. Thread 0 is the
+  session thread itself. Reported in the optimizer trace.
+*/
+
+struct Sort_worker_stats
+{
+  ulonglong sorted_chunks;    // Chunks of the sort buffer sorted.
+  ulonglong sorted_keys;      // Keys in those chunks.
+  ulonglong merged_runs;      // Runs merged by merge_many_buff() passes.
+};
+
 class Sort_param {
 public:
   uint rec_length;            // Length of sorted records.
@@ -88,6 +103,8 @@ public:
   uchar *unique_buff;
   bool not_killable;
   char* tmp_buffer;
+  uint parallel_degree;       // Threads used to sort/merge, <= 1: serial.
+  Sort_worker_stats *worker_stats; // parallel_degree elements, or NULL.
   // The fields below are used only by Unique class.
   qsort2_cmp compare;
   BUFFPEK_COMPARE_CONTEXT cmp_context;
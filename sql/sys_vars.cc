@@ -64,6 +64,7 @@
 #include "sp_head.h" // SP_PSI_STATEMENT_INFO_COUNT 
 
 #include "log_event.h"
+#include "sql_sort.h"                           // MAX_SORT_PARALLEL_DEGREE
 #ifdef WITH_PERFSCHEMA_STORAGE_ENGINE
 #include "../storage/perfschema/pfs_server.h"
 #endif /* WITH_PERFSCHEMA_STORAGE_ENGINE */
@@ -1001,6 +1002,38 @@ static Sys_var_mybool Sys_binlog_order_commits(
        GLOBAL_VAR(opt_binlog_order_commits),
        CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static Sys_var_mybool Sys_binlog_parallel_flush(
+       "binlog_parallel_flush",
+       "Let the sessions of a binary log group commit copy their binary log"
+       " caches into the binary log in parallel, in byte ranges reserved in"
+       " commit order by the leader of the flush stage, instead of having the"
+       " leader copy all the caches.",
+       GLOBAL_VAR(opt_binlog_parallel_flush),
+       CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
+static const char *binlog_transaction_dependency_tracking_names[]=
+       {"COMMIT_ORDER", "WRITESET", NullS};
+static Sys_var_enum Sys_binlog_transaction_dependency_tracking(
+       "binlog_transaction_dependency_tracking",
+       "How the master tells the slave which transactions it can apply in "
+       "parallel with --slave-parallel-type=LOGICAL_CLOCK. COMMIT_ORDER: "
+       "transactions that prepared in the same binary log commit group. "
+       "WRITESET: also transactions that changed different rows, as told by "
+       "the primary and unique keys of the rows in the row events",
+       GLOBAL_VAR(opt_binlog_transaction_dependency_tracking),
+       CMD_LINE(REQUIRED_ARG), binlog_transaction_dependency_tracking_names,
+       DEFAULT(DEPENDENCY_TRACKING_COMMIT_ORDER));
+
+static Sys_var_ulong Sys_binlog_transaction_dependency_history_size(
+       "binlog_transaction_dependency_history_size",
+       "Maximum number of row hashes kept to compare the write sets of "
+       "transactions when binlog_transaction_dependency_tracking is "
+       "WRITESET. A transaction that would exceed it is not applied in "
+       "parallel with the ones before it",
+       GLOBAL_VAR(opt_binlog_transaction_dependency_history_size),
+       CMD_LINE(REQUIRED_ARG), VALID_RANGE(1, 1000000), DEFAULT(25000),
+       BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_bulk_insert_buff_size(
        "bulk_insert_buffer_size", "Size of tree cache used in bulk "
        "insert optimisation. Note that this is a limit per thread!",
@@ -2162,7 +2195,7 @@ static const char *optimizer_switch_names[]=
   "block_nested_loop", "batched_key_access",
   "materialization", "semijoin", "loosescan", "firstmatch",
   "subquery_materialization_cost_based",
-  "use_index_extensions", "default", NullS
+  "use_index_extensions", "hash_join", "default", NullS
 };
 static Sys_var_flagset Sys_optimizer_switch(
        "optimizer_switch",
@@ -2173,7 +2206,7 @@ static Sys_var_flagset Sys_optimizer_switch(
        ", materialization, semijoin, loosescan, firstmatch,"
        " subquery_materialization_cost_based"
        ", block_nested_loop, batched_key_access, use_index_extensions"
-       "} and val is one of {on, off, default}",
+       ", hash_join} and val is one of {on, off, default}",
        SESSION_VAR(optimizer_switch), CMD_LINE(REQUIRED_ARG),
        optimizer_switch_names, DEFAULT(OPTIMIZER_SWITCH_DEFAULT),
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL), ON_UPDATE(NULL));
@@ -2568,11 +2601,26 @@ static Sys_var_ulong Sys_query_cache_size(
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(fix_query_cache_size));
 
+static bool fix_query_cache_limit(sys_var *self, THD *thd, enum_var_type type)
+{
+  query_cache.result_size_limit(query_cache.query_cache_limit);
+  return false;
+}
 static Sys_var_ulong Sys_query_cache_limit(
        "query_cache_limit",
        "Don't cache results that are bigger than this",
        GLOBAL_VAR(query_cache.query_cache_limit), CMD_LINE(REQUIRED_ARG),
-       VALID_RANGE(0, ULONG_MAX), DEFAULT(1024*1024), BLOCK_SIZE(1));
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(1024*1024), BLOCK_SIZE(1),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_query_cache_limit));
+
+static Sys_var_ulong Sys_query_cache_partitions(
+       "query_cache_partitions",
+       "Number of independently locked partitions of the query cache. "
+       "A statement is cached in the partition chosen by the hash of "
+       "its text",
+       READ_ONLY GLOBAL_VAR(query_cache_partitions), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, QUERY_CACHE_MAX_PARTITIONS), DEFAULT(1), BLOCK_SIZE(1));
 
 static bool fix_qcache_min_res_unit(sys_var *self, THD *thd, enum_var_type type)
 {
@@ -2838,6 +2886,13 @@ static Sys_var_ulong Sys_sort_buffer(
        VALID_RANGE(MIN_SORT_MEMORY, ULONG_MAX), DEFAULT(DEFAULT_SORT_MEMORY),
        BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_sort_parallel_degree(
+       "sort_parallel_degree",
+       "Number of threads a sort may use to sort its buffers and to merge "
+       "sorted runs from disk. 1 sorts in the session thread only",
+       SESSION_VAR(sort_parallel_degree), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, MAX_SORT_PARALLEL_DEGREE), DEFAULT(1), BLOCK_SIZE(1));
+
 export sql_mode_t expand_sql_mode(sql_mode_t sql_mode)
 {
   if (sql_mode & MODE_ANSI)
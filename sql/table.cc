@@ -3571,6 +3571,13 @@ bool TABLE_SHARE::wait_for_old_version(THD *thd, struct timespec *abstime,
 
   mysql_mutex_unlock(&LOCK_open);
 
+  /*
+    Make metadata locks acquired on the fast path visible to the
+    deadlock detector. Can't be done under LOCK_open, which the
+    deadlock detector acquires while holding MDL_lock::m_rwlock.
+  */
+  mdl_context->materialize_fast_path_locks();
+
   mdl_context->will_wait_for(&ticket);
 
   mdl_context->find_deadlock();
@@ -0,0 +1,651 @@
+/*****************************************************************************
+
+Copyright (c) 2013, Oracle and/or its affiliates. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA
+
+*****************************************************************************/
+
+/********************************************************************//**
+@file btr/btr0bulk.cc
+The B-tree bulk load
+
+Created 10/18/2013
+*************************************************************************/
+
+#include "btr0bulk.h"
+
+#include "btr0btr.h"
+#include "buf0buf.h"
+#include "fil0fil.h"
+#include "fsp0fsp.h"
+#include "ibuf0ibuf.h"
+#include "log0log.h"
+#include "page0page.h"
+#include "rem0cmp.h"
+#include "srv0srv.h"
+#include "trx0trx.h"
+
+/**
+@param index		the index
+@param trx_id		transaction id, for PAGE_MAX_TRX_ID
+@param page_no		page number of an existing empty page
+			(the root), or FIL_NULL to allocate one
+@param level		B-tree level of the page, 0 = leaf */
+PageBulk::PageBulk(
+	dict_index_t*	index,
+	trx_id_t	trx_id,
+	ulint		page_no,
+	ulint		level)
+	:
+	m_heap(mem_heap_create(1000)),
+	m_index(index),
+	m_trx_id(trx_id),
+	m_block(NULL),
+	m_page(NULL),
+	m_cur_rec(NULL),
+	m_page_no(page_no),
+	m_prev_page_no(FIL_NULL),
+	m_level(level),
+	m_is_comp(dict_table_is_comp(index->table)),
+	m_heap_top(NULL),
+	m_rec_no(0),
+	m_free_space(0),
+	m_reserved_space(0),
+	m_modify_clock(0)
+{
+}
+
+PageBulk::~PageBulk()
+{
+	mem_heap_free(m_heap);
+}
+
+/**
+Allocate and initialize the page, and latch it.
+@return DB_SUCCESS or DB_OUT_OF_FILE_SPACE */
+dberr_t
+PageBulk::init()
+{
+	buf_block_t*	new_block;
+	page_t*		new_page;
+
+	ut_ad(!dict_table_zip_size(m_index->table));
+
+	mtr_start(&m_mtr);
+	mtr_x_lock(dict_index_get_lock(m_index), &m_mtr);
+	mtr_set_log_mode(&m_mtr, MTR_LOG_NO_REDO);
+
+	if (m_page_no == FIL_NULL) {
+		mtr_t	alloc_mtr;
+		ulint	n_reserved;
+
+		/* The allocation is redo logged, so that the file
+		segment stays consistent whatever happens to the
+		contents of the page. */
+		mtr_start(&alloc_mtr);
+
+		if (!fsp_reserve_free_extents(&n_reserved, m_index->space,
+					      1, FSP_NORMAL, &alloc_mtr)) {
+			mtr_commit(&alloc_mtr);
+			mtr_commit(&m_mtr);
+
+			return(DB_OUT_OF_FILE_SPACE);
+		}
+
+		new_block = btr_page_alloc(m_index, 0, FSP_UP, m_level,
+					   &alloc_mtr, &m_mtr);
+
+		if (n_reserved > 0) {
+			fil_space_release_free_extents(m_index->space,
+						       n_reserved);
+		}
+
+		mtr_commit(&alloc_mtr);
+
+		if (new_block == NULL) {
+			mtr_commit(&m_mtr);
+
+			return(DB_OUT_OF_FILE_SPACE);
+		}
+
+		new_page = buf_block_get_frame(new_block);
+
+		page_create(new_block, &m_mtr, m_is_comp);
+		btr_page_set_level(new_page, NULL, m_level, &m_mtr);
+		btr_page_set_next(new_page, NULL, FIL_NULL, &m_mtr);
+		btr_page_set_prev(new_page, NULL, FIL_NULL, &m_mtr);
+		btr_page_set_index_id(new_page, NULL, m_index->id, &m_mtr);
+	} else {
+		new_block = btr_block_get(m_index->space, 0, m_page_no,
+					  RW_X_LATCH, m_index, &m_mtr);
+		new_page = buf_block_get_frame(new_block);
+
+		ut_ad(page_dir_get_n_heap(new_page) == PAGE_HEAP_NO_USER_LOW);
+
+		btr_page_set_level(new_page, NULL, m_level, &m_mtr);
+	}
+
+	if (!dict_index_is_clust(m_index) && page_is_leaf(new_page)) {
+		page_update_max_trx_id(new_block, NULL, m_trx_id, &m_mtr);
+	}
+
+	/* The page directory is only built by finish(). Until then
+	the page must not be checked when it is flushed. */
+	new_block->check_index_page_at_flush = FALSE;
+
+	m_block = new_block;
+	m_page = new_page;
+	m_page_no = page_get_page_no(new_page);
+	m_cur_rec = page_get_infimum_rec(new_page);
+	m_heap_top = page_header_get_ptr(new_page, PAGE_HEAP_TOP);
+	m_rec_no = 0;
+	m_free_space = page_get_free_space_of_empty(m_is_comp);
+
+	if (srv_fill_factor == 100 && dict_index_is_clust(m_index)) {
+		/* Leave the same room for updates as the inserts
+		would leave. */
+		m_reserved_space = dict_index_get_space_reserve();
+	} else {
+		m_reserved_space
+			= UNIV_PAGE_SIZE * (100 - srv_fill_factor) / 100;
+	}
+
+	/* Let page_rec_set_next() accept the records that are
+	appended above the heap top that was created. */
+	page_header_set_field(m_page, NULL, PAGE_HEAP_TOP,
+			      UNIV_PAGE_SIZE - 1);
+
+	return(DB_SUCCESS);
+}
+
+/**
+Append a record to the page.
+@param rec		record, greater than the last one
+@param offsets		rec_get_offsets(rec) */
+void
+PageBulk::insert(
+	const rec_t*	rec,
+	ulint*		offsets)
+{
+	ulint	rec_size = rec_offs_size(offsets);
+	ulint	slot_size = page_dir_calc_reserved_space(m_rec_no + 1)
+		- page_dir_calc_reserved_space(m_rec_no);
+
+	ut_ad(m_free_space >= rec_size + slot_size);
+	ut_ad(m_heap_top + rec_size < m_page + UNIV_PAGE_SIZE);
+
+#ifdef UNIV_DEBUG
+	if (!page_rec_is_infimum(m_cur_rec)) {
+		ulint*	cur_offsets = rec_get_offsets(
+			m_cur_rec, m_index, NULL, ULINT_UNDEFINED, &m_heap);
+
+		ut_ad(cmp_rec_rec(rec, m_cur_rec, offsets, cur_offsets,
+				  m_index) > 0);
+	}
+#endif /* UNIV_DEBUG */
+
+	rec_t*	insert_rec = rec_copy(m_heap_top, rec, offsets);
+
+	rec_offs_make_valid(insert_rec, m_index, offsets);
+
+	page_rec_set_next(insert_rec, page_rec_get_next(m_cur_rec));
+	page_rec_set_next(m_cur_rec, insert_rec);
+
+	/* The owners are assigned by finish(). */
+	if (m_is_comp) {
+		rec_set_n_owned_new(insert_rec, NULL, 0);
+		rec_set_heap_no_new(insert_rec,
+				    PAGE_HEAP_NO_USER_LOW + m_rec_no);
+	} else {
+		rec_set_n_owned_old(insert_rec, 0);
+		rec_set_heap_no_old(insert_rec,
+				    PAGE_HEAP_NO_USER_LOW + m_rec_no);
+	}
+
+	m_free_space -= rec_size + slot_size;
+	m_heap_top += rec_size;
+	m_rec_no++;
+	m_cur_rec = insert_rec;
+}
+
+/**
+Build the page directory and set the page header fields, after which
+the page is a valid index page. The directory has the same shape as
+the one that page_copy_rec_list_end_to_created_page() builds. */
+void
+PageBulk::finish()
+{
+	const ulint	n_owned = (PAGE_DIR_SLOT_MAX_N_OWNED + 1) / 2;
+	page_dir_slot_t*	slot = NULL;
+	ulint		slot_index = 0;
+	ulint		count = 0;
+
+	ut_ad(m_rec_no > 0);
+
+	/* Let page_dir_get_nth_slot() accept the slots that are
+	being built. */
+	ut_d(page_dir_set_n_slots(m_page, NULL, UNIV_PAGE_SIZE / 2));
+
+	for (rec_t* rec = page_rec_get_next(page_get_infimum_rec(m_page));
+	     !page_rec_is_supremum(rec);
+	     rec = page_rec_get_next(rec)) {
+
+		if (++count == n_owned) {
+			slot = page_dir_get_nth_slot(m_page, ++slot_index);
+			page_dir_slot_set_rec(slot, rec);
+			page_dir_slot_set_n_owned(slot, NULL, count);
+			count = 0;
+		}
+	}
+
+	if (slot_index > 0
+	    && count + 1 + n_owned <= PAGE_DIR_SLOT_MAX_N_OWNED) {
+		/* Merge the last two slots, like
+		page_copy_rec_list_end_to_created_page(). */
+		count += n_owned;
+		page_dir_slot_set_n_owned(slot, NULL, 0);
+		slot_index--;
+	}
+
+	slot = page_dir_get_nth_slot(m_page, 1 + slot_index);
+	page_dir_slot_set_rec(slot, page_get_supremum_rec(m_page));
+	page_dir_slot_set_n_owned(slot, NULL, count + 1);
+
+	page_dir_set_n_slots(m_page, NULL, 2 + slot_index);
+	page_header_set_ptr(m_page, NULL, PAGE_HEAP_TOP, m_heap_top);
+	page_dir_set_n_heap(m_page, NULL, PAGE_HEAP_NO_USER_LOW + m_rec_no);
+	page_header_set_field(m_page, NULL, PAGE_N_RECS, m_rec_no);
+	page_header_set_ptr(m_page, NULL, PAGE_LAST_INSERT, m_cur_rec);
+	page_header_set_field(m_page, NULL, PAGE_DIRECTION, PAGE_RIGHT);
+	page_header_set_field(m_page, NULL, PAGE_N_DIRECTION, 0);
+
+	m_block->check_index_page_at_flush = TRUE;
+}
+
+/**
+Commit the mini-transaction and release the page.
+@param success		whether the page was finished */
+void
+PageBulk::commit(bool success)
+{
+	if (success) {
+		ut_ad(page_validate(m_page, m_index));
+
+		/* The change buffer must not count on free space
+		that the bulk load did not leave. */
+		if (!dict_index_is_clust(m_index)
+		    && !dict_table_is_temporary(m_index->table)
+		    && page_is_leaf(m_page)) {
+
+			ibuf_reset_free_bits(m_block);
+		}
+	}
+
+	/* The records were written without mlog calls, which would
+	have marked the mini-transaction as modifying the page. */
+	m_mtr.modifications = TRUE;
+
+	mtr_commit(&m_mtr);
+}
+
+/**
+Copy the records from rec to the end of another page into this
+empty page.
+@param rec		first user record to copy */
+void
+PageBulk::copyIn(const rec_t* rec)
+{
+	ulint*	offsets = NULL;
+
+	ut_ad(m_rec_no == 0);
+	ut_ad(page_rec_is_user_rec(rec));
+
+	do {
+		offsets = rec_get_offsets(rec, m_index, offsets,
+					  ULINT_UNDEFINED, &m_heap);
+		insert(rec, offsets);
+		rec = page_rec_get_next_const(rec);
+	} while (!page_rec_is_supremum(rec));
+}
+
+/**
+Build the node pointer to this page in the father page. It is
+allocated from the heap of this page.
+@return node pointer */
+dtuple_t*
+PageBulk::getNodePtr()
+{
+	rec_t*	first_rec = page_rec_get_next(page_get_infimum_rec(m_page));
+
+	ut_a(page_rec_is_user_rec(first_rec));
+
+	return(dict_index_build_node_ptr(m_index, first_rec, m_page_no,
+					 m_heap, m_level));
+}
+
+/**
+Check whether a record fits in the page, leaving the space that is
+reserved by the fill factor free.
+@param rec_size		size of the record
+@return true if the record can be appended */
+bool
+PageBulk::isSpaceAvailable(ulint rec_size) const
+{
+	ulint	required = rec_size
+		+ page_dir_calc_reserved_space(m_rec_no + 1)
+		- page_dir_calc_reserved_space(m_rec_no);
+
+	if (required > m_free_space) {
+		ut_ad(m_rec_no > 0);
+		return(false);
+	}
+
+	/* Keep at least two records on each page, or the tree
+	could grow a level for every record. */
+	return(m_rec_no < 2
+	       || m_free_space - required >= m_reserved_space);
+}
+
+/**
+Set the next page in the level.
+@param next_page_no	page number of the next page */
+void
+PageBulk::setNext(ulint next_page_no)
+{
+	btr_page_set_next(m_page, NULL, next_page_no, &m_mtr);
+}
+
+/**
+Set the previous page in the level.
+@param prev_page_no	page number of the previous page */
+void
+PageBulk::setPrev(ulint prev_page_no)
+{
+	btr_page_set_prev(m_page, NULL, prev_page_no, &m_mtr);
+	m_prev_page_no = prev_page_no;
+}
+
+/**
+Release the page latch, keeping the block buffer-fixed, so that the
+caller can wait for a log checkpoint. */
+void
+PageBulk::release()
+{
+	/* The buffer-fix keeps the block in the buffer pool, and
+	nothing else modifies a page of an index that is being
+	created, so latch() will find the page where it was. */
+	buf_page_mutex_enter(m_block);
+	buf_block_buf_fix_inc(m_block, __FILE__, __LINE__);
+	buf_page_mutex_exit(m_block);
+
+	m_modify_clock = buf_block_get_modify_clock(m_block);
+
+	m_mtr.modifications = TRUE;
+
+	mtr_commit(&m_mtr);
+}
+
+/**
+Latch the page again after release(). */
+void
+PageBulk::latch()
+{
+	mtr_start(&m_mtr);
+	mtr_x_lock(dict_index_get_lock(m_index), &m_mtr);
+	mtr_set_log_mode(&m_mtr, MTR_LOG_NO_REDO);
+
+	if (!buf_page_optimistic_get(RW_X_LATCH, m_block, m_modify_clock,
+				     __FILE__, __LINE__, &m_mtr)) {
+		/* The page cleaner may be writing the page. */
+		buf_block_t*	block = btr_block_get(
+			m_index->space, 0, m_page_no, RW_X_LATCH,
+			m_index, &m_mtr);
+
+		ut_a(block == m_block);
+	}
+
+	buf_page_mutex_enter(m_block);
+	buf_block_buf_fix_dec(m_block);
+	buf_page_mutex_exit(m_block);
+}
+
+/**
+@param index		the empty index
+@param trx		transaction, to check for interruption */
+BtrBulk::BtrBulk(
+	dict_index_t*	index,
+	const trx_t*	trx)
+	:
+	m_index(index),
+	m_trx(trx),
+	m_root_level(0)
+{
+}
+
+BtrBulk::~BtrBulk()
+{
+	ut_ad(m_page_bulks.empty());
+}
+
+/**
+Append a record to a level, starting a new page when the current one
+is full.
+@param tuple		record to append
+@param level		B-tree level, 0 = leaf
+@return DB_SUCCESS or error code */
+dberr_t
+BtrBulk::insert(
+	dtuple_t*	tuple,
+	ulint		level)
+{
+	dberr_t		err;
+
+	if (level == m_page_bulks.size()) {
+		PageBulk*	new_page_bulk = new PageBulk(
+			m_index, m_trx->id, FIL_NULL, level);
+
+		err = new_page_bulk->init();
+
+		if (err != DB_SUCCESS) {
+			delete new_page_bulk;
+			return(err);
+		}
+
+		m_page_bulks.push_back(new_page_bulk);
+		m_root_level = level;
+	}
+
+	PageBulk*	page_bulk = m_page_bulks[level];
+	ulint		rec_size = rec_get_converted_size(m_index, tuple, 0);
+
+	if (!page_bulk->isSpaceAvailable(rec_size)) {
+		PageBulk*	sibling_page_bulk = new PageBulk(
+			m_index, m_trx->id, FIL_NULL, level);
+
+		err = sibling_page_bulk->init();
+
+		if (err != DB_SUCCESS) {
+			delete sibling_page_bulk;
+			return(err);
+		}
+
+		err = pageCommit(page_bulk, sibling_page_bulk, true);
+
+		if (err != DB_SUCCESS) {
+			sibling_page_bulk->commit(false);
+			delete sibling_page_bulk;
+			return(err);
+		}
+
+		m_page_bulks[level] = sibling_page_bulk;
+		delete page_bulk;
+		page_bulk = sibling_page_bulk;
+
+		if (level == 0) {
+			if (trx_is_interrupted(m_trx)) {
+				return(DB_INTERRUPTED);
+			}
+
+			logFreeCheck();
+		}
+	}
+
+	if (level > 0 && page_bulk->getRecNo() == 0
+	    && page_bulk->isLeftMost()) {
+		/* There is no lower limit to the records in the
+		leftmost subtree of a level. */
+		dtuple_set_info_bits(tuple, dtuple_get_info_bits(tuple)
+				     | REC_INFO_MIN_REC_FLAG);
+	}
+
+	mem_heap_t*	heap = page_bulk->getHeap();
+	rec_t*		rec = rec_convert_dtuple_to_rec(
+		static_cast<byte*>(mem_heap_alloc(heap, rec_size)),
+		m_index, tuple, 0);
+	ulint*		offsets = rec_get_offsets(
+		rec, m_index, NULL, ULINT_UNDEFINED, &heap);
+
+	page_bulk->insert(rec, offsets);
+
+	return(DB_SUCCESS);
+}
+
+/**
+Finish a page, link it to the next page and append its node pointer to
+the level above, then commit it.
+@param page_bulk	the page
+@param next_page_bulk	next page in the level, or NULL
+@param insert_father	whether to append the node pointer
+@return DB_SUCCESS or error code */
+dberr_t
+BtrBulk::pageCommit(
+	PageBulk*	page_bulk,
+	PageBulk*	next_page_bulk,
+	bool		insert_father)
+{
+	page_bulk->finish();
+
+	if (next_page_bulk != NULL) {
+		ut_ad(page_bulk->getLevel() == next_page_bulk->getLevel());
+
+		page_bulk->setNext(next_page_bulk->getPageNo());
+		next_page_bulk->setPrev(page_bulk->getPageNo());
+	} else {
+		page_bulk->setNext(FIL_NULL);
+	}
+
+	if (insert_father) {
+		dberr_t	err = insert(page_bulk->getNodePtr(),
+				     page_bulk->getLevel() + 1);
+
+		if (err != DB_SUCCESS) {
+			return(err);
+		}
+	}
+
+	page_bulk->commit(true);
+
+	return(DB_SUCCESS);
+}
+
+/**
+Release all the pages being built, wait for a log checkpoint if one is
+needed, and latch the pages again. */
+void
+BtrBulk::logFreeCheck()
+{
+	if (!log_sys->check_flush_or_checkpoint) {
+		return;
+	}
+
+	for (ulint level = 0; level <= m_root_level; level++) {
+		m_page_bulks[level]->release();
+	}
+
+	log_free_check();
+
+	for (ulint level = 0; level <= m_root_level; level++) {
+		m_page_bulks[level]->latch();
+	}
+}
+
+/**
+Finish the pages of all levels and move the top page to the root page
+of the index.
+@param err		error from the inserts, or DB_SUCCESS
+@return DB_SUCCESS or error code */
+dberr_t
+BtrBulk::finish(dberr_t err)
+{
+	ulint	last_page_no = FIL_NULL;
+
+	if (m_page_bulks.empty()) {
+		/* Nothing was inserted; the root page stays empty. */
+		return(err);
+	}
+
+	/* Committing a page appends its node pointer to the level
+	above, which may add a level on top. */
+	for (ulint level = 0; level < m_page_bulks.size(); level++) {
+		PageBulk*	page_bulk = m_page_bulks[level];
+
+		last_page_no = page_bulk->getPageNo();
+
+		if (err == DB_SUCCESS) {
+			err = pageCommit(page_bulk, NULL,
+					 level != m_root_level);
+		}
+
+		if (err != DB_SUCCESS) {
+			page_bulk->commit(false);
+		}
+
+		delete page_bulk;
+	}
+
+	m_page_bulks.clear();
+
+	if (err != DB_SUCCESS) {
+		return(err);
+	}
+
+	/* The top level consists of one page. Copy it to the root
+	page, which is referenced from the data dictionary, and free
+	it. */
+	PageBulk	root_page_bulk(m_index, m_trx->id,
+				       dict_index_get_page(m_index),
+				       m_root_level);
+	mtr_t		mtr;
+
+	mtr_start(&mtr);
+	mtr_x_lock(dict_index_get_lock(m_index), &mtr);
+
+	buf_block_t*	last_block = btr_block_get(
+		m_index->space, 0, last_page_no, RW_X_LATCH, m_index, &mtr);
+
+	err = root_page_bulk.init();
+	ut_a(err == DB_SUCCESS);
+
+	root_page_bulk.copyIn(page_rec_get_next(
+		page_get_infimum_rec(buf_block_get_frame(last_block))));
+	root_page_bulk.finish();
+
+	btr_page_free_low(m_index, last_block, m_root_level, &mtr);
+
+	mtr_commit(&mtr);
+
+	root_page_bulk.commit(true);
+
+	return(DB_SUCCESS);
+}
@@ -45,9 +45,12 @@ Created 2/17/1996 Heikki Tuuri
 #include "sync0sync.h"
 
 /** Flag: has the search system been enabled?
-Protected by btr_search_latch. */
+Protected by all the btr_search_latches. */
 char		btr_search_enabled	= TRUE;
 
+/** Number of adaptive hash index partitions */
+ulong		btr_ahi_parts		= 8;
+
 #ifdef UNIV_SEARCH_PERF_STAT
 /** Number of successful adaptive hash index lookups */
 ulint		btr_search_n_succ	= 0;
@@ -57,18 +60,20 @@ ulint		btr_search_n_hash_fail	= 0;
 
 /** padding to prevent other memory update
 hotspots from residing on the same memory
-cache line as btr_search_latch */
+cache line as btr_search_latches */
 byte		btr_sea_pad1[64];
 
-/** The latch protecting the adaptive search system: this latch protects the
-(1) positions of records on those pages where a hash index has been built.
+/** The latches protecting the adaptive search system, one for each
+partition: the latch of a partition protects the
+(1) positions of records on those pages where a hash index has been built
+in that partition.
 NOTE: It does not protect values of non-ordering fields within a record from
 being updated in-place! We can use fact (1) to perform unique searches to
 indexes. */
 
-/* We will allocate the latch from dynamic memory to get it to the
-same DRAM page as other hotspot semaphores */
-rw_lock_t*		btr_search_latch_temp;
+/* We will allocate each latch separately from dynamic memory to get it
+to the same DRAM page as other hotspot semaphores */
+rw_lock_t**		btr_search_latches;
 
 /** padding to prevent other memory update hotspots from residing on
 the same memory cache line */
@@ -113,18 +118,21 @@ allocate a new node to the hash table, it will succeed. However, the check
 will not guarantee success. */
 static
 void
-btr_search_check_free_space_in_heap(void)
-/*=====================================*/
+btr_search_check_free_space_in_heap(
+/*================================*/
+	const dict_index_t*	index)	/*!< in: index whose partition
+					the nodes will be added to */
 {
 	hash_table_t*	table;
 	mem_heap_t*	heap;
+	rw_lock_t*	latch = btr_get_search_latch(index);
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_S));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-	table = btr_search_sys->hash_index;
+	table = btr_get_search_table(index);
 
 	heap = table->heap;
 
@@ -135,7 +143,7 @@ btr_search_check_free_space_in_heap(void)
 	if (heap->free_block == NULL) {
 		buf_block_t*	block = buf_block_alloc(NULL);
 
-		rw_lock_x_lock(&btr_search_latch);
+		rw_lock_x_lock(latch);
 
 		if (heap->free_block == NULL) {
 			heap->free_block = block;
@@ -143,7 +151,7 @@ btr_search_check_free_space_in_heap(void)
 			buf_block_free(block);
 		}
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	}
 }
 
@@ -155,24 +163,42 @@ btr_search_sys_create(
 /*==================*/
 	ulint	hash_size)	/*!< in: hash index hash table size */
 {
-	/* We allocate the search latch from dynamic memory:
+	ut_a(btr_ahi_parts > 0 && btr_ahi_parts <= BTR_AHI_PARTS_MAX);
+
+	/* We allocate the search latches from dynamic memory:
 	see above at the global variable definition */
 
-	btr_search_latch_temp = reinterpret_cast<rw_lock_t*>(
-		mem_alloc(sizeof(rw_lock_t)));
+	btr_search_latches = reinterpret_cast<rw_lock_t**>(
+		mem_alloc(sizeof(rw_lock_t*) * btr_ahi_parts));
+
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+
+		btr_search_latches[i] = reinterpret_cast<rw_lock_t*>(
+			mem_alloc(sizeof(rw_lock_t)));
 
-	rw_lock_create(
-		btr_search_latch_key, &btr_search_latch, SYNC_SEARCH_SYS);
+		rw_lock_create(btr_search_latch_key,
+			       btr_search_latches[i], SYNC_SEARCH_SYS);
+	}
 
 	btr_search_sys = reinterpret_cast<btr_search_sys_t*>(
 		mem_alloc(sizeof(btr_search_sys_t)));
 
-	btr_search_sys->hash_index = ib_create(
-		hash_size, "hash_table_mutex", 0, MEM_HEAP_FOR_BTR_SEARCH);
+	btr_search_sys->hash_tables = reinterpret_cast<hash_table_t**>(
+		mem_alloc(sizeof(hash_table_t*) * btr_ahi_parts));
+
+	/* Each partition gets an equal share of the cells. */
+	hash_size = ut_max(hash_size / btr_ahi_parts, ulint(1));
+
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+
+		btr_search_sys->hash_tables[i] = ib_create(
+			hash_size, "hash_table_mutex", 0,
+			MEM_HEAP_FOR_BTR_SEARCH);
 
 #if defined UNIV_AHI_DEBUG || defined UNIV_DEBUG
-	btr_search_sys->hash_index->adaptive = TRUE;
+		btr_search_sys->hash_tables[i]->adaptive = TRUE;
 #endif /* UNIV_AHI_DEBUG || UNIV_DEBUG */
+	}
 }
 
 /*****************************************************************//**
@@ -182,11 +208,19 @@ void
 btr_search_sys_free(void)
 /*=====================*/
 {
-	rw_lock_free(&btr_search_latch);
-	mem_free(btr_search_latch_temp);
-	btr_search_latch_temp = NULL;
-	mem_heap_free(btr_search_sys->hash_index->heap);
-	hash_table_free(btr_search_sys->hash_index);
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+
+		rw_lock_free(btr_search_latches[i]);
+		mem_free(btr_search_latches[i]);
+
+		mem_heap_free(btr_search_sys->hash_tables[i]->heap);
+		hash_table_free(btr_search_sys->hash_tables[i]);
+	}
+
+	mem_free(btr_search_latches);
+	btr_search_latches = NULL;
+
+	mem_free(btr_search_sys->hash_tables);
 	mem_free(btr_search_sys);
 	btr_search_sys = NULL;
 }
@@ -203,7 +237,7 @@ btr_search_disable_ref_count(
 
 	ut_ad(mutex_own(&dict_sys->mutex));
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(btr_search_own_all(RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
 	for (index = dict_table_get_first_index(table); index;
@@ -223,7 +257,7 @@ btr_search_disable(void)
 	dict_table_t*	table;
 
 	mutex_enter(&dict_sys->mutex);
-	rw_lock_x_lock(&btr_search_latch);
+	btr_search_x_lock_all();
 
 	btr_search_enabled = FALSE;
 
@@ -246,11 +280,13 @@ btr_search_disable(void)
 	/* Set all block->index = NULL. */
 	buf_pool_clear_hash_index();
 
-	/* Clear the adaptive hash index. */
-	hash_table_clear(btr_search_sys->hash_index);
-	mem_heap_empty(btr_search_sys->hash_index->heap);
+	/* Clear the adaptive hash index partitions. */
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+		hash_table_clear(btr_search_sys->hash_tables[i]);
+		mem_heap_empty(btr_search_sys->hash_tables[i]->heap);
+	}
 
-	rw_lock_x_unlock(&btr_search_latch);
+	btr_search_x_unlock_all();
 }
 
 /********************************************************************//**
@@ -260,11 +296,11 @@ void
 btr_search_enable(void)
 /*====================*/
 {
-	rw_lock_x_lock(&btr_search_latch);
+	btr_search_x_lock_all();
 
 	btr_search_enabled = TRUE;
 
-	rw_lock_x_unlock(&btr_search_latch);
+	btr_search_x_unlock_all();
 }
 
 /*****************************************************************//**
@@ -309,26 +345,29 @@ btr_search_info_create(
 
 /*****************************************************************//**
 Returns the value of ref_count. The value is protected by
-btr_search_latch.
+the latch of the adaptive hash index partition of the index.
 @return ref_count value. */
 
 ulint
 btr_search_info_get_ref_count(
 /*==========================*/
-	btr_search_t*   info)	/*!< in: search info. */
+	btr_search_t*   info,	/*!< in: search info. */
+	dict_index_t*	index)	/*!< in: index */
 {
-	ulint ret;
+	ulint		ret;
+	rw_lock_t*	latch = btr_get_search_latch(index);
 
 	ut_ad(info);
+	ut_ad(info == index->search_info);
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_S));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(latch);
 	ret = info->ref_count;
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(latch);
 
 	return(ret);
 }
@@ -344,16 +383,14 @@ btr_search_info_update_hash(
 	btr_search_t*	info,	/*!< in/out: search info */
 	btr_cur_t*	cursor)	/*!< in: cursor which was just positioned */
 {
-	dict_index_t*	index;
+	dict_index_t*	index = cursor->index;
 	ulint		n_unique;
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(btr_get_search_latch(index), RW_LOCK_S));
+	ut_ad(!rw_lock_own(btr_get_search_latch(index), RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-	index = cursor->index;
-
 	if (dict_index_is_ibuf(index)) {
 		/* So many deletes are performed on an insert buffer tree
 		that we do not consider a hash index useful on it: */
@@ -446,13 +483,13 @@ btr_search_update_block_hash_info(
 	btr_cur_t*	cursor __attribute__((unused)))
 				/*!< in: cursor */
 {
+	ut_ad(cursor);
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(btr_get_search_latch(cursor->index), RW_LOCK_S));
+	ut_ad(!rw_lock_own(btr_get_search_latch(cursor->index), RW_LOCK_X));
 	ut_ad(rw_lock_own(&block->lock, RW_LOCK_S)
 	      || rw_lock_own(&block->lock, RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
-	ut_ad(cursor);
 
 	info->last_hash_succ = FALSE;
 
@@ -528,7 +565,7 @@ btr_search_update_hash_ref(
 
 	ut_ad(cursor->flag == BTR_CUR_HASH_FAIL);
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(rw_lock_own(btr_get_search_latch(cursor->index), RW_LOCK_X));
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_S)
 	      || rw_lock_own(&(block->lock), RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
@@ -567,10 +604,10 @@ btr_search_update_hash_ref(
 			mem_heap_free(heap);
 		}
 #ifdef UNIV_SYNC_DEBUG
-		ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_X));
+		ut_ad(rw_lock_own(btr_get_search_latch(index), RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-		ha_insert_for_fold(btr_search_sys->hash_index, fold,
+		ha_insert_for_fold(btr_get_search_table(index), fold,
 				   block, rec);
 
 		MONITOR_INC(MONITOR_ADAPTIVE_HASH_ROW_ADDED);
@@ -588,10 +625,11 @@ btr_search_info_update_slow(
 {
 	buf_block_t*	block;
 	ibool		build_index;
+	rw_lock_t*	latch = btr_get_search_latch(cursor->index);
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_S));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
 	block = btr_cur_get_block(cursor);
@@ -607,7 +645,7 @@ btr_search_info_update_slow(
 
 	if (build_index || (cursor->flag == BTR_CUR_HASH_FAIL)) {
 
-		btr_search_check_free_space_in_heap();
+		btr_search_check_free_space_in_heap(cursor->index);
 	}
 
 	if (cursor->flag == BTR_CUR_HASH_FAIL) {
@@ -617,11 +655,11 @@ btr_search_info_update_slow(
 		btr_search_n_hash_fail++;
 #endif /* UNIV_SEARCH_PERF_STAT */
 
-		rw_lock_x_lock(&btr_search_latch);
+		rw_lock_x_lock(latch);
 
 		btr_search_update_hash_ref(info, block, cursor);
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	}
 
 	if (build_index) {
@@ -646,8 +684,9 @@ btr_search_check_guess(
 	btr_cur_t*	cursor,	/*!< in: guessed cursor position */
 	ibool		can_only_compare_to_cursor_rec,
 				/*!< in: if we do not have a latch on the page
-				of cursor, but only a latch on
-				btr_search_latch, then ONLY the columns
+				of cursor, but only a latch on the
+				partition latch of the adaptive hash index,
+				then ONLY the columns
 				of the record UNDER the cursor are
 				protected, not the next or previous record
 				in the chain: we cannot look at the next or
@@ -776,12 +815,33 @@ exit_func:
 	return(success);
 }
 
+/******************************************************************//**
+Counts a lookup in an adaptive hash index partition in the
+INFORMATION_SCHEMA.INNODB_METRICS counters of the partition. */
+static
+void
+btr_search_part_monitor_inc(
+/*========================*/
+	ulint	part,	/*!< in: adaptive hash index partition */
+	bool	hit)	/*!< in: true if the lookup succeeded */
+{
+	monitor_id_t	monitor = static_cast<monitor_id_t>(
+		MONITOR_ADAPTIVE_HASH_PART_0_HITS + 2 * part + (hit ? 0 : 1));
+
+	ut_ad(part < BTR_AHI_PARTS_MAX);
+
+	MONITOR_INC(monitor);
+}
+
 static
 void
 btr_search_failure(btr_search_t* info, btr_cur_t* cursor)
 {
 	cursor->flag = BTR_CUR_HASH_FAIL;
 
+	btr_search_part_monitor_inc(btr_search_get_part(cursor->index->id),
+				    false);
+
 #ifdef UNIV_SEARCH_PERF_STAT
 	++info->n_hash_fail;
 
@@ -815,18 +875,21 @@ btr_search_guess_on_hash(
 					to protect the record! */
 	btr_cur_t*	cursor,		/*!< out: tree cursor */
 	ulint		has_search_latch,/*!< in: latch mode the caller
-					currently has on btr_search_latch:
+					currently has on the partition
+					latch btr_get_search_latch(index):
 					RW_S_LATCH, RW_X_LATCH, or 0 */
 	mtr_t*		mtr)		/*!< in: mtr */
 {
 	const rec_t*	rec;
 	ulint		fold;
 	index_id_t	index_id;
+	rw_lock_t*	latch;
 #ifdef notdefined
 	btr_cur_t	cursor2;
 	btr_pcur_t	pcur;
 #endif
 	ut_ad(index && info && tuple && cursor && mtr);
+	ut_ad(cursor->index == index);
 	ut_ad(!dict_index_is_ibuf(index));
 	ut_ad((latch_mode == BTR_SEARCH_LEAF)
 	      || (latch_mode == BTR_MODIFY_LEAF));
@@ -856,6 +919,8 @@ btr_search_guess_on_hash(
 	cursor->fold = fold;
 	cursor->flag = BTR_CUR_HASH;
 
+	latch = btr_get_search_latch(index);
+
 	if (!has_search_latch) {
 
 		if (!btr_search_enabled) {
@@ -864,18 +929,19 @@ btr_search_guess_on_hash(
 			return(FALSE);
 		}
 
-		rw_lock_s_lock(&btr_search_latch);
+		rw_lock_s_lock(latch);
 	}
 
-	ut_ad(rw_lock_get_writer(&btr_search_latch) != RW_LOCK_X);
-	ut_ad(rw_lock_get_reader_count(&btr_search_latch) > 0);
+	ut_ad(rw_lock_get_writer(latch) != RW_LOCK_X);
+	ut_ad(rw_lock_get_reader_count(latch) > 0);
 
-	rec = (rec_t*) ha_search_and_get_data(btr_search_sys->hash_index, fold);
+	rec = (rec_t*) ha_search_and_get_data(btr_get_search_table(index),
+					      fold);
 
 	if (rec == NULL) {
 
 		if (!has_search_latch) {
-			rw_lock_s_unlock(&btr_search_latch);
+			rw_lock_s_unlock(latch);
 		}
 
 		btr_search_failure(info, cursor);
@@ -892,7 +958,7 @@ btr_search_guess_on_hash(
 			__FILE__, __LINE__, mtr)) {
 
 			if (!has_search_latch) {
-				rw_lock_s_unlock(&btr_search_latch);
+				rw_lock_s_unlock(latch);
 			}
 
 			btr_search_failure(info, cursor);
@@ -900,7 +966,7 @@ btr_search_guess_on_hash(
 			return(FALSE);
 		}
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		buf_block_dbg_add_level(block, SYNC_TREE_NODE_FROM_HASH);
 	}
@@ -925,8 +991,8 @@ btr_search_guess_on_hash(
 
 	/* Check the validity of the guess within the page */
 
-	/* If we only have the latch on btr_search_latch, not on the
-	page, it only protects the columns of the record the cursor
+	/* If we only have the partition latch of the adaptive hash index,
+	not on the page, it only protects the columns of the record the cursor
 	is positioned on. We cannot look at the next of the previous
 	record to determine if our guess for the cursor position is
 	right. */
@@ -986,6 +1052,8 @@ btr_search_guess_on_hash(
 #endif
 	info->last_hash_succ = TRUE;
 
+	btr_search_part_monitor_inc(btr_search_get_part(index_id), true);
+
 #ifdef UNIV_SEARCH_PERF_STAT
 	btr_search_n_succ++;
 #endif
@@ -1036,30 +1104,40 @@ btr_search_drop_page_hash_index(
 	const dict_index_t*	index;
 	ulint*			offsets;
 	btr_search_t*		info;
-
-#ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_S));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
-#endif /* UNIV_SYNC_DEBUG */
+	ulint			part;
+	rw_lock_t*		latch;
 
 	/* Do a dirty check on block->index, return if the block is
 	not in the adaptive hash index. This is to avoid acquiring
-	shared btr_search_latch for performance consideration. */
+	a shared partition latch for performance consideration. */
 	if (!block->index) {
 		return;
 	}
 
+	/* The caller prevents the page from being reused or modified,
+	and a hashed page always belongs to block->index, so the index id
+	on the page selects the partition of the hash entries. */
+	part = btr_search_get_part(btr_page_get_index_id(block->frame));
+	latch = btr_search_latches[part];
+
+#ifdef UNIV_SYNC_DEBUG
+	ut_ad(!rw_lock_own(latch, RW_LOCK_S));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_X));
+#endif /* UNIV_SYNC_DEBUG */
+
 retry:
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(latch);
 	index = block->index;
 
 	if (UNIV_LIKELY(!index)) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		return;
 	}
 
+	ut_ad(btr_search_get_part(index->id) == part);
+
 	ut_a(!dict_index_is_ibuf(index));
 #ifdef UNIV_DEBUG
 	switch (dict_index_get_online_status(index)) {
@@ -1082,7 +1160,7 @@ retry:
 	}
 #endif /* UNIV_DEBUG */
 
-	table = btr_search_sys->hash_index;
+	table = btr_search_sys->hash_tables[part];
 
 #ifdef UNIV_SYNC_DEBUG
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_S)
@@ -1094,10 +1172,10 @@ retry:
 	n_fields = block->curr_n_fields;
 
 	/* NOTE: The fields of block must not be accessed after
-	releasing btr_search_latch, as the index page might only
+	releasing the partition latch, as the index page might only
 	be s-latched! */
 
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(latch);
 
 	ut_a(n_fields > 0);
 
@@ -1148,7 +1226,7 @@ next_rec:
 		mem_heap_free(heap);
 	}
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(latch);
 
 	if (UNIV_UNLIKELY(!block->index)) {
 		/* Someone else has meanwhile dropped the hash index */
@@ -1163,7 +1241,7 @@ next_rec:
 		/* Someone else has meanwhile built a new hash index on the
 		page, with different parameters */
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 
 		mem_free(folds);
 		goto retry;
@@ -1194,14 +1272,14 @@ cleanup:
 			"InnoDB: the hash index to a page of %s,"
 			" still %lu hash nodes remain.\n",
 			index->name, (ulong) block->n_pointers);
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 
 		ut_ad(btr_search_validate());
 	} else {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	}
 #else /* UNIV_AHI_DEBUG || UNIV_DEBUG */
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(latch);
 #endif /* UNIV_AHI_DEBUG || UNIV_DEBUG */
 
 	mem_free(folds);
@@ -1274,35 +1352,38 @@ btr_search_build_page_hash_index(
 	mem_heap_t*	heap		= NULL;
 	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
 	ulint*		offsets		= offsets_;
+	rw_lock_t*	latch;
 	rec_offs_init(offsets_);
 
 	ut_ad(index);
 	ut_a(!dict_index_is_ibuf(index));
 
+	latch = btr_get_search_latch(index);
+
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_X));
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_S)
 	      || rw_lock_own(&(block->lock), RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(latch);
 
 	if (!btr_search_enabled) {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 		return;
 	}
 
-	table = btr_search_sys->hash_index;
+	table = btr_get_search_table(index);
 	page = buf_block_get_frame(block);
 
 	if (block->index && ((block->curr_n_fields != n_fields)
 			     || (block->curr_left_side != left_side))) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		btr_search_drop_page_hash_index(block);
 	} else {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 	}
 
 	n_recs = page_get_n_recs(page);
@@ -1389,9 +1470,9 @@ btr_search_build_page_hash_index(
 		fold = next_fold;
 	}
 
-	btr_search_check_free_space_in_heap();
+	btr_search_check_free_space_in_heap(index);
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(latch);
 
 	if (UNIV_UNLIKELY(!btr_search_enabled)) {
 		goto exit_func;
@@ -1425,7 +1506,7 @@ btr_search_build_page_hash_index(
 	MONITOR_INC(MONITOR_ADAPTIVE_HASH_PAGE_ADDED);
 	MONITOR_INC_VALUE(MONITOR_ADAPTIVE_HASH_ROW_ADDED, n_cached);
 exit_func:
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(latch);
 
 	mem_free(folds);
 	mem_free(recs);
@@ -1451,12 +1532,14 @@ btr_search_move_or_delete_hash_entries(
 					from this page */
 	dict_index_t*	index)		/*!< in: record descriptor */
 {
+	rw_lock_t*	latch = btr_get_search_latch(index);
+
 #ifdef UNIV_SYNC_DEBUG
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_X));
 	ut_ad(rw_lock_own(&(new_block->lock), RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(latch);
 
 	ut_a(!new_block->index || new_block->index == index);
 	ut_a(!block->index || block->index == index);
@@ -1465,7 +1548,7 @@ btr_search_move_or_delete_hash_entries(
 
 	if (new_block->index) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		btr_search_drop_page_hash_index(block);
 
@@ -1479,7 +1562,7 @@ btr_search_move_or_delete_hash_entries(
 		new_block->n_fields = block->curr_n_fields;
 		new_block->left_side = left_side;
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		ut_a(n_fields > 0);
 
@@ -1490,7 +1573,7 @@ btr_search_move_or_delete_hash_entries(
 		return;
 	}
 
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(latch);
 }
 
 /********************************************************************//**
@@ -1529,7 +1612,7 @@ btr_search_update_hash_on_delete(
 	ut_a(block->curr_n_fields > 0);
 	ut_a(!dict_index_is_ibuf(index));
 
-	table = btr_search_sys->hash_index;
+	table = btr_get_search_table(index);
 
 	rec = btr_cur_get_rec(cursor);
 
@@ -1540,7 +1623,7 @@ btr_search_update_hash_on_delete(
 		mem_heap_free(heap);
 	}
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(btr_get_search_latch(index));
 
 	if (block->index) {
 		ut_a(block->index == index);
@@ -1553,7 +1636,7 @@ btr_search_update_hash_on_delete(
 		}
 	}
 
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(btr_get_search_latch(index));
 }
 
 /********************************************************************//**
@@ -1571,6 +1654,7 @@ btr_search_update_hash_node_on_insert(
 	buf_block_t*	block;
 	dict_index_t*	index;
 	rec_t*		rec;
+	rw_lock_t*	latch;
 
 	rec = btr_cur_get_rec(cursor);
 
@@ -1590,7 +1674,9 @@ btr_search_update_hash_node_on_insert(
 	ut_a(cursor->index == index);
 	ut_a(!dict_index_is_ibuf(index));
 
-	rw_lock_x_lock(&btr_search_latch);
+	latch = btr_get_search_latch(index);
+
+	rw_lock_x_lock(latch);
 
 	if (!block->index) {
 
@@ -1603,7 +1689,7 @@ btr_search_update_hash_node_on_insert(
 	    && (cursor->n_fields == block->curr_n_fields)
 	    && !block->curr_left_side) {
 
-		table = btr_search_sys->hash_index;
+		table = btr_get_search_table(index);
 
 		if (ha_search_and_update_if_found(
 			table, cursor->fold, rec, block,
@@ -1612,9 +1698,9 @@ btr_search_update_hash_node_on_insert(
 		}
 
 func_exit:
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	} else {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 
 		btr_search_update_hash_on_insert(cursor);
 	}
@@ -1643,6 +1729,7 @@ btr_search_update_hash_on_insert(
 	ulint		n_fields;
 	ibool		left_side;
 	ibool		locked		= FALSE;
+	rw_lock_t*	latch;
 	mem_heap_t*	heap		= NULL;
 	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
 	ulint*		offsets		= offsets_;
@@ -1661,9 +1748,10 @@ btr_search_update_hash_on_insert(
 		return;
 	}
 
-	btr_search_check_free_space_in_heap();
+	btr_search_check_free_space_in_heap(index);
 
-	table = btr_search_sys->hash_index;
+	table = btr_get_search_table(index);
+	latch = btr_get_search_latch(index);
 
 	rec = btr_cur_get_rec(cursor);
 
@@ -1693,7 +1781,7 @@ btr_search_update_hash_on_insert(
 	} else {
 		if (left_side) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(latch);
 
 			locked = TRUE;
 
@@ -1711,7 +1799,7 @@ btr_search_update_hash_on_insert(
 
 		if (!locked) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(latch);
 
 			locked = TRUE;
 
@@ -1733,7 +1821,7 @@ check_next_rec:
 		if (!left_side) {
 
 			if (!locked) {
-				rw_lock_x_lock(&btr_search_latch);
+				rw_lock_x_lock(latch);
 
 				locked = TRUE;
 
@@ -1752,7 +1840,7 @@ check_next_rec:
 
 		if (!locked) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(latch);
 
 			locked = TRUE;
 
@@ -1779,18 +1867,19 @@ function_exit:
 		mem_heap_free(heap);
 	}
 	if (locked) {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	}
 }
 
 #if defined UNIV_AHI_DEBUG || defined UNIV_DEBUG
 /********************************************************************//**
-Validates the search system.
+Validates one partition of the search system.
 @return TRUE if ok */
-
+static
 ibool
-btr_search_validate(void)
-/*=====================*/
+btr_search_hash_table_validate(
+/*===========================*/
+	ulint	part)	/*!< in: adaptive hash index partition */
 {
 	ha_node_t*	node;
 	ulint		n_page_dumps	= 0;
@@ -1802,29 +1891,29 @@ btr_search_validate(void)
 	ulint*		offsets		= offsets_;
 
 	/* How many cells to check before temporarily releasing
-	btr_search_latch. */
+	the partition latch. */
 	ulint		chunk_size = 10000;
 
 	rec_offs_init(offsets_);
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(btr_search_latches[part]);
 	buf_pool_mutex_enter_all();
 
-	cell_count = hash_get_n_cells(btr_search_sys->hash_index);
+	cell_count = hash_get_n_cells(btr_search_sys->hash_tables[part]);
 
 	for (i = 0; i < cell_count; i++) {
-		/* We release btr_search_latch every once in a while to
+		/* We release the partition latch every once in a while to
 		give other queries a chance to run. */
 		if ((i != 0) && ((i % chunk_size) == 0)) {
 			buf_pool_mutex_exit_all();
-			rw_lock_x_unlock(&btr_search_latch);
+			rw_lock_x_unlock(btr_search_latches[part]);
 			os_thread_yield();
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(btr_search_latches[part]);
 			buf_pool_mutex_enter_all();
 		}
 
 		node = (ha_node_t*)
-			hash_get_nth_cell(btr_search_sys->hash_index, i)->node;
+			hash_get_nth_cell(btr_search_sys->hash_tables[part], i)->node;
 
 		for (; node != NULL; node = node->next) {
 			const buf_block_t*	block
@@ -1862,7 +1951,7 @@ btr_search_validate(void)
 				After that, it invokes
 				btr_search_drop_page_hash_index() to
 				remove the block from
-				btr_search_sys->hash_index. */
+				btr_search_sys->hash_tables[part]. */
 
 				ut_a(buf_block_get_state(block)
 				     == BUF_BLOCK_REMOVE_HASH);
@@ -1925,27 +2014,46 @@ btr_search_validate(void)
 	for (i = 0; i < cell_count; i += chunk_size) {
 		ulint end_index = ut_min(i + chunk_size - 1, cell_count - 1);
 
-		/* We release btr_search_latch every once in a while to
+		/* We release the partition latch every once in a while to
 		give other queries a chance to run. */
 		if (i != 0) {
 			buf_pool_mutex_exit_all();
-			rw_lock_x_unlock(&btr_search_latch);
+			rw_lock_x_unlock(btr_search_latches[part]);
 			os_thread_yield();
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(btr_search_latches[part]);
 			buf_pool_mutex_enter_all();
 		}
 
-		if (!ha_validate(btr_search_sys->hash_index, i, end_index)) {
+		if (!ha_validate(btr_search_sys->hash_tables[part], i, end_index)) {
 			ok = FALSE;
 		}
 	}
 
 	buf_pool_mutex_exit_all();
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(btr_search_latches[part]);
 	if (UNIV_LIKELY_NULL(heap)) {
 		mem_heap_free(heap);
 	}
 
 	return(ok);
 }
+
+/********************************************************************//**
+Validates the search system.
+@return TRUE if ok */
+
+ibool
+btr_search_validate(void)
+/*=====================*/
+{
+	ibool	ok = TRUE;
+
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+		if (!btr_search_hash_table_validate(i)) {
+			ok = FALSE;
+		}
+	}
+
+	return(ok);
+}
 #endif /* defined UNIV_AHI_DEBUG || defined UNIV_DEBUG */
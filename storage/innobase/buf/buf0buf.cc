@@ -1558,6 +1558,20 @@ buf_pool_init(
 
 	btr_search_sys_create(buf_pool_get_curr_size() / sizeof(void*) / 64);
 
+	/* Let io_uring read and write the page frames without mapping
+	them on every request. */
+	for (i = 0; i < n_instances; i++) {
+		const buf_pool_t*	buf_pool = buf_pool_from_array(i);
+
+		for (ulint j = 0; j < buf_pool->n_chunks; j++) {
+			const buf_chunk_t*	chunk = &buf_pool->chunks[j];
+
+			os_aio_add_fixed_buffer(chunk->mem, chunk->mem_size);
+		}
+	}
+
+	os_aio_register_fixed_buffers();
+
 	return(DB_SUCCESS);
 }
 
@@ -1588,7 +1602,7 @@ buf_pool_clear_hash_index(void)
 	ulint	p;
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_X));
+	ut_ad(btr_search_own_all(RW_LOCK_X));
 #endif /* UNIV_SYNC_DEBUG */
 	ut_ad(!btr_search_enabled);
 
@@ -1605,8 +1619,9 @@ buf_pool_clear_hash_index(void)
 				dict_index_t*	index	= block->index;
 
 				/* We can set block->index = NULL
-				when we have an x-latch on btr_search_latch;
-				see the comment in buf0buf.h */
+				when we have an x-latch on the
+				btr_search_latches; see the comment
+				in buf0buf.h */
 
 				if (!index) {
 					/* Not hashed */
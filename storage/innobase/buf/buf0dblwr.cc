@@ -25,6 +25,8 @@ Created 2011/12/19
 
 #include "ha_prototypes.h"
 
+#include <map>
+
 #include "buf0dblwr.h"
 
 #ifdef UNIV_NONINL
@@ -33,6 +35,7 @@ Created 2011/12/19
 
 #include "buf0buf.h"
 #include "buf0checksum.h"
+#include "os0file.h"
 #include "srv0start.h"
 #include "srv0srv.h"
 #include "page0zip.h"
@@ -116,6 +119,110 @@ buf_dblwr_sync_datafiles()
 	fil_flush_file_spaces(FIL_TABLESPACE);
 }
 
+/****************************************************************//**
+Builds the path of the file of a doublewrite shard. */
+static
+void
+buf_dblwr_shard_file_name(
+/*======================*/
+	ulint	shard_no,	/*!< in: shard number */
+	char*	name,		/*!< out: file path */
+	ulint	size)		/*!< in: size of name */
+{
+	ut_snprintf(name, size, "%s%cib_dblwr_%lu",
+		    srv_data_home, SRV_PATH_SEPARATOR, (ulong) shard_no);
+}
+
+/****************************************************************//**
+Checks if the file of a doublewrite shard exists.
+@return true if the file exists */
+static
+bool
+buf_dblwr_shard_file_exists(
+/*========================*/
+	ulint	shard_no)	/*!< in: shard number */
+{
+	char		name[OS_FILE_MAX_PATH];
+	ibool		exists;
+	os_file_type_t	type;
+
+	buf_dblwr_shard_file_name(shard_no, name, sizeof(name));
+
+	return(os_file_status(name, &exists, &type) && exists);
+}
+
+/****************************************************************//**
+Gets the doublewrite shard of a buffer pool instance and flush type.
+@return the shard */
+UNIV_INLINE
+buf_dblwr_shard_t*
+buf_dblwr_get_shard(
+/*================*/
+	ulint		buf_pool_no,	/*!< in: buffer pool instance number */
+	buf_flush_t	flush_type)	/*!< in: flush type */
+{
+	ulint	shard_no = buf_pool_no * BUF_FLUSH_N_TYPES + flush_type;
+
+	ut_ad(shard_no < buf_dblwr->n_shards);
+
+	return(&buf_dblwr->shards[shard_no]);
+}
+
+/****************************************************************//**
+Initializes a doublewrite shard and creates its file. Anything that the
+file contained has been restored by buf_dblwr_init_or_restore_pages()
+already. */
+static
+void
+buf_dblwr_shard_init(
+/*=================*/
+	buf_dblwr_shard_t*	shard,		/*!< out: shard */
+	ulint			shard_no,	/*!< in: shard number */
+	ulint			n_slots)	/*!< in: number of pages */
+{
+	char	name[OS_FILE_MAX_PATH];
+	ibool	ret;
+
+	buf_dblwr_shard_file_name(shard_no, name, sizeof(name));
+
+	shard->name = mem_strdup(name);
+
+	shard->file = os_file_create(
+		innodb_data_file_key, shard->name, OS_FILE_OVERWRITE,
+		OS_FILE_NORMAL, OS_DATA_FILE, &ret);
+
+	if (!ret
+	    || !os_file_set_size(shard->name, shard->file,
+				 (os_offset_t) n_slots * UNIV_PAGE_SIZE)) {
+
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot create the doublewrite file %s.",
+			shard->name);
+	}
+
+	mutex_create("buf_dblwr", &shard->mutex);
+
+	shard->b_event = os_event_create("dblwr_batch_event");
+	shard->s_event = os_event_create("dblwr_single_event");
+	shard->n_slots = n_slots;
+	shard->first_free = 0;
+	shard->s_reserved = 0;
+	shard->b_reserved = 0;
+
+	shard->in_use = static_cast<bool*>(
+		mem_zalloc(n_slots * sizeof(bool)));
+
+	shard->write_buf_unaligned = static_cast<byte*>(
+		ut_malloc((1 + n_slots) * UNIV_PAGE_SIZE));
+
+	shard->write_buf = static_cast<byte*>(
+		ut_align(shard->write_buf_unaligned,
+			 UNIV_PAGE_SIZE));
+
+	shard->buf_block_arr = static_cast<buf_page_t**>(
+		mem_zalloc(n_slots * sizeof(void*)));
+}
+
 /****************************************************************//**
 Creates or initialializes the doublewrite buffer at a database start. */
 static
@@ -130,8 +237,8 @@ buf_dblwr_init(
 	buf_dblwr = static_cast<buf_dblwr_t*>(
 		mem_zalloc(sizeof(buf_dblwr_t)));
 
-	/* There are two blocks of same size in the doublewrite
-	buffer. */
+	/* Each buffer pool instance has as many slots as the two blocks
+	in the system tablespace had. */
 	buf_size = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
 
 	/* There must be atleast one buffer for single page writes
@@ -139,31 +246,53 @@ buf_dblwr_init(
 	ut_a(srv_doublewrite_batch_size > 0
 	     && srv_doublewrite_batch_size < buf_size);
 
-	mutex_create("buf_dblwr", &buf_dblwr->mutex);
-
-	buf_dblwr->b_event = os_event_create("dblwr_batch_event");
-	buf_dblwr->s_event = os_event_create("dblwr_single_event");
-	buf_dblwr->first_free = 0;
-	buf_dblwr->s_reserved = 0;
-	buf_dblwr->b_reserved = 0;
-
 	buf_dblwr->block1 = mach_read_from_4(
 		doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK1);
 	buf_dblwr->block2 = mach_read_from_4(
 		doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK2);
 
-	buf_dblwr->in_use = static_cast<bool*>(
-		mem_zalloc(buf_size * sizeof(bool)));
+	if (srv_read_only_mode) {
+		/* Nothing is flushed through the doublewrite buffer in
+		read-only mode: do not create the files. */
+		return;
+	}
+
+	if (srv_use_doublewrite_buf) {
+		buf_dblwr->n_shards
+			= srv_buf_pool_instances * BUF_FLUSH_N_TYPES;
+	}
 
-	buf_dblwr->write_buf_unaligned = static_cast<byte*>(
-		ut_malloc((1 + buf_size) * UNIV_PAGE_SIZE));
+	buf_dblwr->shards = static_cast<buf_dblwr_shard_t*>(
+		mem_zalloc(buf_dblwr->n_shards * sizeof(buf_dblwr_shard_t)));
 
-	buf_dblwr->write_buf = static_cast<byte*>(
-		ut_align(buf_dblwr->write_buf_unaligned,
-			 UNIV_PAGE_SIZE));
+	for (ulint i = 0; i < buf_dblwr->n_shards; ++i) {
+		ulint	n_slots;
 
-	buf_dblwr->buf_block_arr = static_cast<buf_page_t**>(
-		mem_zalloc(buf_size * sizeof(void*)));
+		if (i % BUF_FLUSH_N_TYPES == BUF_FLUSH_SINGLE_PAGE) {
+			n_slots = buf_size - srv_doublewrite_batch_size;
+		} else {
+			n_slots = srv_doublewrite_batch_size;
+		}
+
+		buf_dblwr_shard_init(&buf_dblwr->shards[i], i, n_slots);
+	}
+
+	/* Remove the files of the buffer pool instances that are gone
+	since the last start, or all of them if the doublewrite buffer
+	is not used. Their pages have been restored already, and would
+	be out of date at the next start. */
+	for (ulint i = buf_dblwr->n_shards;; ++i) {
+		char	name[OS_FILE_MAX_PATH];
+		bool	exists;
+
+		buf_dblwr_shard_file_name(i, name, sizeof(name));
+
+		if (!os_file_delete_if_exists(
+			    innodb_data_file_key, name, &exists)
+		    || !exists) {
+			break;
+		}
+	}
 }
 
 /****************************************************************//**
@@ -343,38 +472,362 @@ start_again:
 	goto start_again;
 }
 
+/** Newest LSN of the copies of each page in the doublewrite buffer,
+keyed by space id and page number */
+typedef std::map<std::pair<ulint, ulint>, lsn_t>	buf_dblwr_lsn_map_t;
+
+/****************************************************************//**
+Gets the key of a copy of a page in the doublewrite buffer.
+@return space id and page number of the page */
+UNIV_INLINE
+std::pair<ulint, ulint>
+buf_dblwr_page_key(
+/*===============*/
+	const byte*	page)	/*!< in: copy of a page */
+{
+	return(std::make_pair(
+		       mach_read_from_4(
+			       page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID),
+		       mach_read_from_4(page + FIL_PAGE_OFFSET)));
+}
+
+/****************************************************************//**
+Remembers the LSN of a copy of a page if it is the newest copy seen.
+A page can have copies in several shards, for example when it was
+written by an LRU flush and later by a flush list batch, and only the
+newest of them may be restored. */
+static
+void
+buf_dblwr_note_page(
+/*================*/
+	const byte*		page,	/*!< in: copy of a page */
+	buf_dblwr_lsn_map_t&	lsns)	/*!< in/out: newest LSNs */
+{
+	lsn_t	lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+
+	if (lsn == 0) {
+		/* A slot that has never been written to */
+		return;
+	}
+
+	lsn_t&	newest = lsns[buf_dblwr_page_key(page)];
+
+	if (newest < lsn) {
+		newest = lsn;
+	}
+}
+
+/****************************************************************//**
+Checks if a copy of a page is the newest one in the doublewrite buffer.
+@return true if the copy may be restored */
+static
+bool
+buf_dblwr_is_newest_page(
+/*=====================*/
+	const byte*			page,	/*!< in: copy of a page */
+	const buf_dblwr_lsn_map_t&	lsns)	/*!< in: newest LSNs */
+{
+	lsn_t	lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+
+	if (lsn == 0) {
+		return(false);
+	}
+
+	buf_dblwr_lsn_map_t::const_iterator	it
+		= lsns.find(buf_dblwr_page_key(page));
+
+	return(it != lsns.end() && it->second == lsn);
+}
+
+/****************************************************************//**
+Restores a page from its copy in the doublewrite buffer if the page in
+the data file is half-written. */
+static
+void
+buf_dblwr_restore_page(
+/*===================*/
+	byte*	page,		/*!< in: copy of the page */
+	byte*	read_buf,	/*!< out: buffer of UNIV_PAGE_SIZE for
+				reading the page from the data file */
+	ulint	i)		/*!< in: position of the copy in the
+				doublewrite buffer */
+{
+	ulint	space_id = mach_read_from_4(
+		page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+	ulint	page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
+
+	if (!fil_tablespace_exists_in_mem(space_id)) {
+		/* Maybe we have dropped the single-table tablespace
+		and this page once belonged to it: do nothing */
+
+	} else if (!fil_check_adress_in_tablespace(space_id, page_no)) {
+		/* Do not report the warning if the tablespace is
+		truncated as it's reasonable */
+		if (!srv_is_tablespace_truncated(space_id)) {
+			ib_logf(IB_LOG_LEVEL_WARN,
+				"A page in the doublewrite buffer is "
+				"not within space bounds; space id %lu "
+				"page number %lu, page %lu in "
+				"doublewrite buf.",
+				(ulong) space_id, (ulong) page_no,
+				(ulong) i);
+		}
+
+	} else {
+		ulint	zip_size = fil_space_get_zip_size(space_id);
+
+		/* Read in the actual page from the file */
+		fil_io(OS_FILE_READ, true, space_id, zip_size,
+		       page_no, 0,
+		       zip_size ? zip_size : UNIV_PAGE_SIZE,
+		       read_buf, NULL);
+
+		/* Check if the page is corrupt */
+
+		if (buf_page_is_corrupted(true, read_buf, zip_size)) {
+
+			fprintf(stderr,
+				"InnoDB: Warning: database page"
+				" corruption or a failed\n"
+				"InnoDB: file read of"
+				" space %lu page %lu.\n"
+				"InnoDB: Trying to recover it from"
+				" the doublewrite buffer.\n",
+				(ulong) space_id, (ulong) page_no);
+
+			if (buf_page_is_corrupted(true, page, zip_size)) {
+				fprintf(stderr,
+					"InnoDB: Dump of the page:\n");
+				buf_page_print(
+					read_buf, zip_size,
+					BUF_PAGE_PRINT_NO_CRASH);
+				fprintf(stderr,
+					"InnoDB: Dump of"
+					" corresponding page"
+					" in doublewrite buffer:\n");
+				buf_page_print(
+					page, zip_size,
+					BUF_PAGE_PRINT_NO_CRASH);
+
+				ib_logf(IB_LOG_LEVEL_FATAL,
+					"The page in the doublewrite"
+					" buffer is corrupt. Cannot"
+					" continue operation. You"
+					" can try to recover the"
+					" database with"
+					" innodb_force_recovery=6");
+			}
+
+			/* Write the good page from the
+			doublewrite buffer to the intended
+			position */
+
+			fil_io(OS_FILE_WRITE, true, space_id,
+			       zip_size, page_no, 0,
+			       zip_size ? zip_size : UNIV_PAGE_SIZE,
+			       page, NULL);
+
+			ib_logf(IB_LOG_LEVEL_INFO,
+				"Recovered the page from"
+				" the doublewrite buffer.");
+		}
+	}
+}
+
+/****************************************************************//**
+Reads the file of a doublewrite shard as it was left by the previous
+run of the server.
+@return the pages of the file, or NULL if the file does not exist */
+static
+byte*
+buf_dblwr_read_shard_file(
+/*======================*/
+	ulint	shard_no,	/*!< in: shard number */
+	byte**	unaligned_buf,	/*!< out: buffer to free with ut_free() */
+	ulint*	n_pages)	/*!< out: number of pages in the file */
+{
+	char		name[OS_FILE_MAX_PATH];
+	ibool		exists;
+	os_file_type_t	type;
+	ibool		ret;
+	os_offset_t	size;
+	byte*		buf;
+
+	buf_dblwr_shard_file_name(shard_no, name, sizeof(name));
+
+	if (!os_file_status(name, &exists, &type) || !exists) {
+		return(NULL);
+	}
+
+	os_file_t	file = os_file_create(
+		innodb_data_file_key, name, OS_FILE_OPEN,
+		OS_FILE_NORMAL, OS_DATA_FILE, &ret);
+
+	if (!ret || (size = os_file_get_size(file)) == (os_offset_t) -1) {
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot open the doublewrite file %s.", name);
+	}
+
+	*n_pages = (ulint) (size / UNIV_PAGE_SIZE);
+
+	*unaligned_buf = static_cast<byte*>(
+		ut_malloc((1 + *n_pages) * UNIV_PAGE_SIZE));
+
+	buf = static_cast<byte*>(ut_align(*unaligned_buf, UNIV_PAGE_SIZE));
+
+	if (*n_pages > 0
+	    && !os_file_read(file, buf, 0, *n_pages * UNIV_PAGE_SIZE)) {
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot read the doublewrite file %s.", name);
+	}
+
+	os_file_close(file);
+
+	return(buf);
+}
+
+/****************************************************************//**
+Scans the files of all the doublewrite shards. The number of buffer pool
+instances may have changed since the files were written, so the files
+are read until one does not exist. */
+static
+void
+buf_dblwr_scan_shard_files(
+/*=======================*/
+	buf_dblwr_lsn_map_t&	lsns,		/*!< in/out: newest LSNs */
+	byte*			read_buf,	/*!< out: buffer for reading
+						a page from a data file, or
+						NULL to only note the LSNs
+						of the copies in lsns */
+	ulint*			n_pages_total)	/*!< in/out: number of
+						copies scanned before */
+{
+	for (ulint shard_no = 0;; ++shard_no) {
+		byte*	unaligned_buf;
+		ulint	n_pages;
+		byte*	page;
+
+		page = buf_dblwr_read_shard_file(
+			shard_no, &unaligned_buf, &n_pages);
+
+		if (page == NULL) {
+			break;
+		}
+
+		for (ulint i = 0; i < n_pages; ++i) {
+
+			if (read_buf == NULL) {
+				buf_dblwr_note_page(page, lsns);
+			} else if (buf_dblwr_is_newest_page(page, lsns)) {
+				buf_dblwr_restore_page(
+					page, read_buf, *n_pages_total + i);
+			}
+
+			page += UNIV_PAGE_SIZE;
+		}
+
+		*n_pages_total += n_pages;
+
+		ut_free(unaligned_buf);
+	}
+}
+
+/****************************************************************//**
+Reads the two blocks in the system tablespace that versions without the
+files of the shards wrote to.
+@return the pages of the blocks, to free with ut_free() */
+static
+byte*
+buf_dblwr_read_legacy_blocks(
+/*=========================*/
+	ulint	block1,		/*!< in: first page of block 1 */
+	ulint	block2,		/*!< in: first page of block 2 */
+	byte**	unaligned_buf)	/*!< out: buffer to free with ut_free() */
+{
+	byte*	buf;
+
+	*unaligned_buf = static_cast<byte*>(
+		ut_malloc((1 + 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+			  * UNIV_PAGE_SIZE));
+
+	buf = static_cast<byte*>(ut_align(*unaligned_buf, UNIV_PAGE_SIZE));
+
+	fil_io(OS_FILE_READ, true, TRX_SYS_SPACE, 0, block1, 0,
+	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       buf, NULL);
+	fil_io(OS_FILE_READ, true, TRX_SYS_SPACE, 0, block2, 0,
+	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       buf + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       NULL);
+
+	return(buf);
+}
+
+/****************************************************************//**
+Fills the two blocks in the system tablespace with zeroes. The blocks
+are not written to any more, so the copies in them only get older: they
+must not be restored over a page at a later crash recovery. */
+static
+void
+buf_dblwr_clear_legacy_blocks(
+/*==========================*/
+	ulint	block1,		/*!< in: first page of block 1 */
+	ulint	block2,		/*!< in: first page of block 2 */
+	byte*	buf)		/*!< in/out: buffer of 2 blocks */
+{
+	memset(buf, 0, 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE);
+
+	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0, block1, 0,
+	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       buf, NULL);
+	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0, block2, 0,
+	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       buf + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+	       NULL);
+
+	fil_flush_file_spaces(FIL_TABLESPACE);
+}
+
 /****************************************************************//**
 At a database startup initializes the doublewrite buffer memory structure if
 we already have a doublewrite buffer created in the data files. If we are
 upgrading to an InnoDB version which supports multiple tablespaces, then this
 function performs the necessary update operations. If we are in a crash
 recovery, this function uses a possible doublewrite buffer to restore
-half-written pages in the data files. */
+half-written pages in the data files. The files of the shards are scanned,
+and at the first start after an upgrade also the two blocks in the system
+tablespace that older versions wrote to. The blocks are cleared after
+that start has restored from them. */
 
 void
 buf_dblwr_init_or_restore_pages(
 /*============================*/
 	ibool	restore_corrupt_pages)	/*!< in: TRUE=restore pages */
 {
-	byte*	buf;
+	byte*	buf = NULL;
+	byte*	unaligned_buf = NULL;
 	byte*	read_buf;
 	byte*	unaligned_read_buf;
+	byte*	page_buf;
 	ulint	block1;
 	ulint	block2;
 	byte*	page;
 	ibool	reset_space_ids = FALSE;
 	byte*	doublewrite;
-	ulint	space_id;
-	ulint	page_no;
+	bool	use_legacy_blocks;
 	ulint	i;
 
 	/* We do the file i/o past the buffer pool */
 
-	unaligned_read_buf = static_cast<byte*>(ut_malloc(2 * UNIV_PAGE_SIZE));
+	unaligned_read_buf = static_cast<byte*>(ut_malloc(3 * UNIV_PAGE_SIZE));
 
 	read_buf = static_cast<byte*>(
 		ut_align(unaligned_read_buf, UNIV_PAGE_SIZE));
 
+	/* The trx sys header stays in read_buf; pages read from the data
+	files go to page_buf. */
+	page_buf = read_buf + UNIV_PAGE_SIZE;
+
 	/* Read the trx sys header to check if we are using the doublewrite
 	buffer */
 
@@ -383,20 +836,28 @@ buf_dblwr_init_or_restore_pages(
 	doublewrite = read_buf + TRX_SYS_DOUBLEWRITE;
 
 	if (mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_MAGIC)
-	    == TRX_SYS_DOUBLEWRITE_MAGIC_N) {
-		/* The doublewrite buffer has been created */
+	    != TRX_SYS_DOUBLEWRITE_MAGIC_N) {
+		goto leave_func;
+	}
 
-		buf_dblwr_init(doublewrite);
+	/* The doublewrite buffer has been created */
 
-		block1 = buf_dblwr->block1;
-		block2 = buf_dblwr->block2;
+	block1 = mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK1);
+	block2 = mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK2);
 
-		buf = buf_dblwr->write_buf;
-	} else {
-		goto leave_func;
+	/* The blocks in the system tablespace were cleared at the start
+	that created the files of the shards. If the files exist, the
+	blocks can only hold copies from before that start. */
+	use_legacy_blocks = !buf_dblwr_shard_file_exists(0);
+
+	if (use_legacy_blocks) {
+		buf = buf_dblwr_read_legacy_blocks(
+			block1, block2, &unaligned_buf);
 	}
 
-	if (mach_read_from_4(doublewrite + TRX_SYS_DOUBLEWRITE_SPACE_ID_STORED)
+	if (use_legacy_blocks
+	    && mach_read_from_4(doublewrite
+				+ TRX_SYS_DOUBLEWRITE_SPACE_ID_STORED)
 	    != TRX_SYS_DOUBLEWRITE_SPACE_ID_STORED_N) {
 
 		/* We are upgrading from a version < 4.1.x to a version where
@@ -411,28 +872,14 @@ buf_dblwr_init_or_restore_pages(
 			"Resetting space id's in the doublewrite buffer");
 	}
 
-	/* Read the pages from the doublewrite buffer to memory */
-
-	fil_io(OS_FILE_READ, true, TRX_SYS_SPACE, 0, block1, 0,
-	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-	       buf, NULL);
-	fil_io(OS_FILE_READ, true, TRX_SYS_SPACE, 0, block2, 0,
-	       TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-	       buf + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-	       NULL);
-	/* Check if any of these pages is half-written in data files, in the
-	intended position */
-
-	page = buf;
+	if (reset_space_ids) {
 
-	for (i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
+		page = buf;
 
-		ulint source_page_no;
-		page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
+		for (i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
 
-		if (reset_space_ids) {
+			ulint	source_page_no;
 
-			space_id = 0;
 			mach_write_to_4(page
 					+ FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID, 0);
 			/* We do not need to calculate new checksums for the
@@ -448,111 +895,81 @@ buf_dblwr_init_or_restore_pages(
 
 			fil_io(OS_FILE_WRITE, true, 0, 0, source_page_no, 0,
 			       UNIV_PAGE_SIZE, page, NULL);
-		} else {
 
-			space_id = mach_read_from_4(
-				page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+			page += UNIV_PAGE_SIZE;
 		}
+	}
 
-		if (!restore_corrupt_pages) {
-			/* The database was shut down gracefully: no need to
-			restore pages */
-
-		} else if (!fil_tablespace_exists_in_mem(space_id)) {
-			/* Maybe we have dropped the single-table tablespace
-			and this page once belonged to it: do nothing */
-
-		} else if (!fil_check_adress_in_tablespace(space_id,
-							   page_no)) {
-			/* Do not report the warning if the tablespace is
-			truncated as it's reasonable */
-			if (!srv_is_tablespace_truncated(space_id)) {
-				ib_logf(IB_LOG_LEVEL_WARN,
-					"A page in the doublewrite buffer is "
-					"not within space bounds; space id %lu "
-					"page number %lu, page %lu in "
-					"doublewrite buf.",
-					(ulong) space_id, (ulong) page_no,
-					(ulong) i);
-			}
+	if (restore_corrupt_pages) {
+		buf_dblwr_lsn_map_t	lsns;
+		ulint			n_pages = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
 
-		} else if (space_id == TRX_SYS_SPACE
-			   && ((page_no >= block1
-				&& page_no
-				< block1 + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
-			       || (page_no >= block2
-				   && page_no
-				   < (block2
-				      + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)))) {
-
-			/* It is an unwritten doublewrite buffer page:
-			do nothing */
-		} else {
-			ulint	zip_size = fil_space_get_zip_size(space_id);
+		/* Find the newest copy of each page first. An older copy
+		in another shard must not overwrite a page that was
+		half-written by a newer flush. */
 
-			/* Read in the actual page from the file */
-			fil_io(OS_FILE_READ, true, space_id, zip_size,
-			       page_no, 0,
-			       zip_size ? zip_size : UNIV_PAGE_SIZE,
-			       read_buf, NULL);
+		page = buf;
 
-			/* Check if the page is corrupt */
+		for (i = 0; use_legacy_blocks
+			    && i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
+			buf_dblwr_note_page(page, lsns);
+			page += UNIV_PAGE_SIZE;
+		}
 
-			if (buf_page_is_corrupted(true, read_buf, zip_size)) {
+		buf_dblwr_scan_shard_files(lsns, NULL, &n_pages);
 
-				fprintf(stderr,
-					"InnoDB: Warning: database page"
-					" corruption or a failed\n"
-					"InnoDB: file read of"
-					" space %lu page %lu.\n"
-					"InnoDB: Trying to recover it from"
-					" the doublewrite buffer.\n",
-					(ulong) space_id, (ulong) page_no);
-
-				if (buf_page_is_corrupted(true,
-							  page, zip_size)) {
-					fprintf(stderr,
-						"InnoDB: Dump of the page:\n");
-					buf_page_print(
-						read_buf, zip_size,
-						BUF_PAGE_PRINT_NO_CRASH);
-					fprintf(stderr,
-						"InnoDB: Dump of"
-						" corresponding page"
-						" in doublewrite buffer:\n");
-					buf_page_print(
-						page, zip_size,
-						BUF_PAGE_PRINT_NO_CRASH);
-
-					ib_logf(IB_LOG_LEVEL_FATAL,
-						"The page in the doublewrite"
-						" buffer is corrupt. Cannot"
-						" continue operation. You"
-						" can try to recover the"
-						" database with"
-						" innodb_force_recovery=6");
-				}
+		/* Check if any of these pages is half-written in data
+		files, in the intended position */
 
-				/* Write the good page from the
-				doublewrite buffer to the intended
-				position */
+		page = buf;
 
-				fil_io(OS_FILE_WRITE, true, space_id,
-				       zip_size, page_no, 0,
-				       zip_size ? zip_size : UNIV_PAGE_SIZE,
-				       page, NULL);
+		for (i = 0; use_legacy_blocks
+			    && i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * 2; i++) {
 
-				ib_logf(IB_LOG_LEVEL_INFO,
-					"Recovered the page from"
-					" the doublewrite buffer.");
+			ulint	space_id = mach_read_from_4(
+				page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID);
+			ulint	page_no = mach_read_from_4(
+				page + FIL_PAGE_OFFSET);
+
+			if (space_id == TRX_SYS_SPACE
+			    && ((page_no >= block1
+				 && page_no
+				 < block1 + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
+				|| (page_no >= block2
+				    && page_no
+				    < (block2
+				       + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)))) {
+
+				/* It is an unwritten doublewrite buffer
+				page: do nothing */
+			} else if (buf_dblwr_is_newest_page(page, lsns)) {
+				buf_dblwr_restore_page(page, page_buf, i);
 			}
+
+			page += UNIV_PAGE_SIZE;
 		}
 
-		page += UNIV_PAGE_SIZE;
+		n_pages = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
+
+		buf_dblwr_scan_shard_files(lsns, page_buf, &n_pages);
 	}
 
 	fil_flush_file_spaces(FIL_TABLESPACE);
 
+	/* The files of the shards can be emptied now. */
+	buf_dblwr_init(doublewrite);
+
+	if (use_legacy_blocks && !srv_read_only_mode) {
+		/* Once the files have been created, the blocks are not
+		scanned any more, so a crash before they are cleared
+		does no harm. */
+		buf_dblwr_clear_legacy_blocks(block1, block2, buf);
+	}
+
+	if (unaligned_buf != NULL) {
+		ut_free(unaligned_buf);
+	}
+
 leave_func:
 	ut_free(unaligned_read_buf);
 }
@@ -566,21 +983,34 @@ buf_dblwr_free(void)
 {
 	/* Free the double write data structures. */
 	ut_a(buf_dblwr != NULL);
-	ut_ad(buf_dblwr->s_reserved == 0);
-	ut_ad(buf_dblwr->b_reserved == 0);
 
-	os_event_destroy(buf_dblwr->b_event);
-	os_event_destroy(buf_dblwr->s_event);
-	ut_free(buf_dblwr->write_buf_unaligned);
-	buf_dblwr->write_buf_unaligned = NULL;
+	for (ulint i = 0; i < buf_dblwr->n_shards; ++i) {
+		buf_dblwr_shard_t*	shard = &buf_dblwr->shards[i];
 
-	mem_free(buf_dblwr->buf_block_arr);
-	buf_dblwr->buf_block_arr = NULL;
+		ut_ad(shard->s_reserved == 0);
+		ut_ad(shard->b_reserved == 0);
 
-	mem_free(buf_dblwr->in_use);
-	buf_dblwr->in_use = NULL;
+		os_event_destroy(shard->b_event);
+		os_event_destroy(shard->s_event);
+		ut_free(shard->write_buf_unaligned);
+		shard->write_buf_unaligned = NULL;
+
+		mem_free(shard->buf_block_arr);
+		shard->buf_block_arr = NULL;
+
+		mem_free(shard->in_use);
+		shard->in_use = NULL;
+
+		os_file_close(shard->file);
+		mem_free(shard->name);
+
+		mutex_free(&shard->mutex);
+	}
+
+	if (buf_dblwr->shards != NULL) {
+		mem_free(buf_dblwr->shards);
+	}
 
-	mutex_free(&buf_dblwr->mutex);
 	mem_free(buf_dblwr);
 	buf_dblwr = NULL;
 }
@@ -594,56 +1024,60 @@ buf_dblwr_update(
 	const buf_page_t*	bpage,	/*!< in: buffer block descriptor */
 	buf_flush_t		flush_type)/*!< in: flush type */
 {
-	if (!srv_use_doublewrite_buf || buf_dblwr == NULL) {
+	buf_dblwr_shard_t*	shard;
+
+	if (!srv_use_doublewrite_buf || buf_dblwr == NULL
+	    || srv_read_only_mode) {
 		return;
 	}
 
+	shard = buf_dblwr_get_shard(bpage->buf_pool_index, flush_type);
+
 	switch (flush_type) {
 	case BUF_FLUSH_LIST:
 	case BUF_FLUSH_LRU:
-		mutex_enter(&buf_dblwr->mutex);
+		mutex_enter(&shard->mutex);
 
-		ut_ad(buf_dblwr->batch_running);
-		ut_ad(buf_dblwr->b_reserved > 0);
-		ut_ad(buf_dblwr->b_reserved <= buf_dblwr->first_free);
+		ut_ad(shard->batch_running);
+		ut_ad(shard->b_reserved > 0);
+		ut_ad(shard->b_reserved <= shard->first_free);
 
-		buf_dblwr->b_reserved--;
+		shard->b_reserved--;
 
-		if (buf_dblwr->b_reserved == 0) {
-			mutex_exit(&buf_dblwr->mutex);
+		if (shard->b_reserved == 0) {
+			mutex_exit(&shard->mutex);
 			/* This will finish the batch. Sync data files
 			to the disk. */
 			fil_flush_file_spaces(FIL_TABLESPACE);
-			mutex_enter(&buf_dblwr->mutex);
+			mutex_enter(&shard->mutex);
 
 			/* We can now reuse the doublewrite memory buffer: */
-			buf_dblwr->first_free = 0;
-			buf_dblwr->batch_running = false;
-			os_event_set(buf_dblwr->b_event);
+			shard->first_free = 0;
+			shard->batch_running = false;
+			os_event_set(shard->b_event);
 		}
 
-		mutex_exit(&buf_dblwr->mutex);
+		mutex_exit(&shard->mutex);
 		break;
 	case BUF_FLUSH_SINGLE_PAGE:
 		{
-			const ulint size = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
 			ulint i;
-			mutex_enter(&buf_dblwr->mutex);
-			for (i = srv_doublewrite_batch_size; i < size; ++i) {
-				if (buf_dblwr->buf_block_arr[i] == bpage) {
-					buf_dblwr->s_reserved--;
-					buf_dblwr->buf_block_arr[i] = NULL;
-					buf_dblwr->in_use[i] = false;
+			mutex_enter(&shard->mutex);
+			for (i = 0; i < shard->n_slots; ++i) {
+				if (shard->buf_block_arr[i] == bpage) {
+					shard->s_reserved--;
+					shard->buf_block_arr[i] = NULL;
+					shard->in_use[i] = false;
 					break;
 				}
 			}
 
 			/* The block we are looking for must exist as a
 			reserved block. */
-			ut_a(i < size);
+			ut_a(i < shard->n_slots);
 		}
-		os_event_set(buf_dblwr->s_event);
-		mutex_exit(&buf_dblwr->mutex);
+		os_event_set(shard->s_event);
+		mutex_exit(&shard->mutex);
 		break;
 	case BUF_FLUSH_N_TYPES:
 		ut_error;
@@ -769,73 +1203,87 @@ buf_dblwr_write_block_to_datafile(
 }
 
 /********************************************************************//**
-Flushes possible buffered writes from the doublewrite memory buffer to disk,
-and also wakes up the aio thread if simulated aio is used. It is very
-important to call this function after a batch of writes has been posted,
-and also when we may have to wait for a page latch! Otherwise a deadlock
-of threads can occur. */
+Writes pages of a doublewrite shard to its file. */
+static
+void
+buf_dblwr_shard_write(
+/*==================*/
+	buf_dblwr_shard_t*	shard,	/*!< in: shard */
+	ulint			slot,	/*!< in: first slot to write */
+	const byte*		buf,	/*!< in: pages to write */
+	ulint			n_pages)/*!< in: number of pages */
+{
+	ut_ad(slot + n_pages <= shard->n_slots);
+
+	if (!os_file_write(shard->name, shard->file, buf,
+			   (os_offset_t) slot * UNIV_PAGE_SIZE,
+			   n_pages * UNIV_PAGE_SIZE)) {
+
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Cannot write to the doublewrite file %s.",
+			shard->name);
+	}
+}
 
+/********************************************************************//**
+Flushes possible buffered writes from the doublewrite memory buffer of a
+shard to disk. */
+static
 void
-buf_dblwr_flush_buffered_writes(void)
-/*=================================*/
+buf_dblwr_shard_flush(
+/*==================*/
+	buf_dblwr_shard_t*	shard)	/*!< in: shard */
 {
 	byte*		write_buf;
 	ulint		first_free;
-	ulint		len;
-
-	if (!srv_use_doublewrite_buf || buf_dblwr == NULL) {
-		/* Sync the writes to the disk. */
-		buf_dblwr_sync_datafiles();
-		return;
-	}
 
 try_again:
-	mutex_enter(&buf_dblwr->mutex);
+	mutex_enter(&shard->mutex);
 
 	/* Write first to doublewrite buffer blocks. We use synchronous
 	aio and thus know that file write has been completed when the
 	control returns. */
 
-	if (buf_dblwr->first_free == 0) {
+	if (shard->first_free == 0) {
 
-		mutex_exit(&buf_dblwr->mutex);
+		mutex_exit(&shard->mutex);
 
 		return;
 	}
 
-	if (buf_dblwr->batch_running) {
+	if (shard->batch_running) {
 		/* Another thread is running the batch right now. Wait
 		for it to finish. */
-		ib_int64_t	sig_count = os_event_reset(buf_dblwr->b_event);
-		mutex_exit(&buf_dblwr->mutex);
+		ib_int64_t	sig_count = os_event_reset(shard->b_event);
+		mutex_exit(&shard->mutex);
 
-		os_event_wait_low(buf_dblwr->b_event, sig_count);
+		os_event_wait_low(shard->b_event, sig_count);
 		goto try_again;
 	}
 
-	ut_a(!buf_dblwr->batch_running);
-	ut_ad(buf_dblwr->first_free == buf_dblwr->b_reserved);
+	ut_a(!shard->batch_running);
+	ut_ad(shard->first_free == shard->b_reserved);
 
 	/* Disallow anyone else to post to doublewrite buffer or to
 	start another batch of flushing. */
-	buf_dblwr->batch_running = true;
-	first_free = buf_dblwr->first_free;
+	shard->batch_running = true;
+	first_free = shard->first_free;
 
 	/* Now safe to release the mutex. Note that though no other
 	thread is allowed to post to the doublewrite batch flushing
 	but any threads working on single page flushes are allowed
 	to proceed. */
-	mutex_exit(&buf_dblwr->mutex);
+	mutex_exit(&shard->mutex);
 
-	write_buf = buf_dblwr->write_buf;
+	write_buf = shard->write_buf;
 
 	for (ulint len2 = 0, i = 0;
-	     i < buf_dblwr->first_free;
+	     i < shard->first_free;
 	     len2 += UNIV_PAGE_SIZE, i++) {
 
 		const buf_block_t*	block;
 
-		block = (buf_block_t*) buf_dblwr->buf_block_arr[i];
+		block = (buf_block_t*) shard->buf_block_arr[i];
 
 		if (buf_block_get_state(block) != BUF_BLOCK_FILE_PAGE
 		    || block->page.zip.data) {
@@ -853,57 +1301,37 @@ try_again:
 		buf_dblwr_check_page_lsn(write_buf + len2);
 	}
 
-	/* Write out the first block of the doublewrite buffer */
-	len = ut_min(TRX_SYS_DOUBLEWRITE_BLOCK_SIZE,
-		     buf_dblwr->first_free) * UNIV_PAGE_SIZE;
-
-	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-	       buf_dblwr->block1, 0, len,
-	       (void*) write_buf, NULL);
+	/* Write out the doublewrite buffer of the shard */
+	buf_dblwr_shard_write(shard, 0, write_buf, first_free);
 
-	if (buf_dblwr->first_free <= TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		/* No unwritten pages in the second block. */
-		goto flush;
-	}
-
-	/* Write out the second block of the doublewrite buffer. */
-	len = (buf_dblwr->first_free - TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
-	       * UNIV_PAGE_SIZE;
-
-	write_buf = buf_dblwr->write_buf
-		    + TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
-
-	fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-	       buf_dblwr->block2, 0, len,
-	       (void*) write_buf, NULL);
-
-flush:
 	/* increment the doublewrite flushed pages counter */
-	srv_stats.dblwr_pages_written.add(buf_dblwr->first_free);
+	srv_stats.dblwr_pages_written.add(first_free);
 	srv_stats.dblwr_writes.inc();
 
-	/* Now flush the doublewrite buffer data to disk */
-	fil_flush(TRX_SYS_SPACE);
+	/* Now flush the doublewrite buffer data to disk. Only the file
+	of this shard is synced: the batches of the other shards do not
+	wait for it. */
+	os_file_flush(shard->file);
 
 	/* We know that the writes have been flushed to disk now
 	and in recovery we will find them in the doublewrite buffer
 	blocks. Next do the writes to the intended positions. */
 
-	/* Up to this point first_free and buf_dblwr->first_free are
-	same because we have set the buf_dblwr->batch_running flag
+	/* Up to this point first_free and shard->first_free are
+	same because we have set the shard->batch_running flag
 	disallowing any other thread to post any request but we
-	can't safely access buf_dblwr->first_free in the loop below.
+	can't safely access shard->first_free in the loop below.
 	This is so because it is possible that after we are done with
 	the last iteration and before we terminate the loop, the batch
 	gets finished in the IO helper thread and another thread posts
-	a new batch setting buf_dblwr->first_free to a higher value.
-	If this happens and we are using buf_dblwr->first_free in the
+	a new batch setting shard->first_free to a higher value.
+	If this happens and we are using shard->first_free in the
 	loop termination condition then we'll end up dispatching
 	the same block twice from two different threads. */
-	ut_ad(first_free == buf_dblwr->first_free);
+	ut_ad(first_free == shard->first_free);
 	for (ulint i = 0; i < first_free; i++) {
 		buf_dblwr_write_block_to_datafile(
-			buf_dblwr->buf_block_arr[i], false);
+			shard->buf_block_arr[i], false);
 	}
 
 	/* Wake possible simulated aio thread to actually post the
@@ -914,43 +1342,76 @@ flush:
 }
 
 /********************************************************************//**
-Posts a buffer page for writing. If the doublewrite memory buffer is
-full, calls buf_dblwr_flush_buffered_writes and waits for for free
-space to appear. */
+Flushes possible buffered writes from the doublewrite memory buffer of
+one shard to disk, and also wakes up the aio thread if simulated aio is
+used. It is very important to call this function after a batch of writes
+has been posted, and also when we may have to wait for a page latch!
+Otherwise a deadlock of threads can occur. */
+
+void
+buf_dblwr_flush_buffered_writes(
+/*============================*/
+	const buf_pool_t*	buf_pool,	/*!< in: buffer pool instance */
+	buf_flush_t		flush_type)	/*!< in: BUF_FLUSH_LRU or
+						BUF_FLUSH_LIST */
+{
+	if (!srv_use_doublewrite_buf || buf_dblwr == NULL
+	    || srv_read_only_mode) {
+		/* Sync the writes to the disk. */
+		buf_dblwr_sync_datafiles();
+		return;
+	}
+
+	ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
+
+	buf_dblwr_shard_flush(
+		buf_dblwr_get_shard(buf_pool->instance_no, flush_type));
+}
+
+/********************************************************************//**
+Posts a buffer page for writing. The page goes to the shard of its buffer
+pool instance and flush type. If the doublewrite memory buffer of the
+shard is full, flushes it and waits for free space to appear. */
 
 void
 buf_dblwr_add_to_batch(
 /*====================*/
 	buf_page_t*	bpage)	/*!< in: buffer block to write */
 {
-	ulint	zip_size;
+	ulint			zip_size;
+	buf_dblwr_shard_t*	shard;
 
 	ut_a(buf_page_in_file(bpage));
 
+	shard = buf_dblwr_get_shard(
+		bpage->buf_pool_index, buf_page_get_flush_type(bpage));
+
+	ut_ad(buf_page_get_flush_type(bpage) == BUF_FLUSH_LRU
+	      || buf_page_get_flush_type(bpage) == BUF_FLUSH_LIST);
+
 try_again:
-	mutex_enter(&buf_dblwr->mutex);
+	mutex_enter(&shard->mutex);
 
-	ut_a(buf_dblwr->first_free <= srv_doublewrite_batch_size);
+	ut_a(shard->first_free <= shard->n_slots);
 
-	if (buf_dblwr->batch_running) {
+	if (shard->batch_running) {
 
-		/* This not nearly as bad as it looks. There is only
-		page_cleaner thread which does background flushing
-		in batches therefore it is unlikely to be a contention
-		point. The only exception is when a user thread is
-		forced to do a flush batch because of a sync
-		checkpoint. */
-		ib_int64_t	sig_count = os_event_reset(buf_dblwr->b_event);
-		mutex_exit(&buf_dblwr->mutex);
+		/* This not nearly as bad as it looks. Only one thread
+		at a time does a flush batch of a given type in a buffer
+		pool instance, and the other instances and flush types
+		have shards of their own. The only exception is when the
+		batch of the previous thread is still being written. */
+		ib_int64_t	sig_count = os_event_reset(shard->b_event);
+		mutex_exit(&shard->mutex);
 
-		os_event_wait_low(buf_dblwr->b_event, sig_count);
+		os_event_wait_low(shard->b_event, sig_count);
 		goto try_again;
 	}
 
-	if (buf_dblwr->first_free == srv_doublewrite_batch_size) {
-		mutex_exit(&(buf_dblwr->mutex));
+	if (shard->first_free == shard->n_slots) {
+		mutex_exit(&(shard->mutex));
 
-		buf_dblwr_flush_buffered_writes();
+		buf_dblwr_shard_flush(shard);
 
 		goto try_again;
 	}
@@ -960,46 +1421,47 @@ try_again:
 	if (zip_size) {
 		UNIV_MEM_ASSERT_RW(bpage->zip.data, zip_size);
 		/* Copy the compressed page and clear the rest. */
-		memcpy(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free,
+		memcpy(shard->write_buf
+		       + UNIV_PAGE_SIZE * shard->first_free,
 		       bpage->zip.data, zip_size);
-		memset(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free
+		memset(shard->write_buf
+		       + UNIV_PAGE_SIZE * shard->first_free
 		       + zip_size, 0, UNIV_PAGE_SIZE - zip_size);
 	} else {
 		ut_a(buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE);
 		UNIV_MEM_ASSERT_RW(((buf_block_t*) bpage)->frame,
 				   UNIV_PAGE_SIZE);
 
-		memcpy(buf_dblwr->write_buf
-		       + UNIV_PAGE_SIZE * buf_dblwr->first_free,
+		memcpy(shard->write_buf
+		       + UNIV_PAGE_SIZE * shard->first_free,
 		       ((buf_block_t*) bpage)->frame, UNIV_PAGE_SIZE);
 	}
 
-	buf_dblwr->buf_block_arr[buf_dblwr->first_free] = bpage;
+	shard->buf_block_arr[shard->first_free] = bpage;
 
-	buf_dblwr->first_free++;
-	buf_dblwr->b_reserved++;
+	shard->first_free++;
+	shard->b_reserved++;
 
-	ut_ad(!buf_dblwr->batch_running);
-	ut_ad(buf_dblwr->first_free == buf_dblwr->b_reserved);
-	ut_ad(buf_dblwr->b_reserved <= srv_doublewrite_batch_size);
+	ut_ad(!shard->batch_running);
+	ut_ad(shard->first_free == shard->b_reserved);
+	ut_ad(shard->b_reserved <= shard->n_slots);
 
-	if (buf_dblwr->first_free == srv_doublewrite_batch_size) {
-		mutex_exit(&(buf_dblwr->mutex));
+	if (shard->first_free == shard->n_slots) {
+		mutex_exit(&(shard->mutex));
 
-		buf_dblwr_flush_buffered_writes();
+		buf_dblwr_shard_flush(shard);
 
 		return;
 	}
 
-	mutex_exit(&(buf_dblwr->mutex));
+	mutex_exit(&(shard->mutex));
 }
 
 /********************************************************************//**
 Writes a page to the doublewrite buffer on disk, sync it, then write
 the page to the datafile and sync the datafile. This function is used
-for single page flushes. If all the buffers allocated for single page
+for single page flushes, which have a shard of their own in each buffer
+pool instance. If all the buffers allocated for single page
 flushes in the doublewrite buffer are in use we wait here for one to
 become free. We are guaranteed that a slot will become free because any
 thread that is using a slot must also release the slot before leaving
@@ -1011,22 +1473,16 @@ buf_dblwr_write_single_page(
 	buf_page_t*	bpage,	/*!< in: buffer block to write */
 	bool		sync)	/*!< in: true if sync IO requested */
 {
-	ulint		n_slots;
-	ulint		size;
-	ulint		zip_size;
-	ulint		offset;
-	ulint		i;
+	buf_dblwr_shard_t*	shard;
+	ulint			zip_size;
+	ulint			i;
 
 	ut_a(buf_page_in_file(bpage));
 	ut_a(srv_use_doublewrite_buf);
 	ut_a(buf_dblwr != NULL);
 
-	/* total number of slots available for single page flushes
-	starts from srv_doublewrite_batch_size to the end of the
-	buffer. */
-	size = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
-	ut_a(size > srv_doublewrite_batch_size);
-	n_slots = size - srv_doublewrite_batch_size;
+	shard = buf_dblwr_get_shard(
+		bpage->buf_pool_index, BUF_FLUSH_SINGLE_PAGE);
 
 	if (buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE) {
 
@@ -1043,52 +1499,42 @@ buf_dblwr_write_single_page(
 	}
 
 retry:
-	mutex_enter(&buf_dblwr->mutex);
-	if (buf_dblwr->s_reserved == n_slots) {
+	mutex_enter(&shard->mutex);
+	if (shard->s_reserved == shard->n_slots) {
 
 		/* All slots are reserved. */
 		ib_int64_t	sig_count =
-			os_event_reset(buf_dblwr->s_event);
-		mutex_exit(&buf_dblwr->mutex);
-		os_event_wait_low(buf_dblwr->s_event, sig_count);
+			os_event_reset(shard->s_event);
+		mutex_exit(&shard->mutex);
+		os_event_wait_low(shard->s_event, sig_count);
 
 		goto retry;
 	}
 
-	for (i = srv_doublewrite_batch_size; i < size; ++i) {
+	for (i = 0; i < shard->n_slots; ++i) {
 
-		if (!buf_dblwr->in_use[i]) {
+		if (!shard->in_use[i]) {
 			break;
 		}
 	}
 
 	/* We are guaranteed to find a slot. */
-	ut_a(i < size);
-	buf_dblwr->in_use[i] = true;
-	buf_dblwr->s_reserved++;
-	buf_dblwr->buf_block_arr[i] = bpage;
+	ut_a(i < shard->n_slots);
+	shard->in_use[i] = true;
+	shard->s_reserved++;
+	shard->buf_block_arr[i] = bpage;
 
 	/* increment the doublewrite flushed pages counter */
 	srv_stats.dblwr_pages_written.inc();
 	srv_stats.dblwr_writes.inc();
 
-	mutex_exit(&buf_dblwr->mutex);
-
-	/* Lets see if we are going to write in the first or second
-	block of the doublewrite buffer. */
-	if (i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		offset = buf_dblwr->block1 + i;
-	} else {
-		offset = buf_dblwr->block2 + i
-			 - TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
-	}
+	mutex_exit(&shard->mutex);
 
 	/* We deal with compressed and uncompressed pages a little
 	differently here. In case of uncompressed pages we can
 	directly write the block to the allocated slot in the
-	doublewrite buffer in the system tablespace and then after
-	syncing the system table space we can proceed to write the page
-	in the datafile.
+	doublewrite file and then after syncing the file we can
+	proceed to write the page in the datafile.
 	In case of compressed page we first do a memcpy of the block
 	to the in-memory buffer of doublewrite before proceeding to
 	write it. This is so because we want to pad the remaining
@@ -1096,26 +1542,22 @@ retry:
 
 	zip_size = buf_page_get_zip_size(bpage);
 	if (zip_size) {
-		memcpy(buf_dblwr->write_buf + UNIV_PAGE_SIZE * i,
+		memcpy(shard->write_buf + UNIV_PAGE_SIZE * i,
 		       bpage->zip.data, zip_size);
-		memset(buf_dblwr->write_buf + UNIV_PAGE_SIZE * i
+		memset(shard->write_buf + UNIV_PAGE_SIZE * i
 		       + zip_size, 0, UNIV_PAGE_SIZE - zip_size);
 
-		fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-		       offset, 0, UNIV_PAGE_SIZE,
-		       (void*) (buf_dblwr->write_buf
-				+ UNIV_PAGE_SIZE * i), NULL);
+		buf_dblwr_shard_write(
+			shard, i, shard->write_buf + UNIV_PAGE_SIZE * i, 1);
 	} else {
 		/* It is a regular page. Write it directly to the
 		doublewrite buffer */
-		fil_io(OS_FILE_WRITE, true, TRX_SYS_SPACE, 0,
-		       offset, 0, UNIV_PAGE_SIZE,
-		       (void*) ((buf_block_t*) bpage)->frame,
-		       NULL);
+		buf_dblwr_shard_write(
+			shard, i, ((buf_block_t*) bpage)->frame, 1);
 	}
 
 	/* Now flush the doublewrite buffer data to disk */
-	fil_flush(TRX_SYS_SPACE);
+	os_file_flush(shard->file);
 
 	/* We know that the write has been flushed to disk now
 	and during recovery we will find it in the doublewrite buffer
@@ -27,7 +27,9 @@ Created April 08, 2011 Vasil Dimov
 
 #include "buf0buf.h"
 #include "buf0dump.h"
+#include "buf0rea.h"
 #include "dict0dict.h"
+#include "os0atomic.h"
 #include "os0file.h"
 #include "os0thread.h"
 #include "srv0srv.h"
@@ -162,6 +164,23 @@ buf_load_status(
 	va_end(ap);
 }
 
+/*****************************************************************//**
+Frees the pages that buf_dump() has copied from the buffer pools. */
+static
+void
+buf_dump_free(
+/*==========*/
+	buf_dump_t**	dumps,		/*!< in: pages of each buffer pool */
+	ulint*		n_dumped)	/*!< in: number of pages in dumps */
+{
+	for (ulint i = 0; i < srv_buf_pool_instances; i++) {
+		ut_free(dumps[i]);
+	}
+
+	ut_free(dumps);
+	ut_free(n_dumped);
+}
+
 /*****************************************************************//**
 Perform a buffer pool dump into the file specified by
 innodb_buffer_pool_filename. If any errors occur then the value of
@@ -177,12 +196,17 @@ buf_dump(
 {
 #define SHOULD_QUIT()	(SHUTTING_DOWN() && obey_shutdown)
 
-	char	full_filename[OS_FILE_MAX_PATH];
-	char	tmp_filename[OS_FILE_MAX_PATH];
-	char	now[32];
-	FILE*	f;
-	ulint	i;
-	int	ret;
+	char		full_filename[OS_FILE_MAX_PATH];
+	char		tmp_filename[OS_FILE_MAX_PATH];
+	char		now[32];
+	FILE*		f;
+	buf_dump_t**	dumps;
+	ulint*		n_dumped;
+	ulint		n_total = 0;
+	ulint		n_max = 0;
+	ulint		n_written = 0;
+	ulint		i;
+	int		ret;
 
 	ut_snprintf(full_filename, sizeof(full_filename),
 		    "%s%c%s", srv_data_home, SRV_PATH_SEPARATOR,
@@ -203,6 +227,27 @@ buf_dump(
 	}
 	/* else */
 
+	dumps = static_cast<buf_dump_t**>(
+		ut_malloc(srv_buf_pool_instances * sizeof(*dumps)));
+	n_dumped = static_cast<ulint*>(
+		ut_malloc(srv_buf_pool_instances * sizeof(*n_dumped)));
+
+	if (dumps == NULL || n_dumped == NULL) {
+		ut_free(dumps);
+		ut_free(n_dumped);
+		fclose(f);
+		buf_dump_status(STATUS_ERR,
+				"Cannot allocate " ULINTPF " bytes: %s",
+				(ulint) (srv_buf_pool_instances
+					 * sizeof(*dumps)),
+				strerror(errno));
+		/* leave tmp_filename to exist */
+		return;
+	}
+
+	memset(dumps, 0, srv_buf_pool_instances * sizeof(*dumps));
+	memset(n_dumped, 0, srv_buf_pool_instances * sizeof(*n_dumped));
+
 	/* walk through each buffer pool */
 	for (i = 0; i < srv_buf_pool_instances && !SHOULD_QUIT(); i++) {
 		buf_pool_t*		buf_pool;
@@ -240,6 +285,7 @@ buf_dump(
 
 		if (dump == NULL) {
 			buf_pool_mutex_exit(buf_pool);
+			buf_dump_free(dumps, n_dumped);
 			fclose(f);
 			buf_dump_status(STATUS_ERR,
 					"Cannot allocate " ULINTPF " bytes: %s",
@@ -263,12 +309,31 @@ buf_dump(
 
 		buf_pool_mutex_exit(buf_pool);
 
-		for (j = 0; j < n_pages && !SHOULD_QUIT(); j++) {
+		dumps[i] = dump;
+		n_dumped[i] = n_pages;
+
+		n_total += n_pages;
+		n_max = ut_max(n_max, n_pages);
+	}
+
+	/* Write the pages of all the buffer pools interleaved by their
+	position in the LRU lists, starting from the most recently used
+	ones. The position of a page in the file then tells how hot it was
+	across all the buffer pools, and buf_load() can load the hottest
+	pages first. */
+	for (ulint j = 0; j < n_max && !SHOULD_QUIT(); j++) {
+
+		for (i = 0; i < srv_buf_pool_instances; i++) {
+
+			if (j >= n_dumped[i]) {
+				continue;
+			}
+
 			ret = fprintf(f, ULINTPF "," ULINTPF "\n",
-				      BUF_DUMP_SPACE(dump[j]),
-				      BUF_DUMP_PAGE(dump[j]));
+				      BUF_DUMP_SPACE(dumps[i][j]),
+				      BUF_DUMP_PAGE(dumps[i][j]));
 			if (ret < 0) {
-				ut_free(dump);
+				buf_dump_free(dumps, n_dumped);
 				fclose(f);
 				buf_dump_status(STATUS_ERR,
 						"Cannot write to '%s': %s",
@@ -277,20 +342,20 @@ buf_dump(
 				return;
 			}
 
-			if (j % 128 == 0) {
+			if (n_written % 128 == 0) {
 				buf_dump_status(
 					STATUS_INFO,
-					"Dumping buffer pool "
-					ULINTPF "/" ULINTPF ", "
+					"Dumping buffer pool(s), "
 					"page " ULINTPF "/" ULINTPF,
-					i + 1, srv_buf_pool_instances,
-					j + 1, n_pages);
+					n_written + 1, n_total);
 			}
-		}
 
-		ut_free(dump);
+			n_written++;
+		}
 	}
 
+	buf_dump_free(dumps, n_dumped);
+
 	ret = fclose(f);
 	if (ret != 0) {
 		buf_dump_status(STATUS_ERR,
@@ -340,12 +405,14 @@ buf_load_throttle_if_needed(
 	ulint*	last_check_time,	/*!< in/out: milliseconds since epoch
 					of the last time we did check if
 					throttling is needed, we do the check
-					every srv_io_capacity IO ops. */
+					every io_capacity IO ops. */
 	ulint*	last_activity_count,
-	ulint	n_io)			/*!< in: number of IO ops done since
+	ulint	n_io,			/*!< in: number of IO ops done since
 					buffer pool load has started */
+	ulint	io_capacity)		/*!< in: IO ops per second allowed
+					when there is other activity */
 {
-	if (n_io % srv_io_capacity < srv_io_capacity - 1) {
+	if (n_io % io_capacity < io_capacity - 1) {
 		return;
 	}
 
@@ -355,7 +422,7 @@ buf_load_throttle_if_needed(
 		return;
 	}
 
-	/* srv_io_capacity IO operations have been performed by buffer pool
+	/* io_capacity IO operations have been performed by buffer pool
 	load since the last time we were here. */
 
 	/* If no other activity, then keep going without any delay. */
@@ -369,19 +436,19 @@ buf_load_throttle_if_needed(
 	ulint	elapsed_time = now - *last_check_time;
 
 	/* Notice that elapsed_time is not the time for the last
-	srv_io_capacity IO operations performed by BP load. It is the
+	io_capacity IO operations performed by BP load. It is the
 	time elapsed since the last time we detected that there has been
 	other activity. This has a small and acceptable deficiency, e.g.:
 	1. BP load runs and there is no other activity.
 	2. Other activity occurs, we run N IO operations after that and
-	   enter here (where 0 <= N < srv_io_capacity).
+	   enter here (where 0 <= N < io_capacity).
 	3. last_check_time is very old and we do not sleep at this time, but
 	   only update last_check_time and last_activity_count.
-	4. We run srv_io_capacity more IO operations and call this function
+	4. We run io_capacity more IO operations and call this function
 	   again.
 	5. There has been more other activity and thus we enter here.
 	6. Now last_check_time is recent and we sleep if necessary to prevent
-	   more than srv_io_capacity IO operations per second.
+	   more than io_capacity IO operations per second.
 	The deficiency is that we could have slept at 3., but for this we
 	would have to update last_check_time before the
 	"cur_activity_count == *last_activity_count" check and calling
@@ -395,6 +462,238 @@ buf_load_throttle_if_needed(
 	*last_activity_count = srv_get_activity_count();
 }
 
+#ifdef UNIV_PFS_THREAD
+mysql_pfs_key_t	buf_load_thread_key;
+#endif /* UNIV_PFS_THREAD */
+
+/** The pages of one buffer pool instance that a buf_load_thread reads
+in turns with the other threads of the instance */
+struct buf_load_thread_t {
+	const buf_dump_t*	pages;		/*!< the pages of the instance,
+						sorted by space id and page
+						number */
+	ulint			n_pages;	/*!< number of pages */
+	ulint			thread_no;	/*!< number of the thread
+						among the threads of the
+						instance */
+	ulint			n_threads;	/*!< number of threads of the
+						instance */
+	ulint			io_capacity;	/*!< the share of
+						srv_io_capacity of the thread */
+};
+
+/** Number of buf_load_thread that have not finished yet */
+static ulint	buf_load_n_threads_active;
+
+/** Number of pages that buf_load_thread have processed in the current
+buffer pool load */
+static ulint	buf_load_n_pages_done;
+
+/*****************************************************************//**
+A thread reading the pages of a buffer pool instance in a buffer pool
+load. Pages that follow each other in a file are read with one request,
+and the threads of the instance take these ranges in turns.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(buf_load_thread)(
+/*============================*/
+	void*	arg)	/*!< in: buf_load_thread_t of the thread */
+{
+	const buf_load_thread_t*	load
+		= static_cast<const buf_load_thread_t*>(arg);
+	byte*	unaligned_buf;
+	byte*	buf;
+	ulint	last_check_time = 0;
+	ulint	last_activity_cnt = 0;
+	ulint	n_io = 0;
+	ulint	range_no = 0;
+	ulint	i = 0;
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(buf_load_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	unaligned_buf = static_cast<byte*>(
+		ut_malloc((1 + BUF_READ_RANGE_MAX_PAGES) * UNIV_PAGE_SIZE));
+
+	buf = static_cast<byte*>(ut_align(unaligned_buf, UNIV_PAGE_SIZE));
+
+	while (i < load->n_pages && !buf_load_abort_flag && !SHUTTING_DOWN()) {
+		ulint	space = BUF_DUMP_SPACE(load->pages[i]);
+		ulint	page_no = BUF_DUMP_PAGE(load->pages[i]);
+		ulint	n = 1;
+
+		while (i + n < load->n_pages
+		       && n < BUF_READ_RANGE_MAX_PAGES
+		       && BUF_DUMP_SPACE(load->pages[i + n]) == space
+		       && BUF_DUMP_PAGE(load->pages[i + n]) == page_no + n) {
+			n++;
+		}
+
+		if (range_no++ % load->n_threads == load->thread_no) {
+
+			if (space == TRX_SYS_SPACE) {
+				/* The pages of the insert buffer may be
+				needed while the pages of a range are
+				read in: read them one by one. */
+				for (ulint j = 0; j < n; j++) {
+					buf_read_page_async(
+						space, page_no + j);
+				}
+
+				os_aio_simulated_wake_handler_threads();
+			} else {
+				buf_read_page_range(space, page_no, n, buf);
+			}
+
+			os_atomic_increment_ulint(&buf_load_n_pages_done, n);
+
+			for (ulint j = 0; j < n; j++) {
+				buf_load_throttle_if_needed(
+					&last_check_time, &last_activity_cnt,
+					n_io++, load->io_capacity);
+			}
+		}
+
+		i += n;
+	}
+
+	ut_free(unaligned_buf);
+
+	os_atomic_decrement_ulint(&buf_load_n_threads_active, 1);
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*****************************************************************//**
+Loads pages of a buffer pool dump. The pages are partitioned by buffer
+pool instance and sorted by their positions in the files, and
+srv_buf_pool_load_threads buf_load_thread read the pages of each
+instance. Returns when all the threads have finished, which they do
+early if the load is aborted or the server is shutting down. */
+static
+void
+buf_load_pages(
+/*===========*/
+	const buf_dump_t*	dump,	/*!< in: pages to load */
+	ulint			n_pages,/*!< in: number of pages */
+	ulint			n_total)/*!< in: number of pages in the
+					whole load, for the status */
+{
+	buf_dump_t*		sorted;
+	ulint*			n_inst_pages;
+	ulint*			inst_start;
+	buf_load_thread_t*	threads;
+	ulint			n_threads;
+	ulint			n_started = 0;
+	ulint			io_capacity;
+	ulint			i;
+
+	if (n_pages == 0) {
+		return;
+	}
+
+	sorted = static_cast<buf_dump_t*>(
+		ut_malloc(n_pages * sizeof(*sorted)));
+	n_inst_pages = static_cast<ulint*>(
+		ut_malloc(srv_buf_pool_instances * sizeof(*n_inst_pages)));
+	inst_start = static_cast<ulint*>(
+		ut_malloc(srv_buf_pool_instances * sizeof(*inst_start)));
+
+	memset(n_inst_pages, 0,
+	       srv_buf_pool_instances * sizeof(*n_inst_pages));
+
+	for (i = 0; i < n_pages; i++) {
+		n_inst_pages[buf_pool_get(BUF_DUMP_SPACE(dump[i]),
+					  BUF_DUMP_PAGE(dump[i]))
+			     ->instance_no]++;
+	}
+
+	for (i = 0; i < srv_buf_pool_instances; i++) {
+		inst_start[i] = i == 0
+			? 0 : inst_start[i - 1] + n_inst_pages[i - 1];
+	}
+
+	for (i = 0; i < n_pages; i++) {
+		ulint	inst = buf_pool_get(BUF_DUMP_SPACE(dump[i]),
+					    BUF_DUMP_PAGE(dump[i]))
+			->instance_no;
+
+		sorted[inst_start[inst]++] = dump[i];
+	}
+
+	n_threads = ut_min(ulint(srv_buf_pool_load_threads),
+			   ulint(BUF_LOAD_MAX_THREADS));
+	n_threads = ut_max(n_threads, ulint(1));
+
+	threads = static_cast<buf_load_thread_t*>(
+		ut_malloc(srv_buf_pool_instances * n_threads
+			  * sizeof(*threads)));
+
+	for (i = 0; i < srv_buf_pool_instances; i++) {
+		if (n_inst_pages[i] > 0) {
+			n_started += n_threads;
+		}
+	}
+
+	io_capacity = ut_max(srv_io_capacity / n_started, ulint(1));
+
+	for (i = 0; i < srv_buf_pool_instances; i++) {
+		/* inst_start[i] is the end of the pages of the instance
+		after the loop above. */
+		buf_dump_t*	pages = sorted + inst_start[i]
+			- n_inst_pages[i];
+
+		if (n_inst_pages[i] == 0) {
+			continue;
+		}
+
+		std::sort(pages, pages + n_inst_pages[i]);
+
+		for (ulint j = 0; j < n_threads; j++) {
+			buf_load_thread_t*	load
+				= &threads[i * n_threads + j];
+
+			load->pages = pages;
+			load->n_pages = n_inst_pages[i];
+			load->thread_no = j;
+			load->n_threads = n_threads;
+			load->io_capacity = io_capacity;
+		}
+	}
+
+	buf_load_n_threads_active = n_started;
+
+	for (i = 0; i < srv_buf_pool_instances; i++) {
+		if (n_inst_pages[i] == 0) {
+			continue;
+		}
+
+		for (ulint j = 0; j < n_threads; j++) {
+			os_thread_create(buf_load_thread,
+					 &threads[i * n_threads + j], NULL);
+		}
+	}
+
+	while (buf_load_n_threads_active > 0) {
+		os_thread_sleep(100000);
+
+		buf_load_status(STATUS_INFO,
+				"Loaded " ULINTPF "/" ULINTPF " pages",
+				buf_load_n_pages_done, n_total);
+	}
+
+	ut_free(threads);
+	ut_free(inst_start);
+	ut_free(n_inst_pages);
+	ut_free(sorted);
+}
+
 /*****************************************************************//**
 Perform a buffer pool load from the file specified by
 innodb_buffer_pool_filename. If any errors occur then the value of
@@ -413,6 +712,7 @@ buf_load()
 	ulint		dump_n;
 	ulint		total_buffer_pools_pages;
 	ulint		i;
+	ulint		dump_done = 0;
 	ulint		space_id;
 	ulint		page_no;
 	int		fscanf_ret;
@@ -534,43 +834,31 @@ buf_load()
 		return;
 	}
 
-	if (!SHUTTING_DOWN()) {
-		std::sort(dump, dump + dump_n);
-	}
-
-	ulint	last_check_time = 0;
-	ulint	last_activity_cnt = 0;
+	buf_load_n_pages_done = 0;
 
-	for (i = 0; i < dump_n && !SHUTTING_DOWN(); i++) {
-
-		buf_read_page_async(BUF_DUMP_SPACE(dump[i]),
-				    BUF_DUMP_PAGE(dump[i]));
-
-		if (i % 64 == 63) {
-			os_aio_simulated_wake_handler_threads();
-		}
+	if (srv_buf_pool_load_hot_pct > 0 && srv_buf_pool_load_hot_pct < 100) {
+		/* buf_dump() writes the hottest pages first. */
+		ulint	n_hot = dump_n * srv_buf_pool_load_hot_pct / 100;
 
-		if (i % 128 == 0) {
-			buf_load_status(STATUS_INFO,
-					"Loaded " ULINTPF "/" ULINTPF " pages",
-					i + 1, dump_n);
-		}
+		buf_load_pages(dump, n_hot, dump_n);
 
-		if (buf_load_abort_flag) {
-			buf_load_abort_flag = FALSE;
-			ut_free(dump);
-			buf_load_status(
-				STATUS_NOTICE,
-				"Buffer pool(s) load aborted on request");
-			return;
-		}
+		dump_done = n_hot;
+	}
 
-		buf_load_throttle_if_needed(
-			&last_check_time, &last_activity_cnt, i);
+	if (!buf_load_abort_flag && !SHUTTING_DOWN()) {
+		buf_load_pages(dump + dump_done, dump_n - dump_done, dump_n);
 	}
 
 	ut_free(dump);
 
+	if (buf_load_abort_flag) {
+		buf_load_abort_flag = FALSE;
+		buf_load_status(
+			STATUS_NOTICE,
+			"Buffer pool(s) load aborted on request");
+		return;
+	}
+
 	ut_sprintf_timestamp(now);
 
 	buf_load_status(STATUS_NOTICE,
@@ -66,6 +66,85 @@ mysql_pfs_key_t page_cleaner_thread_key;
 /** Event to synchronise with the flushing. */
 os_event_t	buf_flush_event;
 
+/** State of a page cleaner slot in the current flushing round. */
+enum page_cleaner_state_t {
+	PAGE_CLEANER_STATE_NONE = 0,	/*!< no work requested */
+	PAGE_CLEANER_STATE_REQUESTED,	/*!< the coordinator has
+					requested a flushing round */
+	PAGE_CLEANER_STATE_FLUSHING,	/*!< the owning page cleaner is
+					flushing its instances */
+	PAGE_CLEANER_STATE_FINISHED	/*!< the round is done and the
+					results are in the slot */
+};
+
+/** Work slot of one page cleaner thread. Slot i is served by page
+cleaner i and covers the buffer pool instances j for which
+j % page_cleaner->n_slots == i. */
+struct page_cleaner_slot_t {
+	page_cleaner_state_t	state;	/*!< state of the slot, protected
+					by page_cleaner->mutex */
+	os_event_t		event;	/*!< set when work is requested
+					from the owning page cleaner */
+	ulint			n_flushed_lru;
+					/*!< pages flushed from the tail
+					of the LRU lists in this round */
+	ulint			n_flushed_list;
+					/*!< pages flushed from the flush
+					lists in this round */
+	bool			succeeded_list;
+					/*!< false if a flush list batch
+					was already running in one of
+					the instances in this round */
+};
+
+/** Page cleaner coordination. The coordinator thread decides how much
+to flush and requests a round from all slots; each page cleaner thread
+flushes only its own buffer pool instances, so that with many instances
+the flushing is not bounded by a single thread. */
+struct page_cleaner_t {
+	ib_mutex_t		mutex;	/*!< protects the fields below
+					and the state of the slots */
+	os_event_t		is_finished;
+					/*!< set when all slots have
+					finished the current round */
+	ulint			n_slots;/*!< number of page cleaner
+					threads, including the
+					coordinator which serves slot 0 */
+	ulint			n_workers;
+					/*!< number of worker threads
+					that have not exited yet */
+	ulint			n_workers_started;
+					/*!< number of worker threads
+					that have claimed a slot */
+	bool			is_running;
+					/*!< false when the workers must
+					exit */
+	bool			requested;
+					/*!< true while a round is in
+					progress */
+	ulint			n_slots_finished;
+					/*!< number of slots in state
+					PAGE_CLEANER_STATE_FINISHED */
+	bool			flush_lru;
+					/*!< whether to flush the tail of
+					the LRU lists in this round */
+	ulint			list_min_n;
+					/*!< wished number of pages to
+					flush from the flush list of each
+					instance, 0 for no flush list
+					flushing in this round */
+	lsn_t			lsn_limit;
+					/*!< upper limit of the
+					oldest_modification of the pages
+					flushed from the flush lists */
+	page_cleaner_slot_t*	slots;	/*!< one slot per page cleaner */
+};
+
+/** The page cleaner coordination, created by
+buf_flush_page_cleaner_init() and freed by buf_flush_page_cleaner_free()
+at shutdown. */
+static page_cleaner_t*	page_cleaner = NULL;
+
 /** If LRU list of a buf_pool is less than this size then LRU eviction
 should not happen. This is because when we do LRU flushing we also put
 the blocks on free list. If LRU list is very small then we can end up
@@ -901,7 +980,7 @@ buf_flush_write_block_low(
 		break;
 	}
 
-	if (!srv_use_doublewrite_buf || !buf_dblwr) {
+	if (!srv_use_doublewrite_buf || !buf_dblwr || srv_read_only_mode) {
 		fil_io(OS_FILE_WRITE | OS_AIO_SIMULATED_WAKE_LATER,
 		       sync, buf_page_get_space(bpage), zip_size,
 		       buf_page_get_page_no(bpage), 0,
@@ -997,7 +1076,8 @@ buf_flush_page(
 		flush_list or LRU_list. */
 
 		if (!is_s_latched) {
-			buf_dblwr_flush_buffered_writes();
+			buf_dblwr_flush_buffered_writes(
+				buf_pool, BUF_FLUSH_LIST);
 
 			if (is_uncompressed) {
 				rw_lock_sx_lock_gen(&((buf_block_t*) bpage)
@@ -1668,10 +1748,11 @@ static
 void
 buf_flush_common(
 /*=============*/
+	buf_pool_t*	buf_pool,	/*!< in: buffer pool instance */
 	buf_flush_t	flush_type,	/*!< in: type of flush */
 	ulint		page_count)	/*!< in: number of pages flushed */
 {
-	buf_dblwr_flush_buffered_writes();
+	buf_dblwr_flush_buffered_writes(buf_pool, flush_type);
 
 	ut_a(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
 
@@ -1800,7 +1881,7 @@ buf_flush_LRU(
 
 	buf_flush_end(buf_pool, BUF_FLUSH_LRU);
 
-	buf_flush_common(BUF_FLUSH_LRU, page_count);
+	buf_flush_common(buf_pool, BUF_FLUSH_LRU, page_count);
 
 	if (n_processed) {
 		*n_processed = page_count;
@@ -1809,6 +1890,77 @@ buf_flush_LRU(
 	return(true);
 }
 
+/*******************************************************************//**
+This utility flushes dirty blocks from the end of the flush list of
+one buffer pool instance.
+NOTE: The calling thread is not allowed to own any latches on pages!
+@return true if a batch was queued successfully. false if another batch
+of same type was already running in the instance */
+static
+bool
+buf_flush_list_instance(
+/*====================*/
+	buf_pool_t*	buf_pool,	/*!< in/out: buffer pool instance */
+	ulint		min_n,		/*!< in: wished minimum mumber of blocks
+					flushed (it is not guaranteed that the
+					actual number is that big, though) */
+	lsn_t		lsn_limit,	/*!< in: all blocks whose
+					oldest_modification is smaller than
+					this should be flushed (if their number
+					does not exceed min_n) */
+	ulint*		n_processed)	/*!< out: the number of pages
+					which were processed */
+{
+	ulint		page_count;
+
+	*n_processed = 0;
+
+	if (!buf_flush_start(buf_pool, BUF_FLUSH_LIST)) {
+		return(false);
+	}
+
+	page_count = buf_flush_batch(
+		buf_pool, BUF_FLUSH_LIST, min_n, lsn_limit);
+
+	buf_flush_end(buf_pool, BUF_FLUSH_LIST);
+
+	buf_flush_common(buf_pool, BUF_FLUSH_LIST, page_count);
+
+	if (page_count) {
+		MONITOR_INC_VALUE_CUMULATIVE(
+			MONITOR_FLUSH_BATCH_TOTAL_PAGE,
+			MONITOR_FLUSH_BATCH_COUNT,
+			MONITOR_FLUSH_BATCH_PAGES,
+			page_count);
+	}
+
+	*n_processed = page_count;
+
+	return(true);
+}
+
+/*******************************************************************//**
+Divides a flush list batch evenly amongst the buffer pool instances.
+@return wished minimum number of blocks to flush in each instance */
+static
+ulint
+buf_flush_list_instance_min_n(
+/*==========================*/
+	ulint		min_n)		/*!< in: wished minimum number of
+					blocks flushed in all instances */
+{
+	if (min_n != ULINT_MAX) {
+		/* Ensure that flushing is spread evenly amongst the
+		buffer pool instances. When min_n is ULINT_MAX
+		we need to flush everything up to the lsn limit
+		so no limit here. */
+		min_n = (min_n + srv_buf_pool_instances - 1)
+			 / srv_buf_pool_instances;
+	}
+
+	return(min_n);
+}
+
 /*******************************************************************//**
 This utility flushes dirty blocks from the end of the flush list of
 all buffer pool instances.
@@ -1840,23 +1992,17 @@ buf_flush_list(
 		*n_processed = 0;
 	}
 
-	if (min_n != ULINT_MAX) {
-		/* Ensure that flushing is spread evenly amongst the
-		buffer pool instances. When min_n is ULINT_MAX
-		we need to flush everything up to the lsn limit
-		so no limit here. */
-		min_n = (min_n + srv_buf_pool_instances - 1)
-			 / srv_buf_pool_instances;
-	}
+	min_n = buf_flush_list_instance_min_n(min_n);
 
 	/* Flush to lsn_limit in all buffer pool instances */
 	for (i = 0; i < srv_buf_pool_instances; i++) {
 		buf_pool_t*	buf_pool;
-		ulint		page_count = 0;
+		ulint		page_count;
 
 		buf_pool = buf_pool_from_array(i);
 
-		if (!buf_flush_start(buf_pool, BUF_FLUSH_LIST)) {
+		if (!buf_flush_list_instance(
+			buf_pool, min_n, lsn_limit, &page_count)) {
 			/* We have two choices here. If lsn_limit was
 			specified then skipping an instance of buffer
 			pool means we cannot guarantee that all pages
@@ -1872,24 +2018,9 @@ buf_flush_list(
 			continue;
 		}
 
-		page_count = buf_flush_batch(
-			buf_pool, BUF_FLUSH_LIST, min_n, lsn_limit);
-
-		buf_flush_end(buf_pool, BUF_FLUSH_LIST);
-
-		buf_flush_common(BUF_FLUSH_LIST, page_count);
-
 		if (n_processed) {
 			*n_processed += page_count;
 		}
-
-		if (page_count) {
-			MONITOR_INC_VALUE_CUMULATIVE(
-				MONITOR_FLUSH_BATCH_TOTAL_PAGE,
-				MONITOR_FLUSH_BATCH_COUNT,
-				MONITOR_FLUSH_BATCH_PAGES,
-				page_count);
-		}
 	}
 
 	return(success);
@@ -1977,6 +2108,37 @@ buf_flush_single_page_from_LRU(
 	return(freed);
 }
 
+/*********************************************************************//**
+Clears up tail of the LRU list of one buffer pool instance:
+* Put replaceable pages at the tail of LRU to the free list
+* Flush dirty pages at the tail of LRU to the disk
+@return number of pages flushed */
+static
+ulint
+buf_flush_LRU_tail_instance(
+/*========================*/
+	buf_pool_t*	buf_pool)	/*!< in/out: buffer pool instance */
+{
+	ulint	scan_depth;
+	ulint	n_flushed = 0;
+
+	/* srv_LRU_scan_depth can be arbitrarily large value.
+	We cap it with current LRU size. */
+	buf_pool_mutex_enter(buf_pool);
+	scan_depth = UT_LIST_GET_LEN(buf_pool->LRU);
+	buf_pool_mutex_exit(buf_pool);
+
+	scan_depth = ut_min(srv_LRU_scan_depth, scan_depth);
+
+	/* Currently page_cleaner is the only thread
+	that can trigger an LRU flush. It is possible
+	that a batch triggered during last iteration is
+	still running, */
+	buf_flush_LRU(buf_pool, scan_depth, &n_flushed);
+
+	return(n_flushed);
+}
+
 /*********************************************************************//**
 Clears up tail of the LRU lists:
 * Put replaceable pages at the tail of LRU to the free list
@@ -1993,24 +2155,8 @@ buf_flush_LRU_tail(void)
 
 	for (ulint i = 0; i < srv_buf_pool_instances; i++) {
 
-		buf_pool_t*	buf_pool = buf_pool_from_array(i);
-		ulint		scan_depth;
-		ulint		n_flushed = 0;
-
-		/* srv_LRU_scan_depth can be arbitrarily large value.
-		We cap it with current LRU size. */
-		buf_pool_mutex_enter(buf_pool);
-		scan_depth = UT_LIST_GET_LEN(buf_pool->LRU);
-		buf_pool_mutex_exit(buf_pool);
-
-		scan_depth = ut_min(srv_LRU_scan_depth, scan_depth);
-
-		/* Currently page_cleaner is the only thread
-		that can trigger an LRU flush. It is possible
-		that a batch triggered during last iteration is
-		still running, */
-		buf_flush_LRU(buf_pool, scan_depth, &n_flushed);
-		total_flushed += n_flushed;
+		total_flushed += buf_flush_LRU_tail_instance(
+			buf_pool_from_array(i));
 	}
 
 	if (total_flushed) {
@@ -2049,8 +2195,330 @@ buf_flush_wait_LRU_batch_end(void)
 	}
 }
 
+/******************************************************************//**
+Initializes the page cleaner coordination. Must be called before the
+page cleaner threads are created. */
+
+void
+buf_flush_page_cleaner_init(void)
+/*=============================*/
+{
+	ut_ad(page_cleaner == NULL);
+	ut_ad(srv_n_page_cleaners >= 1);
+	ut_ad(srv_n_page_cleaners <= BUF_FLUSH_PAGE_CLEANERS_MAX);
+	ut_ad(srv_n_page_cleaners <= srv_buf_pool_instances);
+
+	page_cleaner = static_cast<page_cleaner_t*>(
+		mem_zalloc(sizeof(*page_cleaner)));
+
+	mutex_create("page_cleaner", &page_cleaner->mutex);
+
+	page_cleaner->is_finished = os_event_create("pc_is_finished");
+
+	page_cleaner->n_slots = srv_n_page_cleaners;
+	page_cleaner->n_workers = srv_n_page_cleaners - 1;
+	page_cleaner->is_running = true;
+
+	page_cleaner->slots = static_cast<page_cleaner_slot_t*>(
+		mem_zalloc(page_cleaner->n_slots
+			   * sizeof(*page_cleaner->slots)));
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		page_cleaner->slots[i].event = os_event_create(
+			"pc_slot_event");
+	}
+}
+
+/******************************************************************//**
+Stops the page cleaner worker threads. Called by the coordinator thread
+before it exits. */
+static
+void
+buf_flush_page_cleaner_stop(void)
+/*=============================*/
+{
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(!page_cleaner->requested);
+	page_cleaner->is_running = false;
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		os_event_set(page_cleaner->slots[i].event);
+	}
+
+	while (page_cleaner->n_workers > 0) {
+		mutex_exit(&page_cleaner->mutex);
+		os_thread_sleep(10000);
+		mutex_enter(&page_cleaner->mutex);
+	}
+
+	mutex_exit(&page_cleaner->mutex);
+}
+
+/******************************************************************//**
+Frees the page cleaner coordination. Must be called after all the page
+cleaner threads have exited. */
+
+void
+buf_flush_page_cleaner_free(void)
+/*=============================*/
+{
+	if (page_cleaner == NULL) {
+		return;
+	}
+
+	ut_ad(!page_cleaner->is_running);
+	ut_ad(page_cleaner->n_workers == 0);
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		os_event_destroy(page_cleaner->slots[i].event);
+	}
+
+	os_event_destroy(page_cleaner->is_finished);
+
+	mutex_free(&page_cleaner->mutex);
+
+	mem_free(page_cleaner->slots);
+	mem_free(page_cleaner);
+
+	page_cleaner = NULL;
+}
+
+/******************************************************************//**
+Requests a flushing round from all page cleaner slots. */
+static
+void
+pc_request(
+/*=======*/
+	bool		flush_lru,	/*!< in: whether to flush the tail
+					of the LRU lists */
+	ulint		list_min_n,	/*!< in: wished number of pages to
+					flush from the flush list of each
+					instance, 0 for none */
+	lsn_t		lsn_limit)	/*!< in: LSN up to which the flush
+					lists are flushed */
+{
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(!page_cleaner->requested);
+	ut_ad(page_cleaner->is_running);
+
+	page_cleaner->requested = true;
+	page_cleaner->flush_lru = flush_lru;
+	page_cleaner->list_min_n = list_min_n;
+	page_cleaner->lsn_limit = lsn_limit;
+	page_cleaner->n_slots_finished = 0;
+
+	os_event_reset(page_cleaner->is_finished);
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		page_cleaner_slot_t*	slot = &page_cleaner->slots[i];
+
+		ut_ad(slot->state == PAGE_CLEANER_STATE_NONE);
+
+		slot->state = PAGE_CLEANER_STATE_REQUESTED;
+		slot->n_flushed_lru = 0;
+		slot->n_flushed_list = 0;
+		slot->succeeded_list = true;
+
+		os_event_set(slot->event);
+	}
+
+	mutex_exit(&page_cleaner->mutex);
+}
+
+/******************************************************************//**
+Does the work requested from a page cleaner slot, if any: flushes the
+buffer pool instances owned by the slot and accounts the time spent in
+the per page cleaner monitor counters. */
+static
+void
+pc_flush_slot(
+/*==========*/
+	ulint		slot_id)	/*!< in: slot of the calling page
+					cleaner */
+{
+	page_cleaner_slot_t*	slot;
+	bool			flush_lru;
+	ulint			list_min_n;
+	lsn_t			lsn_limit;
+	ulint			n_slots;
+
+	ut_ad(slot_id < page_cleaner->n_slots);
+
+	slot = &page_cleaner->slots[slot_id];
+
+	mutex_enter(&page_cleaner->mutex);
+
+	os_event_reset(slot->event);
+
+	if (slot->state != PAGE_CLEANER_STATE_REQUESTED) {
+		mutex_exit(&page_cleaner->mutex);
+		return;
+	}
+
+	slot->state = PAGE_CLEANER_STATE_FLUSHING;
+
+	flush_lru = page_cleaner->flush_lru;
+	list_min_n = page_cleaner->list_min_n;
+	lsn_limit = page_cleaner->lsn_limit;
+	n_slots = page_cleaner->n_slots;
+
+	mutex_exit(&page_cleaner->mutex);
+
+	ulint	n_flushed_lru = 0;
+	ulint	n_flushed_list = 0;
+	bool	succeeded_list = true;
+	ulint	start_time = ut_time_ms();
+
+	for (ulint i = slot_id; i < srv_buf_pool_instances; i += n_slots) {
+		buf_pool_t*	buf_pool = buf_pool_from_array(i);
+
+		if (flush_lru) {
+			n_flushed_lru += buf_flush_LRU_tail_instance(buf_pool);
+		}
+
+		if (list_min_n > 0) {
+			ulint	n_flushed;
+
+			if (!buf_flush_list_instance(
+				buf_pool, list_min_n, lsn_limit,
+				&n_flushed)) {
+
+				succeeded_list = false;
+			}
+
+			n_flushed_list += n_flushed;
+		}
+	}
+
+	monitor_id_t	time_monitor = static_cast<monitor_id_t>(
+		MONITOR_FLUSH_CLEANER_0_TIME + 2 * slot_id);
+	monitor_id_t	pages_monitor = static_cast<monitor_id_t>(
+		MONITOR_FLUSH_CLEANER_0_PAGES + 2 * slot_id);
+
+	MONITOR_INC_VALUE(time_monitor, ut_time_ms() - start_time);
+	MONITOR_INC_VALUE(pages_monitor, n_flushed_lru + n_flushed_list);
+
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(slot->state == PAGE_CLEANER_STATE_FLUSHING);
+
+	slot->state = PAGE_CLEANER_STATE_FINISHED;
+	slot->n_flushed_lru = n_flushed_lru;
+	slot->n_flushed_list = n_flushed_list;
+	slot->succeeded_list = succeeded_list;
+
+	if (++page_cleaner->n_slots_finished == page_cleaner->n_slots) {
+		os_event_set(page_cleaner->is_finished);
+	}
+
+	mutex_exit(&page_cleaner->mutex);
+}
+
+/******************************************************************//**
+Waits until all page cleaner slots have finished the current round and
+collects the results.
+@return false if a flush list batch was already running in one of the
+buffer pool instances */
+static
+bool
+pc_wait_finished(
+/*=============*/
+	ulint*		n_flushed_lru,	/*!< out: pages flushed from the
+					tail of the LRU lists */
+	ulint*		n_flushed_list)	/*!< out: pages flushed from the
+					flush lists */
+{
+	bool	succeeded_list = true;
+
+	*n_flushed_lru = 0;
+	*n_flushed_list = 0;
+
+	os_event_wait(page_cleaner->is_finished);
+
+	mutex_enter(&page_cleaner->mutex);
+
+	ut_ad(page_cleaner->requested);
+	ut_ad(page_cleaner->n_slots_finished == page_cleaner->n_slots);
+
+	for (ulint i = 0; i < page_cleaner->n_slots; i++) {
+		page_cleaner_slot_t*	slot = &page_cleaner->slots[i];
+
+		ut_ad(slot->state == PAGE_CLEANER_STATE_FINISHED);
+
+		*n_flushed_lru += slot->n_flushed_lru;
+		*n_flushed_list += slot->n_flushed_list;
+		succeeded_list = succeeded_list && slot->succeeded_list;
+
+		slot->state = PAGE_CLEANER_STATE_NONE;
+	}
+
+	page_cleaner->requested = false;
+
+	mutex_exit(&page_cleaner->mutex);
+
+	return(succeeded_list);
+}
+
+/******************************************************************//**
+Runs a flushing round on all buffer pool instances, in parallel in the
+page cleaner threads. The calling coordinator serves slot 0 itself.
+@return false if a flush list batch was already running in one of the
+buffer pool instances */
+static
+bool
+pc_flush(
+/*=====*/
+	bool		flush_lru,	/*!< in: whether to flush the tail
+					of the LRU lists */
+	ulint		list_min_n,	/*!< in: wished number of pages to
+					flush from the flush list of each
+					instance, 0 for none */
+	lsn_t		lsn_limit,	/*!< in: LSN up to which the flush
+					lists are flushed */
+	ulint*		n_flushed_lru,	/*!< out: pages flushed from the
+					tail of the LRU lists */
+	ulint*		n_flushed_list)	/*!< out: pages flushed from the
+					flush lists */
+{
+	pc_request(flush_lru, list_min_n, lsn_limit);
+
+	pc_flush_slot(0);
+
+	return(pc_wait_finished(n_flushed_lru, n_flushed_list));
+}
+
 /*********************************************************************//**
-Flush a batch of dirty pages from the flush list
+Clears up tail of the LRU lists of all buffer pool instances, in
+parallel in the page cleaner threads.
+@return total pages flushed */
+static
+ulint
+page_cleaner_flush_LRU_tail(void)
+/*=============================*/
+{
+	ulint	n_flushed_lru;
+	ulint	n_flushed_list;
+
+	pc_flush(true, 0, 0, &n_flushed_lru, &n_flushed_list);
+
+	ut_ad(n_flushed_list == 0);
+
+	if (n_flushed_lru) {
+		MONITOR_INC_VALUE_CUMULATIVE(
+			MONITOR_LRU_BATCH_FLUSH_TOTAL_PAGE,
+			MONITOR_LRU_BATCH_FLUSH_COUNT,
+			MONITOR_LRU_BATCH_FLUSH_PAGES,
+			n_flushed_lru);
+	}
+
+	return(n_flushed_lru);
+}
+
+/*********************************************************************//**
+Flush a batch of dirty pages from the flush list, in parallel in the
+page cleaner threads
 @return number of pages flushed, 0 if no page is flushed or if another
 flush_list type batch is running */
 static
@@ -2062,9 +2530,13 @@ page_cleaner_do_flush_batch(
 	lsn_t		lsn_limit)	/*!< in: LSN up to which flushing
 					must happen */
 {
-	ulint n_flushed;
+	ulint	n_flushed_lru;
+	ulint	n_flushed;
+
+	pc_flush(false, buf_flush_list_instance_min_n(n_to_flush), lsn_limit,
+		 &n_flushed_lru, &n_flushed);
 
-	buf_flush_list(n_to_flush, lsn_limit, &n_flushed);
+	ut_ad(n_flushed_lru == 0);
 
 	return(n_flushed);
 }
@@ -2277,13 +2749,15 @@ page_cleaner_sleep_if_needed(
 }
 
 /******************************************************************//**
-page_cleaner thread tasked with flushing dirty pages from the buffer
-pools. As of now we'll have only one instance of this thread.
+page_cleaner coordinator thread tasked with flushing dirty pages from
+the buffer pools. It decides how much to flush and shares the work with
+the page_cleaner worker threads, each of which flushes its own subset
+of the buffer pool instances.
 @return a dummy parameter */
 extern "C"
 os_thread_ret_t
-DECLARE_THREAD(buf_flush_page_cleaner_thread)(
-/*==========================================*/
+DECLARE_THREAD(buf_flush_page_cleaner_coordinator)(
+/*===============================================*/
 	void*	arg __attribute__((unused)))
 			/*!< in: a dummy parameter required by
 			os_thread_create */
@@ -2325,7 +2799,7 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 			last_activity = srv_get_activity_count();
 
 			/* Flush pages from end of LRU if required */
-			n_flushed = buf_flush_LRU_tail();
+			n_flushed = page_cleaner_flush_LRU_tail();
 
 			/* Flush pages from flush_list if required */
 			n_flushed += page_cleaner_flush_pages_if_needed();
@@ -2347,6 +2821,7 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 	if (srv_fast_shutdown == 2) {
 		/* In very fast shutdown we simulate a crash of
 		buffer pool. We are not required to do any flushing */
+		buf_flush_page_cleaner_stop();
 		goto thread_exit;
 	}
 
@@ -2376,6 +2851,9 @@ DECLARE_THREAD(buf_flush_page_cleaner_thread)(
 	ut_a(srv_get_active_thread_type() == SRV_NONE);
 	ut_a(srv_shutdown_state == SRV_SHUTDOWN_FLUSH_PHASE);
 
+	/* The final sweep is done by this thread alone. */
+	buf_flush_page_cleaner_stop();
+
 	/* We can now make a final sweep on flushing the buffer pool
 	and exit after we have cleaned the whole buffer pool.
 	It is important that we wait for any running batch that has
@@ -2418,6 +2896,56 @@ thread_exit:
 	OS_THREAD_DUMMY_RETURN;
 }
 
+/******************************************************************//**
+page_cleaner worker thread. It flushes the buffer pool instances of its
+slot whenever the coordinator requests a flushing round.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(buf_flush_page_cleaner_worker)(
+/*==========================================*/
+	void*	arg __attribute__((unused)))
+			/*!< in: a dummy parameter required by
+			os_thread_create */
+{
+	ulint	slot_id;
+
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(page_cleaner_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	mutex_enter(&page_cleaner->mutex);
+	slot_id = ++page_cleaner->n_workers_started;
+	mutex_exit(&page_cleaner->mutex);
+
+	ut_a(slot_id < page_cleaner->n_slots);
+
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "InnoDB: page_cleaner worker %lu running, id %lu\n",
+		slot_id, os_thread_pf(os_thread_get_curr_id()));
+#endif /* UNIV_DEBUG_THREAD_CREATION */
+
+	for (;;) {
+		os_event_wait(page_cleaner->slots[slot_id].event);
+
+		if (!page_cleaner->is_running) {
+			break;
+		}
+
+		pc_flush_slot(slot_id);
+	}
+
+	mutex_enter(&page_cleaner->mutex);
+	--page_cleaner->n_workers;
+	mutex_exit(&page_cleaner->mutex);
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
 /*******************************************************************//**
 Synchronously flush dirty blocks from the end of the flush list of all buffer
 pool instances.
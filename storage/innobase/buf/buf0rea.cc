@@ -470,6 +470,128 @@ buf_read_page_async(
 	return(count > 0);
 }
 
+/********************************************************************//**
+Reads a range of contiguous pages of a tablespace to the buffer buf_pool
+with one synchronous read request, and puts those pages of the range that
+are not in the buffer pool yet there. Used by the buffer pool load, which
+reads the pages of a dump in the order of their positions in the files.
+The system tablespace, which contains the insert buffer, must be read
+with buf_read_page_async() instead.
+@return number of pages that were read in */
+
+ulint
+buf_read_page_range(
+/*================*/
+	ulint	space,	/*!< in: space id */
+	ulint	offset,	/*!< in: number of the first page */
+	ulint	n_pages,/*!< in: number of pages, at most
+			BUF_READ_RANGE_MAX_PAGES */
+	byte*	buf)	/*!< out: buffer of BUF_READ_RANGE_MAX_PAGES
+			* UNIV_PAGE_SIZE bytes, aligned to
+			UNIV_PAGE_SIZE */
+{
+	buf_page_t*	bpages[BUF_READ_RANGE_MAX_PAGES];
+	ulint		zip_size;
+	ulint		page_size;
+	ulint		space_size;
+	ib_int64_t	tablespace_version;
+	ulint		first = ULINT_UNDEFINED;
+	ulint		last = 0;
+	ulint		count = 0;
+	dberr_t		err = DB_SUCCESS;
+	ulint		i;
+
+	ut_ad(space != TRX_SYS_SPACE);
+	ut_ad(n_pages <= BUF_READ_RANGE_MAX_PAGES);
+
+	zip_size = fil_space_get_zip_size(space);
+
+	if (zip_size == ULINT_UNDEFINED) {
+		return(0);
+	}
+
+	page_size = zip_size ? zip_size : UNIV_PAGE_SIZE;
+
+	tablespace_version = fil_space_get_version(space);
+
+	/* The pages may have been dumped before the tablespace was
+	truncated. A read request must not go past the end of the file. */
+	space_size = fil_space_get_size(space);
+
+	if (offset >= space_size) {
+		return(0);
+	}
+
+	n_pages = ut_min(n_pages, space_size - offset);
+
+	/* Fix the pages for the read in ascending order. They are put in
+	the buffer pool in the same order below, so that the insert buffer
+	bitmap page of the range, if any, is there before the pages that
+	it describes are merged with the insert buffer. */
+	for (i = 0; i < n_pages && err == DB_SUCCESS; i++) {
+
+		bpages[i] = buf_page_init_for_read(
+			&err, BUF_READ_ANY_PAGE, space, zip_size, FALSE,
+			tablespace_version, offset + i);
+
+		if (bpages[i] != NULL) {
+			if (first == ULINT_UNDEFINED) {
+				first = i;
+			}
+
+			last = i;
+		}
+	}
+
+	if (first == ULINT_UNDEFINED) {
+		return(0);
+	}
+
+	DBUG_PRINT("ib_buf", ("read pages %u:%u..%u zip=%u",
+			      unsigned(space), unsigned(offset + first),
+			      unsigned(offset + last), unsigned(zip_size)));
+
+	thd_wait_begin(NULL, THD_WAIT_DISKIO);
+
+	err = fil_io(OS_FILE_READ | BUF_READ_IGNORE_NONEXISTENT_PAGES,
+		     true, space, zip_size, offset + first, 0,
+		     (last - first + 1) * page_size, buf, NULL);
+
+	thd_wait_end(NULL);
+
+	for (i = first; i <= last; i++) {
+		buf_page_t*	bpage = bpages[i];
+
+		if (bpage == NULL) {
+			continue;
+		}
+
+		if (err != DB_SUCCESS) {
+			buf_read_page_handle_error(bpage);
+			continue;
+		}
+
+		const byte*	page = buf + (i - first) * page_size;
+
+		if (zip_size) {
+			memcpy(bpage->zip.data, page, zip_size);
+		} else {
+			ut_a(buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE);
+
+			memcpy(((buf_block_t*) bpage)->frame, page,
+			       UNIV_PAGE_SIZE);
+		}
+
+		if (buf_page_io_complete(bpage)) {
+			count++;
+		}
+	}
+
+	srv_stats.buf_pool_reads.add(count);
+
+	return(count);
+}
+
 /********************************************************************//**
 Applies linear read-ahead if in the buf_pool the page is a border page of
 a linear read-ahead area and all the pages in the area have been accessed.
@@ -339,6 +339,9 @@ dict_build_tablespace(
 			return(err);
 		}
 
+		fil_space_set_compression(
+			space, dict_table_page_compression(table));
+
 		mtr_start(&mtr);
 		dict_disable_redo_if_temporary(table, &mtr);
 
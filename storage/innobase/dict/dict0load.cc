@@ -2487,6 +2487,11 @@ err_exit:
 		}
 	}
 
+	if (!table->ibd_file_missing && table->space != 0) {
+		fil_space_set_compression(
+			table->space, dict_table_page_compression(table));
+	}
+
 	dict_load_columns(table, heap);
 
 	if (cached) {
@@ -163,6 +163,12 @@ struct fil_node_t {
 	ib_int64_t	flush_counter;/*!< up to what
 				modification_counter value we have
 				flushed the modifications to disk */
+	ulint		block_size;/*!< file system block size; valid
+				while the file is open */
+	bool		punch_hole;/*!< true if holes can be punched
+				into the file; pages are only compressed
+				for writing if this is set. Valid while
+				the file is open. */
 	UT_LIST_NODE_T(fil_node_t) chain;
 				/*!< link field for the file chain */
 	UT_LIST_NODE_T(fil_node_t) LRU;
@@ -215,6 +221,10 @@ struct fil_space_t {
 	ulint		flags;	/*!< tablespace flags; see
 				fsp_flags_is_valid(),
 				fsp_flags_get_zip_size() */
+	ulint		compression;/*!< page_zip_algorithm_t that
+				compresses the pages written to the
+				files, or ULINT_UNDEFINED; see
+				fil_space_set_compression() */
 	ulint		n_reserved_extents;
 				/*!< number of reserved free extents for
 				ongoing operations like B-tree page split */
@@ -863,6 +873,31 @@ add_size:
 
 	node->open = TRUE;
 
+	/* Transparent page compression is only worth it if the disk
+	space of the unused end of each page can be freed. Probe this
+	by punching a hole past the end of the file, which does not
+	change the file on file systems that support sparse files. */
+	node->block_size = os_file_get_block_size(node->handle);
+	node->punch_hole = false;
+
+	if (fil_is_user_tablespace_id(space->id)
+	    && space->purpose == FIL_TABLESPACE
+	    && !node->is_raw_disk
+	    && !srv_read_only_mode
+	    && ut_is_2pow(node->block_size)
+	    && node->block_size >= OS_FILE_LOG_BLOCK_SIZE
+	    && node->block_size < UNIV_PAGE_SIZE) {
+
+		size_bytes = os_file_get_size(node->handle);
+
+		node->punch_hole = size_bytes != (os_offset_t) -1
+			&& os_file_punch_hole(
+				node->handle,
+				ut_uint64_align_up(size_bytes,
+						   node->block_size),
+				node->block_size) == DB_SUCCESS;
+	}
+
 	system->n_open++;
 	fil_n_file_opened++;
 
@@ -1265,6 +1300,7 @@ fil_space_create(
 
 	space->purpose = purpose;
 	space->flags = flags;
+	space->compression = ULINT_UNDEFINED;
 	space->is_being_truncated = false;
 
 	space->magic_n = FIL_SPACE_MAGIC_N;
@@ -1594,6 +1630,38 @@ fil_space_get_zip_size(
 	return(flags);
 }
 
+/*******************************************************************//**
+Sets the transparent page compression of a tablespace: the pages that
+are written to its data files are compressed and the unused end of each
+page is punched out of the file, if the file system supports it. Pages
+that were written compressed are restored on read whatever the setting.
+Does nothing if the tablespace is not in the memory cache. */
+
+void
+fil_space_set_compression(
+/*======================*/
+	ulint	id,		/*!< in: space id */
+	ulint	algorithm)	/*!< in: page_zip_algorithm_t, or
+				ULINT_UNDEFINED to write the pages
+				uncompressed */
+{
+	fil_space_t*	space;
+
+	ut_ad(fil_system);
+	ut_ad(algorithm == ULINT_UNDEFINED
+	      || algorithm < PAGE_ZIP_N_ALGORITHMS);
+
+	mutex_enter(&fil_system->mutex);
+
+	space = fil_space_get_by_id(id);
+
+	if (space != NULL && space->purpose == FIL_TABLESPACE) {
+		space->compression = algorithm;
+	}
+
+	mutex_exit(&fil_system->mutex);
+}
+
 /*******************************************************************//**
 Checks if the pair space, page_no refers to an existing page in a tablespace
 file space. The tablespace must be cached in the memory cache.
@@ -3103,6 +3171,80 @@ fil_reinit_space_header(
 	mtr_commit(&mtr);
 }
 
+/**********************************************************************//**
+Truncates the data file of an undo tablespace and reinitializes its
+header. The caller must ensure that no page of the tablespace is in use.
+@return true if success */
+
+bool
+fil_truncate_undo_space(
+/*====================*/
+	ulint		id,	/*!< in: space id */
+	ulint		size)	/*!< in: new size in blocks */
+{
+	ut_a(!Tablespace::is_system_tablespace(id));
+
+	/* Discard the pages first, so that no dirty page can be written
+	beyond the end of the truncated file. */
+	buf_LRU_flush_or_remove_pages(id, BUF_REMOVE_ALL_NO_WRITE, 0);
+
+	mutex_enter(&fil_system->mutex);
+
+	fil_space_t*	space = fil_space_get_by_id(id);
+
+	ut_a(UT_LIST_GET_LEN(space->chain) == 1);
+
+	fil_node_t*	node = UT_LIST_GET_FIRST(space->chain);
+
+	bool	opened;
+
+	if (!node->open) {
+
+		ibool	ret;
+
+		node->handle = os_file_create_simple_no_error_handling(
+			innodb_data_file_key, node->name, OS_FILE_OPEN,
+			OS_FILE_READ_WRITE, &ret);
+
+		if (!ret) {
+			mutex_exit(&fil_system->mutex);
+
+			ib_logf(IB_LOG_LEVEL_ERROR,
+				"Failed to open undo tablespace file %s.",
+				node->name);
+
+			return(false);
+		}
+
+		node->open = TRUE;
+		opened = true;
+	} else {
+		opened = false;
+	}
+
+	bool	success = os_file_truncate(
+		node->name, node->handle, (os_offset_t) size * UNIV_PAGE_SIZE);
+
+	if (!success) {
+		ib_logf(IB_LOG_LEVEL_ERROR,
+			"Cannot truncate undo tablespace file %s.",
+			node->name);
+	}
+
+	if (opened) {
+		os_file_close(node->handle);
+		node->open = FALSE;
+	}
+
+	mutex_exit(&fil_system->mutex);
+
+	if (success) {
+		fil_reinit_space_header(id, size);
+	}
+
+	return(success);
+}
+
 /*******************************************************************//**
 Returns TRUE if a single-table tablespace is being deleted.
 @return TRUE if being deleted */
@@ -5210,7 +5352,7 @@ retry:
 		success = os_aio(OS_FILE_WRITE, OS_AIO_SYNC,
 				 node->name, node->handle, buf,
 				 offset, page_size * n_pages,
-				 NULL, NULL);
+				 NULL, NULL, NULL);
 #endif /* UNIV_HOTBACKUP */
 		if (success) {
 			os_has_said_disk_full = FALSE;
@@ -5547,6 +5689,82 @@ fil_report_invalid_page_access(
 		(ulong) byte_offset, (ulong) len, (ulong) type);
 }
 
+/********************************************************************//**
+Restores the pages of a read request that were written compressed by
+fil_page_compress(). A page that cannot be decompressed is reported and
+left as it is; it fails the checksum check after this. */
+static
+void
+fil_node_decompress_pages(
+/*======================*/
+	const fil_node_t*	node,	/*!< in: file node */
+	byte*			buf,	/*!< in/out: pages that were read */
+	ulint			len)	/*!< in: length of buf */
+{
+	ut_ad(len % UNIV_PAGE_SIZE == 0);
+
+	for (byte* page = buf; page < buf + len; page += UNIV_PAGE_SIZE) {
+
+		if (!fil_page_decompress(page)) {
+			ib_logf(IB_LOG_LEVEL_ERROR,
+				"Cannot decompress page %lu of file %s:"
+				" compression algorithm %lu is not"
+				" available, or the page is corrupted.",
+				(ulong) mach_read_from_4(
+					page + FIL_PAGE_OFFSET),
+				node->name,
+				(ulong) mach_read_from_1(
+					page + FIL_PAGE_COMPRESS_ALGORITHM));
+		}
+	}
+}
+
+/********************************************************************//**
+Frees the unused end of a page that fil_page_compress() compressed,
+after the compressed page has been written, and counts the page. The
+file must have the write pending, so that it stays open and the page is
+not written again meanwhile. If the hole cannot be punched, the page is
+not counted, and the pages of the file are written uncompressed while it
+is open; the compressed page stays readable. */
+static
+void
+fil_node_punch_page(
+/*================*/
+	fil_node_t*	node,	/*!< in/out: file node */
+	os_offset_t	offset,	/*!< in: file offset of the page */
+	ulint		len)	/*!< in: length of the compressed page
+				that was written, less than
+				UNIV_PAGE_SIZE */
+{
+	ut_ad(len < UNIV_PAGE_SIZE);
+	ut_ad(node->n_pending > 0);
+
+	dberr_t	err = os_file_punch_hole(
+		node->handle, offset + len, UNIV_PAGE_SIZE - len);
+
+	if (err == DB_SUCCESS) {
+		srv_stats.pages_page_compressed.inc();
+		srv_stats.page_compression_saved.add(UNIV_PAGE_SIZE - len);
+
+		return;
+	}
+
+	mutex_enter(&fil_system->mutex);
+
+	bool	was_punching = node->punch_hole;
+
+	node->punch_hole = false;
+
+	mutex_exit(&fil_system->mutex);
+
+	if (was_punching) {
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"Cannot punch a hole in file %s;"
+			" its pages will not be compressed"
+			" while it is open.", node->name);
+	}
+}
+
 /********************************************************************//**
 Reads or writes data. This operation is asynchronous (aio).
 @return DB_SUCCESS, DB_TABLESPACE_DELETED or DB_TABLESPACE_TRUNCATED
@@ -5589,6 +5807,9 @@ fil_io(
 	ulint		wake_later;
 	os_offset_t	offset;
 	ibool		ignore_nonexistent_pages;
+	ulint		compression;
+	bool		page_io;
+	void*		compress_buf = NULL;
 
 	is_log = type & OS_FILE_LOG;
 	type = type & ~OS_FILE_LOG;
@@ -5715,6 +5936,14 @@ fil_io(
 	/* Open file if closed */
 	fil_node_prepare_for_io(node, fil_system, space);
 
+	/* Whether the request is for whole uncompressed pages of a
+	tablespace, which may be stored compressed in the file */
+	page_io = !is_log && !zip_size && !byte_offset
+		&& space->purpose == FIL_TABLESPACE
+		&& len % UNIV_PAGE_SIZE == 0;
+
+	compression = space->compression;
+
 	/* Check that at least the start offset is within the bounds of a
 	single-table tablespace, including rollback tablespaces. */
 	if (UNIV_UNLIKELY(node->size <= block_offset)
@@ -5760,6 +5989,38 @@ fil_io(
 	ut_a(byte_offset % OS_FILE_LOG_BLOCK_SIZE == 0);
 	ut_a((len % OS_FILE_LOG_BLOCK_SIZE) == 0);
 
+	/* Compress a page that is written to a tablespace with
+	transparent page compression, except the first page of the file,
+	which is read directly when the file is opened. */
+	if (type == OS_FILE_WRITE
+	    && page_io
+	    && len == UNIV_PAGE_SIZE
+	    && offset != 0
+	    && compression != ULINT_UNDEFINED
+	    && node->punch_hole) {
+
+		compress_buf = ut_malloc(2 * UNIV_PAGE_SIZE);
+
+		/* Align the memory for file i/o if we might have O_DIRECT
+		set */
+		byte*	page = static_cast<byte*>(
+			ut_align(compress_buf, UNIV_PAGE_SIZE));
+		ulint	page_len = fil_page_compress(
+			static_cast<byte*>(buf), page, compression,
+			node->block_size);
+
+		if (page_len == 0) {
+			ut_free(compress_buf);
+			compress_buf = NULL;
+		} else {
+			/* The end of the page is punched out of the file
+			when the write has completed, see
+			fil_node_punch_page(). */
+			buf = page;
+			len = page_len;
+		}
+	}
+
 #ifdef UNIV_HOTBACKUP
 	/* In ibbackup do normal i/o, not aio */
 	if (type == OS_FILE_READ) {
@@ -5772,7 +6033,8 @@ fil_io(
 #else
 	/* Queue the aio request */
 	ret = os_aio(type, mode | wake_later, node->name, node->handle, buf,
-		     offset, len, node, message);
+		     offset, len, node, message,
+		     mode == OS_AIO_SYNC ? NULL : compress_buf);
 #endif /* UNIV_HOTBACKUP */
 	ut_a(ret);
 
@@ -5780,6 +6042,17 @@ fil_io(
 		/* The i/o operation is already completed when we return from
 		os_aio: */
 
+		if (compress_buf != NULL) {
+			fil_node_punch_page(node, offset, len);
+
+			ut_free(compress_buf);
+		}
+
+		if (type == OS_FILE_READ && page_io) {
+			fil_node_decompress_pages(
+				node, static_cast<byte*>(buf), len);
+		}
+
 		mutex_enter(&fil_system->mutex);
 
 		fil_node_complete_io(node, fil_system, type);
@@ -5809,6 +6082,7 @@ fil_aio_wait(
 	fil_node_t*	fil_node;
 	void*		message;
 	ulint		type;
+	ulint		compress_len;
 
 	ut_ad(fil_validate_skip());
 
@@ -5816,10 +6090,10 @@ fil_aio_wait(
 		srv_set_io_thread_op_info(segment, "native aio handle");
 #ifdef WIN_ASYNC_IO
 		ret = os_aio_windows_handle(
-			segment, 0, &fil_node, &message, &type);
+			segment, 0, &fil_node, &message, &type, &compress_len);
 #elif defined(LINUX_NATIVE_AIO)
 		ret = os_aio_linux_handle(
-			segment, &fil_node, &message, &type);
+			segment, &fil_node, &message, &type, &compress_len);
 #else
 		ut_error;
 		ret = 0; /* Eliminate compiler warning */
@@ -5828,7 +6102,7 @@ fil_aio_wait(
 		srv_set_io_thread_op_info(segment, "simulated aio handle");
 
 		ret = os_aio_simulated_handle(
-			segment, &fil_node, &message, &type);
+			segment, &fil_node, &message, &type, &compress_len);
 	}
 
 	ut_a(ret);
@@ -5837,6 +6111,25 @@ fil_aio_wait(
 		return;
 	}
 
+	if (compress_len != 0
+	    && fil_node->space->compression != ULINT_UNDEFINED) {
+
+		/* The page was written compressed by fil_io() to a
+		single-file tablespace. */
+		buf_page_t*	bpage = static_cast<buf_page_t*>(message);
+
+		ut_ad(type == OS_FILE_WRITE);
+		ut_ad(fil_node->space->purpose == FIL_TABLESPACE);
+		ut_ad(!buf_page_get_zip_size(bpage));
+		ut_ad(UT_LIST_GET_LEN(fil_node->space->chain) == 1);
+
+		srv_set_io_thread_op_info(segment, "punch hole");
+		fil_node_punch_page(
+			fil_node,
+			(os_offset_t) bpage->offset << UNIV_PAGE_SIZE_SHIFT,
+			compress_len);
+	}
+
 	srv_set_io_thread_op_info(segment, "complete io for fil node");
 
 	mutex_enter(&fil_system->mutex);
@@ -5854,8 +6147,17 @@ fil_aio_wait(
 	open, and use a special i/o thread to serve insert buffer requests. */
 
 	if (fil_node->space->purpose == FIL_TABLESPACE) {
+		buf_page_t*	bpage = static_cast<buf_page_t*>(message);
+
+		if (type == OS_FILE_READ && !buf_page_get_zip_size(bpage)) {
+			fil_node_decompress_pages(
+				fil_node,
+				((buf_block_t*) bpage)->frame,
+				UNIV_PAGE_SIZE);
+		}
+
 		srv_set_io_thread_op_info(segment, "complete io for buf page");
-		buf_page_io_complete(static_cast<buf_page_t*>(message));
+		buf_page_io_complete(bpage);
 	} else {
 		srv_set_io_thread_op_info(segment, "complete io for log");
 		log_io_complete(static_cast<log_group_t*>(message));
@@ -6190,6 +6492,115 @@ fil_page_get_type(
 	return(mach_read_from_2(page + FIL_PAGE_TYPE));
 }
 
+/*********************************************************************//**
+Compresses a page for writing it to a tablespace with transparent page
+compression, see FIL_PAGE_COMPRESS_DATA.
+@return number of bytes to write from dst, a multiple of block_size that
+is less than UNIV_PAGE_SIZE, or 0 if the page is to be written as is */
+
+ulint
+fil_page_compress(
+/*==============*/
+	const byte*	src,		/*!< in: page */
+	byte*		dst,		/*!< out: compressed page, of
+					UNIV_PAGE_SIZE bytes */
+	ulint		algorithm,	/*!< in: page_zip_algorithm_t */
+	ulint		block_size)	/*!< in: file system block size,
+					a power of 2 */
+{
+	ulint	zip_len;
+	ulint	len;
+
+	ut_ad(ut_is_2pow(block_size));
+	ut_ad(fil_page_get_type(src) != FIL_PAGE_COMPRESSED);
+
+	/* Unless the page shrinks by at least one file system block,
+	compressing it does not save any space. */
+	if (block_size + FIL_PAGE_COMPRESS_DATA >= UNIV_PAGE_SIZE) {
+
+		return(0);
+	}
+
+	zip_len = page_zip_compress_buf(
+		static_cast<page_zip_algorithm_t>(algorithm), page_zip_level,
+		src + FIL_PAGE_DATA, UNIV_PAGE_SIZE - FIL_PAGE_DATA,
+		dst + FIL_PAGE_COMPRESS_DATA,
+		UNIV_PAGE_SIZE - block_size - FIL_PAGE_COMPRESS_DATA);
+
+	if (zip_len == 0) {
+
+		return(0);
+	}
+
+	memcpy(dst, src, FIL_PAGE_DATA);
+
+	fil_page_set_type(dst, FIL_PAGE_COMPRESSED);
+	mach_write_to_2(dst + FIL_PAGE_COMPRESS_ORIGINAL_TYPE,
+			fil_page_get_type(src));
+	mach_write_to_1(dst + FIL_PAGE_COMPRESS_ALGORITHM, algorithm);
+	mach_write_to_2(dst + FIL_PAGE_COMPRESS_SIZE, zip_len);
+
+	len = ut_calc_align(FIL_PAGE_COMPRESS_DATA + zip_len, block_size);
+
+	memset(dst + FIL_PAGE_COMPRESS_DATA + zip_len, 0,
+	       len - FIL_PAGE_COMPRESS_DATA - zip_len);
+
+	ut_ad(len < UNIV_PAGE_SIZE);
+
+	return(len);
+}
+
+/*********************************************************************//**
+Restores a page that fil_page_compress() compressed. Other pages are
+left alone.
+@return false if the page is FIL_PAGE_COMPRESSED but cannot be
+decompressed; it is left as it is then, and fails the checksum check */
+
+bool
+fil_page_decompress(
+/*================*/
+	byte*		page)		/*!< in/out: page that was read */
+{
+	ulint	algorithm;
+	ulint	zip_len;
+	ulint	type;
+	ulint	len;
+	/* The compressed data overlaps the decompressed data. This is
+	called for every compressed page that is read, so it does not
+	allocate memory. */
+	byte	buf[UNIV_PAGE_SIZE_MAX - FIL_PAGE_DATA];
+
+	if (fil_page_get_type(page) != FIL_PAGE_COMPRESSED) {
+
+		return(true);
+	}
+
+	algorithm = mach_read_from_1(page + FIL_PAGE_COMPRESS_ALGORITHM);
+	zip_len = mach_read_from_2(page + FIL_PAGE_COMPRESS_SIZE);
+	type = mach_read_from_2(page + FIL_PAGE_COMPRESS_ORIGINAL_TYPE);
+
+	if (algorithm >= PAGE_ZIP_N_ALGORITHMS
+	    || !page_zip_algorithm_is_available(
+		    static_cast<page_zip_algorithm_t>(algorithm))
+	    || zip_len == 0
+	    || zip_len > UNIV_PAGE_SIZE - FIL_PAGE_COMPRESS_DATA) {
+
+		return(false);
+	}
+
+	len = page_zip_decompress_buf(
+		static_cast<page_zip_algorithm_t>(algorithm),
+		page + FIL_PAGE_COMPRESS_DATA, zip_len,
+		buf, UNIV_PAGE_SIZE - FIL_PAGE_DATA);
+
+	if (len == UNIV_PAGE_SIZE - FIL_PAGE_DATA) {
+		memcpy(page + FIL_PAGE_DATA, buf, len);
+		fil_page_set_type(page, type);
+	}
+
+	return(len == UNIV_PAGE_SIZE - FIL_PAGE_DATA);
+}
+
 /****************************************************************//**
 Closes the tablespace memory cache. */
 
@@ -6313,6 +6724,25 @@ fil_iterate(
 			return(DB_IO_ERROR);
 		}
 
+		/* Restore the pages that were written compressed by
+		fil_page_compress(). If the pages are written back, they
+		are written uncompressed. */
+		for (ulint i = 0;
+		     callback.get_zip_size() == 0 && i < n_bytes;
+		     i += iter.page_size) {
+
+			if (!fil_page_decompress(io_buffer + i)) {
+
+				ib_logf(IB_LOG_LEVEL_ERROR,
+					"Cannot decompress page " UINT64PF
+					" of file %s.",
+					(offset + i) / iter.page_size,
+					iter.filepath);
+
+				return(DB_CORRUPTION);
+			}
+		}
+
 		bool		updated = false;
 		os_offset_t	page_off = offset;
 		ulint		n_pages_read = (ulint) n_bytes / iter.page_size;
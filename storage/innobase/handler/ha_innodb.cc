@@ -69,6 +69,7 @@ this program; if not, write to the Free Software Foundation, Inc.,
 #include "row0sel.h"
 #include "row0upd.h"
 #include "log0log.h"
+#include "log0recv.h"
 #include "lock0lock.h"
 #include "dict0crea.h"
 #include "btr0cur.h"
@@ -223,6 +224,24 @@ static TYPELIB innodb_checksum_algorithm_typelib = {
 	NULL
 };
 
+/** Possible values for system variable "innodb_compression_algorithm",
+in the order of page_zip_algorithm_t. */
+static const char* innodb_compression_algorithm_names[] = {
+	"zlib",
+	"lz4",
+	"zstd",
+	NullS
+};
+
+/** Used to define an enumerate type of the system variable
+innodb_compression_algorithm. */
+static TYPELIB innodb_compression_algorithm_typelib = {
+	array_elements(innodb_compression_algorithm_names) - 1,
+	"innodb_compression_algorithm_typelib",
+	innodb_compression_algorithm_names,
+	NULL
+};
+
 /* The following counter is used to convey information to InnoDB
 about server activity: in selects it is not sensible to call
 srv_active_wake_master_thread after each fetch or search, we only do
@@ -300,6 +319,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	PSI_KEY(hash_table_mutex),
 	PSI_KEY(ibuf_bitmap_mutex),
 	PSI_KEY(ibuf_mutex),
+	PSI_KEY(ibuf_merge_mutex),
 	PSI_KEY(ibuf_pessimistic_insert_mutex),
 #  ifndef HAVE_ATOMIC_BUILTINS
 	PSI_KEY(server_mutex),
@@ -310,6 +330,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 #  endif /* UNIV_MEM_DEBUG */
 	PSI_KEY(mem_pool_mutex),
 	PSI_KEY(page_zip_stat_per_index_mutex),
+	PSI_KEY(page_cleaner_mutex),
 	PSI_KEY(purge_sys_pq_mutex),
 	PSI_KEY(recv_sys_mutex),
 	PSI_KEY(recv_writer_mutex),
@@ -332,7 +353,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	PSI_KEY(trx_pool_mutex),
 	PSI_KEY(trx_pool_manager_mutex),
 	PSI_KEY(srv_sys_mutex),
-	PSI_KEY(lock_mutex),
+	PSI_KEY(lock_rec_shard_mutex),
 	PSI_KEY(lock_wait_mutex),
 	PSI_KEY(trx_mutex),
 	PSI_KEY(srv_threads_mutex),
@@ -348,6 +369,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	PSI_KEY(ut_list_mutex),
 	PSI_KEY(trx_sys_mutex),
 	PSI_KEY(zip_pad_mutex),
+	PSI_KEY(row_merge_mutex),
 };
 # endif /* UNIV_PFS_MUTEX */
 
@@ -370,6 +392,7 @@ static PSI_rwlock_info all_innodb_rwlocks[] = {
 	PSI_KEY(fts_cache_init_rw_lock),
 	PSI_KEY(trx_i_s_cache_lock),
 	PSI_KEY(trx_purge_latch),
+	PSI_KEY(lock_sys_latch),
 	PSI_KEY(index_tree_rw_lock),
 	PSI_KEY(index_online_log),
 	PSI_KEY(dict_table_stats),
@@ -389,12 +412,19 @@ static PSI_thread_info	all_innodb_threads[] = {
 	PSI_KEY(io_write_thread),
 	PSI_KEY(io_handler_thread),
 	PSI_KEY(srv_lock_timeout_thread),
+	PSI_KEY(srv_lock_deadlock_thread),
 	PSI_KEY(srv_error_monitor_thread),
 	PSI_KEY(srv_monitor_thread),
 	PSI_KEY(srv_master_thread),
 	PSI_KEY(srv_purge_thread),
 	PSI_KEY(page_cleaner_thread),
-	PSI_KEY(recv_writer_thread)
+	PSI_KEY(recv_writer_thread),
+	PSI_KEY(recv_apply_thread),
+	PSI_KEY(buf_load_thread),
+	PSI_KEY(row_merge_thread),
+	PSI_KEY(log_writer_thread),
+	PSI_KEY(log_flusher_thread),
+	PSI_KEY(ibuf_merge_thread)
 };
 # endif /* UNIV_PFS_THREAD */
 
@@ -532,6 +562,22 @@ static MYSQL_THDVAR_STR(ft_user_stopword_table,
   "User supplied stopword table name, effective in the session level.",
   innodb_stopword_table_validate, NULL, NULL);
 
+static MYSQL_THDVAR_ENUM(compression_algorithm, PLUGIN_VAR_RQCMDARG,
+  "The algorithm that compresses the pages of the ROW_FORMAT=COMPRESSED"
+  " tables, and of the tables with innodb_page_compression, that are"
+  " created or rebuilt. Values: zlib (default), lz4, zstd."
+  " lz4 and zstd are available if InnoDB was built with them.",
+  NULL, NULL, PAGE_ZIP_ALGORITHM_ZLIB,
+  &innodb_compression_algorithm_typelib);
+
+static MYSQL_THDVAR_BOOL(page_compression, PLUGIN_VAR_OPCMDARG,
+  "Compress the pages of the tables that are created or rebuilt in their"
+  " own tablespace without ROW_FORMAT=COMPRESSED with"
+  " innodb_compression_algorithm when they are written to the file, and"
+  " punch holes for the unused end of each page. This needs a file system"
+  " with sparse files. The buffer pool keeps the pages uncompressed.",
+  NULL, NULL, FALSE);
+
 static SHOW_VAR innodb_status_variables[]= {
   {"buffer_pool_dump_status",
   (char*) &export_vars.innodb_buffer_pool_dump_status,	  SHOW_CHAR},
@@ -607,10 +653,14 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_os_log_pending_writes,	  SHOW_LONG},
   {"os_log_written",
   (char*) &export_vars.innodb_os_log_written,		  SHOW_LONGLONG},
+  {"page_compression_saved",
+  (char*) &export_vars.innodb_page_compression_saved,	  SHOW_LONG},
   {"page_size",
   (char*) &export_vars.innodb_page_size,		  SHOW_LONG},
   {"pages_created",
   (char*) &export_vars.innodb_pages_created,		  SHOW_LONG},
+  {"pages_page_compressed",
+  (char*) &export_vars.innodb_pages_page_compressed,	  SHOW_LONG},
   {"pages_read",
   (char*) &export_vars.innodb_pages_read,		  SHOW_LONG},
   {"pages_written",
@@ -4563,7 +4613,7 @@ ha_innobase::open(
 	thd = ha_thd();
 
 	/* Under some cases MySQL seems to call this function while
-	holding btr_search_latch. This breaks the latching order as
+	holding an adaptive hash index latch. This breaks the latching order as
 	we acquire dict_sys->mutex below and leads to a deadlock. */
 	if (thd != NULL) {
 		innobase_release_temporary_latches(ht, thd);
@@ -9174,6 +9224,35 @@ index_bad:
 		*flags2 |= DICT_TF2_USE_TABLESPACE;
 	}
 
+	if (!zip_ssize && THDVAR(thd, page_compression)) {
+		if (use_tablespace) {
+			*flags2 |= DICT_TF2_PAGE_COMPRESSION;
+		} else {
+			push_warning(
+				thd, Sql_condition::SL_WARNING,
+				ER_ILLEGAL_HA_CREATE_OPTION,
+				"InnoDB: innodb_page_compression requires"
+				" innodb_file_per_table.");
+		}
+	}
+
+	if (zip_ssize || (*flags2 & DICT_TF2_PAGE_COMPRESSION)) {
+		ulint	algorithm = THDVAR(thd, compression_algorithm);
+
+		if (!page_zip_algorithm_is_available(
+			    static_cast<page_zip_algorithm_t>(algorithm))) {
+			push_warning_printf(
+				thd, Sql_condition::SL_WARNING,
+				ER_ILLEGAL_HA_CREATE_OPTION,
+				"InnoDB: innodb_compression_algorithm=%s"
+				" is not available. Using zlib.",
+				innodb_compression_algorithm_names[algorithm]);
+			algorithm = PAGE_ZIP_ALGORITHM_ZLIB;
+		}
+
+		*flags2 |= algorithm << DICT_TF2_POS_ZIP_ALGORITHM;
+	}
+
 	DBUG_RETURN(true);
 }
 
@@ -15273,6 +15352,24 @@ static MYSQL_SYSVAR_ULONG(purge_threads, srv_n_purge_threads,
   1,			/* Minimum value */
   32, 0);		/* Maximum value */
 
+static MYSQL_SYSVAR_ULONG(page_cleaners, srv_n_page_cleaners,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Page cleaner threads can be from 1 to 16, and at most the number of"
+  " buffer pool instances. Default is 1.",
+  NULL, NULL,
+  1,			/* Default setting */
+  1,			/* Minimum value */
+  BUF_FLUSH_PAGE_CLEANERS_MAX, 0);	/* Maximum value */
+
+static MYSQL_SYSVAR_ULONG(recovery_threads, srv_n_recovery_threads,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Number of threads applying redo log records to pages in crash recovery,"
+  " from 1 to 64. Default is 4.",
+  NULL, NULL,
+  4,			/* Default setting */
+  1,			/* Minimum value */
+  RECV_MAX_APPLY_THREADS, 0);	/* Maximum value */
+
 static MYSQL_SYSVAR_ULONG(sync_array_size, srv_sync_array_size,
   PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
   "Size of the mutex/lock wait array.",
@@ -15331,6 +15428,19 @@ static MYSQL_SYSVAR_UINT(flush_log_at_timeout, srv_flush_log_at_timeout,
   "Write and flush logs every (n) second.",
   NULL, NULL, 1, 0, 2700, 0);
 
+static MYSQL_SYSVAR_BOOL(log_writer_threads, srv_log_writer_threads,
+  PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
+  "Write and flush the redo log in dedicated background threads instead"
+  " of in the committing threads (ON by default).",
+  NULL, NULL, TRUE);
+
+static MYSQL_SYSVAR_ULONG(log_wait_spin_rounds, srv_log_wait_spin_rounds,
+  PLUGIN_VAR_RQCMDARG,
+  "Count of spin-loop rounds a thread does while waiting for the log writer"
+  " or flusher before it sleeps, if recent log writes and flushes were fast"
+  " (30 by default)",
+  NULL, NULL, 30L, 0L, ~0UL, 0);
+
 static MYSQL_SYSVAR_ULONG(flush_log_at_trx_commit, srv_flush_log_at_trx_commit,
   PLUGIN_VAR_OPCMDARG,
   "Set to 0 (write and flush once per second),"
@@ -15459,6 +15569,13 @@ static MYSQL_SYSVAR_BOOL(adaptive_hash_index, btr_search_enabled,
   "Disable with --skip-innodb-adaptive-hash-index.",
   NULL, innodb_adaptive_hash_index_update, TRUE);
 
+static MYSQL_SYSVAR_ULONG(adaptive_hash_index_parts, btr_ahi_parts,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of InnoDB adaptive hash index partitions, each with its own "
+  "latch. An index is assigned to a partition by its index id "
+  "(default 8).",
+  NULL, NULL, 8, 1, BTR_AHI_PARTS_MAX, 0);
+
 static MYSQL_SYSVAR_ULONG(replication_delay, srv_replication_delay,
   PLUGIN_VAR_RQCMDARG,
   "Replication thread delay (ms) on the slave server if "
@@ -15558,6 +15675,18 @@ static MYSQL_SYSVAR_BOOL(buffer_pool_load_abort, innodb_buffer_pool_load_abort,
   "Abort a currently running load of the buffer pool",
   NULL, buffer_pool_load_abort, FALSE);
 
+static MYSQL_SYSVAR_ULONG(buffer_pool_load_threads, srv_buf_pool_load_threads,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of threads reading the pages of each buffer pool in a load of"
+  " the buffer pool, from 1 to 16. Default is 1.",
+  NULL, NULL, 1, 1, BUF_LOAD_MAX_THREADS, 0);
+
+static MYSQL_SYSVAR_ULONG(buffer_pool_load_hot_pct, srv_buf_pool_load_hot_pct,
+  PLUGIN_VAR_RQCMDARG,
+  "Load the hottest N% of the pages in @@innodb_buffer_pool_filename before"
+  " the other pages, 0 loads all the pages at once (the default)",
+  NULL, NULL, 0, 0, 100, 0);
+
 /* there is no point in changing this during runtime, thus readonly */
 static MYSQL_SYSVAR_BOOL(buffer_pool_load_at_startup, srv_buffer_pool_load_at_startup,
   PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
@@ -15648,6 +15777,20 @@ static MYSQL_SYSVAR_ULONG(sort_buffer_size, srv_sort_buf_size,
   "Memory buffer size for index creation",
   NULL, NULL, 1048576, 65536, 64<<20, 0);
 
+static MYSQL_SYSVAR_ULONG(sort_threads, srv_sort_threads,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of threads that read the clustered index and sort the entries"
+  " when creating secondary indexes without rebuilding the table."
+  " 1 (the default) builds the indexes in the connection thread.",
+  NULL, NULL, 1, 1, ROW_MERGE_MAX_THREADS, 0);
+
+static MYSQL_SYSVAR_ULONG(fill_factor, srv_fill_factor,
+  PLUGIN_VAR_RQCMDARG,
+  "Percentage of each B-tree page to fill when loading sorted entries"
+  " in index creation. 100 (the default) fills secondary index pages"
+  " completely and leaves 1/16 of clustered index pages free.",
+  NULL, NULL, 100, 10, 100, 0);
+
 static MYSQL_SYSVAR_ULONGLONG(online_alter_log_max_size, srv_online_max_size,
   PLUGIN_VAR_RQCMDARG,
   "Maximum modification log file size for online index creation",
@@ -15784,6 +15927,20 @@ static MYSQL_SYSVAR_ULONG(undo_logs, srv_undo_logs,
   1,			/* Minimum value */
   TRX_SYS_N_RSEGS, 0);	/* Maximum value */
 
+static MYSQL_SYSVAR_BOOL(undo_log_truncate, srv_undo_log_truncate,
+  PLUGIN_VAR_OPCMDARG,
+  "Enable or Disable Truncate of UNDO tablespace (off by default).",
+  NULL, NULL, FALSE);
+
+static MYSQL_SYSVAR_ULONGLONG(max_undo_log_size, srv_max_undo_log_size,
+  PLUGIN_VAR_OPCMDARG,
+  "Maximum size of an UNDO tablespace in bytes. If it grows beyond this"
+  " size, purge truncates it when innodb_undo_log_truncate is set.",
+  NULL, NULL,
+  1024 * 1024 * 1024L,	/* Default setting */
+  10 * 1024 * 1024L,	/* Minimum value */
+  ~0ULL, 0);		/* Maximum value */
+
 /* Alias for innodb_undo_logs, this config variable is deprecated. */
 static MYSQL_SYSVAR_ULONG(rollback_segments, srv_undo_logs,
   PLUGIN_VAR_OPCMDARG,
@@ -15821,6 +15978,12 @@ static MYSQL_SYSVAR_BOOL(use_native_aio, srv_use_native_aio,
   "Use native AIO if supported on this platform.",
   NULL, NULL, TRUE);
 
+static MYSQL_SYSVAR_BOOL(use_io_uring, srv_use_io_uring,
+  PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
+  "Submit native AIO requests through io_uring instead of libaio "
+  "if supported on this platform.",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_BOOL(api_enable_binlog, ib_binlog_enabled,
   PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
   "Enable binlog for applications direct access InnoDB through InnoDB APIs",
@@ -15867,6 +16030,18 @@ static MYSQL_SYSVAR_UINT(change_buffer_max_size,
   NULL, innodb_change_buffer_max_size_update,
   CHANGE_BUFFER_DEFAULT_SIZE, 0, 50, 0);
 
+static MYSQL_SYSVAR_ULONG(change_buffer_merge_threads, srv_ibuf_merge_threads,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of threads that merge the change buffer, one tablespace at a"
+  " time in page order. 0 means that the master thread merges it.",
+  NULL, NULL, 0, 0, 16, 0);
+
+static MYSQL_SYSVAR_ULONG(change_buffer_merge_rate, srv_ibuf_merge_rate,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of pages per second that the change buffer merge threads read."
+  " 0 means innodb_io_capacity.",
+  NULL, NULL, 0, 0, ~0UL, 0);
+
 static MYSQL_SYSVAR_ENUM(stats_method, srv_innodb_stats_method,
    PLUGIN_VAR_RQCMDARG,
   "Specifies how InnoDB index statistics collection code should "
@@ -15927,6 +16102,13 @@ static MYSQL_SYSVAR_BOOL(print_all_deadlocks, srv_print_all_deadlocks,
   "Print all deadlocks to MySQL error log (off by default)",
   NULL, NULL, FALSE);
 
+static MYSQL_SYSVAR_BOOL(deadlock_detect_background,
+  srv_deadlock_detect_background,
+  PLUGIN_VAR_OPCMDARG,
+  "Search for deadlocks in a background thread instead of when a lock"
+  " wait starts (off by default)",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_ULONG(compression_failure_threshold_pct,
   zip_failure_threshold_pct, PLUGIN_VAR_OPCMDARG,
   "If the compression failure rate of a table is greater than this number"
@@ -15986,6 +16168,8 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
 #endif /* UNIV_DEBUG */
   MYSQL_SYSVAR(buffer_pool_load_now),
   MYSQL_SYSVAR(buffer_pool_load_abort),
+  MYSQL_SYSVAR(buffer_pool_load_threads),
+  MYSQL_SYSVAR(buffer_pool_load_hot_pct),
   MYSQL_SYSVAR(buffer_pool_load_at_startup),
   MYSQL_SYSVAR(lru_scan_depth),
   MYSQL_SYSVAR(flush_neighbors),
@@ -15994,6 +16178,8 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(commit_concurrency),
   MYSQL_SYSVAR(concurrency_tickets),
   MYSQL_SYSVAR(compression_level),
+  MYSQL_SYSVAR(compression_algorithm),
+  MYSQL_SYSVAR(page_compression),
   MYSQL_SYSVAR(data_file_path),
   MYSQL_SYSVAR(temp_data_file_path),
   MYSQL_SYSVAR(data_home_dir),
@@ -16011,6 +16197,8 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(file_format_max),
   MYSQL_SYSVAR(flush_log_at_timeout),
   MYSQL_SYSVAR(flush_log_at_trx_commit),
+  MYSQL_SYSVAR(log_writer_threads),
+  MYSQL_SYSVAR(log_wait_spin_rounds),
   MYSQL_SYSVAR(flush_method),
   MYSQL_SYSVAR(force_recovery),
 #ifndef DBUG_OFF
@@ -16058,12 +16246,15 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(stats_persistent_sample_pages),
   MYSQL_SYSVAR(stats_auto_recalc),
   MYSQL_SYSVAR(adaptive_hash_index),
+  MYSQL_SYSVAR(adaptive_hash_index_parts),
   MYSQL_SYSVAR(stats_method),
   MYSQL_SYSVAR(replication_delay),
   MYSQL_SYSVAR(status_file),
   MYSQL_SYSVAR(strict_mode),
   MYSQL_SYSVAR(support_xa),
   MYSQL_SYSVAR(sort_buffer_size),
+  MYSQL_SYSVAR(sort_threads),
+  MYSQL_SYSVAR(fill_factor),
   MYSQL_SYSVAR(online_alter_log_max_size),
   MYSQL_SYSVAR(sync_spin_loops),
   MYSQL_SYSVAR(spin_wait_delay),
@@ -16077,8 +16268,11 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(version),
   MYSQL_SYSVAR(use_sys_malloc),
   MYSQL_SYSVAR(use_native_aio),
+  MYSQL_SYSVAR(use_io_uring),
   MYSQL_SYSVAR(change_buffering),
   MYSQL_SYSVAR(change_buffer_max_size),
+  MYSQL_SYSVAR(change_buffer_merge_threads),
+  MYSQL_SYSVAR(change_buffer_merge_rate),
 #if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
   MYSQL_SYSVAR(change_buffering_debug),
   MYSQL_SYSVAR(disable_background_merge),
@@ -16093,6 +16287,8 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(monitor_reset),
   MYSQL_SYSVAR(monitor_reset_all),
   MYSQL_SYSVAR(purge_threads),
+  MYSQL_SYSVAR(page_cleaners),
+  MYSQL_SYSVAR(recovery_threads),
   MYSQL_SYSVAR(purge_batch_size),
 #ifdef UNIV_DEBUG
   MYSQL_SYSVAR(purge_run_now),
@@ -16104,11 +16300,14 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(doublewrite_batch_size),
 #endif /* defined UNIV_DEBUG || defined UNIV_PERF_DEBUG */
   MYSQL_SYSVAR(print_all_deadlocks),
+  MYSQL_SYSVAR(deadlock_detect_background),
   MYSQL_SYSVAR(cmp_per_index_enabled),
   MYSQL_SYSVAR(undo_logs),
   MYSQL_SYSVAR(rollback_segments),
   MYSQL_SYSVAR(undo_directory),
   MYSQL_SYSVAR(undo_tablespaces),
+  MYSQL_SYSVAR(undo_log_truncate),
+  MYSQL_SYSVAR(max_undo_log_size),
   MYSQL_SYSVAR(sync_array_size),
   MYSQL_SYSVAR(compression_failure_threshold_pct),
   MYSQL_SYSVAR(compression_pad_pct_max),
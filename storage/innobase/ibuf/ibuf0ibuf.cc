@@ -65,6 +65,10 @@ my_bool	srv_ibuf_disable_background_merge;
 #include "srv0space.h"
 #include "rem0cmp.h"
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 /*	STRUCTURE OF AN INSERT BUFFER RECORD
 
 In versions < 4.1.x:
@@ -293,6 +297,9 @@ static ib_mutex_t	ibuf_mutex;
 /** The mutex protecting the insert buffer bitmaps */
 static ib_mutex_t	ibuf_bitmap_mutex;
 
+/** The mutex protecting the merge position */
+static ib_mutex_t	ibuf_merge_mutex;
+
 /** The area in pages from which contract looks for page numbers for merge */
 #define	IBUF_MERGE_AREA			8UL
 
@@ -320,6 +327,56 @@ this many pages, we start to contract it synchronous contract, but do
 not insert */
 #define IBUF_CONTRACT_DO_NOT_INSERT		10
 
+/** A merge thread reads at most this many pages in one batch */
+#define IBUF_MERGE_THREAD_BATCH		256UL
+
+/** The merge threads claim their next batch of pages from this position
+in the insert buffer tree, and move it past the pages that they read.
+Protected by ibuf_merge_mutex. */
+static ulint	ibuf_merge_space_id;
+/** Page number of the merge position */
+static ulint	ibuf_merge_page_no;
+
+/** Number of tablespaces whose backlog can be counted; a prime */
+#define IBUF_BACKLOG_SLOTS		1021UL
+
+/** ibuf_backlog_slot_t::space of a slot that was never used */
+#define IBUF_BACKLOG_FREE		ULINT_UNDEFINED
+
+/** ibuf_backlog_slot_t::space of a slot whose tablespace was dropped */
+#define IBUF_BACKLOG_DROPPED		(ULINT_UNDEFINED - 1)
+
+/** Number of buffered operations of a tablespace */
+struct ibuf_backlog_slot_t {
+	ulint	space;	/*!< space id, IBUF_BACKLOG_FREE or
+			IBUF_BACKLOG_DROPPED */
+	ulint	n_ops;	/*!< operations buffered and not yet merged
+			or discarded */
+};
+
+/** The operations per tablespace that have been buffered and not yet
+merged or discarded. The operations that were buffered before the server
+was started are not counted, so this is a lower limit. A tablespace has
+a slot by open addressing from the hash of its id. Lookups do not latch
+anything, and step over the slots of dropped tablespaces; a slot is
+claimed, or given up when its tablespace is dropped, under
+ibuf_merge_mutex, and a claim may reuse the slot of a dropped
+tablespace. The counts are updated with atomic operations, so that
+buffering and merging do not share a latch. */
+static ibuf_backlog_slot_t	ibuf_backlog[IBUF_BACKLOG_SLOTS];
+
+/** Operations that were not counted in ibuf_backlog because all of its
+slots were taken. Protected by ibuf_merge_mutex. */
+static ulint	ibuf_backlog_n_lost;
+
+/** Number of tablespaces with the largest backlog that ibuf_print()
+shows */
+#define IBUF_PRINT_BACKLOG_SPACES	10UL
+
+#ifdef UNIV_PFS_THREAD
+mysql_pfs_key_t	ibuf_merge_thread_key;
+#endif /* UNIV_PFS_THREAD */
+
 /* TODO: how to cope with drop table if there are records in the insert
 buffer for the indexes of the table? Is there actually any problem,
 because ibuf merge is done to a page when it is read in, and it is
@@ -469,6 +526,11 @@ ibuf_close(void)
 	mutex_free(&ibuf_bitmap_mutex);
 	memset(&ibuf_bitmap_mutex, 0x0, sizeof(ibuf_mutex));
 
+	mutex_free(&ibuf_merge_mutex);
+	memset(&ibuf_merge_mutex, 0x0, sizeof(ibuf_merge_mutex));
+
+	os_event_destroy(ibuf->merge_event);
+
 	mem_free(ibuf);
 	ibuf = NULL;
 }
@@ -527,6 +589,20 @@ ibuf_init_at_db_start(void)
 
 	mutex_create("ibuf_pessimistic_insert", &ibuf_pessimistic_insert_mutex);
 
+	mutex_create("ibuf_merge", &ibuf_merge_mutex);
+
+	ibuf->merge_event = os_event_create(0);
+
+	for (ulint i = 0; i < IBUF_BACKLOG_SLOTS; i++) {
+		ibuf_backlog[i].space = IBUF_BACKLOG_FREE;
+		ibuf_backlog[i].n_ops = 0;
+	}
+
+	ibuf_backlog_n_lost = 0;
+
+	ibuf_merge_space_id = 0;
+	ibuf_merge_page_no = 0;
+
 	mtr_start(&mtr);
 
 	mutex_enter(&ibuf_mutex);
@@ -1487,6 +1563,184 @@ ibuf_add_ops(
 	}
 }
 
+/*********************************************************************//**
+Looks up the backlog slot of a tablespace.
+@return the slot, or NULL if the tablespace has none */
+static
+ibuf_backlog_slot_t*
+ibuf_backlog_get(
+/*=============*/
+	ulint	space)	/*!< in: space id */
+{
+	ulint	fold = ut_hash_ulint(space, IBUF_BACKLOG_SLOTS);
+
+	for (ulint i = 0; i < IBUF_BACKLOG_SLOTS; i++) {
+		ibuf_backlog_slot_t*	slot = &ibuf_backlog[
+			(fold + i) % IBUF_BACKLOG_SLOTS];
+		ulint			slot_space = slot->space;
+
+		if (slot_space == space) {
+			return(slot);
+		} else if (slot_space == IBUF_BACKLOG_FREE) {
+			/* A slot that was never used ends the probe
+			sequence of every tablespace that hashes
+			before it. */
+			return(NULL);
+		}
+	}
+
+	return(NULL);
+}
+
+/*********************************************************************//**
+Looks up the backlog slot of a tablespace, and claims one if it has none.
+The caller must hold ibuf_merge_mutex.
+@return the slot, or NULL if all slots are taken */
+static
+ibuf_backlog_slot_t*
+ibuf_backlog_create(
+/*================*/
+	ulint	space)	/*!< in: space id */
+{
+	ulint			fold = ut_hash_ulint(space, IBUF_BACKLOG_SLOTS);
+	ibuf_backlog_slot_t*	reuse = NULL;
+
+	ut_ad(mutex_own(&ibuf_merge_mutex));
+
+	for (ulint i = 0; i < IBUF_BACKLOG_SLOTS; i++) {
+		ibuf_backlog_slot_t*	slot = &ibuf_backlog[
+			(fold + i) % IBUF_BACKLOG_SLOTS];
+
+		if (slot->space == space) {
+			return(slot);
+		} else if (slot->space == IBUF_BACKLOG_DROPPED) {
+			if (reuse == NULL) {
+				reuse = slot;
+			}
+		} else if (slot->space == IBUF_BACKLOG_FREE) {
+			if (reuse == NULL) {
+				reuse = slot;
+			}
+			break;
+		}
+	}
+
+	if (reuse != NULL) {
+		reuse->n_ops = 0;
+#ifdef HAVE_ATOMIC_BUILTINS
+		/* Publish the slot to the lookups only after its count
+		has been reset; a compare-and-swap is a full barrier. */
+		ibool	claimed = os_compare_and_swap_ulint(
+			&reuse->space, reuse->space, space);
+		ut_a(claimed);
+#else /* HAVE_ATOMIC_BUILTINS */
+		reuse->space = space;
+#endif /* HAVE_ATOMIC_BUILTINS */
+	}
+
+	return(reuse);
+}
+
+/*********************************************************************//**
+Adds buffered operations to the backlog of a tablespace. */
+static
+void
+ibuf_backlog_add(
+/*=============*/
+	ulint	space,	/*!< in: space id */
+	ulint	n_ops)	/*!< in: number of operations */
+{
+	ibuf_backlog_slot_t*	slot;
+
+#ifdef HAVE_ATOMIC_BUILTINS
+	slot = ibuf_backlog_get(space);
+
+	if (slot != NULL) {
+		os_atomic_increment_ulint(&slot->n_ops, n_ops);
+		return;
+	}
+#endif /* HAVE_ATOMIC_BUILTINS */
+
+	mutex_enter(&ibuf_merge_mutex);
+
+	slot = ibuf_backlog_create(space);
+
+	if (slot == NULL) {
+		ibuf_backlog_n_lost += n_ops;
+	} else {
+#ifdef HAVE_ATOMIC_BUILTINS
+		os_atomic_increment_ulint(&slot->n_ops, n_ops);
+#else /* HAVE_ATOMIC_BUILTINS */
+		slot->n_ops += n_ops;
+#endif /* HAVE_ATOMIC_BUILTINS */
+	}
+
+	mutex_exit(&ibuf_merge_mutex);
+}
+
+/*********************************************************************//**
+Removes merged or discarded operations from the backlog of a tablespace.
+The backlog does not go below zero, because the operations that were
+buffered before the server was started were never added to it. */
+static
+void
+ibuf_backlog_sub(
+/*=============*/
+	ulint	space,	/*!< in: space id */
+	ulint	n_ops)	/*!< in: number of operations */
+{
+#ifndef HAVE_ATOMIC_BUILTINS
+	mutex_enter(&ibuf_merge_mutex);
+#endif /* !HAVE_ATOMIC_BUILTINS */
+
+	ibuf_backlog_slot_t*	slot = ibuf_backlog_get(space);
+
+	if (slot == NULL) {
+		/* Nothing was buffered since the server was started */
+#ifdef HAVE_ATOMIC_BUILTINS
+	} else {
+		ulint	old_n_ops;
+
+		do {
+			old_n_ops = slot->n_ops;
+		} while (!os_compare_and_swap_ulint(
+				 &slot->n_ops, old_n_ops,
+				 n_ops >= old_n_ops ? 0 : old_n_ops - n_ops));
+	}
+#else /* HAVE_ATOMIC_BUILTINS */
+	} else if (n_ops >= slot->n_ops) {
+		slot->n_ops = 0;
+	} else {
+		slot->n_ops -= n_ops;
+	}
+
+	mutex_exit(&ibuf_merge_mutex);
+#endif /* HAVE_ATOMIC_BUILTINS */
+}
+
+/*********************************************************************//**
+Gives up the backlog slot of a dropped tablespace, so that another
+tablespace can claim it. */
+static
+void
+ibuf_backlog_drop(
+/*==============*/
+	ulint	space)	/*!< in: space id */
+{
+	mutex_enter(&ibuf_merge_mutex);
+
+	ibuf_backlog_slot_t*	slot = ibuf_backlog_get(space);
+
+	if (slot != NULL) {
+		slot->n_ops = 0;
+		/* Lookups step over the slot, so that they still find
+		the tablespaces that claimed a slot after it. */
+		slot->space = IBUF_BACKLOG_DROPPED;
+	}
+
+	mutex_exit(&ibuf_merge_mutex);
+}
+
 /****************************************************************//**
 Print operation counts. The array must be of size IBUF_OP_COUNT. */
 static
@@ -2846,6 +3100,209 @@ ibuf_contract_in_background(
 	return(sum_bytes);
 }
 
+/*********************************************************************//**
+Reads the next batch of pages for a merge thread to the buffer pool, so
+that the buffered changes are merged to them. The merge threads move a
+shared position through the insert buffer tree, so that each batch is a
+range of pages of one tablespace in page number order, and each page is
+read by only one thread. The tree is not latched while the position is
+updated: if another thread moved the position in the meantime, the batch
+is looked up again.
+@return a lower limit for the combined size in bytes of entries which
+will be merged from ibuf trees to the pages read, 0 if ibuf is
+empty */
+static
+ulint
+ibuf_merge_next_batch(
+/*==================*/
+	ulint	limit,		/*!< in: max number of pages to read */
+	ulint*	n_pages)	/*!< out: number of pages read */
+{
+	ulint		pages[IBUF_MERGE_THREAD_BATCH];
+	ulint		spaces[IBUF_MERGE_THREAD_BATCH];
+	ib_int64_t	versions[IBUF_MERGE_THREAD_BATCH];
+
+	ut_ad(limit > 0);
+	ut_ad(limit <= IBUF_MERGE_THREAD_BATCH);
+
+	for (;;) {
+		mutex_enter(&ibuf_merge_mutex);
+
+		ulint	start_space = ibuf_merge_space_id;
+		ulint	start_page_no = ibuf_merge_page_no;
+
+		mutex_exit(&ibuf_merge_mutex);
+
+		mtr_t		mtr;
+		btr_pcur_t	pcur;
+		mem_heap_t*	heap = mem_heap_create(512);
+		dtuple_t*	tuple = ibuf_search_tuple_build(
+			start_space, start_page_no, heap);
+		ulint		space = ULINT_UNDEFINED;
+		ulint		sum_sizes = 0;
+
+		*n_pages = 0;
+
+		ibuf_mtr_start(&mtr);
+
+		btr_pcur_open(
+			ibuf->index, tuple, PAGE_CUR_GE, BTR_SEARCH_LEAF,
+			&pcur, &mtr);
+
+		mem_heap_free(heap);
+
+		const rec_t*	rec = ibuf_get_user_rec(&pcur, &mtr);
+
+		if (rec != NULL) {
+			/* Read the pages of the first tablespace that has
+			buffered changes at or after the position. */
+			space = ibuf_rec_get_space(&mtr, rec);
+
+			sum_sizes = ibuf_get_merge_pages(
+				&pcur, space, limit,
+				pages, spaces, versions, n_pages, &mtr);
+		}
+
+		ibuf_mtr_commit(&mtr);
+		btr_pcur_close(&pcur);
+
+		mutex_enter(&ibuf_merge_mutex);
+
+		bool	claimed = ibuf_merge_space_id == start_space
+			&& ibuf_merge_page_no == start_page_no;
+
+		if (claimed && *n_pages > 0) {
+			ibuf_merge_space_id = space;
+			ibuf_merge_page_no = pages[*n_pages - 1] + 1;
+			ibuf->n_merge_thread_pages += *n_pages;
+		} else if (claimed) {
+			/* The end of the tree: start over from the
+			beginning. */
+			ibuf_merge_space_id = 0;
+			ibuf_merge_page_no = 0;
+		}
+
+		mutex_exit(&ibuf_merge_mutex);
+
+		if (!claimed) {
+			/* Another thread took these pages. */
+			continue;
+		} else if (*n_pages > 0) {
+			buf_read_ibuf_merge_pages(
+				true, spaces, versions, pages, *n_pages);
+
+			return(sum_sizes + 1);
+		} else if (start_space == 0 && start_page_no == 0) {
+			/* The whole tree is empty. */
+			return(0);
+		}
+	}
+}
+
+/*********************************************************************//**
+A thread which merges the change buffer to the index pages, when
+innodb_change_buffer_merge_threads is set. The threads read batches of
+pages of one tablespace at a time, and together read at most
+innodb_change_buffer_merge_rate pages per second.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(ibuf_merge_thread)(
+/*==============================*/
+	void*	arg __attribute__((unused)))
+			/*!< in: a dummy parameter required by
+			os_thread_create */
+{
+	ib_int64_t	sig_count = 0;
+
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(ibuf_merge_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	while (srv_shutdown_state < SRV_SHUTDOWN_CLEANUP) {
+		ulint	n_threads = srv_ibuf_merge_threads;
+		ulint	rate = srv_ibuf_merge_rate > 0
+			? srv_ibuf_merge_rate : srv_io_capacity;
+
+		/* A batch is at most one second of the share of this
+		thread of the rate, and at most a quarter of the share of
+		this thread of the buffer pool. */
+		ulint	limit = ut_min(
+			rate / n_threads,
+			buf_pool_get_n_pages() / (4 * n_threads));
+
+		limit = ut_max(ut_min(limit, IBUF_MERGE_THREAD_BATCH), 1UL);
+
+		bool	merge = !ibuf->empty;
+
+#if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
+		merge = merge && !srv_ibuf_disable_background_merge;
+#endif /* UNIV_DEBUG || UNIV_IBUF_DEBUG */
+
+		ullint	start_time = ut_time_us(NULL);
+		ulint	n_pages = 0;
+
+		if (merge) {
+			ibuf_merge_next_batch(limit, &n_pages);
+		}
+
+		ullint	wait_us = 1000000;
+
+		if (n_pages > 0) {
+			/* Sleep for the rest of the time that this
+			thread may take for the pages that it read. */
+			ullint	target_us = (ullint) n_pages * n_threads
+				* 1000000 / rate;
+			ullint	elapsed_us = ut_time_us(NULL) - start_time;
+
+			wait_us = target_us > elapsed_us
+				? target_us - elapsed_us : 0;
+		}
+
+		if (wait_us > 0) {
+			os_event_wait_time_low(
+				ibuf->merge_event, (ulint) wait_us,
+				sig_count);
+
+			sig_count = os_event_reset(ibuf->merge_event);
+		}
+	}
+
+	mutex_enter(&ibuf_merge_mutex);
+	ut_ad(ibuf->n_merge_threads_active > 0);
+	ibuf->n_merge_threads_active--;
+	mutex_exit(&ibuf_merge_mutex);
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*********************************************************************//**
+Creates the change buffer merge threads, if
+innodb_change_buffer_merge_threads is set. Then the master thread does
+not merge the change buffer in the background. */
+
+void
+ibuf_merge_threads_create(void)
+/*===========================*/
+{
+	ut_ad(!srv_read_only_mode);
+
+	mutex_enter(&ibuf_merge_mutex);
+	ibuf->n_merge_threads_active = srv_ibuf_merge_threads;
+	mutex_exit(&ibuf_merge_mutex);
+
+	for (ulint i = 0; i < srv_ibuf_merge_threads; ++i) {
+		os_thread_create(ibuf_merge_thread, NULL, NULL);
+	}
+}
+
 /*********************************************************************//**
 Contract insert buffer trees after insert if they are too big. */
 UNIV_INLINE
@@ -3760,6 +4217,10 @@ func_exit:
 
 	mem_heap_free(heap);
 
+	if (err == DB_SUCCESS) {
+		ibuf_backlog_add(space, 1);
+	}
+
 	if (err == DB_SUCCESS
 	    && BTR_LATCH_MODE_WITHOUT_INTENTION(mode) == BTR_MODIFY_TREE) {
 		ibuf_contract_after_insert(entry_size);
@@ -4927,6 +5388,16 @@ reset_bit:
 	mutex_exit(&ibuf_mutex);
 #endif /* HAVE_ATOMIC_BUILTINS */
 
+	ulint	n_ops = 0;
+
+	for (ulint i = 0; i < IBUF_OP_COUNT; i++) {
+		n_ops += mops[i] + dops[i];
+	}
+
+	if (n_ops > 0) {
+		ibuf_backlog_sub(space, n_ops);
+	}
+
 	if (update_ibuf_bitmap && !tablespace_being_deleted) {
 
 		fil_decr_pending_ops(space);
@@ -5027,6 +5498,8 @@ leave_loop:
 	mutex_exit(&ibuf_mutex);
 #endif /* HAVE_ATOMIC_BUILTINS */
 
+	ibuf_backlog_drop(space);
+
 	mem_heap_free(heap);
 }
 
@@ -5100,6 +5573,63 @@ ibuf_print(
 #endif /* UNIV_IBUF_COUNT_DEBUG */
 
 	mutex_exit(&ibuf_mutex);
+
+	mutex_enter(&ibuf_merge_mutex);
+
+	if (srv_ibuf_merge_threads > 0) {
+		fprintf(file,
+			"merge threads %lu, %lu pages read by them\n",
+			(ulong) ibuf->n_merge_threads_active,
+			(ulong) ibuf->n_merge_thread_pages);
+	}
+
+	/* Take a snapshot of the counts; they may change while it is
+	being taken. */
+	typedef std::pair<ulint, ulint>	count_space_t;
+
+	std::vector<count_space_t>	backlog;
+
+	for (ulint i = 0; i < IBUF_BACKLOG_SLOTS; i++) {
+		ulint	space = ibuf_backlog[i].space;
+		ulint	n_ops = ibuf_backlog[i].n_ops;
+
+		if (space != IBUF_BACKLOG_FREE
+		    && space != IBUF_BACKLOG_DROPPED
+		    && n_ops > 0) {
+			backlog.push_back(count_space_t(n_ops, space));
+		}
+	}
+
+	ulint	n_lost = ibuf_backlog_n_lost;
+
+	mutex_exit(&ibuf_merge_mutex);
+
+	if (n_lost > 0) {
+		fprintf(file,
+			"%lu operations not counted per space,"
+			" too many spaces\n",
+			(ulong) n_lost);
+	}
+
+	if (!backlog.empty()) {
+		ulint	n = ut_min(
+			static_cast<ulint>(backlog.size()),
+			IBUF_PRINT_BACKLOG_SPACES);
+
+		std::partial_sort(
+			backlog.begin(), backlog.begin() + n, backlog.end(),
+			std::greater<count_space_t>());
+
+		fprintf(file,
+			"operations to merge in %lu spaces, largest:\n",
+			(ulong) backlog.size());
+
+		for (ulint i = 0; i < n; ++i) {
+			fprintf(file, " space %lu: %lu\n",
+				(ulong) backlog[i].second,
+				(ulong) backlog[i].first);
+		}
+	}
 }
 
 /******************************************************************//**
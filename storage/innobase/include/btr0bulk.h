@@ -0,0 +1,272 @@
+/*****************************************************************************
+
+Copyright (c) 2013, Oracle and/or its affiliates. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA
+
+*****************************************************************************/
+
+/********************************************************************//**
+@file include/btr0bulk.h
+The B-tree bulk load
+
+Created 10/18/2013
+*************************************************************************/
+
+#ifndef btr0bulk_h
+#define btr0bulk_h
+
+#include "univ.i"
+
+#include "dict0dict.h"
+#include "page0cur.h"
+#include "mtr0mtr.h"
+
+#include <vector>
+
+/** A B-tree page that is being filled by the bulk load. Records are
+appended to the end of the page in ascending order; the page directory
+and the page header are only built when the page is full, by finish().
+The page is modified in a mini-transaction that does not write redo
+log: the caller must flush the tablespace before the index is used. */
+class PageBulk {
+public:
+	/**
+	@param index		the index
+	@param trx_id		transaction id, for PAGE_MAX_TRX_ID
+	@param page_no		page number of an existing empty page
+				(the root), or FIL_NULL to allocate one
+	@param level		B-tree level of the page, 0 = leaf */
+	PageBulk(
+		dict_index_t*	index,
+		trx_id_t	trx_id,
+		ulint		page_no,
+		ulint		level);
+
+	~PageBulk();
+
+	/**
+	Allocate and initialize the page, and latch it.
+	@return DB_SUCCESS or DB_OUT_OF_FILE_SPACE */
+	dberr_t init();
+
+	/**
+	Append a record to the page.
+	@param rec		record, greater than the last one
+	@param offsets		rec_get_offsets(rec) */
+	void insert(const rec_t* rec, ulint* offsets);
+
+	/**
+	Build the page directory and set the page header fields,
+	after which the page is a valid index page. */
+	void finish();
+
+	/**
+	Commit the mini-transaction and release the page.
+	@param success		whether the page was finished */
+	void commit(bool success);
+
+	/**
+	Copy the records from rec to the end of another page into this
+	empty page.
+	@param rec		first user record to copy */
+	void copyIn(const rec_t* rec);
+
+	/**
+	Build the node pointer to this page in the father page. It is
+	allocated from the heap of this page.
+	@return node pointer */
+	dtuple_t* getNodePtr();
+
+	/**
+	Check whether a record fits in the page, leaving the space that
+	is reserved by the fill factor free.
+	@param rec_size		size of the record
+	@return true if the record can be appended */
+	bool isSpaceAvailable(ulint rec_size) const;
+
+	/**
+	Set the next page in the level.
+	@param next_page_no	page number of the next page */
+	void setNext(ulint next_page_no);
+
+	/**
+	Set the previous page in the level.
+	@param prev_page_no	page number of the previous page */
+	void setPrev(ulint prev_page_no);
+
+	/**
+	Release the page latch, keeping the block buffer-fixed, so that
+	the caller can wait for a log checkpoint. */
+	void release();
+
+	/**
+	Latch the page again after release(). */
+	void latch();
+
+	/**
+	@return the page number */
+	ulint getPageNo() const
+	{
+		return(m_page_no);
+	}
+
+	/**
+	@return the B-tree level of the page */
+	ulint getLevel() const
+	{
+		return(m_level);
+	}
+
+	/**
+	@return the number of user records on the page */
+	ulint getRecNo() const
+	{
+		return(m_rec_no);
+	}
+
+	/**
+	@return whether this is the leftmost page of its level */
+	bool isLeftMost() const
+	{
+		return(m_prev_page_no == FIL_NULL);
+	}
+
+	/**
+	@return the memory heap for the records of this page */
+	mem_heap_t* getHeap()
+	{
+		return(m_heap);
+	}
+
+private:
+	/** Memory heap for the records and the node pointer */
+	mem_heap_t*	m_heap;
+
+	/** The index of the page */
+	dict_index_t*	m_index;
+
+	/** Mini-transaction that latches the page */
+	mtr_t		m_mtr;
+
+	/** Transaction id, for PAGE_MAX_TRX_ID */
+	trx_id_t	m_trx_id;
+
+	/** The page block */
+	buf_block_t*	m_block;
+
+	/** The page frame */
+	page_t*		m_page;
+
+	/** The last record appended, or the infimum */
+	rec_t*		m_cur_rec;
+
+	/** The page number */
+	ulint		m_page_no;
+
+	/** Page number of the previous page in the level */
+	ulint		m_prev_page_no;
+
+	/** B-tree level of the page */
+	ulint		m_level;
+
+	/** Whether the page is in ROW_FORMAT=COMPACT or DYNAMIC */
+	bool		m_is_comp;
+
+	/** Where the next record goes */
+	byte*		m_heap_top;
+
+	/** Number of user records on the page */
+	ulint		m_rec_no;
+
+	/** Free space left on the page, including the directory */
+	ulint		m_free_space;
+
+	/** Space that is left free by the fill factor */
+	ulint		m_reserved_space;
+
+	/** Modify clock of the block when it was released */
+	ib_uint64_t	m_modify_clock;
+};
+
+/** Loads a stream of index entries that are sorted in ascending order
+into an empty B-tree. The leaf pages are filled from left to right, and
+a node pointer to each finished page is appended to the level above,
+which is built in the same way, so that no record is inserted by a
+search from the root and no page is split. */
+class BtrBulk {
+public:
+	/**
+	@param index		the empty index
+	@param trx		transaction, to check for interruption */
+	BtrBulk(dict_index_t* index, const trx_t* trx);
+
+	~BtrBulk();
+
+	/**
+	Append an index entry to the leaf level. The caller must check
+	with page_zip_rec_needs_ext() that the record fits on a page.
+	@param tuple		index entry, greater than the last one
+	@return DB_SUCCESS or error code */
+	dberr_t insert(dtuple_t* tuple)
+	{
+		return(insert(tuple, 0));
+	}
+
+	/**
+	Finish the pages of all levels and move the top page to the
+	root page of the index.
+	@param err		error from the inserts, or DB_SUCCESS
+	@return DB_SUCCESS or error code */
+	dberr_t finish(dberr_t err);
+
+private:
+	/**
+	Append a record to a level, starting a new page when the
+	current one is full.
+	@param tuple		record to append
+	@param level		B-tree level, 0 = leaf
+	@return DB_SUCCESS or error code */
+	dberr_t insert(dtuple_t* tuple, ulint level);
+
+	/**
+	Finish a page, link it to the next page and append its node
+	pointer to the level above, then commit it.
+	@param page_bulk	the page
+	@param next_page_bulk	next page in the level, or NULL
+	@param insert_father	whether to append the node pointer
+	@return DB_SUCCESS or error code */
+	dberr_t pageCommit(
+		PageBulk*	page_bulk,
+		PageBulk*	next_page_bulk,
+		bool		insert_father);
+
+	/**
+	Release all the pages being built, wait for a log checkpoint
+	if one is needed, and latch the pages again. */
+	void logFreeCheck();
+
+	/** The index */
+	dict_index_t*		m_index;
+
+	/** The transaction */
+	const trx_t*		m_trx;
+
+	/** Level of the top page */
+	ulint			m_root_level;
+
+	/** The page being built in each level, from the leaf up */
+	std::vector<PageBulk*>	m_page_bulks;
+};
+
+#endif /* btr0bulk_h */
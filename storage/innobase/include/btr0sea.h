@@ -35,7 +35,9 @@ Created 2/17/1996 Heikki Tuuri
 #include "ha0ha.h"
 
 /*****************************************************************//**
-Creates and initializes the adaptive search system at a database start. */
+Creates and initializes the adaptive search system at a database start.
+The hash table size is divided evenly among the btr_ahi_parts
+partitions. */
 
 void
 btr_search_sys_create(
@@ -61,6 +63,77 @@ void
 btr_search_enable(void);
 /*====================*/
 
+/********************************************************************//**
+Returns the adaptive hash index partition that an index belongs to.
+@return partition number, less than btr_ahi_parts */
+UNIV_INLINE
+ulint
+btr_search_get_part(
+/*================*/
+	index_id_t	index_id);	/*!< in: index id */
+/********************************************************************//**
+Returns the latch of the adaptive hash index partition of an index.
+@return latch protecting the partition */
+UNIV_INLINE
+rw_lock_t*
+btr_get_search_latch(
+/*=================*/
+	const dict_index_t*	index)	/*!< in: index */
+	__attribute__((nonnull));
+/********************************************************************//**
+Returns the hash table of the adaptive hash index partition of an index.
+@return hash table of the partition */
+UNIV_INLINE
+hash_table_t*
+btr_get_search_table(
+/*=================*/
+	const dict_index_t*	index)	/*!< in: index */
+	__attribute__((nonnull));
+/********************************************************************//**
+X-latches the latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_x_lock_all(void);
+/*========================*/
+/********************************************************************//**
+X-unlatches the latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_x_unlock_all(void);
+/*==========================*/
+/********************************************************************//**
+S-latches the latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_s_lock_all(void);
+/*========================*/
+/********************************************************************//**
+S-unlatches the latches of all the adaptive hash index partitions. */
+UNIV_INLINE
+void
+btr_search_s_unlock_all(void);
+/*==========================*/
+#ifdef UNIV_SYNC_DEBUG
+/********************************************************************//**
+Checks if the thread owns the latch of any adaptive hash index partition
+in the given mode.
+@return true if some partition latch is owned */
+UNIV_INLINE
+bool
+btr_search_own_any(
+/*===============*/
+	ulint	mode);	/*!< in: RW_LOCK_S or RW_LOCK_X */
+/********************************************************************//**
+Checks if the thread owns the latches of all the adaptive hash index
+partitions in the given mode.
+@return true if all the partition latches are owned */
+UNIV_INLINE
+bool
+btr_search_own_all(
+/*===============*/
+	ulint	mode);	/*!< in: RW_LOCK_S or RW_LOCK_X */
+#endif /* UNIV_SYNC_DEBUG */
+
 /********************************************************************//**
 Returns search info for an index.
 @return search info; search mutex reserved */
@@ -80,13 +153,14 @@ btr_search_info_create(
 	mem_heap_t*	heap);	/*!< in: heap where created */
 /*****************************************************************//**
 Returns the value of ref_count. The value is protected by
-btr_search_latch.
+the latch of the adaptive hash index partition of the index.
 @return ref_count value. */
 
 ulint
 btr_search_info_get_ref_count(
 /*==========================*/
-	btr_search_t*   info);	/*!< in: search info. */
+	btr_search_t*   info,	/*!< in: search info. */
+	dict_index_t*	index);	/*!< in: index */
 /*********************************************************************//**
 Updates the search info. */
 UNIV_INLINE
@@ -112,7 +186,8 @@ btr_search_guess_on_hash(
 	ulint		latch_mode,	/*!< in: BTR_SEARCH_LEAF, ... */
 	btr_cur_t*	cursor,		/*!< out: tree cursor */
 	ulint		has_search_latch,/*!< in: latch mode the caller
-					currently has on btr_search_latch:
+					currently has on the partition
+					latch btr_get_search_latch(index):
 					RW_S_LATCH, RW_X_LATCH, or 0 */
 	mtr_t*		mtr);		/*!< in: mtr */
 /********************************************************************//**
@@ -198,8 +273,9 @@ struct btr_search_t{
 	ulint	ref_count;	/*!< Number of blocks in this index tree
 				that have search index built
 				i.e. block->index points to this index.
-				Protected by btr_search_latch except
-				when during initialization in
+				Protected by the partition latch
+				btr_get_search_latch() of the index
+				except when during initialization in
 				btr_search_info_create(). */
 
 	/* @{ The following fields are not protected by any latch.
@@ -247,9 +323,11 @@ struct btr_search_t{
 
 /** The hash index system */
 struct btr_search_sys_t{
-	hash_table_t*	hash_index;	/*!< the adaptive hash index,
-					mapping dtuple_fold values
-					to rec_t pointers on index pages */
+	hash_table_t**	hash_tables;	/*!< the adaptive hash index
+					partitions, mapping dtuple_fold
+					values to rec_t pointers on index
+					pages; partition i is protected by
+					btr_search_latches[i] */
 };
 
 /** The adaptive hash index */
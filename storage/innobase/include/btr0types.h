@@ -41,11 +41,14 @@ struct btr_search_t;
 
 #ifndef UNIV_HOTBACKUP
 
-/** @brief The latch protecting the adaptive search system
+/** @brief The latches protecting the adaptive search system
 
-This latch protects the
-(1) hash index;
-(2) columns of a record to which we have a pointer in the hash index;
+The adaptive hash index is split into btr_ahi_parts partitions, each
+with its own hash table and latch. The partition of an index is selected
+by its index id. The latch of a partition protects the
+(1) hash index partition;
+(2) columns of a record to which we have a pointer in the hash index
+partition;
 
 but does NOT protect:
 
@@ -54,15 +57,18 @@ but does NOT protect:
 
 Bear in mind (3) and (4) when using the hash index.
 */
-extern rw_lock_t*	btr_search_latch_temp;
+extern rw_lock_t**	btr_search_latches;
+
+/** Number of adaptive hash index partitions */
+extern ulong		btr_ahi_parts;
 
 #endif /* UNIV_HOTBACKUP */
 
-/** The latch protecting the adaptive search system */
-#define btr_search_latch	(*btr_search_latch_temp)
+/** Maximum number of adaptive hash index partitions */
+#define BTR_AHI_PARTS_MAX	16
 
 /** Flag: has the search system been enabled?
-Protected by btr_search_latch. */
+Protected by all the btr_search_latches. */
 extern char	btr_search_enabled;
 
 #ifdef UNIV_BLOB_DEBUG
@@ -81,28 +81,32 @@ buf_dblwr_page_inside(
 /*==================*/
 	ulint	page_no);	/*!< in: page number */
 /********************************************************************//**
-Posts a buffer page for writing. If the doublewrite memory buffer is
-full, calls buf_dblwr_flush_buffered_writes and waits for for free
-space to appear. */
+Posts a buffer page for writing. The page goes to the shard of its buffer
+pool instance and flush type. If the doublewrite memory buffer of the
+shard is full, flushes it and waits for free space to appear. */
 
 void
 buf_dblwr_add_to_batch(
 /*====================*/
 	buf_page_t*	bpage);	/*!< in: buffer block to write */
 /********************************************************************//**
-Flushes possible buffered writes from the doublewrite memory buffer to disk,
-and also wakes up the aio thread if simulated aio is used. It is very
-important to call this function after a batch of writes has been posted,
-and also when we may have to wait for a page latch! Otherwise a deadlock
-of threads can occur. */
+Flushes possible buffered writes from the doublewrite memory buffer of
+one shard to disk, and also wakes up the aio thread if simulated aio is
+used. It is very important to call this function after a batch of writes
+has been posted, and also when we may have to wait for a page latch!
+Otherwise a deadlock of threads can occur. */
 
 void
-buf_dblwr_flush_buffered_writes(void);
-/*=================================*/
+buf_dblwr_flush_buffered_writes(
+/*============================*/
+	const buf_pool_t*	buf_pool,	/*!< in: buffer pool instance */
+	buf_flush_t		flush_type);	/*!< in: BUF_FLUSH_LRU or
+						BUF_FLUSH_LIST */
 /********************************************************************//**
 Writes a page to the doublewrite buffer on disk, sync it, then write
 the page to the datafile and sync the datafile. This function is used
-for single page flushes. If all the buffers allocated for single page
+for single page flushes, which have a shard of their own in each buffer
+pool instance. If all the buffers allocated for single page
 flushes in the doublewrite buffer are in use we wait here for one to
 become free. We are guaranteed that a slot will become free because any
 thread that is using a slot must also release the slot before leaving
@@ -114,13 +118,16 @@ buf_dblwr_write_single_page(
 	buf_page_t*	bpage,	/*!< in: buffer block to write */
 	bool		sync);	/*!< in: true if sync IO requested */
 
-/** Doublewrite control struct */
-struct buf_dblwr_t{
+/** Doublewrite shard. The pages that one buffer pool instance writes
+with one flush type are written to a file of their own, so that the
+shards of different instances and flush types can be written and synced
+independently of each other. */
+struct buf_dblwr_shard_t{
 	ib_mutex_t	mutex;	/*!< mutex protecting the first_free
 				field and write_buf */
-	ulint		block1;	/*!< the page number of the first
-				doublewrite block (64 pages) */
-	ulint		block2;	/*!< page number of the second block */
+	char*		name;	/*!< path of the doublewrite file */
+	os_file_t	file;	/*!< handle of the doublewrite file */
+	ulint		n_slots;/*!< number of pages in the file */
 	ulint		first_free;/*!< first free position in write_buf
 				measured in units of UNIV_PAGE_SIZE */
 	ulint		b_reserved;/*!< number of slots currently reserved
@@ -148,6 +155,21 @@ struct buf_dblwr_t{
 				cached to write_buf */
 };
 
+/** Doublewrite control struct */
+struct buf_dblwr_t{
+	ulint		block1;	/*!< the page number of the first
+				doublewrite block (64 pages) in the
+				system tablespace. The two blocks are
+				no longer written to, but they are
+				still scanned in crash recovery. */
+	ulint		block2;	/*!< page number of the second block */
+	ulint		n_shards;/*!< number of shards: one for each
+				buffer pool instance and flush type */
+	buf_dblwr_shard_t*	shards;/*!< the shards, indexed by
+				buf_pool_index * BUF_FLUSH_N_TYPES
+				+ flush type */
+};
+
 
 #endif /* UNIV_HOTBACKUP */
 
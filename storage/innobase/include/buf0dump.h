@@ -28,6 +28,10 @@ Created April 08, 2011 Vasil Dimov
 
 #include "univ.i"
 
+/** The maximum number of threads that load the pages of one buffer pool
+instance in a buffer pool load */
+#define BUF_LOAD_MAX_THREADS	16
+
 /*****************************************************************//**
 Wakes up the buffer pool dump/load thread and instructs it to start
 a dump. This function is called by MySQL code via buffer_pool_dump_now()
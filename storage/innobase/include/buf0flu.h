@@ -39,6 +39,10 @@ extern ibool buf_page_cleaner_is_active;
 /** Event to synchronise with the flushing. */
 extern os_event_t	buf_flush_event;
 
+/** Maximum number of page cleaner threads. Each page cleaner has its own
+pair of monitor counters, so this is a fixed bound. */
+#define BUF_FLUSH_PAGE_CLEANERS_MAX	16
+
 /********************************************************************//**
 Remove a block from the flush list of modified blocks. */
 
@@ -177,12 +181,38 @@ buf_flush_ready_for_replace(
 	buf_page_t*	bpage);	/*!< in: buffer control block, must be
 				buf_page_in_file(bpage) and in the LRU list */
 /******************************************************************//**
-page_cleaner thread tasked with flushing dirty pages from the buffer
-pools. As of now we'll have only one instance of this thread.
+Initializes the page cleaner coordination. Must be called before the
+page cleaner threads are created. */
+
+void
+buf_flush_page_cleaner_init(void);
+/*=============================*/
+/******************************************************************//**
+Frees the page cleaner coordination. Must be called after all the page
+cleaner threads have exited. */
+
+void
+buf_flush_page_cleaner_free(void);
+/*=============================*/
+/******************************************************************//**
+page_cleaner coordinator thread tasked with flushing dirty pages from
+the buffer pools. It decides how much to flush and shares the work with
+the page_cleaner worker threads, each of which flushes its own subset
+of the buffer pool instances.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(buf_flush_page_cleaner_coordinator)(
+/*===============================================*/
+	void*	arg);		/*!< in: a dummy parameter required by
+				os_thread_create */
+/******************************************************************//**
+page_cleaner worker thread. It flushes the buffer pool instances of its
+slot whenever the coordinator requests a flushing round.
 @return a dummy parameter */
 extern "C"
 os_thread_ret_t
-DECLARE_THREAD(buf_flush_page_cleaner_thread)(
+DECLARE_THREAD(buf_flush_page_cleaner_worker)(
 /*==========================================*/
 	void*	arg);		/*!< in: a dummy parameter required by
 				os_thread_create */
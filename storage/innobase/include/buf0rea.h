@@ -55,6 +55,25 @@ buf_read_page_async(
 	ulint	space,	/*!< in: space id */
 	ulint	offset);/*!< in: page number */
 /********************************************************************//**
+Reads a range of contiguous pages of a tablespace to the buffer buf_pool
+with one synchronous read request, and puts those pages of the range that
+are not in the buffer pool yet there. Used by the buffer pool load, which
+reads the pages of a dump in the order of their positions in the files.
+The system tablespace, which contains the insert buffer, must be read
+with buf_read_page_async() instead.
+@return number of pages that were read in */
+
+ulint
+buf_read_page_range(
+/*================*/
+	ulint	space,	/*!< in: space id */
+	ulint	offset,	/*!< in: number of the first page */
+	ulint	n_pages,/*!< in: number of pages, at most
+			BUF_READ_RANGE_MAX_PAGES */
+	byte*	buf);	/*!< out: buffer of BUF_READ_RANGE_MAX_PAGES
+			* UNIV_PAGE_SIZE bytes, aligned to
+			UNIV_PAGE_SIZE */
+/********************************************************************//**
 Applies a random read-ahead in buf_pool if there are at least a threshold
 value of accessed pages from the random read-ahead area. Does not read any
 page, not even the one at the position (space, offset), if the read-ahead
@@ -164,6 +183,9 @@ invoked */
 #define	BUF_READ_AHEAD_AREA(b)					\
 	ut_min(64, ut_2_power_up((b)->curr_size / 32))
 
+/** The maximum number of pages that buf_read_page_range() reads */
+#define BUF_READ_RANGE_MAX_PAGES	64
+
 /** @name Modes used in read-ahead @{ */
 /** read only pages belonging to the insert buffer tree */
 #define BUF_READ_IBUF_PAGES_ONLY	131
@@ -955,6 +955,17 @@ dict_table_zip_size(
 /*================*/
 	const dict_table_t*	table)	/*!< in: table */
 	__attribute__((nonnull, warn_unused_result));
+/********************************************************************//**
+Get the algorithm that compresses the pages of a table when they are
+written to its tablespace file, see DICT_TF2_PAGE_COMPRESSION.
+@return page_zip_algorithm_t, or ULINT_UNDEFINED if the pages are
+written as they are */
+UNIV_INLINE
+ulint
+dict_table_page_compression(
+/*========================*/
+	const dict_table_t*	table)	/*!< in: table */
+	__attribute__((nonnull, warn_unused_result));
 #ifndef UNIV_HOTBACKUP
 /*********************************************************************//**
 Obtain exclusive locks on all index trees of the table. This is to prevent
@@ -190,7 +190,7 @@ ROW_FORMAT=REDUNDANT.  InnoDB engines do not check these flags
 for unknown bits in order to protect backward incompatibility. */
 /* @{ */
 /** Total number of bits in table->flags2. */
-#define DICT_TF2_BITS			6
+#define DICT_TF2_BITS			9
 #define DICT_TF2_BIT_MASK		~(~0 << DICT_TF2_BITS)
 
 /** TEMPORARY; TRUE for tables from CREATE TEMPORARY TABLE. */
@@ -208,6 +208,27 @@ use its own tablespace instead of the system tablespace. */
 
 /** Set when we discard/detach the tablespace */
 #define DICT_TF2_DISCARDED		32
+
+/** Width of the ZIP_ALGORITHM field, the page_zip_algorithm_t that
+compresses the pages of a ROW_FORMAT=COMPRESSED table or of a
+DICT_TF2_PAGE_COMPRESSION table. It is 0 (zlib) for tables that were
+created before the field existed. */
+#define DICT_TF2_WIDTH_ZIP_ALGORITHM	2
+/** Zero relative shift position of the ZIP_ALGORITHM field */
+#define DICT_TF2_POS_ZIP_ALGORITHM	6
+/** Bit mask of the ZIP_ALGORITHM field */
+#define DICT_TF2_MASK_ZIP_ALGORITHM			\
+		((~(~0 << DICT_TF2_WIDTH_ZIP_ALGORITHM))	\
+		<< DICT_TF2_POS_ZIP_ALGORITHM)
+/** Return the value of the ZIP_ALGORITHM field */
+#define DICT_TF2_GET_ZIP_ALGORITHM(flags2)		\
+		((flags2 & DICT_TF2_MASK_ZIP_ALGORITHM)	\
+		>> DICT_TF2_POS_ZIP_ALGORITHM)
+
+/** The table is not ROW_FORMAT=COMPRESSED, but its pages are compressed
+with the ZIP_ALGORITHM when they are written to its tablespace file; see
+fil_space_set_compression() */
+#define DICT_TF2_PAGE_COMPRESSION	256
 /* @} */
 
 #define DICT_TF2_FLAG_SET(table, flag)				\
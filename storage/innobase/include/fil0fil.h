@@ -159,6 +159,28 @@ extern fil_addr_t	fil_addr_null;
 #define FIL_PAGE_TYPE_ZBLOB2	12	/*!< Subsequent compressed BLOB page */
 #define FIL_PAGE_TYPE_LAST	FIL_PAGE_TYPE_ZBLOB2
 					/*!< Last page type */
+#define FIL_PAGE_COMPRESSED	14	/*!< Page that fil_page_compress()
+					compressed for writing; it only
+					exists in data files, never in the
+					buffer pool */
+/* @} */
+
+/** Header of a FIL_PAGE_COMPRESSED page. The FIL header of the page is
+that of the original page, apart from FIL_PAGE_TYPE; the rest of the
+original page from FIL_PAGE_DATA on, including the trailer, is compressed
+into FIL_PAGE_COMPRESS_DATA. The page is padded with zeros to a multiple
+of the file system block size, and the file system blocks after that are
+punched out of the file. @{ */
+#define FIL_PAGE_COMPRESS_ORIGINAL_TYPE FIL_PAGE_DATA
+					/*!< FIL_PAGE_TYPE of the original
+					page, 2 bytes */
+#define FIL_PAGE_COMPRESS_ALGORITHM (FIL_PAGE_DATA + 2)
+					/*!< page_zip_algorithm_t, 1 byte */
+#define FIL_PAGE_COMPRESS_SIZE	(FIL_PAGE_DATA + 3)
+					/*!< length of the compressed data,
+					2 bytes */
+#define FIL_PAGE_COMPRESS_DATA	(FIL_PAGE_DATA + 5)
+					/*!< start of the compressed data */
 /* @} */
 
 #ifndef UNIV_INNOCHECKSUM
@@ -283,6 +305,20 @@ fil_space_get_zip_size(
 /*===================*/
 	ulint	id);	/*!< in: space id */
 /*******************************************************************//**
+Sets the transparent page compression of a tablespace: the pages that
+are written to its data files are compressed and the unused end of each
+page is punched out of the file, if the file system supports it. Pages
+that were written compressed are restored on read whatever the setting.
+Does nothing if the tablespace is not in the memory cache. */
+
+void
+fil_space_set_compression(
+/*======================*/
+	ulint	id,		/*!< in: space id */
+	ulint	algorithm);	/*!< in: page_zip_algorithm_t, or
+				ULINT_UNDEFINED to write the pages
+				uncompressed */
+/*******************************************************************//**
 Checks if the pair space, page_no refers to an existing page in a tablespace
 file space. The tablespace must be cached in the memory cache.
 @return TRUE if the address is meaningful */
@@ -497,6 +533,16 @@ fil_reinit_space_header(
 /*====================*/
 	ulint		id,	/*!< in: space id */
 	ulint		size);	/*!< in: size in blocks */
+/**********************************************************************//**
+Truncates the data file of an undo tablespace and reinitializes its
+header. The caller must ensure that no page of the tablespace is in use.
+@return true if success */
+
+bool
+fil_truncate_undo_space(
+/*====================*/
+	ulint		id,	/*!< in: space id */
+	ulint		size);	/*!< in: new size in blocks */
 /*******************************************************************//**
 Closes a single-table tablespace. The tablespace must be cached in the
 memory cache. Free all pages used by the tablespace.
@@ -891,6 +937,31 @@ ulint
 fil_page_get_type(
 /*==============*/
 	const byte*	page);	/*!< in: file page */
+/*********************************************************************//**
+Compresses a page for writing it to a tablespace with transparent page
+compression, see FIL_PAGE_COMPRESS_DATA.
+@return number of bytes to write from dst, a multiple of block_size that
+is less than UNIV_PAGE_SIZE, or 0 if the page is to be written as is */
+
+ulint
+fil_page_compress(
+/*==============*/
+	const byte*	src,		/*!< in: page */
+	byte*		dst,		/*!< out: compressed page, of
+					UNIV_PAGE_SIZE bytes */
+	ulint		algorithm,	/*!< in: page_zip_algorithm_t */
+	ulint		block_size);	/*!< in: file system block size,
+					a power of 2 */
+/*********************************************************************//**
+Restores a page that fil_page_compress() compressed. Other pages are
+left alone.
+@return false if the page is FIL_PAGE_COMPRESSED but cannot be
+decompressed; it is left as it is then, and fails the checksum check */
+
+bool
+fil_page_decompress(
+/*================*/
+	byte*		page);		/*!< in/out: page that was read */
 
 /*******************************************************************//**
 Returns TRUE if a single-table tablespace is being deleted.
@@ -386,6 +386,14 @@ ibuf_contract_in_background(
 					If FALSE then the size of contract
 					batch is determined based on the
 					current size of the ibuf tree. */
+/*********************************************************************//**
+Creates the change buffer merge threads, if
+innodb_change_buffer_merge_threads is set. Then the master thread does
+not merge the change buffer in the background. */
+
+void
+ibuf_merge_threads_create(void);
+/*===========================*/
 #endif /* !UNIV_HOTBACKUP */
 /*********************************************************************//**
 Parses a redo log record of an ibuf bitmap page init.
@@ -36,6 +36,8 @@ Created 5/7/1996 Heikki Tuuri
 #include "lock0types.h"
 #include "hash0hash.h"
 #include "srv0srv.h"
+#include "sync0rw.h"
+#include "ut0counter.h"
 #include "ut0vec.h"
 
 // Forward declaration
@@ -766,6 +768,27 @@ DECLARE_THREAD(lock_wait_timeout_thread)(
 	void*	arg);	/*!< in: a dummy parameter required by
 			os_thread_create */
 
+/*********************************************************************//**
+A thread which searches the wait-for graph of the suspended transactions
+for deadlocks, when innodb_deadlock_detect_background is set.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(lock_deadlock_thread)(
+/*=================================*/
+	void*	arg);	/*!< in: a dummy parameter required by
+			os_thread_create */
+
+/*********************************************************************//**
+Takes a snapshot of the wait-for graph of all suspended transactions,
+searches it for cycles without holding lock_sys->latch, and resolves each
+cycle that still exists in the lock queues by rolling back the transaction
+in it that has the smallest undo log. */
+
+void
+lock_deadlock_check_background(void);
+/*================================*/
+
 /********************************************************************//**
 Releases a user OS thread waiting for a lock to be released, if the
 thread is already suspended. */
@@ -946,12 +969,39 @@ struct lock_op_t{
 
 typedef ib_mutex_t LockMutex;
 
+/** Number of partitions of the record lock hash table, each protected
+by its own mutex. */
+#define LOCK_REC_N_SHARDS	64
+
+/** A partition of the record lock hash table. The record locks on a page
+belong to the shard of the hash cell of the page. They can be accessed
+by holding lock_sys->latch in S mode and the shard mutex, or by holding
+lock_sys->latch in X mode. */
+struct lock_rec_shard_t{
+	LockMutex	mutex;			/*!< Mutex protecting the
+						record locks of the shard */
+	ulint		n_enters;		/*!< Number of times mutex
+						was acquired, protected by
+						mutex */
+	ulint		n_waits;		/*!< Number of times mutex
+						was busy when it was
+						requested, protected by
+						mutex */
+	byte		pad[CACHE_LINE_SIZE];	/*!< Keep the shards in
+						different cache lines */
+};
+
 /** The lock system struct */
 struct lock_sys_t{
-	LockMutex	mutex;			/*!< Mutex protecting the
-						locks */
+	rw_lock_t	latch;			/*!< Latch protecting the
+						locks. X mode protects all
+						the locks. S mode only
+						allows acquiring the
+						rec_shards mutexes */
 	hash_table_t*	rec_hash;		/*!< hash table of the record
 						locks */
+	lock_rec_shard_t rec_shards[LOCK_REC_N_SHARDS];
+						/*!< Partitions of rec_hash */
 	LockMutex	wait_mutex;		/*!< Mutex protecting the
 						next two fields */
 	srv_slot_t*	waiting_threads;	/*!< Array  of user threads
@@ -966,7 +1016,7 @@ struct lock_sys_t{
 						/*!< TRUE if rollback of all
 						recovered transactions is
 						complete. Protected by
-						lock_sys->mutex */
+						lock_sys->latch */
 
 	ulint		n_lock_max_wait_time;	/*!< Max wait time */
 
@@ -977,26 +1027,56 @@ struct lock_sys_t{
 
 	bool		timeout_thread_active;	/*!< True if the timeout thread
 						is running */
+
+	os_event_t	deadlock_event;		/*!< Set when a thread has been
+						suspended in a lock wait, to
+						wake up the background
+						deadlock detector thread */
+
+	bool		deadlock_thread_active;	/*!< True if the background
+						deadlock detector thread is
+						running */
 };
 
 /** The lock system */
 extern lock_sys_t*	lock_sys;
 
-/** Test if lock_sys->mutex can be acquired without waiting. */
+#ifdef UNIV_DEBUG
+/*********************************************************************//**
+Checks if the current thread holds lock_sys->latch in X mode.
+@return true if it does */
+
+bool
+lock_sys_x_own(void);
+/*================*/
+#endif /* UNIV_DEBUG */
+
+/** Test if lock_sys->latch can be X-latched without waiting.
+@return 0 if the latch was acquired */
 #define lock_mutex_enter_nowait() 		\
-	(lock_sys->mutex.trylock(__FILE__, __LINE__))
+	(!rw_lock_x_lock_nowait(&lock_sys->latch))
 
-/** Test if lock_sys->mutex is owned. */
-#define lock_mutex_own() (lock_sys->mutex.is_owned())
+/** Test if lock_sys->latch is X-latched by the current thread. */
+#define lock_mutex_own() lock_sys_x_own()
 
-/** Acquire the lock_sys->mutex. */
+/** Acquire lock_sys->latch in X mode, for accessing any lock. */
 #define lock_mutex_enter() do {			\
-	mutex_enter(&lock_sys->mutex);		\
+	rw_lock_x_lock(&lock_sys->latch);	\
 } while (0)
 
-/** Release the lock_sys->mutex. */
+/** Release the X-latch on lock_sys->latch. */
 #define lock_mutex_exit() do {			\
-	lock_sys->mutex.exit();			\
+	rw_lock_x_unlock(&lock_sys->latch);	\
+} while (0)
+
+/** Acquire lock_sys->latch in S mode, for latching record lock shards. */
+#define lock_sys_s_lock() do {			\
+	rw_lock_s_lock(&lock_sys->latch);	\
+} while (0)
+
+/** Release the S-latch on lock_sys->latch. */
+#define lock_sys_s_unlock() do {		\
+	rw_lock_s_unlock(&lock_sys->latch);	\
 } while (0)
 
 /** Test if lock_sys->wait_mutex is owned. */
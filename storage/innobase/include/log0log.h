@@ -87,23 +87,6 @@ log_calc_where_lsn_is(
 	ib_int64_t	log_file_size);		/*!< in: log file size
 						(including the header) */
 #ifndef UNIV_HOTBACKUP
-/************************************************************//**
-Writes to the log the string given. The log must be released with
-log_release.
-@return end lsn of the log record, zero if did not succeed */
-UNIV_INLINE
-lsn_t
-log_reserve_and_write_fast(
-/*=======================*/
-	const void*	str,	/*!< in: string */
-	ulint		len,	/*!< in: string length */
-	lsn_t*		start_lsn);/*!< out: start lsn of the log record */
-/***********************************************************************//**
-Releases the log mutex. */
-UNIV_INLINE
-void
-log_release(void);
-/*=============*/
 /***********************************************************************//**
 Checks if there is need for a log buffer flush or a new checkpoint, and does
 this if yes. Any database operation should call this when it has modified
@@ -114,30 +97,52 @@ void
 log_free_check(void);
 /*================*/
 /************************************************************//**
-Opens the log for log_write_low. The log must be closed with log_close and
-released with log_release.
-@return start lsn of the log record */
+Reserves an lsn range for the log records of a mini-transaction, waiting
+for free space in the log buffer if necessary. The range is claimed with
+an atomic update of log_sys->lsn, so several threads can reserve and fill
+their ranges at the same time; the records must then be copied with
+log_buffer_write() and the range published with log_buffer_close().
+@return start lsn of the reserved range */
 
 lsn_t
-log_reserve_and_open(
-/*=================*/
-	ulint	len);	/*!< in: length of data to be catenated */
+log_buffer_reserve(
+/*===============*/
+	ulint	len,		/*!< in: length of the log records */
+	bool	flush_order,	/*!< in: true if the caller dirtied a clean
+				page; the function then returns with
+				log_sys->log_flush_order_mutex held, so that
+				the page can be added to the flush list in
+				lsn order */
+	lsn_t*	end_lsn);	/*!< out: end lsn of the reserved range */
+/************************************************************//**
+Copies log records to the log buffer, into a range reserved with
+log_buffer_reserve(). Does not need the log mutex.
+@return lsn following the copied records */
+
+lsn_t
+log_buffer_write(
+/*=============*/
+	lsn_t		lsn,		/*!< in: lsn where to copy */
+	const void*	str,		/*!< in: log records */
+	ulint		str_len);	/*!< in: length of the records */
 /************************************************************//**
-Writes to the log the string given. It is assumed that the caller holds the
-log mutex. */
+Publishes a range of the log buffer filled by log_buffer_write(), so that
+log_write_up_to() can write it once all the ranges before it have been
+published too. */
 
 void
-log_write_low(
-/*==========*/
-	byte*	str,		/*!< in: string */
-	ulint	str_len);	/*!< in: string length */
+log_buffer_close(
+/*=============*/
+	lsn_t	start_lsn,	/*!< in: start lsn of the range */
+	lsn_t	end_lsn);	/*!< in: end lsn of the range */
 /************************************************************//**
-Closes the log.
-@return lsn */
+Advances log_sys->recent_written_lsn over the contiguous ranges that have
+been published by log_buffer_close(). The caller must own the log mutex.
+@return lsn up to which the log buffer is completely filled */
 
 lsn_t
-log_close(void);
-/*===========*/
+log_buffer_advance_written(void);
+/*============================*/
 /************************************************************//**
 Gets the current lsn.
 @return current lsn */
@@ -224,6 +229,22 @@ void
 log_buffer_sync_in_background(
 /*==========================*/
 	ibool	flush);	/*<! in: flush the logs to disk */
+/****************************************************************//**
+Starts the log writer and log flusher threads. From then on only these
+threads write and flush the log, and log_write_up_to() requests the write
+or flush from them and waits for it. */
+
+void
+log_start_writer_threads(void);
+/*==========================*/
+/****************************************************************//**
+Makes the log writer and log flusher threads exit and waits for them.
+From then on log_write_up_to() writes and flushes the log itself. Does
+nothing if the threads were not started. */
+
+void
+log_stop_writer_threads(void);
+/*=========================*/
 /******************************************************//**
 Makes a checkpoint. Note that this function does not flush dirty
 blocks from the buffer pool: it only checks what is lsn of the oldest
@@ -505,6 +526,14 @@ log_block_init(
 	byte*	log_block,	/*!< in: pointer to the log buffer */
 	lsn_t	lsn);		/*!< in: lsn within the log block */
 /************************************************************//**
+Gets the block of the log buffer that holds an lsn.
+@return log block in log_sys->buf */
+UNIV_INLINE
+byte*
+log_buffer_get_block(
+/*=================*/
+	lsn_t	lsn);	/*!< in: lsn within the log block */
+/************************************************************//**
 Initializes a log block in the log buffer in the old, < 3.23.52 format, where
 there was no checksum yet. */
 UNIV_INLINE
@@ -574,6 +603,21 @@ extern log_t*	log_sys;
 #define LOG_BUFFER_SIZE		(srv_log_buffer_size * UNIV_PAGE_SIZE)
 #define LOG_ARCHIVE_BUF_SIZE	(srv_log_buffer_size * UNIV_PAGE_SIZE / 4)
 
+/* Number of slots in log_t::recent_written; a mini-transaction may start
+copying its log records only this many bytes ahead of the first range
+that has not yet been completely copied to the log buffer */
+#define LOG_RECENT_WRITTEN_SIZE	(1024 * 1024)
+
+/* Number of events for the threads that wait for the log writer or the log
+flusher; a thread waiting for lsn waits for the event of the log block of
+lsn, so that one write or flush does not wake up all the waiting threads */
+#define LOG_WAIT_EVENTS		64
+
+/* A thread waiting for a log write or flush spins for at most
+srv_log_wait_spin_rounds before it waits for an event, but only if the
+average time of the write or write + flush is below this many microseconds */
+#define LOG_WAIT_SPIN_MAX_AVG_TIME	500
+
 /* Offsets of a log block header */
 #define	LOG_BLOCK_HDR_NO	0	/* block number which must be > 0 and
 					is allowed to wrap around at 2G; the
@@ -744,35 +788,35 @@ struct log_t{
 	byte		pad[64];	/*!< padding to prevent other memory
 					update hotspots from residing on the
 					same memory cache line */
-	lsn_t		lsn;		/*!< log sequence number */
-	ulint		buf_free;	/*!< first free offset within the log
-					buffer */
+	lsn_t		lsn;		/*!< log sequence number; this is the
+					end of the last range reserved in the
+					log buffer by log_buffer_reserve(),
+					and is advanced with an atomic
+					compare-and-swap */
+	byte		pad1[64];	/*!< padding to keep the other fields
+					off the cache line of lsn */
 #ifndef UNIV_HOTBACKUP
 	LogSysMutex	mutex;		/*!< mutex protecting the log */
 
 	FlushOrderMutex	log_flush_order_mutex;/*!< mutex to serialize access to
 					the flush list when we are putting
-					dirty blocks in the list. The idea
-					behind this mutex is to be able
-					to release log_sys->mutex during
-					mtr_commit and still ensure that
+					dirty blocks in the list. A
+					mini-transaction that dirtied a clean
+					page reserves its lsn range while
+					holding this mutex, which ensures that
 					insertions in the flush_list happen
-					in the LSN order. */
+					in the LSN order without taking
+					log_sys->mutex in mtr_commit. */
 #endif /* !UNIV_HOTBACKUP */
 	byte*		buf_ptr;	/* unaligned log buffer */
-	byte*		buf;		/*!< log buffer */
+	byte*		buf;		/*!< log buffer; this is a ring where
+					the block holding an lsn is at offset
+					lsn % buf_size, rounded down to
+					OS_FILE_LOG_BLOCK_SIZE */
 	ulint		buf_size;	/*!< log buffer size in bytes */
-	ulint		max_buf_free;	/*!< recommended maximum value of
-					buf_free, after which the buffer is
-					flushed */
- #ifdef UNIV_LOG_DEBUG
-	ulint		old_buf_free;	/*!< value of buf free when log was
-					last time opened; only in the debug
-					version */
-	ib_uint64_t	old_lsn;	/*!< value of lsn when log was
-					last time opened; only in the
-					debug version */
-#endif /* UNIV_LOG_DEBUG */
+	ulint		max_buf_free;	/*!< recommended maximum amount of
+					unwritten log in the buffer, after
+					which the buffer is flushed */
 	ibool		check_flush_or_checkpoint;
 					/*!< this is set to TRUE when there may
 					be need to flush the log buffer, or
@@ -788,13 +832,23 @@ struct log_t{
 #ifndef UNIV_HOTBACKUP
 	/** The fields involved in the log buffer flush @{ */
 
-	ulint		buf_next_to_write;/*!< first offset in the log buffer
-					where the byte content may not exist
-					written to file, e.g., the start
-					offset of a log record catenated
-					later; this is advanced when a flush
-					operation is completed to all the log
-					groups */
+	lsn_t*		recent_written;	/*!< LOG_RECENT_WRITTEN_SIZE slots;
+					log_buffer_close() stores the end lsn
+					of a completely copied range in the
+					slot start_lsn % LOG_RECENT_WRITTEN_SIZE,
+					and log_buffer_advance_written()
+					follows and clears these links */
+	lsn_t		recent_written_lsn;
+					/*!< the log buffer is completely filled
+					up to this lsn: all the ranges
+					reserved before it have been copied;
+					protected by the log mutex */
+	byte*		write_buf_ptr;	/*!< unaligned write buffer */
+	byte*		write_buf;	/*!< the blocks to be written to the log
+					files are copied here from the log
+					buffer, so that the write is not
+					disturbed by threads copying more log
+					records into the last block */
 	lsn_t		written_to_some_lsn;
 					/*!< first log sequence number not yet
 					written to any log group; for this to
@@ -819,11 +873,6 @@ struct log_t{
 					up-to-date and accurate. */
 	lsn_t		write_lsn;	/*!< end lsn for the current running
 					write */
-	ulint		write_end_offset;/*!< the data in buffer has
-					been written up to this offset
-					when the current write ends:
-					this field will then be copied
-					to buf_next_to_write */
 	lsn_t		current_flush_lsn;/*!< end lsn for the current running
 					write + flush operation */
 	lsn_t		flushed_to_disk_lsn;
@@ -854,6 +903,40 @@ struct log_t{
 					but NOTE that to set or reset this
 					event, the thread MUST own the log
 					mutex! */
+	bool		writer_threads;	/*!< true if the log writer and log
+					flusher threads are running; then only
+					they write and flush the log */
+	bool		writer_threads_exit;
+					/*!< set to make the log writer and log
+					flusher threads exit once they have no
+					more requests */
+	ulint		n_writer_threads;/*!< number of the log writer and log
+					flusher threads that have not exited;
+					protected by the log mutex */
+	lsn_t		write_requested_lsn;
+					/*!< the log writer writes the log at
+					least up to this lsn */
+	lsn_t		flush_requested_lsn;
+					/*!< the log flusher flushes the log at
+					least up to this lsn */
+	os_event_t	writer_event;	/*!< set to wake up the log writer */
+	os_event_t	flusher_event;	/*!< set to wake up the log flusher */
+	os_event_t	write_events[LOG_WAIT_EVENTS];
+					/*!< a thread waiting for
+					written_to_all_lsn to reach lsn waits
+					for the event number
+					lsn / OS_FILE_LOG_BLOCK_SIZE
+					% LOG_WAIT_EVENTS; the log writer sets
+					the events of the blocks it wrote */
+	os_event_t	flush_events[LOG_WAIT_EVENTS];
+					/*!< the same for flushed_to_disk_lsn
+					and the log flusher */
+	ulint		write_avg_time;	/*!< moving average of the duration
+					of a write by the log writer, in
+					microseconds */
+	ulint		flush_avg_time;	/*!< moving average of the duration
+					of a flush by the log flusher, in
+					microseconds */
 	ulint		n_log_ios;	/*!< number of log i/os initiated thus
 					far */
 	ulint		n_log_ios_old;	/*!< number of log i/o's at the
@@ -164,6 +164,16 @@ recv_scan_log_recs(
 					to this lsn */
 	lsn_t*		group_scanned_lsn);/*!< out: scanning succeeded up to
 					this lsn */
+/*******************************************************//**
+Calculates the new value for lsn when more data is added to the log.
+@return lsn following the data, log block headers and trailers included */
+
+lsn_t
+recv_calc_lsn_on_data_add(
+/*======================*/
+	lsn_t		lsn,	/*!< in: old lsn */
+	ib_uint64_t	len);	/*!< in: this many bytes of data is
+				added, log block headers not included */
 /******************************************************//**
 Resets the logs. The contents of log files will be lost! */
 
@@ -353,6 +363,16 @@ struct recv_sys_t{
 	hash_table_t*	addr_hash;/*!< hash table of file addresses of pages */
 	ulint		n_addrs;/*!< number of not processed hashed file
 				addresses in the hash table */
+#ifndef UNIV_HOTBACKUP
+	ulint		n_apply_threads;
+				/*!< number of recv_apply_thread applying
+				the current batch, or 0; when nonzero, the
+				i/o-handler threads leave the log record
+				application to them */
+	ulint		n_apply_threads_active;
+				/*!< number of recv_apply_thread that have
+				not yet exited; protected by mutex */
+#endif /* !UNIV_HOTBACKUP */
 };
 
 /** The recovery system */
@@ -399,6 +419,10 @@ times! */
 roll-forward */
 #define RECV_SCAN_SIZE		(4 * UNIV_PAGE_SIZE)
 
+/** Maximum number of threads applying the log records to pages in crash
+recovery (innodb_recovery_threads) */
+#define RECV_MAX_APPLY_THREADS	64
+
 /** This many frames must be left free in the buffer pool when we scan
 the log and store the scanned log records in the buffer pool: we will
 use these free frames to read in pages when we start applying the
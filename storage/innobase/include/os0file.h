@@ -69,6 +69,12 @@ extern ulint	os_n_pending_writes;
 
 #endif
 
+#if defined(LINUX_NATIVE_AIO) && defined(HAVE_IO_URING)
+/** Linux native aio can submit its requests through io_uring; whether it
+does is decided at startup by innodb_use_io_uring */
+#define LINUX_IO_URING
+#endif
+
 /* path name separator character */
 #ifdef _WIN32
 #  define OS_FILE_PATH_SEPARATOR	'\\'
@@ -313,9 +319,10 @@ The wrapper functions have the prefix of "innodb_". */
 	pfs_os_file_close_func(file, __FILE__, __LINE__)
 
 # define os_aio(type, mode, name, file, buf, offset,			\
-		n, message1, message2)					\
+		n, message1, message2, compress_buf)			\
 	pfs_os_aio_func(type, mode, name, file, buf, offset,		\
-			n, message1, message2, __FILE__, __LINE__)
+			n, message1, message2, compress_buf,		\
+			__FILE__, __LINE__)
 
 # define os_file_read(file, buf, offset, n)				\
 	pfs_os_file_read_func(file, buf, offset, n, __FILE__, __LINE__)
@@ -356,9 +363,10 @@ to original un-instrumented file I/O APIs */
 
 # define os_file_close(file)	os_file_close_func(file)
 
-# define os_aio(type, mode, name, file, buf, offset, n, message1, message2) \
+# define os_aio(type, mode, name, file, buf, offset, n, message1,	\
+		message2, compress_buf)					\
 	os_aio_func(type, mode, name, file, buf, offset, n,		\
-		    message1, message2)
+		    message1, message2, compress_buf)
 
 # define os_file_read(file, buf, offset, n)	\
 	os_file_read_func(file, buf, offset, n)
@@ -755,6 +763,11 @@ pfs_os_aio_func(
 				(can be used to identify a completed
 				aio operation); ignored if mode is
                                 OS_AIO_SYNC */
+	void*		compress_buf,/*!< in: memory holding the
+				compressed page that buf points into,
+				freed with ut_free() when the aio
+				operation completes, or NULL; must be
+				NULL if mode is OS_AIO_SYNC */
 	const char*	src_file,/*!< in: file name where func invoked */
 	ulint		src_line);/*!< in: line where the func invoked */
 /*******************************************************************//**
@@ -892,6 +905,28 @@ os_file_truncate(
 	os_file_t	file,		/*!< in: file to be truncated */
 	os_offset_t	size);		/*!< in: size preserved in bytes */
 /***********************************************************************//**
+Gets the block size of the file system that holds a file, the unit in
+which disk space is allocated to the file.
+@return block size in bytes, or 0 if it is not known */
+
+ulint
+os_file_get_block_size(
+/*===================*/
+	os_file_t	file);		/*!< in: handle to a file */
+/***********************************************************************//**
+Frees the disk space of a range of a file without changing the size of
+the file; the range reads back as zeros. Only the whole file system
+blocks in the range are freed.
+@return DB_SUCCESS, DB_UNSUPPORTED if the file system does not support
+sparse files, or DB_IO_ERROR */
+
+dberr_t
+os_file_punch_hole(
+/*===============*/
+	os_file_t	file,		/*!< in: handle to a file */
+	os_offset_t	offset,		/*!< in: start of the range */
+	os_offset_t	len);		/*!< in: length of the range */
+/***********************************************************************//**
 NOTE! Use the corresponding macro os_file_flush(), not directly this function!
 Flushes the write buffers of a given file to the disk.
 @return TRUE if success */
@@ -1093,6 +1128,27 @@ Frees the asynchronous io system. */
 void
 os_aio_free(void);
 /*=============*/
+/***********************************************************************
+Adds a memory area, normally a buffer pool chunk, to the buffers that
+io_uring will access without mapping them on every request. Does nothing
+unless io_uring is in use. The buffers take effect when
+os_aio_register_fixed_buffers() is called. */
+
+void
+os_aio_add_fixed_buffer(
+/*====================*/
+	void*	buf,	/*!< in: start of the memory area */
+	ulint	len);	/*!< in: length of the memory area in bytes */
+/***********************************************************************
+Registers the buffers added with os_aio_add_fixed_buffer() with every
+io_uring instance. Requests whose buffer lies inside a registered buffer
+are then submitted as fixed buffer reads and writes. If the registration
+fails, for example because of RLIMIT_MEMLOCK, a warning is printed and
+io_uring keeps on mapping the buffers on every request. */
+
+void
+os_aio_register_fixed_buffers(void);
+/*===============================*/
 
 /*******************************************************************//**
 NOTE! Use the corresponding macro os_aio(), not directly this function!
@@ -1127,10 +1183,15 @@ os_aio_func(
 				(can be used to identify a completed
 				aio operation); ignored if mode is
 				OS_AIO_SYNC */
-	void*		message2);/*!< in: message for the aio handler
+	void*		message2,/*!< in: message for the aio handler
 				(can be used to identify a completed
 				aio operation); ignored if mode is
 				OS_AIO_SYNC */
+	void*		compress_buf);/*!< in: memory holding the
+				compressed page that buf points into,
+				freed with ut_free() when the aio
+				operation completes, or NULL; must be
+				NULL if mode is OS_AIO_SYNC */
 /************************************************************************//**
 Wakes up all async i/o threads so that they know to exit themselves in
 shutdown. */
@@ -1146,7 +1207,9 @@ void
 os_aio_wait_until_no_pending_writes(void);
 /*=====================================*/
 /**********************************************************************//**
-Wakes up simulated aio i/o-handler threads if they have something to do. */
+Wakes up simulated aio i/o-handler threads if they have something to do.
+With Linux native aio, submits to the kernel in one system call per segment
+the requests that were posted with OS_AIO_SIMULATED_WAKE_LATER. */
 
 void
 os_aio_simulated_wake_handler_threads(void);
@@ -1190,7 +1253,10 @@ os_aio_windows_handle(
 				parameters are valid and can be used to
 				restart the operation, for example */
 	void**	message2,
-	ulint*	type);		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len);/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 #endif
 
 /**********************************************************************//**
@@ -1212,7 +1278,10 @@ os_aio_simulated_handle(
 				parameters are valid and can be used to
 				restart the operation, for example */
 	void**	message2,
-	ulint*	type);		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len);/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 /**********************************************************************//**
 Validates the consistency of the aio system.
 @return TRUE if ok */
@@ -1293,7 +1362,10 @@ os_aio_linux_handle(
 				aio operation failed, these output
 				parameters are valid and can be used to
 				restart the operation. */
-	ulint*	type);		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len);/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 #endif /* LINUX_NATIVE_AIO */
 
 #ifndef UNIV_NONINL
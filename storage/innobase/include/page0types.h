@@ -60,6 +60,16 @@ ssize, which is the number of shifts from 512. */
 # error "PAGE_ZIP_SSIZE_MAX >= (1 << PAGE_ZIP_SSIZE_BITS)"
 #endif
 
+/** Algorithms for compressing the records of a compressed page.
+The algorithm of a table is kept in DICT_TF2_MASK_ZIP_ALGORITHM;
+each compressed page identifies its own algorithm, see page0zip.ic. */
+enum page_zip_algorithm_t {
+	PAGE_ZIP_ALGORITHM_ZLIB = 0,	/*!< zlib deflate stream */
+	PAGE_ZIP_ALGORITHM_LZ4,		/*!< LZ4 block */
+	PAGE_ZIP_ALGORITHM_ZSTD,	/*!< Zstandard frame */
+	PAGE_ZIP_N_ALGORITHMS
+};
+
 /** The information used for compressing a page when applying
 TRUNCATE log record during recovery */
 struct redo_page_compress_t {
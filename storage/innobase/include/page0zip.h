@@ -60,6 +60,14 @@ extern uint	page_zip_level;
 /* Default compression level. */
 #define DEFAULT_COMPRESSION_LEVEL	6
 
+/** Number of low bits of the level argument of page_zip_compress()
+that hold the compression level. The bits above may hold a
+page_zip_algorithm_t that overrides the algorithm of the table; this
+is how MLOG_ZIP_PAGE_COMPRESS_NO_DATA records the algorithm. */
+#define PAGE_ZIP_LEVEL_BITS		4
+/** Mask of the compression level in the level of page_zip_compress() */
+#define PAGE_ZIP_LEVEL_MASK		((1 << PAGE_ZIP_LEVEL_BITS) - 1)
+
 /* Whether or not to log compressed page images to avoid possible
 compression algorithm changes in zlib. */
 extern my_bool	page_zip_log_pages;
@@ -127,6 +135,47 @@ page_zip_set_alloc(
 	void*		stream,		/*!< in/out: zlib stream */
 	mem_heap_t*	heap);		/*!< in: memory heap to use */
 
+/**********************************************************************//**
+Determine if a compression algorithm was compiled in.
+@return true if pages can be compressed and decompressed with it */
+
+bool
+page_zip_algorithm_is_available(
+/*============================*/
+	page_zip_algorithm_t	algorithm)	/*!< in: algorithm */
+	__attribute__((const));
+
+/**********************************************************************//**
+Compress a buffer with the block compressor of an algorithm. For zlib,
+this is not the stream format of the compressed pages; it is meant for
+comparing the algorithms on page images.
+@return compressed size, or 0 if it exceeds dst_len */
+
+ulint
+page_zip_compress_buf(
+/*==================*/
+	page_zip_algorithm_t	algorithm,	/*!< in: available algorithm */
+	ulint			level,		/*!< in: compression level */
+	const byte*		src,		/*!< in: data to compress */
+	ulint			src_len,	/*!< in: length of src */
+	byte*			dst,		/*!< out: compressed data */
+	ulint			dst_len)	/*!< in: size of dst */
+	__attribute__((nonnull));
+
+/**********************************************************************//**
+Decompress a buffer that was compressed by page_zip_compress_buf().
+@return decompressed size, or 0 on error */
+
+ulint
+page_zip_decompress_buf(
+/*====================*/
+	page_zip_algorithm_t	algorithm,	/*!< in: available algorithm */
+	const byte*		src,		/*!< in: compressed data */
+	ulint			src_len,	/*!< in: length of src */
+	byte*			dst,		/*!< out: decompressed data */
+	ulint			dst_len)	/*!< in: size of dst */
+	__attribute__((nonnull));
+
 /**********************************************************************//**
 Compress a page.
 @return TRUE on success, FALSE on failure; page_zip will be left
@@ -87,6 +87,12 @@ public:
 	for views created by RW transactions. */
 	static void set_view_creator_trx_id(ReadView* view, trx_id_t id);
 
+	/**
+	Forget the shared snapshot of the active RW transaction ids. Must
+	be called whenever trx_sys_t::rw_trx_ids is modified, with the
+	trx_sys_t::mutex still held. */
+	void snapshot_invalidate();
+
 private:
 
 	/**
@@ -106,6 +112,13 @@ private:
 	@return oldest view if found or NULL */
 	inline ReadView* get_oldest_view() const;
 
+	/**
+	Get the snapshot of trx_sys_t::rw_trx_ids, create it if the set
+	has changed since the last view was opened.
+	@return snapshot with a reference owned by the caller, or NULL if
+	there are no active RW transactions */
+	inline ReadView::ids_t* get_ids();
+
 private:
 	// Prevent copying
 	MVCC(const MVCC&);
@@ -120,6 +133,11 @@ private:
 	/** Active and closed views, the closed views will have the
 	creator trx id set to TRX_ID_MAX */
 	view_list_t		m_views;
+
+	/** Snapshot of trx_sys_t::rw_trx_ids that is handed out to new
+	views, NULL if it has not been created since the set last changed.
+	Protected by trx_sys_t::mutex. */
+	ReadView::ids_t*	m_ids;
 };
 
 #endif /* read0read_h */
@@ -37,111 +37,83 @@ class MVCC;
 read should not see the modifications to the database. */
 
 class ReadView {
-	/** This is similar to a std::vector but it is not a drop
-	in replacement. It is specific to ReadView. */
+	/** An immutable, sorted copy of trx_sys_t::rw_trx_ids. It is
+	shared by all the views that are opened while the set of active
+	RW transactions does not change, so that opening a view copies a
+	pointer instead of the whole array. It is reference counted and
+	freed when the last view using it lets go of it. */
 	class ids_t {
 		typedef trx_ids_t::value_type value_type;
 
 		/**
-		Constructor */
-		ids_t() : m_ptr(), m_size(), m_reserved() { }
+		Create a snapshot, the caller owns the only reference.
+		@param start		Source array, sorted
+		@param end		Pointer to end of array
+		@param value		Additional value to insert in order,
+					or 0 for none. Must not be in the
+					source array.
+		@return the new snapshot */
+		static ids_t* create(
+			const value_type*	start,
+			const value_type*	end,
+			value_type		value);
 
 		/**
-		Destructor */
-		~ids_t() { delete[] m_ptr; }
+		Add a reference. The caller must own trx_sys_t::mutex or
+		another reference to the snapshot. */
+		void acquire();
 
 		/**
-		Try and increase the size of the array. Old elements are
-		copied across. It is a no-op if n is < current size.
-
-		@param n 		Make space for n elements */
-		void reserve(ulint n);
-
-		/**
-		Resize the array, sets the current element count.
-		@param n		new size of the array, in elements */
-		void resize(ulint n)
-		{
-			ut_ad(n <= capacity());
-
-			m_size = n;
-		}
-
-		/**
-		Reset the size to 0 */
-		void clear() { resize(0); }
-
-		/**
-		@return the capacity of the array in elements */
-		ulint capacity() const { return(m_reserved); }
-
-		/**
-		Copy and overwrite the current array contents
-
-		@param start		Source array
-		@paran end		Pointer to end of array */
-		void assign(const value_type* start, const value_type* end);
-
-		/**
-		Insert the value in the correct slot, preserving the order.
-		Doesn't check for duplicates. */
-		void insert(value_type value);
+		Release a reference, free the snapshot if it was the last.
+		@param ids		Snapshot to release, can be NULL.
+					Set to NULL on return. */
+		static void release(ids_t*& ids);
 
 		/**
 		@return the value of the first element in the array */
 		value_type front() const
 		{
-			ut_ad(!empty());
-
-			return(m_ptr[0]);
-		}
-
-		/**
-		@return the value of the last element in the array */
-		value_type back() const
-		{
-			ut_ad(!empty());
-
-			return(m_ptr[m_size - 1]);
+			return(m_data[0]);
 		}
 
-		/**
-		Append a value to the array.
-		@param value		the value to append */
-		void push_back(value_type value);
-
-		/**
-		@return a pointer to the start of the array */
-		trx_id_t* data() { return(m_ptr); };
-
 		/**
 		@return a const pointer to the start of the array */
-		const trx_id_t* data() const { return(m_ptr); };
+		const value_type* data() const { return(m_data); };
 
 		/**
 		@return the number of elements in the array */
 		ulint size() const { return(m_size); }
 
 		/**
-		@return true if size() == 0 */
-		bool empty() const { return(size() == 0); }
+		@param value		value to look for
+		@return true if value is in the array */
+		bool contains(value_type value) const
+		{
+			return(std::binary_search(
+				m_data, m_data + m_size, value));
+		}
 
 	private:
+		// Only created by create() and freed by release()
+		ids_t();
+		~ids_t();
+
 		// Prevent copying
 		ids_t(const ids_t&);
 		ids_t& operator=(const ids_t&);
 
 	private:
-		/** Memory for the array */
-		value_type*	m_ptr;
+		/** Number of references to the snapshot */
+		ulint		m_n_refs;
 
-		/** Number of active elements in the array */
+		/** Number of elements in the array, never 0 */
 		ulint		m_size;
 
-		/** Size of m_ptr in elements */
-		ulint		m_reserved;
+		/** The array, allocated together with this object */
+		value_type	m_data[1];
 
 		friend class ReadView;
+		friend class MVCC;
 	};
 public:
 	ReadView();
@@ -164,14 +136,12 @@ public:
 
 			return(false);
 
-		} else if (m_ids.empty()) {
+		} else if (m_ids == NULL) {
 
 			return(true);
 		}
 
-		const ids_t::value_type*	p = m_ids.data();
-
-		return(!std::binary_search(p, p + m_ids.size(), id));
+		return(!m_ids->contains(id));
 	}
 
 	/**
@@ -183,11 +153,13 @@ public:
 	}
 
 	/**
-	Mark the view as closed */
+	Mark the view as closed and release its snapshot */
 	void close()
 	{
 		ut_ad(m_creator_trx_id != TRX_ID_MAX);
 		m_creator_trx_id = TRX_ID_MAX;
+
+		ids_t::release(m_ids);
 	}
 
 	/**
@@ -223,10 +195,12 @@ public:
 	}
 
 	/**
-	@return true if there are no transaction ids in the snapshot */
+	@return true if there are no transaction ids in the snapshot. For
+	a view of a RW transaction the snapshot can contain the creator's
+	own id. */
 	bool empty() const
 	{
-		return(m_ids.empty());
+		return(m_ids == NULL);
 	}
 
 #ifdef UNIV_DEBUG
@@ -244,15 +218,14 @@ public:
 	}
 #endif /* UNIV_DEBUG */
 private:
-	/**
-	Copy the transaction ids from the source vector */
-	inline void copy_trx_ids(const trx_ids_t& trx_ids);
-
 	/**
 	Opens a read view where exactly the transactions serialized before this
 	point in time are seen in the view.
-	@param id		Creator transaction id */
-	inline void prepare(trx_id_t id);
+	@param id		Creator transaction id
+	@param ids		Snapshot of the active RW transaction ids, or
+				NULL if there are none. The view takes over
+				the caller's reference. */
+	inline void prepare(trx_id_t id, ids_t* ids);
 
 	/**
 	Complete the read view creation */
@@ -298,8 +271,8 @@ private:
 	trx_id_t	m_creator_trx_id;
 
 	/** Set of RW transactions that was active when this snapshot
-	was taken */
-	ids_t		m_ids;
+	was taken, shared with other views. NULL if there were none. */
+	ids_t*		m_ids;
 
 	/** The view does not need to see the undo logs for transactions
 	whose transaction number is strictly smaller (<) than this value:
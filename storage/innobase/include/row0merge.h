@@ -42,6 +42,10 @@ Created 13/06/2005 Jan Lindstrom
 // Forward declaration
 struct ib_sequence_t;
 
+/** Maximum number of threads that build indexes in parallel,
+see innodb_sort_threads */
+#define ROW_MERGE_MAX_THREADS	32
+
 /** @brief Block size for I/O operations in merge sort.
 
 The minimum is UNIV_PAGE_SIZE, or page_get_free_space_of_empty()
@@ -116,6 +120,12 @@ struct row_merge_dup_t {
 					(index->table), or NULL if not
 					rebuilding table */
 	ulint			n_dup;	/*!< number of duplicates */
+	ib_mutex_t*		mutex;	/*!< mutex protecting *reported
+					when several threads sort
+					entries, or NULL */
+	const dict_index_t**	reported;/*!< in/out: the index whose
+					duplicate was copied to table,
+					or NULL if mutex == NULL */
 };
 
 /*************************************************************//**
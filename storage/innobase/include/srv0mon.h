@@ -192,6 +192,38 @@ enum monitor_id_t {
 	MONITOR_FLUSH_BACKGROUND_TOTAL_PAGE,
 	MONITOR_FLUSH_BACKGROUND_COUNT,
 	MONITOR_FLUSH_BACKGROUND_PAGES,
+	MONITOR_FLUSH_CLEANER_0_TIME,
+	MONITOR_FLUSH_CLEANER_0_PAGES,
+	MONITOR_FLUSH_CLEANER_1_TIME,
+	MONITOR_FLUSH_CLEANER_1_PAGES,
+	MONITOR_FLUSH_CLEANER_2_TIME,
+	MONITOR_FLUSH_CLEANER_2_PAGES,
+	MONITOR_FLUSH_CLEANER_3_TIME,
+	MONITOR_FLUSH_CLEANER_3_PAGES,
+	MONITOR_FLUSH_CLEANER_4_TIME,
+	MONITOR_FLUSH_CLEANER_4_PAGES,
+	MONITOR_FLUSH_CLEANER_5_TIME,
+	MONITOR_FLUSH_CLEANER_5_PAGES,
+	MONITOR_FLUSH_CLEANER_6_TIME,
+	MONITOR_FLUSH_CLEANER_6_PAGES,
+	MONITOR_FLUSH_CLEANER_7_TIME,
+	MONITOR_FLUSH_CLEANER_7_PAGES,
+	MONITOR_FLUSH_CLEANER_8_TIME,
+	MONITOR_FLUSH_CLEANER_8_PAGES,
+	MONITOR_FLUSH_CLEANER_9_TIME,
+	MONITOR_FLUSH_CLEANER_9_PAGES,
+	MONITOR_FLUSH_CLEANER_10_TIME,
+	MONITOR_FLUSH_CLEANER_10_PAGES,
+	MONITOR_FLUSH_CLEANER_11_TIME,
+	MONITOR_FLUSH_CLEANER_11_PAGES,
+	MONITOR_FLUSH_CLEANER_12_TIME,
+	MONITOR_FLUSH_CLEANER_12_PAGES,
+	MONITOR_FLUSH_CLEANER_13_TIME,
+	MONITOR_FLUSH_CLEANER_13_PAGES,
+	MONITOR_FLUSH_CLEANER_14_TIME,
+	MONITOR_FLUSH_CLEANER_14_PAGES,
+	MONITOR_FLUSH_CLEANER_15_TIME,
+	MONITOR_FLUSH_CLEANER_15_PAGES,
 	MONITOR_LRU_BATCH_SCANNED,
 	MONITOR_LRU_BATCH_SCANNED_NUM_CALL,
 	MONITOR_LRU_BATCH_SCANNED_PER_CALL,
@@ -284,6 +316,13 @@ enum monitor_id_t {
 	MONITOR_DML_PURGE_DELAY,
 	MONITOR_PURGE_STOP_COUNT,
 	MONITOR_PURGE_RESUME_COUNT,
+	MONITOR_PURGE_BATCH_SIZE,
+	MONITOR_PURGE_BATCH_TABLES,
+	MONITOR_PURGE_TABLE_MAX_RECORDS,
+	MONITOR_PURGE_TABLE_MAX_ID,
+	MONITOR_UNDO_TRUNCATE_COUNT,
+	MONITOR_UNDO_TRUNCATE_DRAIN_MICROSECOND,
+	MONITOR_UNDO_TRUNCATE_MICROSECOND,
 
 	/* Recovery related counters */
 	MONITOR_MODULE_RECOVERY,
@@ -324,6 +363,38 @@ enum monitor_id_t {
 	MONITOR_ADAPTIVE_HASH_ROW_REMOVED,
 	MONITOR_ADAPTIVE_HASH_ROW_REMOVE_NOT_FOUND,
 	MONITOR_ADAPTIVE_HASH_ROW_UPDATED,
+	MONITOR_ADAPTIVE_HASH_PART_0_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_0_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_1_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_1_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_2_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_2_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_3_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_3_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_4_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_4_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_5_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_5_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_6_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_6_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_7_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_7_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_8_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_8_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_9_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_9_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_10_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_10_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_11_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_11_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_12_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_12_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_13_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_13_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_14_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_14_MISSES,
+	MONITOR_ADAPTIVE_HASH_PART_15_HITS,
+	MONITOR_ADAPTIVE_HASH_PART_15_MISSES,
 
 	/* Tablespace related counters */
 	MONITOR_MODULE_FIL_SYSTEM,
@@ -64,6 +64,14 @@ struct srv_stats_t {
 	/** Count the amount of data written in total (in bytes) */
 	ulint_ctr_1_t		data_written;
 
+	/** Number of pages that were written compressed to tablespaces
+	with transparent page compression */
+	ulint_ctr_1_t		pages_page_compressed;
+
+	/** Number of bytes that were not written, and were punched out
+	of the files instead, because pages were compressed */
+	ulint_ctr_1_t		page_compression_saved;
+
 	/** Number of the log write requests done */
 	ulint_ctr_1_t		log_write_requests;
 
@@ -207,6 +215,11 @@ extern ibool	srv_locks_unsafe_for_binlog;
 
 /** Sort buffer size in index creation */
 extern ulong	srv_sort_buf_size;
+/** Number of threads that build secondary indexes in index creation */
+extern ulong	srv_sort_threads;
+/** Percentage of each B-tree page that is filled when sorted index
+entries are loaded in index creation */
+extern ulong	srv_fill_factor;
 /** Maximum modification log file size for online index creation */
 extern unsigned long long	srv_online_max_size;
 
@@ -215,6 +228,9 @@ OS (provided we compiled Innobase with it in), otherwise we will
 use simulated aio we build below with threads.
 Currently we support native aio on windows and linux */
 extern my_bool	srv_use_native_aio;
+/* If this flag is TRUE, Linux native aio requests are submitted through
+io_uring rather than libaio, provided io_uring support is compiled in */
+extern my_bool	srv_use_io_uring;
 #ifdef _WIN32
 extern bool	srv_use_native_conditions;
 #endif /* _WIN32 */
@@ -232,6 +248,12 @@ extern ulint	srv_undo_tablespaces_open;
 /** The number of undo segments to use */
 extern ulong	srv_undo_logs;
 
+/** Whether purge truncates undo tablespaces that grew too big. */
+extern my_bool	srv_undo_log_truncate;
+
+/** Size in bytes beyond which an undo tablespace is truncated. */
+extern unsigned long long	srv_max_undo_log_size;
+
 /** UNDO logs not redo logged, these logs reside in the temp tablespace.*/
 extern const ulong	srv_tmp_undo_logs;
 
@@ -246,6 +268,12 @@ extern ib_uint64_t	srv_log_file_size_requested;
 extern ulint	srv_log_buffer_size;
 extern ulong	srv_flush_log_at_trx_commit;
 extern uint	srv_flush_log_at_timeout;
+/* If this flag is TRUE, dedicated log writer and log flusher threads
+write and flush the redo log, instead of the committing threads */
+extern my_bool	srv_log_writer_threads;
+/* Number of spin rounds a thread waiting for a log write or flush does
+before it waits for an event */
+extern ulong	srv_log_wait_spin_rounds;
 extern char	srv_adaptive_flushing;
 
 /* If this flag is TRUE, then we will load the indexes' (and tables') metadata
@@ -271,6 +299,10 @@ extern ulint	srv_buf_pool_old_size;	/*!< previously requested size */
 extern ulint	srv_buf_pool_curr_size;	/*!< current size in bytes */
 extern ulong	srv_buf_pool_dump_pct;	/*!< dump that may % of each buffer
 					pool during BP dump */
+extern ulong	srv_buf_pool_load_threads;/*!< number of threads loading
+					each buffer pool during BP load */
+extern ulong	srv_buf_pool_load_hot_pct;/*!< load the hottest % of the
+					dumped pages first during BP load */
 extern ulint	srv_mem_pool_size;
 extern ulint	srv_lock_table_size;
 
@@ -371,6 +403,13 @@ extern ulint	srv_available_undo_logs;
 extern	ulint	srv_mem_pool_size;
 extern	ulint	srv_lock_table_size;
 
+/** Number of threads that merge the change buffer, 0 if the master
+thread does it */
+extern ulong	srv_ibuf_merge_threads;
+/** Pages per second that the change buffer merge threads read, 0 for
+innodb_io_capacity */
+extern ulong	srv_ibuf_merge_rate;
+
 #if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
 extern my_bool	srv_ibuf_disable_background_merge;
 #endif /* UNIV_DEBUG || UNIV_IBUF_DEBUG */
@@ -398,6 +437,12 @@ extern const char* srv_io_thread_function[];
 /* the number of purge threads to use from the worker pool (currently 0 or 1) */
 extern ulong srv_n_purge_threads;
 
+/* the number of page cleaner threads, including the coordinator */
+extern ulong srv_n_page_cleaners;
+
+/* the number of threads applying redo log records in crash recovery */
+extern ulong srv_n_recovery_threads;
+
 /* the number of pages to purge in one batch */
 extern ulong srv_purge_batch_size;
 
@@ -407,6 +452,10 @@ extern ulong srv_sync_array_size;
 /* print all user-level transactions deadlocks to mysqld stderr */
 extern my_bool srv_print_all_deadlocks;
 
+/* detect deadlocks in a background thread instead of when a lock wait
+is enqueued */
+extern my_bool srv_deadlock_detect_background;
+
 extern my_bool	srv_cmp_per_index_enabled;
 
 /** Status variables to be passed to MySQL */
@@ -425,11 +474,18 @@ extern mysql_pfs_key_t	io_read_thread_key;
 extern mysql_pfs_key_t	io_write_thread_key;
 extern mysql_pfs_key_t	io_handler_thread_key;
 extern mysql_pfs_key_t	srv_lock_timeout_thread_key;
+extern mysql_pfs_key_t	srv_lock_deadlock_thread_key;
 extern mysql_pfs_key_t	srv_error_monitor_thread_key;
 extern mysql_pfs_key_t	srv_monitor_thread_key;
 extern mysql_pfs_key_t	srv_master_thread_key;
 extern mysql_pfs_key_t	srv_purge_thread_key;
 extern mysql_pfs_key_t	recv_writer_thread_key;
+extern mysql_pfs_key_t	recv_apply_thread_key;
+extern mysql_pfs_key_t	buf_load_thread_key;
+extern mysql_pfs_key_t	row_merge_thread_key;
+extern mysql_pfs_key_t	log_writer_thread_key;
+extern mysql_pfs_key_t	log_flusher_thread_key;
+extern mysql_pfs_key_t	ibuf_merge_thread_key;
 
 /* This macro register the current thread and its key with performance
 schema */
@@ -808,6 +864,8 @@ struct export_var_t{
 	ulint innodb_pages_created;		/*!< buf_pool->stat.n_pages_created */
 	ulint innodb_pages_read;		/*!< buf_pool->stat.n_pages_read */
 	ulint innodb_pages_written;		/*!< buf_pool->stat.n_pages_written */
+	ulint innodb_pages_page_compressed;	/*!< srv_pages_page_compressed */
+	ulint innodb_page_compression_saved;	/*!< srv_page_compression_saved */
 	ulint innodb_row_lock_waits;		/*!< srv_n_lock_wait_count */
 	ulint innodb_row_lock_current_waits;	/*!< srv_n_lock_wait_current_count */
 	ib_int64_t innodb_row_lock_time;	/*!< srv_n_lock_wait_time
@@ -862,6 +920,7 @@ struct srv_slot_t{
 #else /* !UNIV_HOTBACKUP */
 # define srv_use_adaptive_hash_indexes		FALSE
 # define srv_use_native_aio			FALSE
+# define srv_use_io_uring			FALSE
 # define srv_force_recovery			0UL
 # define srv_set_io_thread_op_info(t,info)	((void) 0)
 # define srv_reset_io_thread_op_info()		((void) 0)
@@ -36,6 +36,11 @@ Created 10/10/1995 Heikki Tuuri
 #define SRV_PATH_SEPARATOR	'/'
 #endif
 
+/** Default undo tablespace size in UNIV_PAGEs count (10MB). This is also
+the size to which an undo tablespace is truncated. */
+static const ulint SRV_UNDO_TABLESPACE_SIZE_IN_PAGES =
+	((1024 * 1024) * 10) / UNIV_PAGE_SIZE_DEF;
+
 #ifdef DBUG_OFF
 # define RECOVERY_CRASH(x) do {} while(0)
 #else
@@ -164,9 +164,13 @@ V
 lock_sys_wait_mutex			Mutex protecting lock timeout data
 |
 V
-lock_sys_mutex				Mutex protecting lock_sys_t
+lock_sys_latch				Latch protecting lock_sys_t
 |
 V
+lock_rec_shard_mutex			Mutex protecting a partition of the
+|					record locks, acquired with
+|					lock_sys_latch in S mode
+V
 trx_sys->mutex				Mutex protecting trx_sys_t
 |
 V
@@ -232,6 +236,7 @@ enum latch_level_t {
 	SYNC_FTS_BG_THREADS,
 	SYNC_FTS_CACHE_INIT,
 	SYNC_RECV,
+	SYNC_PAGE_CLEANER,
 	SYNC_LOG_FLUSH_ORDER,
 	SYNC_LOG,
 	SYNC_PURGE_QUEUE,
@@ -240,6 +245,7 @@ enum latch_level_t {
 	SYNC_THREADS,
 	SYNC_TRX,
 	SYNC_TRX_SYS,
+	SYNC_LOCK_REC_SHARD,
 	SYNC_LOCK_SYS,
 	SYNC_LOCK_WAIT_SYS,
 
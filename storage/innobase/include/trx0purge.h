@@ -112,6 +112,35 @@ void
 trx_purge_run(void);
 /*================*/
 
+/*******************************************************************//**
+Checks at startup whether the server crashed while purge was truncating
+an undo tablespace. If it did, the tablespace is remembered until
+trx_purge_fix_up_undo_spaces() has initialized it again; until then,
+its redo log is ignored and its rollback segments are not loaded.
+@return true if the truncation of the tablespace must be finished */
+
+bool
+trx_purge_check_undo_space_truncated(
+/*=================================*/
+	ulint	space_id);	/*!< in: undo tablespace id */
+/*******************************************************************//**
+Checks if an undo tablespace is waiting for
+trx_purge_fix_up_undo_spaces() after a crash during its truncation.
+@return true if the tablespace is being truncated */
+
+bool
+trx_purge_is_undo_space_truncated(
+/*==============================*/
+	ulint	space_id);	/*!< in: tablespace id */
+/*******************************************************************//**
+Finishes the truncation of the undo tablespaces that was interrupted by
+a crash: initializes their pages and re-creates their rollback segments.
+Called after the redo log has been applied. */
+
+void
+trx_purge_fix_up_undo_spaces(void);
+/*==============================*/
+
 /** Purge states */
 enum purge_state_t {
 	PURGE_STATE_INIT,		/*!< Purge instance created */
@@ -233,6 +262,21 @@ struct trx_purge_t{
 					TrxUndoRsegs::trx_no. It is protected
 					by the pq_mutex */
 	PQMutex		pq_mutex;	/*!< Mutex protecting purge_queue */
+	mem_heap_t*	heap;		/*!< Memory heap for the undo records
+					of the current batch, emptied when
+					all the purge threads have completed
+					it */
+	/*-----------------------------*/
+	ulint		undo_trunc_space;
+					/*!< The undo tablespace that is marked
+					for truncation: its rollback segments
+					are not assigned to new transactions.
+					ULINT_UNDEFINED if none */
+	ulint		undo_trunc_next;/*!< Undo tablespace from which the
+					next search for one to mark starts */
+	ullint		undo_trunc_marked_time;
+					/*!< ut_time_us() when the undo
+					tablespace was marked */
 };
 
 /** Info required to purge a record */
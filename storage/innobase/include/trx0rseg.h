@@ -136,6 +136,18 @@ trx_rseg_create(
 	ulint   nth_free_slot);	/*!< in: allocate nth free slot.
 				0 means next free slots. */
 
+/*********************************************************************//**
+Re-creates the header of a rollback segment in an undo tablespace that
+was truncated, in the same slot of the trx system header, and resets its
+memory object. The memory object is created if it does not exist yet.
+@return rollback segment memory object */
+
+trx_rseg_t*
+trx_rseg_recreate(
+/*==============*/
+	ulint	space,		/*!< in: id of the truncated UNDO tablespace */
+	ulint	slot_no);	/*!< in: rseg id == slot number in trx sys */
+
 /********************************************************************
 Get the number of unique rollback tablespaces in use except space id 0.
 The last space id will be the sentinel value ULINT_UNDEFINED. The array
@@ -193,6 +205,14 @@ struct trx_rseg_t{
 					yet purged log */
 	ibool		last_del_marks;	/*!< TRUE if the last not yet purged log
 					needs purging */
+	/*--------------------------------------------------------*/
+	ulint		trx_ref_count;	/*!< Number of transactions that were
+					assigned this rollback segment and
+					have not committed or rolled back */
+	bool		skip_allocation;/*!< true if the rollback segment is
+					not assigned to new transactions,
+					because purge is going to truncate
+					its undo tablespace */
 };
 
 /* Undo log segment slot in a rollback segment header */
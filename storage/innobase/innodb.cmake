@@ -28,12 +28,43 @@ IF(UNIX)
     IF(HAVE_LIBAIO_H AND HAVE_LIBAIO)
       ADD_DEFINITIONS(-DLINUX_NATIVE_AIO=1)
       LINK_LIBRARIES(aio)
+      # io_uring is used through raw system calls, only the kernel
+      # headers are needed
+      CHECK_C_SOURCE_COMPILES("
+      #include <linux/io_uring.h>
+      #include <sys/syscall.h>
+      int main()
+      {
+        struct io_uring_params p;
+        return(__NR_io_uring_setup + __NR_io_uring_enter
+               + __NR_io_uring_register + IORING_OP_READ_FIXED
+               + IORING_FEAT_SINGLE_MMAP + sizeof(p));
+      }"
+      HAVE_IO_URING)
+      IF(HAVE_IO_URING)
+        ADD_DEFINITIONS(-DHAVE_IO_URING=1)
+      ENDIF()
     ENDIF()
   ELSEIF(CMAKE_SYSTEM_NAME STREQUAL "SunOS")
     ADD_DEFINITIONS("-DUNIV_SOLARIS")
   ENDIF()
 ENDIF()
 
+# Optional compression algorithms for ROW_FORMAT=COMPRESSED,
+# in addition to zlib
+CHECK_INCLUDE_FILES (lz4.h HAVE_LZ4_H)
+CHECK_LIBRARY_EXISTS(lz4 LZ4_compress_default "" HAVE_LZ4)
+IF(HAVE_LZ4_H AND HAVE_LZ4)
+  ADD_DEFINITIONS(-DHAVE_LZ4=1)
+  LINK_LIBRARIES(lz4)
+ENDIF()
+CHECK_INCLUDE_FILES (zstd.h HAVE_ZSTD_H)
+CHECK_LIBRARY_EXISTS(zstd ZSTD_compress "" HAVE_ZSTD)
+IF(HAVE_ZSTD_H AND HAVE_ZSTD)
+  ADD_DEFINITIONS(-DHAVE_ZSTD=1)
+  LINK_LIBRARIES(zstd)
+ENDIF()
+
 OPTION(INNODB_COMPILER_HINTS "Compile InnoDB with compiler hints" ON)
 MARK_AS_ADVANCED(INNODB_COMPILER_HINTS)
 
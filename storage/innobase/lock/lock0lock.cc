@@ -43,8 +43,11 @@ Created 5/7/1996 Heikki Tuuri
 #include "ut0vec.h"
 #include "btr0btr.h"
 #include "dict0boot.h"
+#include "sync0sync.h"
 
+#include <map>
 #include <set>
+#include <vector>
 
 /** Restricts the length of search we will do in the waits-for
 graph of transactions */
@@ -58,6 +61,11 @@ static const ulint	LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK = 200;
 the lock mutex for a moment to give also others access to it */
 static const ulint	LOCK_RELEASE_INTERVAL = 1000;
 
+/** Transactions with more locks than this release their record locks
+holding only the record lock shards, instead of lock_sys->latch in X mode,
+so that lock requests on other pages can proceed meanwhile */
+static const ulint	LOCK_RELEASE_SHARDED_MIN = 32;
+
 /** Safety margin when creating a new record lock: this many extra records
 can be inserted to the page without need to create a lock with a bigger
 bitmap */
@@ -516,6 +524,10 @@ private:
 	@param lock lock trx wants */
 	static void joining_trx_print(const trx_t* trx, const lock_t* lock);
 
+	/** The background deadlock detector prints the deadlocks that
+	it finds in the same way. */
+	friend class WaitForGraph;
+
 private:
 	/** DFS state information, used during deadlock checking. */
 	struct state_t {
@@ -774,12 +786,18 @@ lock_sys_create(
 
 	lock_sys->last_slot = lock_sys->waiting_threads;
 
-	mutex_create("lock_sys", &lock_sys->mutex);
+	rw_lock_create(lock_sys_latch_key, &lock_sys->latch, SYNC_LOCK_SYS);
+
+	for (ulint i = 0; i < LOCK_REC_N_SHARDS; ++i) {
+		mutex_create("lock_rec_shard", &lock_sys->rec_shards[i].mutex);
+	}
 
 	mutex_create("lock_sys_wait", &lock_sys->wait_mutex);
 
 	lock_sys->timeout_event = os_event_create(0);
 
+	lock_sys->deadlock_event = os_event_create(0);
+
 	lock_sys->rec_hash = hash_create(n_cells);
 
 	if (!srv_read_only_mode) {
@@ -804,7 +822,14 @@ lock_sys_close(void)
 
 	os_event_destroy(lock_sys->timeout_event);
 
-	mutex_destroy(&lock_sys->mutex);
+	os_event_destroy(lock_sys->deadlock_event);
+
+	rw_lock_free(&lock_sys->latch);
+
+	for (ulint i = 0; i < LOCK_REC_N_SHARDS; ++i) {
+		mutex_destroy(&lock_sys->rec_shards[i].mutex);
+	}
+
 	mutex_destroy(&lock_sys->wait_mutex);
 
 	srv_slot_t*	slot = lock_sys->waiting_threads;
@@ -820,6 +845,97 @@ lock_sys_close(void)
 	lock_sys = NULL;
 }
 
+#ifdef UNIV_DEBUG
+/*********************************************************************//**
+Checks if the current thread holds lock_sys->latch in X mode.
+@return true if it does */
+
+bool
+lock_sys_x_own(void)
+/*================*/
+{
+	const rw_lock_t*	latch = &lock_sys->latch;
+
+	/* The writer thread id is only valid when the recursive flag
+	is set, and the flag is reset when the last X-latch is released. */
+	return(rw_lock_get_writer(latch) == RW_LOCK_X
+	       && latch->recursive
+	       && os_thread_eq(latch->writer_thread, os_thread_get_curr_id()));
+}
+#endif /* UNIV_DEBUG */
+
+/*********************************************************************//**
+Gets the record lock shard of a page.
+@return the shard of the page */
+UNIV_INLINE
+lock_rec_shard_t*
+lock_rec_get_shard(
+/*===============*/
+	ulint	space,	/*!< in: space */
+	ulint	page_no)/*!< in: page number */
+{
+	/* All the pages that hash to the same cell of lock_sys->rec_hash
+	must be in the same shard, because they share the cell chain. */
+	return(&lock_sys->rec_shards[
+		lock_rec_hash(space, page_no) % LOCK_REC_N_SHARDS]);
+}
+
+/*********************************************************************//**
+Acquires the mutex of the record lock shard of a page. The caller must
+hold lock_sys->latch in S mode.
+@return the shard of the page */
+static
+lock_rec_shard_t*
+lock_rec_shard_enter(
+/*=================*/
+	ulint	space,	/*!< in: space */
+	ulint	page_no)/*!< in: page number */
+{
+	lock_rec_shard_t*	shard = lock_rec_get_shard(space, page_no);
+
+	ut_ad(!lock_mutex_own());
+
+	if (shard->mutex.trylock(__FILE__, __LINE__) != 0) {
+
+		mutex_enter(&shard->mutex);
+
+		++shard->n_waits;
+	}
+
+	++shard->n_enters;
+
+	return(shard);
+}
+
+/*********************************************************************//**
+Releases the mutex of a record lock shard. */
+UNIV_INLINE
+void
+lock_rec_shard_exit(
+/*================*/
+	lock_rec_shard_t*	shard)	/*!< in: shard to release */
+{
+	shard->mutex.exit();
+}
+
+#ifdef UNIV_DEBUG
+/*********************************************************************//**
+Checks if the current thread may access the record locks of a page:
+either it holds lock_sys->latch in X mode, or it holds the mutex of the
+shard of the page (together with an S-latch on lock_sys->latch).
+@return true if the locks of the page are latched */
+static
+bool
+lock_rec_latched(
+/*=============*/
+	ulint	space,	/*!< in: space */
+	ulint	page_no)/*!< in: page number */
+{
+	return(lock_mutex_own()
+	       || lock_rec_get_shard(space, page_no)->mutex.is_owned());
+}
+#endif /* UNIV_DEBUG */
+
 /*********************************************************************//**
 Gets the size of a lock struct.
 @return size in bytes */
@@ -1329,12 +1445,13 @@ lock_rec_get_next_on_page_const(
 	ulint	space;
 	ulint	page_no;
 
-	ut_ad(lock_mutex_own());
 	ut_ad(lock_get_type_low(lock) == LOCK_REC);
 
 	space = lock->un_member.rec_lock.space;
 	page_no = lock->un_member.rec_lock.page_no;
 
+	ut_ad(lock_rec_latched(space, page_no));
+
 	for (;;) {
 		lock = static_cast<const lock_t*>(HASH_GET_NEXT(hash, lock));
 
@@ -1378,7 +1495,7 @@ lock_rec_get_first_on_page_addr(
 {
 	lock_t*	lock;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_latched(space, page_no));
 
 	for (lock = static_cast<lock_t*>(
 			HASH_GET_FIRST(lock_sys->rec_hash,
@@ -1430,7 +1547,7 @@ lock_rec_get_first_on_page(
 	ulint	space	= buf_block_get_space(block);
 	ulint	page_no	= buf_block_get_page_no(block);
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_latched(space, page_no));
 
 	hash = buf_block_get_lock_hash_val(block);
 
@@ -1942,7 +2059,8 @@ lock_rec_create(
 	ulint		n_bytes;
 	const page_t*	page;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_latched(buf_block_get_space(block),
+			       buf_block_get_page_no(block)));
 	ut_ad(caller_owns_trx_mutex == trx_mutex_own(trx));
 	ut_ad(dict_index_is_clust(index) || !dict_index_is_online_ddl(index));
 
@@ -2002,7 +2120,9 @@ lock_rec_create(
 	/* Set the bit corresponding to rec */
 	lock_rec_set_nth_bit(lock, heap_no);
 
-	index->table->n_rec_locks++;
+	/* Locks on pages of different shards can be created at the same
+	time. */
+	os_atomic_increment_ulint(&index->table->n_rec_locks, 1);
 
 	ut_ad(index->table->n_ref_count > 0 || !index->table->can_be_evicted);
 
@@ -2025,8 +2145,8 @@ lock_rec_create(
 		trx_mutex_exit(trx);
 	}
 
-	MONITOR_INC(MONITOR_RECLOCK_CREATED);
-	MONITOR_INC(MONITOR_NUM_RECLOCK);
+	MONITOR_ATOMIC_INC(MONITOR_RECLOCK_CREATED);
+	MONITOR_ATOMIC_INC(MONITOR_NUM_RECLOCK);
 
 	return(lock);
 }
@@ -2111,21 +2231,27 @@ lock_rec_enqueue_waiting(
 		lock_set_lock_and_trx_wait(lock, trx);
 	}
 
-	/* Release the mutex to obey the latching order.
-	This is safe, because DeadlockChecker::check_and_resolve()
-	is invoked when a lock wait is enqueued for the currently
-	running transaction. Because trx is a running transaction
-	(it is not currently suspended because of a lock wait),
-	its state can only be changed by this thread, which is
-	currently associated with the transaction. */
+	const trx_t*	victim_trx = 0;
 
-	trx_mutex_exit(trx);
+	/* With innodb_deadlock_detect_background, lock_deadlock_thread
+	looks for a deadlock after this thread has been suspended. */
 
-	const trx_t*	victim_trx;
+	if (!srv_deadlock_detect_background) {
 
-	victim_trx = DeadlockChecker::check_and_resolve(lock, trx);
+		/* Release the mutex to obey the latching order.
+		This is safe, because DeadlockChecker::check_and_resolve()
+		is invoked when a lock wait is enqueued for the currently
+		running transaction. Because trx is a running transaction
+		(it is not currently suspended because of a lock wait),
+		its state can only be changed by this thread, which is
+		currently associated with the transaction. */
 
-	trx_mutex_enter(trx);
+		trx_mutex_exit(trx);
+
+		victim_trx = DeadlockChecker::check_and_resolve(lock, trx);
+
+		trx_mutex_enter(trx);
+	}
 
 	if (victim_trx != 0) {
 
@@ -2302,7 +2428,8 @@ lock_rec_lock_fast(
 	trx_t*			trx;
 	enum lock_rec_req_status status = LOCK_REC_SUCCESS;
 
-	ut_ad(lock_mutex_own());
+	ut_ad(lock_rec_latched(buf_block_get_space(block),
+			       buf_block_get_page_no(block)));
 	ut_ad(!srv_read_only_mode);
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_S
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IS));
@@ -2459,7 +2586,8 @@ Tries to lock the specified record in the mode requested. If not immediately
 possible, enqueues a waiting lock request. This is a low-level function
 which does NOT look at implicit locks! Checks lock compatibility within
 explicit locks. This function sets a normal next-key lock, or in the case
-of a page supremum record, a gap type lock.
+of a page supremum record, a gap type lock. The caller must not hold
+lock_sys->latch.
 @return DB_SUCCESS, DB_SUCCESS_LOCKED_REC, DB_LOCK_WAIT, DB_DEADLOCK,
 or DB_QUE_THR_SUSPENDED */
 static
@@ -2479,7 +2607,11 @@ lock_rec_lock(
 	dict_index_t*		index,	/*!< in: index of record */
 	que_thr_t*		thr)	/*!< in: query thread */
 {
-	ut_ad(lock_mutex_own());
+	lock_rec_shard_t*		shard;
+	enum lock_rec_req_status	status;
+	dberr_t				err;
+
+	ut_ad(!lock_mutex_own());
 	ut_ad(!srv_read_only_mode);
 	ut_ad((LOCK_MODE_MASK & mode) != LOCK_S
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IS));
@@ -2493,19 +2625,41 @@ lock_rec_lock(
 	ut_ad(dict_index_is_clust(index) || !dict_index_is_online_ddl(index));
 
 	/* We try a simplified and faster subroutine for the most
-	common cases */
-	switch (lock_rec_lock_fast(impl, mode, block, heap_no, index, thr)) {
+	common cases. It only looks at the locks on this page, so it
+	only needs the shard of the page, and requests on pages of
+	other shards can proceed at the same time. */
+
+	lock_sys_s_lock();
+
+	shard = lock_rec_shard_enter(
+		buf_block_get_space(block), buf_block_get_page_no(block));
+
+	status = lock_rec_lock_fast(impl, mode, block, heap_no, index, thr);
+
+	lock_rec_shard_exit(shard);
+
+	lock_sys_s_unlock();
+
+	switch (status) {
 	case LOCK_REC_SUCCESS:
 		return(DB_SUCCESS);
 	case LOCK_REC_SUCCESS_CREATED:
 		return(DB_SUCCESS_LOCKED_REC);
 	case LOCK_REC_FAIL:
-		return(lock_rec_lock_slow(impl, mode, block,
-					  heap_no, index, thr));
+		break;
 	}
 
-	ut_error;
-	return(DB_ERROR);
+	/* The request may have to wait, and the deadlock check needs all
+	the locks. lock_rec_lock_fast() did not change anything, and the
+	queue may have changed since, so start over. */
+
+	lock_mutex_enter();
+
+	err = lock_rec_lock_slow(impl, mode, block, heap_no, index, thr);
+
+	lock_mutex_exit();
+
+	return(err);
 }
 
 /*********************************************************************//**
@@ -2710,7 +2864,6 @@ lock_rec_discard(
 	ulint		page_no;
 	trx_lock_t*	trx_lock;
 
-	ut_ad(lock_mutex_own());
 	ut_ad(lock_get_type_low(in_lock) == LOCK_REC);
 
 	trx_lock = &in_lock->trx->lock;
@@ -2718,15 +2871,19 @@ lock_rec_discard(
 	space = in_lock->un_member.rec_lock.space;
 	page_no = in_lock->un_member.rec_lock.page_no;
 
-	in_lock->index->table->n_rec_locks--;
+	ut_ad(lock_rec_latched(space, page_no));
+
+	/* Locks on pages of different shards can be discarded at the
+	same time. */
+	os_atomic_decrement_ulint(&in_lock->index->table->n_rec_locks, 1);
 
 	HASH_DELETE(lock_t, hash, lock_sys->rec_hash,
 		    lock_rec_fold(space, page_no), in_lock);
 
 	UT_LIST_REMOVE(trx_lock->trx_locks, in_lock);
 
-	MONITOR_INC(MONITOR_RECLOCK_REMOVED);
-	MONITOR_DEC(MONITOR_NUM_RECLOCK);
+	MONITOR_ATOMIC_INC(MONITOR_RECLOCK_REMOVED);
+	MONITOR_ATOMIC_DEC(MONITOR_NUM_RECLOCK);
 }
 
 /*************************************************************//**
@@ -3938,21 +4095,27 @@ lock_table_enqueue_waiting(
 
 	lock = lock_table_create(table, mode | LOCK_WAIT, trx);
 
-	/* Release the mutex to obey the latching order.
-	This is safe, because DeadlockChecker::check_and_resolve()
-	is invoked when a lock wait is enqueued for the currently
-	running transaction. Because trx is a running transaction
-	(it is not currently suspended because of a lock wait),
-	its state can only be changed by this thread, which is
-	currently associated with the transaction. */
+	const trx_t*	victim_trx = 0;
 
-	trx_mutex_exit(trx);
+	/* With innodb_deadlock_detect_background, lock_deadlock_thread
+	looks for a deadlock after this thread has been suspended. */
 
-	const trx_t*	victim_trx;
+	if (!srv_deadlock_detect_background) {
 
-	victim_trx = DeadlockChecker::check_and_resolve(lock, trx);
+		/* Release the mutex to obey the latching order.
+		This is safe, because DeadlockChecker::check_and_resolve()
+		is invoked when a lock wait is enqueued for the currently
+		running transaction. Because trx is a running transaction
+		(it is not currently suspended because of a lock wait),
+		its state can only be changed by this thread, which is
+		currently associated with the transaction. */
 
-	trx_mutex_enter(trx);
+		trx_mutex_exit(trx);
+
+		victim_trx = DeadlockChecker::check_and_resolve(lock, trx);
+
+		trx_mutex_enter(trx);
+	}
 
 	if (victim_trx != 0) {
 		ut_ad(victim_trx == trx);
@@ -4320,6 +4483,76 @@ lock_check_dict_lock(
 }
 #endif /* UNIV_DEBUG */
 
+/*********************************************************************//**
+Releases the record locks of a committed transaction on the pages where no
+lock request is waiting, holding only the shard of each page. Granting a
+waiting request needs lock_sys->latch in X mode, so the locks on the pages
+with waiting requests are left for lock_release(). */
+static
+void
+lock_release_rec_sharded(
+/*=====================*/
+	trx_t*	trx)	/*!< in/out: transaction */
+{
+	lock_t*		lock;
+	lock_t*		prev;
+	ulint		count = 0;
+
+	ut_ad(!lock_mutex_own());
+	ut_ad(!trx_mutex_own(trx));
+	ut_ad(trx_state_eq(trx, TRX_STATE_COMMITTED_IN_MEMORY));
+
+	lock_sys_s_lock();
+
+	for (lock = UT_LIST_GET_LAST(trx->lock.trx_locks);
+	     lock != NULL;
+	     lock = prev) {
+
+		prev = UT_LIST_GET_PREV(trx_locks, lock);
+
+		if (lock_get_type_low(lock) != LOCK_REC) {
+			continue;
+		}
+
+		ulint			space = lock->un_member.rec_lock.space;
+		ulint			page_no
+			= lock->un_member.rec_lock.page_no;
+		lock_rec_shard_t*	shard
+			= lock_rec_shard_enter(space, page_no);
+		const lock_t*		wait_lock;
+
+		for (wait_lock = lock_rec_get_first_on_page_addr(
+				space, page_no);
+		     wait_lock != NULL && !lock_get_wait(wait_lock);
+		     wait_lock = lock_rec_get_next_on_page_const(wait_lock)) {
+		}
+
+		if (wait_lock == NULL) {
+			lock_rec_discard(lock);
+			++count;
+		}
+
+		lock_rec_shard_exit(shard);
+
+		if (count == LOCK_RELEASE_INTERVAL) {
+			/* Release the latch for a while, so that we do
+			not block the threads waiting for the X-latch.
+			They can move our remaining locks, so restart
+			from the end of the list. */
+
+			lock_sys_s_unlock();
+
+			lock_sys_s_lock();
+
+			prev = UT_LIST_GET_LAST(trx->lock.trx_locks);
+
+			count = 0;
+		}
+	}
+
+	lock_sys_s_unlock();
+}
+
 /*********************************************************************//**
 Releases transaction locks, and releases possible other transactions waiting
 because of these locks. */
@@ -4805,6 +5038,37 @@ lock_get_n_rec_locks(void)
 }
 #endif /* PRINT_NUM_OF_LOCK_STRUCTS */
 
+/*********************************************************************//**
+Prints the contention counters of the record lock shards. The counters
+are read without the shard mutexes. */
+static
+void
+lock_rec_shards_print(
+/*==================*/
+	FILE*	file)	/*!< in: file where to print */
+{
+	ulint	n_enters = 0;
+	ulint	n_waits = 0;
+
+	for (ulint i = 0; i < LOCK_REC_N_SHARDS; ++i) {
+		n_enters += lock_sys->rec_shards[i].n_enters;
+		n_waits += lock_sys->rec_shards[i].n_waits;
+	}
+
+	fprintf(file,
+		"Record lock shards %lu, mutex enters %lu, waits %lu\n"
+		"Waits per shard:",
+		(ulong) LOCK_REC_N_SHARDS, (ulong) n_enters, (ulong) n_waits);
+
+	for (ulint i = 0; i < LOCK_REC_N_SHARDS; ++i) {
+		fprintf(file, "%s %lu",
+			i > 0 && i % 16 == 0 ? "\n" : "",
+			(ulong) lock_sys->rec_shards[i].n_waits);
+	}
+
+	putc('\n', file);
+}
+
 /*********************************************************************//**
 Prints info of locks for all transactions.
 @return FALSE if not able to obtain lock mutex
@@ -4883,6 +5147,8 @@ lock_print_info_summary(
 		"History list length %lu\n",
 		(ulong) trx_sys->rseg_history_len);
 
+	lock_rec_shards_print(file);
+
 #ifdef PRINT_NUM_OF_LOCK_STRUCTS
 	fprintf(file,
 		"Total number of lock structs in row lock hash table %lu\n",
@@ -6003,16 +6269,12 @@ lock_clust_rec_modify_check_and_lock(
 
 	lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 
-	lock_mutex_enter();
-
 	ut_ad(lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 
 	err = lock_rec_lock(TRUE, LOCK_X | LOCK_REC_NOT_GAP,
 			    block, heap_no, index, thr);
 
-	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
-
-	lock_mutex_exit();
+	MONITOR_ATOMIC_INC(MONITOR_NUM_RECLOCK_REQ);
 
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
@@ -6064,16 +6326,12 @@ lock_sec_rec_modify_check_and_lock(
 	index record, and this would not have been possible if another active
 	transaction had modified this secondary index record. */
 
-	lock_mutex_enter();
-
 	ut_ad(lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 
 	err = lock_rec_lock(TRUE, LOCK_X | LOCK_REC_NOT_GAP,
 			    block, heap_no, index, thr);
 
-	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
-
-	lock_mutex_exit();
+	MONITOR_ATOMIC_INC(MONITOR_NUM_RECLOCK_REQ);
 
 #ifdef UNIV_DEBUG
 	{
@@ -6165,8 +6423,6 @@ lock_sec_rec_read_check_and_lock(
 		lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 	}
 
-	lock_mutex_enter();
-
 	ut_ad(mode != LOCK_X
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 	ut_ad(mode != LOCK_S
@@ -6175,9 +6431,7 @@ lock_sec_rec_read_check_and_lock(
 	err = lock_rec_lock(FALSE, mode | gap_mode,
 			    block, heap_no, index, thr);
 
-	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
-
-	lock_mutex_exit();
+	MONITOR_ATOMIC_INC(MONITOR_NUM_RECLOCK_REQ);
 
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
@@ -6239,8 +6493,6 @@ lock_clust_rec_read_check_and_lock(
 		lock_rec_convert_impl_to_expl(block, rec, index, offsets);
 	}
 
-	lock_mutex_enter();
-
 	ut_ad(mode != LOCK_X
 	      || lock_table_has(thr_get_trx(thr), index->table, LOCK_IX));
 	ut_ad(mode != LOCK_S
@@ -6248,9 +6500,7 @@ lock_clust_rec_read_check_and_lock(
 
 	err = lock_rec_lock(FALSE, mode | gap_mode, block, heap_no, index, thr);
 
-	MONITOR_INC(MONITOR_NUM_RECLOCK_REQ);
-
-	lock_mutex_exit();
+	MONITOR_ATOMIC_INC(MONITOR_NUM_RECLOCK_REQ);
 
 	ut_ad(lock_rec_queue_validate(FALSE, block, rec, index, offsets));
 
@@ -6763,6 +7013,15 @@ lock_trx_release_locks(
 
 	trx_mutex_exit(trx);
 
+	if (UT_LIST_GET_LEN(trx->lock.trx_locks) > LOCK_RELEASE_SHARDED_MIN) {
+
+		lock_mutex_exit();
+
+		lock_release_rec_sharded(trx);
+
+		lock_mutex_enter();
+	}
+
 	lock_release(trx);
 
 	lock_mutex_exit();
@@ -7481,6 +7740,454 @@ DeadlockChecker::check_and_resolve(const lock_t* lock, const trx_t* trx)
 	return(victim_trx);
 }
 
+/** Gets the next lock ahead of a waiting lock in its queue that the waiting
+lock has to wait for.
+@param wait_lock waiting lock
+@param lock NULL to get the first such lock, else the previous one
+@return next lock that wait_lock waits for, or NULL */
+static
+const lock_t*
+lock_get_next_blocking(const lock_t* wait_lock, const lock_t* lock)
+{
+	ut_ad(lock_mutex_own());
+	ut_ad(lock_get_wait(wait_lock));
+
+	if (lock_get_type_low(wait_lock) == LOCK_REC) {
+		ulint	heap_no = lock_rec_find_set_bit(wait_lock);
+
+		if (lock == NULL) {
+			lock = lock_rec_get_first_on_page_addr(
+				wait_lock->un_member.rec_lock.space,
+				wait_lock->un_member.rec_lock.page_no);
+		} else {
+			lock = lock_rec_get_next_on_page_const(lock);
+		}
+
+		for (/* No op */;
+		     lock != wait_lock;
+		     lock = lock_rec_get_next_on_page_const(lock)) {
+
+			ut_ad(lock != NULL);
+
+			if (lock_rec_get_nth_bit(lock, heap_no)
+			    && lock_has_to_wait(wait_lock, lock)) {
+
+				return(lock);
+			}
+		}
+	} else {
+		if (lock == NULL) {
+			lock = UT_LIST_GET_FIRST(
+				wait_lock->un_member.tab_lock.table->locks);
+		} else {
+			lock = UT_LIST_GET_NEXT(un_member.tab_lock.locks, lock);
+		}
+
+		for (/* No op */;
+		     lock != wait_lock;
+		     lock = UT_LIST_GET_NEXT(un_member.tab_lock.locks, lock)) {
+
+			ut_ad(lock != NULL);
+
+			if (lock_has_to_wait(wait_lock, lock)) {
+				return(lock);
+			}
+		}
+	}
+
+	return(NULL);
+}
+
+/** Background deadlock detector. The wait-for graph of the suspended
+transactions is copied holding lock_sys->latch in X mode, and searched for
+cycles without the latch, with an explicit stack. A cycle can have been
+broken meanwhile, so the latch is acquired again to check that each of its
+edges still exists before a victim is rolled back. */
+class WaitForGraph {
+public:
+	/** Finds and resolves the deadlocks among the suspended
+	transactions. */
+	void check_and_resolve();
+
+private:
+	/** A suspended transaction */
+	struct node_t {
+		/** The transaction. trx_t objects are never freed
+		while the server is running, the pointer can be
+		dereferenced after the latch has been released. */
+		trx_t*		m_trx;
+
+		/** The lock that m_trx waits for */
+		const lock_t*	m_wait_lock;
+
+		/** Undo log size of m_trx when the graph was copied */
+		undo_no_t	m_undo_no;
+
+		/** Number of locks of m_trx */
+		ulint		m_n_locks;
+
+		/** true if m_trx has modified non-transactional tables */
+		bool		m_notrans_edit;
+
+		/** Offset of the first edge of the node in m_edges */
+		ulint		m_edges;
+
+		/** Number of edges of the node */
+		ulint		m_n_edges;
+
+		/** State of the node in the search */
+		enum {
+			WHITE,		/*!< not visited */
+			GREY,		/*!< on the search stack */
+			BLACK		/*!< no cycle is reachable, or
+					the node was rolled back */
+		}		m_color;
+	};
+
+	/** Search state: node and the next edge to follow */
+	typedef std::pair<ulint, ulint>		frame_t;
+
+	typedef std::map<const trx_t*, ulint>	trx_map_t;
+
+	/** Copies the wait-for graph of the suspended transactions. */
+	void snapshot();
+
+	/** Searches for a cycle reachable from a node.
+	@param root index of the node to start from
+	@return true if a cycle was found, it is on m_stack from the
+	node that the top of the stack points to */
+	bool search(ulint root);
+
+	/** Selects the victim of a cycle: the transaction that has not
+	modified non-transactional tables, and has the smallest undo log.
+	@param first position of the first cycle node in m_stack
+	@return index of the victim node */
+	ulint select_victim(ulint first) const;
+
+	/** Checks that a cycle still exists in the lock queues.
+	@param first position of the first cycle node in m_stack
+	@return true if it does */
+	bool validate(ulint first) const;
+
+	/** Prints a cycle to the deadlock file and rolls back its victim.
+	@param first position of the first cycle node in m_stack
+	@param victim index of the victim node */
+	void resolve(ulint first, ulint victim) const;
+
+	/** The suspended transactions */
+	std::vector<node_t>	m_nodes;
+
+	/** The edges: the indexes of the nodes that the nodes wait for */
+	std::vector<ulint>	m_edge_nodes;
+
+	/** Search stack */
+	std::vector<frame_t>	m_stack;
+};
+
+/** Copies the wait-for graph of the suspended transactions. */
+void
+WaitForGraph::snapshot()
+{
+	trx_map_t	trx_map;
+
+	m_nodes.clear();
+	m_edge_nodes.clear();
+
+	lock_wait_mutex_enter();
+
+	lock_mutex_enter();
+
+	for (const srv_slot_t* slot = lock_sys->waiting_threads;
+	     slot < lock_sys->last_slot;
+	     ++slot) {
+
+		if (!slot->in_use) {
+			continue;
+		}
+
+		trx_t*	trx = thr_get_trx(slot->thr);
+
+		if (trx->lock.wait_lock == NULL) {
+			continue;
+		}
+
+		node_t	node;
+
+		node.m_trx = trx;
+		node.m_wait_lock = trx->lock.wait_lock;
+		node.m_undo_no = trx->undo_no;
+		node.m_n_locks = UT_LIST_GET_LEN(trx->lock.trx_locks);
+		node.m_notrans_edit = trx->mysql_thd != NULL
+			&& thd_has_edited_nontrans_tables(trx->mysql_thd);
+		node.m_edges = 0;
+		node.m_n_edges = 0;
+		node.m_color = node_t::WHITE;
+
+		trx_map[trx] = m_nodes.size();
+
+		m_nodes.push_back(node);
+	}
+
+	lock_wait_mutex_exit();
+
+	/* Only the edges to suspended transactions can be on a cycle. */
+
+	for (ulint i = 0; i < m_nodes.size(); ++i) {
+		node_t&		node = m_nodes[i];
+		const lock_t*	lock = NULL;
+
+		node.m_edges = m_edge_nodes.size();
+
+		while ((lock = lock_get_next_blocking(node.m_wait_lock, lock))
+		       != NULL) {
+
+			trx_map_t::const_iterator	it
+				= trx_map.find(lock->trx);
+
+			if (it != trx_map.end()
+			    && (node.m_n_edges == 0
+				|| m_edge_nodes.back() != it->second)) {
+
+				m_edge_nodes.push_back(it->second);
+				++node.m_n_edges;
+			}
+		}
+	}
+
+	lock_mutex_exit();
+}
+
+/** Searches for a cycle reachable from a node.
+@param root index of the node to start from
+@return true if a cycle was found, it is on m_stack from the
+node that the top of the stack points to */
+bool
+WaitForGraph::search(ulint root)
+{
+	ut_ad(!lock_mutex_own());
+	ut_ad(m_stack.empty());
+
+	if (m_nodes[root].m_color != node_t::WHITE) {
+		return(false);
+	}
+
+	m_nodes[root].m_color = node_t::GREY;
+	m_stack.push_back(frame_t(root, 0));
+
+	while (!m_stack.empty()) {
+		frame_t&	frame = m_stack.back();
+		node_t&		node = m_nodes[frame.first];
+
+		if (frame.second == node.m_n_edges) {
+			/* All the edges have been searched. */
+			node.m_color = node_t::BLACK;
+			m_stack.pop_back();
+			continue;
+		}
+
+		ulint	next = m_edge_nodes[node.m_edges + frame.second++];
+
+		switch (m_nodes[next].m_color) {
+		case node_t::WHITE:
+			m_nodes[next].m_color = node_t::GREY;
+			m_stack.push_back(frame_t(next, 0));
+			break;
+		case node_t::GREY:
+			/* Found a cycle: remember where it starts. */
+			m_stack.push_back(frame_t(next, 0));
+			return(true);
+		case node_t::BLACK:
+			break;
+		}
+	}
+
+	return(false);
+}
+
+/** Selects the victim of a cycle: the transaction that has not
+modified non-transactional tables, and has the smallest undo log.
+@param first position of the first cycle node in m_stack
+@return index of the victim node */
+ulint
+WaitForGraph::select_victim(ulint first) const
+{
+	ulint	victim = m_stack[first].first;
+
+	for (ulint i = first + 1; i < m_stack.size() - 1; ++i) {
+		const node_t&	node = m_nodes[m_stack[i].first];
+		const node_t&	min = m_nodes[victim];
+
+		if (node.m_notrans_edit != min.m_notrans_edit) {
+			if (!node.m_notrans_edit) {
+				victim = m_stack[i].first;
+			}
+		} else if (node.m_undo_no < min.m_undo_no
+			   || (node.m_undo_no == min.m_undo_no
+			       && node.m_n_locks < min.m_n_locks)) {
+
+			victim = m_stack[i].first;
+		}
+	}
+
+	return(victim);
+}
+
+/** Checks that a cycle still exists in the lock queues.
+@param first position of the first cycle node in m_stack
+@return true if it does */
+bool
+WaitForGraph::validate(ulint first) const
+{
+	ut_ad(lock_mutex_own());
+
+	for (ulint i = first; i < m_stack.size() - 1; ++i) {
+		const node_t&	node = m_nodes[m_stack[i].first];
+		const trx_t*	next = m_nodes[m_stack[i + 1].first].m_trx;
+
+		if (node.m_trx->lock.wait_lock != node.m_wait_lock) {
+			return(false);
+		}
+
+		const lock_t*	lock = NULL;
+
+		do {
+			lock = lock_get_next_blocking(node.m_wait_lock, lock);
+		} while (lock != NULL && lock->trx != next);
+
+		if (lock == NULL) {
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/** Prints a cycle to the deadlock file and rolls back its victim.
+@param first position of the first cycle node in m_stack
+@param victim index of the victim node */
+void
+WaitForGraph::resolve(ulint first, ulint victim) const
+{
+	ut_ad(lock_mutex_own());
+
+	/* Room for the longest message below with a 20-digit number */
+	char	buf[sizeof "*** (18446744073709551615)"
+		    " WAITING FOR THIS LOCK TO BE GRANTED:\n"];
+	ulint	victim_no = 0;
+
+	DeadlockChecker::start_print();
+
+	for (ulint i = first; i < m_stack.size() - 1; ++i) {
+		const node_t&	node = m_nodes[m_stack[i].first];
+		ulint		no = i - first + 1;
+
+		if (m_stack[i].first == victim) {
+			victim_no = no;
+		}
+
+		ut_snprintf(buf, sizeof buf, "\n*** (%lu) TRANSACTION:\n",
+			    (ulong) no);
+		DeadlockChecker::print(buf);
+
+		DeadlockChecker::print(node.m_trx, 3000);
+
+		ut_snprintf(buf, sizeof buf,
+			    "*** (%lu) WAITING FOR THIS LOCK TO BE GRANTED:\n",
+			    (ulong) no);
+		DeadlockChecker::print(buf);
+
+		DeadlockChecker::print(node.m_wait_lock);
+	}
+
+	ut_snprintf(buf, sizeof buf, "*** WE ROLL BACK TRANSACTION (%lu)\n",
+		    (ulong) victim_no);
+	DeadlockChecker::print(buf);
+
+	trx_t*	trx = m_nodes[victim].m_trx;
+
+	trx_mutex_enter(trx);
+
+	trx->lock.was_chosen_as_deadlock_victim = true;
+
+	lock_cancel_waiting_and_release(trx->lock.wait_lock);
+
+	trx_mutex_exit(trx);
+
+	lock_deadlock_found = true;
+
+	MONITOR_INC(MONITOR_DEADLOCK);
+}
+
+/** Finds and resolves the deadlocks among the suspended transactions. */
+void
+WaitForGraph::check_and_resolve()
+{
+	ut_ad(!lock_mutex_own());
+	ut_ad(!srv_read_only_mode);
+
+	snapshot();
+
+	for (ulint root = 0; root < m_nodes.size(); /* No op */) {
+
+		if (!search(root)) {
+			ut_ad(m_stack.empty());
+			++root;
+			continue;
+		}
+
+		/* The top of the stack is the node that closed the
+		cycle. Find where the cycle starts. */
+
+		ulint	first = m_stack.size() - 1;
+
+		do {
+			ut_a(first > 0);
+			--first;
+		} while (m_stack[first].first != m_stack.back().first);
+
+		ulint	victim = select_victim(first);
+
+		lock_mutex_enter();
+
+		if (validate(first)) {
+			resolve(first, victim);
+		}
+
+		lock_mutex_exit();
+
+		/* Remove the victim from the graph, and search again
+		from the same root. The nodes that became BLACK cannot
+		reach a cycle, removing a node does not change that. If
+		the cycle was already broken, the victim was probably
+		not the transaction that broke it, but the next round
+		will see that. */
+
+		for (ulint i = 0; i < m_stack.size() - 1; ++i) {
+			m_nodes[m_stack[i].first].m_color = node_t::WHITE;
+		}
+
+		m_nodes[victim].m_color = node_t::BLACK;
+
+		m_stack.clear();
+	}
+}
+
+/** Only used by lock_deadlock_thread, reuses its memory between rounds. */
+static WaitForGraph	lock_wait_for_graph;
+
+/*********************************************************************//**
+Takes a snapshot of the wait-for graph of all suspended transactions,
+searches it for cycles without holding lock_sys->latch, and resolves each
+cycle that still exists in the lock queues by rolling back the transaction
+in it that has the smallest undo log. */
+
+void
+lock_deadlock_check_background(void)
+/*================================*/
+{
+	lock_wait_for_graph.check_and_resolve();
+}
+
 /**
 Allocate cached locks for the transaction.
 @param trx		allocate cached record locks for this transaction */
@@ -259,6 +259,11 @@ lock_wait_suspend_thread(
 
 	os_event_set(lock_sys->timeout_event);
 
+	if (srv_deadlock_detect_background) {
+		/* Let the deadlock detector see this wait */
+		os_event_set(lock_sys->deadlock_event);
+	}
+
 	lock_wait_mutex_exit();
 	trx_mutex_exit(trx);
 
@@ -539,3 +544,63 @@ DECLARE_THREAD(lock_wait_timeout_thread)(
 
 	OS_THREAD_DUMMY_RETURN;
 }
+
+/*********************************************************************//**
+A thread which searches the wait-for graph of the suspended transactions
+for deadlocks, when innodb_deadlock_detect_background is set.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(lock_deadlock_thread)(
+/*=================================*/
+	void*	arg __attribute__((unused)))
+			/* in: a dummy parameter required by
+			os_thread_create */
+{
+	ib_int64_t	sig_count = 0;
+	os_event_t	event = lock_sys->deadlock_event;
+	bool		was_enabled = false;
+
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(srv_lock_deadlock_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	lock_sys->deadlock_thread_active = true;
+
+	do {
+		/* Wake up when a thread is suspended, and every second
+		for the cycles that a resolved deadlock or a change in
+		the lock queues left unnoticed */
+
+		os_event_wait_time_low(event, 1000000, sig_count);
+		sig_count = os_event_reset(event);
+
+		if (srv_shutdown_state >= SRV_SHUTDOWN_CLEANUP) {
+			break;
+		}
+
+		/* Do one more round after the detection has been moved
+		back to the threads that enqueue the lock waits, for the
+		waits that no thread has checked. */
+
+		bool	enabled = srv_deadlock_detect_background;
+
+		if (enabled || was_enabled) {
+			lock_deadlock_check_background();
+		}
+
+		was_enabled = enabled;
+
+	} while (srv_shutdown_state < SRV_SHUTDOWN_CLEANUP);
+
+	lock_sys->deadlock_thread_active = false;
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
@@ -82,6 +82,11 @@ reduce the size of the log.
 /* Global log system variable */
 log_t*	log_sys	= NULL;
 
+#ifdef UNIV_PFS_THREAD
+mysql_pfs_key_t	log_writer_thread_key;
+mysql_pfs_key_t	log_flusher_thread_key;
+#endif /* UNIV_PFS_THREAD */
+
 #ifdef UNIV_DEBUG
 ibool	log_do_write = TRUE;
 #endif /* UNIV_DEBUG */
@@ -147,49 +152,123 @@ log_buf_pool_get_oldest_modification(void)
 /*======================================*/
 {
 	lsn_t	lsn;
+	lsn_t	oldest_lsn;
 
 	ut_ad(mutex_own(&(log_sys->mutex)));
 
-	lsn = buf_pool_get_oldest_modification();
+	/* Read the lsn before looking at the flush lists. A
+	mini-transaction that dirtied a clean page reserves its lsn range
+	and adds the page to the flush list while holding the flush order
+	mutex, so that any such range starting below lsn is visible to
+	buf_pool_get_oldest_modification(). */
+	lsn = log_sys->lsn;
 
-	if (!lsn) {
+	oldest_lsn = buf_pool_get_oldest_modification();
 
-		lsn = log_sys->lsn;
+	if (!oldest_lsn) {
+
+		oldest_lsn = lsn;
 	}
 
-	return(lsn);
+	return(oldest_lsn);
 }
 
 /************************************************************//**
-Opens the log for log_write_low. The log must be closed with log_close and
-released with log_release.
-@return start lsn of the log record */
+Reserves an lsn range for the log records of a mini-transaction, waiting
+for free space in the log buffer if necessary. The range is claimed with
+an atomic update of log_sys->lsn, so several threads can reserve and fill
+their ranges at the same time; the records must then be copied with
+log_buffer_write() and the range published with log_buffer_close().
+@return start lsn of the reserved range */
 
 lsn_t
-log_reserve_and_open(
-/*=================*/
-	ulint	len)	/*!< in: length of data to be catenated */
+log_buffer_reserve(
+/*===============*/
+	ulint	len,		/*!< in: length of the log records */
+	bool	flush_order,	/*!< in: true if the caller dirtied a clean
+				page; the function then returns with
+				log_sys->log_flush_order_mutex held, so that
+				the page can be added to the flush list in
+				lsn order */
+	lsn_t*	end_lsn)	/*!< out: end lsn of the reserved range */
 {
 	log_t*	log			= log_sys;
-	ulint	len_upper_limit;
+	lsn_t	start_lsn;
+	bool	buffer_full		= false;
 #ifdef UNIV_DEBUG
 	ulint	count			= 0;
 #endif /* UNIV_DEBUG */
 
 	ut_a(len < log->buf_size / 2);
+	ut_ad(!recv_no_log_write);
 loop:
+#ifndef os_compare_and_swap_uint64
+	/* Without 64-bit atomics the lsn is updated under the log mutex;
+	the records are still copied without it. */
 	log_mutex_enter();
-	ut_ad(!recv_no_log_write);
+#endif /* !os_compare_and_swap_uint64 */
 
-	/* Calculate an upper limit for the space the string may take in the
-	log buffer */
+	if (flush_order) {
+		log_flush_order_mutex_enter();
+	}
+retry:
+	start_lsn = log->lsn;
+	*end_lsn = start_lsn;
 
-	len_upper_limit = LOG_BUF_WRITE_MARGIN + (5 * len) / 4;
+	if (len > 0) {
+		ulint	rec_len	= len;
 
-	if (log->buf_free + len_upper_limit > log->buf_size) {
+#ifdef UNIV_LOG_LSN_DEBUG
+		/* Room for the LSN pseudo-record written by mtr_commit() */
+		rec_len += 1
+			+ mach_get_compressed_size(start_lsn >> 32)
+			+ mach_get_compressed_size(start_lsn & 0xFFFFFFFFUL);
+#endif /* UNIV_LOG_LSN_DEBUG */
 
-		log_mutex_exit();
+		*end_lsn = recv_calc_lsn_on_data_add(start_lsn, rec_len);
+
+		/* The blocks from the start of the last write to the end
+		of the range must fit in the log buffer. A torn read of
+		written_to_all_lsn or recent_written_lsn on a 32-bit
+		platform can only make these checks fail. */
+
+		buffer_full = ut_uint64_align_up(*end_lsn,
+						 OS_FILE_LOG_BLOCK_SIZE)
+			- ut_uint64_align_down(log->written_to_all_lsn,
+					       OS_FILE_LOG_BLOCK_SIZE)
+			> log->buf_size;
+
+		if (buffer_full
+		    || start_lsn - log->recent_written_lsn
+		    >= LOG_RECENT_WRITTEN_SIZE) {
+
+			goto wait;
+		}
+	}
+
+#ifdef os_compare_and_swap_uint64
+	if (!os_compare_and_swap_uint64(&log->lsn, start_lsn, *end_lsn)) {
+
+		goto retry;
+	}
+#else /* os_compare_and_swap_uint64 */
+	log->lsn = *end_lsn;
+
+	log_mutex_exit();
+#endif /* os_compare_and_swap_uint64 */
+
+	return(start_lsn);
+
+wait:
+	if (flush_order) {
+		log_flush_order_mutex_exit();
+	}
+
+#ifndef os_compare_and_swap_uint64
+	log_mutex_exit();
+#endif /* !os_compare_and_swap_uint64 */
 
+	if (buffer_full) {
 		/* Not enough free space, do a syncronous flush of the log
 		buffer */
 
@@ -198,130 +277,133 @@ loop:
 		srv_stats.log_waits.inc();
 
 		ut_ad(++count < 50);
+	} else {
+		/* Too many ranges before ours are still being copied, or
+		nobody has advanced recent_written_lsn lately */
 
-		goto loop;
+		log_mutex_enter();
+		log_buffer_advance_written();
+		log_mutex_exit();
+
+		os_thread_yield();
 	}
 
-#ifdef UNIV_LOG_DEBUG
-	log->old_buf_free = log->buf_free;
-	log->old_lsn = log->lsn;
-#endif
-	return(log->lsn);
+	goto loop;
 }
 
 /************************************************************//**
-Writes to the log the string given. It is assumed that the caller holds the
-log mutex. */
+Copies log records to the log buffer, into a range reserved with
+log_buffer_reserve(). Does not need the log mutex.
+@return lsn following the copied records */
 
-void
-log_write_low(
-/*==========*/
-	byte*	str,		/*!< in: string */
-	ulint	str_len)	/*!< in: string length */
+lsn_t
+log_buffer_write(
+/*=============*/
+	lsn_t		lsn,		/*!< in: lsn where to copy */
+	const void*	str,		/*!< in: log records */
+	ulint		str_len)	/*!< in: length of the records */
 {
-	log_t*	log	= log_sys;
-	ulint	len;
-	ulint	data_len;
-	byte*	log_block;
+	const byte*	ptr	= static_cast<const byte*>(str);
 
-	ut_ad(mutex_own(&(log->mutex)));
-part_loop:
 	ut_ad(!recv_no_log_write);
-	/* Calculate a part length */
 
-	data_len = (log->buf_free % OS_FILE_LOG_BLOCK_SIZE) + str_len;
+	while (str_len > 0) {
+		byte*	log_block	= log_buffer_get_block(lsn);
+		ulint	offset		= (ulint) (lsn % OS_FILE_LOG_BLOCK_SIZE);
+		ulint	len;
 
-	if (data_len <= OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+		ut_ad(offset >= LOG_BLOCK_HDR_SIZE);
+		ut_ad(offset < OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
 
-		/* The string fits within the current log block */
+		/* Calculate a part length */
 
-		len = str_len;
-	} else {
-		data_len = OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE;
+		len = OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE - offset;
 
-		len = OS_FILE_LOG_BLOCK_SIZE
-			- (log->buf_free % OS_FILE_LOG_BLOCK_SIZE)
-			- LOG_BLOCK_TRL_SIZE;
-	}
-
-	ut_memcpy(log->buf + log->buf_free, str, len);
-
-	str_len -= len;
-	str = str + len;
-
-	log_block = static_cast<byte*>(
-		ut_align_down(
-			log->buf + log->buf_free, OS_FILE_LOG_BLOCK_SIZE));
+		if (len > str_len) {
+			len = str_len;
+		}
 
-	log_block_set_data_len(log_block, data_len);
+		ut_memcpy(log_block + offset, ptr, len);
 
-	if (data_len == OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-		/* This block became full */
-		log_block_set_data_len(log_block, OS_FILE_LOG_BLOCK_SIZE);
-		log_block_set_checkpoint_no(log_block,
-					    log_sys->next_checkpoint_no);
-		len += LOG_BLOCK_HDR_SIZE + LOG_BLOCK_TRL_SIZE;
+		ptr += len;
+		str_len -= len;
+		lsn += len;
 
-		log->lsn += len;
+		if (offset + len == OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+			/* This block became full. Its data length and
+			checkpoint number are set by log_write_up_to(); here
+			we initialize the header of the next block, which
+			belongs to our range. */
 
-		/* Initialize the next block header */
-		log_block_init(log_block + OS_FILE_LOG_BLOCK_SIZE, log->lsn);
-	} else {
-		log->lsn += len;
-	}
+			lsn += LOG_BLOCK_TRL_SIZE + LOG_BLOCK_HDR_SIZE;
 
-	log->buf_free += len;
-
-	ut_ad(log->buf_free <= log->buf_size);
-
-	if (str_len > 0) {
-		goto part_loop;
+			log_block_init(log_buffer_get_block(lsn), lsn);
+		}
 	}
 
 	srv_stats.log_write_requests.inc();
+
+	return(lsn);
 }
 
 /************************************************************//**
-Closes the log.
-@return lsn */
+Publishes a range of the log buffer filled by log_buffer_write(), so that
+log_write_up_to() can write it once all the ranges before it have been
+published too. */
 
-lsn_t
-log_close(void)
-/*===========*/
+void
+log_buffer_close(
+/*=============*/
+	lsn_t	start_lsn,	/*!< in: start lsn of the range */
+	lsn_t	end_lsn)	/*!< in: end lsn of the range */
 {
-	byte*		log_block;
-	ulint		first_rec_group;
-	lsn_t		oldest_lsn;
-	lsn_t		lsn;
-	log_t*		log	= log_sys;
-	lsn_t		checkpoint_age;
+	log_t*	log	= log_sys;
+	lsn_t*	slot;
+	lsn_t	oldest_lsn;
+	lsn_t	checkpoint_age;
 
-	ut_ad(mutex_own(&(log->mutex)));
+	ut_ad(end_lsn > start_lsn);
 	ut_ad(!recv_no_log_write);
 
-	lsn = log->lsn;
-
-	log_block = static_cast<byte*>(
-		ut_align_down(
-			log->buf + log->buf_free, OS_FILE_LOG_BLOCK_SIZE));
-
-	first_rec_group = log_block_get_first_rec_group(log_block);
-
-	if (first_rec_group == 0) {
+	if (ut_uint64_align_down(start_lsn, OS_FILE_LOG_BLOCK_SIZE)
+	    != ut_uint64_align_down(end_lsn, OS_FILE_LOG_BLOCK_SIZE)) {
 		/* We initialized a new log block which was not written
 		full by the current mtr: the next mtr log record group
-		will start within this block at the offset data_len */
+		will start within this block at the end of our range */
 
 		log_block_set_first_rec_group(
-			log_block, log_block_get_data_len(log_block));
+			log_buffer_get_block(end_lsn),
+			(ulint) (end_lsn % OS_FILE_LOG_BLOCK_SIZE));
 	}
 
-	if (log->buf_free > log->max_buf_free) {
+	slot = &log->recent_written[start_lsn % LOG_RECENT_WRITTEN_SIZE];
+
+#ifdef os_compare_and_swap_uint64
+	/* This is a full barrier: the copied records and block headers
+	are visible to whoever follows the link. */
+	bool	published = os_compare_and_swap_uint64(slot, 0, end_lsn);
+
+	ut_a(published);
+#else /* os_compare_and_swap_uint64 */
+	log_mutex_enter();
+
+	ut_a(*slot == 0);
+	*slot = end_lsn;
+
+	log_mutex_exit();
+#endif /* os_compare_and_swap_uint64 */
+
+	/* The checks below read the log fields without the log mutex:
+	they only decide whether log_free_check() should do more work. */
+
+	if (end_lsn - log->written_to_all_lsn > log->max_buf_free) {
 
 		log->check_flush_or_checkpoint = TRUE;
 	}
 
-	checkpoint_age = lsn - log->last_checkpoint_lsn;
+	checkpoint_age = end_lsn - log->last_checkpoint_lsn;
+
+	MONITOR_SET(MONITOR_LSN_CHECKPOINT_AGE, checkpoint_age);
 
 	if (checkpoint_age >= log->log_group_capacity) {
 		/* TODO: split btr_store_big_rec_extern_fields() into small
@@ -350,23 +432,65 @@ log_close(void)
 
 	if (checkpoint_age <= log->max_modified_age_sync) {
 
-		goto function_exit;
+		return;
 	}
 
 	oldest_lsn = buf_pool_get_oldest_modification();
 
 	if (!oldest_lsn
-	    || lsn - oldest_lsn > log->max_modified_age_sync
+	    || end_lsn - oldest_lsn > log->max_modified_age_sync
 	    || checkpoint_age > log->max_checkpoint_age_async) {
 
 		log->check_flush_or_checkpoint = TRUE;
 	}
-function_exit:
+}
 
-#ifdef UNIV_LOG_DEBUG
-	log_check_log_recs(log->buf + log->old_buf_free,
-			   log->buf_free - log->old_buf_free, log->old_lsn);
-#endif
+/************************************************************//**
+Advances log_sys->recent_written_lsn over the contiguous ranges that have
+been published by log_buffer_close(). The caller must own the log mutex.
+@return lsn up to which the log buffer is completely filled */
+
+lsn_t
+log_buffer_advance_written(void)
+/*============================*/
+{
+	log_t*	log	= log_sys;
+	lsn_t	lsn;
+
+	ut_ad(log_mutex_own());
+
+	lsn = log->recent_written_lsn;
+
+	for (;;) {
+		lsn_t*	slot;
+		lsn_t	end_lsn;
+
+		slot = &log->recent_written[lsn % LOG_RECENT_WRITTEN_SIZE];
+		end_lsn = *slot;
+
+		if (end_lsn == 0) {
+
+			break;
+		}
+
+		ut_ad(end_lsn > lsn);
+
+#ifdef os_compare_and_swap_uint64
+		/* Clear the slot with a full barrier: the records of the
+		range are then visible to us, and the slot is seen free by
+		the thread that reserves it after recent_written_lsn has
+		moved past it. */
+		bool	cleared = os_compare_and_swap_uint64(slot, end_lsn, 0);
+
+		ut_a(cleared);
+#else /* os_compare_and_swap_uint64 */
+		*slot = 0;
+#endif /* os_compare_and_swap_uint64 */
+
+		lsn = end_lsn;
+	}
+
+	log->recent_written_lsn = lsn;
 
 	return(lsn);
 }
@@ -655,6 +779,17 @@ log_init(void)
 
 	log_sys->max_buf_free = log_sys->buf_size / LOG_BUF_FLUSH_RATIO
 		- LOG_BUF_FLUSH_MARGIN;
+
+	log_sys->write_buf_ptr = static_cast<byte*>(
+		mem_zalloc(LOG_BUFFER_SIZE + OS_FILE_LOG_BLOCK_SIZE));
+
+	log_sys->write_buf = static_cast<byte*>(
+		ut_align(log_sys->write_buf_ptr, OS_FILE_LOG_BLOCK_SIZE));
+
+	log_sys->recent_written = static_cast<lsn_t*>(
+		mem_zalloc(LOG_RECENT_WRITTEN_SIZE
+			   * sizeof *log_sys->recent_written));
+
 	log_sys->check_flush_or_checkpoint = TRUE;
 	UT_LIST_INIT(log_sys->log_groups, &log_group_t::log_groups);
 
@@ -664,8 +799,6 @@ log_init(void)
 	log_sys->last_printout_time = time(NULL);
 	/*----------------------------*/
 
-	log_sys->buf_next_to_write = 0;
-
 	log_sys->write_lsn = 0;
 	log_sys->current_flush_lsn = 0;
 	log_sys->flushed_to_disk_lsn = 0;
@@ -683,6 +816,14 @@ log_init(void)
 
 	os_event_set(log_sys->one_flushed_event);
 
+	log_sys->writer_event = os_event_create(0);
+	log_sys->flusher_event = os_event_create(0);
+
+	for (ulint i = 0; i < LOG_WAIT_EVENTS; i++) {
+		log_sys->write_events[i] = os_event_create(0);
+		log_sys->flush_events[i] = os_event_create(0);
+	}
+
 	/*----------------------------*/
 
 	log_sys->next_checkpoint_no = 0;
@@ -702,11 +843,12 @@ log_init(void)
 
 	/*----------------------------*/
 
-	log_block_init(log_sys->buf, log_sys->lsn);
-	log_block_set_first_rec_group(log_sys->buf, LOG_BLOCK_HDR_SIZE);
+	log_block_init(log_buffer_get_block(log_sys->lsn), log_sys->lsn);
+	log_block_set_first_rec_group(log_buffer_get_block(log_sys->lsn),
+				      LOG_BLOCK_HDR_SIZE);
 
-	log_sys->buf_free = LOG_BLOCK_HDR_SIZE;
 	log_sys->lsn = LOG_START_LSN + LOG_BLOCK_HDR_SIZE;
+	log_sys->recent_written_lsn = log_sys->lsn;
 
 	MONITOR_SET(MONITOR_LSN_CHECKPOINT_AGE,
 		    log_sys->lsn - log_sys->last_checkpoint_lsn);
@@ -853,32 +995,13 @@ ulint
 log_sys_check_flush_completion(void)
 /*================================*/
 {
-	ulint	move_start;
-	ulint	move_end;
-
 	ut_ad(mutex_own(&(log_sys->mutex)));
 
 	if (log_sys->n_pending_writes == 0) {
 
+		/* The log buffer is a ring: the space before the written
+		lsn becomes free for log_buffer_reserve() */
 		log_sys->written_to_all_lsn = log_sys->write_lsn;
-		log_sys->buf_next_to_write = log_sys->write_end_offset;
-
-		if (log_sys->write_end_offset > log_sys->max_buf_free / 2) {
-			/* Move the log buffer content to the start of the
-			buffer */
-
-			move_start = ut_calc_align_down(
-				log_sys->write_end_offset,
-				OS_FILE_LOG_BLOCK_SIZE);
-			move_end = ut_calc_align(log_sys->buf_free,
-						 OS_FILE_LOG_BLOCK_SIZE);
-
-			ut_memmove(log_sys->buf, log_sys->buf + move_start,
-				   move_end - move_start);
-			log_sys->buf_free -= move_start;
-
-			log_sys->buf_next_to_write -= move_start;
-		}
 
 		return(LOG_UNLOCK_FLUSH_LOCK);
 	}
@@ -1122,11 +1245,277 @@ loop:
 	}
 }
 
+/******************************************************//**
+Starts a write of the log buffer up to end_lsn to the log groups. The
+caller must own the log mutex, and no other write may be running. The
+write must be completed with log_write_complete(). */
+static
+void
+log_write_low(
+/*==========*/
+	lsn_t	end_lsn,	/*!< in: end of the write; the log
+				buffer must be completely filled up
+				to this lsn */
+	bool	flush_to_disk)	/*!< in: true if the write will be
+				followed by a flush to disk */
+{
+	log_group_t*	group;
+	lsn_t		start_lsn;
+	lsn_t		area_start;
+	lsn_t		area_end;
+	ulint		area_len;
+	ulint		offset;
+	ulint		n;
+	ulint		i;
+
+	ut_ad(log_mutex_own());
+	ut_ad(log_sys->n_pending_writes == 0);
+	ut_ad(end_lsn <= log_sys->recent_written_lsn);
+
+	start_lsn = log_sys->written_to_all_lsn;
+
+	DBUG_PRINT("ib_log", ("write " LSN_PF " to " LSN_PF,
+			      start_lsn, end_lsn));
+	log_sys->n_pending_writes++;
+	MONITOR_INC(MONITOR_PENDING_LOG_WRITE);
+
+	group = UT_LIST_GET_FIRST(log_sys->log_groups);
+	group->n_pending_writes++;	/*!< We assume here that we have only
+					one log group! */
+
+	os_event_reset(log_sys->no_flush_event);
+	os_event_reset(log_sys->one_flushed_event);
+
+	area_start = ut_uint64_align_down(start_lsn, OS_FILE_LOG_BLOCK_SIZE);
+	area_end = ut_uint64_align_up(end_lsn, OS_FILE_LOG_BLOCK_SIZE);
+
+	ut_ad(area_end - area_start > 0);
+	ut_ad(area_end - area_start <= log_sys->buf_size);
+
+	area_len = (ulint) (area_end - area_start);
+
+	log_sys->write_lsn = end_lsn;
+
+	if (flush_to_disk) {
+		log_sys->current_flush_lsn = end_lsn;
+	}
+
+	log_sys->one_flushed = FALSE;
+
+	/* Copy the blocks to the write buffer, so that the write is not
+	changed by the threads copying log records past end_lsn into the
+	last block, and so that a range wrapping around the end of the
+	log buffer is written with one i/o */
+
+	offset = (ulint) (area_start % log_sys->buf_size);
+	n = ut_min(area_len, log_sys->buf_size - offset);
+
+	ut_memcpy(log_sys->write_buf, log_sys->buf + offset, n);
+
+	if (n < area_len) {
+		ut_memcpy(log_sys->write_buf + n, log_sys->buf, area_len - n);
+	}
+
+	/* The threads that filled the blocks have only initialized the
+	block headers: a block can be filled before its header is
+	initialized, so we set the data lengths here. */
+
+	for (i = 0; i < area_len; i += OS_FILE_LOG_BLOCK_SIZE) {
+		byte*	log_block = log_sys->write_buf + i;
+
+		log_block_set_data_len(
+			log_block,
+			i + OS_FILE_LOG_BLOCK_SIZE < area_len
+			? OS_FILE_LOG_BLOCK_SIZE
+			: (ulint) (end_lsn % OS_FILE_LOG_BLOCK_SIZE));
+		log_block_set_checkpoint_no(
+			log_block, log_sys->next_checkpoint_no);
+	}
+
+	log_block_set_flush_bit(log_sys->write_buf, TRUE);
+
+#ifdef UNIV_LOG_DEBUG
+	log_check_log_recs(log_sys->write_buf + (start_lsn - area_start),
+			   (ulint) (end_lsn - start_lsn), start_lsn);
+#endif /* UNIV_LOG_DEBUG */
+
+	/* Do the write to the log files */
+
+	while (group) {
+		log_group_write_buf(
+			group, log_sys->write_buf, area_len, area_start,
+			(ulint) (start_lsn - area_start));
+
+		log_group_set_fields(group, log_sys->write_lsn);
+
+		group = UT_LIST_GET_NEXT(log_groups, group);
+	}
+}
+
+/******************************************************//**
+Completes a write started with log_write_low(), after the possible flush
+to disk. The caller must own the log mutex. */
+static
+void
+log_write_complete(void)
+/*====================*/
+{
+	log_group_t*	group;
+	ulint		unlock;
+
+	ut_ad(log_mutex_own());
+
+	group = UT_LIST_GET_FIRST(log_sys->log_groups);
+
+	ut_a(group->n_pending_writes == 1);
+	ut_a(log_sys->n_pending_writes == 1);
+
+	group->n_pending_writes--;
+	log_sys->n_pending_writes--;
+	MONITOR_DEC(MONITOR_PENDING_LOG_WRITE);
+
+	unlock = log_group_check_flush_completion(group);
+	unlock = unlock | log_sys_check_flush_completion();
+
+	log_flush_do_unlocks(unlock);
+}
+
+/******************************************************//**
+Raises a requested lsn of the log writer or flusher to at least lsn. */
+static
+void
+log_request_lsn(
+/*============*/
+	lsn_t*	requested_lsn,	/*!< in/out: write_requested_lsn or
+				flush_requested_lsn of log_sys */
+	lsn_t	lsn)		/*!< in: lsn to request */
+{
+#ifdef os_compare_and_swap_uint64
+	for (lsn_t old_lsn = *requested_lsn;
+	     old_lsn < lsn
+	     && !os_compare_and_swap_uint64(requested_lsn, old_lsn, lsn);
+	     old_lsn = *requested_lsn) {
+	}
+#else /* os_compare_and_swap_uint64 */
+	log_mutex_enter();
+
+	if (*requested_lsn < lsn) {
+		*requested_lsn = lsn;
+	}
+
+	log_mutex_exit();
+#endif /* os_compare_and_swap_uint64 */
+}
+
+/******************************************************//**
+Sets the wait events of the log blocks between two lsns, after the log
+writer or flusher has advanced its lsn from old_lsn to new_lsn. */
+static
+void
+log_wait_events_set(
+/*================*/
+	os_event_t*	events,		/*!< in: write_events or
+					flush_events of log_sys */
+	lsn_t		old_lsn,	/*!< in: previous lsn */
+	lsn_t		new_lsn)	/*!< in: new lsn */
+{
+	lsn_t	first = old_lsn / OS_FILE_LOG_BLOCK_SIZE;
+	lsn_t	last = new_lsn / OS_FILE_LOG_BLOCK_SIZE;
+
+	for (lsn_t i = first; i <= last && i - first < LOG_WAIT_EVENTS; i++) {
+		os_event_set(events[i % LOG_WAIT_EVENTS]);
+	}
+}
+
+/******************************************************//**
+Requests a log write or flush from the log writer threads, and waits for
+it unless wait is LOG_NO_WAIT. A waiting thread first spins, if the recent
+writes or flushes have been fast, and then waits for the event of the log
+block of lsn.
+@return false if the log writer threads exited before completing the
+request, in which case the caller must write the log itself */
+static
+bool
+log_wait_for_writer_threads(
+/*========================*/
+	lsn_t	lsn,		/*!< in: lsn up to which the log should
+				be written */
+	ulint	wait,		/*!< in: LOG_NO_WAIT, LOG_WAIT_ONE_GROUP,
+				or LOG_WAIT_ALL_GROUPS */
+	bool	flush_to_disk)	/*!< in: true if the log should also be
+				flushed to disk */
+{
+	const lsn_t*	done_lsn;
+	os_event_t	event;
+	ulint		avg_time;
+
+	if (flush_to_disk) {
+		done_lsn = &log_sys->flushed_to_disk_lsn;
+		event = log_sys->flush_events[
+			(lsn / OS_FILE_LOG_BLOCK_SIZE) % LOG_WAIT_EVENTS];
+		avg_time = log_sys->write_avg_time + log_sys->flush_avg_time;
+	} else {
+		done_lsn = &log_sys->written_to_all_lsn;
+		event = log_sys->write_events[
+			(lsn / OS_FILE_LOG_BLOCK_SIZE) % LOG_WAIT_EVENTS];
+		avg_time = log_sys->write_avg_time;
+	}
+
+	if (*done_lsn >= lsn) {
+		return(true);
+	}
+
+	log_request_lsn(&log_sys->write_requested_lsn, lsn);
+
+	os_event_set(log_sys->writer_event);
+
+	if (flush_to_disk) {
+		/* The log may already have been written: then only the
+		log flusher has work to do */
+
+		log_request_lsn(&log_sys->flush_requested_lsn, lsn);
+
+		os_event_set(log_sys->flusher_event);
+	}
+
+	if (wait == LOG_NO_WAIT) {
+		return(true);
+	}
+
+	if (avg_time < LOG_WAIT_SPIN_MAX_AVG_TIME) {
+		for (ulint i = 0;
+		     i < srv_log_wait_spin_rounds && *done_lsn < lsn;
+		     i++) {
+
+			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+		}
+	}
+
+	while (*done_lsn < lsn) {
+		ib_int64_t	sig_count = os_event_reset(event);
+
+		if (*done_lsn >= lsn) {
+			break;
+		}
+
+		if (!log_sys->writer_threads) {
+			/* log_stop_writer_threads() sets all the events
+			after clearing writer_threads */
+			return(false);
+		}
+
+		os_event_wait_low(event, sig_count);
+	}
+
+	return(true);
+}
+
 /******************************************************//**
 This function is called, e.g., when a transaction wants to commit. It checks
 that the log has been written to the log file up to the last log entry written
-by the transaction. If there is a flush running, it waits and checks if the
-flush flushed enough. If not, starts a new flush. */
+by the transaction. If the log writer threads are running, it requests the
+write from them and waits for it. Otherwise, if there is a flush running, it
+waits and checks if the flush flushed enough. If not, starts a new flush. */
 
 void
 log_write_up_to(
@@ -1141,14 +1530,10 @@ log_write_up_to(
 			also to be flushed to disk */
 {
 	log_group_t*	group;
-	ulint		start_offset;
-	ulint		end_offset;
-	ulint		area_start;
-	ulint		area_end;
+	lsn_t		end_lsn;
 #ifdef UNIV_DEBUG
 	ulint		loop_count	= 0;
 #endif /* UNIV_DEBUG */
-	ulint		unlock;
 
 	ut_ad(!srv_read_only_mode);
 
@@ -1159,6 +1544,12 @@ log_write_up_to(
 		return;
 	}
 
+	if (log_sys->writer_threads
+	    && log_wait_for_writer_threads(ut_min(lsn, log_sys->lsn), wait,
+					   flush_to_disk)) {
+		return;
+	}
+
 loop:
 #ifdef UNIV_DEBUG
 	loop_count++;
@@ -1166,6 +1557,7 @@ loop:
 	ut_ad(loop_count < 128);
 #endif /* UNUV_DEBUG */
 
+retry:
 	log_mutex_enter();
 	ut_ad(!recv_no_log_write);
 
@@ -1216,77 +1608,31 @@ loop:
 		goto loop;
 	}
 
-	if (!flush_to_disk
-	    && log_sys->buf_free == log_sys->buf_next_to_write) {
-		/* Nothing to write and no flush to disk requested */
-
-		log_mutex_exit();
-
-		return;
-	}
-
-	DBUG_PRINT("ib_log", ("write " LSN_PF " to " LSN_PF,
-			      log_sys->written_to_all_lsn,
-			      log_sys->lsn));
-	log_sys->n_pending_writes++;
-	MONITOR_INC(MONITOR_PENDING_LOG_WRITE);
-
-	group = UT_LIST_GET_FIRST(log_sys->log_groups);
-	group->n_pending_writes++;	/*!< We assume here that we have only
-					one log group! */
-
-	os_event_reset(log_sys->no_flush_event);
-	os_event_reset(log_sys->one_flushed_event);
-
-	start_offset = log_sys->buf_next_to_write;
-	end_offset = log_sys->buf_free;
+	end_lsn = log_buffer_advance_written();
 
-	area_start = ut_calc_align_down(start_offset, OS_FILE_LOG_BLOCK_SIZE);
-	area_end = ut_calc_align(end_offset, OS_FILE_LOG_BLOCK_SIZE);
+	if (end_lsn < lsn && end_lsn < log_sys->lsn) {
+		/* Some mini-transactions are still copying log records
+		that we have to write: wait for them. They hold no latch
+		that we could be waiting for. */
 
-	ut_ad(area_end - area_start > 0);
+		log_mutex_exit();
 
-	log_sys->write_lsn = log_sys->lsn;
+		os_thread_yield();
 
-	if (flush_to_disk) {
-		log_sys->current_flush_lsn = log_sys->lsn;
+		goto retry;
 	}
 
-	log_sys->one_flushed = FALSE;
-
-	log_block_set_flush_bit(log_sys->buf + area_start, TRUE);
-	log_block_set_checkpoint_no(
-		log_sys->buf + area_end - OS_FILE_LOG_BLOCK_SIZE,
-		log_sys->next_checkpoint_no);
-
-	/* Copy the last, incompletely written, log block a log block length
-	up, so that when the flush operation writes from the log buffer, the
-	segment to write will not be changed by writers to the log */
-
-	ut_memcpy(log_sys->buf + area_end,
-		  log_sys->buf + area_end - OS_FILE_LOG_BLOCK_SIZE,
-		  OS_FILE_LOG_BLOCK_SIZE);
-
-	log_sys->buf_free += OS_FILE_LOG_BLOCK_SIZE;
-	log_sys->write_end_offset = log_sys->buf_free;
-
-	group = UT_LIST_GET_FIRST(log_sys->log_groups);
-
-	/* Do the write to the log files */
-
-	while (group) {
-		log_group_write_buf(
-			group, log_sys->buf + area_start,
-			area_end - area_start,
-			ut_uint64_align_down(log_sys->written_to_all_lsn,
-					     OS_FILE_LOG_BLOCK_SIZE),
-			start_offset - area_start);
+	if (!flush_to_disk
+	    && end_lsn == log_sys->written_to_all_lsn) {
+		/* Nothing to write and no flush to disk requested */
 
-		log_group_set_fields(group, log_sys->write_lsn);
+		log_mutex_exit();
 
-		group = UT_LIST_GET_NEXT(log_groups, group);
+		return;
 	}
 
+	log_write_low(end_lsn, flush_to_disk);
+
 	log_mutex_exit();
 
 	if (srv_unix_file_flush_method == SRV_UNIX_O_DSYNC) {
@@ -1305,19 +1651,7 @@ loop:
 
 	log_mutex_enter();
 
-	group = UT_LIST_GET_FIRST(log_sys->log_groups);
-
-	ut_a(group->n_pending_writes == 1);
-	ut_a(log_sys->n_pending_writes == 1);
-
-	group->n_pending_writes--;
-	log_sys->n_pending_writes--;
-	MONITOR_DEC(MONITOR_PENDING_LOG_WRITE);
-
-	unlock = log_group_check_flush_completion(group);
-	unlock = unlock | log_sys_check_flush_completion();
-
-	log_flush_do_unlocks(unlock);
+	log_write_complete();
 
 	log_mutex_exit();
 
@@ -1342,6 +1676,273 @@ do_waits:
 	}
 }
 
+/******************************************************************//**
+The log writer thread. It writes to the log files everything that has
+been copied to the log buffer whenever log_write_up_to() has requested a
+write that is not yet done, so that the writes of concurrent commits are
+batched regardless of which thread requested first.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(log_writer_thread)(
+/*==============================*/
+	void*	arg __attribute__((unused)))
+			/*!< in: a dummy parameter required by
+			os_thread_create */
+{
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(log_writer_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "InnoDB: log_writer thread running, id %lu\n",
+		os_thread_pf(os_thread_get_curr_id()));
+#endif /* UNIV_DEBUG_THREAD_CREATION */
+
+	for (;;) {
+		ib_int64_t	sig_count;
+		lsn_t		old_lsn;
+		lsn_t		end_lsn;
+		ullint		start_time;
+		ullint		end_time;
+
+		sig_count = os_event_reset(log_sys->writer_event);
+
+		log_mutex_enter();
+
+		old_lsn = log_sys->written_to_all_lsn;
+
+		if (log_sys->write_requested_lsn <= old_lsn) {
+			bool	exit = log_sys->writer_threads_exit;
+
+			log_mutex_exit();
+
+			if (exit) {
+				break;
+			}
+
+			os_event_wait_low(log_sys->writer_event, sig_count);
+
+			continue;
+		}
+
+		end_lsn = log_buffer_advance_written();
+
+		if (end_lsn == old_lsn) {
+			/* Some mini-transactions are still copying the
+			log records that were requested */
+
+			log_mutex_exit();
+
+			os_thread_yield();
+
+			continue;
+		}
+
+		ut_time_us(&start_time);
+
+		log_write_low(end_lsn, false);
+
+		if (srv_unix_file_flush_method == SRV_UNIX_O_DSYNC) {
+			/* The write also flushed the log to disk */
+
+			log_sys->flushed_to_disk_lsn = end_lsn;
+		}
+
+		log_write_complete();
+
+		log_mutex_exit();
+
+		ut_time_us(&end_time);
+
+		log_sys->write_avg_time = (ulint)
+			((log_sys->write_avg_time * 7
+			  + (end_time - start_time)) / 8);
+
+		log_wait_events_set(log_sys->write_events, old_lsn, end_lsn);
+
+		if (srv_unix_file_flush_method == SRV_UNIX_O_DSYNC) {
+
+			log_wait_events_set(
+				log_sys->flush_events, old_lsn, end_lsn);
+
+		} else if (log_sys->flush_requested_lsn
+			   > log_sys->flushed_to_disk_lsn) {
+
+			os_event_set(log_sys->flusher_event);
+		}
+	}
+
+	log_mutex_enter();
+	log_sys->n_writer_threads--;
+	log_mutex_exit();
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/******************************************************************//**
+The log flusher thread. It flushes the log files to disk up to what the
+log writer has written whenever log_write_up_to() has requested a flush
+that is not yet done, while the log writer may already write the next
+batch.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(log_flusher_thread)(
+/*===============================*/
+	void*	arg __attribute__((unused)))
+			/*!< in: a dummy parameter required by
+			os_thread_create */
+{
+	ut_ad(!srv_read_only_mode);
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(log_flusher_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "InnoDB: log_flusher thread running, id %lu\n",
+		os_thread_pf(os_thread_get_curr_id()));
+#endif /* UNIV_DEBUG_THREAD_CREATION */
+
+	for (;;) {
+		ib_int64_t	sig_count;
+		log_group_t*	group;
+		lsn_t		old_lsn;
+		lsn_t		lsn;
+		ullint		start_time;
+		ullint		end_time;
+
+		sig_count = os_event_reset(log_sys->flusher_event);
+
+		log_mutex_enter();
+
+		group = UT_LIST_GET_FIRST(log_sys->log_groups);
+		old_lsn = log_sys->flushed_to_disk_lsn;
+		lsn = log_sys->written_to_all_lsn;
+
+		if (srv_unix_file_flush_method == SRV_UNIX_O_DSYNC
+		    || log_sys->flush_requested_lsn <= old_lsn
+		    || lsn == old_lsn) {
+			/* Nothing to flush, or the log writer has not yet
+			written what was requested; it will wake us up */
+
+			bool	exit = log_sys->writer_threads_exit;
+
+			log_mutex_exit();
+
+			if (exit) {
+				break;
+			}
+
+			os_event_wait_low(log_sys->flusher_event, sig_count);
+
+			continue;
+		}
+
+		log_mutex_exit();
+
+		ut_time_us(&start_time);
+
+		fil_flush(group->space_id);
+
+		ut_time_us(&end_time);
+
+		log_sys->flushed_to_disk_lsn = lsn;
+
+		log_sys->flush_avg_time = (ulint)
+			((log_sys->flush_avg_time * 7
+			  + (end_time - start_time)) / 8);
+
+		log_wait_events_set(log_sys->flush_events, old_lsn, lsn);
+	}
+
+	log_mutex_enter();
+	log_sys->n_writer_threads--;
+	log_mutex_exit();
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/****************************************************************//**
+Starts the log writer and log flusher threads. From then on only these
+threads write and flush the log, and log_write_up_to() requests the write
+or flush from them and waits for it. */
+
+void
+log_start_writer_threads(void)
+/*==========================*/
+{
+	ut_ad(!srv_read_only_mode);
+
+	log_mutex_enter();
+
+	ut_ad(!log_sys->writer_threads);
+	ut_ad(log_sys->n_writer_threads == 0);
+
+	log_sys->write_requested_lsn = log_sys->written_to_all_lsn;
+	log_sys->flush_requested_lsn = log_sys->flushed_to_disk_lsn;
+	log_sys->writer_threads_exit = false;
+	log_sys->n_writer_threads = 2;
+	log_sys->writer_threads = true;
+
+	log_mutex_exit();
+
+	os_thread_create(log_writer_thread, NULL, NULL);
+	os_thread_create(log_flusher_thread, NULL, NULL);
+}
+
+/****************************************************************//**
+Makes the log writer and log flusher threads exit and waits for them.
+From then on log_write_up_to() writes and flushes the log itself. Does
+nothing if the threads were not started. */
+
+void
+log_stop_writer_threads(void)
+/*=========================*/
+{
+	ulint	n_threads;
+
+	if (log_sys == NULL || !log_sys->writer_threads) {
+		return;
+	}
+
+	log_sys->writer_threads_exit = true;
+
+	do {
+		os_event_set(log_sys->writer_event);
+		os_event_set(log_sys->flusher_event);
+
+		log_mutex_enter();
+		n_threads = log_sys->n_writer_threads;
+		log_mutex_exit();
+
+		if (n_threads > 0) {
+			os_thread_sleep(10000);
+		}
+	} while (n_threads > 0);
+
+	log_sys->writer_threads = false;
+
+	/* Wake up the threads whose requests came too late for the log
+	writer threads: they will do the write themselves */
+
+	for (ulint i = 0; i < LOG_WAIT_EVENTS; i++) {
+		os_event_set(log_sys->write_events[i]);
+		os_event_set(log_sys->flush_events[i]);
+	}
+}
+
 /****************************************************************//**
 Does a syncronous flush of the log buffer to disk. */
 
@@ -1397,7 +1998,7 @@ log_flush_margin(void)
 
 	log_mutex_enter();
 
-	if (log->buf_free > log->max_buf_free) {
+	if (log->lsn - log->written_to_all_lsn > log->max_buf_free) {
 
 		if (log->n_pending_writes > 0) {
 			/* A flush is running: hope that it will provide enough
@@ -2156,6 +2757,10 @@ loop:
 		}
 	}
 
+	/* The rest of the shutdown writes and flushes the log in this
+	thread */
+	log_stop_writer_threads();
+
 	log_mutex_enter();
 	server_busy = log_sys->n_pending_checkpoint_writes
 		      || log_sys->n_pending_writes;
@@ -2319,15 +2924,15 @@ loop:
 
 #ifdef UNIV_LOG_DEBUG
 /******************************************************//**
-Checks by parsing that the catenated log segment for a single mtr is
-consistent. */
+Checks by parsing that a log segment about to be written to the log files
+is consistent. */
 
 ibool
 log_check_log_recs(
 /*===============*/
 	const byte*	buf,		/*!< in: pointer to the start of
-					the log segment in the
-					log_sys->buf log buffer */
+					the log segment in
+					log_sys->write_buf */
 	ulint		len,		/*!< in: segment length in bytes */
 	ib_uint64_t	buf_start_lsn)	/*!< in: buffer start lsn */
 {
@@ -2501,12 +3106,24 @@ log_shutdown(void)
 	mem_free(log_sys->buf_ptr);
 	log_sys->buf_ptr = NULL;
 	log_sys->buf = NULL;
+	mem_free(log_sys->write_buf_ptr);
+	log_sys->write_buf_ptr = NULL;
+	log_sys->write_buf = NULL;
+	mem_free(log_sys->recent_written);
+	log_sys->recent_written = NULL;
 	mem_free(log_sys->checkpoint_buf_ptr);
 	log_sys->checkpoint_buf_ptr = NULL;
 	log_sys->checkpoint_buf = NULL;
 
 	os_event_destroy(log_sys->no_flush_event);
 	os_event_destroy(log_sys->one_flushed_event);
+	os_event_destroy(log_sys->writer_event);
+	os_event_destroy(log_sys->flusher_event);
+
+	for (ulint i = 0; i < LOG_WAIT_EVENTS; i++) {
+		os_event_destroy(log_sys->write_events[i]);
+		os_event_destroy(log_sys->flush_events[i]);
+	}
 
 	rw_lock_free(&log_sys->checkpoint_lock);
 
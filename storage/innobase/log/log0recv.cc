@@ -67,6 +67,13 @@ this must be less than UNIV_PAGE_SIZE as it is stored in the buffer pool */
 /** Read-ahead area in applying log records to file pages */
 #define RECV_READ_AHEAD_AREA	32
 
+/** Number of read-ahead areas that a recv_apply_thread keeps reading while
+it applies log records to the pages of the oldest one */
+#define RECV_APPLY_READ_AHEAD	4
+
+/** Interval in seconds between progress reports of an apply batch */
+#define RECV_PROGRESS_INTERVAL	10
+
 /** The recovery system */
 recv_sys_t*	recv_sys = NULL;
 /** TRUE when applying redo log records during crash recovery; FALSE
@@ -154,6 +161,7 @@ mysql_pfs_key_t	trx_rollback_clean_thread_key;
 #ifndef UNIV_HOTBACKUP
 # ifdef UNIV_PFS_THREAD
 mysql_pfs_key_t	recv_writer_thread_key;
+mysql_pfs_key_t	recv_apply_thread_key;
 # endif /* UNIV_PFS_THREAD */
 
 /** Flag indicating if recv_writer thread is active. */
@@ -392,6 +400,10 @@ recv_sys_init(
 
 	recv_sys->apply_log_recs = FALSE;
 	recv_sys->apply_batch_on = FALSE;
+#ifndef UNIV_HOTBACKUP
+	recv_sys->n_apply_threads = 0;
+	recv_sys->n_apply_threads_active = 0;
+#endif /* !UNIV_HOTBACKUP */
 
 	recv_sys->last_block_buf_start = static_cast<byte*>(
 		mem_alloc(2 * OS_FILE_LOG_BLOCK_SIZE));
@@ -1386,6 +1398,23 @@ recv_recover_page_func(
 		return;
 	}
 
+#ifndef UNIV_HOTBACKUP
+	if (just_read_in && recv_sys->n_apply_threads > 0
+	    && recv_no_ibuf_operations) {
+
+		/* The recv_apply_thread that reads the page applies the
+		log records once the read has completed. If ibuf
+		operations are allowed, the log records are applied
+		here, because buf_page_io_complete() merges the buffered
+		changes to the page next, and the merge must not raise
+		the page lsn above log records that are not applied. */
+
+		mutex_exit(&(recv_sys->mutex));
+
+		return;
+	}
+#endif /* !UNIV_HOTBACKUP */
+
 	recv_addr = recv_get_fil_addr_struct(buf_block_get_space(block),
 					     buf_block_get_page_no(block));
 
@@ -1576,7 +1605,8 @@ recv_recover_page_func(
 #ifndef UNIV_HOTBACKUP
 /*******************************************************************//**
 Reads in pages which have hashed log records, from an area around a given
-page number.
+page number. The reads are posted together, and the log records are
+applied to the pages by the caller.
 @return number of pages found */
 static
 ulint
@@ -1584,10 +1614,11 @@ recv_read_in_area(
 /*==============*/
 	ulint	space,	/*!< in: space */
 	ulint	zip_size,/*!< in: compressed page size in bytes, or 0 */
-	ulint	page_no)/*!< in: page number */
+	ulint	page_no,/*!< in: page number */
+	ulint*	page_nos)/*!< out: RECV_READ_AHEAD_AREA elements, the
+			pages that are being read */
 {
 	recv_addr_t* recv_addr;
-	ulint	page_nos[RECV_READ_AHEAD_AREA];
 	ulint	low_limit;
 	ulint	n;
 
@@ -1622,9 +1653,168 @@ recv_read_in_area(
 	return(n);
 }
 
+/*******************************************************************//**
+Applies the hashed log records to a page, reading it in if necessary. */
+static
+void
+recv_apply_page(
+/*============*/
+	ulint	space,	/*!< in: space */
+	ulint	zip_size,/*!< in: compressed page size in bytes, or 0 */
+	ulint	page_no)/*!< in: page number */
+{
+	buf_block_t*	block;
+	mtr_t		mtr;
+
+	mtr_start(&mtr);
+
+	block = buf_page_get(space, zip_size, page_no, RW_X_LATCH, &mtr);
+	buf_block_dbg_add_level(block, SYNC_NO_ORDER_CHECK);
+
+	recv_recover_page(FALSE, block);
+
+	mtr_commit(&mtr);
+}
+
+/*******************************************************************//**
+Returns the recv_apply_thread that applies the log records of a page. All
+the pages of a read-ahead area go to the same thread.
+@return thread number, less than recv_sys->n_apply_threads */
+UNIV_INLINE
+ulint
+recv_apply_thread_no(
+/*=================*/
+	const recv_addr_t*	recv_addr)	/*!< in: page file address */
+{
+	return(ut_fold_ulint_pair(recv_addr->space,
+				  recv_addr->page_no / RECV_READ_AHEAD_AREA)
+	       % recv_sys->n_apply_threads);
+}
+
+/** A page whose log records a recv_apply_thread applies after reading it */
+struct recv_apply_page_t {
+	ulint	space;		/*!< space id */
+	ulint	zip_size;	/*!< compressed page size, or 0 */
+	ulint	page_no;	/*!< page number */
+};
+
+/*******************************************************************//**
+A thread applying a batch of log records to the pages in its partition of
+the hash table. Pages that are not in the buffer pool are read in by
+read-ahead areas, and the thread keeps RECV_APPLY_READ_AHEAD areas being
+read while it applies the log records to the pages of the oldest one. In a
+batch that allows ibuf operations, the i/o handler threads apply the log
+records to the pages that they read in, see recv_recover_page_func().
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(recv_apply_thread)(
+/*==============================*/
+	void*	arg)	/*!< in: pointer to the thread number */
+{
+	ulint			thread_no = *static_cast<ulint*>(arg);
+	recv_apply_page_t	pages[RECV_APPLY_READ_AHEAD
+				      * RECV_READ_AHEAD_AREA];
+	ulint			first = 0;
+	ulint			n_pages = 0;
+	ulint			i;
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(recv_apply_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
+
+		for (recv_addr_t* recv_addr = static_cast<recv_addr_t*>(
+				HASH_GET_FIRST(recv_sys->addr_hash, i));
+		     recv_addr != 0;
+		     recv_addr = static_cast<recv_addr_t*>(
+				HASH_GET_NEXT(addr_hash, recv_addr))) {
+
+			ulint	space = recv_addr->space;
+			ulint	page_no = recv_addr->page_no;
+			ulint	zip_size;
+			ulint	page_nos[RECV_READ_AHEAD_AREA];
+			ulint	n;
+			bool	not_processed;
+
+			if (recv_apply_thread_no(recv_addr) != thread_no) {
+				continue;
+			}
+
+			mutex_enter(&recv_sys->mutex);
+			not_processed = recv_addr->state == RECV_NOT_PROCESSED;
+			mutex_exit(&recv_sys->mutex);
+
+			if (!not_processed) {
+				continue;
+			}
+
+			zip_size = fil_space_get_zip_size(space);
+
+			if (zip_size == ULINT_UNDEFINED) {
+				/* The tablespace does not exist */
+				continue;
+			}
+
+			if (buf_page_peek(space, page_no)) {
+				recv_apply_page(space, zip_size, page_no);
+				continue;
+			}
+
+			/* Make room for another read-ahead area */
+
+			while (n_pages > UT_ARR_SIZE(pages)
+			       - RECV_READ_AHEAD_AREA) {
+
+				const recv_apply_page_t* page = &pages[first];
+
+				recv_apply_page(page->space, page->zip_size,
+						page->page_no);
+
+				first = (first + 1) % UT_ARR_SIZE(pages);
+				n_pages--;
+			}
+
+			n = recv_read_in_area(space, zip_size, page_no,
+					      page_nos);
+
+			for (ulint j = 0; j < n; j++) {
+				recv_apply_page_t* page = &pages[
+					(first + n_pages) % UT_ARR_SIZE(pages)];
+
+				page->space = space;
+				page->zip_size = zip_size;
+				page->page_no = page_nos[j];
+				n_pages++;
+			}
+		}
+	}
+
+	for (; n_pages > 0; n_pages--) {
+		const recv_apply_page_t* page = &pages[first];
+
+		recv_apply_page(page->space, page->zip_size, page->page_no);
+
+		first = (first + 1) % UT_ARR_SIZE(pages);
+	}
+
+	mutex_enter(&recv_sys->mutex);
+	recv_sys->n_apply_threads_active--;
+	mutex_exit(&recv_sys->mutex);
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
 /*******************************************************************//**
 Empties the hash table of stored log records, applying them to appropriate
-pages. */
+pages. The pages are partitioned by read-ahead area between
+srv_n_recovery_threads recv_apply_thread, and this thread reports the
+progress in the error log. */
 
 void
 recv_apply_hashed_log_recs(
@@ -1639,10 +1829,13 @@ recv_apply_hashed_log_recs(
 				the caller must in this case own the log
 				mutex */
 {
-	recv_addr_t* recv_addr;
-	ulint	i;
-	ibool	has_printed	= FALSE;
-	mtr_t	mtr;
+	ulint		thread_nos[RECV_MAX_APPLY_THREADS];
+	ulint		n_threads;
+	ulint		n_pages;
+	ulint		n_active;
+	ib_time_t	start_time = 0;
+	ib_time_t	last_report_time;
+	ulint		i;
 loop:
 	mutex_enter(&(recv_sys->mutex));
 
@@ -1664,62 +1857,68 @@ loop:
 	recv_sys->apply_log_recs = TRUE;
 	recv_sys->apply_batch_on = TRUE;
 
-	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
+	n_pages = recv_sys->n_addrs;
 
-		for (recv_addr = static_cast<recv_addr_t*>(
-				HASH_GET_FIRST(recv_sys->addr_hash, i));
-		     recv_addr != 0;
-		     recv_addr = static_cast<recv_addr_t*>(
-				HASH_GET_NEXT(addr_hash, recv_addr))) {
+	if (n_pages > 0) {
+		n_threads = ut_min(srv_n_recovery_threads,
+				   ulint(RECV_MAX_APPLY_THREADS));
+		n_threads = ut_max(n_threads, ulint(1));
 
-			ulint	space = recv_addr->space;
-			ulint	zip_size = fil_space_get_zip_size(space);
-			ulint	page_no = recv_addr->page_no;
+		ib_logf(IB_LOG_LEVEL_INFO,
+			"Starting an apply batch of log records"
+			" to %lu pages of the database,"
+			" using %lu threads...",
+			(ulong) n_pages, (ulong) n_threads);
 
-			if (recv_addr->state == RECV_NOT_PROCESSED) {
-				if (!has_printed) {
-					ib_logf(IB_LOG_LEVEL_INFO,
-						"Starting an apply batch"
-						" of log records"
-						" to the database...");
-					fputs("InnoDB: Progress in percent: ",
-					      stderr);
-					has_printed = TRUE;
-				}
+		recv_sys->n_apply_threads = n_threads;
+		recv_sys->n_apply_threads_active = n_threads;
+
+		mutex_exit(&(recv_sys->mutex));
 
-				mutex_exit(&(recv_sys->mutex));
+		for (i = 0; i < n_threads; i++) {
+			thread_nos[i] = i;
+			os_thread_create(recv_apply_thread, &thread_nos[i],
+					 NULL);
+		}
 
-				if (buf_page_peek(space, page_no)) {
-					buf_block_t*	block;
+		start_time = last_report_time = ut_time();
 
-					mtr_start(&mtr);
+		do {
+			ib_time_t	now;
+			ulint		n_done;
 
-					block = buf_page_get(
-						space, zip_size, page_no,
-						RW_X_LATCH, &mtr);
-					buf_block_dbg_add_level(
-						block, SYNC_NO_ORDER_CHECK);
+			os_thread_sleep(100000);
 
-					recv_recover_page(FALSE, block);
-					mtr_commit(&mtr);
-				} else {
-					recv_read_in_area(space, zip_size,
-							  page_no);
-				}
+			mutex_enter(&(recv_sys->mutex));
+			n_active = recv_sys->n_apply_threads_active;
+			n_done = n_pages - recv_sys->n_addrs;
+			mutex_exit(&(recv_sys->mutex));
+
+			now = ut_time();
+
+			if (n_active > 0 && n_done > 0
+			    && now - last_report_time
+			    >= RECV_PROGRESS_INTERVAL) {
+
+				ulint	elapsed = (ulint) (now - start_time);
+
+				ib_logf(IB_LOG_LEVEL_INFO,
+					"Applied log records to %lu of %lu"
+					" pages (%lu%%) in %lu seconds,"
+					" about %lu seconds remaining",
+					(ulong) n_done, (ulong) n_pages,
+					(ulong) (n_done * 100 / n_pages),
+					(ulong) elapsed,
+					(ulong) ((n_pages - n_done) * elapsed
+						 / n_done));
 
-				mutex_enter(&(recv_sys->mutex));
+				last_report_time = now;
 			}
-		}
+		} while (n_active > 0);
 
-		if (has_printed
-		    && (i * 100) / hash_get_n_cells(recv_sys->addr_hash)
-		    != ((i + 1) * 100)
-		    / hash_get_n_cells(recv_sys->addr_hash)) {
+		mutex_enter(&(recv_sys->mutex));
 
-			fprintf(stderr, "%lu ", (ulong)
-				((i * 100)
-				 / hash_get_n_cells(recv_sys->addr_hash)));
-		}
+		recv_sys->n_apply_threads = 0;
 	}
 
 	/* Wait until all the pages have been processed */
@@ -1733,11 +1932,6 @@ loop:
 		mutex_enter(&(recv_sys->mutex));
 	}
 
-	if (has_printed) {
-
-		fprintf(stderr, "\n");
-	}
-
 	if (!allow_ibuf) {
 
 		/* Flush all the file pages to disk and invalidate them in
@@ -1773,8 +1967,10 @@ loop:
 
 	recv_sys_empty_hash();
 
-	if (has_printed) {
-		fprintf(stderr, "InnoDB: Apply batch completed\n");
+	if (n_pages > 0) {
+		ib_logf(IB_LOG_LEVEL_INFO,
+			"Apply batch completed in %lu seconds",
+			(ulong) (ut_time() - start_time));
 	}
 
 	mutex_exit(&(recv_sys->mutex));
@@ -1974,11 +2170,7 @@ recv_parse_log_rec(
 #ifdef UNIV_LOG_LSN_DEBUG
 	if (*type == MLOG_LSN) {
 		lsn_t	lsn = (lsn_t) *space << 32 | *page_no;
-# ifdef UNIV_LOG_DEBUG
-		ut_a(lsn == log_sys->old_lsn);
-# else /* UNIV_LOG_DEBUG */
 		ut_a(lsn == recv_sys->recovered_lsn);
-# endif /* UNIV_LOG_DEBUG */
 	}
 #endif /* UNIV_LOG_LSN_DEBUG */
 
@@ -1998,8 +2190,9 @@ recv_parse_log_rec(
 }
 
 /*******************************************************//**
-Calculates the new value for lsn when more data is added to the log. */
-static
+Calculates the new value for lsn when more data is added to the log.
+@return lsn following the data, log block headers and trailers included */
+
 lsn_t
 recv_calc_lsn_on_data_add(
 /*======================*/
@@ -2992,10 +3185,10 @@ recv_recovery_from_checkpoint_start(
 
 	log_sys->lsn = recv_sys->recovered_lsn;
 
-	ut_memcpy(log_sys->buf, recv_sys->last_block, OS_FILE_LOG_BLOCK_SIZE);
+	ut_memcpy(log_buffer_get_block(log_sys->lsn), recv_sys->last_block,
+		  OS_FILE_LOG_BLOCK_SIZE);
 
-	log_sys->buf_free = (ulint) log_sys->lsn % OS_FILE_LOG_BLOCK_SIZE;
-	log_sys->buf_next_to_write = log_sys->buf_free;
+	log_sys->recent_written_lsn = log_sys->lsn;
 	log_sys->written_to_some_lsn = log_sys->lsn;
 	log_sys->written_to_all_lsn = log_sys->lsn;
 
@@ -3160,19 +3353,23 @@ recv_reset_logs(
 		group = UT_LIST_GET_NEXT(log_groups, group);
 	}
 
-	log_sys->buf_next_to_write = 0;
 	log_sys->written_to_some_lsn = log_sys->lsn;
 	log_sys->written_to_all_lsn = log_sys->lsn;
 
 	log_sys->next_checkpoint_no = 0;
 	log_sys->last_checkpoint_lsn = 0;
 
-	log_block_init(log_sys->buf, log_sys->lsn);
-	log_block_set_first_rec_group(log_sys->buf, LOG_BLOCK_HDR_SIZE);
+	log_block_init(log_buffer_get_block(log_sys->lsn), log_sys->lsn);
+	log_block_set_first_rec_group(log_buffer_get_block(log_sys->lsn),
+				      LOG_BLOCK_HDR_SIZE);
 
-	log_sys->buf_free = LOG_BLOCK_HDR_SIZE;
 	log_sys->lsn += LOG_BLOCK_HDR_SIZE;
 
+	/* Forget the ranges published for the old lsn sequence */
+	memset(log_sys->recent_written, 0,
+	       LOG_RECENT_WRITTEN_SIZE * sizeof *log_sys->recent_written);
+	log_sys->recent_written_lsn = log_sys->lsn;
+
 	MONITOR_SET(MONITOR_LSN_CHECKPOINT_AGE,
 		    (log_sys->lsn - log_sys->last_checkpoint_lsn));
 
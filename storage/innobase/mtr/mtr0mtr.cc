@@ -205,7 +205,8 @@ mtr_memo_note_modifications(
 }
 
 /************************************************************//**
-Append the dirty pages to the flush list. */
+Append the dirty pages to the flush list. If this mtr dirtied a clean page,
+the caller owns log_sys->log_flush_order_mutex, which is released here. */
 static
 void
 mtr_add_dirtied_pages_to_flush_list(
@@ -214,19 +215,10 @@ mtr_add_dirtied_pages_to_flush_list(
 {
 	ut_ad(!srv_read_only_mode);
 
-	/* No need to acquire log_flush_order_mutex if this mtr has
-	not dirtied a clean page. log_flush_order_mutex is used to
-	ensure ordered insertions in the flush_list. We need to
-	insert in the flush_list iff the page in question was clean
-	before modifications. */
-	if (mtr->made_dirty) {
-		log_flush_order_mutex_enter();
-	}
-
-	/* It is now safe to release the log mutex because the
-	flush_order mutex will ensure that we are the first one
-	to insert into the flush list. */
-	log_release();
+	/* We need to insert in the flush_list iff the page in question
+	was clean before modifications. log_flush_order_mutex, which we
+	have held since reserving our lsn range, ensures that such
+	insertions happen in lsn order. */
 
 	if (mtr->modifications) {
 		mtr_memo_note_modifications(mtr);
@@ -238,7 +230,9 @@ mtr_add_dirtied_pages_to_flush_list(
 }
 
 /************************************************************//**
-Writes the contents of a mini-transaction log, if any, to the database log. */
+Writes the contents of a mini-transaction log, if any, to the database log.
+The lsn range is reserved without the log mutex and the records are copied
+to the log buffer concurrently with other mini-transactions. */
 static
 void
 mtr_log_reserve_and_write(
@@ -248,6 +242,7 @@ mtr_log_reserve_and_write(
 	dyn_array_t*	mlog;
 	ulint		data_size;
 	byte*		first_data;
+	lsn_t		lsn;
 
 	ut_ad(!srv_read_only_mode);
 
@@ -262,50 +257,54 @@ mtr_log_reserve_and_write(
 				     | MLOG_SINGLE_REC_FLAG);
 	}
 
-	if (mlog->heap == NULL) {
-		ulint	len;
-
-		len = mtr->log_mode != MTR_LOG_NO_REDO
-			? dyn_block_get_used(mlog) : 0;
+	if (mtr->log_mode == MTR_LOG_ALL) {
+		data_size = dyn_array_get_data_size(mlog);
+	} else {
+		ut_ad(mtr->log_mode == MTR_LOG_NONE
+		      || mtr->log_mode == MTR_LOG_NO_REDO);
+		data_size = 0;
+	}
 
-		mtr->end_lsn = log_reserve_and_write_fast(
-			first_data, len, &mtr->start_lsn);
+	mtr->start_lsn = log_buffer_reserve(
+		data_size, mtr->made_dirty, &mtr->end_lsn);
 
-		if (mtr->end_lsn) {
+	mtr_add_dirtied_pages_to_flush_list(mtr);
 
-			/* Success. We have the log mutex.
-			Add pages to flush list and exit */
-			mtr_add_dirtied_pages_to_flush_list(mtr);
+	if (data_size == 0) {
 
-			return;
-		}
+		return;
 	}
 
-	data_size = dyn_array_get_data_size(mlog);
+	lsn = mtr->start_lsn;
 
-	/* Open the database log for log_write_low */
-	mtr->start_lsn = log_reserve_and_open(data_size);
+#ifdef UNIV_LOG_LSN_DEBUG
+	{
+		/* Write the LSN pseudo-record. */
+		byte	lsn_rec[1 + 2 * 5];
+		byte*	b = lsn_rec;
 
-	if (mtr->log_mode == MTR_LOG_ALL) {
+		*b++ = MLOG_LSN | (MLOG_SINGLE_REC_FLAG & *first_data);
+		/* Write the LSN in two parts,
+		as a pseudo page number and space id. */
+		b += mach_write_compressed(b, lsn >> 32);
+		b += mach_write_compressed(b, lsn & 0xFFFFFFFFUL);
 
-		for (dyn_block_t* block = mlog;
-		     block != 0;
-		     block = dyn_array_get_next_block(mlog, block)) {
+		lsn = log_buffer_write(lsn, lsn_rec, b - lsn_rec);
+	}
+#endif /* UNIV_LOG_LSN_DEBUG */
 
-			log_write_low(
-				dyn_block_get_data(block),
-				dyn_block_get_used(block));
-		}
+	for (dyn_block_t* block = mlog;
+	     block != 0;
+	     block = dyn_array_get_next_block(mlog, block)) {
 
-	} else {
-		ut_ad(mtr->log_mode == MTR_LOG_NONE
-		      || mtr->log_mode == MTR_LOG_NO_REDO);
-		/* Do nothing */
+		lsn = log_buffer_write(
+			lsn, dyn_block_get_data(block),
+			dyn_block_get_used(block));
 	}
 
-	mtr->end_lsn = log_close();
+	ut_ad(lsn == mtr->end_lsn);
 
-	mtr_add_dirtied_pages_to_flush_list(mtr);
+	log_buffer_close(mtr->start_lsn, mtr->end_lsn);
 }
 #endif /* !UNIV_HOTBACKUP */
 
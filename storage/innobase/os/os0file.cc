@@ -62,6 +62,14 @@ Created 10/21/1995 Heikki Tuuri
 #include <libaio.h>
 #endif
 
+#ifdef LINUX_IO_URING
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif /* LINUX_IO_URING */
+
 /** Insert buffer segment id */
 static const ulint IO_IBUF_SEGMENT = 0;
 
@@ -180,6 +188,15 @@ struct os_aio_slot_t{
 					and which can be used to identify
 					which pending aio operation was
 					completed */
+	void*		compress_buf;	/*!< memory holding the compressed
+					page that is written, freed with
+					the slot, or NULL; see
+					os_aio_func() */
+	ulint		compress_len;	/*!< length of the compressed page
+					that is written from compress_buf,
+					or 0; unlike len, this is not
+					changed when a partial write is
+					resubmitted */
 #ifdef WIN_ASYNC_IO
 	HANDLE		handle;		/*!< handle object we need in the
 					OVERLAPPED struct */
@@ -189,9 +206,45 @@ struct os_aio_slot_t{
 	struct iocb	control;	/* Linux control block for aio */
 	int		n_bytes;	/* bytes written/read. */
 	int		ret;		/* AIO return code */
+# ifdef LINUX_IO_URING
+	struct iovec	iov;		/* buffer of an io_uring request
+					that does not use a registered
+					buffer */
+# endif /* LINUX_IO_URING */
 #endif /* WIN_ASYNC_IO */
 };
 
+#ifdef LINUX_IO_URING
+/** An io_uring instance. When innodb_use_io_uring is set, each segment of
+an aio array submits its requests through one of these instead of an
+io_context. The submission ring is only written with the aio array mutex
+held; the completion ring is only read by the i/o-handler thread of the
+segment. */
+struct os_aio_uring_t{
+	int			fd;	/*!< io_uring file descriptor, or
+					-1 */
+	void*			sq_ptr;	/*!< mapping of the submission
+					ring */
+	size_t			sq_size;/*!< size of the sq_ptr mapping */
+	void*			cq_ptr;	/*!< mapping of the completion
+					ring, equal to sq_ptr if the kernel
+					maps both rings at once */
+	size_t			cq_size;/*!< size of the cq_ptr mapping */
+	struct io_uring_sqe*	sqes;	/*!< submission queue entries */
+	size_t			sqes_size;/*!< size of the sqes mapping */
+	unsigned*		sq_head;/*!< consumed by the kernel up to
+					here */
+	unsigned*		sq_tail;/*!< queued by us up to here */
+	unsigned*		sq_mask;/*!< ring index mask */
+	unsigned*		sq_array;/*!< indexes into sqes */
+	unsigned*		cq_head;/*!< reaped by us up to here */
+	unsigned*		cq_tail;/*!< completed by the kernel up to
+					here */
+	unsigned*		cq_mask;/*!< ring index mask */
+	struct io_uring_cqe*	cqes;	/*!< completion queue entries */
+};
+#endif /* LINUX_IO_URING */
+
 /** The asynchronous i/o array structure */
 struct os_aio_array_t{
 	SysMutex	mutex;	/*!< the mutex protecting the aio array */
@@ -240,6 +293,23 @@ struct os_aio_array_t{
 				There is one such event for each
 				possible pending IO. The size of the
 				array is equal to n_slots. */
+	struct iocb**		pending;
+				/* Requests posted with
+				OS_AIO_SIMULATED_WAKE_LATER that have
+				not been submitted to the kernel yet.
+				Each segment owns n_slots / n_segments
+				entries. Protected by mutex. */
+	ulint*			n_pending;
+				/* Number of requests waiting for
+				submission, per segment. With io_uring
+				these are the entries queued in the
+				submission ring. Protected by mutex. */
+# ifdef LINUX_IO_URING
+	os_aio_uring_t*		rings;
+				/* io_uring instances used instead of
+				aio_ctx if srv_use_io_uring is set,
+				one per segment */
+# endif /* LINUX_IO_URING */
 #endif /* LINUX_NATIV_AIO */
 };
 
@@ -252,8 +322,29 @@ struct os_aio_array_t{
 
 /** number of attempts before giving up on io_setup(). */
 #define OS_AIO_IO_SETUP_RETRY_ATTEMPTS	5
+
+/** time to sleep, in microseconds, if the kernel has no resources left
+for the submission of a batch of requests. */
+#define OS_AIO_SUBMIT_RETRY_SLEEP	(1000UL)
 #endif
 
+#ifdef LINUX_IO_URING
+/** Maximum number of buffers that can be registered with io_uring */
+static const ulint	OS_AIO_URING_MAX_FIXED_BUFS = 1024;
+
+/** Maximum size of a buffer registered with io_uring */
+static const ulint	OS_AIO_URING_MAX_FIXED_BUF_SIZE = 1UL << 30;
+
+/** Buffers to register with io_uring, sorted by address */
+static struct iovec	os_aio_fixed_bufs[OS_AIO_URING_MAX_FIXED_BUFS];
+
+/** Number of entries in os_aio_fixed_bufs */
+static ulint		os_aio_n_fixed_bufs = 0;
+
+/** true if os_aio_fixed_bufs have been registered with every io_uring */
+static bool		os_aio_fixed_bufs_registered = false;
+#endif /* LINUX_IO_URING */
+
 /** Array of events used in simulated aio */
 static os_event_t*	os_aio_segment_wait_events = NULL;
 
@@ -2230,6 +2321,57 @@ os_file_truncate(
 	return(res == 0);
 }
 
+/***********************************************************************//**
+Gets the block size of the file system that holds a file, the unit in
+which disk space is allocated to the file.
+@return block size in bytes, or 0 if it is not known */
+
+ulint
+os_file_get_block_size(
+/*===================*/
+	os_file_t	file)		/*!< in: handle to a file */
+{
+#ifdef _WIN32
+	return(0);
+#else
+	struct stat	statinfo;
+
+	if (fstat(file, &statinfo) != 0) {
+		return(0);
+	}
+
+	return(static_cast<ulint>(statinfo.st_blksize));
+#endif /* _WIN32 */
+}
+
+/***********************************************************************//**
+Frees the disk space of a range of a file without changing the size of
+the file; the range reads back as zeros. Only the whole file system
+blocks in the range are freed.
+@return DB_SUCCESS, DB_UNSUPPORTED if the file system does not support
+sparse files, or DB_IO_ERROR */
+
+dberr_t
+os_file_punch_hole(
+/*===============*/
+	os_file_t	file,		/*!< in: handle to a file */
+	os_offset_t	offset,		/*!< in: start of the range */
+	os_offset_t	len)		/*!< in: length of the range */
+{
+#ifdef FALLOC_FL_PUNCH_HOLE
+	if (fallocate(file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+		      offset, len) == 0) {
+
+		return(DB_SUCCESS);
+	}
+
+	return(errno == EOPNOTSUPP || errno == ENOSYS
+	       ? DB_UNSUPPORTED : DB_IO_ERROR);
+#else
+	return(DB_UNSUPPORTED);
+#endif /* FALLOC_FL_PUNCH_HOLE */
+}
+
 #ifndef _WIN32
 /***********************************************************************//**
 Wrapper to fsync(2) that retries the call on some errors.
@@ -3793,6 +3935,296 @@ os_aio_native_aio_supported(void)
 
 	return(FALSE);
 }
+
+#ifdef LINUX_IO_URING
+/******************************************************************//**
+Unmaps the rings of an io_uring instance and closes it. */
+static
+void
+os_aio_uring_close(
+/*===============*/
+	os_aio_uring_t*	ring)	/*!< in/out: io_uring instance */
+{
+	if (ring->sqes != NULL) {
+		munmap(ring->sqes, ring->sqes_size);
+	}
+
+	if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr) {
+		munmap(ring->cq_ptr, ring->cq_size);
+	}
+
+	if (ring->sq_ptr != NULL) {
+		munmap(ring->sq_ptr, ring->sq_size);
+	}
+
+	if (ring->fd >= 0) {
+		close(ring->fd);
+	}
+
+	memset(ring, 0x0, sizeof(*ring));
+	ring->fd = -1;
+}
+
+/******************************************************************//**
+Creates an io_uring instance and maps its rings.
+@return true on success */
+static
+bool
+os_aio_uring_create(
+/*================*/
+	ulint		max_events,	/*!< in: number of events */
+	os_aio_uring_t*	ring)		/*!< out: io_uring instance */
+{
+	struct io_uring_params	params;
+	byte*			sq;
+	byte*			cq;
+
+	memset(ring, 0x0, sizeof(*ring));
+	memset(&params, 0x0, sizeof(params));
+
+	ring->fd = static_cast<int>(
+		syscall(__NR_io_uring_setup, (unsigned) max_events, &params));
+
+	if (ring->fd < 0) {
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"io_uring_setup() failed with error %d", errno);
+
+		ring->fd = -1;
+		return(false);
+	}
+
+	ring->sq_size = params.sq_off.array
+		+ params.sq_entries * sizeof(unsigned);
+	ring->cq_size = params.cq_off.cqes
+		+ params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->sq_size = ring->cq_size = ut_max(ring->sq_size,
+						       ring->cq_size);
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, ring->fd,
+			    IORING_OFF_SQ_RING);
+
+	if (ring->sq_ptr == MAP_FAILED) {
+		ring->sq_ptr = NULL;
+		goto err_exit;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ring->cq_ptr = mmap(NULL, ring->cq_size,
+				    PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_POPULATE, ring->fd,
+				    IORING_OFF_CQ_RING);
+
+		if (ring->cq_ptr == MAP_FAILED) {
+			ring->cq_ptr = NULL;
+			goto err_exit;
+		}
+	}
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = static_cast<struct io_uring_sqe*>(
+		mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+		     MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES));
+
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err_exit;
+	}
+
+	sq = static_cast<byte*>(ring->sq_ptr);
+	cq = static_cast<byte*>(ring->cq_ptr);
+
+	ring->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	ring->sq_mask = reinterpret_cast<unsigned*>(
+		sq + params.sq_off.ring_mask);
+	ring->sq_array = reinterpret_cast<unsigned*>(
+		sq + params.sq_off.array);
+
+	ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	ring->cq_mask = reinterpret_cast<unsigned*>(
+		cq + params.cq_off.ring_mask);
+	ring->cqes = reinterpret_cast<struct io_uring_cqe*>(
+		cq + params.cq_off.cqes);
+
+	/* Every reserved slot of the segment has at most one entry in
+	the rings: they can never overflow. */
+	ut_a(params.sq_entries >= max_events);
+	ut_a(params.cq_entries >= max_events);
+
+	return(true);
+
+err_exit:
+	ib_logf(IB_LOG_LEVEL_WARN,
+		"Mapping the io_uring rings failed with error %d", errno);
+
+	os_aio_uring_close(ring);
+
+	return(false);
+}
+
+/******************************************************************//**
+Checks if the kernel supports io_uring.
+@return true if supported */
+static
+bool
+os_aio_uring_supported(void)
+/*========================*/
+{
+	os_aio_uring_t	ring;
+
+	if (!os_aio_uring_create(1, &ring)) {
+		return(false);
+	}
+
+	os_aio_uring_close(&ring);
+
+	return(true);
+}
+
+/******************************************************************//**
+Looks for the registered buffer that contains a memory area.
+@return true if the area lies inside a registered buffer */
+static
+bool
+os_aio_uring_find_fixed_buffer(
+/*===========================*/
+	const void*	buf,	/*!< in: start of the memory area */
+	ulint		len,	/*!< in: length of the memory area */
+	unsigned*	index)	/*!< out: index of the registered buffer */
+{
+	const byte*	ptr = static_cast<const byte*>(buf);
+	ulint		low = 0;
+	ulint		high = os_aio_n_fixed_bufs;
+
+	if (!os_aio_fixed_bufs_registered) {
+		return(false);
+	}
+
+	/* Find the last buffer that starts at or before ptr. */
+	while (high - low > 1) {
+		ulint	mid = (low + high) / 2;
+
+		if (static_cast<const byte*>(os_aio_fixed_bufs[mid].iov_base)
+		    <= ptr) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	const byte*	start = static_cast<const byte*>(
+		os_aio_fixed_bufs[low].iov_base);
+
+	if (ptr < start
+	    || ptr + len > start + os_aio_fixed_bufs[low].iov_len) {
+
+		return(false);
+	}
+
+	*index = static_cast<unsigned>(low);
+
+	return(true);
+}
+
+/******************************************************************//**
+Queues a request in the submission ring of an io_uring. The request is
+passed to the kernel by os_aio_uring_submit(). The caller must hold the
+mutex of the aio array. */
+static
+void
+os_aio_uring_prep(
+/*==============*/
+	os_aio_uring_t*	ring,	/*!< in/out: io_uring instance */
+	os_aio_slot_t*	slot)	/*!< in/out: reserved slot */
+{
+	unsigned		tail = *ring->sq_tail;
+	unsigned		index = tail & *ring->sq_mask;
+	struct io_uring_sqe*	sqe = &ring->sqes[index];
+	unsigned		buf_index;
+
+	ut_a(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)
+	     <= *ring->sq_mask);
+
+	memset(sqe, 0x0, sizeof(*sqe));
+
+	sqe->fd = slot->file;
+	sqe->off = slot->offset;
+	sqe->user_data = reinterpret_cast<ulint>(slot);
+
+	if (os_aio_uring_find_fixed_buffer(slot->buf, slot->len, &buf_index)) {
+		/* The pages of the buffer pool are pinned already, the
+		kernel does not have to map them for this request. */
+		sqe->opcode = slot->type == OS_FILE_READ
+			? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+		sqe->addr = reinterpret_cast<ulint>(slot->buf);
+		sqe->len = static_cast<unsigned>(slot->len);
+		sqe->buf_index = static_cast<__u16>(buf_index);
+	} else {
+		slot->iov.iov_base = slot->buf;
+		slot->iov.iov_len = slot->len;
+
+		sqe->opcode = slot->type == OS_FILE_READ
+			? IORING_OP_READV : IORING_OP_WRITEV;
+		sqe->addr = reinterpret_cast<ulint>(&slot->iov);
+		sqe->len = 1;
+	}
+
+	ring->sq_array[index] = index;
+
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/******************************************************************//**
+Passes the requests queued in the submission ring of a segment to the
+kernel with one system call. The caller must hold the mutex of the aio
+array. */
+static
+void
+os_aio_uring_submit(
+/*================*/
+	os_aio_array_t*	array,	/*!< in/out: aio array */
+	ulint		segment)/*!< in: local segment number */
+{
+	os_aio_uring_t*	ring = &array->rings[segment];
+
+	while (array->n_pending[segment] > 0) {
+		int	ret = static_cast<int>(syscall(
+				__NR_io_uring_enter, ring->fd,
+				(unsigned) array->n_pending[segment],
+				0U, 0U, NULL, 0));
+
+		if (ret > 0) {
+			ut_a((ulint) ret <= array->n_pending[segment]);
+			array->n_pending[segment] -= ret;
+			continue;
+		}
+
+		switch (ret < 0 ? errno : EAGAIN) {
+		case EINTR:
+			break;
+		case EAGAIN:
+		case EBUSY:
+			/* Out of kernel resources. The i/o-handler
+			thread reaps completions without the array
+			mutex, so we can wait for it here. */
+			os_thread_sleep(OS_AIO_SUBMIT_RETRY_SLEEP);
+			break;
+		default:
+			ib_logf(IB_LOG_LEVEL_FATAL,
+				"io_uring_enter() failed with error %d",
+				errno);
+		}
+	}
+}
+
+#endif /* LINUX_IO_URING */
 #endif /* LINUX_NATIVE_AIO */
 
 /******************************************************************//**
@@ -3842,6 +4274,11 @@ os_aio_array_create(
 #if defined(LINUX_NATIVE_AIO)
 	array->aio_ctx = NULL;
 	array->aio_events = NULL;
+	array->pending = NULL;
+	array->n_pending = NULL;
+# ifdef LINUX_IO_URING
+	array->rings = NULL;
+# endif /* LINUX_IO_URING */
 
 	/* If we are not using native aio interface then skip this
 	part of initialization. */
@@ -3849,6 +4286,26 @@ os_aio_array_create(
 		goto skip_native_aio;
 	}
 
+# ifdef LINUX_IO_URING
+	if (srv_use_io_uring) {
+		/* One io_uring per segment instead of an io_context. */
+
+		array->rings = static_cast<os_aio_uring_t*>(
+			ut_malloc(n_segments * sizeof(*array->rings)));
+
+		for (ulint i = 0; i < n_segments; ++i) {
+			if (!os_aio_uring_create(n / n_segments,
+						 &array->rings[i])) {
+				/* As with io_setup() failures, the
+				server is not going to start up. */
+				return(NULL);
+			}
+		}
+
+		goto create_events;
+	}
+# endif /* LINUX_IO_URING */
+
 	/* Initialize the io_context array. One io_context
 	per segment in the array. */
 
@@ -3868,6 +4325,9 @@ os_aio_array_create(
 		}
 	}
 
+# ifdef LINUX_IO_URING
+create_events:
+# endif /* LINUX_IO_URING */
 	/* Initialize the event array. One event per slot. */
 	io_event = static_cast<struct io_event*>(
 		ut_malloc(n * sizeof(*io_event)));
@@ -3875,6 +4335,15 @@ os_aio_array_create(
 	memset(io_event, 0x0, sizeof(*io_event) * n);
 	array->aio_events = io_event;
 
+	/* Initialize the lists of requests waiting for submission. */
+	array->pending = static_cast<struct iocb**>(
+		ut_malloc(n * sizeof(*array->pending)));
+
+	array->n_pending = static_cast<ulint*>(
+		ut_malloc(n_segments * sizeof(*array->n_pending)));
+
+	memset(array->n_pending, 0x0, n_segments * sizeof(*array->n_pending));
+
 skip_native_aio:
 #endif /* LINUX_NATIVE_AIO */
 	for (ulint i = 0; i < n; i++) {
@@ -3884,6 +4353,8 @@ skip_native_aio:
 
 		slot->pos = i;
 		slot->reserved = FALSE;
+		slot->compress_buf = NULL;
+		slot->compress_len = 0;
 #ifdef WIN_ASYNC_IO
 		slot->handle = CreateEvent(NULL,TRUE, FALSE, NULL);
 
@@ -3929,6 +4400,17 @@ os_aio_array_free(
 
 #if defined(LINUX_NATIVE_AIO)
 	if (srv_use_native_aio) {
+# ifdef LINUX_IO_URING
+		if (array->rings != NULL) {
+			for (ulint i = 0; i < array->n_segments; ++i) {
+				os_aio_uring_close(&array->rings[i]);
+			}
+
+			ut_free(array->rings);
+		}
+# endif /* LINUX_IO_URING */
+		ut_free(array->n_pending);
+		ut_free(array->pending);
 		ut_free(array->aio_events);
 		ut_free(array->aio_ctx);
 	}
@@ -3968,6 +4450,30 @@ os_aio_init(
 
 		srv_use_native_aio = FALSE;
 	}
+
+# ifdef LINUX_IO_URING
+	if (srv_use_io_uring && !srv_use_native_aio) {
+
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"innodb_use_io_uring requires Linux Native AIO."
+			" io_uring disabled.");
+
+		srv_use_io_uring = FALSE;
+
+	} else if (srv_use_io_uring && !os_aio_uring_supported()) {
+
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"io_uring is not supported by the kernel."
+			" Using libaio for Linux Native AIO.");
+
+		srv_use_io_uring = FALSE;
+
+	} else if (srv_use_io_uring) {
+
+		ib_logf(IB_LOG_LEVEL_INFO,
+			"Using io_uring for Linux Native AIO");
+	}
+# endif /* LINUX_IO_URING */
 #endif /* LINUX_NATIVE_AIO */
 
 	srv_reset_io_thread_op_info();
@@ -4099,6 +4605,141 @@ os_aio_free(void)
 	os_aio_n_segments = 0;
 }
 
+/***********************************************************************
+Adds a memory area, normally a buffer pool chunk, to the buffers that
+io_uring will access without mapping them on every request. Does nothing
+unless io_uring is in use. The buffers take effect when
+os_aio_register_fixed_buffers() is called. */
+
+void
+os_aio_add_fixed_buffer(
+/*====================*/
+	void*	buf,	/*!< in: start of the memory area */
+	ulint	len)	/*!< in: length of the memory area in bytes */
+{
+#ifdef LINUX_IO_URING
+	byte*	ptr = static_cast<byte*>(buf);
+
+	if (!srv_use_io_uring) {
+		return;
+	}
+
+	ut_ad(!os_aio_fixed_bufs_registered);
+
+	/* The kernel limits the size of a registered buffer. A page
+	that straddles two of them is read and written without using
+	the registration. */
+	while (len > 0 && os_aio_n_fixed_bufs < OS_AIO_URING_MAX_FIXED_BUFS) {
+		ulint	size = ut_min(len, OS_AIO_URING_MAX_FIXED_BUF_SIZE);
+		ulint	i;
+
+		/* Keep the buffers sorted by address. */
+		for (i = os_aio_n_fixed_bufs;
+		     i > 0 && os_aio_fixed_bufs[i - 1].iov_base > ptr;
+		     --i) {
+
+			os_aio_fixed_bufs[i] = os_aio_fixed_bufs[i - 1];
+		}
+
+		os_aio_fixed_bufs[i].iov_base = ptr;
+		os_aio_fixed_bufs[i].iov_len = size;
+		++os_aio_n_fixed_bufs;
+
+		ptr += size;
+		len -= size;
+	}
+#endif /* LINUX_IO_URING */
+}
+
+#ifdef LINUX_IO_URING
+/***********************************************************************
+Registers or unregisters os_aio_fixed_bufs with all io_uring instances
+of an aio array.
+@return true on success */
+static
+bool
+os_aio_array_register_fixed_buffers(
+/*================================*/
+	os_aio_array_t*	array,	/*!< in: aio array, or NULL */
+	bool		reg)	/*!< in: true to register, false to
+				unregister */
+{
+	if (array == NULL) {
+		return(true);
+	}
+
+	for (ulint i = 0; i < array->n_segments; ++i) {
+		long	ret;
+
+		if (reg) {
+			ret = syscall(__NR_io_uring_register,
+				      array->rings[i].fd,
+				      IORING_REGISTER_BUFFERS,
+				      os_aio_fixed_bufs,
+				      (unsigned) os_aio_n_fixed_bufs);
+		} else {
+			ret = syscall(__NR_io_uring_register,
+				      array->rings[i].fd,
+				      IORING_UNREGISTER_BUFFERS,
+				      NULL, 0U);
+		}
+
+		if (ret < 0 && reg) {
+			return(false);
+		}
+	}
+
+	return(true);
+}
+#endif /* LINUX_IO_URING */
+
+/***********************************************************************
+Registers the buffers added with os_aio_add_fixed_buffer() with every
+io_uring instance. Requests whose buffer lies inside a registered buffer
+are then submitted as fixed buffer reads and writes. If the registration
+fails, for example because of RLIMIT_MEMLOCK, a warning is printed and
+io_uring keeps on mapping the buffers on every request. */
+
+void
+os_aio_register_fixed_buffers(void)
+/*===============================*/
+{
+#ifdef LINUX_IO_URING
+	os_aio_array_t*	arrays[] = {
+		os_aio_read_array, os_aio_write_array, os_aio_ibuf_array,
+		os_aio_log_array, os_aio_sync_array
+	};
+
+	if (!srv_use_io_uring || os_aio_n_fixed_bufs == 0) {
+		return;
+	}
+
+	for (ulint i = 0; i < UT_ARR_SIZE(arrays); ++i) {
+
+		if (!os_aio_array_register_fixed_buffers(arrays[i], true)) {
+
+			ib_logf(IB_LOG_LEVEL_WARN,
+				"Registering the buffer pool with io_uring"
+				" failed with error %d. Check the locked"
+				" memory limit (ulimit -l).", errno);
+
+			for (ulint j = 0; j <= i; ++j) {
+				os_aio_array_register_fixed_buffers(
+					arrays[j], false);
+			}
+
+			return;
+		}
+	}
+
+	os_aio_fixed_bufs_registered = true;
+
+	ib_logf(IB_LOG_LEVEL_INFO,
+		"Registered %lu buffers of the buffer pool with io_uring",
+		os_aio_n_fixed_bufs);
+#endif /* LINUX_IO_URING */
+}
+
 #ifdef WIN_ASYNC_IO
 /************************************************************************//**
 Wakes up all async i/o threads in the array in Windows async i/o at
@@ -4276,7 +4917,10 @@ os_aio_array_reserve_slot(
 	void*		buf,	/*!< in: buffer where to read or from which
 				to write */
 	os_offset_t	offset,	/*!< in: file offset */
-	ulint		len)	/*!< in: length of the block to read or write */
+	ulint		len,	/*!< in: length of the block to read or write */
+	void*		compress_buf)/*!< in: memory holding the
+				compressed page that buf points into,
+				freed with the slot, or NULL */
 {
 	os_aio_slot_t*	slot = NULL;
 #ifdef WIN_ASYNC_IO
@@ -4312,12 +4956,11 @@ loop:
 	if (array->n_reserved == array->n_slots) {
 		mutex_exit(&array->mutex);
 
-		if (!srv_use_native_aio) {
-			/* If the handler threads are suspended, wake them
-			so that we get more slots */
+		/* If the handler threads are suspended, wake them
+		so that we get more slots. With native aio, this
+		submits the requests that are waiting in a batch. */
 
-			os_aio_simulated_wake_handler_threads();
-		}
+		os_aio_simulated_wake_handler_threads();
 
 		os_event_wait(array->not_full);
 
@@ -4365,6 +5008,8 @@ found:
 	slot->type     = type;
 	slot->buf      = static_cast<byte*>(buf);
 	slot->offset   = offset;
+	slot->compress_buf = compress_buf;
+	slot->compress_len = compress_buf != NULL ? len : 0;
 	slot->io_already_done = FALSE;
 
 #ifdef WIN_ASYNC_IO
@@ -4422,6 +5067,12 @@ os_aio_array_free_slot(
 
 	slot->reserved = FALSE;
 
+	if (slot->compress_buf != NULL) {
+		ut_free(slot->compress_buf);
+		slot->compress_buf = NULL;
+		slot->compress_len = 0;
+	}
+
 	array->n_reserved--;
 
 	if (array->n_reserved == array->n_slots - 1) {
@@ -4454,6 +5105,77 @@ os_aio_array_free_slot(
 	mutex_exit(&array->mutex);
 }
 
+#if defined(LINUX_NATIVE_AIO)
+/*******************************************************************//**
+Submits to the kernel the requests of a segment that were posted with
+OS_AIO_SIMULATED_WAKE_LATER, in as few system calls as possible. */
+static
+void
+os_aio_linux_submit_pending(
+/*========================*/
+	os_aio_array_t*	array,	/*!< in/out: aio array */
+	ulint		segment)/*!< in: local segment number */
+{
+	/* A dirty read is enough: the requests posted by this thread
+	are visible to it, and the other threads submit their own. */
+	if (array->n_pending[segment] == 0) {
+		return;
+	}
+
+	mutex_enter(&array->mutex);
+
+#ifdef LINUX_IO_URING
+	if (srv_use_io_uring) {
+		os_aio_uring_submit(array, segment);
+
+		mutex_exit(&array->mutex);
+
+		return;
+	}
+#endif /* LINUX_IO_URING */
+
+	ulint		seg_size = array->n_slots / array->n_segments;
+	struct iocb**	iocbs = &array->pending[segment * seg_size];
+	ulint		n = array->n_pending[segment];
+
+	for (ulint i = 0; i < n; /* No op */) {
+		int	ret = io_submit(
+			array->aio_ctx[segment], n - i, iocbs + i);
+
+		if (ret > 0) {
+			i += ret;
+			continue;
+		}
+
+		switch (ret) {
+		case -EINTR:
+			break;
+		case -EAGAIN:
+			/* Out of kernel resources. The i/o-handler thread
+			reaps completions before it waits for the array
+			mutex, so we can wait for it here. */
+			os_thread_sleep(OS_AIO_SUBMIT_RETRY_SLEEP);
+			break;
+		default:
+			/* The first request was refused. Pass the error to
+			the i/o-handler thread as if the request had
+			completed, and submit the rest. */
+			os_aio_slot_t*	slot = static_cast<os_aio_slot_t*>(
+				iocbs[i]->data);
+
+			slot->n_bytes = 0;
+			slot->ret = ret;
+			slot->io_already_done = TRUE;
+			++i;
+		}
+	}
+
+	array->n_pending[segment] = 0;
+
+	mutex_exit(&array->mutex);
+}
+#endif /* LINUX_NATIVE_AIO */
+
 /**********************************************************************//**
 Wakes up a simulated aio i/o-handler thread if it has something to do. */
 static
@@ -4510,7 +5232,19 @@ os_aio_simulated_wake_handler_threads(void)
 /*=======================================*/
 {
 	if (srv_use_native_aio) {
-		/* We do not use simulated aio: do nothing */
+		/* We do not use simulated aio: only submit the
+		requests that were posted in a batch */
+#if defined(LINUX_NATIVE_AIO)
+		for (ulint i = 0; i < os_aio_n_segments; i++) {
+			os_aio_array_t*	array;
+			ulint		segment;
+
+			segment = os_aio_get_array_and_local_segment(
+				&array, i);
+
+			os_aio_linux_submit_pending(array, segment);
+		}
+#endif /* LINUX_NATIVE_AIO */
 
 		return;
 	}
@@ -4568,7 +5302,11 @@ ibool
 os_aio_linux_dispatch(
 /*==================*/
 	os_aio_array_t*	array,	/*!< in: io request array. */
-	os_aio_slot_t*	slot)	/*!< in: an already reserved slot. */
+	os_aio_slot_t*	slot,	/*!< in: an already reserved slot. */
+	bool		batch)	/*!< in: true if the request may wait
+				for os_aio_simulated_wake_handler_threads()
+				and be submitted together with the other
+				requests of the batch */
 {
 	int		ret;
 	ulint		io_ctx_index;
@@ -4586,6 +5324,41 @@ os_aio_linux_dispatch(
 	iocb = &slot->control;
 	io_ctx_index = (slot->pos * array->n_segments) / array->n_slots;
 
+#ifdef LINUX_IO_URING
+	if (srv_use_io_uring) {
+		mutex_enter(&array->mutex);
+
+		os_aio_uring_prep(&array->rings[io_ctx_index], slot);
+
+		++array->n_pending[io_ctx_index];
+
+		if (!batch) {
+			os_aio_uring_submit(array, io_ctx_index);
+		}
+
+		mutex_exit(&array->mutex);
+
+		return(TRUE);
+	}
+#endif /* LINUX_IO_URING */
+
+	if (batch) {
+		ulint	seg_size = array->n_slots / array->n_segments;
+
+		mutex_enter(&array->mutex);
+
+		/* Every request of the list holds a slot of the
+		segment: the list cannot overflow. */
+		ut_a(array->n_pending[io_ctx_index] < seg_size);
+
+		array->pending[io_ctx_index * seg_size
+			       + array->n_pending[io_ctx_index]++] = iocb;
+
+		mutex_exit(&array->mutex);
+
+		return(TRUE);
+	}
+
 	ret = io_submit(array->aio_ctx[io_ctx_index], 1, &iocb);
 
 #if defined(UNIV_AIO_DEBUG)
@@ -4640,10 +5413,15 @@ os_aio_func(
 				(can be used to identify a completed
 				aio operation); ignored if mode is
 				OS_AIO_SYNC */
-	void*		message2)/*!< in: message for the aio handler
+	void*		message2,/*!< in: message for the aio handler
 				(can be used to identify a completed
 				aio operation); ignored if mode is
 				OS_AIO_SYNC */
+	void*		compress_buf)/*!< in: memory holding the
+				compressed page that buf points into,
+				freed with ut_free() when the aio
+				operation completes, or NULL; must be
+				NULL if mode is OS_AIO_SYNC */
 {
 	os_aio_array_t*	array;
 	os_aio_slot_t*	slot;
@@ -4654,6 +5432,7 @@ os_aio_func(
 	struct fil_node_t* dummy_mess1;
 	void*		dummy_mess2;
 	ulint		dummy_type;
+	ulint		dummy_n;
 #endif /* WIN_ASYNC_IO */
 	ulint		wake_later;
 
@@ -4670,6 +5449,8 @@ os_aio_func(
 	wake_later = mode & OS_AIO_SIMULATED_WAKE_LATER;
 	mode = mode & (~OS_AIO_SIMULATED_WAKE_LATER);
 
+	ut_ad(mode != OS_AIO_SYNC || compress_buf == NULL);
+
 	if (mode == OS_AIO_SYNC
 #ifdef WIN_ASYNC_IO
 	    && !srv_use_native_aio
@@ -4741,7 +5522,7 @@ try_again:
 	}
 
 	slot = os_aio_array_reserve_slot(type, array, message1, message2, file,
-					 name, buf, offset, n);
+					 name, buf, offset, n, compress_buf);
 	if (type == OS_FILE_READ) {
 		if (srv_use_native_aio) {
 			os_n_file_reads++;
@@ -4751,7 +5532,8 @@ try_again:
 				       &(slot->control));
 
 #elif defined(LINUX_NATIVE_AIO)
-			if (!os_aio_linux_dispatch(array, slot)) {
+			if (!os_aio_linux_dispatch(
+				    array, slot, wake_later != 0)) {
 				goto err_exit;
 			}
 #endif /* WIN_ASYNC_IO */
@@ -4771,7 +5553,8 @@ try_again:
 					&(slot->control));
 
 #elif defined(LINUX_NATIVE_AIO)
-			if (!os_aio_linux_dispatch(array, slot)) {
+			if (!os_aio_linux_dispatch(
+				    array, slot, wake_later != 0)) {
 				goto err_exit;
 			}
 #endif /* WIN_ASYNC_IO */
@@ -4801,7 +5584,7 @@ try_again:
 				retval = os_aio_windows_handle(
 					ULINT_UNDEFINED, slot->pos,
 					&dummy_mess1, &dummy_mess2,
-					&dummy_type);
+					&dummy_type, &dummy_n);
 
 				return(retval);
 			}
@@ -4818,6 +5601,9 @@ try_again:
 #if defined LINUX_NATIVE_AIO || defined WIN_ASYNC_IO
 err_exit:
 #endif /* LINUX_NATIVE_AIO || WIN_ASYNC_IO */
+	/* The request is retried with the same buffer. */
+	slot->compress_buf = NULL;
+
 	os_aio_array_free_slot(array, slot);
 
 	if (os_file_handle_error(
@@ -4826,6 +5612,8 @@ err_exit:
 		goto try_again;
 	}
 
+	ut_free(compress_buf);
+
 	return(FALSE);
 }
 
@@ -4858,7 +5646,10 @@ os_aio_windows_handle(
 				parameters are valid and can be used to
 				restart the operation, for example */
 	void**	message2,
-	ulint*	type)		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len)/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 {
 	ulint		orig_seg	= segment;
 	os_aio_array_t*	array;
@@ -4930,6 +5721,7 @@ os_aio_windows_handle(
 	*message2 = slot->message2;
 
 	*type = slot->type;
+	*compress_len = slot->compress_len;
 
 	if (ret && len == slot->len) {
 
@@ -5115,7 +5907,9 @@ retry:
 		the return code will be the number of IOs. We get EINTR only
 		if there are no completed IOs and we have been interrupted. */
 	case 0:
-		/* No pending request! Go back and check again. */
+		/* No pending request! Submit the requests that a batch
+		may have left behind, go back and check again. */
+		os_aio_linux_submit_pending(array, segment);
 		goto retry;
 	}
 
@@ -5125,6 +5919,103 @@ retry:
 		"Unexpected ret_code[%d] from io_getevents()!",	ret);
 }
 
+#ifdef LINUX_IO_URING
+/******************************************************************//**
+This function is only used with io_uring. It is called from within the
+io-thread of a segment if there are no completed requests in the slot
+array, and waits for the kernel to complete some. Like
+os_aio_linux_collect() it wakes up periodically to check the server
+status. */
+static
+void
+os_aio_uring_collect(
+/*=================*/
+	os_aio_array_t* array,		/*!< in/out: slot array. */
+	ulint		segment,	/*!< in: local segment no. */
+	ulint		seg_size)	/*!< in: segment size. */
+{
+	os_aio_uring_t*		ring = &array->rings[segment];
+	struct io_event*	events = &array->aio_events[segment * seg_size];
+	ulint			start_pos = segment * seg_size;
+	ulint			end_pos = start_pos + seg_size;
+
+	for (;;) {
+		unsigned	head = *ring->cq_head;
+		unsigned	tail = __atomic_load_n(
+			ring->cq_tail, __ATOMIC_ACQUIRE);
+		ulint		n = 0;
+
+		/* Copy the completions out of the ring and release the
+		ring entries before we wait for the array mutex. */
+		for (; head != tail; ++head, ++n) {
+			const struct io_uring_cqe*	cqe;
+
+			ut_a(n < seg_size);
+
+			cqe = &ring->cqes[head & *ring->cq_mask];
+			events[n].data = reinterpret_cast<void*>(
+				static_cast<ulint>(cqe->user_data));
+			events[n].res = cqe->res;
+		}
+
+		if (n > 0) {
+			__atomic_store_n(ring->cq_head, head,
+					 __ATOMIC_RELEASE);
+
+			mutex_enter(&array->mutex);
+
+			for (ulint i = 0; i < n; ++i) {
+				os_aio_slot_t*	slot;
+				int		res;
+
+				slot = static_cast<os_aio_slot_t*>(
+					events[i].data);
+				res = static_cast<int>(events[i].res);
+
+				ut_a(slot != NULL);
+				ut_a(slot->reserved);
+				ut_a(slot->pos >= start_pos);
+				ut_a(slot->pos < end_pos);
+
+				/* Mark this request as completed. The
+				error handling will be done in the calling
+				function. */
+				slot->n_bytes = res < 0 ? 0 : res;
+				slot->ret = res < 0 ? res : 0;
+				slot->io_already_done = TRUE;
+			}
+
+			mutex_exit(&array->mutex);
+
+			return;
+		}
+
+		if (UNIV_UNLIKELY(srv_shutdown_state
+				  == SRV_SHUTDOWN_EXIT_THREADS)) {
+			return;
+		}
+
+		/* Submit the requests that a batch may have left
+		behind in the submission ring, and wait. */
+		os_aio_linux_submit_pending(array, segment);
+
+		struct pollfd	pfd;
+
+		pfd.fd = ring->fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		if (poll(&pfd, 1, OS_AIO_REAP_TIMEOUT / 1000000) < 0
+		    && errno != EINTR) {
+
+			ib_logf(IB_LOG_LEVEL_FATAL,
+				"poll() on io_uring failed with error %d",
+				errno);
+		}
+	}
+}
+#endif /* LINUX_IO_URING */
+
 /**********************************************************************//**
 This function is only used in Linux native asynchronous i/o.
 Waits for an aio operation to complete. This function is used to wait for
@@ -5148,7 +6039,10 @@ os_aio_linux_handle(
 				aio operation failed, these output
 				parameters are valid and can be used to
 				restart the operation. */
-	ulint*	type)		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len)/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 {
 	ulint		segment;
 	os_aio_array_t*	array;
@@ -5200,6 +6094,12 @@ wait_for_event:
 
 		srv_set_io_thread_op_info(global_seg,
 			"waiting for completed aio requests");
+#ifdef LINUX_IO_URING
+		if (srv_use_io_uring) {
+			os_aio_uring_collect(array, segment, n);
+			continue;
+		}
+#endif /* LINUX_IO_URING */
 		os_aio_linux_collect(array, segment, n);
 	}
 
@@ -5222,6 +6122,21 @@ found:
 	*message2 = slot->message2;
 
 	*type = slot->type;
+	*compress_len = slot->compress_len;
+
+	DBUG_EXECUTE_IF(
+		"os_aio_partial_write",
+		if (slot->type == OS_FILE_WRITE
+		    && slot->ret == 0
+		    && slot->n_bytes == (long) slot->len
+		    && slot->len >= 2 * OS_FILE_LOG_BLOCK_SIZE) {
+			/* Pretend that only the first half was
+			written, so that the rest is written again
+			by a resubmitted request. */
+			slot->n_bytes = (long) ut_calc_align_down(
+				slot->len / 2, OS_FILE_LOG_BLOCK_SIZE);
+		}
+	);
 
 	if (slot->ret == 0 && slot->n_bytes == (long) slot->len) {
 
@@ -5248,6 +6163,14 @@ found:
 				       slot->len, (off_t) slot->offset);
 		}
 		/* Resubmit an I/O request */
+#ifdef LINUX_IO_URING
+		if (srv_use_io_uring) {
+			os_aio_uring_prep(&array->rings[segment], slot);
+			++array->n_pending[segment];
+			os_aio_uring_submit(array, segment);
+			submit_ret = 1;
+		} else
+#endif /* LINUX_IO_URING */
 		submit_ret = io_submit(array->aio_ctx[segment], 1, &iocb);
 		if (submit_ret < 0 ) {
 			/* Aborting in case of submit failure */
@@ -5303,7 +6226,10 @@ os_aio_simulated_handle(
 				parameters are valid and can be used to
 				restart the operation, for example */
 	void**	message2,
-	ulint*	type)		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	type,		/*!< out: OS_FILE_WRITE or ..._READ */
+	ulint*	compress_len)/*!< out: length of the compressed
+				page that was written from the
+				compress_buf of the request, or 0 */
 {
 	os_aio_array_t*	array;
 	ulint		segment;
@@ -5585,6 +6511,7 @@ slot_io_done:
 	*message2 = aio_slot->message2;
 
 	*type = aio_slot->type;
+	*compress_len = aio_slot->compress_len;
 
 	mutex_exit(&array->mutex);
 
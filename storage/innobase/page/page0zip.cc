@@ -38,6 +38,12 @@ Created June 2005 by Marko Makela
 #include "log0recv.h"
 #include "row0trunc.h"
 #include "zlib.h"
+#ifdef HAVE_LZ4
+# include <lz4.h>
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif /* HAVE_ZSTD */
 #ifndef UNIV_HOTBACKUP
 # include "buf0buf.h"
 # include "buf0lru.h"
@@ -755,6 +761,521 @@ page_zip_set_alloc(
 	strm->opaque = heap;
 }
 
+/** Compress a buffer.
+@param level	compression level
+@param src	data to compress
+@param src_len	length of src
+@param dst	output buffer
+@param dst_len	size of dst
+@return compressed size, or 0 if it exceeds dst_len */
+typedef ulint (*page_zip_compress_func_t)(
+	ulint		level,
+	const byte*	src,
+	ulint		src_len,
+	byte*		dst,
+	ulint		dst_len);
+
+/** Decompress a buffer.
+@param src	compressed data
+@param src_len	length of src
+@param dst	output buffer
+@param dst_len	size of dst
+@return decompressed size, or 0 on error */
+typedef ulint (*page_zip_decompress_func_t)(
+	const byte*	src,
+	ulint		src_len,
+	byte*		dst,
+	ulint		dst_len);
+
+/** Block compressor of a page_zip_algorithm_t */
+struct page_zip_compressor_t {
+	/** Compress a buffer, or NULL if the algorithm is not available */
+	page_zip_compress_func_t	compress;
+	/** Decompress a buffer, or NULL if the algorithm is not available */
+	page_zip_decompress_func_t	decompress;
+};
+
+/**********************************************************************//**
+Compress a buffer with zlib.
+@return compressed size, or 0 if it exceeds dst_len */
+static
+ulint
+page_zip_zlib_compress(
+/*===================*/
+	ulint		level,	/*!< in: compression level */
+	const byte*	src,	/*!< in: data to compress */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: compressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	uLongf	len = static_cast<uLongf>(dst_len);
+
+	return(compress2(dst, &len, src, static_cast<uLong>(src_len),
+			 static_cast<int>(level)) == Z_OK ? len : 0);
+}
+
+/**********************************************************************//**
+Decompress a buffer with zlib.
+@return decompressed size, or 0 on error */
+static
+ulint
+page_zip_zlib_decompress(
+/*=====================*/
+	const byte*	src,	/*!< in: compressed data */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: decompressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	uLongf	len = static_cast<uLongf>(dst_len);
+
+	return(uncompress(dst, &len, src, static_cast<uLong>(src_len))
+	       == Z_OK ? len : 0);
+}
+
+#ifdef HAVE_LZ4
+/**********************************************************************//**
+Compress a buffer with LZ4. The level is ignored.
+@return compressed size, or 0 if it exceeds dst_len */
+static
+ulint
+page_zip_lz4_compress(
+/*==================*/
+	ulint		level __attribute__((unused)),
+				/*!< in: compression level */
+	const byte*	src,	/*!< in: data to compress */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: compressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	int	len = LZ4_compress_default(
+		reinterpret_cast<const char*>(src),
+		reinterpret_cast<char*>(dst),
+		static_cast<int>(src_len), static_cast<int>(dst_len));
+
+	return(len > 0 ? static_cast<ulint>(len) : 0);
+}
+
+/**********************************************************************//**
+Decompress a buffer with LZ4.
+@return decompressed size, or 0 on error */
+static
+ulint
+page_zip_lz4_decompress(
+/*====================*/
+	const byte*	src,	/*!< in: compressed data */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: decompressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	int	len = LZ4_decompress_safe(
+		reinterpret_cast<const char*>(src),
+		reinterpret_cast<char*>(dst),
+		static_cast<int>(src_len), static_cast<int>(dst_len));
+
+	return(len > 0 ? static_cast<ulint>(len) : 0);
+}
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+/**********************************************************************//**
+Compress a buffer with Zstandard. Level 0 is the zstd default level.
+@return compressed size, or 0 if it exceeds dst_len */
+static
+ulint
+page_zip_zstd_compress(
+/*===================*/
+	ulint		level,	/*!< in: compression level */
+	const byte*	src,	/*!< in: data to compress */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: compressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	size_t	len = ZSTD_compress(dst, dst_len, src, src_len,
+				    static_cast<int>(level));
+
+	return(ZSTD_isError(len) ? 0 : len);
+}
+
+/**********************************************************************//**
+Decompress a buffer with Zstandard.
+@return decompressed size, or 0 on error */
+static
+ulint
+page_zip_zstd_decompress(
+/*=====================*/
+	const byte*	src,	/*!< in: compressed data */
+	ulint		src_len,/*!< in: length of src */
+	byte*		dst,	/*!< out: decompressed data */
+	ulint		dst_len)/*!< in: size of dst */
+{
+	size_t	len = ZSTD_decompress(dst, dst_len, src, src_len);
+
+	return(ZSTD_isError(len) ? 0 : len);
+}
+#endif /* HAVE_ZSTD */
+
+/** Block compressors, indexed by page_zip_algorithm_t */
+static const page_zip_compressor_t
+page_zip_compressors[PAGE_ZIP_N_ALGORITHMS] = {
+	{ page_zip_zlib_compress, page_zip_zlib_decompress },
+#ifdef HAVE_LZ4
+	{ page_zip_lz4_compress, page_zip_lz4_decompress },
+#else /* HAVE_LZ4 */
+	{ NULL, NULL },
+#endif /* HAVE_LZ4 */
+#ifdef HAVE_ZSTD
+	{ page_zip_zstd_compress, page_zip_zstd_decompress }
+#else /* HAVE_ZSTD */
+	{ NULL, NULL }
+#endif /* HAVE_ZSTD */
+};
+
+/**********************************************************************//**
+Determine if a compression algorithm was compiled in.
+@return true if pages can be compressed and decompressed with it */
+
+bool
+page_zip_algorithm_is_available(
+/*============================*/
+	page_zip_algorithm_t	algorithm)	/*!< in: algorithm */
+{
+	return(algorithm < PAGE_ZIP_N_ALGORITHMS
+	       && page_zip_compressors[algorithm].compress != NULL);
+}
+
+/**********************************************************************//**
+Compress a buffer with the block compressor of an algorithm. For zlib,
+this is not the stream format of the compressed pages; it is meant for
+comparing the algorithms on page images.
+@return compressed size, or 0 if it exceeds dst_len */
+
+ulint
+page_zip_compress_buf(
+/*==================*/
+	page_zip_algorithm_t	algorithm,	/*!< in: available algorithm */
+	ulint			level,		/*!< in: compression level */
+	const byte*		src,		/*!< in: data to compress */
+	ulint			src_len,	/*!< in: length of src */
+	byte*			dst,		/*!< out: compressed data */
+	ulint			dst_len)	/*!< in: size of dst */
+{
+	ut_a(page_zip_algorithm_is_available(algorithm));
+
+	return(page_zip_compressors[algorithm].compress(
+		       level, src, src_len, dst, dst_len));
+}
+
+/**********************************************************************//**
+Decompress a buffer that was compressed by page_zip_compress_buf().
+@return decompressed size, or 0 on error */
+
+ulint
+page_zip_decompress_buf(
+/*====================*/
+	page_zip_algorithm_t	algorithm,	/*!< in: available algorithm */
+	const byte*		src,		/*!< in: compressed data */
+	ulint			src_len,	/*!< in: length of src */
+	byte*			dst,		/*!< out: decompressed data */
+	ulint			dst_len)	/*!< in: size of dst */
+{
+	ut_a(page_zip_algorithm_is_available(algorithm));
+
+	return(page_zip_compressors[algorithm].decompress(
+		       src, src_len, dst, dst_len));
+}
+
+/* The compression and decompression of the records is written against
+the zlib stream interface, see page0zip.ic.  The algorithms other than
+zlib compress the page as one block: deflate() collects its input in
+page_zip_stream_t::block and compresses it at Z_FINISH, and the block
+is decompressed up front for inflate() to hand out.  They leave
+next_out and avail_out alone until then, so that the space that the
+callers reserve for the uncompressed columns stays valid. */
+
+/** Size of the header of a block, see page0zip.ic */
+#define PAGE_ZIP_BLOCK_HEADER	7
+/** Low bits of the first byte of a block */
+#define PAGE_ZIP_BLOCK_TAG	0x0f
+
+/** Compressed page stream */
+struct page_zip_stream_t : public z_stream {
+	/** Uncompressed block, or NULL for zlib */
+	byte*			block;
+	/** Length of the block */
+	ulint			block_len;
+	/** Allocated size of the block */
+	ulint			block_size;
+	/** Number of bytes of the block that inflate() handed out */
+	ulint			block_pos;
+	/** Length of the index information at the start of the block */
+	ulint			fields_len;
+	/** Compression algorithm */
+	page_zip_algorithm_t	algorithm;
+	/** Compression level */
+	ulint			level;
+};
+
+/**********************************************************************//**
+Prepare a stream for compressing a page. The caller must set
+next_out and avail_out.
+@return Z_OK, or a zlib error code */
+static
+int
+page_zip_deflate_init(
+/*==================*/
+	page_zip_stream_t*	strm,	/*!< out: compressed page stream */
+	page_zip_algorithm_t	algorithm,/*!< in: available algorithm */
+	ulint			level,	/*!< in: compression level */
+	ulint			size,	/*!< in: maximum length of
+					the uncompressed data */
+	mem_heap_t*		heap)	/*!< in/out: memory heap */
+{
+	ut_ad(page_zip_algorithm_is_available(algorithm));
+
+	strm->algorithm = algorithm;
+	strm->level = level;
+
+	if (algorithm == PAGE_ZIP_ALGORITHM_ZLIB) {
+		strm->block = NULL;
+
+		page_zip_set_alloc(strm, heap);
+
+		return(deflateInit2(strm, (int) level,
+				    Z_DEFLATED, UNIV_PAGE_SIZE_SHIFT,
+				    MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY));
+	}
+
+	strm->block = static_cast<byte*>(mem_heap_alloc(heap, size));
+	strm->block_len = 0;
+	strm->block_size = size;
+	strm->block_pos = 0;
+	strm->fields_len = 0;
+	strm->total_in = 0;
+	strm->total_out = 0;
+	strm->msg = NULL;
+
+	return(Z_OK);
+}
+
+/**********************************************************************//**
+Compress with the block compressor of the stream, like deflate().
+@return Z_OK, Z_STREAM_END at Z_FINISH, or Z_BUF_ERROR if the
+compressed block does not fit in avail_out */
+static
+int
+page_zip_block_deflate(
+/*===================*/
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	int			flush)	/*!< in: deflate() flushing method */
+{
+	ut_a(strm->block_len + strm->avail_in <= strm->block_size);
+
+	memcpy(strm->block + strm->block_len, strm->next_in, strm->avail_in);
+	strm->block_len += strm->avail_in;
+	strm->next_in += strm->avail_in;
+	strm->total_in += strm->avail_in;
+	strm->avail_in = 0;
+
+	switch (flush) {
+	case Z_NO_FLUSH:
+		return(Z_OK);
+	case Z_FULL_FLUSH:
+		/* Only the index information is flushed. */
+		ut_ad(!strm->fields_len);
+		strm->fields_len = strm->block_len;
+		return(Z_OK);
+	}
+
+	ut_ad(flush == Z_FINISH);
+
+	if (strm->avail_out <= PAGE_ZIP_BLOCK_HEADER) {
+		return(Z_BUF_ERROR);
+	}
+
+	byte*	out = strm->next_out + PAGE_ZIP_BLOCK_HEADER;
+	ulint	out_size = strm->avail_out - PAGE_ZIP_BLOCK_HEADER;
+	ulint	len = page_zip_compressors[strm->algorithm].compress(
+		strm->level, strm->block, strm->block_len, out, out_size);
+
+	if (len == 0 || len >= strm->block_len) {
+		/* Store the block as is, like zlib would store
+		incompressible data. */
+		if (strm->block_len > out_size) {
+			return(Z_BUF_ERROR);
+		}
+
+		memcpy(out, strm->block, strm->block_len);
+		len = strm->block_len;
+	}
+
+	strm->next_out[0] = static_cast<byte>(
+		strm->algorithm << 4 | PAGE_ZIP_BLOCK_TAG);
+	mach_write_to_2(strm->next_out + 1, strm->fields_len);
+	mach_write_to_2(strm->next_out + 3, strm->block_len);
+	mach_write_to_2(strm->next_out + 5, len);
+
+	len += PAGE_ZIP_BLOCK_HEADER;
+	strm->next_out += len;
+	strm->avail_out -= static_cast<uInt>(len);
+	strm->total_out += len;
+
+	return(Z_STREAM_END);
+}
+
+/**********************************************************************//**
+Release a stream that page_zip_deflate_init() prepared.
+@return deflateEnd() status */
+static
+int
+page_zip_deflate_end(
+/*=================*/
+	z_streamp	strm)	/*!< in/out: compressed page stream */
+{
+	if (static_cast<page_zip_stream_t*>(strm)->block) {
+		return(Z_OK);
+	}
+
+	return(deflateEnd(strm));
+}
+
+/**********************************************************************//**
+Prepare a stream for decompressing a page. The caller must set
+next_in, avail_in, next_out and avail_out. A block that was not
+compressed by zlib is decompressed here, and next_in is advanced
+past it.
+@return Z_OK, Z_DATA_ERROR if the block is corrupted or the algorithm
+is not available, or a zlib error code */
+static
+int
+page_zip_inflate_init(
+/*==================*/
+	page_zip_stream_t*	strm,	/*!< in/out: compressed page stream */
+	mem_heap_t*		heap)	/*!< in/out: memory heap */
+{
+	const byte*	in = strm->next_in;
+
+	if ((*in & PAGE_ZIP_BLOCK_TAG) != PAGE_ZIP_BLOCK_TAG) {
+		strm->algorithm = PAGE_ZIP_ALGORITHM_ZLIB;
+		strm->block = NULL;
+
+		page_zip_set_alloc(strm, heap);
+
+		return(inflateInit2(strm, UNIV_PAGE_SIZE_SHIFT));
+	}
+
+	strm->msg = NULL;
+
+	if (strm->avail_in <= PAGE_ZIP_BLOCK_HEADER) {
+		return(Z_DATA_ERROR);
+	}
+
+	strm->algorithm = static_cast<page_zip_algorithm_t>(*in >> 4);
+	strm->fields_len = mach_read_from_2(in + 1);
+	strm->block_len = mach_read_from_2(in + 3);
+
+	ulint	len = mach_read_from_2(in + 5);
+
+	if (!page_zip_algorithm_is_available(strm->algorithm)
+	    || strm->fields_len > strm->block_len
+	    || strm->block_len > UNIV_PAGE_SIZE + 2 * (REC_MAX_N_FIELDS + 1)
+	    || len > strm->block_len
+	    || len > strm->avail_in - PAGE_ZIP_BLOCK_HEADER) {
+
+		return(Z_DATA_ERROR);
+	}
+
+	in += PAGE_ZIP_BLOCK_HEADER;
+
+	strm->block = static_cast<byte*>(
+		mem_heap_alloc(heap, strm->block_len));
+	strm->block_size = strm->block_len;
+	strm->block_pos = 0;
+
+	if (len == strm->block_len) {
+		memcpy(strm->block, in, len);
+	} else if (page_zip_compressors[strm->algorithm].decompress(
+			   in, len, strm->block, strm->block_len)
+		   != strm->block_len) {
+
+		return(Z_DATA_ERROR);
+	}
+
+	len += PAGE_ZIP_BLOCK_HEADER;
+	strm->next_in += len;
+	strm->avail_in -= static_cast<uInt>(len);
+	strm->total_in = len;
+	strm->total_out = 0;
+
+	return(Z_OK);
+}
+
+/**********************************************************************//**
+Decompress a page stream, like inflate().
+@return inflate() status: Z_OK, Z_STREAM_END, ... */
+static
+int
+page_zip_inflate(
+/*=============*/
+	z_streamp	strm,	/*!< in/out: compressed page stream */
+	int		flush)	/*!< in: inflate() flushing method */
+{
+	page_zip_stream_t*	s = static_cast<page_zip_stream_t*>(strm);
+
+	if (!s->block) {
+		return(inflate(strm, flush));
+	}
+
+	/* Z_BLOCK stops at the end of the index information,
+	like zlib stops at the full flush that terminates it. */
+	ulint	end = flush == Z_BLOCK && s->block_pos <= s->fields_len
+		? s->fields_len : s->block_len;
+	ulint	len = ut_min(end - s->block_pos, ulint(s->avail_out));
+
+	memcpy(s->next_out, s->block + s->block_pos, len);
+	s->block_pos += len;
+	s->next_out += len;
+	s->avail_out -= static_cast<uInt>(len);
+	s->total_out += len;
+
+	if (flush == Z_BLOCK || s->block_pos < s->block_len) {
+		return(Z_OK);
+	}
+
+	return(Z_STREAM_END);
+}
+
+/**********************************************************************//**
+Release a stream that page_zip_inflate_init() prepared.
+@return inflateEnd() status */
+static
+int
+page_zip_inflate_end(
+/*=================*/
+	z_streamp	strm)	/*!< in/out: compressed page stream */
+{
+	if (static_cast<page_zip_stream_t*>(strm)->block) {
+		return(Z_OK);
+	}
+
+	return(inflateEnd(strm));
+}
+
+/* Redefine inflate(), inflateEnd() and deflateEnd(). */
+#undef inflate
+#undef inflateEnd
+#undef deflateEnd
+/** Decompress with the algorithm of the stream.
+@param strm in/out: compressed page stream
+@param flush in: flushing method
+@return inflate() status: Z_OK, Z_STREAM_END, ... */
+#define inflate(strm, flush) page_zip_inflate(strm, flush)
+/** Release a decompression stream.
+@param strm in/out: compressed page stream */
+#define inflateEnd(strm) page_zip_inflate_end(strm)
+/** Release a compression stream.
+@param strm in/out: compressed page stream */
+#define deflateEnd(strm) page_zip_deflate_end(strm)
+
 #if 0 || defined UNIV_DEBUG || defined UNIV_ZIP_DEBUG
 /** Symbol for enabling compression and decompression diagnostics */
 # define PAGE_ZIP_COMPRESS_DBG
@@ -770,18 +1291,32 @@ When this variable is nonzero, it will act
 as a log file name generator. */
 unsigned	page_zip_compress_log;
 
+/** Declaration of the logfile parameter */
+# define FILE_LOGFILE FILE* logfile,
+/** The logfile parameter */
+# define LOGFILE logfile,
+#else /* PAGE_ZIP_COMPRESS_DBG */
+/** Empty declaration of the logfile parameter */
+# define FILE_LOGFILE
+/** Missing logfile parameter */
+# define LOGFILE
+#endif /* PAGE_ZIP_COMPRESS_DBG */
+
 /**********************************************************************//**
-Wrapper for deflate().  Log the operation if page_zip_compress_dbg is set.
+Wrapper for deflate().  Compress with the algorithm of the stream.
+Log the operation if page_zip_compress_dbg is set.
 @return deflate() status: Z_OK, Z_BUF_ERROR, ... */
 static
 int
 page_zip_compress_deflate(
 /*======================*/
-	FILE*		logfile,/*!< in: log file, or NULL */
+	FILE_LOGFILE
 	z_streamp	strm,	/*!< in/out: compressed stream for deflate() */
 	int		flush)	/*!< in: deflate() flushing method */
 {
-	int	status;
+	page_zip_stream_t*	s = static_cast<page_zip_stream_t*>(strm);
+	int			status;
+#ifdef PAGE_ZIP_COMPRESS_DBG
 	if (UNIV_UNLIKELY(page_zip_compress_dbg)) {
 		ut_print_buf(stderr, strm->next_in, strm->avail_in);
 	}
@@ -791,31 +1326,26 @@ page_zip_compress_deflate(
 			perror("fwrite");
 		}
 	}
-	status = deflate(strm, flush);
+#endif /* PAGE_ZIP_COMPRESS_DBG */
+	status = s->block
+		? page_zip_block_deflate(s, flush)
+		: deflate(strm, flush);
+#ifdef PAGE_ZIP_COMPRESS_DBG
 	if (UNIV_UNLIKELY(page_zip_compress_dbg)) {
 		fprintf(stderr, " -> %d\n", status);
 	}
+#endif /* PAGE_ZIP_COMPRESS_DBG */
 	return(status);
 }
 
 /* Redefine deflate(). */
-# undef deflate
-/** Debug wrapper for the zlib compression routine deflate().
+#undef deflate
+/** Wrapper for the zlib compression routine deflate().
 Log the operation if page_zip_compress_dbg is set.
 @param strm in/out: compressed stream
 @param flush in: flushing method
 @return deflate() status: Z_OK, Z_BUF_ERROR, ... */
-# define deflate(strm, flush) page_zip_compress_deflate(logfile, strm, flush)
-/** Declaration of the logfile parameter */
-# define FILE_LOGFILE FILE* logfile,
-/** The logfile parameter */
-# define LOGFILE logfile,
-#else /* PAGE_ZIP_COMPRESS_DBG */
-/** Empty declaration of the logfile parameter */
-# define FILE_LOGFILE
-/** Missing logfile parameter */
-# define LOGFILE
-#endif /* PAGE_ZIP_COMPRESS_DBG */
+#define deflate(strm, flush) page_zip_compress_deflate(LOGFILE strm, flush)
 
 /**********************************************************************//**
 Compress the records of a node pointer page.
@@ -1215,7 +1745,8 @@ page_zip_compress(
 	mtr_t*			mtr)		/*!< in/out: mini-transaction,
 						or NULL */
 {
-	z_stream		c_stream;
+	page_zip_stream_t	c_stream;
+	page_zip_algorithm_t	algorithm;
 	int			err;
 	ulint			n_fields;	/* number of index fields
 						needed */
@@ -1286,6 +1817,21 @@ page_zip_compress(
 		ind_id = index->id;
 	}
 
+	/* The algorithm of the table can be overridden by the
+	caller, see page_zip_compress_write_log_no_data(). */
+	algorithm = static_cast<page_zip_algorithm_t>(
+		level >> PAGE_ZIP_LEVEL_BITS);
+	level &= PAGE_ZIP_LEVEL_MASK;
+
+	if (algorithm == PAGE_ZIP_ALGORITHM_ZLIB && index) {
+		algorithm = static_cast<page_zip_algorithm_t>(
+			DICT_TF2_GET_ZIP_ALGORITHM(index->table->flags2));
+	}
+
+	if (!page_zip_algorithm_is_available(algorithm)) {
+		algorithm = PAGE_ZIP_ALGORITHM_ZLIB;
+	}
+
 	/* The dense directory excludes the infimum and supremum records. */
 	n_dense = page_dir_get_n_heap(page) - PAGE_HEAP_NO_USER_LOW;
 #ifdef PAGE_ZIP_COMPRESS_DBG
@@ -1353,11 +1899,9 @@ page_zip_compress(
 	buf_end = buf + page_zip_get_size(page_zip) - PAGE_DATA;
 
 	/* Compress the data payload. */
-	page_zip_set_alloc(&c_stream, heap);
-
-	err = deflateInit2(&c_stream, (int) level,
-			   Z_DEFLATED, UNIV_PAGE_SIZE_SHIFT,
-			   MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+	err = page_zip_deflate_init(&c_stream, algorithm, level,
+				    (n_fields + 1) * 2 + UNIV_PAGE_SIZE,
+				    heap);
 	ut_a(err == Z_OK);
 
 	c_stream.next_out = buf;
@@ -2981,7 +3525,7 @@ page_zip_decompress_low(
 				page header fields that should not change
 				after page creation */
 {
-	z_stream	d_stream;
+	page_zip_stream_t	d_stream;
 	dict_index_t*	index	= NULL;
 	rec_t**		recs;	/*!< dense page directory, sorted by address */
 	ulint		n_dense;/* number of user records on the page */
@@ -3062,8 +3606,6 @@ zlib_error:
 	memcpy(page + (PAGE_NEW_SUPREMUM - REC_N_NEW_EXTRA_BYTES + 1),
 	       supremum_extra_data, sizeof supremum_extra_data);
 
-	page_zip_set_alloc(&d_stream, heap);
-
 	d_stream.next_in = page_zip->data + PAGE_DATA;
 	/* Subtract the space reserved for
 	the page header and the end marker of the modification log. */
@@ -3071,8 +3613,15 @@ zlib_error:
 	d_stream.next_out = page + PAGE_ZIP_START;
 	d_stream.avail_out = UNIV_PAGE_SIZE - PAGE_ZIP_START;
 
-	if (UNIV_UNLIKELY(inflateInit2(&d_stream, UNIV_PAGE_SIZE_SHIFT)
-			  != Z_OK)) {
+	switch (page_zip_inflate_init(&d_stream, heap)) {
+	case Z_OK:
+		break;
+	case Z_DATA_ERROR:
+		page_zip_fail(("page_zip_decompress:"
+			       " algorithm %u block\n",
+			       (unsigned) d_stream.algorithm));
+		goto zlib_error;
+	default:
 		ut_error;
 	}
 
@@ -171,9 +171,6 @@ RW transaction can commit or rollback (or free views). AC-NL-RO transactions
 will mark their views as closed but not actually free their views.
 */
 
-/** Minimum number of elements to reserve in ReadView::ids_t */
-static const ulint MIN_TRX_IDS = 32;
-
 #ifdef UNIV_DEBUG
 /** Functor to validate the view list. */
 struct	ViewCheck {
@@ -207,116 +204,93 @@ MVCC::validate() const
 #endif /* UNIV_DEBUG */
 
 /**
-Try and increase the size of the array. Old elements are
-copied across.
-@param n 		Make space for n elements */
-
-void
-ReadView::ids_t::reserve(ulint n)
+Create a snapshot, the caller owns the only reference.
+@param start		Source array, sorted
+@param end		Pointer to end of array
+@param value		Additional value to insert in order, or 0 for none.
+			Must not be in the source array.
+@return the new snapshot */
+
+ReadView::ids_t*
+ReadView::ids_t::create(
+	const value_type*	start,
+	const value_type*	end,
+	value_type		value)
 {
-	if (n <= capacity()) {
-		return;
-	}
+	ut_ad(end >= start);
 
-	/** Keep a minimum threshold */
-	if (n < MIN_TRX_IDS) {
-		n = MIN_TRX_IDS;
-	}
+	ulint	n = end - start;
+	ulint	size = n + (value > 0 ? 1 : 0);
 
-	value_type*	p = m_ptr;
+	ut_ad(size > 0);
 
-	m_ptr = new(std::nothrow) value_type[n];
+	byte*	ptr = new(std::nothrow) byte[
+		sizeof(ids_t) + (size - 1) * sizeof(value_type)];
 
-	if (m_ptr == NULL) {
+	if (ptr == NULL) {
 		ib_logf(IB_LOG_LEVEL_FATAL,
 			"Out of memory: read0read.cc:%d", __LINE__);
 	}
 
-	m_reserved = n;
+	ids_t*	ids = reinterpret_cast<ids_t*>(ptr);
 
-	ut_ad(size() < capacity());
+	ids->m_n_refs = 1;
+	ids->m_size = size;
 
-	if (p != NULL) {
+	if (value == 0) {
+		::memcpy(ids->m_data, start, n * sizeof(value_type));
 
-		::memmove(m_ptr, p, size() * sizeof(value_type));
-
-		delete[] p;
+		return(ids);
 	}
-}
 
-/**
-Copy and overwrite this array contents
-@param start		Source array
-@paran end		Pointer to end of array */
+	const value_type*	ub = std::upper_bound(start, end, value);
+	ulint			i = std::distance(start, ub);
 
-void
-ReadView::ids_t::assign(const value_type* start, const value_type* end)
-{
-	ut_ad(end >= start);
+	ut_ad(ub == start || *(ub - 1) != value);
 
-	ulint	n = end - start;
-
-	/* No need to copy the old contents across during reserve(). */
-	clear();
-
-	/* Create extra space if required. */
-	reserve(n);
+	if (i > 0) {
+		::memcpy(ids->m_data, start, i * sizeof(value_type));
+	}
 
-	resize(n);
+	ids->m_data[i] = value;
 
-	ut_ad(size() == n);
+	if (n > i) {
+		::memcpy(ids->m_data + i + 1, ub,
+			 (n - i) * sizeof(value_type));
+	}
 
-	::memmove(m_ptr, start, size() * sizeof(value_type));
+	return(ids);
 }
 
 /**
-Append a value to the array.
-@param value		the value to append */
+Add a reference. The caller must own trx_sys_t::mutex or another
+reference to the snapshot. */
 
 void
-ReadView::ids_t::push_back(value_type value)
+ReadView::ids_t::acquire()
 {
-	if (capacity() <= size()) {
-		reserve(size() * 2);
-	}
+	ut_ad(m_n_refs > 0);
 
-	m_ptr[m_size++] = value;
-	ut_ad(size() <= capacity());
+	os_atomic_increment_ulint(&m_n_refs, 1);
 }
 
 /**
-Insert the value in the correct slot, preserving the order. Doesn't
-check for duplicates. */
+Release a reference, free the snapshot if it was the last.
+@param ids		Snapshot to release, can be NULL. Set to NULL on
+			return. */
 
 void
-ReadView::ids_t::insert(value_type value)
+ReadView::ids_t::release(ids_t*& ids)
 {
-	ut_ad(value > 0);
-
-	reserve(size() + 1);
+	if (ids != NULL) {
 
-	if (empty() || back() < value) {
-		push_back(value);
-		return;
-	}
+		ut_ad(ids->m_n_refs > 0);
 
-	value_type*	end = data() + size();
-	value_type*	ub = std::upper_bound(data(), end, value);
-
-	if (ub == end) {
-		push_back(value);
-	} else {
-		ut_ad(ub < end);
-
-		ulint	n_elems = std::distance(ub, end);
-		ulint	n = n_elems * sizeof(value_type);
-
-		/* Note: Copying overlapped memory locations. */
-		::memmove(ub + 1, ub, n);
-
-		*ub = value;
+		if (os_atomic_decrement_ulint(&ids->m_n_refs, 1) == 0) {
+			delete[] reinterpret_cast<byte*>(ids);
+		}
 
-		resize(size() + 1);
+		ids = NULL;
 	}
 }
 
@@ -337,12 +311,14 @@ ReadView::ReadView()
 ReadView destructor */
 ReadView::~ReadView()
 {
-	// Do nothing
+	ids_t::release(m_ids);
 }
 
 /** Constructor
 @param size		Number of views to pre-allocate */
 MVCC::MVCC(ulint size)
+	:
+	m_ids()
 {
 	UT_LIST_INIT(m_free, &ReadView::m_view_list);
 	UT_LIST_INIT(m_views, &ReadView::m_view_list);
@@ -372,74 +348,62 @@ MVCC::~MVCC()
 	}
 
 	ut_a(UT_LIST_GET_LEN(m_views) == 0);
+
+	ReadView::ids_t::release(m_ids);
 }
 
 /**
-Copy the transaction ids from the source vector */
+Forget the shared snapshot of the active RW transaction ids. Must be
+called whenever trx_sys_t::rw_trx_ids is modified, with the
+trx_sys_t::mutex still held. */
 
 void
-ReadView::copy_trx_ids(const trx_ids_t& trx_ids)
+MVCC::snapshot_invalidate()
 {
-	ulint	size = trx_ids.size();
-
-	if (m_creator_trx_id > 0) {
-		ut_ad(size > 0);
-		--size;
-	}
-
-	if (size == 0) {
-		m_ids.clear();
-		return;
-	}
-
-	m_ids.reserve(size);
-	m_ids.resize(size);
-
-	ids_t::value_type*	p = m_ids.data();
-
-	/* Copy all the trx_ids except the creator trx id */
-
-	if (m_creator_trx_id > 0) {
-
-		/* Note: We go through all this trouble because it is
-		unclear whether std::vector::resize() will cause an
-		overhead or not. We should test this extensively and
-		if the vector to vector copy is fast enough then get
-		rid of this code and replace it with more readable
-		and obvious code. The code below does exactly one copy,
-		and filters out the creator's trx id. */
-
-		trx_ids_t::const_iterator	it = std::lower_bound(
-			trx_ids.begin(), trx_ids.end(), m_creator_trx_id);
-
-		ut_ad(it != trx_ids.end() && *it == m_creator_trx_id);
+	ut_ad(mutex_own(&trx_sys->mutex));
 
-		ulint	i = std::distance(trx_ids.begin(), it);
-		ulint	n = i * sizeof(trx_ids_t::value_type);
+	ReadView::ids_t::release(m_ids);
+}
 
-		::memmove(p, &trx_ids[0], n);
+/**
+Get the snapshot of trx_sys_t::rw_trx_ids, create it if the set has
+changed since the last view was opened. All the views opened between
+two changes of the set share the same snapshot.
+@return snapshot with a reference owned by the caller, or NULL if there
+are no active RW transactions */
+
+ReadView::ids_t*
+MVCC::get_ids()
+{
+	ut_ad(mutex_own(&trx_sys->mutex));
 
-		n = (trx_ids.size() - i - 1) * sizeof(trx_ids_t::value_type);
+	if (m_ids == NULL) {
 
-		ut_ad(i + (n / sizeof(trx_ids_t::value_type)) == m_ids.size());
+		const trx_ids_t&	trx_ids = trx_sys->rw_trx_ids;
 
-		if (n > 0) {
-			::memmove(p + i, &trx_ids[i + 1], n);
+		if (trx_ids.empty()) {
+			return(NULL);
 		}
-	} else {
-		ulint	n = size * sizeof(trx_ids_t::value_type);
 
-		::memmove(p, &trx_ids[0], n);
+		m_ids = ReadView::ids_t::create(
+			&trx_ids[0], &trx_ids[0] + trx_ids.size(), 0);
 	}
+
+	m_ids->acquire();
+
+	return(m_ids);
 }
 
 /**
 Opens a read view where exactly the transactions serialized before this
 point in time are seen in the view.
-@param id		Creator transaction id */
+@param id		Creator transaction id
+@param ids		Snapshot of the active RW transaction ids, or NULL if
+			there are none. The view takes over the caller's
+			reference. */
 
 void
-ReadView::prepare(trx_id_t id)
+ReadView::prepare(trx_id_t id, ids_t* ids)
 {
 	ut_ad(mutex_own(&trx_sys->mutex));
 
@@ -447,11 +411,13 @@ ReadView::prepare(trx_id_t id)
 
 	m_low_limit_no = m_low_limit_id = trx_sys->max_trx_id;
 
-	if (!trx_sys->rw_trx_ids.empty()) {
-		copy_trx_ids(trx_sys->rw_trx_ids);
-	} else {
-		m_ids.clear();
-	}
+	/* The snapshot is shared with the other views opened since the
+	last change of trx_sys->rw_trx_ids. It includes our own id if we
+	are a RW transaction, changes_visible() checks for that first. */
+
+	ids_t::release(m_ids);
+
+	m_ids = ids;
 
 	if (UT_LIST_GET_LEN(trx_sys->serialisation_list) > 0) {
 		const trx_t*	trx;
@@ -470,8 +436,22 @@ Complete the read view creation */
 void
 ReadView::complete()
 {
-	/* The first active transaction has the smallest id. */
-	m_up_limit_id = !m_ids.empty() ? m_ids.front() : m_low_limit_id;
+	m_up_limit_id = m_low_limit_id;
+
+	if (m_ids != NULL) {
+		const trx_id_t*	p = m_ids->data();
+		const trx_id_t*	end = p + m_ids->size();
+
+		/* Skip the creator's own id, which is always visible. */
+		if (*p == m_creator_trx_id) {
+			++p;
+		}
+
+		/* The first active transaction has the smallest id. */
+		if (p < end) {
+			m_up_limit_id = *p;
+		}
+	}
 
 	ut_ad(m_up_limit_id <= m_low_limit_id);
 
@@ -528,6 +508,8 @@ MVCC::view_release(ReadView*& view)
 
 	ut_ad(view->m_creator_trx_id == 0);
 
+	ReadView::ids_t::release(view->m_ids);
+
 	UT_LIST_REMOVE(m_views, view);
 
 	UT_LIST_ADD_LAST(m_free, view);
@@ -586,7 +568,7 @@ MVCC::view_open(ReadView*& view, trx_t* trx)
 
 	if (view != NULL) {
 
-		view->prepare(trx->id);
+		view->prepare(trx->id, get_ids());
 
 		view->complete();
 
@@ -631,15 +613,20 @@ void
 ReadView::copy_prepare(const ReadView& other)
 {
 	ut_ad(&other != this);
+	ut_ad(mutex_own(&trx_sys->mutex));
 
-	if (!other.m_ids.empty()) {
-		const ids_t::value_type* 	p = other.m_ids.data();
+	/* Share the snapshot of the other view. It cannot be freed
+	under us because the other view can only release it while
+	holding trx_sys->mutex. */
 
-		m_ids.assign(p, p + other.m_ids.size());
-	} else {
-		m_ids.clear();
+	if (other.m_ids != NULL) {
+		other.m_ids->acquire();
 	}
 
+	ids_t::release(m_ids);
+
+	m_ids = other.m_ids;
+
 	m_up_limit_id = other.m_up_limit_id;
 
 	m_low_limit_no = other.m_low_limit_no;
@@ -658,16 +645,36 @@ ReadView::copy_complete()
 {
 	ut_ad(!trx_sys_mutex_own());
 
-	if (m_creator_trx_id > 0) {
-		m_ids.insert(m_creator_trx_id);
+	/* The snapshot of a RW transaction already contains the creator
+	id, unless the transaction became RW after it opened the view. Then
+	the snapshot has to be copied to add the id. This is rare and it is
+	done outside trx_sys->mutex. */
+
+	if (m_creator_trx_id > 0
+	    && (m_ids == NULL || !m_ids->contains(m_creator_trx_id))) {
+
+		ids_t*	ids;
+
+		if (m_ids == NULL) {
+			ids = ids_t::create(NULL, NULL, m_creator_trx_id);
+		} else {
+			const trx_id_t*	p = m_ids->data();
+
+			ids = ids_t::create(
+				p, p + m_ids->size(), m_creator_trx_id);
+		}
+
+		ids_t::release(m_ids);
+
+		m_ids = ids;
 	}
 
-	if (!m_ids.empty()) {
+	if (m_ids != NULL) {
 
 		using std::min;
 
 		/* The last active transaction has the smallest id. */
-		m_up_limit_id = min(m_ids.front(), m_up_limit_id);
+		m_up_limit_id = min(m_ids->front(), m_up_limit_id);
 	}
 
 	ut_ad(m_up_limit_id <= m_low_limit_id);
@@ -691,7 +698,7 @@ MVCC::clone_oldest_view(ReadView* view)
 
 	if (oldest_view == NULL) {
 
-		view->prepare(0);
+		view->prepare(0, get_ids());
 
 		trx_sys_mutex_exit();
 
@@ -3618,6 +3618,9 @@ row_import_for_mysql(
 		return(row_import_cleanup(prebuilt, trx, err));
 	}
 
+	fil_space_set_compression(
+		table->space, dict_table_page_compression(table));
+
 	row_mysql_unlock_data_dictionary(trx);
 
 	mem_free(filepath);
@@ -27,6 +27,8 @@ Completed by Sunny Bains and Marko Makela
 #include "ha_prototypes.h"
 
 #include "row0merge.h"
+#include "btr0bulk.h"
+#include "buf0lru.h"
 #include "row0ext.h"
 #include "row0log.h"
 #include "row0ins.h"
@@ -41,6 +43,8 @@ Completed by Sunny Bains and Marko Makela
 #include "handler0alter.h"
 #include "srv0space.h"
 
+#include <vector>
+
 /* Ignore posix_fadvise() on those platforms where it does not exist */
 #if defined _WIN32
 # define posix_fadvise(fd, offset, len, advice) /* nothing */
@@ -464,10 +468,23 @@ row_merge_dup_report(
 	row_merge_dup_t*	dup,	/*!< in/out: for reporting duplicates */
 	const dfield_t*		entry)	/*!< in: duplicate index entry */
 {
-	if (!dup->n_dup++) {
+	if (dup->n_dup++) {
 		/* Only report the first duplicate record,
 		but count all duplicate records. */
+	} else if (dup->mutex == NULL) {
 		innobase_fields_to_mysql(dup->table, dup->index, entry);
+	} else {
+		/* The threads building the indexes share the MySQL
+		record buffer: only the first of them reports. */
+		mutex_enter(dup->mutex);
+
+		if (*dup->reported == NULL) {
+			*dup->reported = dup->index;
+			innobase_fields_to_mysql(
+				dup->table, dup->index, entry);
+		}
+
+		mutex_exit(dup->mutex);
 	}
 }
 
@@ -1520,7 +1537,8 @@ write_buffers:
 			if (buf->n_tuples) {
 				if (dict_index_is_unique(buf->index)) {
 					row_merge_dup_t	dup = {
-						buf->index, table, col_map, 0};
+						buf->index, table, col_map, 0,
+						NULL, NULL};
 
 					row_merge_buf_sort(buf, &dup);
 
@@ -2111,19 +2129,57 @@ row_merge_copy_blobs(
 	}
 }
 
+/********************************************************************//**
+Completes the bulk load of an index and writes the pages of its
+tablespace to disk. The bulk load does not write redo log for the
+pages it builds, so they must be durable before any redo logged
+change is made to them.
+@return DB_SUCCESS or error number */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+row_merge_bulk_finish(
+/*==================*/
+	BtrBulk*		btr_bulk,/*!< in/out: bulk load */
+	const dict_index_t*	index,	/*!< in: index */
+	const trx_t*		trx,	/*!< in: transaction */
+	bool			flush,	/*!< in: whether to write the
+					pages to disk */
+	dberr_t			error)	/*!< in: error from the inserts,
+					or DB_SUCCESS */
+{
+	error = btr_bulk->finish(error);
+
+	if (error == DB_SUCCESS && flush
+	    && !dict_table_is_temporary(index->table)) {
+		buf_LRU_flush_or_remove_pages(
+			index->space, BUF_REMOVE_FLUSH_WRITE, trx);
+
+		if (trx_is_interrupted(trx)) {
+			error = DB_INTERRUPTED;
+		}
+	}
+
+	return(error);
+}
+
 /********************************************************************//**
 Read sorted file containing index data tuples and insert these data
-tuples to the index
+tuples to the index. The tuples are loaded bottom-up into the empty
+index by BtrBulk, except in ROW_FORMAT=COMPRESSED and from the first
+record that needs off-page columns, where they are inserted one by one.
 @return DB_SUCCESS or error number */
 static __attribute__((nonnull, warn_unused_result))
 dberr_t
 row_merge_insert_index_tuples(
 /*==========================*/
-	trx_id_t		trx_id, /*!< in: transaction identifier */
+	const trx_t*		trx,	/*!< in: transaction */
 	dict_index_t*		index,	/*!< in: index */
 	const dict_table_t*	old_table,/*!< in: old table */
 	int			fd,	/*!< in: file descriptor */
-	row_merge_block_t*	block)	/*!< in/out: file buffer */
+	row_merge_block_t*	block,	/*!< in/out: file buffer */
+	bool			flush)	/*!< in: whether to write the
+					bulk loaded pages to disk at the
+					end; if false, the caller must */
 {
 	const byte*		b;
 	mem_heap_t*		heap;
@@ -2133,6 +2189,10 @@ row_merge_insert_index_tuples(
 	ulint			foffs = 0;
 	ulint*			offsets;
 	mrec_buf_t*		buf;
+	const trx_id_t		trx_id = trx->id;
+	/* BtrBulk only builds uncompressed pages. */
+	bool			bulk = !dict_table_zip_size(index->table);
+	BtrBulk			btr_bulk(index, trx);
 	DBUG_ENTER("row_merge_insert_index_tuples");
 
 	ut_ad(!srv_read_only_mode);
@@ -2223,6 +2283,38 @@ row_merge_insert_index_tuples(
 			}
 
 			ut_ad(dtuple_validate(dtuple));
+
+			if (bulk
+			    && (n_ext || page_zip_rec_needs_ext(
+					rec_get_converted_size(
+						index, dtuple, 0),
+					dict_table_is_comp(index->table),
+					dtuple_get_n_fields(dtuple), 0))) {
+				/* BtrBulk does not move columns
+				off-page. Complete the tree, and insert
+				this and the remaining records one by
+				one. */
+				bulk = false;
+				error = row_merge_bulk_finish(
+					&btr_bulk, index, trx, true,
+					DB_SUCCESS);
+
+				if (error != DB_SUCCESS) {
+					goto err_exit;
+				}
+			}
+
+			if (bulk) {
+				error = btr_bulk.insert(dtuple);
+
+				if (error != DB_SUCCESS) {
+					goto err_exit;
+				}
+
+				mem_heap_empty(tuple_heap);
+				continue;
+			}
+
 			log_free_check();
 
 			mtr_start(&mtr);
@@ -2314,6 +2406,11 @@ row_merge_insert_index_tuples(
 	}
 
 err_exit:
+	if (bulk) {
+		error = row_merge_bulk_finish(
+			&btr_bulk, index, trx, flush, error);
+	}
+
 	mem_heap_free(tuple_heap);
 	mem_heap_free(ins_heap);
 	mem_heap_free(heap);
@@ -3263,6 +3360,747 @@ row_merge_drop_table(
 	return(row_drop_table_for_mysql(table->name, trx, false, false));
 }
 
+#ifdef UNIV_PFS_THREAD
+mysql_pfs_key_t	row_merge_thread_key;
+#endif /* UNIV_PFS_THREAD */
+
+/** State shared by the threads that build secondary indexes in
+parallel, see innodb_sort_threads */
+struct row_merge_pll_t {
+	ib_mutex_t		mutex;		/*!< mutex protecting the
+						offset and n_rec of files[],
+						and reported */
+	const dict_index_t*	reported;	/*!< the index whose duplicate
+						was copied to table, or NULL */
+	ulint			n_active;	/*!< number of threads that
+						have not finished */
+	bool			failed;		/*!< true if a thread failed;
+						the others stop early */
+	trx_t*			trx;		/*!< transaction */
+	struct TABLE*		table;		/*!< MySQL table object, for
+						reporting duplicates */
+	const dict_table_t*	old_table;	/*!< table where rows are
+						read from */
+	bool			online;		/*!< true if creating indexes
+						online */
+	dict_index_t**		index;		/*!< indexes to be created */
+	merge_file_t*		files;		/*!< temporary files of
+						index[] */
+	ulint			n_index;	/*!< number of indexes */
+};
+
+/** A thread that builds secondary indexes in parallel */
+struct row_merge_pll_thread_t {
+	row_merge_pll_t*	pll;		/*!< shared state */
+	const dtuple_t*		low;		/*!< scan: first key of the
+						range of the clustered index,
+						or NULL if the range starts
+						from the first record */
+	const dtuple_t*		high;		/*!< scan: key where the range
+						ends (not included), or NULL
+						if it ends at the last record */
+	ulint			thread_no;	/*!< merge: the thread builds
+						the indexes whose number
+						modulo n_threads is this */
+	ulint			n_threads;	/*!< merge: number of threads;
+						0 for a scan thread */
+	dberr_t			err;		/*!< out: error code */
+	ulint			err_index;	/*!< out: number of the index
+						that failed, if err is not
+						DB_SUCCESS */
+};
+
+/*********************************************************************//**
+Splits the clustered index into key ranges of about equal size, using
+the node pointers of the highest level that has enough of them.
+@return number of ranges, at most n_ranges */
+static
+ulint
+row_merge_split_clustered_index(
+/*============================*/
+	dict_index_t*	index,		/*!< in: clustered index */
+	ulint		n_ranges,	/*!< in: number of ranges wanted */
+	dtuple_t**	bounds,		/*!< out: bounds[i] is the first key
+					of range i + 1 */
+	mem_heap_t*	heap)		/*!< in: memory heap for bounds[] */
+{
+	std::vector<const rec_t*>	node_ptrs;
+	mtr_t				mtr;
+	buf_block_t*			block;
+	ulint				space = dict_index_get_space(index);
+	ulint				zip_size = dict_table_zip_size(
+		index->table);
+	ulint				n_uniq
+		= dict_index_get_n_unique_in_tree(index);
+	ulint				n = 1;
+
+	mtr_start(&mtr);
+
+	mtr_s_lock(dict_index_get_lock(index), &mtr);
+
+	block = btr_block_get(space, zip_size, dict_index_get_page(index),
+			      RW_S_LATCH, index, &mtr);
+
+	while (btr_page_get_level(buf_block_get_frame(block), &mtr) > 0) {
+		ulint		level = btr_page_get_level(
+			buf_block_get_frame(block), &mtr);
+		ulint		child_page_no = FIL_NULL;
+		const page_t*	page;
+
+		node_ptrs.clear();
+
+		/* Collect the node pointers of the level, from the
+		leftmost page to the right. */
+		for (;;) {
+			const rec_t*	rec;
+
+			page = buf_block_get_frame(block);
+
+			for (rec = page_rec_get_next_const(
+				     page_get_infimum_rec(page));
+			     !page_rec_is_supremum(rec);
+			     rec = page_rec_get_next_const(rec)) {
+
+				if (child_page_no == FIL_NULL) {
+					ulint	offsets_[REC_OFFS_NORMAL_SIZE];
+					ulint*	offsets = offsets_;
+					mem_heap_t*	offsets_heap = NULL;
+
+					rec_offs_init(offsets_);
+
+					offsets = rec_get_offsets(
+						rec, index, offsets,
+						ULINT_UNDEFINED,
+						&offsets_heap);
+
+					child_page_no =
+						btr_node_ptr_get_child_page_no(
+							rec, offsets);
+
+					if (offsets_heap != NULL) {
+						mem_heap_free(offsets_heap);
+					}
+				}
+
+				/* The key of the first node pointer of
+				the level is the minimum of all keys. */
+				if (!(rec_get_info_bits(
+					      rec, page_is_comp(page))
+				      & REC_INFO_MIN_REC_FLAG)) {
+					node_ptrs.push_back(rec);
+				}
+			}
+
+			ulint	next_page_no = btr_page_get_next(page, &mtr);
+
+			if (next_page_no == FIL_NULL) {
+				break;
+			}
+
+			block = btr_block_get(space, zip_size, next_page_no,
+					      RW_S_LATCH, index, &mtr);
+		}
+
+		if (level == 1 || node_ptrs.size() >= 8 * n_ranges) {
+			break;
+		}
+
+		ut_a(child_page_no != FIL_NULL);
+
+		block = btr_block_get(space, zip_size, child_page_no,
+				      RW_S_LATCH, index, &mtr);
+	}
+
+	if (!node_ptrs.empty()) {
+		n = ut_min(n_ranges, node_ptrs.size() + 1);
+
+		for (ulint i = 1; i < n; i++) {
+			rec_t*	rec = const_cast<rec_t*>(
+				node_ptrs[i * node_ptrs.size() / n]);
+
+			bounds[i - 1] = dict_index_build_data_tuple(
+				index, rec, n_uniq, heap);
+
+			dtuple_set_info_bits(bounds[i - 1], 0);
+		}
+	}
+
+	mtr_commit(&mtr);
+
+	return(n);
+}
+
+/*********************************************************************//**
+Sorts the entries of a merge buffer and appends them to the temporary
+file of the index as one block.
+@return DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+row_merge_pll_write(
+/*================*/
+	row_merge_pll_t*	pll,	/*!< in/out: shared state */
+	ulint			i,	/*!< in: number of the index */
+	row_merge_buf_t*	buf,	/*!< in: buffer of the index */
+	row_merge_block_t*	block)	/*!< out: buffer for writing */
+{
+	merge_file_t*	file = &pll->files[i];
+	ulint		offset;
+
+	if (dict_index_is_unique(buf->index)) {
+		row_merge_dup_t	dup = {
+			buf->index, pll->table, NULL, 0,
+			&pll->mutex, &pll->reported};
+
+		row_merge_buf_sort(buf, &dup);
+
+		if (dup.n_dup) {
+			return(DB_DUPLICATE_KEY);
+		}
+	} else {
+		row_merge_buf_sort(buf, NULL);
+	}
+
+	row_merge_buf_write(buf, file, block);
+
+	/* The blocks are independent sorted runs: the threads append
+	them in any order. */
+	mutex_enter(&pll->mutex);
+	offset = file->offset++;
+	file->n_rec += buf->n_tuples;
+	mutex_exit(&pll->mutex);
+
+	if (!row_merge_write(file->fd, offset, block)) {
+		return(DB_OUT_OF_FILE_SPACE);
+	}
+
+	UNIV_MEM_INVALID(&block[0], srv_sort_buf_size);
+
+	return(DB_SUCCESS);
+}
+
+/*********************************************************************//**
+Reads a key range of the clustered index and writes sorted blocks of
+the entries of the secondary indexes to the shared temporary files.
+Unlike row_merge_read_clustered_index(), this only handles creating
+secondary indexes without rebuilding the table. */
+static __attribute__((nonnull))
+void
+row_merge_pll_scan(
+/*===============*/
+	row_merge_pll_thread_t*	thr)	/*!< in/out: the thread */
+{
+	row_merge_pll_t*	pll = thr->pll;
+	trx_t*			trx = pll->trx;
+	const dict_table_t*	old_table = pll->old_table;
+	dict_index_t*		clust_index
+		= dict_table_get_first_index(old_table);
+	row_merge_buf_t**	merge_buf;
+	row_merge_block_t*	block;
+	ulint			block_size = srv_sort_buf_size;
+	mem_heap_t*		row_heap;
+	btr_pcur_t		pcur;
+	mtr_t			mtr;
+	doc_id_t		doc_id = 0;
+
+	thr->err = DB_SUCCESS;
+
+	block = static_cast<row_merge_block_t*>(
+		os_mem_alloc_large(&block_size));
+
+	if (block == NULL) {
+		thr->err = DB_OUT_OF_MEMORY;
+		thr->err_index = 0;
+		return;
+	}
+
+	merge_buf = static_cast<row_merge_buf_t**>(
+		mem_alloc(pll->n_index * sizeof *merge_buf));
+
+	for (ulint i = 0; i < pll->n_index; i++) {
+		merge_buf[i] = row_merge_buf_create(pll->index[i]);
+	}
+
+	row_heap = mem_heap_create(sizeof(mrec_buf_t));
+
+	mtr_start(&mtr);
+
+	if (thr->low == NULL) {
+		btr_pcur_open_at_index_side(
+			true, clust_index, BTR_SEARCH_LEAF, &pcur, true, 0,
+			&mtr);
+	} else {
+		btr_pcur_open(clust_index, thr->low, PAGE_CUR_GE,
+			      BTR_SEARCH_LEAF, &pcur, &mtr);
+
+		/* The loop below starts by moving to the next record. */
+		page_cur_move_to_prev(btr_pcur_get_page_cur(&pcur));
+	}
+
+	for (;;) {
+		const rec_t*	rec;
+		ulint*		offsets;
+		const dtuple_t*	row;
+		row_ext_t*	ext;
+		page_cur_t*	cur	= btr_pcur_get_page_cur(&pcur);
+
+		page_cur_move_to_next(cur);
+
+		if (page_cur_is_after_last(cur)) {
+			if (pll->failed) {
+				goto func_exit;
+			}
+
+			if (trx_is_interrupted(trx)) {
+				thr->err = DB_INTERRUPTED;
+				thr->err_index = 0;
+				goto func_exit;
+			}
+
+			if (rw_lock_get_waiters(
+				    dict_index_get_lock(clust_index))) {
+				/* Yield to the waiters on the clustered
+				index tree lock, like
+				row_merge_read_clustered_index() does. */
+				btr_pcur_move_to_prev_on_page(&pcur);
+				btr_pcur_store_position(&pcur, &mtr);
+				mtr_commit(&mtr);
+
+				os_thread_yield();
+
+				mtr_start(&mtr);
+				btr_pcur_restore_position(
+					BTR_SEARCH_LEAF, &pcur, &mtr);
+
+				if (!btr_pcur_move_to_next_user_rec(
+					    &pcur, &mtr)) {
+					break;
+				}
+			} else {
+				ulint		next_page_no;
+				buf_block_t*	next_block;
+
+				next_page_no = btr_page_get_next(
+					page_cur_get_page(cur), &mtr);
+
+				if (next_page_no == FIL_NULL) {
+					break;
+				}
+
+				next_block = page_cur_get_block(cur);
+				next_block = btr_block_get(
+					buf_block_get_space(next_block),
+					buf_block_get_zip_size(next_block),
+					next_page_no, BTR_SEARCH_LEAF,
+					clust_index, &mtr);
+
+				btr_leaf_page_release(page_cur_get_block(cur),
+						      BTR_SEARCH_LEAF, &mtr);
+				page_cur_set_before_first(next_block, cur);
+				page_cur_move_to_next(cur);
+
+				ut_ad(!page_cur_is_after_last(cur));
+			}
+		}
+
+		rec = page_cur_get_rec(cur);
+
+		offsets = rec_get_offsets(rec, clust_index, NULL,
+					  ULINT_UNDEFINED, &row_heap);
+
+		if (thr->high != NULL
+		    && cmp_dtuple_rec(thr->high, rec, offsets) <= 0) {
+			/* The next thread reads the rest. */
+			break;
+		}
+
+		if (pll->online) {
+			/* Perform a REPEATABLE READ, see
+			row_merge_read_clustered_index(). */
+			ut_ad(MVCC::is_view_active(trx->read_view));
+
+			if (!trx->read_view->changes_visible(
+				    row_get_rec_trx_id(
+					    rec, clust_index, offsets))) {
+				rec_t*	old_vers;
+
+				row_vers_build_for_consistent_read(
+					rec, &mtr, clust_index, &offsets,
+					trx->read_view, &row_heap,
+					row_heap, &old_vers);
+
+				rec = old_vers;
+
+				if (!rec) {
+					continue;
+				}
+			}
+		}
+
+		if (rec_get_deleted_flag(rec, dict_table_is_comp(old_table))) {
+			continue;
+		}
+
+		ut_ad(!rec_offs_any_null_extern(rec, offsets));
+
+		row = row_build(ROW_COPY_POINTERS, clust_index,
+				rec, offsets, old_table,
+				NULL, NULL, &ext, row_heap);
+		ut_ad(row);
+
+		for (ulint i = 0; i < pll->n_index; i++) {
+			row_merge_buf_t*	buf = merge_buf[i];
+
+			if (row_merge_buf_add(buf, NULL, old_table, NULL,
+					      row, ext, &doc_id)) {
+				continue;
+			}
+
+			/* The buffer is full. */
+			ut_ad(buf->n_tuples);
+
+			thr->err = row_merge_pll_write(pll, i, buf, block);
+
+			if (thr->err != DB_SUCCESS) {
+				thr->err_index = i;
+				goto func_exit;
+			}
+
+			merge_buf[i] = buf = row_merge_buf_empty(buf);
+
+			if (!row_merge_buf_add(buf, NULL, old_table, NULL,
+					       row, ext, &doc_id)) {
+				/* An empty buffer should have enough
+				room for at least one record. */
+				ut_error;
+			}
+		}
+
+		mem_heap_empty(row_heap);
+	}
+
+	mtr_commit(&mtr);
+
+	for (ulint i = 0; i < pll->n_index; i++) {
+		if (merge_buf[i]->n_tuples == 0) {
+			continue;
+		}
+
+		thr->err = row_merge_pll_write(pll, i, merge_buf[i], block);
+
+		if (thr->err != DB_SUCCESS) {
+			thr->err_index = i;
+			break;
+		}
+	}
+
+	goto all_done;
+
+func_exit:
+	mtr_commit(&mtr);
+
+all_done:
+	btr_pcur_close(&pcur);
+	mem_heap_free(row_heap);
+
+	for (ulint i = 0; i < pll->n_index; i++) {
+		row_merge_buf_free(merge_buf[i]);
+	}
+
+	mem_free(merge_buf);
+	os_mem_free_large(block, block_size);
+}
+
+/*********************************************************************//**
+Sorts the temporary files of some of the indexes and inserts the
+entries into the indexes. */
+static __attribute__((nonnull))
+void
+row_merge_pll_insert(
+/*=================*/
+	row_merge_pll_thread_t*	thr)	/*!< in/out: the thread */
+{
+	row_merge_pll_t*	pll = thr->pll;
+	row_merge_block_t*	block;
+	ulint			block_size = 3 * srv_sort_buf_size;
+	int			tmpfd;
+
+	thr->err = DB_SUCCESS;
+	thr->err_index = thr->thread_no;
+
+	block = static_cast<row_merge_block_t*>(
+		os_mem_alloc_large(&block_size));
+
+	if (block == NULL) {
+		thr->err = DB_OUT_OF_MEMORY;
+		return;
+	}
+
+	tmpfd = row_merge_file_create_low();
+
+	if (tmpfd < 0) {
+		os_mem_free_large(block, block_size);
+		thr->err = DB_OUT_OF_MEMORY;
+		return;
+	}
+
+	for (ulint i = thr->thread_no;
+	     i < pll->n_index && !pll->failed;
+	     i += thr->n_threads) {
+
+		row_merge_dup_t	dup = {
+			pll->index[i], pll->table, NULL, 0,
+			&pll->mutex, &pll->reported};
+
+		thr->err = row_merge_sort(
+			pll->trx, &dup, &pll->files[i], block, &tmpfd);
+
+		if (thr->err == DB_SUCCESS) {
+			thr->err = row_merge_insert_index_tuples(
+				pll->trx, pll->index[i], pll->old_table,
+				pll->files[i].fd, block, false);
+		}
+
+		if (thr->err != DB_SUCCESS) {
+			thr->err_index = i;
+			break;
+		}
+	}
+
+	row_merge_file_destroy_low(tmpfd);
+	os_mem_free_large(block, block_size);
+}
+
+/*********************************************************************//**
+A thread that scans a range of the clustered index, or sorts and
+inserts the entries of some of the indexes.
+@return a dummy parameter */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(row_merge_pll_thread)(
+/*=================================*/
+	void*	arg)	/*!< in/out: row_merge_pll_thread_t */
+{
+	row_merge_pll_thread_t*	thr
+		= static_cast<row_merge_pll_thread_t*>(arg);
+	row_merge_pll_t*	pll = thr->pll;
+
+#ifdef UNIV_PFS_THREAD
+	pfs_register_thread(row_merge_thread_key);
+#endif /* UNIV_PFS_THREAD */
+
+	if (thr->n_threads == 0) {
+		row_merge_pll_scan(thr);
+	} else {
+		row_merge_pll_insert(thr);
+	}
+
+	if (thr->err != DB_SUCCESS) {
+		pll->failed = true;
+	}
+
+	os_atomic_decrement_ulint(&pll->n_active, 1);
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*********************************************************************//**
+Runs row_merge_pll_thread for each element of thr[] and waits for all of
+them to finish.
+@return DB_SUCCESS or the error code of a failed thread */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+row_merge_pll_run(
+/*==============*/
+	row_merge_pll_t*	pll,	/*!< in/out: shared state */
+	row_merge_pll_thread_t*	thr,	/*!< in/out: the threads */
+	ulint			n,	/*!< in: number of threads */
+	ulint*			err_index)/*!< out: number of the index
+					that failed */
+{
+	dberr_t	err = DB_SUCCESS;
+
+	pll->n_active = n;
+	pll->failed = false;
+
+	for (ulint i = 0; i < n; i++) {
+		os_thread_create(row_merge_pll_thread, &thr[i], NULL);
+	}
+
+	while (pll->n_active > 0) {
+		os_thread_sleep(10000);
+	}
+
+	for (ulint i = 0; i < n; i++) {
+		if (thr[i].err == DB_SUCCESS) {
+			continue;
+		}
+
+		/* A duplicate must be reported on the index whose
+		entry was copied to the MySQL record. A thread may
+		have stopped because another failed: ignore that. */
+		if (err == DB_SUCCESS
+		    || (thr[i].err == DB_DUPLICATE_KEY
+			&& pll->index[thr[i].err_index] == pll->reported)) {
+			err = thr[i].err;
+			*err_index = thr[i].err_index;
+		}
+	}
+
+	return(err);
+}
+
+/*********************************************************************//**
+Builds secondary indexes without rebuilding the table, using n_threads
+threads. The threads first read key ranges of the clustered index and
+write sorted blocks of index entries to the shared temporary files.
+Then each of them merge sorts the files of some of the indexes and
+inserts the entries into the indexes.
+@return DB_SUCCESS or error code */
+static __attribute__((nonnull, warn_unused_result))
+dberr_t
+row_merge_build_indexes_pll(
+/*========================*/
+	trx_t*			trx,	/*!< in: transaction */
+	struct TABLE*		table,	/*!< in/out: MySQL table, for
+					reporting erroneous key value
+					if applicable */
+	const dict_table_t*	old_table,/*!< in: table where rows are
+					read from */
+	bool			online,	/*!< in: true if creating indexes
+					online */
+	dict_index_t**		indexes,/*!< in: indexes to be created */
+	const ulint*		key_numbers,/*!< in: MySQL key numbers */
+	ulint			n_indexes,/*!< in: size of indexes[] */
+	merge_file_t*		files,	/*!< in/out: temporary files */
+	row_merge_block_t*	block,	/*!< in/out: file buffer */
+	ulint			n_threads)/*!< in: number of threads */
+{
+	row_merge_pll_t		pll;
+	row_merge_pll_thread_t*	thr;
+	dtuple_t**		bounds;
+	mem_heap_t*		heap;
+	ulint			n_ranges;
+	ulint			err_index = 0;
+	dberr_t			err;
+
+	mutex_create("row_merge", &pll.mutex);
+	pll.reported = NULL;
+	pll.n_active = 0;
+	pll.failed = false;
+	pll.trx = trx;
+	pll.table = table;
+	pll.old_table = old_table;
+	pll.online = online;
+	pll.index = indexes;
+	pll.files = files;
+	pll.n_index = n_indexes;
+
+	heap = mem_heap_create(1024);
+
+	bounds = static_cast<dtuple_t**>(
+		mem_heap_alloc(heap, n_threads * sizeof *bounds));
+
+	thr = static_cast<row_merge_pll_thread_t*>(
+		mem_heap_zalloc(heap, n_threads * sizeof *thr));
+
+	trx->op_info = "reading clustered index";
+
+	n_ranges = row_merge_split_clustered_index(
+		dict_table_get_first_index(old_table), n_threads,
+		bounds, heap);
+
+	for (ulint i = 0; i < n_ranges; i++) {
+		thr[i].pll = &pll;
+		thr[i].low = i > 0 ? bounds[i - 1] : NULL;
+		thr[i].high = i + 1 < n_ranges ? bounds[i] : NULL;
+		thr[i].thread_no = i;
+		thr[i].n_threads = 0;
+	}
+
+	err = row_merge_pll_run(&pll, thr, n_ranges, &err_index);
+
+	trx->op_info = "";
+
+	for (ulint i = 0; err == DB_SUCCESS && i < n_indexes; i++) {
+		if (files[i].offset == 0) {
+			/* row_merge_sort() expects at least one block,
+			with the end-of-chunk marker. */
+			row_merge_buf_t*	buf
+				= row_merge_buf_create(indexes[i]);
+
+			row_merge_buf_write(buf, &files[i], block);
+
+			if (!row_merge_write(files[i].fd, files[i].offset++,
+					     block)) {
+				err = DB_OUT_OF_FILE_SPACE;
+				err_index = i;
+			}
+
+			row_merge_buf_free(buf);
+		}
+
+		if (online) {
+			/* Note the newest transaction that modified
+			this index when the scan was completed, see
+			row_merge_read_clustered_index(). */
+			trx_id_t	max_trx_id;
+
+			rw_lock_x_lock(dict_index_get_lock(indexes[i]));
+			ut_a(dict_index_get_online_status(indexes[i])
+			     == ONLINE_INDEX_CREATION);
+
+			max_trx_id = row_log_get_max_trx(indexes[i]);
+
+			if (max_trx_id > indexes[i]->trx_id) {
+				indexes[i]->trx_id = max_trx_id;
+			}
+
+			rw_lock_x_unlock(dict_index_get_lock(indexes[i]));
+		}
+	}
+
+	if (err == DB_SUCCESS) {
+		DEBUG_SYNC_C("row_merge_after_scan");
+
+		n_threads = ut_min(n_threads, n_indexes);
+
+		for (ulint i = 0; i < n_threads; i++) {
+			thr[i].pll = &pll;
+			thr[i].low = NULL;
+			thr[i].high = NULL;
+			thr[i].thread_no = i;
+			thr[i].n_threads = n_threads;
+		}
+
+		err = row_merge_pll_run(&pll, thr, n_threads, &err_index);
+	}
+
+	if (err == DB_SUCCESS && !dict_table_is_temporary(old_table)) {
+		/* Write the bulk loaded pages of all the indexes at
+		once, instead of having each thread wait for the pages
+		that the others are still building. */
+		buf_LRU_flush_or_remove_pages(
+			old_table->space, BUF_REMOVE_FLUSH_WRITE, trx);
+
+		if (trx_is_interrupted(trx)) {
+			err = DB_INTERRUPTED;
+		}
+	}
+
+	if (err != DB_SUCCESS) {
+		trx->error_key_num = key_numbers[err_index];
+	}
+
+	mem_heap_free(heap);
+	mutex_free(&pll.mutex);
+
+	return(err);
+}
+
 /*********************************************************************//**
 Build indexes on a table by reading a clustered index,
 creating a temporary file containing index entries, merge sorting
@@ -3309,6 +4147,7 @@ row_merge_build_indexes(
 	fts_psort_t*		merge_info = NULL;
 	ib_int64_t		sig_count = 0;
 	bool			fts_psort_initiated = false;
+	ulint			n_threads = 1;
 	DBUG_ENTER("row_merge_build_indexes");
 
 	ut_ad(!srv_read_only_mode);
@@ -3361,6 +4200,8 @@ row_merge_build_indexes(
 			dup->table = table;
 			dup->col_map = col_map;
 			dup->n_dup = 0;
+			dup->mutex = NULL;
+			dup->reported = NULL;
 
 			row_fts_psort_info_init(
 				trx, dup, new_table, opt_doc_id_size,
@@ -3383,21 +4224,42 @@ row_merge_build_indexes(
 	duplicate keys. */
 	innobase_rec_reset(table);
 
-	/* Read clustered index of the table and create files for
-	secondary index entries for merge sort */
+	/* Secondary indexes other than FULLTEXT can be built by several
+	threads when the table is not rebuilt. */
+	if (old_table == new_table && fts_sort_idx == NULL) {
+		n_threads = ut_min(ulint(srv_sort_threads),
+				   ulint(ROW_MERGE_MAX_THREADS));
+	}
 
-	error = row_merge_read_clustered_index(
-		trx, table, old_table, new_table, online, indexes,
-		fts_sort_idx, psort_info, merge_files, key_numbers,
-		n_indexes, add_cols, col_map,
-		add_autoinc, sequence, block);
+	if (n_threads > 1) {
+		ut_ad(add_autoinc == ULINT_UNDEFINED);
 
-	if (error != DB_SUCCESS) {
+		error = row_merge_build_indexes_pll(
+			trx, table, old_table, online, indexes,
+			key_numbers, n_indexes, merge_files, block,
+			n_threads);
 
-		goto func_exit;
-	}
+		if (error != DB_SUCCESS) {
+
+			goto func_exit;
+		}
+	} else {
+		/* Read clustered index of the table and create files
+		for secondary index entries for merge sort */
+
+		error = row_merge_read_clustered_index(
+			trx, table, old_table, new_table, online, indexes,
+			fts_sort_idx, psort_info, merge_files, key_numbers,
+			n_indexes, add_cols, col_map,
+			add_autoinc, sequence, block);
 
-	DEBUG_SYNC_C("row_merge_after_scan");
+		if (error != DB_SUCCESS) {
+
+			goto func_exit;
+		}
+
+		DEBUG_SYNC_C("row_merge_after_scan");
+	}
 
 	/* Now we have files containing index entries ready for
 	sorting and inserting. */
@@ -3471,9 +4333,12 @@ wait_again:
 #ifdef FTS_INTERNAL_DIAG_PRINT
 			DEBUG_FTS_SORT_PRINT("FTS_SORT: Complete Insert\n");
 #endif
+		} else if (n_threads > 1) {
+			/* row_merge_build_indexes_pll() already sorted
+			and inserted the entries. */
 		} else {
 			row_merge_dup_t	dup = {
-				sort_idx, table, col_map, 0};
+				sort_idx, table, col_map, 0, NULL, NULL};
 
 			error = row_merge_sort(
 				trx, &dup, &merge_files[i],
@@ -3481,8 +4346,8 @@ wait_again:
 
 			if (error == DB_SUCCESS) {
 				error = row_merge_insert_index_tuples(
-					trx->id, sort_idx, old_table,
-					merge_files[i].fd, block);
+					trx, sort_idx, old_table,
+					merge_files[i].fd, block, true);
 			}
 		}
 
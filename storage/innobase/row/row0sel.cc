@@ -1212,7 +1212,7 @@ row_sel_try_search_shortcut(
 				index */
 	ibool		search_latch_locked,
 				/*!< in: whether the search holds
-				btr_search_latch */
+				btr_get_search_latch(plan->index) */
 	mtr_t*		mtr)	/*!< in: mtr */
 {
 	dict_index_t*	index;
@@ -1230,7 +1230,7 @@ row_sel_try_search_shortcut(
 	ut_ad(!plan->must_get_clust);
 #ifdef UNIV_SYNC_DEBUG
 	if (search_latch_locked) {
-		ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_S));
+		ut_ad(rw_lock_own(btr_get_search_latch(index), RW_LOCK_S));
 	}
 #endif /* UNIV_SYNC_DEBUG */
 
@@ -1325,7 +1325,9 @@ row_sel(
 	rec_t*		rec;
 	rec_t*		old_vers;
 	rec_t*		clust_rec;
-	ibool		search_latch_locked;
+	rw_lock_t*	search_latch;	/* the adaptive hash index
+					partition latch we hold in s-mode,
+					or NULL */
 	ibool		consistent_read;
 
 	/* The following flag becomes TRUE when we are doing a
@@ -1353,7 +1355,7 @@ row_sel(
 
 	ut_ad(thr->run_node == node);
 
-	search_latch_locked = FALSE;
+	search_latch = NULL;
 
 	if (node->read_view) {
 		/* In consistent reads, we try to do with the hash index and
@@ -1403,11 +1405,21 @@ table_loop:
 	if (consistent_read && plan->unique_search && !plan->pcur_is_open
 	    && !plan->must_get_clust
 	    && !plan->table->big_rows) {
-		if (!search_latch_locked) {
-			rw_lock_s_lock(&btr_search_latch);
+		rw_lock_t*	latch = btr_get_search_latch(plan->index);
 
-			search_latch_locked = TRUE;
-		} else if (rw_lock_get_writer(&btr_search_latch) == RW_LOCK_X_WAIT) {
+		if (search_latch != NULL && search_latch != latch) {
+			/* We hold the latch of the partition of the
+			index of another table */
+			rw_lock_s_unlock(search_latch);
+
+			search_latch = NULL;
+		}
+
+		if (search_latch == NULL) {
+			rw_lock_s_lock(latch);
+
+			search_latch = latch;
+		} else if (rw_lock_get_writer(latch) == RW_LOCK_X_WAIT) {
 
 			/* There is an x-latch request waiting: release the
 			s-latch for a moment; as an s-latch here is often
@@ -1416,12 +1428,11 @@ table_loop:
 			from acquiring an s-latch for a long time, lowering
 			performance significantly in multiprocessors. */
 
-			rw_lock_s_unlock(&btr_search_latch);
-			rw_lock_s_lock(&btr_search_latch);
+			rw_lock_s_unlock(latch);
+			rw_lock_s_lock(latch);
 		}
 
-		found_flag = row_sel_try_search_shortcut(node, plan,
-							 search_latch_locked,
+		found_flag = row_sel_try_search_shortcut(node, plan, TRUE,
 							 &mtr);
 
 		if (found_flag == SEL_FOUND) {
@@ -1441,17 +1452,17 @@ table_loop:
 		mtr_start(&mtr);
 	}
 
-	if (search_latch_locked) {
-		rw_lock_s_unlock(&btr_search_latch);
+	if (search_latch != NULL) {
+		rw_lock_s_unlock(search_latch);
 
-		search_latch_locked = FALSE;
+		search_latch = NULL;
 	}
 
 	if (!plan->pcur_is_open) {
 		/* Evaluate the expressions to build the search tuple and
 		open the cursor */
 
-		row_sel_open_pcur(plan, search_latch_locked, &mtr);
+		row_sel_open_pcur(plan, FALSE, &mtr);
 
 		cursor_just_opened = TRUE;
 
@@ -1839,7 +1850,7 @@ skip_lock:
 	}
 
 next_rec:
-	ut_ad(!search_latch_locked);
+	ut_ad(search_latch == NULL);
 
 	if (mtr_has_extra_clust_latch) {
 
@@ -1878,7 +1889,7 @@ next_table:
 
 		plan->cursor_at_end = TRUE;
 	} else {
-		ut_ad(!search_latch_locked);
+		ut_ad(search_latch == NULL);
 
 		plan->stored_cursor_rec_processed = TRUE;
 
@@ -1970,7 +1981,7 @@ stop_for_a_while:
 	inserted new records which should have appeared in the result set,
 	which would result in the phantom problem. */
 
-	ut_ad(!search_latch_locked);
+	ut_ad(search_latch == NULL);
 
 	plan->stored_cursor_rec_processed = FALSE;
 	btr_pcur_store_position(&(plan->pcur), &mtr);
@@ -1993,7 +2004,7 @@ commit_mtr_for_a_while:
 
 	plan->stored_cursor_rec_processed = TRUE;
 
-	ut_ad(!search_latch_locked);
+	ut_ad(search_latch == NULL);
 	btr_pcur_store_position(&(plan->pcur), &mtr);
 
 	mtr_commit(&mtr);
@@ -2014,7 +2025,7 @@ lock_wait_or_error:
 	/* See the note at stop_for_a_while: the same holds for this case */
 
 	ut_ad(!btr_pcur_is_before_first_on_page(&plan->pcur) || !node->asc);
-	ut_ad(!search_latch_locked);
+	ut_ad(search_latch == NULL);
 
 	plan->stored_cursor_rec_processed = FALSE;
 	btr_pcur_store_position(&(plan->pcur), &mtr);
@@ -2030,8 +2041,8 @@ lock_wait_or_error:
 #endif /* UNIV_SYNC_DEBUG */
 
 func_exit:
-	if (search_latch_locked) {
-		rw_lock_s_unlock(&btr_search_latch);
+	if (search_latch != NULL) {
+		rw_lock_s_unlock(search_latch);
 	}
 
 	if (heap != NULL) {
@@ -3764,15 +3775,14 @@ row_search_for_mysql(
 	adaptive hash index latch if there is someone waiting behind */
 
 	if (trx->has_search_latch
-	    && rw_lock_get_writer(&btr_search_latch) != RW_LOCK_NOT_LOCKED) {
+	    && rw_lock_get_writer(trx->search_latch) != RW_LOCK_NOT_LOCKED) {
 
 		/* There is an x-latch request on the adaptive hash index:
 		release the s-latch to reduce starvation and wait for
 		BTR_SEA_TIMEOUT rounds before trying to keep it again over
 		calls from MySQL */
 
-		rw_lock_s_unlock(&btr_search_latch);
-		trx->has_search_latch = false;
+		trx_search_latch_release_if_reserved(trx);
 
 		trx->search_latch_timeout = BTR_SEA_TIMEOUT;
 	}
@@ -3923,9 +3933,20 @@ row_search_for_mysql(
 			hash index semaphore! */
 
 #ifndef UNIV_SEARCH_DEBUG
+			rw_lock_t*	latch = btr_get_search_latch(index);
+
+			if (trx->has_search_latch
+			    && trx->search_latch != latch) {
+				/* The latch that was kept over calls
+				from MySQL belongs to the adaptive hash
+				index partition of another index */
+				trx_search_latch_release_if_reserved(trx);
+			}
+
 			if (!trx->has_search_latch) {
-				rw_lock_s_lock(&btr_search_latch);
+				rw_lock_s_lock(latch);
 				trx->has_search_latch = true;
+				trx->search_latch = latch;
 			}
 #endif
 			switch (row_sel_try_search_shortcut_for_mysql(
@@ -3996,8 +4017,8 @@ release_search_latch_if_needed:
 
 					trx->search_latch_timeout--;
 
-					rw_lock_s_unlock(&btr_search_latch);
-					trx->has_search_latch = false;
+					trx_search_latch_release_if_reserved(
+						trx);
 				}
 
 				/* NOTE that we do NOT store the cursor
@@ -4019,10 +4040,7 @@ release_search_latch_if_needed:
 	/*-------------------------------------------------------------*/
 	/* PHASE 3: Open or restore index cursor position */
 
-	if (trx->has_search_latch) {
-		rw_lock_s_unlock(&btr_search_latch);
-		trx->has_search_latch = false;
-	}
+	trx_search_latch_release_if_reserved(trx);
 
 	/* The state of a running trx can only be changed by the
 	thread that is currently serving the transaction. Because we
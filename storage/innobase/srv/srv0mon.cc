@@ -436,6 +436,182 @@ static monitor_info_t	innodb_counter_info[] =
 	 MONITOR_SET_MEMBER, MONITOR_FLUSH_BACKGROUND_TOTAL_PAGE,
 	 MONITOR_FLUSH_BACKGROUND_PAGES},
 
+	{"buffer_flush_cleaner_0_time", "buffer",
+	 "Time (in milliseconds) page cleaner 0 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_0_TIME},
+
+	{"buffer_flush_cleaner_0_pages", "buffer",
+	 "Pages flushed by page cleaner 0",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_0_PAGES},
+
+	{"buffer_flush_cleaner_1_time", "buffer",
+	 "Time (in milliseconds) page cleaner 1 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_1_TIME},
+
+	{"buffer_flush_cleaner_1_pages", "buffer",
+	 "Pages flushed by page cleaner 1",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_1_PAGES},
+
+	{"buffer_flush_cleaner_2_time", "buffer",
+	 "Time (in milliseconds) page cleaner 2 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_2_TIME},
+
+	{"buffer_flush_cleaner_2_pages", "buffer",
+	 "Pages flushed by page cleaner 2",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_2_PAGES},
+
+	{"buffer_flush_cleaner_3_time", "buffer",
+	 "Time (in milliseconds) page cleaner 3 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_3_TIME},
+
+	{"buffer_flush_cleaner_3_pages", "buffer",
+	 "Pages flushed by page cleaner 3",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_3_PAGES},
+
+	{"buffer_flush_cleaner_4_time", "buffer",
+	 "Time (in milliseconds) page cleaner 4 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_4_TIME},
+
+	{"buffer_flush_cleaner_4_pages", "buffer",
+	 "Pages flushed by page cleaner 4",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_4_PAGES},
+
+	{"buffer_flush_cleaner_5_time", "buffer",
+	 "Time (in milliseconds) page cleaner 5 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_5_TIME},
+
+	{"buffer_flush_cleaner_5_pages", "buffer",
+	 "Pages flushed by page cleaner 5",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_5_PAGES},
+
+	{"buffer_flush_cleaner_6_time", "buffer",
+	 "Time (in milliseconds) page cleaner 6 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_6_TIME},
+
+	{"buffer_flush_cleaner_6_pages", "buffer",
+	 "Pages flushed by page cleaner 6",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_6_PAGES},
+
+	{"buffer_flush_cleaner_7_time", "buffer",
+	 "Time (in milliseconds) page cleaner 7 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_7_TIME},
+
+	{"buffer_flush_cleaner_7_pages", "buffer",
+	 "Pages flushed by page cleaner 7",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_7_PAGES},
+
+	{"buffer_flush_cleaner_8_time", "buffer",
+	 "Time (in milliseconds) page cleaner 8 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_8_TIME},
+
+	{"buffer_flush_cleaner_8_pages", "buffer",
+	 "Pages flushed by page cleaner 8",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_8_PAGES},
+
+	{"buffer_flush_cleaner_9_time", "buffer",
+	 "Time (in milliseconds) page cleaner 9 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_9_TIME},
+
+	{"buffer_flush_cleaner_9_pages", "buffer",
+	 "Pages flushed by page cleaner 9",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_9_PAGES},
+
+	{"buffer_flush_cleaner_10_time", "buffer",
+	 "Time (in milliseconds) page cleaner 10 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_10_TIME},
+
+	{"buffer_flush_cleaner_10_pages", "buffer",
+	 "Pages flushed by page cleaner 10",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_10_PAGES},
+
+	{"buffer_flush_cleaner_11_time", "buffer",
+	 "Time (in milliseconds) page cleaner 11 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_11_TIME},
+
+	{"buffer_flush_cleaner_11_pages", "buffer",
+	 "Pages flushed by page cleaner 11",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_11_PAGES},
+
+	{"buffer_flush_cleaner_12_time", "buffer",
+	 "Time (in milliseconds) page cleaner 12 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_12_TIME},
+
+	{"buffer_flush_cleaner_12_pages", "buffer",
+	 "Pages flushed by page cleaner 12",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_12_PAGES},
+
+	{"buffer_flush_cleaner_13_time", "buffer",
+	 "Time (in milliseconds) page cleaner 13 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_13_TIME},
+
+	{"buffer_flush_cleaner_13_pages", "buffer",
+	 "Pages flushed by page cleaner 13",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_13_PAGES},
+
+	{"buffer_flush_cleaner_14_time", "buffer",
+	 "Time (in milliseconds) page cleaner 14 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_14_TIME},
+
+	{"buffer_flush_cleaner_14_pages", "buffer",
+	 "Pages flushed by page cleaner 14",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_14_PAGES},
+
+	{"buffer_flush_cleaner_15_time", "buffer",
+	 "Time (in milliseconds) page cleaner 15 spent flushing its"
+	 " buffer pool instances",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_15_TIME},
+
+	{"buffer_flush_cleaner_15_pages", "buffer",
+	 "Pages flushed by page cleaner 15",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_FLUSH_CLEANER_15_PAGES},
+
 	/* Cumulative counter for LRU batch scan */
 	{"buffer_LRU_batch_scanned", "buffer",
 	 "Total pages scanned as part of LRU batch",
@@ -790,6 +966,45 @@ static monitor_info_t	innodb_counter_info[] =
 	 MONITOR_DISPLAY_CURRENT,
 	 MONITOR_DEFAULT_START, MONITOR_PURGE_RESUME_COUNT},
 
+	{"purge_batch_size", "purge",
+	 "Number of undo log pages in the current purge batch, adapted to"
+	 " the history list length",
+	 MONITOR_DISPLAY_CURRENT,
+	 MONITOR_DEFAULT_START, MONITOR_PURGE_BATCH_SIZE},
+
+	{"purge_batch_tables", "purge",
+	 "Number of tables whose undo records are in the last purge batch",
+	 MONITOR_DISPLAY_CURRENT,
+	 MONITOR_DEFAULT_START, MONITOR_PURGE_BATCH_TABLES},
+
+	{"purge_table_max_records", "purge",
+	 "Number of undo records of the table with the most undo records"
+	 " in the last purge batch",
+	 MONITOR_DISPLAY_CURRENT,
+	 MONITOR_DEFAULT_START, MONITOR_PURGE_TABLE_MAX_RECORDS},
+
+	{"purge_table_max_id", "purge",
+	 "Table id of the table with the most undo records in the last"
+	 " purge batch",
+	 MONITOR_DISPLAY_CURRENT,
+	 MONITOR_DEFAULT_START, MONITOR_PURGE_TABLE_MAX_ID},
+
+	{"undo_truncate_count", "purge",
+	 "Number of times an undo tablespace was truncated",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_UNDO_TRUNCATE_COUNT},
+
+	{"undo_truncate_drain_usec", "purge",
+	 "Time (in microseconds) it took to drain the last truncated undo"
+	 " tablespace after it was marked for truncation",
+	 MONITOR_DISPLAY_CURRENT,
+	 MONITOR_DEFAULT_START, MONITOR_UNDO_TRUNCATE_DRAIN_MICROSECOND},
+
+	{"undo_truncate_usec", "purge",
+	 "Time (in microseconds) spent to truncate undo tablespaces",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_UNDO_TRUNCATE_MICROSECOND},
+
 	/* ========== Counters for Recovery Module ========== */
 	{"module_log", "recovery", "Recovery Module",
 	 MONITOR_MODULE,
@@ -952,6 +1167,166 @@ static monitor_info_t	innodb_counter_info[] =
 	 MONITOR_NONE,
 	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_ROW_UPDATED},
 
+	{"adaptive_hash_part_0_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 0",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_0_HITS},
+
+	{"adaptive_hash_part_0_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 0",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_0_MISSES},
+
+	{"adaptive_hash_part_1_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 1",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_1_HITS},
+
+	{"adaptive_hash_part_1_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 1",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_1_MISSES},
+
+	{"adaptive_hash_part_2_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 2",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_2_HITS},
+
+	{"adaptive_hash_part_2_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 2",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_2_MISSES},
+
+	{"adaptive_hash_part_3_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 3",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_3_HITS},
+
+	{"adaptive_hash_part_3_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 3",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_3_MISSES},
+
+	{"adaptive_hash_part_4_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 4",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_4_HITS},
+
+	{"adaptive_hash_part_4_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 4",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_4_MISSES},
+
+	{"adaptive_hash_part_5_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 5",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_5_HITS},
+
+	{"adaptive_hash_part_5_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 5",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_5_MISSES},
+
+	{"adaptive_hash_part_6_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 6",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_6_HITS},
+
+	{"adaptive_hash_part_6_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 6",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_6_MISSES},
+
+	{"adaptive_hash_part_7_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 7",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_7_HITS},
+
+	{"adaptive_hash_part_7_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 7",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_7_MISSES},
+
+	{"adaptive_hash_part_8_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 8",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_8_HITS},
+
+	{"adaptive_hash_part_8_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 8",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_8_MISSES},
+
+	{"adaptive_hash_part_9_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 9",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_9_HITS},
+
+	{"adaptive_hash_part_9_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 9",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_9_MISSES},
+
+	{"adaptive_hash_part_10_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 10",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_10_HITS},
+
+	{"adaptive_hash_part_10_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 10",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_10_MISSES},
+
+	{"adaptive_hash_part_11_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 11",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_11_HITS},
+
+	{"adaptive_hash_part_11_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 11",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_11_MISSES},
+
+	{"adaptive_hash_part_12_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 12",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_12_HITS},
+
+	{"adaptive_hash_part_12_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 12",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_12_MISSES},
+
+	{"adaptive_hash_part_13_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 13",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_13_HITS},
+
+	{"adaptive_hash_part_13_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 13",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_13_MISSES},
+
+	{"adaptive_hash_part_14_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 14",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_14_HITS},
+
+	{"adaptive_hash_part_14_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 14",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_14_MISSES},
+
+	{"adaptive_hash_part_15_hits", "adaptive_hash_index",
+	 "Number of successful searches in Adaptive Hash Index partition 15",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_15_HITS},
+
+	{"adaptive_hash_part_15_misses", "adaptive_hash_index",
+	 "Number of failed searches in Adaptive Hash Index partition 15",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_ADAPTIVE_HASH_PART_15_MISSES},
+
 	/* ========== Counters for tablespace ========== */
 	{"module_file", "file_system", "Tablespace and File System Manager",
 	 MONITOR_MODULE,
@@ -106,6 +106,13 @@ ulint	srv_undo_tablespaces_open = 8;
 /* The number of rollback segments to use */
 ulong	srv_undo_logs = 1;
 
+/** Whether purge truncates undo tablespaces that grew too big. */
+my_bool	srv_undo_log_truncate = FALSE;
+
+/** Size in bytes beyond which an undo tablespace is marked for truncation
+by purge, when srv_undo_log_truncate is set. */
+unsigned long long	srv_max_undo_log_size;
+
 /** UNDO logs that are not redo logged.
 These logs reside in the temp tablespace.*/
 const ulong		srv_tmp_undo_logs = 32;
@@ -133,6 +140,11 @@ on duplicate key checking and foreign key checking */
 ibool	srv_locks_unsafe_for_binlog = FALSE;
 /** Sort buffer size in index creation */
 ulong	srv_sort_buf_size = 1048576;
+/** Number of threads that build secondary indexes in index creation */
+ulong	srv_sort_threads = 1;
+/** Percentage of each B-tree page that is filled when sorted index
+entries are loaded in index creation */
+ulong	srv_fill_factor = 100;
 /** Maximum modification log file size for online index creation */
 unsigned long long	srv_online_max_size;
 
@@ -141,6 +153,9 @@ OS (provided we compiled Innobase with it in), otherwise we will
 use simulated aio we build below with threads.
 Currently we support native aio on windows and linux */
 my_bool	srv_use_native_aio = TRUE;
+/* If this flag is TRUE, Linux native aio requests are submitted through
+io_uring rather than libaio, provided io_uring support is compiled in */
+my_bool	srv_use_io_uring = FALSE;
 
 /*------------------------- LOG FILES ------------------------ */
 char*	srv_log_group_home_dir	= NULL;
@@ -153,6 +168,8 @@ ib_uint64_t	srv_log_file_size_requested;
 ulint	srv_log_buffer_size	= ULINT_MAX;
 ulong	srv_flush_log_at_trx_commit = 1;
 uint	srv_flush_log_at_timeout = 1;
+my_bool	srv_log_writer_threads	= TRUE;
+ulong	srv_log_wait_spin_rounds = 30;
 ulong	srv_page_size		= UNIV_PAGE_SIZE_DEF;
 ulong	srv_page_size_shift	= UNIV_PAGE_SIZE_SHIFT_DEF;
 
@@ -188,6 +205,10 @@ ulint	srv_buf_pool_old_size;
 ulint	srv_buf_pool_curr_size	= 0;
 /* dump that may % of each buffer pool during BP dump */
 ulong	srv_buf_pool_dump_pct;
+/* number of threads loading each buffer pool during BP load */
+ulong	srv_buf_pool_load_threads = 1;
+/* load the hottest % of the dumped pages first during BP load */
+ulong	srv_buf_pool_load_hot_pct;
 /* size in bytes */
 ulint	srv_mem_pool_size	= ULINT_MAX;
 ulint	srv_lock_table_size	= ULINT_MAX;
@@ -225,6 +246,14 @@ ulint	srv_max_n_open_files	  = 300;
 ulong	srv_io_capacity         = 200;
 ulong	srv_max_io_capacity     = 400;
 
+/* Number of threads that merge the change buffer, 0 if the master
+thread does it */
+ulong	srv_ibuf_merge_threads	= 0;
+
+/* Pages per second that the change buffer merge threads read; 0 means
+innodb_io_capacity */
+ulong	srv_ibuf_merge_rate	= 0;
+
 /* The InnoDB main thread tries to keep the ratio of modified pages
 in the buffer pool to all database pages in the buffer pool smaller than
 the following number. But it is not guaranteed that the value stays below
@@ -243,6 +272,12 @@ ulong	srv_flushing_avg_loops		= 30;
 /* The number of purge threads to use.*/
 ulong	srv_n_purge_threads = 1;
 
+/* The number of page cleaner threads to use.*/
+ulong	srv_n_page_cleaners = 1;
+
+/* The number of threads applying redo log records in crash recovery.*/
+ulong	srv_n_recovery_threads = 4;
+
 /* the number of pages to purge in one batch */
 ulong	srv_purge_batch_size = 20;
 
@@ -271,6 +306,11 @@ ulong	srv_force_recovery_crash;
 
 my_bool	srv_print_all_deadlocks = FALSE;
 
+/** Search for deadlocks in a background thread, instead of in the thread
+that enqueues a lock wait */
+
+my_bool	srv_deadlock_detect_background = FALSE;
+
 /** Enable INFORMATION_SCHEMA.innodb_cmp_per_index */
 my_bool	srv_cmp_per_index_enabled = FALSE;
 
@@ -1146,7 +1186,11 @@ srv_printf_innodb_monitor(
 	      "-------------------------------------\n", file);
 	ibuf_print(file);
 
-	ha_print_info(file, btr_search_sys->hash_index);
+	for (ulint i = 0; i < btr_ahi_parts; ++i) {
+		fprintf(file, "AHI PARTITION %lu: ", (ulong) i + 1);
+
+		ha_print_info(file, btr_search_sys->hash_tables[i]);
+	}
 
 	fprintf(file,
 		"%.2f hash searches/s, %.2f non-hash searches/s\n",
@@ -1354,6 +1398,12 @@ srv_export_innodb_status(void)
 
 	export_vars.innodb_pages_written = stat.n_pages_written;
 
+	export_vars.innodb_pages_page_compressed =
+		srv_stats.pages_page_compressed;
+
+	export_vars.innodb_page_compression_saved =
+		srv_stats.page_compression_saved;
+
 	export_vars.innodb_row_lock_waits = srv_stats.n_lock_wait_count;
 
 	export_vars.innodb_row_lock_current_waits =
@@ -1777,19 +1827,25 @@ srv_any_background_threads_are_active(void)
 		thread_active = "srv_error_monitor_thread";
 	} else if (lock_sys->timeout_thread_active) {
 		thread_active = "srv_lock_timeout thread";
+	} else if (lock_sys->deadlock_thread_active) {
+		thread_active = "lock_deadlock_thread";
 	} else if (srv_monitor_active) {
 		thread_active = "srv_monitor_thread";
 	} else if (srv_buf_dump_thread_active) {
 		thread_active = "buf_dump_thread";
 	} else if (srv_dict_stats_thread_active) {
 		thread_active = "dict_stats_thread";
+	} else if (ibuf->n_merge_threads_active > 0) {
+		thread_active = "ibuf_merge_thread";
 	}
 
 	os_event_set(srv_error_event);
 	os_event_set(srv_monitor_event);
 	os_event_set(srv_buf_dump_event);
 	os_event_set(lock_sys->timeout_event);
+	os_event_set(lock_sys->deadlock_event);
 	os_event_set(dict_stats_event);
+	os_event_set(ibuf->merge_event);
 
 	return(thread_active);
 }
@@ -2022,12 +2078,14 @@ srv_master_do_active_tasks(void)
 	srv_main_thread_op_info = "checking free log space";
 	log_free_check();
 
-	/* Do an ibuf merge */
-	srv_main_thread_op_info = "doing insert buffer merge";
-	counter_time = ut_time_us(NULL);
-	ibuf_contract_in_background(0, FALSE);
-	MONITOR_INC_TIME_IN_MICRO_SECS(
-		MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	/* Do an ibuf merge, unless the merge threads do it */
+	if (srv_ibuf_merge_threads == 0) {
+		srv_main_thread_op_info = "doing insert buffer merge";
+		counter_time = ut_time_us(NULL);
+		ibuf_contract_in_background(0, FALSE);
+		MONITOR_INC_TIME_IN_MICRO_SECS(
+			MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	}
 
 	/* Flush logs if needed */
 	srv_main_thread_op_info = "flushing log";
@@ -2114,12 +2172,14 @@ srv_master_do_idle_tasks(void)
 	srv_main_thread_op_info = "checking free log space";
 	log_free_check();
 
-	/* Do an ibuf merge */
-	counter_time = ut_time_us(NULL);
-	srv_main_thread_op_info = "doing insert buffer merge";
-	ibuf_contract_in_background(0, TRUE);
-	MONITOR_INC_TIME_IN_MICRO_SECS(
-		MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	/* Do an ibuf merge, unless the merge threads do it */
+	if (srv_ibuf_merge_threads == 0) {
+		counter_time = ut_time_us(NULL);
+		srv_main_thread_op_info = "doing insert buffer merge";
+		ibuf_contract_in_background(0, TRUE);
+		MONITOR_INC_TIME_IN_MICRO_SECS(
+			MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	}
 
 	if (srv_shutdown_state > 0) {
 		return;
@@ -2445,6 +2505,10 @@ DECLARE_THREAD(srv_worker_thread)(
 	OS_THREAD_DUMMY_RETURN;	/* Not reached, avoid compiler warning */
 }
 
+/** The purge batch size grows up to this many times innodb_purge_batch_size
+while the history list keeps growing with all the purge threads in use */
+static const ulint	SRV_PURGE_BATCH_SIZE_MAX_FACTOR = 8;
+
 /*********************************************************************//**
 Do the actual purge operation.
 @return length of history list before the last purge batch. */
@@ -2459,6 +2523,7 @@ srv_do_purge(
 
 	static ulint	count = 0;
 	static ulint	n_use_threads = 0;
+	static ulint	batch_size = 0;
 	static ulint	rseg_history_len = 0;
 	ulint		old_activity_count = srv_get_activity_count();
 
@@ -2481,23 +2546,39 @@ srv_do_purge(
 			&& rseg_history_len > srv_max_purge_lag)) {
 
 			/* History length is now longer than what it was
-			when we took the last snapshot. Use more threads. */
+			when we took the last snapshot. Use more threads,
+			and bigger batches once all threads are in use. */
 
 			if (n_use_threads < n_threads) {
 				++n_use_threads;
+			} else {
+				batch_size *= 2;
 			}
 
 		} else if (srv_check_activity(old_activity_count)
-			   && n_use_threads > 1) {
+			   && (n_use_threads > 1
+			       || batch_size > srv_purge_batch_size)) {
 
 			/* History length same or smaller since last snapshot,
-			use fewer threads. */
+			use smaller batches first, then fewer threads. */
 
-			--n_use_threads;
+			if (batch_size > srv_purge_batch_size) {
+				batch_size /= 2;
+			} else {
+				--n_use_threads;
+			}
 
 			old_activity_count = srv_get_activity_count();
 		}
 
+		/* innodb_purge_batch_size can be changed at any time. */
+
+		batch_size = ut_max(batch_size, srv_purge_batch_size);
+		batch_size = ut_min(batch_size, srv_purge_batch_size
+				    * SRV_PURGE_BATCH_SIZE_MAX_FACTOR);
+
+		MONITOR_SET(MONITOR_PURGE_BATCH_SIZE, batch_size);
+
 		/* Ensure that the purge threads are less than what
 		was configured. */
 
@@ -2509,8 +2590,7 @@ srv_do_purge(
 			break;
 		}
 
-		n_pages_purged = trx_purge(
-			n_use_threads, srv_purge_batch_size, false);
+		n_pages_purged = trx_purge(n_use_threads, batch_size, false);
 
 		if (!(count++ % TRX_SYS_N_RSEGS)) {
 			/* Force a truncate of the history list. */
@@ -2818,7 +2898,8 @@ srv_is_tablespace_truncated(ulint space_id)
 		return(false);
 	}
 
-	return(truncate_t::is_tablespace_truncated(space_id));
+	return(truncate_t::is_tablespace_truncated(space_id)
+	       || trx_purge_is_undo_space_truncated(space_id));
 
 }
 
@@ -126,8 +126,10 @@ enum srv_start_state_t {
 	SRV_START_STATE_MONITOR = 4,		/*!< Started montior thread */
 	SRV_START_STATE_MASTER = 8,		/*!< Started master threadd. */
 	SRV_START_STATE_PURGE = 16,		/*!< Started purge thread(s) */
-	SRV_START_STATE_STAT = 32		/*!< Started bufdump + dict stat
+	SRV_START_STATE_STAT = 32,		/*!< Started bufdump + dict stat
 						and FTS optimize thread. */
+	SRV_START_STATE_LOG = 64		/*!< Started log writer and log
+						flusher threads. */
 };
 
 /** Track server thrd starting phases */
@@ -152,10 +154,6 @@ static char*	srv_monitor_file_name;
 /** Minimum expected tablespace size. (10M) */
 static const ulint MIN_EXPECTED_TABLESPACE_SIZE = 5 * 1024 * 1024;
 
-/** Default undo tablespace size in UNIV_PAGEs count (10MB). */
-static const ulint SRV_UNDO_TABLESPACE_SIZE_IN_PAGES =
-	((1024 * 1024) * 10) / UNIV_PAGE_SIZE_DEF;
-
 /** */
 #define SRV_N_PENDING_IOS_PER_THREAD	OS_AIO_N_PENDING_IOS_PER_THREAD
 #define SRV_MAX_N_PENDING_SYNC_IOS	100
@@ -168,6 +166,7 @@ mysql_pfs_key_t	io_read_thread_key;
 mysql_pfs_key_t	io_write_thread_key;
 mysql_pfs_key_t	io_handler_thread_key;
 mysql_pfs_key_t	srv_lock_timeout_thread_key;
+mysql_pfs_key_t	srv_lock_deadlock_thread_key;
 mysql_pfs_key_t	srv_error_monitor_thread_key;
 mysql_pfs_key_t	srv_monitor_thread_key;
 mysql_pfs_key_t	srv_master_thread_key;
@@ -646,6 +645,32 @@ srv_undo_tablespace_open(
 	if (ret) {
 		os_offset_t	size;
 
+		if (trx_purge_check_undo_space_truncated(space)) {
+
+			/* The server crashed while purge was truncating
+			this undo tablespace. It was drained before the
+			truncation started, so shrink the file now and
+			ignore its redo log: its pages are initialized
+			again by trx_purge_fix_up_undo_spaces(). */
+
+			if (srv_read_only_mode) {
+				ib_logf(IB_LOG_LEVEL_ERROR,
+					"Cannot finish the truncation of"
+					" undo tablespace '%s' in read-only"
+					" mode.", name);
+
+				os_file_close(fh);
+
+				return(DB_READ_ONLY);
+			}
+
+			ret = os_file_truncate(
+				name, fh,
+				(os_offset_t) SRV_UNDO_TABLESPACE_SIZE_IN_PAGES
+				* UNIV_PAGE_SIZE);
+			ut_a(ret);
+		}
+
 		size = os_file_get_size(fh);
 		ut_a(size != (os_offset_t) -1);
 
@@ -1092,6 +1117,12 @@ srv_shutdown_all_bg_threads()
 		return;
 	}
 
+	if (srv_start_state_is_set(SRV_START_STATE_LOG)) {
+		/* The log writer and log flusher threads exit once they
+		have served the pending requests */
+		log_stop_writer_threads();
+	}
+
 	/* All threads end up waiting for certain events. Put those events
 	to the signaled state. Then the threads will exit themselves after
 	os_event_wait(). */
@@ -1102,8 +1133,10 @@ srv_shutdown_all_bg_threads()
 		if (!srv_read_only_mode) {
 
 			if (srv_start_state_is_set(SRV_START_STATE_LOCK_SYS)) {
-				/* a. Let the lock timeout thread exit */
+				/* a. Let the lock timeout thread and the
+				deadlock detector thread exit */
 				os_event_set(lock_sys->timeout_event);
+				os_event_set(lock_sys->deadlock_event);
 			}
 
 			/* b. srv error monitor thread exits automatically,
@@ -1113,6 +1146,10 @@ srv_shutdown_all_bg_threads()
 				/* c. We wake the master thread so that
 				it exits */
 				srv_wake_master_thread();
+
+				/* Let the change buffer merge threads
+				exit */
+				os_event_set(ibuf->merge_event);
 			}
 
 			if (srv_start_state_is_set(SRV_START_STATE_PURGE)) {
@@ -1358,6 +1395,16 @@ innobase_start_or_create_for_mysql(void)
 	srv_use_native_aio = FALSE;
 #endif /* _WIN32 */
 
+#ifndef LINUX_IO_URING
+	if (srv_use_io_uring) {
+		ib_logf(IB_LOG_LEVEL_WARN,
+			"io_uring support is not compiled in."
+			" Ignoring innodb_use_io_uring.");
+
+		srv_use_io_uring = FALSE;
+	}
+#endif /* !LINUX_IO_URING */
+
 	if (srv_file_flush_method_str == NULL) {
 		/* These are the default options */
 
@@ -1460,6 +1507,12 @@ innobase_start_or_create_for_mysql(void)
 		}
 	}
 
+	/* Each page cleaner thread flushes at least one buffer pool
+	instance. */
+	if (srv_n_page_cleaners > srv_buf_pool_instances) {
+		srv_n_page_cleaners = srv_buf_pool_instances;
+	}
+
 	srv_boot();
 
 	ib_logf(IB_LOG_LEVEL_INFO,
@@ -2058,6 +2111,9 @@ files_checked:
 			return(srv_init_abort(err));
 		}
 
+		/* Likewise, finish the truncation of undo tablespaces. */
+		trx_purge_fix_up_undo_spaces();
+
 		if (!srv_force_recovery
 		    && !recv_sys->found_corrupt_log
 		    && (srv_log_file_size_requested != srv_log_file_size
@@ -2230,6 +2286,10 @@ files_checked:
 			lock_wait_timeout_thread,
 			NULL, thread_ids + 2 + SRV_MAX_N_IO_THREADS);
 
+		/* Create the thread which searches for deadlocks when
+		innodb_deadlock_detect_background is set */
+		os_thread_create(lock_deadlock_thread, NULL, NULL);
+
 		/* Create the thread which warns of long semaphore waits */
 		os_thread_create(
 			srv_error_monitor_thread,
@@ -2262,6 +2322,13 @@ files_checked:
 	/* Create the master thread which does purge and other utility
 	operations */
 
+	if (!srv_read_only_mode && srv_log_writer_threads) {
+
+		log_start_writer_threads();
+
+		srv_start_state_set(SRV_START_STATE_LOG);
+	}
+
 	if (!srv_read_only_mode) {
 
 		os_thread_create(
@@ -2269,6 +2336,10 @@ files_checked:
 			NULL, thread_ids + (1 + SRV_MAX_N_IO_THREADS));
 
 		srv_start_state_set(SRV_START_STATE_MASTER);
+
+		/* Create the threads which merge the change buffer
+		instead of the master thread */
+		ibuf_merge_threads_create();
 	}
 
 	if (!srv_read_only_mode
@@ -2296,7 +2367,15 @@ files_checked:
 	}
 
 	if (!srv_read_only_mode) {
-		os_thread_create(buf_flush_page_cleaner_thread, NULL, NULL);
+		buf_flush_page_cleaner_init();
+
+		os_thread_create(buf_flush_page_cleaner_coordinator,
+				 NULL, NULL);
+
+		for (i = 1; i < srv_n_page_cleaners; ++i) {
+			os_thread_create(buf_flush_page_cleaner_worker,
+					 NULL, NULL);
+		}
 	}
 
 	sum_of_data_file_sizes = srv_sys_space.get_sum_of_sizes();
@@ -2551,6 +2630,7 @@ innobase_shutdown_for_mysql(void)
 
 	if (!srv_read_only_mode) {
 		dict_stats_thread_deinit();
+		buf_flush_page_cleaner_free();
 	}
 
 	/* This must be disabled before closing the buffer pool
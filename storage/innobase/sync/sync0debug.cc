@@ -568,6 +568,7 @@ SyncDebug::check_order(const latch_t* latch)
 	case SYNC_MEM_POOL:
 	case SYNC_MEM_HASH:
 	case SYNC_RECV:
+	case SYNC_PAGE_CLEANER:
 	case SYNC_FTS_BG_THREADS:
 	case SYNC_WORK_QUEUE:
 	case SYNC_FTS_OPTIMIZE:
@@ -578,9 +579,9 @@ SyncDebug::check_order(const latch_t* latch)
 	case SYNC_ANY_LATCH:
 	case SYNC_FILE_FORMAT_TAG:
 	case SYNC_DOUBLEWRITE:
-	case SYNC_SEARCH_SYS:
 	case SYNC_THREADS:
 	case SYNC_LOCK_SYS:
+	case SYNC_LOCK_REC_SHARD:
 	case SYNC_LOCK_WAIT_SYS:
 	case SYNC_TRX_SYS:
 	case SYNC_IBUF_BITMAP_MUTEX:
@@ -616,8 +617,9 @@ SyncDebug::check_order(const latch_t* latch)
 
 	case SYNC_BUF_FLUSH_LIST:
 	case SYNC_BUF_POOL:
+	case SYNC_SEARCH_SYS:
 
-		/* We can have multiple mutexes of this type therefore we
+		/* We can have multiple latches of this type therefore we
 		can only check whether the greater than condition holds. */
 
 		basic_check(latches, latch->m_level - 1);
@@ -923,6 +925,10 @@ sync_latch_meta_init()
 		  SYNC_IBUF_MUTEX,
 		  ibuf_mutex_key);
 
+	LATCH_ADD(SrvLatches, "ibuf_merge",
+		  SYNC_NO_ORDER_CHECK,
+		  ibuf_merge_mutex_key);
+
 	LATCH_ADD(SrvLatches, "ibuf_pessimistic_insert",
 		  SYNC_IBUF_PESS_INSERT_MUTEX,
 		  ibuf_pessimistic_insert_mutex_key);
@@ -955,6 +961,10 @@ sync_latch_meta_init()
 		  SYNC_MEM_POOL,
 		  mem_pool_mutex_key);
 
+	LATCH_ADD(SrvLatches, "page_cleaner",
+		  SYNC_PAGE_CLEANER,
+		  page_cleaner_mutex_key);
+
 	LATCH_ADD(SrvLatches, "purge_sys_pq",
 		  SYNC_PURGE_QUEUE,
 		  purge_sys_pq_mutex_key);
@@ -1041,9 +1051,9 @@ sync_latch_meta_init()
 		  SYNC_TRX,
 		  trx_mutex_key);
 
-	LATCH_ADD(SrvLatches, "lock_sys",
-		  SYNC_LOCK_SYS,
-		  lock_mutex_key);
+	LATCH_ADD(SrvLatches, "lock_rec_shard",
+		  SYNC_LOCK_REC_SHARD,
+		  lock_rec_shard_mutex_key);
 
 	LATCH_ADD(SrvLatches, "lock_sys_wait",
 		  SYNC_LOCK_WAIT_SYS,
@@ -1129,6 +1139,10 @@ sync_latch_meta_init()
 		  SYNC_NO_ORDER_CHECK,
 		  row_drop_list_mutex_key);
 
+	LATCH_ADD(SrvLatches, "row_merge",
+		  SYNC_ANY_LATCH,
+		  row_merge_mutex_key);
+
 	LATCH_ADD(SrvLatches, "index_online_log",
 		  SYNC_INDEX_ONLINE_LOG,
 		  index_online_log_key);
@@ -1186,6 +1200,10 @@ sync_latch_meta_init()
 		  SYNC_PURGE_LATCH,
 		  trx_purge_latch_key);
 
+	LATCH_ADD(SrvLatches, "lock_sys",
+		  SYNC_LOCK_SYS,
+		  lock_sys_latch_key);
+
 	LATCH_ADD(SrvLatches, "ibuf_index_tree",
 		  SYNC_IBUF_INDEX_TREE,
 		  index_tree_rw_lock_key);
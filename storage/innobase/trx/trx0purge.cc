@@ -33,6 +33,7 @@ Created 3/26/1996 Heikki Tuuri
 
 #include "fsp0fsp.h"
 #include "fut0fut.h"
+#include "log0log.h"
 #include "mach0data.h"
 #include "mtr0log.h"
 #include "os0thread.h"
@@ -50,6 +51,10 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0rseg.h"
 #include "trx0trx.h"
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 /** Maximum allowable purge history length.  <=0 means 'infinite'. */
 ulong		srv_max_purge_lag = 0;
 
@@ -261,6 +266,11 @@ trx_purge_sys_create(
 	purge_sys->view_active = true;
 
 	purge_sys->rseg_iter = new TrxUndoRsegsIterator(purge_sys);
+
+	purge_sys->heap = mem_heap_create(16 * 1024);
+
+	purge_sys->undo_trunc_space = ULINT_UNDEFINED;
+	purge_sys->undo_trunc_next = 1;
 }
 
 /************************************************************************
@@ -298,6 +308,8 @@ trx_purge_sys_close(void)
 
 	delete purge_sys->rseg_iter;
 
+	mem_heap_free(purge_sys->heap);
+
 	mem_free(purge_sys);
 
 	purge_sys = NULL;
@@ -1021,8 +1033,47 @@ trx_purge_fetch_next_rec(
 	return(trx_purge_get_next_rec(n_pages_handled, heap));
 }
 
+/** When the purge node that the undo records of a table are attached to
+has this many records more than the least loaded node, the next records of
+the table go to the least loaded node, so that one table cannot serialize
+the batch */
+static const ulint	TRX_PURGE_TABLE_IMBALANCE = 64;
+
+/** The purge node that the undo records of a table in a batch are
+attached to */
+struct trx_purge_table_t {
+	ulint		node;		/*!< index of the purge node */
+	ulint		n_recs;		/*!< number of undo records of the
+					table in the batch */
+};
+
+typedef std::map<table_id_t, trx_purge_table_t> trx_purge_tables_t;
+
 /*******************************************************************//**
-This function runs a purge batch.
+Returns the least loaded purge node of a batch.
+@return index of the node with the fewest undo records */
+static
+ulint
+trx_purge_min_node(
+/*===============*/
+	const std::vector<ulint>&	n_recs)	/*!< in: number of undo records
+						attached to each node */
+{
+	ulint	min = 0;
+
+	for (ulint i = 1; i < n_recs.size(); ++i) {
+		if (n_recs[i] < n_recs[min]) {
+			min = i;
+		}
+	}
+
+	return(min);
+}
+
+/*******************************************************************//**
+This function runs a purge batch. The undo records of a table are attached
+to the same purge node, so that the purge threads do not contend for the
+same index pages.
 @return number of undo log pages handled in the batch */
 static
 ulint
@@ -1041,6 +1092,10 @@ trx_purge_attach_undo_recs(
 
 	purge_sys->limit = purge_sys->iter;
 
+	std::vector<purge_node_t*>	nodes;
+	std::vector<ulint>		n_recs(n_purge_threads);
+	trx_purge_tables_t		tables;
+
 	/* Debug code to validate some pre-requisites and reset done flag. */
 	for (thr = UT_LIST_GET_FIRST(purge_sys->query->thrs);
 	     thr != NULL && i < n_purge_threads;
@@ -1054,35 +1109,29 @@ trx_purge_attach_undo_recs(
 		ut_a(que_node_get_type(node) == QUE_NODE_PURGE);
 		ut_a(node->undo_recs == NULL);
 		ut_a(node->done);
+		ut_a(!thr->is_active);
 
 		node->done = FALSE;
+
+		nodes.push_back(node);
 	}
 
 	/* There should never be fewer nodes than threads, the inverse
 	however is allowed because we only use purge threads as needed. */
 	ut_a(i == n_purge_threads);
-
-	/* Fetch and parse the UNDO records. The UNDO records are added
-	to a per purge node vector. */
-	thr = UT_LIST_GET_FIRST(purge_sys->query->thrs);
-	ut_a(n_thrs > 0 && thr != NULL);
+	ut_a(n_thrs > 0);
 
 	ut_ad(trx_purge_check_limit());
 
-	i = 0;
+	/* Fetch and parse the UNDO records. The UNDO records are added
+	to a per purge node vector. They are allocated from purge_sys->heap,
+	because a node empties its own heap as soon as it is done. */
 
 	for (;;) {
-		purge_node_t*		node;
 		trx_purge_rec_t*	purge_rec;
 
-		ut_a(!thr->is_active);
-
-		/* Get the purge node. */
-		node = (purge_node_t*) thr->child;
-		ut_a(que_node_get_type(node) == QUE_NODE_PURGE);
-
 		purge_rec = static_cast<trx_purge_rec_t*>(
-			mem_heap_zalloc(node->heap, sizeof(*purge_rec)));
+			mem_heap_zalloc(purge_sys->heap, sizeof(*purge_rec)));
 
 		/* Track the max {trx_id, undo_no} for truncating the
 		UNDO logs once we have purged the records. */
@@ -1093,40 +1142,96 @@ trx_purge_attach_undo_recs(
 
 		/* Fetch the next record, and advance the purge_sys->iter. */
 		purge_rec->undo_rec = trx_purge_fetch_next_rec(
-			&purge_rec->roll_ptr, &n_pages_handled, node->heap);
+			&purge_rec->roll_ptr, &n_pages_handled,
+			purge_sys->heap);
 
-		if (purge_rec->undo_rec != NULL) {
+		if (purge_rec->undo_rec == NULL) {
+			break;
+		}
 
-			if (node->undo_recs == NULL) {
-				node->undo_recs = ib_vector_create(
-					ib_heap_allocator_create(node->heap),
-					sizeof(trx_purge_rec_t),
-					batch_size);
-			} else {
-				ut_a(!ib_vector_is_empty(node->undo_recs));
-			}
+		ulint	min = trx_purge_min_node(n_recs);
+		ulint	n = min;
 
-			ib_vector_push(node->undo_recs, purge_rec);
+		if (purge_rec->undo_rec != &trx_purge_dummy_rec) {
+			ulint		type;
+			ulint		cmpl_info;
+			bool		updated_extern;
+			undo_no_t	undo_no;
+			table_id_t	table_id;
 
-			if (n_pages_handled >= batch_size) {
+			trx_undo_rec_get_pars(
+				purge_rec->undo_rec, &type, &cmpl_info,
+				&updated_extern, &undo_no, &table_id);
 
-				break;
+			std::pair<trx_purge_tables_t::iterator, bool>	ret;
+			trx_purge_table_t				table;
+
+			table.node = min;
+			table.n_recs = 0;
+
+			ret = tables.insert(
+				trx_purge_tables_t::value_type(
+					table_id, table));
+
+			trx_purge_table_t&	t = ret.first->second;
+
+			if (n_recs[t.node]
+			    >= n_recs[min] + TRX_PURGE_TABLE_IMBALANCE) {
+
+				t.node = min;
 			}
-		} else {
-			break;
+
+			++t.n_recs;
+			n = t.node;
 		}
 
-		thr = UT_LIST_GET_NEXT(thrs, thr);
+		purge_node_t*	node = nodes[n];
 
-		if (!(++i % n_purge_threads)) {
-			thr = UT_LIST_GET_FIRST(purge_sys->query->thrs);
+		if (node->undo_recs == NULL) {
+			node->undo_recs = ib_vector_create(
+				ib_heap_allocator_create(node->heap),
+				sizeof(trx_purge_rec_t),
+				batch_size);
+		} else {
+			ut_a(!ib_vector_is_empty(node->undo_recs));
 		}
 
-		ut_a(thr != NULL);
+		ib_vector_push(node->undo_recs, purge_rec);
+
+		++n_recs[n];
+
+		if (n_pages_handled >= batch_size) {
+
+			break;
+		}
 	}
 
 	ut_ad(trx_purge_check_limit());
 
+	/* Report the table that has the most undo records in the batch.
+	The purge of a table that keeps appearing here lags behind. */
+
+	trx_purge_tables_t::const_iterator	max = tables.end();
+
+	for (trx_purge_tables_t::const_iterator it = tables.begin();
+	     it != tables.end();
+	     ++it) {
+
+		if (max == tables.end()
+		    || it->second.n_recs > max->second.n_recs) {
+
+			max = it;
+		}
+	}
+
+	MONITOR_SET(MONITOR_PURGE_BATCH_TABLES, tables.size());
+
+	if (max != tables.end()) {
+		MONITOR_SET(MONITOR_PURGE_TABLE_MAX_RECORDS,
+			    max->second.n_recs);
+		MONITOR_SET(MONITOR_PURGE_TABLE_MAX_ID, max->first);
+	}
+
 	return(n_pages_handled);
 }
 
@@ -1217,6 +1322,411 @@ trx_purge_wait_for_workers_to_complete(
 	ut_a(srv_get_task_queue_length() == 0);
 }
 
+/** Undo tablespaces whose truncation was interrupted by a crash, see
+trx_purge_check_undo_space_truncated() */
+static std::vector<ulint>	trx_purge_undo_fix_up_spaces;
+
+/*******************************************************************//**
+Builds the name of the file that marks an undo tablespace as being
+truncated. The file exists from before the truncation starts until the
+truncated tablespace has been made durable by a checkpoint. */
+static
+void
+trx_purge_undo_trunc_log_name(
+/*==========================*/
+	ulint	space_id,	/*!< in: undo tablespace id */
+	char*	name,		/*!< out: file name */
+	ulint	size)		/*!< in: size of name */
+{
+	ut_snprintf(name, size, "%s%cundo%03lu_trunc.log",
+		    srv_undo_dir, SRV_PATH_SEPARATOR, (ulong) space_id);
+}
+
+/*******************************************************************//**
+Creates the file that marks an undo tablespace as being truncated.
+@return true if success */
+static
+bool
+trx_purge_undo_trunc_log_create(
+/*============================*/
+	ulint	space_id)	/*!< in: undo tablespace id */
+{
+	char		name[OS_FILE_MAX_PATH];
+	ibool		ret;
+
+	trx_purge_undo_trunc_log_name(space_id, name, sizeof(name));
+
+	os_file_t	handle = os_file_create(
+		innodb_log_file_key, name, OS_FILE_OVERWRITE,
+		OS_FILE_NORMAL, OS_LOG_FILE, &ret);
+
+	if (!ret) {
+		return(false);
+	}
+
+	os_file_flush(handle);
+	os_file_close(handle);
+
+	return(true);
+}
+
+/*******************************************************************//**
+Removes the file that marks an undo tablespace as being truncated. */
+static
+void
+trx_purge_undo_trunc_log_delete(
+/*============================*/
+	ulint	space_id)	/*!< in: undo tablespace id */
+{
+	char	name[OS_FILE_MAX_PATH];
+
+	trx_purge_undo_trunc_log_name(space_id, name, sizeof(name));
+
+	os_file_delete_if_exists(innodb_log_file_key, name, NULL);
+}
+
+/*******************************************************************//**
+Checks at startup whether the server crashed while purge was truncating
+an undo tablespace. If it did, the tablespace is remembered until
+trx_purge_fix_up_undo_spaces() has initialized it again; until then,
+its redo log is ignored and its rollback segments are not loaded.
+@return true if the truncation of the tablespace must be finished */
+
+bool
+trx_purge_check_undo_space_truncated(
+/*=================================*/
+	ulint	space_id)	/*!< in: undo tablespace id */
+{
+	char		name[OS_FILE_MAX_PATH];
+	ibool		exists;
+	os_file_type_t	type;
+
+	trx_purge_undo_trunc_log_name(space_id, name, sizeof(name));
+
+	if (!os_file_status(name, &exists, &type) || !exists) {
+		return(false);
+	}
+
+	ib_logf(IB_LOG_LEVEL_INFO,
+		"Found %s: finishing the truncation of undo tablespace %lu.",
+		name, (ulong) space_id);
+
+	trx_purge_undo_fix_up_spaces.push_back(space_id);
+
+	return(true);
+}
+
+/*******************************************************************//**
+Checks if an undo tablespace is waiting for
+trx_purge_fix_up_undo_spaces() after a crash during its truncation.
+@return true if the tablespace is being truncated */
+
+bool
+trx_purge_is_undo_space_truncated(
+/*==============================*/
+	ulint	space_id)	/*!< in: tablespace id */
+{
+	return(std::find(trx_purge_undo_fix_up_spaces.begin(),
+			 trx_purge_undo_fix_up_spaces.end(),
+			 space_id)
+	       != trx_purge_undo_fix_up_spaces.end());
+}
+
+/*******************************************************************//**
+Truncates an undo tablespace that no transaction and no history uses
+any more to its initial size, and re-creates its rollback segments in
+their slots of the trx system header. */
+static
+void
+trx_purge_reinit_undo_space(
+/*========================*/
+	ulint	space_id)	/*!< in: undo tablespace id */
+{
+	ulint		slots[TRX_SYS_N_RSEGS];
+	ulint		n_slots = 0;
+	mtr_t		mtr;
+
+	mtr_start(&mtr);
+
+	trx_sysf_t*	sys_header = trx_sysf_get(&mtr);
+
+	for (ulint i = 0; i < TRX_SYS_N_RSEGS; ++i) {
+
+		if (!trx_sys_is_noredo_rseg_slot(i)
+		    && trx_sysf_rseg_get_page_no(sys_header, i, &mtr)
+		    != FIL_NULL
+		    && trx_sysf_rseg_get_space(sys_header, i, &mtr)
+		    == space_id) {
+
+			slots[n_slots++] = i;
+		}
+	}
+
+	mtr_commit(&mtr);
+
+	if (!fil_truncate_undo_space(
+		    space_id, SRV_UNDO_TABLESPACE_SIZE_IN_PAGES)) {
+
+		/* The file may have been only partially truncated, the
+		undo tablespace cannot be used any more. */
+		ib_logf(IB_LOG_LEVEL_FATAL,
+			"Could not truncate undo tablespace %lu.",
+			(ulong) space_id);
+	}
+
+	for (ulint i = 0; i < n_slots; ++i) {
+		trx_rseg_recreate(space_id, slots[i]);
+	}
+}
+
+/*******************************************************************//**
+Finishes the truncation of the undo tablespaces that was interrupted by
+a crash: initializes their pages and re-creates their rollback segments.
+Called after the redo log has been applied. */
+
+void
+trx_purge_fix_up_undo_spaces(void)
+/*==============================*/
+{
+	if (trx_purge_undo_fix_up_spaces.empty()) {
+		return;
+	}
+
+	for (ulint i = 0; i < trx_purge_undo_fix_up_spaces.size(); ++i) {
+		trx_purge_reinit_undo_space(trx_purge_undo_fix_up_spaces[i]);
+	}
+
+	log_make_checkpoint_at(LSN_MAX, TRUE);
+
+	for (ulint i = 0; i < trx_purge_undo_fix_up_spaces.size(); ++i) {
+		ulint	space_id = trx_purge_undo_fix_up_spaces[i];
+
+		trx_purge_undo_trunc_log_delete(space_id);
+
+		ib_logf(IB_LOG_LEVEL_INFO,
+			"Truncated undo tablespace %lu.", (ulong) space_id);
+	}
+
+	trx_purge_undo_fix_up_spaces.clear();
+}
+
+/*******************************************************************//**
+Marks or unmarks the rollback segments of an undo tablespace, so that
+they are not assigned to new transactions. */
+static
+void
+trx_purge_undo_space_skip_allocation(
+/*=================================*/
+	ulint	space_id,	/*!< in: undo tablespace id */
+	bool	skip)		/*!< in: true to stop assigning them */
+{
+	for (ulint i = 0; i < TRX_SYS_N_RSEGS; ++i) {
+		trx_rseg_t*	rseg = trx_sys->rseg_array[i];
+
+		if (rseg != NULL && rseg->space == space_id) {
+			mutex_enter(&rseg->mutex);
+			rseg->skip_allocation = skip;
+			mutex_exit(&rseg->mutex);
+		}
+	}
+}
+
+/*******************************************************************//**
+Looks for an undo tablespace bigger than srv_max_undo_log_size, and
+marks it for truncation. Only tablespaces that hold nothing but redo
+rollback segments are considered, and only while other undo tablespaces
+have rollback segments that new transactions can use instead. */
+static
+void
+trx_purge_mark_undo_space(void)
+/*===========================*/
+{
+	ulint	n_spaces = srv_undo_tablespaces_open;
+
+	for (ulint n = 0; n < n_spaces; ++n) {
+		ulint	space_id = purge_sys->undo_trunc_next;
+
+		purge_sys->undo_trunc_next = space_id % n_spaces + 1;
+
+		if ((ib_uint64_t) fil_space_get_size(space_id) * UNIV_PAGE_SIZE
+		    <= srv_max_undo_log_size) {
+
+			continue;
+		}
+
+		bool	has_rseg = false;
+		bool	has_other_rseg = false;
+		bool	has_pending_rseg = false;
+
+		for (ulint i = 0; i < TRX_SYS_N_RSEGS; ++i) {
+			const trx_rseg_t*	rseg = trx_sys->rseg_array[i];
+
+			if (rseg == NULL) {
+				/* Unused slot */
+			} else if (rseg->space == space_id) {
+				has_rseg = true;
+			} else if (i < srv_undo_logs
+				   && rseg->space != srv_sys_space.space_id()
+				   && rseg->space != srv_tmp_space.space_id()) {
+				has_other_rseg = true;
+			}
+
+			rseg = trx_sys->pending_purge_rseg_array[i];
+
+			if (rseg != NULL && rseg->space == space_id) {
+				has_pending_rseg = true;
+			}
+		}
+
+		/* Rollback segments left over from an upgrade are never
+		truncated. While the tablespace is being drained, new
+		transactions must be able to use rollback segments in the
+		other undo tablespaces, not in the system tablespace. */
+		if (!has_rseg || !has_other_rseg || has_pending_rseg) {
+			continue;
+		}
+
+		ib_logf(IB_LOG_LEVEL_INFO,
+			"Marking undo tablespace %lu of size %lu pages for"
+			" truncation.", (ulong) space_id,
+			(ulong) fil_space_get_size(space_id));
+
+		trx_purge_undo_space_skip_allocation(space_id, true);
+
+		purge_sys->undo_trunc_space = space_id;
+		purge_sys->undo_trunc_marked_time = ut_time_us(NULL);
+
+		return;
+	}
+}
+
+/*******************************************************************//**
+Checks if purge has drained an undo tablespace marked for truncation:
+no transaction uses its rollback segments, and their history is empty.
+@return true if the tablespace can be truncated */
+static
+bool
+trx_purge_undo_space_is_drained(
+/*============================*/
+	ulint	space_id)	/*!< in: undo tablespace id */
+{
+	for (ulint i = 0; i < TRX_SYS_N_RSEGS; ++i) {
+		trx_rseg_t*	rseg = trx_sys->rseg_array[i];
+
+		if (rseg == NULL || rseg->space != space_id) {
+			continue;
+		}
+
+		mtr_t	mtr;
+
+		mtr_start(&mtr);
+
+		mutex_enter(&rseg->mutex);
+
+		ut_ad(rseg->skip_allocation);
+
+		bool	drained = rseg->trx_ref_count == 0
+			&& UT_LIST_GET_LEN(rseg->update_undo_list) == 0
+			&& UT_LIST_GET_LEN(rseg->insert_undo_list) == 0;
+
+		if (drained) {
+			trx_rsegf_t*	rseg_hdr = trx_rsegf_get(
+				rseg->space, rseg->zip_size, rseg->page_no,
+				&mtr);
+
+			drained = flst_get_len(
+				rseg_hdr + TRX_RSEG_HISTORY, &mtr) == 0;
+		}
+
+		mutex_exit(&rseg->mutex);
+
+		mtr_commit(&mtr);
+
+		if (!drained) {
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/*******************************************************************//**
+Truncates the undo tablespace marked for truncation once purge has
+drained it, or marks one if none is marked. The truncation is made crash
+safe by a marker file, created after a checkpoint has flushed all the
+pages of the tablespace, and removed after another checkpoint has made
+the truncated tablespace durable. */
+static
+void
+trx_purge_truncate_undo_spaces(void)
+/*================================*/
+{
+	ulint	space_id = purge_sys->undo_trunc_space;
+
+	if (space_id == ULINT_UNDEFINED) {
+
+		if (srv_undo_log_truncate && !srv_read_only_mode) {
+			trx_purge_mark_undo_space();
+		}
+
+		return;
+
+	} else if (!srv_undo_log_truncate) {
+
+		/* Truncation was disabled while the tablespace was
+		being drained. */
+		trx_purge_undo_space_skip_allocation(space_id, false);
+
+		purge_sys->undo_trunc_space = ULINT_UNDEFINED;
+
+		return;
+
+	} else if (!trx_purge_undo_space_is_drained(space_id)) {
+
+		return;
+	}
+
+	ullint	counter_time = ut_time_us(NULL);
+
+	MONITOR_SET(MONITOR_UNDO_TRUNCATE_DRAIN_MICROSECOND,
+		    counter_time - purge_sys->undo_trunc_marked_time);
+
+	ib_logf(IB_LOG_LEVEL_INFO,
+		"Truncating undo tablespace %lu.", (ulong) space_id);
+
+	log_make_checkpoint_at(LSN_MAX, TRUE);
+
+	if (!trx_purge_undo_trunc_log_create(space_id)) {
+
+		ib_logf(IB_LOG_LEVEL_ERROR,
+			"Could not create the truncation marker file of"
+			" undo tablespace %lu, not truncating it.",
+			(ulong) space_id);
+
+	} else {
+		DBUG_EXECUTE_IF("ib_undo_trunc_crash_before_truncate",
+				DBUG_SUICIDE(););
+
+		trx_purge_reinit_undo_space(space_id);
+
+		DBUG_EXECUTE_IF("ib_undo_trunc_crash_after_truncate",
+				DBUG_SUICIDE(););
+
+		log_make_checkpoint_at(LSN_MAX, TRUE);
+
+		trx_purge_undo_trunc_log_delete(space_id);
+
+		MONITOR_INC(MONITOR_UNDO_TRUNCATE_COUNT);
+	}
+
+	trx_purge_undo_space_skip_allocation(space_id, false);
+
+	purge_sys->undo_trunc_space = ULINT_UNDEFINED;
+
+	MONITOR_INC_TIME_IN_MICRO_SECS(
+		MONITOR_UNDO_TRUNCATE_MICROSECOND, counter_time);
+}
+
 /******************************************************************//**
 Remove old historical changes from the rollback segments. */
 static
@@ -1231,6 +1741,8 @@ trx_purge_truncate(void)
 	} else {
 		trx_purge_truncate_history(&purge_sys->limit, &purge_sys->view);
 	}
+
+	trx_purge_truncate_undo_spaces();
 }
 
 /*******************************************************************//**
@@ -1323,6 +1835,9 @@ run_synchronously:
 
 	ut_a(purge_sys->n_submitted == purge_sys->n_completed);
 
+	/* All the purge threads are done with the undo records. */
+	mem_heap_empty(purge_sys->heap);
+
 #ifdef UNIV_DEBUG
 	rw_lock_x_lock(&purge_sys->latch);
 	if (purge_sys->limit.trx_no == 0) {
@@ -115,24 +115,16 @@ trx_rseg_header_create(
 }
 
 /***********************************************************************//**
-Free's an instance of the rollback segment in memory. */
-
+Frees the undo log segments cached for reuse in a rollback segment. */
+static
 void
-trx_rseg_mem_free(
-/*==============*/
-	trx_rseg_t*	rseg,		/* in, own: instance to free */
-	trx_rseg_t**	rseg_array)	/*!< out: add rseg reference to this
-					central array. */
+trx_rseg_free_cached_undo(
+/*======================*/
+	trx_rseg_t*	rseg)		/*!< in/out: rollback segment */
 {
 	trx_undo_t*	undo;
 	trx_undo_t*	next_undo;
 
-	mutex_free(&rseg->mutex);
-
-	/* There can't be any active transactions. */
-	ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
-	ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
-
 	for (undo = UT_LIST_GET_FIRST(rseg->update_undo_cached);
 	     undo != NULL;
 	     undo = next_undo) {
@@ -158,6 +150,25 @@ trx_rseg_mem_free(
 
 		trx_undo_mem_free(undo);
 	}
+}
+
+/***********************************************************************//**
+Free's an instance of the rollback segment in memory. */
+
+void
+trx_rseg_mem_free(
+/*==============*/
+	trx_rseg_t*	rseg,		/* in, own: instance to free */
+	trx_rseg_t**	rseg_array)	/*!< out: add rseg reference to this
+					central array. */
+{
+	mutex_free(&rseg->mutex);
+
+	/* There can't be any active transactions. */
+	ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
+	ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
+
+	trx_rseg_free_cached_undo(rseg);
 
 	ut_a(*((trx_rseg_t**) rseg_array + rseg->id) == rseg);
 	*((trx_rseg_t**) rseg_array + rseg->id) = NULL;
@@ -346,6 +357,13 @@ trx_rseg_create_instance(
 
 			space = trx_sysf_rseg_get_space(sys_header, i, mtr);
 
+			if (trx_purge_is_undo_space_truncated(space)) {
+				/* The header of the rollback segment is
+				lost: trx_purge_fix_up_undo_spaces() will
+				create it again, after recovery. */
+				continue;
+			}
+
 			zip_size = !Tablespace::is_system_tablespace(space)
 				   ? fil_space_get_zip_size(space) : 0;
 
@@ -419,6 +437,74 @@ trx_rseg_create(
 	return(rseg);
 }
 
+/*********************************************************************//**
+Re-creates the header of a rollback segment in an undo tablespace that
+was truncated, in the same slot of the trx system header, and resets its
+memory object. The memory object is created if it does not exist yet.
+@return rollback segment memory object */
+
+trx_rseg_t*
+trx_rseg_recreate(
+/*==============*/
+	ulint	space,		/*!< in: id of the truncated UNDO tablespace */
+	ulint	slot_no)	/*!< in: rseg id == slot number in trx sys */
+{
+	mtr_t		mtr;
+	ulint		page_no;
+	trx_rseg_t*	rseg = trx_sys->rseg_array[slot_no];
+
+	ut_ad(!trx_sys_is_noredo_rseg_slot(slot_no));
+
+	if (rseg != NULL) {
+		/* The rollback segment was drained before its tablespace
+		was truncated: only the cached undo log segments remain,
+		and their pages no longer exist. */
+
+		mutex_enter(&rseg->mutex);
+
+		ut_a(rseg->space == space);
+		ut_a(rseg->skip_allocation);
+		ut_a(rseg->trx_ref_count == 0);
+		ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
+		ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
+
+		trx_rseg_free_cached_undo(rseg);
+
+		rseg->curr_size = 1;
+		rseg->last_page_no = FIL_NULL;
+		rseg->last_offset = 0;
+		rseg->last_trx_no = 0;
+		rseg->last_del_marks = FALSE;
+
+		mutex_exit(&rseg->mutex);
+	}
+
+	mtr_start(&mtr);
+
+	mtr_x_lock(fil_space_get_latch(space, NULL), &mtr);
+
+	page_no = trx_rseg_header_create(space, 0, ULINT_MAX, slot_no, &mtr);
+
+	ut_a(page_no != FIL_NULL);
+
+	if (rseg == NULL) {
+		trx_rseg_t** rseg_array =
+			static_cast<trx_rseg_t**>(trx_sys->rseg_array);
+
+		rseg = trx_rseg_mem_create(
+			slot_no, space, fil_space_get_zip_size(space), page_no,
+			purge_sys->purge_queue, rseg_array, &mtr);
+	}
+
+	mtr_commit(&mtr);
+
+	mutex_enter(&rseg->mutex);
+	rseg->page_no = page_no;
+	mutex_exit(&rseg->mutex);
+
+	return(rseg);
+}
+
 /*********************************************************************//**
 Creates the memory copies for rollback segments and initializes the
 rseg array in trx_sys at a database startup. */
@@ -114,6 +114,8 @@ trx_init(
 
 	trx->support_xa = true;
 
+	trx->search_latch = NULL;
+
 	trx->search_latch_timeout = BTR_SEA_TIMEOUT;
 
 	trx->dict_operation = TRX_DICT_OP_NONE;
@@ -514,6 +516,27 @@ trx_validate_state_before_free(trx_t* trx)
 	assert_trx_is_inactive(trx);
 }
 
+/********************************************************************//**
+Releases the redo rollback segment of a transaction, so that purge can
+truncate its undo tablespace when no other transaction uses it. */
+static
+void
+trx_release_redo_rseg(
+/*==================*/
+	trx_t*	trx)	/*!< in/out: transaction */
+{
+	trx_rseg_t*	rseg = trx->rsegs.m_redo.rseg;
+
+	if (rseg != NULL) {
+		mutex_enter(&rseg->mutex);
+		ut_ad(rseg->trx_ref_count > 0);
+		--rseg->trx_ref_count;
+		mutex_exit(&rseg->mutex);
+
+		trx->rsegs.m_redo.rseg = NULL;
+	}
+}
+
 /** Free and initialize a transaction object instantinated during recovery.
 @param trx trx object to free and initialize during recovery */
 
@@ -522,6 +545,8 @@ trx_free_resurrected(trx_t* trx)
 {
 	trx_validate_state_before_free(trx);
 
+	trx_release_redo_rseg(trx);
+
 	trx_init(trx);
 
 	trx_free(trx);
@@ -711,6 +736,7 @@ trx_resurrect_insert(
 	ut_d(trx->start_line = __LINE__);
 
 	trx->rsegs.m_redo.rseg = rseg;
+	++rseg->trx_ref_count;
 	*trx->xid = undo->xid;
 	trx->id = undo->trx_id;
 	trx->rsegs.m_redo.insert_undo = undo;
@@ -827,6 +853,15 @@ trx_resurrect_update(
 	trx_undo_t*	undo,	/*!< in/out: update UNDO record */
 	trx_rseg_t*	rseg)	/*!< in/out: rollback segment */
 {
+	/* The insert undo log of the transaction, if any, is in the same
+	rollback segment and may have resurrected it already. */
+	if (trx->rsegs.m_redo.rseg == NULL) {
+		++rseg->trx_ref_count;
+	}
+
+	ut_ad(trx->rsegs.m_redo.rseg == NULL
+	      || trx->rsegs.m_redo.rseg == rseg);
+
 	trx->rsegs.m_redo.rseg = rseg;
 	*trx->xid = undo->xid;
 	trx->id = undo->trx_id;
@@ -1025,13 +1060,28 @@ get_next_redo_rseg(
 			   && n_tablespaces > 0
 			   && trx_sys->rseg_array[slot] != NULL
 			   && trx_sys->rseg_array[slot]->space
-			   != srv_sys_space.space_id()) {
+			   != srv_sys_space.space_id()
+			   && !trx_sys->rseg_array[slot]->skip_allocation) {
 			/* If undo-tablespace is configured, skip
 			rseg from system-tablespace and try to use
 			undo-tablespace rseg unless it is not possible
 			due to lower limit of undo-logs. */
 			continue;
 		}
+
+		/* Purge sets skip_allocation under the rseg mutex and
+		then waits for trx_ref_count to drop to zero. */
+		mutex_enter(&rseg->mutex);
+
+		if (rseg->skip_allocation) {
+			mutex_exit(&rseg->mutex);
+			continue;
+		}
+
+		++rseg->trx_ref_count;
+
+		mutex_exit(&rseg->mutex);
+
 		break;
 	}
 
@@ -1152,6 +1202,8 @@ trx_assign_rseg(
 
 		trx_sys->rw_trx_ids.push_back(trx->id);
 
+		trx_sys->mvcc->snapshot_invalidate();
+
 		trx_sys->rw_trx_set.insert(TrxTrack(trx->id, trx));
 
 		mutex_exit(&trx_sys->mutex);
@@ -1236,6 +1288,8 @@ trx_start_low(
 
 		trx_sys->rw_trx_ids.push_back(trx->id);
 
+		trx_sys->mvcc->snapshot_invalidate();
+
 		trx_sys_rw_trx_add(trx);
 
 		ut_ad(trx->rsegs.m_redo.rseg != 0
@@ -1276,6 +1330,8 @@ trx_start_low(
 
 				trx_sys->rw_trx_ids.push_back(trx->id);
 
+				trx_sys->mvcc->snapshot_invalidate();
+
 				trx_sys->rw_trx_set.insert(
 					TrxTrack(trx->id, trx));
 			}
@@ -1827,6 +1883,8 @@ trx_commit_in_memory(
                 trx_finalize_for_fts(trx, not_rollback);
         }
 
+	trx_release_redo_rseg(trx);
+
 	trx_init(trx);
 
 	assert_trx_is_free(trx);
@@ -1935,6 +1993,8 @@ trx_commit_low(
 
 		trx_sys->rw_trx_ids.erase(it);
 
+		trx_sys->mvcc->snapshot_invalidate();
+
 		mutex_exit(&trx_sys->mutex);
 	}
 
@@ -1983,7 +2043,7 @@ trx_cleanup_at_db_startup(
 		trx_undo_insert_cleanup(&trx->rsegs.m_redo);
 	}
 
-	trx->rsegs.m_redo.rseg = NULL;
+	trx_release_redo_rseg(trx);
 	trx->undo_no = 0;
 	trx->undo_rseg_space = 0;
 	trx->last_sql_stat_start.least_undo_no = 0;
@@ -2988,6 +3048,8 @@ trx_set_rw_mode(
 
 	trx_sys->rw_trx_ids.push_back(trx->id);
 
+	trx_sys->mvcc->snapshot_invalidate();
+
 	trx_sys->rw_trx_set.insert(TrxTrack(trx->id, trx));
 
 	/* So that we can see our own changes. */
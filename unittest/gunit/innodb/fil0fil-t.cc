@@ -0,0 +1,162 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/* See http://code.google.com/p/googletest/wiki/Primer */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "univ.i"
+
+#include "fil0fil.h"
+#include "mach0data.h"
+#include "page0zip.h"
+
+namespace innodb_fil0fil_unittest {
+
+/** File system block size that the pages are padded to */
+static const ulint	block_size = 4096;
+
+/** Fill a page with the FIL header of an index page and records that
+compress well.
+@param page	out: page of UNIV_PAGE_SIZE bytes
+@param page_no	page number */
+static
+void
+fil_test_make_page(
+	byte*	page,
+	ulint	page_no)
+{
+	memset(page, 0, UNIV_PAGE_SIZE);
+
+	mach_write_to_4(page + FIL_PAGE_OFFSET, page_no);
+	mach_write_to_8(page + FIL_PAGE_LSN, 1000 + page_no);
+	mach_write_to_2(page + FIL_PAGE_TYPE, FIL_PAGE_INDEX);
+	mach_write_to_4(page + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID, 5);
+
+	for (ulint i = FIL_PAGE_DATA;
+	     i + 32 < UNIV_PAGE_SIZE * 3 / 4;
+	     i += 32) {
+		snprintf(reinterpret_cast<char*>(page + i), 32,
+			 "customer-%08lu-%lu", (ulong) i, (ulong) page_no);
+	}
+
+	mach_write_to_4(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_OLD_CHKSUM,
+			0xdeadbeef);
+}
+
+/* test that each available algorithm restores the page, and that the
+compressed page is padded to the block size */
+TEST(fil0fil, pagecompressroundtrip)
+{
+	std::vector<byte>	page(UNIV_PAGE_SIZE);
+	std::vector<byte>	zip(UNIV_PAGE_SIZE);
+
+	fil_test_make_page(&page[0], 3);
+
+	for (ulint i = 0; i < PAGE_ZIP_N_ALGORITHMS; i++) {
+		if (!page_zip_algorithm_is_available(
+			    static_cast<page_zip_algorithm_t>(i))) {
+			continue;
+		}
+
+		ulint	len = fil_page_compress(
+			&page[0], &zip[0], i, block_size);
+
+		ASSERT_LT(0U, len);
+		EXPECT_GT(UNIV_PAGE_SIZE, len);
+		EXPECT_EQ(0U, len % block_size);
+
+		EXPECT_EQ(ulint(FIL_PAGE_COMPRESSED),
+			  mach_read_from_2(&zip[FIL_PAGE_TYPE]));
+		EXPECT_EQ(0, memcmp(&page[0], &zip[0], FIL_PAGE_TYPE));
+
+		/* The end of the page is punched out of the file, and
+		reads back as zeros. */
+		memset(&zip[len], 0, UNIV_PAGE_SIZE - len);
+
+		EXPECT_TRUE(fil_page_decompress(&zip[0]));
+		EXPECT_EQ(0, memcmp(&page[0], &zip[0], UNIV_PAGE_SIZE));
+	}
+}
+
+/* test the pages that are written or read as they are */
+TEST(fil0fil, pagecompressuncompressed)
+{
+	std::vector<byte>	page(UNIV_PAGE_SIZE);
+	std::vector<byte>	zip(UNIV_PAGE_SIZE);
+	std::vector<byte>	copy;
+	ulint			rnd = 1;
+
+	fil_test_make_page(&page[0], 4);
+
+	/* A block as large as the page saves nothing. */
+	EXPECT_EQ(0U, fil_page_compress(
+			  &page[0], &zip[0], PAGE_ZIP_ALGORITHM_ZLIB,
+			  UNIV_PAGE_SIZE));
+
+	/* Random data does not compress. */
+	for (ulint i = FIL_PAGE_DATA; i < UNIV_PAGE_SIZE; i++) {
+		rnd = rnd * 1103515245 + 12345;
+		page[i] = static_cast<byte>(rnd >> 16);
+	}
+
+	EXPECT_EQ(0U, fil_page_compress(
+			  &page[0], &zip[0], PAGE_ZIP_ALGORITHM_ZLIB,
+			  block_size));
+
+	/* Pages that were not compressed are left alone. */
+	copy = page;
+
+	EXPECT_TRUE(fil_page_decompress(&page[0]));
+	EXPECT_EQ(0, memcmp(&copy[0], &page[0], UNIV_PAGE_SIZE));
+}
+
+/* test that a corrupted compressed page is left as it is */
+TEST(fil0fil, pagecompresscorrupted)
+{
+	std::vector<byte>	page(UNIV_PAGE_SIZE);
+	std::vector<byte>	zip(UNIV_PAGE_SIZE);
+	std::vector<byte>	copy;
+
+	fil_test_make_page(&page[0], 5);
+
+	ulint	len = fil_page_compress(
+		&page[0], &zip[0], PAGE_ZIP_ALGORITHM_ZLIB, block_size);
+
+	ASSERT_LT(0U, len);
+
+	memset(&zip[FIL_PAGE_COMPRESS_DATA + 16], 0xff, 64);
+	copy = zip;
+
+	EXPECT_FALSE(fil_page_decompress(&zip[0]));
+	EXPECT_EQ(0, memcmp(&copy[0], &zip[0], UNIV_PAGE_SIZE));
+
+	/* An unknown algorithm */
+	zip = copy;
+	mach_write_to_1(&zip[FIL_PAGE_COMPRESS_ALGORITHM],
+			PAGE_ZIP_N_ALGORITHMS);
+
+	EXPECT_FALSE(fil_page_decompress(&zip[0]));
+}
+
+}
@@ -0,0 +1,315 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/* See http://code.google.com/p/googletest/wiki/Primer */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "handler.h"
+
+#include "univ.i"
+
+#include "log0log.h"
+#include "log0recv.h"
+#include "mem0mem.h"
+#include "os0event.h"
+#include "srv0conc.h"
+#include "srv0srv.h"
+#include "sync0debug.h"
+
+#include "thread_utils.h"
+
+namespace innodb_log0log_unittest {
+
+/** Sets up the log system without any log group: nothing in these tests
+writes to a log file. */
+static
+void
+log_test_init()
+{
+	srv_max_n_threads = srv_sync_array_size + 1;
+	os_event_init();
+	sync_check_init();
+	mem_init(1024 * 1024);
+
+	srv_log_buffer_size = 16 * 1024 * 1024 / UNIV_PAGE_SIZE;
+
+	log_init();
+
+	/* Keep log_buffer_close() away from the checkpoint checks, which
+	need the buffer pool. */
+	log_sys->log_group_capacity = LSN_MAX;
+	log_sys->max_modified_age_sync = LSN_MAX;
+	log_sys->max_checkpoint_age_async = LSN_MAX;
+	log_sys->max_checkpoint_age = LSN_MAX;
+}
+
+static
+void
+log_test_close()
+{
+	log_shutdown();
+	log_mem_free();
+	mem_close();
+	sync_check_close();
+}
+
+/** Pretends that the log has been written to the log files up to where
+the log buffer is completely filled, so that log_buffer_reserve() never
+has to wait for a log write. */
+static
+void
+log_test_discard_written()
+{
+	log_mutex_enter();
+	log_sys->written_to_all_lsn = log_buffer_advance_written();
+	log_mutex_exit();
+}
+
+class log0log : public ::testing::Test {
+protected:
+	static void SetUpTestCase()
+	{
+		log_test_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		log_test_close();
+	}
+};
+
+/* test copying log records across log block boundaries */
+TEST_F(log0log, bufferwriteacrossblocks)
+{
+	byte	rec[3 * OS_FILE_LOG_BLOCK_SIZE];
+	lsn_t	start_lsn;
+	lsn_t	end_lsn;
+	lsn_t	lsn;
+	ulint	n;
+
+	for (n = 0; n < sizeof rec; n++) {
+		rec[n] = static_cast<byte>(n * 7);
+	}
+
+	start_lsn = log_buffer_reserve(sizeof rec, false, &end_lsn);
+
+	EXPECT_EQ(recv_calc_lsn_on_data_add(start_lsn, sizeof rec), end_lsn);
+	EXPECT_EQ(end_lsn, log_sys->lsn);
+
+	lsn = log_buffer_write(start_lsn, rec, 100);
+	lsn = log_buffer_write(lsn, rec + 100, sizeof rec - 100);
+
+	EXPECT_EQ(end_lsn, lsn);
+
+	/* The range is not complete before it has been published. */
+	log_mutex_enter();
+	EXPECT_EQ(start_lsn, log_buffer_advance_written());
+	log_mutex_exit();
+
+	log_buffer_close(start_lsn, end_lsn);
+
+	log_mutex_enter();
+	EXPECT_EQ(end_lsn, log_buffer_advance_written());
+	log_mutex_exit();
+
+	/* The next record group starts in the last block of the range. */
+	const byte*	block = log_buffer_get_block(end_lsn);
+
+	EXPECT_EQ(log_block_convert_lsn_to_no(end_lsn),
+		  log_block_get_hdr_no(block));
+	EXPECT_EQ(end_lsn % OS_FILE_LOG_BLOCK_SIZE,
+		  log_block_get_first_rec_group(block));
+
+	/* Read the records back, skipping the block headers and trailers. */
+	for (lsn = start_lsn, n = 0; n < sizeof rec; ) {
+		ulint	offset = (ulint) (lsn % OS_FILE_LOG_BLOCK_SIZE);
+		ulint	len = ut_min(OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE
+				     - offset, sizeof rec - n);
+
+		EXPECT_EQ(0, memcmp(log_buffer_get_block(lsn) + offset,
+				    rec + n, len));
+
+		n += len;
+		lsn += len;
+
+		if (offset + len
+		    == OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+			lsn += LOG_BLOCK_TRL_SIZE + LOG_BLOCK_HDR_SIZE;
+		}
+	}
+
+	EXPECT_EQ(end_lsn, lsn);
+}
+
+/* test that zero length reservations do not move the lsn */
+TEST_F(log0log, bufferreserveempty)
+{
+	lsn_t	start_lsn;
+	lsn_t	end_lsn;
+	lsn_t	lsn = log_sys->lsn;
+
+	start_lsn = log_buffer_reserve(0, true, &end_lsn);
+	log_flush_order_mutex_exit();
+
+	EXPECT_EQ(lsn, start_lsn);
+	EXPECT_EQ(lsn, end_lsn);
+	EXPECT_EQ(lsn, log_sys->lsn);
+}
+
+/** How a benchmark thread copies its log records */
+enum log_benchmark_mode {
+	/** reserve with an atomic lsn update, copy in parallel */
+	LOG_BENCHMARK_CONCURRENT,
+	/** reserve holding the flush order mutex, like a mini-transaction
+	that dirtied a clean page, copy in parallel */
+	LOG_BENCHMARK_FLUSH_ORDER,
+	/** reserve and copy holding one mutex, like mtr_commit() did when
+	it held log_sys->mutex for the whole copy */
+	LOG_BENCHMARK_SERIALIZED
+};
+
+/** A thread which commits mini-transaction logs of a typical size in a
+loop. Used for benchmarking the redo log buffer. */
+class log_benchmark_thread : public thread::Thread {
+public:
+	log_benchmark_thread(log_benchmark_mode mode, ulint n_iterations)
+		: m_mode(mode),
+		  m_n_iterations(n_iterations)
+	{}
+
+	virtual void run()
+	{
+		byte	rec[100];
+		bool	flush_order = m_mode != LOG_BENCHMARK_CONCURRENT;
+
+		memset(rec, 0xa5, sizeof rec);
+
+		for (ulint i = 0; i < m_n_iterations; i++) {
+			lsn_t	start_lsn;
+			lsn_t	end_lsn;
+			lsn_t	lsn;
+
+			if (log_sys->lsn - log_sys->written_to_all_lsn
+			    > log_sys->buf_size / 4) {
+				log_test_discard_written();
+			}
+
+			start_lsn = log_buffer_reserve(
+				sizeof rec, flush_order, &end_lsn);
+
+			if (m_mode == LOG_BENCHMARK_FLUSH_ORDER) {
+				log_flush_order_mutex_exit();
+			}
+
+			lsn = log_buffer_write(start_lsn, rec, sizeof rec);
+			EXPECT_EQ(end_lsn, lsn);
+
+			log_buffer_close(start_lsn, end_lsn);
+
+			if (m_mode == LOG_BENCHMARK_SERIALIZED) {
+				log_flush_order_mutex_exit();
+			}
+		}
+	}
+
+private:
+	log_benchmark_mode	m_mode;
+	ulint			m_n_iterations;
+};
+
+#if defined(GTEST_HAS_PARAM_TEST)
+
+/*
+  Benchmark of committing mini-transaction logs to the log buffer from
+  concurrent threads, parameterized by the number of threads.
+
+  In order to do benchmarking, configure in optimized mode, and
+  generate a separate executable for this file:
+    cmake -DMERGE_UNITTESTS=0
+  then increase n_iterations and run 'log0log-t --disable-tap-output'
+  to compare the timing reports of the three modes for 1 to 64 threads.
+*/
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+static const ulint	n_iterations = 100;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// static const ulint	n_iterations = 1000000;
+static const ulint	n_iterations = 1000;
+#endif
+
+class log0logBenchmark : public ::testing::TestWithParam<int> {
+protected:
+	static void SetUpTestCase()
+	{
+		log_test_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		log_test_close();
+	}
+
+	void run_threads(log_benchmark_mode mode)
+	{
+		const int	n_threads = GetParam();
+		std::vector<log_benchmark_thread*>	threads;
+
+		for (int i = 0; i < n_threads; ++i) {
+			threads.push_back(
+				new log_benchmark_thread(mode, n_iterations));
+		}
+
+		for (int i = 0; i < n_threads; ++i) {
+			threads[i]->start();
+		}
+
+		for (int i = 0; i < n_threads; ++i) {
+			threads[i]->join();
+			delete threads[i];
+		}
+
+		/* Every reserved range has been published. */
+		log_test_discard_written();
+		EXPECT_EQ(log_sys->lsn, log_sys->recent_written_lsn);
+	}
+};
+
+INSTANTIATE_TEST_CASE_P(Threads, log0logBenchmark,
+			::testing::Values(1, 2, 4, 8, 16, 32, 64));
+
+TEST_P(log0logBenchmark, ConcurrentCopy)
+{
+	run_threads(LOG_BENCHMARK_CONCURRENT);
+}
+
+TEST_P(log0logBenchmark, FlushOrderCopy)
+{
+	run_threads(LOG_BENCHMARK_FLUSH_ORDER);
+}
+
+TEST_P(log0logBenchmark, SerializedCopy)
+{
+	run_threads(LOG_BENCHMARK_SERIALIZED);
+}
+
+#endif  // GTEST_HAS_PARAM_TEST
+
+}
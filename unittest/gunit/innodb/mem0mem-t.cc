@@ -27,20 +27,21 @@
 
 namespace innodb_mem0mem_unittest {
 
-static bool	innodb_inited = false;
-
 class mem0mem : public ::testing::Test {
 protected:
-	virtual void
-	SetUp()
+	static void SetUpTestCase()
 	{
-		if (!innodb_inited) {
-			srv_max_n_threads = srv_sync_array_size + 1;
-			sync_check_init();
-			mem_init(1024);
+		srv_max_n_threads = srv_sync_array_size + 1;
+		sync_check_init();
+		mem_init(1024);
+	}
 
-			innodb_inited = true;
-		}
+	/* Let the other test cases of merge_innodb_tests-t initialize
+	InnoDB again */
+	static void TearDownTestCase()
+	{
+		mem_close();
+		sync_check_close();
 	}
 };
 
@@ -0,0 +1,558 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/* See http://code.google.com/p/googletest/wiki/Primer */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "univ.i"
+
+#include "buf0buf.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "dict0mem.h"
+#include "fil0fil.h"
+#include "mach0data.h"
+#include "mem0mem.h"
+#include "os0event.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "page0zip.h"
+#include "rem0rec.h"
+#include "srv0conc.h"
+#include "srv0srv.h"
+#include "sync0debug.h"
+#include "ut0ut.h"
+
+namespace innodb_page0zip_unittest {
+
+/** Size of the page images */
+static const ulint	page_size = UNIV_PAGE_SIZE_DEF;
+
+/** Names of page_zip_algorithm_t */
+static const char*	algorithm_names[PAGE_ZIP_N_ALGORITHMS] = {
+	"zlib", "lz4", "zstd"
+};
+
+/** The part of each page image that page_zip_compress() compresses:
+the records from PAGE_ZIP_START to PAGE_HEAP_TOP */
+typedef std::vector<std::vector<byte> >	page_images_t;
+
+/** Read the index pages of an uncompressed tablespace file.
+@param name	file name
+@param pages	out: the records of the index pages */
+static
+void
+page_zip_test_read_file(
+	const char*	name,
+	page_images_t&	pages)
+{
+	FILE*	file = fopen(name, "rb");
+
+	if (file == NULL) {
+		ADD_FAILURE() << "cannot open " << name;
+		return;
+	}
+
+	std::vector<byte>	page(page_size);
+
+	while (fread(&page[0], 1, page_size, file) == page_size) {
+		ulint	heap_top = mach_read_from_2(
+			&page[PAGE_HEADER + PAGE_HEAP_TOP]);
+
+		if (mach_read_from_2(&page[FIL_PAGE_TYPE]) != FIL_PAGE_INDEX
+		    || heap_top <= PAGE_ZIP_START
+		    || heap_top > page_size - PAGE_DIR) {
+			continue;
+		}
+
+		pages.push_back(std::vector<byte>(
+			page.begin() + PAGE_ZIP_START,
+			page.begin() + heap_top));
+	}
+
+	fclose(file);
+}
+
+/** Generate records that look like those of a secondary index on
+(VARCHAR, INT): ascending keys that share a prefix, each preceded by
+a length byte and a 5-byte record header.
+@param pages	out: the records of the pages
+@param n_pages	number of pages to generate */
+static
+void
+page_zip_test_make_pages(
+	page_images_t&	pages,
+	ulint		n_pages)
+{
+	static const char*	words[] = {
+		"alpha", "bravo", "charlie", "delta", "echo", "foxtrot",
+		"golf", "hotel", "india", "juliett", "kilo", "lima"
+	};
+	const ulint		n_words = sizeof words / sizeof *words;
+	ulint			rnd = 1;
+	ulint			key = 0;
+
+	for (ulint i = 0; i < n_pages; i++) {
+		std::vector<byte>	recs;
+		ulint			heap_no = PAGE_HEAP_NO_USER_LOW;
+
+		while (recs.size() + 64
+		       < page_size * 15 / 16 - PAGE_ZIP_START - PAGE_DIR) {
+			char	buf[48];
+
+			rnd = rnd * 1103515245 + 12345;
+
+			int	len = snprintf(buf, sizeof buf,
+					       "customer-%08lu-%s",
+					       (ulong) key,
+					       words[(rnd >> 16) % n_words]);
+
+			recs.push_back(static_cast<byte>(len));
+			/* info bits and n_owned, heap_no and status,
+			next record offset */
+			recs.push_back(0);
+			recs.push_back(static_cast<byte>(heap_no >> 5));
+			recs.push_back(static_cast<byte>(heap_no << 3));
+			recs.push_back(0);
+			recs.push_back(static_cast<byte>(6 + len + 4));
+			recs.insert(recs.end(), buf, buf + len);
+
+			byte	int_col[4];
+
+			mach_write_to_4(int_col, (rnd >> 8) & 0xffffff);
+			recs.insert(recs.end(), int_col, int_col + 4);
+
+			key += 1 + (rnd >> 20) % 4;
+			heap_no++;
+		}
+
+		pages.push_back(recs);
+	}
+}
+
+/** Load the page images: the index pages of the file that the
+environment variable PAGE_ZIP_TEST_FILE names, if it is set,
+otherwise generated ones.
+@param pages	out: the records of the pages */
+static
+void
+page_zip_test_load(
+	page_images_t&	pages)
+{
+	const char*	name = getenv("PAGE_ZIP_TEST_FILE");
+
+	if (name != NULL) {
+		page_zip_test_read_file(name, pages);
+	} else {
+		page_zip_test_make_pages(pages, 64);
+	}
+}
+
+/* test that each available algorithm restores the page images, and
+that zlib is always available */
+TEST(page0zip, roundtrip)
+{
+	page_images_t		pages;
+	std::vector<byte>	zip(2 * page_size);
+	std::vector<byte>	unzip(page_size);
+
+	page_zip_test_load(pages);
+
+	ASSERT_FALSE(pages.empty());
+	EXPECT_TRUE(page_zip_algorithm_is_available(PAGE_ZIP_ALGORITHM_ZLIB));
+
+	for (int i = 0; i < PAGE_ZIP_N_ALGORITHMS; i++) {
+		page_zip_algorithm_t	algorithm
+			= static_cast<page_zip_algorithm_t>(i);
+
+		if (!page_zip_algorithm_is_available(algorithm)) {
+			continue;
+		}
+
+		for (ulint j = 0; j < pages.size(); j++) {
+			const std::vector<byte>&	page = pages[j];
+
+			ulint	zip_len = page_zip_compress_buf(
+				algorithm, DEFAULT_COMPRESSION_LEVEL,
+				&page[0], page.size(), &zip[0], zip.size());
+
+			ASSERT_LT(0U, zip_len);
+
+			ulint	len = page_zip_decompress_buf(
+				algorithm, &zip[0], zip_len,
+				&unzip[0], unzip.size());
+
+			ASSERT_EQ(page.size(), len);
+			EXPECT_EQ(0, memcmp(&page[0], &unzip[0], len));
+		}
+
+		/* The output buffer is too small. */
+		EXPECT_EQ(0U, page_zip_compress_buf(
+				  algorithm, DEFAULT_COMPRESSION_LEVEL,
+				  &pages[0][0], pages[0].size(), &zip[0], 4));
+	}
+}
+
+/** Size of the compressed pages of page0zipIndexPage */
+static const ulint	zip_size = UNIV_PAGE_SIZE_DEF / 2;
+
+/** Compresses and decompresses real B-tree pages: the leaf pages of a
+secondary index on (VARCHAR(32), INT UNSIGNED) of a table that uses
+each algorithm. */
+class page0zipIndexPage : public ::testing::Test {
+protected:
+	static void SetUpTestCase()
+	{
+		srv_max_n_threads = srv_sync_array_size + 1;
+		os_event_init();
+		sync_check_init();
+		mem_init(1024 * 1024);
+		/* page_create_low() uses the dummy index of infimum and
+		supremum */
+		dict_ind_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		/* dict_ind_free() is private to dict_close() */
+		dict_index_t*	indexes[] = {
+			dict_ind_compact, dict_ind_redundant
+		};
+
+		for (ulint i = 0; i < 2; i++) {
+			dict_table_t*	table = indexes[i]->table;
+
+			dict_mem_index_free(indexes[i]);
+			dict_mem_table_free(table);
+		}
+
+		dict_ind_compact = dict_ind_redundant = NULL;
+
+		mem_close();
+		sync_check_close();
+	}
+
+	virtual void SetUp()
+	{
+		m_heap = mem_heap_create(1024);
+
+		m_page_buf = static_cast<byte*>(
+			mem_heap_alloc(m_heap, 3 * UNIV_PAGE_SIZE));
+		m_page = static_cast<page_t*>(
+			ut_align(m_page_buf, UNIV_PAGE_SIZE));
+		m_unzip_page = m_page + UNIV_PAGE_SIZE;
+		m_zip_data = static_cast<byte*>(
+			mem_heap_zalloc(m_heap, zip_size));
+
+		m_table = NULL;
+		m_index = NULL;
+	}
+
+	virtual void TearDown()
+	{
+		if (m_index != NULL) {
+			dict_mem_index_free(m_index);
+		}
+
+		if (m_table != NULL) {
+			dict_mem_table_free(m_table);
+		}
+
+		mem_heap_free(m_heap);
+	}
+
+	/** Create the table and the index.
+	@param algorithm	compression algorithm of the table */
+	void create_index(page_zip_algorithm_t algorithm)
+	{
+		m_table = dict_mem_table_create(
+			"test/t1", 1, 2, DICT_TF_COMPACT,
+			algorithm << DICT_TF2_POS_ZIP_ALGORITHM);
+
+		dict_mem_table_add_col(m_table, m_table->heap, "b",
+				       DATA_VARCHAR,
+				       DATA_ENGLISH | DATA_NOT_NULL, 32);
+		dict_mem_table_add_col(m_table, m_table->heap, "c",
+				       DATA_INT,
+				       DATA_UNSIGNED | DATA_NOT_NULL, 4);
+
+		m_index = dict_mem_index_create("test/t1", "b", 1, 0, 2);
+		dict_index_add_col(m_index, m_table,
+				   dict_table_get_nth_col(m_table, 0), 0);
+		dict_index_add_col(m_index, m_table,
+				   dict_table_get_nth_col(m_table, 1), 0);
+		m_index->table = m_table;
+		m_index->id = 42;
+		m_index->n_uniq = 2;
+		m_index->cached = TRUE;
+	}
+
+	/** Create the page and fill half of it with records in
+	ascending order. The block is only a descriptor of the page,
+	so nothing is logged.
+	@return the compressed page descriptor of the block */
+	page_zip_des_t* create_page()
+	{
+		buf_block_t*	block = static_cast<buf_block_t*>(
+			mem_heap_zalloc(m_heap, sizeof *block));
+
+		block->frame = m_page;
+		block->page.state = BUF_BLOCK_MEMORY;
+		page_zip_des_init(&block->page.zip);
+		block->page.zip.data = m_zip_data;
+		page_zip_set_size(&block->page.zip, zip_size);
+
+		page_create_zip(block, m_index, 0, 0, NULL, NULL);
+		mach_write_to_8(m_page + PAGE_HEADER + PAGE_INDEX_ID,
+				m_index->id);
+
+		rec_t*		cur = m_page + PAGE_NEW_INFIMUM;
+		dtuple_t*	tuple = dtuple_create(m_heap, 2);
+		ulint		key = 0;
+
+		dict_index_copy_types(tuple, m_index, 2);
+
+		while (page_header_get_field(m_page, PAGE_HEAP_TOP)
+		       < UNIV_PAGE_SIZE / 2) {
+			char	b[33];
+			byte	c[4];
+
+			int	len = snprintf(b, sizeof b, "customer-%08lu",
+					       (ulong) key);
+
+			mach_write_to_4(c, key * 7 % 1000);
+			key += 3;
+
+			dfield_set_data(dtuple_get_nth_field(tuple, 0),
+					b, len);
+			dfield_set_data(dtuple_get_nth_field(tuple, 1),
+					c, sizeof c);
+
+			byte*	buf = static_cast<byte*>(mem_heap_alloc(
+				m_heap, rec_get_converted_size(
+					m_index, tuple, 0)));
+			rec_t*	rec = rec_convert_dtuple_to_rec(
+				buf, m_index, tuple, 0);
+			ulint*	offsets = rec_get_offsets(
+				rec, m_index, NULL, ULINT_UNDEFINED, &m_heap);
+
+			cur = page_cur_insert_rec_low(
+				cur, m_index, rec, offsets, NULL);
+
+			if (cur == NULL) {
+				ADD_FAILURE() << "the page is full";
+				break;
+			}
+		}
+
+		return(&block->page.zip);
+	}
+
+	mem_heap_t*	m_heap;
+	byte*		m_page_buf;
+	page_t*		m_page;
+	page_t*		m_unzip_page;
+	byte*		m_zip_data;
+	dict_table_t*	m_table;
+	dict_index_t*	m_index;
+};
+
+/* test that page_zip_compress() compresses an index page with the
+algorithm of the table, and that page_zip_decompress() restores the
+records */
+TEST_F(page0zipIndexPage, compressdecompress)
+{
+	for (int i = 0; i < PAGE_ZIP_N_ALGORITHMS; i++) {
+		page_zip_algorithm_t	algorithm
+			= static_cast<page_zip_algorithm_t>(i);
+
+		if (!page_zip_algorithm_is_available(algorithm)) {
+			printf("%s: not available\n",
+			       algorithm_names[algorithm]);
+			continue;
+		}
+
+		SCOPED_TRACE(algorithm_names[algorithm]);
+
+		TearDown();
+		SetUp();
+		create_index(algorithm);
+
+		page_zip_des_t*	page_zip = create_page();
+
+		ASSERT_LT(100U, page_get_n_recs(m_page));
+		ASSERT_TRUE(page_zip_compress(
+				    page_zip, m_page, m_index,
+				    DEFAULT_COMPRESSION_LEVEL, NULL, NULL));
+
+		/* Each page names its algorithm; zlib streams have
+		Z_DEFLATED in the low bits of the first byte. */
+		const byte	first = page_zip->data[PAGE_DATA];
+
+		if (algorithm == PAGE_ZIP_ALGORITHM_ZLIB) {
+			EXPECT_NE(0x0f, first & 0x0f);
+		} else {
+			EXPECT_EQ((algorithm << 4) | 0x0f, first);
+		}
+
+		memset(m_unzip_page, 0, UNIV_PAGE_SIZE);
+
+		ASSERT_TRUE(page_zip_decompress(page_zip, m_unzip_page, TRUE));
+
+		ASSERT_EQ(page_get_n_recs(m_page),
+			  page_get_n_recs(m_unzip_page));
+
+		const rec_t*	rec = page_rec_get_next_const(
+			page_get_infimum_rec(m_page));
+		const rec_t*	unzip_rec = page_rec_get_next_const(
+			page_get_infimum_rec(m_unzip_page));
+
+		while (!page_rec_is_supremum(rec)) {
+			ulint*	offsets = rec_get_offsets(
+				rec, m_index, NULL, ULINT_UNDEFINED, &m_heap);
+
+			ASSERT_EQ(page_offset(rec), page_offset(unzip_rec));
+			EXPECT_EQ(0, memcmp(rec, unzip_rec,
+					    rec_offs_data_size(offsets)));
+
+			rec = page_rec_get_next_const(rec);
+			unzip_rec = page_rec_get_next_const(unzip_rec);
+		}
+
+		EXPECT_TRUE(page_rec_is_supremum(unzip_rec));
+	}
+}
+
+#if defined(GTEST_HAS_PARAM_TEST)
+
+/*
+  Benchmark of the compression algorithms of ROW_FORMAT=COMPRESSED,
+  parameterized by page_zip_algorithm_t. It reports the compression
+  ratio and the compression and decompression throughput in MB/s of
+  the uncompressed data.
+
+  In order to do benchmarking, configure in optimized mode, and
+  generate a separate executable for this file:
+    cmake -DMERGE_UNITTESTS=0
+  then increase n_iterations and run
+    PAGE_ZIP_TEST_FILE=/path/to/table.ibd page0zip-t
+  on a file-per-table tablespace of an uncompressed table with the
+  default page size. Without PAGE_ZIP_TEST_FILE, generated pages are
+  used. The algorithms that are not built in are skipped. zlib is
+  measured as one block here, like the other algorithms; the pages
+  themselves are compressed as a zlib stream.
+*/
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+static const ulint	n_iterations = 1;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// static const ulint	n_iterations = 1000;
+static const ulint	n_iterations = 10;
+#endif
+
+class page0zipBenchmark : public ::testing::TestWithParam<int> {
+protected:
+	static void SetUpTestCase()
+	{
+		m_pages = new page_images_t;
+
+		page_zip_test_load(*m_pages);
+	}
+
+	static void TearDownTestCase()
+	{
+		delete m_pages;
+		m_pages = NULL;
+	}
+
+	static page_images_t*	m_pages;
+};
+
+page_images_t*	page0zipBenchmark::m_pages;
+
+INSTANTIATE_TEST_CASE_P(Algorithm, page0zipBenchmark,
+			::testing::Range(0, int(PAGE_ZIP_N_ALGORITHMS)));
+
+TEST_P(page0zipBenchmark, CompressDecompress)
+{
+	page_zip_algorithm_t	algorithm
+		= static_cast<page_zip_algorithm_t>(GetParam());
+
+	if (!page_zip_algorithm_is_available(algorithm)) {
+		printf("%s: not available\n", algorithm_names[algorithm]);
+		return;
+	}
+
+	ASSERT_FALSE(m_pages->empty());
+
+	std::vector<byte>	zip(2 * page_size);
+	std::vector<byte>	unzip(page_size);
+	ullint			n_bytes = 0;
+	ullint			n_zip_bytes = 0;
+	ullint			compress_us = 0;
+	ullint			decompress_us = 0;
+
+	for (ulint i = 0; i < n_iterations; ++i) {
+		for (ulint j = 0; j < m_pages->size(); j++) {
+			const std::vector<byte>&	page = (*m_pages)[j];
+			ullint	start = ut_time_us(NULL);
+
+			ulint	zip_len = page_zip_compress_buf(
+				algorithm, DEFAULT_COMPRESSION_LEVEL,
+				&page[0], page.size(), &zip[0], zip.size());
+
+			ullint	end = ut_time_us(NULL);
+
+			compress_us += end - start;
+
+			ASSERT_LT(0U, zip_len);
+
+			ulint	len = page_zip_decompress_buf(
+				algorithm, &zip[0], zip_len,
+				&unzip[0], unzip.size());
+
+			decompress_us += ut_time_us(NULL) - end;
+
+			ASSERT_EQ(page.size(), len);
+
+			n_bytes += len;
+			n_zip_bytes += zip_len;
+		}
+	}
+
+	printf("%s: %lu pages, ratio %.2f,"
+	       " compress %.1f MB/s, decompress %.1f MB/s\n",
+	       algorithm_names[algorithm], (ulong) m_pages->size(),
+	       double(n_bytes) / double(n_zip_bytes),
+	       double(n_bytes) / double(ut_max(compress_us, 1ULL)),
+	       double(n_bytes) / double(ut_max(decompress_us, 1ULL)));
+}
+
+#endif  // GTEST_HAS_PARAM_TEST
+
+}
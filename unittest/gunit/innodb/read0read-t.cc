@@ -0,0 +1,346 @@
+/* Copyright (c) 2013, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/* See http://code.google.com/p/googletest/wiki/Primer */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "handler.h"
+
+#include "univ.i"
+
+#include "mem0mem.h"
+#include "os0event.h"
+#include "read0read.h"
+#include "srv0conc.h"
+#include "srv0srv.h"
+#include "sync0debug.h"
+#include "trx0sys.h"
+
+namespace innodb_read0read_unittest {
+
+/** Sets up trx_sys with an MVCC instance and no rollback segments:
+nothing in these tests starts a real transaction. */
+static
+void
+read_test_init()
+{
+	srv_max_n_threads = srv_sync_array_size + 1;
+	os_event_init();
+	sync_check_init();
+	mem_init(1024 * 1024);
+
+	trx_sys_create();
+
+	trx_sys->max_trx_id = 100;
+}
+
+static
+void
+read_test_close()
+{
+	/* trx_sys_close() would free the rollback segments and the
+	purge system too, which were never created here. */
+	delete trx_sys->mvcc;
+
+	mutex_free(&trx_sys->mutex);
+
+	trx_sys->rw_trx_ids.~trx_ids_t();
+	trx_sys->rw_trx_set.~TrxIdSet();
+
+	mem_free(trx_sys);
+	trx_sys = NULL;
+
+	mem_close();
+	sync_check_close();
+}
+
+/** Pretends that a RW transaction started, like trx_start_low() does.
+@return the id of the transaction */
+static
+trx_id_t
+read_test_trx_start()
+{
+	trx_sys_mutex_enter();
+
+	trx_id_t	id = trx_sys->max_trx_id++;
+
+	trx_sys->rw_trx_ids.push_back(id);
+
+	trx_sys->mvcc->snapshot_invalidate();
+
+	trx_sys_mutex_exit();
+
+	return(id);
+}
+
+/** Pretends that a RW transaction committed, like trx_commit_low() does.
+@param id	id returned by read_test_trx_start() */
+static
+void
+read_test_trx_commit(trx_id_t id)
+{
+	trx_sys_mutex_enter();
+
+	trx_ids_t::iterator	it = std::lower_bound(
+		trx_sys->rw_trx_ids.begin(), trx_sys->rw_trx_ids.end(), id);
+
+	ASSERT_TRUE(it != trx_sys->rw_trx_ids.end() && *it == id);
+
+	trx_sys->rw_trx_ids.erase(it);
+
+	trx_sys->mvcc->snapshot_invalidate();
+
+	trx_sys_mutex_exit();
+}
+
+/** A transaction object for MVCC::view_open(), which only looks at the
+transaction id and, when reusing a view, at the autocommit flags. */
+class read_test_trx {
+public:
+	explicit read_test_trx(trx_id_t id)
+		: m_buf(new byte[sizeof(trx_t)]())
+	{
+		get()->id = id;
+	}
+
+	~read_test_trx()
+	{
+		delete[] m_buf;
+	}
+
+	trx_t* get()
+	{
+		return(reinterpret_cast<trx_t*>(m_buf));
+	}
+
+private:
+	byte*	m_buf;
+};
+
+static
+void
+read_test_view_close(ReadView*& view)
+{
+	trx_sys_mutex_enter();
+	trx_sys->mvcc->view_close(view, true);
+	trx_sys_mutex_exit();
+}
+
+class read0read : public ::testing::Test {
+protected:
+	static void SetUpTestCase()
+	{
+		read_test_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		read_test_close();
+	}
+};
+
+/* test that views opened between two trx state changes see the same
+transactions, and that a change is seen by the views opened after it */
+TEST_F(read0read, sharedsnapshot)
+{
+	trx_id_t	id1 = read_test_trx_start();
+	trx_id_t	id2 = read_test_trx_start();
+	trx_id_t	id3 = read_test_trx_start();
+
+	read_test_trx	ro_trx(0);
+	read_test_trx	rw_trx(id2);
+	ReadView*	ro_view = NULL;
+	ReadView*	rw_view = NULL;
+
+	trx_sys->mvcc->view_open(ro_view, ro_trx.get());
+	trx_sys->mvcc->view_open(rw_view, rw_trx.get());
+
+	ASSERT_TRUE(ro_view != NULL);
+	ASSERT_TRUE(rw_view != NULL);
+
+	EXPECT_FALSE(ro_view->empty());
+	EXPECT_TRUE(ro_view->changes_visible(id1 - 1));
+	EXPECT_FALSE(ro_view->changes_visible(id1));
+	EXPECT_FALSE(ro_view->changes_visible(id2));
+	EXPECT_FALSE(ro_view->changes_visible(id3));
+	EXPECT_FALSE(ro_view->changes_visible(trx_sys->max_trx_id));
+
+	/* The shared snapshot contains the creator, which sees itself. */
+	EXPECT_FALSE(rw_view->changes_visible(id1));
+	EXPECT_TRUE(rw_view->changes_visible(id2));
+	EXPECT_FALSE(rw_view->changes_visible(id3));
+
+	read_test_trx_commit(id1);
+
+	ReadView*	new_view = NULL;
+
+	trx_sys->mvcc->view_open(new_view, ro_trx.get());
+
+	EXPECT_TRUE(new_view->changes_visible(id1));
+	EXPECT_FALSE(new_view->changes_visible(id2));
+	EXPECT_FALSE(ro_view->changes_visible(id1));
+
+	/* Purge must not see anything the oldest view does not see. */
+	ReadView	purge_view;
+
+	trx_sys->mvcc->clone_oldest_view(&purge_view);
+
+	EXPECT_FALSE(purge_view.changes_visible(id1));
+	EXPECT_FALSE(purge_view.changes_visible(id2));
+	EXPECT_FALSE(purge_view.changes_visible(id3));
+
+	read_test_view_close(new_view);
+	read_test_view_close(rw_view);
+	read_test_view_close(ro_view);
+
+	read_test_trx_commit(id2);
+	read_test_trx_commit(id3);
+
+	trx_sys->mvcc->clone_oldest_view(&purge_view);
+
+	EXPECT_TRUE(purge_view.empty());
+	EXPECT_TRUE(purge_view.changes_visible(id3));
+}
+
+/* test that purge sees the creator of the oldest view as active, when
+the creator became a RW transaction after it opened the view */
+TEST_F(read0read, clonecreator)
+{
+	trx_id_t	id1 = read_test_trx_start();
+
+	read_test_trx	trx(0);
+	ReadView*	view = NULL;
+
+	trx_sys->mvcc->view_open(view, trx.get());
+
+	trx_id_t	id2 = read_test_trx_start();
+
+	trx_sys_mutex_enter();
+	MVCC::set_view_creator_trx_id(view, id2);
+	trx_sys_mutex_exit();
+
+	EXPECT_TRUE(view->changes_visible(id2));
+
+	ReadView	purge_view;
+
+	trx_sys->mvcc->clone_oldest_view(&purge_view);
+
+	EXPECT_FALSE(purge_view.changes_visible(id1));
+	EXPECT_FALSE(purge_view.changes_visible(id2));
+
+	read_test_view_close(view);
+
+	read_test_trx_commit(id1);
+	read_test_trx_commit(id2);
+}
+
+#if defined(GTEST_HAS_PARAM_TEST)
+
+/*
+  Benchmark of opening and closing read views, parameterized by the
+  number of active RW transactions.
+
+  In order to do benchmarking, configure in optimized mode, and
+  generate a separate executable for this file:
+    cmake -DMERGE_UNITTESTS=0
+  then increase n_iterations and run 'read0read-t --disable-tap-output'
+  to compare the timing reports. SharedSnapshot opens all views on the
+  same set of active transactions, its cost should not depend on the
+  number of them. ChangingSnapshot has a trx state change before every
+  view, which makes each view copy the whole set like before.
+*/
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+static const ulint	n_iterations = 100;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// static const ulint	n_iterations = 1000000;
+static const ulint	n_iterations = 1000;
+#endif
+
+class read0readBenchmark : public ::testing::TestWithParam<int> {
+protected:
+	static void SetUpTestCase()
+	{
+		read_test_init();
+	}
+
+	static void TearDownTestCase()
+	{
+		read_test_close();
+	}
+
+	virtual void SetUp()
+	{
+		for (int i = 0; i < GetParam(); ++i) {
+			m_ids.push_back(read_test_trx_start());
+		}
+	}
+
+	virtual void TearDown()
+	{
+		for (ulint i = 0; i < m_ids.size(); ++i) {
+			read_test_trx_commit(m_ids[i]);
+		}
+
+		m_ids.clear();
+	}
+
+	void open_views(bool change)
+	{
+		read_test_trx	trx(0);
+
+		for (ulint i = 0; i < n_iterations; ++i) {
+			ReadView*	view = NULL;
+
+			if (change) {
+				trx_sys_mutex_enter();
+				trx_sys->mvcc->snapshot_invalidate();
+				trx_sys_mutex_exit();
+			}
+
+			trx_sys->mvcc->view_open(view, trx.get());
+
+			ASSERT_TRUE(view != NULL);
+			EXPECT_EQ(GetParam() == 0, view->empty());
+
+			read_test_view_close(view);
+		}
+	}
+
+	trx_ids_t	m_ids;
+};
+
+INSTANTIATE_TEST_CASE_P(ActiveTrx, read0readBenchmark,
+			::testing::Values(0, 16, 256, 1024, 4096, 16384));
+
+TEST_P(read0readBenchmark, SharedSnapshot)
+{
+	open_views(false);
+}
+
+TEST_P(read0readBenchmark, ChangingSnapshot)
+{
+	open_views(true);
+}
+
+#endif  // GTEST_HAS_PARAM_TEST
+
+}
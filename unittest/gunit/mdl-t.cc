@@ -28,6 +28,7 @@
 
 #include "mdl.h"
 #include <mysqld_error.h>
+#include <vector>
 
 #include "thr_malloc.h"
 #include "thread_utils.h"
@@ -230,6 +231,14 @@ void MDL_thread::run()
   if (m_mdl_type >= MDL_SHARED_UPGRADABLE)
     request_list.push_front(&global_request);
 
+  /*
+    Threads which release their locks when notified about a conflicting
+    request behave like HANDLER connections, and their locks must not be
+    acquired on the fast path, where conflicting requests don't see them.
+  */
+  if (!m_ignore_notify)
+    m_mdl_context.set_needs_thr_lock_abort(true);
+
   EXPECT_FALSE(m_mdl_context.acquire_locks(&request_list, long_timeout));
   EXPECT_TRUE(m_mdl_context.
               is_lock_owner(MDL_key::TABLE, db_name, m_table_name, m_mdl_type));
@@ -1582,6 +1591,207 @@ TEST_F(MDLTest, HogLockTest5)
 }
 
 
+/*
+  Verifies that unobtrusive locks are granted on the fast path, and that
+  they are moved to the granted lists when the same context requests an
+  obtrusive lock on the object.
+ */
+TEST_F(MDLTest, FastPathMaterialize)
+{
+  MDL_request request2;
+  m_request.init(MDL_key::TABLE, db_name, table_name1, MDL_SHARED_READ,
+                 MDL_TRANSACTION);
+  request2.init(MDL_key::TABLE, db_name, table_name1, MDL_EXCLUSIVE,
+                MDL_TRANSACTION);
+
+  EXPECT_FALSE(m_mdl_context.acquire_lock(&m_global_request, long_timeout));
+  EXPECT_TRUE(m_global_request.ticket->is_fast_path());
+  EXPECT_FALSE(m_mdl_context.acquire_lock(&m_request, long_timeout));
+  EXPECT_TRUE(m_request.ticket->is_fast_path());
+
+  // Our own SR lock does not conflict with X lock.
+  EXPECT_FALSE(m_mdl_context.acquire_lock(&request2, zero_timeout));
+  EXPECT_NE(m_null_ticket, request2.ticket);
+  EXPECT_FALSE(m_request.ticket->is_fast_path());
+  EXPECT_FALSE(m_global_request.ticket->is_fast_path());
+  EXPECT_FALSE(request2.ticket->is_fast_path());
+
+  m_mdl_context.release_transactional_locks();
+
+  // Once the object is gone the fast path can be used again.
+  m_request.ticket= NULL;
+  EXPECT_FALSE(m_mdl_context.acquire_lock(&m_request, long_timeout));
+  EXPECT_TRUE(m_request.ticket->is_fast_path());
+  m_mdl_context.release_transactional_locks();
+}
+
+
+/*
+  Verifies that locks granted on the fast path in another thread are
+  taken into account, per lock type, by obtrusive lock requests.
+ */
+TEST_F(MDLTest, FastPathConcurrentObtrusive)
+{
+  expected_error= ER_LOCK_WAIT_TIMEOUT;
+
+  Notification lock_grabbed;
+  Notification release_locks;
+  MDL_thread mdl_thread(table_name1, MDL_SHARED_READ, &lock_grabbed,
+                        &release_locks, NULL, NULL);
+  mdl_thread.ignore_notify();
+  mdl_thread.start();
+  lock_grabbed.wait_for_notification();
+
+  // SNW is compatible with SR.
+  m_request.init(MDL_key::TABLE, db_name, table_name1, MDL_SHARED_NO_WRITE,
+                 MDL_TRANSACTION);
+  m_request_list.push_front(&m_request);
+  m_request_list.push_front(&m_global_request);
+  EXPECT_FALSE(m_mdl_context.acquire_locks(&m_request_list, zero_timeout));
+  EXPECT_NE(m_null_ticket, m_request.ticket);
+  m_mdl_context.release_transactional_locks();
+
+  // SNRW is not.
+  MDL_request request2;
+  request2.init(MDL_key::TABLE, db_name, table_name1,
+                MDL_SHARED_NO_READ_WRITE, MDL_TRANSACTION);
+  EXPECT_FALSE(m_mdl_context.try_acquire_lock(&request2));
+  EXPECT_EQ(m_null_ticket, request2.ticket);
+
+  MDL_request_list request_list2;
+  m_global_request.ticket= NULL;
+  request_list2.push_front(&request2);
+  request_list2.push_front(&m_global_request);
+  EXPECT_TRUE(m_mdl_context.acquire_locks(&request_list2, zero_timeout));
+
+  release_locks.notify();
+  mdl_thread.join();
+
+  // Now we should be able to grab the lock.
+  EXPECT_FALSE(m_mdl_context.acquire_locks(&request_list2, zero_timeout));
+  EXPECT_NE(m_null_ticket, request2.ticket);
+
+  m_mdl_context.release_transactional_locks();
+}
+
+
+/*
+  A thread which acquires and releases the locks taken by a DML statement
+  in a loop. Used for benchmarking the MDL subsystem.
+*/
+class MDL_benchmark_thread : public Thread, public Test_MDL_context_owner
+{
+public:
+  MDL_benchmark_thread(const char *table_name, size_t num_iterations)
+  : m_table_name(table_name),
+    m_num_iterations(num_iterations)
+  {
+    m_mdl_context.init(this);
+  }
+
+  ~MDL_benchmark_thread()
+  {
+    m_mdl_context.destroy();
+  }
+
+  virtual void run()
+  {
+    MDL_request global_request;
+    MDL_request request;
+
+    for (size_t ix= 0; ix < m_num_iterations; ++ix)
+    {
+      global_request.init(MDL_key::GLOBAL, "", "", MDL_INTENTION_EXCLUSIVE,
+                          MDL_STATEMENT);
+      request.init(MDL_key::TABLE, db_name, m_table_name, MDL_SHARED_WRITE,
+                   MDL_TRANSACTION);
+      EXPECT_FALSE(m_mdl_context.acquire_lock(&global_request, long_timeout));
+      EXPECT_FALSE(m_mdl_context.acquire_lock(&request, long_timeout));
+      m_mdl_context.release_statement_locks();
+      m_mdl_context.release_transactional_locks();
+    }
+  }
+
+  virtual bool notify_shared_lock(MDL_context_owner *in_use,
+                                  bool needs_thr_lock_abort)
+  {
+    return false;
+  }
+
+private:
+  const char   *m_table_name;
+  size_t        m_num_iterations;
+  MDL_context   m_mdl_context;
+};
+
+
+#if defined(GTEST_HAS_PARAM_TEST)
+
+/*
+  Benchmark of acquiring and releasing unobtrusive locks on the same
+  table from concurrent threads, parameterized by the number of threads.
+
+  In order to do benchmarking, configure in optimized mode, and
+  generate a separate executable for this file:
+    cmake -DMERGE_UNITTESTS=0
+  then increase num_iterations and run 'mdl-t --disable-tap-output'
+  to see timing reports for 1 to 64 threads.
+*/
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+const size_t num_iterations= 10ULL;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// const size_t num_iterations= 1000000ULL;
+const size_t num_iterations= 100ULL;
+#endif
+
+class MDLBenchmarkTest : public ::testing::TestWithParam<int>
+{
+protected:
+  static void SetUpTestCase()
+  {
+    error_handler_hook= test_error_handler_hook;
+    mdl_locks_hash_partitions= MDL_LOCKS_HASH_PARTITIONS_DEFAULT;
+  }
+
+  void SetUp()
+  {
+    expected_error= 0;
+    mdl_init();
+  }
+
+  void TearDown()
+  {
+    mdl_destroy();
+  }
+};
+
+
+INSTANTIATE_TEST_CASE_P(Threads, MDLBenchmarkTest,
+                        ::testing::Values(1, 2, 4, 8, 16, 32, 64));
+
+TEST_P(MDLBenchmarkTest, SharedWriteAcquireRelease)
+{
+  const int num_threads= GetParam();
+  std::vector<MDL_benchmark_thread*> threads;
+
+  for (int ix= 0; ix < num_threads; ++ix)
+    threads.push_back(new MDL_benchmark_thread(table_name1, num_iterations));
+  for (int ix= 0; ix < num_threads; ++ix)
+    threads[ix]->start();
+  for (int ix= 0; ix < num_threads; ++ix)
+  {
+    threads[ix]->join();
+    delete threads[ix];
+  }
+}
+
+#endif  // GTEST_HAS_PARAM_TEST
+
+
 /** Test class for MDL_key class testing. Doesn't require MDL initialization. */
 
 class MDLKeyTest : public ::testing::Test